@@ -733,6 +733,7 @@ using markup symbols for regular printers.''';
                                   const Text('✅ FOR THERMAL PRINTERS:', style: TextStyle(fontWeight: FontWeight.bold, color: Colors.green)),
                                   const Text('• Use printRawData(useRawDatatype: true) with ESC/POS commands'),
                                   const Text('• Use esc_pos_utils package for programmatic control'),
+                                  const Text('• printRichTextDocument() markup is sent as ESC/POS text'),
                                   const Text('• Supports: bold, alignment, cutting, cash drawer, beeping'),
                                   const SizedBox(height: 8),
                                   
@@ -744,7 +745,6 @@ using markup symbols for regular printers.''';
                                   
                                   const Text('❌ AVOID:', style: TextStyle(fontWeight: FontWeight.bold, color: Colors.red)),
                                   const Text('• printRawData() on regular printers (poor quality)'),
-                                  const Text('• printRichTextDocument() on thermal printers (unreliable)'),
                                 ],
                               ),
                             ),
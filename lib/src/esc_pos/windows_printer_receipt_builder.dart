@@ -2,6 +2,7 @@ import 'dart:typed_data';
 import 'package:windows_printer/src/esc_pos/windows_printer_esc_pos_generator.dart';
 
 import '../windows_printer_enums.dart';
+import '../windows_printer_ffi.dart';
 import '../windows_printer_models.dart';
 
 /// Helper class for easy receipt generation
@@ -130,6 +131,25 @@ class WPReceiptBuilder {
     _generator.image(imageData, width, height);
     return this;
   }
+
+  /// Adds a PNG or JPEG file's bytes to the receipt, decoded natively.
+  ///
+  /// The image is scaled to [width] dots (the paper width by default),
+  /// keeping its aspect ratio, and dithered unless [dither] is false. Large
+  /// photos need no decoding or resizing in Dart first:
+  ///
+  /// ```dart
+  /// final bytes = File('logo.jpg').readAsBytesSync();
+  /// receiptBuilder.addEncodedImage(bytes);
+  /// ```
+  ///
+  /// Progressive JPEGs are not supported. Throws a [WPNativePrinterException]
+  /// for data that cannot be decoded.
+  WPReceiptBuilder addEncodedImage(Uint8List encoded, {int? width, bool dither = true}) {
+    _generator.raw(WPNativePrinter.instance.encodeReceiptImage(encoded,
+        width: width ?? _generator.paperSize.width, dither: dither));
+    return this;
+  }
   
   /// Cut the paper. Set [partial] to true for a partial cut (leaves a small tab connected),
   /// or false for a full cut (completely separates the receipt).
@@ -43,3 +43,47 @@ enum WPBarcodeType {
   const WPBarcodeType(this.value);
   final int value;
 }
+
+/// How printRichTextDocument reaches the printer
+enum WPRichTextMode {
+  /// ESC/POS for receipt printers, detected from the driver and paper width;
+  /// GDI for everything else
+  auto,
+
+  /// Rendered by the printer driver with the given font
+  gdi,
+
+  /// Sent as ESC/POS text commands in the printer's own fonts
+  escPos,
+}
+
+/// Command language of a label printer
+enum WPLabelLanguage {
+  /// Zebra Programming Language II
+  zpl,
+
+  /// TSC Printer Language, also spoken by many Xprinter and Godex models
+  tspl,
+}
+
+/// Barcode symbologies both label languages can print
+enum WPLabelBarcodeType {
+  code128,
+  code39,
+  ean13,
+  ean8,
+  upcA,
+}
+
+/// What a raw print does while the queue limits set by setQueueLimits are
+/// reached
+enum WPOverflowPolicy {
+  /// Fail at once with a QUEUE_FULL PlatformException
+  reject,
+
+  /// Wait until queued jobs have been spooled
+  block,
+
+  /// Wait like [block] with the data in a temporary file instead of memory
+  spill,
+}
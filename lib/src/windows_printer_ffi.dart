@@ -0,0 +1,728 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+
+// Mirrors windows/include/windows_printer/windows_printer_ffi.h
+
+const int _ffiOk = 0;
+const int _ffiInvalidArgument = -1;
+const int _ffiNotReady = -2;
+const int _ffiFailed = -3;
+const int _ffiTimedOut = -4;
+const int _ffiNotFound = -5;
+const int _ffiQueueFull = -6;
+const int _ffiPaused = 1;
+
+// Version that added the stream functions
+const int _streamVersion = 2;
+
+// Version that added the queue limit metrics
+const int _queueLimitsVersion = 3;
+
+// Version that added receipt image encoding
+const int _receiptImageVersion = 4;
+
+// Version that added encoding several receipt images in parallel
+const int _receiptImagesVersion = 5;
+
+const List<String> _jobStates = ['spooling', 'printing', 'printed', 'error', 'deleted'];
+
+const List<String> _stageNames = [
+  'decodeArguments',
+  'encodeResult',
+  'openPrinter',
+  'queryPrinter',
+  'startDocPrinter',
+  'writePrinter',
+  'endDocPrinter',
+];
+
+final class _Job extends Struct {
+  @Uint32()
+  external int jobId;
+  @Int32()
+  external int state;
+  @Uint32()
+  external int status;
+  @Uint32()
+  external int errorCode;
+  @Uint32()
+  external int pagesPrinted;
+  @Uint32()
+  external int totalPages;
+  @Uint64()
+  external int bytesWritten;
+}
+
+final class _StageMetrics extends Struct {
+  @Uint64()
+  external int count;
+  @Uint64()
+  external int p50Ns;
+  @Uint64()
+  external int p99Ns;
+  @Uint64()
+  external int maxNs;
+}
+
+final class _Metrics extends Struct {
+  @Uint32()
+  external int structSize;
+  @Uint32()
+  external int reserved;
+  @Uint64()
+  external int bytesWritten;
+  @Uint64()
+  external int queueDepth;
+  @Uint64()
+  external int peakQueueDepth;
+  @Uint64()
+  external int failures;
+  @Array(7)
+  external Array<_StageMetrics> stages;
+  @Uint64()
+  external int pendingJobs;
+  @Uint64()
+  external int pendingBytes;
+  @Uint64()
+  external int peakPendingBytes;
+  @Uint64()
+  external int spilledBytes;
+  @Uint64()
+  external int rejectedJobs;
+  @Uint64()
+  external int blockedJobs;
+  @Uint64()
+  external int spilledJobs;
+}
+
+final class _StreamInfo extends Struct {
+  @Uint32()
+  external int streamId;
+  @Uint32()
+  external int jobId;
+  @Uint64()
+  external int capacity;
+  @Uint64()
+  external int buffered;
+  @Uint64()
+  external int bytesWritten;
+  @Int32()
+  external int failed;
+  @Uint32()
+  external int reserved;
+}
+
+typedef _VersionNative = Int32 Function();
+typedef _Version = int Function();
+typedef _AllocateNative = Pointer<Uint8> Function(Uint64 size);
+typedef _Allocate = Pointer<Uint8> Function(int size);
+typedef _FreeNative = Void Function(Pointer<Void> buffer);
+typedef _Free = void Function(Pointer<Void> buffer);
+typedef _SubmitNative = Int32 Function(Pointer<Uint8> printerName, Pointer<Uint8> data,
+    Uint64 size, Int32 useRawDatatype, Int32 copies, Uint32 timeoutMs, Pointer<_Job> job);
+typedef _Submit = int Function(Pointer<Uint8> printerName, Pointer<Uint8> data, int size,
+    int useRawDatatype, int copies, int timeoutMs, Pointer<_Job> job);
+typedef _GetJobNative = Int32 Function(Pointer<Uint8> printerName, Uint32 jobId, Pointer<_Job> job);
+typedef _GetJob = int Function(Pointer<Uint8> printerName, int jobId, Pointer<_Job> job);
+typedef _GetMetricsNative = Int32 Function(Pointer<_Metrics> metrics);
+typedef _GetMetrics = int Function(Pointer<_Metrics> metrics);
+typedef _StreamOpenNative = Int32 Function(Pointer<Uint8> printerName, Uint64 capacity,
+    Uint64 lowWatermark, Uint64 highWatermark, Int32 useRawDatatype,
+    Pointer<Pointer<Void>> stream, Pointer<Uint32> streamId);
+typedef _StreamOpen = int Function(Pointer<Uint8> printerName, int capacity, int lowWatermark,
+    int highWatermark, int useRawDatatype, Pointer<Pointer<Void>> stream, Pointer<Uint32> streamId);
+typedef _StreamReserveNative = Pointer<Uint8> Function(Pointer<Void> stream, Pointer<Uint64> length);
+typedef _StreamReserve = Pointer<Uint8> Function(Pointer<Void> stream, Pointer<Uint64> length);
+typedef _StreamCommitNative = Int32 Function(Pointer<Void> stream, Uint64 length);
+typedef _StreamCommit = int Function(Pointer<Void> stream, int length);
+typedef _StreamGetInfoNative = Int32 Function(Pointer<Void> stream, Pointer<_StreamInfo> info);
+typedef _StreamGetInfo = int Function(Pointer<Void> stream, Pointer<_StreamInfo> info);
+typedef _StreamCloseNative = Int32 Function(Pointer<Void> stream, Int32 abort);
+typedef _StreamClose = int Function(Pointer<Void> stream, int abort);
+typedef _EncodeReceiptImageNative = Int32 Function(Pointer<Uint8> image, Uint64 size, Int32 width,
+    Int32 dither, Pointer<Pointer<Uint8>> output, Pointer<Uint64> outputSize, Pointer<Uint8> error,
+    Uint32 errorSize);
+typedef _EncodeReceiptImage = int Function(Pointer<Uint8> image, int size, int width, int dither,
+    Pointer<Pointer<Uint8>> output, Pointer<Uint64> outputSize, Pointer<Uint8> error, int errorSize);
+typedef _EncodeReceiptImagesNative = Int32 Function(Uint32 count, Pointer<Pointer<Uint8>> images,
+    Pointer<Uint64> sizes, Int32 width, Int32 dither, Pointer<Pointer<Uint8>> outputs,
+    Pointer<Uint64> outputSizes, Pointer<Int32> results, Pointer<Uint8> error, Uint32 errorSize);
+typedef _EncodeReceiptImages = int Function(int count, Pointer<Pointer<Uint8>> images,
+    Pointer<Uint64> sizes, int width, int dither, Pointer<Pointer<Uint8>> outputs,
+    Pointer<Uint64> outputSizes, Pointer<Int32> results, Pointer<Uint8> error, int errorSize);
+
+/// Error returned by a [WPNativePrinter] call
+class WPNativePrinterException implements Exception {
+  /// `invalidArgument`, `notReady`, `failed`, `timedOut` or `queueFull`
+  /// (the limits set by [WindowsPrinter.setQueueLimits] were reached; the
+  /// call fails at once rather than block the isolate, whatever the
+  /// overflow policy)
+  final String code;
+
+  /// Win32 error of the failed spooler call, 0 if there was none
+  final int errorCode;
+
+  /// Job id when the job had started before it failed or timed out
+  final int jobId;
+
+  /// Why an image could not be encoded, null for other calls
+  final String? message;
+
+  WPNativePrinterException(this.code, {this.errorCode = 0, this.jobId = 0, this.message});
+
+  @override
+  String toString() => message == null
+      ? 'WPNativePrinterException($code, errorCode: $errorCode)'
+      : 'WPNativePrinterException($code, $message)';
+}
+
+/// Memory outside the Dart heap that [WPNativePrinter.submitBuffer] prints
+/// without copying. Fill [bytes] directly, e.g. with a receipt, and [free]
+/// the buffer when done; it is reusable until then.
+class WPNativeBuffer {
+  final Pointer<Uint8> _pointer;
+  final _Free _free;
+  bool _freed = false;
+
+  /// View of the native memory
+  final Uint8List bytes;
+
+  WPNativeBuffer._(this._pointer, int size, this._free) : bytes = _pointer.asTypedList(size);
+
+  int get size => bytes.length;
+
+  void free() {
+    if (_freed) return;
+    _freed = true;
+    _free(_pointer.cast());
+  }
+}
+
+/// Synchronous raw printing through the plugin's C ABI
+///
+/// Skips the method channel: no codec encodes the data and no platform
+/// thread hop is made, so small tickets submit in microseconds plus the
+/// spooler's own time. Calls block the calling isolate until the spooler has
+/// taken the job; submit large jobs or slow network printers from a
+/// background isolate, or with a `timeout`. Jobs are followed like those of
+/// [WindowsPrinter.printRawJob] and appear on [WindowsPrinter.jobEvents].
+///
+/// Example:
+/// ```dart
+/// final printer = WPNativePrinter.instance;
+/// final job = printer.submitRawJob(printerName: 'Kitchen', data: ticket);
+/// print(printer.getJob(job['jobId'])?['state']); // spooling
+/// ```
+class WPNativePrinter {
+  static WPNativePrinter? _instance;
+
+  /// The plugin DLL, loaded on first use. Available once the plugin has been
+  /// registered, which Flutter does before `main` runs.
+  static WPNativePrinter get instance =>
+      _instance ??= WPNativePrinter._load(DynamicLibrary.open('windows_printer_plugin.dll'));
+
+  final _Version _version;
+  final _Allocate _allocate;
+  final _Free _free;
+  final _Submit _submit;
+  final _GetJob _getJob;
+  final _GetMetrics _getMetrics;
+  final DynamicLibrary _library;
+
+  // Reused for results and short strings; calls are synchronous, so one
+  // isolate never uses them twice at once
+  final Pointer<_Job> _job;
+  final Pointer<_Metrics> _metrics;
+  WPNativeBuffer? _scratch;
+
+  // Looked up on the first openStream, as older plugins lack them
+  _StreamFunctions? _streamFunctions;
+  Stream<Map<String, dynamic>>? _streamEvents;
+  _EncodeReceiptImage? _encodeReceiptImage;
+  _EncodeReceiptImages? _encodeReceiptImages;
+
+  WPNativePrinter._(this._library, this._version, this._allocate, this._free, this._submit,
+      this._getJob, this._getMetrics)
+      : _job = _allocate(sizeOf<_Job>()).cast(),
+        _metrics = _allocate(sizeOf<_Metrics>()).cast();
+
+  factory WPNativePrinter._load(DynamicLibrary library) {
+    return WPNativePrinter._(
+      library,
+      library.lookupFunction<_VersionNative, _Version>('WindowsPrinterFfiVersion'),
+      library.lookupFunction<_AllocateNative, _Allocate>('WindowsPrinterAllocate'),
+      library.lookupFunction<_FreeNative, _Free>('WindowsPrinterFree'),
+      library.lookupFunction<_SubmitNative, _Submit>('WindowsPrinterSubmitRawJob'),
+      library.lookupFunction<_GetJobNative, _GetJob>('WindowsPrinterGetJob'),
+      library.lookupFunction<_GetMetricsNative, _GetMetrics>('WindowsPrinterGetMetrics'),
+    );
+  }
+
+  /// Version of the C ABI the loaded plugin implements
+  int get version => _version();
+
+  /// Allocate a [WPNativeBuffer] of [size] bytes
+  WPNativeBuffer allocate(int size) {
+    final pointer = _allocate(size);
+    if (pointer == nullptr) {
+      throw ArgumentError.value(size, 'size', 'Could not allocate native memory');
+    }
+    return WPNativeBuffer._(pointer, size, _free);
+  }
+
+  /// Print [data] as one raw document, like [WindowsPrinter.printRawJob]
+  ///
+  /// The data is copied once into reused native memory. Build into a
+  /// [WPNativeBuffer] and call [submitBuffer] to avoid even that copy.
+  /// Returns the job in the format of [WindowsPrinter.getJob] plus
+  /// `bytesWritten`.
+  Map<String, dynamic> submitRawJob({
+    String? printerName,
+    required Uint8List data,
+    bool useRawDatatype = true,
+    int copies = 1,
+    Duration? timeout,
+  }) {
+    final names = printerName == null ? const <int>[] : utf8.encode(printerName);
+    final scratch = _scratchFor(data.length + names.length + 1);
+    scratch.bytes.setRange(0, data.length, data);
+    return _submitFrom(scratch, data.length, printerName,
+        useRawDatatype: useRawDatatype, copies: copies, timeout: timeout, nameOffset: data.length);
+  }
+
+  /// Print the first [length] bytes of [buffer] (all of it by default)
+  /// straight from native memory
+  Map<String, dynamic> submitBuffer(
+    WPNativeBuffer buffer, {
+    int? length,
+    String? printerName,
+    bool useRawDatatype = true,
+    int copies = 1,
+    Duration? timeout,
+  }) {
+    final size = length ?? buffer.size;
+    RangeError.checkValueInInterval(size, 0, buffer.size, 'length');
+    return _submitFrom(buffer, size, printerName,
+        useRawDatatype: useRawDatatype, copies: copies, timeout: timeout);
+  }
+
+  /// Latest known state of a job in the format of [WindowsPrinter.getJob],
+  /// or null for a job that is not known. Does not wait for the spooler.
+  Map<String, dynamic>? getJob(int jobId, {String? printerName}) {
+    final name = _nativeString(printerName, null);
+    final result = _getJob(name, jobId, _job);
+    if (result == _ffiNotFound) return null;
+    _check(result);
+    return _encodeJob(printerName);
+  }
+
+  /// Counters and stage latencies in nanoseconds, a subset of
+  /// [WindowsPrinter.getMetrics] that needs no channel round trip
+  Map<String, dynamic> metrics() {
+    _metrics.ref.structSize = sizeOf<_Metrics>();
+    _check(_getMetrics(_metrics));
+    final metrics = _metrics.ref;
+    return {
+      'bytesWritten': metrics.bytesWritten,
+      'queueDepth': metrics.queueDepth,
+      'peakQueueDepth': metrics.peakQueueDepth,
+      'failures': metrics.failures,
+      if (version >= _queueLimitsVersion) ...{
+        'pendingJobs': metrics.pendingJobs,
+        'pendingBytes': metrics.pendingBytes,
+        'peakPendingBytes': metrics.peakPendingBytes,
+        'spilledBytes': metrics.spilledBytes,
+        'rejectedJobs': metrics.rejectedJobs,
+        'blockedJobs': metrics.blockedJobs,
+        'spilledJobs': metrics.spilledJobs,
+      },
+      'stages': {
+        for (var i = 0; i < _stageNames.length; i++)
+          _stageNames[i]: {
+            'count': metrics.stages[i].count,
+            'p50': metrics.stages[i].p50Ns,
+            'p99': metrics.stages[i].p99Ns,
+            'max': metrics.stages[i].maxNs,
+          },
+      },
+    };
+  }
+
+  /// Start one raw job that is fed continuously, for label and receipt
+  /// printers that print as data arrives
+  ///
+  /// The data goes through a ring buffer of [capacity] bytes in native
+  /// memory, which [WPNativeStream.write] fills without ever waiting for the
+  /// printer; a native thread opens the printer and writes from it. Once
+  /// [highWatermark] bytes are buffered, writes report [WPNativeStream.paused]
+  /// until the printer has drained it to [lowWatermark]. The watermarks
+  /// default to three quarters and a quarter of the capacity.
+  ///
+  /// Example:
+  /// ```dart
+  /// final stream = WPNativePrinter.instance.openStream(printerName: 'Labels');
+  /// for (final label in labels) {
+  ///   await stream.writeAll(label);
+  /// }
+  /// final result = await stream.close(); // {type: finished, jobId: 12, ...}
+  /// ```
+  WPNativeStream openStream({
+    String? printerName,
+    int capacity = 1 << 20,
+    int? lowWatermark,
+    int? highWatermark,
+    bool useRawDatatype = true,
+  }) {
+    final functions = _streamFunctions ??= _StreamFunctions.lookup(this);
+    final events = _streamEvents ??= const EventChannel('windows_printer/streams')
+        .receiveBroadcastStream()
+        .map((event) => Map<String, dynamic>.from(event as Map<Object?, Object?>));
+    final handle = _allocate(sizeOf<Pointer<Void>>()).cast<Pointer<Void>>();
+    final streamId = _allocate(sizeOf<Uint32>()).cast<Uint32>();
+    try {
+      final name = _nativeString(printerName, null);
+      _check(functions.open(name, capacity, lowWatermark ?? 0, highWatermark ?? 0,
+          useRawDatatype ? 1 : 0, handle, streamId));
+      return WPNativeStream._(this, functions, handle.value, streamId.value, events);
+    } finally {
+      _free(handle.cast());
+      _free(streamId.cast());
+    }
+  }
+
+  /// ESC/POS bit image bands of a PNG or baseline JPEG, for a thermal
+  /// receipt printer [width] dots across
+  ///
+  /// The image is decoded, scaled and dithered in one native pass that holds
+  /// a few rows at a time, however large the image: shrinking averages the
+  /// pixels each dot covers, transparency prints as white, and [dither]
+  /// diffuses the error so shading survives. Without it dots are thresholded
+  /// like [WPReceiptBuilder.addImage]. The bytes follow the printer's
+  /// ESC @, e.g. through [WPReceiptBuilder.addEncodedImage]. Throws a
+  /// [WPNativePrinterException] with a [WPNativePrinterException.message]
+  /// for data that cannot be decoded.
+  Uint8List encodeReceiptImage(Uint8List image, {int width = 576, bool dither = true}) {
+    if (version < _receiptImageVersion) {
+      throw UnsupportedError('The loaded plugin does not support receipt images');
+    }
+    final encode = _encodeReceiptImage ??= _library
+        .lookupFunction<_EncodeReceiptImageNative, _EncodeReceiptImage>(
+            'WindowsPrinterEncodeReceiptImage');
+    const errorSize = 128;
+    final scratch = _scratchFor(image.length + errorSize);
+    scratch.bytes.setRange(0, image.length, image);
+    final error = Pointer<Uint8>.fromAddress(scratch._pointer.address + image.length);
+    final output = _allocate(sizeOf<Pointer<Uint8>>()).cast<Pointer<Uint8>>();
+    final outputSize = _allocate(sizeOf<Uint64>()).cast<Uint64>();
+    try {
+      final result = encode(scratch._pointer, image.length, width, dither ? 1 : 0, output,
+          outputSize, error, errorSize);
+      if (result != _ffiOk) {
+        final bytes = scratch.bytes.sublist(image.length, image.length + errorSize);
+        final message = utf8.decode(bytes.sublist(0, max(0, bytes.indexOf(0))));
+        throw WPNativePrinterException(
+            result == _ffiInvalidArgument ? 'invalidArgument' : 'failed',
+            message: message);
+      }
+      final encoded = Uint8List.fromList(output.value.asTypedList(outputSize.value));
+      _free(output.value.cast());
+      return encoded;
+    } finally {
+      _free(output.cast());
+      _free(outputSize.cast());
+    }
+  }
+
+  /// [encodeReceiptImage] for each of [images], encoded in parallel on the
+  /// plugin's worker threads, one per core
+  ///
+  /// A receipt with a logo and several photos is ready in about the time of
+  /// its largest image. Throws a [WPNativePrinterException] for the first
+  /// image that cannot be decoded.
+  List<Uint8List> encodeReceiptImages(List<Uint8List> images,
+      {int width = 576, bool dither = true}) {
+    if (images.isEmpty) return [];
+    if (version < _receiptImagesVersion) {
+      return [for (final image in images) encodeReceiptImage(image, width: width, dither: dither)];
+    }
+    final encode = _encodeReceiptImages ??= _library
+        .lookupFunction<_EncodeReceiptImagesNative, _EncodeReceiptImages>(
+            'WindowsPrinterEncodeReceiptImages');
+    const errorSize = 128;
+    final count = images.length;
+    final total = images.fold<int>(0, (sum, image) => sum + image.length);
+    final scratch = _scratchFor(total + errorSize);
+    final error = Pointer<Uint8>.fromAddress(scratch._pointer.address + total);
+    // Image pointers and sizes, outputs and their sizes, then results
+    final stride = count * 8;
+    final arrays = _allocate(4 * stride + count * sizeOf<Int32>());
+    final pointers = arrays.cast<Pointer<Uint8>>();
+    final sizes = Pointer<Uint64>.fromAddress(arrays.address + stride);
+    final outputs = Pointer<Pointer<Uint8>>.fromAddress(arrays.address + 2 * stride);
+    final outputSizes = Pointer<Uint64>.fromAddress(arrays.address + 3 * stride);
+    final results = Pointer<Int32>.fromAddress(arrays.address + 4 * stride);
+    try {
+      var offset = 0;
+      for (var i = 0; i < count; i++) {
+        scratch.bytes.setRange(offset, offset + images[i].length, images[i]);
+        pointers[i] = Pointer<Uint8>.fromAddress(scratch._pointer.address + offset);
+        sizes[i] = images[i].length;
+        offset += images[i].length;
+      }
+      final result = encode(count, pointers, sizes, width, dither ? 1 : 0, outputs, outputSizes,
+          results, error, errorSize);
+      final encoded = <Uint8List>[];
+      for (var i = 0; i < count; i++) {
+        if (results[i] != _ffiOk) continue;
+        encoded.add(Uint8List.fromList(outputs[i].asTypedList(outputSizes[i])));
+        _free(outputs[i].cast());
+      }
+      if (result != _ffiOk) {
+        final bytes = scratch.bytes.sublist(total, total + errorSize);
+        final message = utf8.decode(bytes.sublist(0, max(0, bytes.indexOf(0))));
+        throw WPNativePrinterException(
+            result == _ffiInvalidArgument ? 'invalidArgument' : 'failed',
+            message: message);
+      }
+      return encoded;
+    } finally {
+      _free(arrays.cast());
+    }
+  }
+
+  Map<String, dynamic> _submitFrom(
+    WPNativeBuffer buffer,
+    int size,
+    String? printerName, {
+    required bool useRawDatatype,
+    required int copies,
+    Duration? timeout,
+    int? nameOffset,
+  }) {
+    final name = _nativeString(printerName, nameOffset);
+    final timeoutMs = timeout == null ? 0 : (timeout.inMilliseconds < 1 ? 1 : timeout.inMilliseconds);
+    final result =
+        _submit(name, buffer._pointer, size, useRawDatatype ? 1 : 0, copies, timeoutMs, _job);
+    _check(result);
+    return _encodeJob(printerName)..['bytesWritten'] = _job.ref.bytesWritten;
+  }
+
+  // NUL-terminated UTF-8 copy of value in the scratch buffer at offset, or
+  // nullptr for null. Without an offset the scratch buffer holds only it.
+  Pointer<Uint8> _nativeString(String? value, int? offset) {
+    if (value == null) return nullptr;
+    final encoded = utf8.encode(value);
+    final start = offset ?? 0;
+    final scratch = offset == null ? _scratchFor(encoded.length + 1) : _scratch!;
+    scratch.bytes.setRange(start, start + encoded.length, encoded);
+    scratch.bytes[start + encoded.length] = 0;
+    return Pointer<Uint8>.fromAddress(scratch._pointer.address + start);
+  }
+
+  WPNativeBuffer _scratchFor(int size) {
+    final scratch = _scratch;
+    if (scratch != null && scratch.size >= size) return scratch;
+    scratch?.free();
+    // Grown in powers of two so a stream of similar tickets allocates once
+    var capacity = 256;
+    while (capacity < size) {
+      capacity *= 2;
+    }
+    return _scratch = allocate(capacity);
+  }
+
+  Map<String, dynamic> _encodeJob(String? printerName) {
+    final job = _job.ref;
+    return {
+      'jobId': job.jobId,
+      if (printerName != null) 'printerName': printerName,
+      'state': _jobStates[job.state],
+      'status': job.status,
+      'pagesPrinted': job.pagesPrinted,
+      'totalPages': job.totalPages,
+    };
+  }
+
+  void _check(int result) {
+    switch (result) {
+      case _ffiOk:
+        return;
+      case _ffiInvalidArgument:
+        throw WPNativePrinterException('invalidArgument');
+      case _ffiNotReady:
+        throw WPNativePrinterException('notReady');
+      case _ffiQueueFull:
+        throw WPNativePrinterException('queueFull');
+      case _ffiTimedOut:
+        throw WPNativePrinterException('timedOut',
+            errorCode: _job.ref.errorCode, jobId: _job.ref.jobId);
+      case _ffiFailed:
+      default:
+        throw WPNativePrinterException('failed',
+            errorCode: _job.ref.errorCode, jobId: _job.ref.jobId);
+    }
+  }
+}
+
+class _StreamFunctions {
+  final _StreamOpen open;
+  final _StreamReserve reserve;
+  final _StreamCommit commit;
+  final _StreamGetInfo getInfo;
+  final _StreamClose close;
+
+  _StreamFunctions(this.open, this.reserve, this.commit, this.getInfo, this.close);
+
+  factory _StreamFunctions.lookup(WPNativePrinter printer) {
+    if (printer.version < _streamVersion) {
+      throw UnsupportedError('The loaded plugin does not support print streams');
+    }
+    final library = printer._library;
+    return _StreamFunctions(
+      library.lookupFunction<_StreamOpenNative, _StreamOpen>('WindowsPrinterStreamOpen'),
+      library.lookupFunction<_StreamReserveNative, _StreamReserve>('WindowsPrinterStreamReserve'),
+      library.lookupFunction<_StreamCommitNative, _StreamCommit>('WindowsPrinterStreamCommit'),
+      library.lookupFunction<_StreamGetInfoNative, _StreamGetInfo>('WindowsPrinterStreamGetInfo'),
+      library.lookupFunction<_StreamCloseNative, _StreamClose>('WindowsPrinterStreamClose'),
+    );
+  }
+}
+
+/// A raw print job fed continuously through native memory, opened with
+/// [WPNativePrinter.openStream]
+///
+/// Writes are synchronous and never block: they copy what fits into the
+/// ring buffer and return. Use the stream from the isolate that opened it.
+class WPNativeStream {
+  final WPNativePrinter _printer;
+  final _StreamFunctions _functions;
+  final Pointer<Void> _handle;
+  final Pointer<Uint64> _length;
+  final Pointer<_StreamInfo> _info;
+  late final StreamSubscription<Map<String, dynamic>> _subscription;
+
+  /// Identifies this stream's [events]
+  final int streamId;
+
+  /// `started` (with the `jobId`), `writable`, then one of `finished`,
+  /// `failed` (with a Win32 `errorCode`) or `cancelled`. Each carries
+  /// `printerName`, `jobId` and `bytesWritten`.
+  final Stream<Map<String, dynamic>> events;
+
+  final Completer<Map<String, dynamic>> _done = Completer();
+  Completer<void>? _writable;
+  bool _paused = false;
+  bool _closed = false;
+
+  WPNativeStream._(this._printer, this._functions, this._handle, this.streamId,
+      Stream<Map<String, dynamic>> allEvents)
+      : events = allEvents.where((event) => event['streamId'] == streamId),
+        _length = _printer._allocate(sizeOf<Uint64>()).cast(),
+        _info = _printer._allocate(sizeOf<_StreamInfo>()).cast() {
+    _subscription = events.listen(_onEvent);
+  }
+
+  /// Above the high watermark; wait for a `writable` event (as [writeAll]
+  /// does) before writing more
+  bool get paused => _paused;
+
+  /// Copy as much of [data] from [start] on as the buffer has room for, and
+  /// return the number of bytes taken. Throws a [WPNativePrinterException]
+  /// once the job has failed.
+  int write(Uint8List data, [int start = 0]) {
+    _checkOpen();
+    RangeError.checkValueInInterval(start, 0, data.length, 'start');
+    var offset = start;
+    while (offset < data.length) {
+      final region = _functions.reserve(_handle, _length);
+      final available = _length.value;
+      if (available == 0) break;
+      final count = min(available, data.length - offset);
+      region.asTypedList(count).setRange(0, count, data, offset);
+      final result = _functions.commit(_handle, count);
+      if (result == _ffiPaused) {
+        _paused = true;
+        return offset + count - start;
+      }
+      if (result != _ffiOk) throw WPNativePrinterException('failed');
+      offset += count;
+    }
+    if (offset < data.length && info()['failed'] == true) {
+      throw WPNativePrinterException('failed');
+    }
+    return offset - start;
+  }
+
+  /// Write all of [data], waiting for the printer to catch up whenever the
+  /// buffer fills. Throws a [StateError] if the job ends first.
+  Future<void> writeAll(Uint8List data) async {
+    var offset = 0;
+    while (true) {
+      offset += write(data, offset);
+      if (offset >= data.length) return;
+      if (_paused) {
+        await (_writable ??= Completer<void>()).future;
+      } else {
+        // Full below the high watermark only while a commit is in flight
+        await Future<void>.delayed(const Duration(milliseconds: 1));
+      }
+    }
+  }
+
+  /// Buffer and job state: `streamId`, `jobId`, `capacity`, `buffered`,
+  /// `bytesWritten` and `failed`
+  Map<String, dynamic> info() {
+    _checkOpen();
+    _printer._check(_functions.getInfo(_handle, _info));
+    final info = _info.ref;
+    return {
+      'streamId': info.streamId,
+      'jobId': info.jobId,
+      'capacity': info.capacity,
+      'buffered': info.buffered,
+      'bytesWritten': info.bytesWritten,
+      'failed': info.failed != 0,
+    };
+  }
+
+  /// No more data: everything written is printed and the job ends. Completes
+  /// with the stream's last event, normally `finished`.
+  Future<Map<String, dynamic>> close() => _close(abort: false);
+
+  /// Cancel the job. Completes with the stream's last event, normally
+  /// `cancelled`.
+  Future<Map<String, dynamic>> abort() => _close(abort: true);
+
+  Future<Map<String, dynamic>> _close({required bool abort}) {
+    if (!_closed) {
+      _closed = true;
+      _functions.close(_handle, abort ? 1 : 0);
+      _printer._free(_length.cast());
+      _printer._free(_info.cast());
+    }
+    return _done.future;
+  }
+
+  void _onEvent(Map<String, dynamic> event) {
+    final type = event['type'];
+    if (type == 'writable') {
+      _paused = false;
+      _writable?.complete();
+      _writable = null;
+    } else if (type == 'finished' || type == 'failed' || type == 'cancelled') {
+      _writable?.completeError(StateError('The print stream ended: $type'));
+      _writable = null;
+      if (!_done.isCompleted) _done.complete(event);
+      _subscription.cancel();
+    }
+  }
+
+  void _checkOpen() {
+    if (_closed) throw StateError('The print stream is closed');
+  }
+}
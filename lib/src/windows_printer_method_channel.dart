@@ -8,6 +8,22 @@ class MethodChannelWindowsPrinter extends WindowsPrinterPlatform {
   @visibleForTesting
   final methodChannel = const MethodChannel('windows_printer');
 
+  /// The event channel used to stream printer discovery events.
+  @visibleForTesting
+  final discoveryChannel = const EventChannel('windows_printer/discovery');
+
+  /// The event channel used to stream network scan results.
+  @visibleForTesting
+  final networkScanChannel = const EventChannel('windows_printer/network_scan');
+
+  /// The event channel used to stream print job state changes.
+  @visibleForTesting
+  final jobsChannel = const EventChannel('windows_printer/jobs');
+
+  /// The event channel used to stream queue limit backpressure.
+  @visibleForTesting
+  final queuePressureChannel = const EventChannel('windows_printer/queue_pressure');
+
   @override
   Future<List<String>> getAvailablePrinters() async {
     final List<Object?> result = await methodChannel.invokeMethod('getAvailablePrinters');
@@ -15,9 +31,46 @@ class MethodChannelWindowsPrinter extends WindowsPrinterPlatform {
   }
 
   @override
-  Future<Map<String, dynamic>> getPrinterProperties(String printerName) async {
+  Future<Map<String, dynamic>> getPrinterProperties(
+    String printerName, {
+    List<String>? fields,
+  }) async {
     final Map<Object?, Object?> result = await methodChannel.invokeMethod(
       'getPrinterProperties',
+      {
+        'printerName': printerName,
+        if (fields != null) 'fields': fields,
+      },
+    );
+    return _convertMap(result);
+  }
+
+  @override
+  Future<Map<String, Map<String, dynamic>>> getPrinterPropertiesBatch(
+    List<String> printerNames, {
+    Duration timeout = const Duration(seconds: 5),
+    int maxConcurrency = 8,
+    List<String>? fields,
+  }) async {
+    final Map<Object?, Object?> result = await methodChannel.invokeMethod(
+      'getPrinterPropertiesBatch',
+      {
+        'printerNames': printerNames,
+        'timeoutMs': timeout.inMilliseconds,
+        'maxConcurrency': maxConcurrency,
+        if (fields != null) 'fields': fields,
+      },
+    );
+    return result.map((name, properties) => MapEntry(
+          name.toString(),
+          _convertMap(properties as Map<Object?, Object?>),
+        ));
+  }
+
+  @override
+  Future<Map<String, dynamic>> getPrinterStatus(String printerName) async {
+    final Map<Object?, Object?> result = await methodChannel.invokeMethod(
+      'getPrinterStatus',
       {'printerName': printerName},
     );
     return _convertMap(result);
@@ -37,6 +90,13 @@ class MethodChannelWindowsPrinter extends WindowsPrinterPlatform {
     String? printerName,
     required Uint8List data,
     bool useRawDatatype = true,
+    Duration? timeout,
+    int copies = 1,
+    List<Uint8List>? copyVariants,
+    String? idempotencyKey,
+    bool deduplicate = false,
+    String? overflow,
+    Duration? overflowTimeout,
   }) async {
     final bool result = await methodChannel.invokeMethod(
       'printRawData',
@@ -44,11 +104,111 @@ class MethodChannelWindowsPrinter extends WindowsPrinterPlatform {
         'printerName': printerName ?? '',
         'data': data,
         'useRawDatatype': useRawDatatype,
+        if (timeout != null) 'timeoutMs': timeout.inMilliseconds,
+        'copies': copies,
+        if (copyVariants != null) 'copyVariants': copyVariants,
+        if (idempotencyKey != null) 'idempotencyKey': idempotencyKey,
+        'deduplicate': deduplicate,
+        if (overflow != null) 'overflow': overflow,
+        if (overflowTimeout != null) 'overflowTimeoutMs': overflowTimeout.inMilliseconds,
+      },
+    );
+    return result;
+  }
+
+  @override
+  Future<int> printRawJob({
+    String? printerName,
+    required Uint8List data,
+    bool useRawDatatype = true,
+    Duration? timeout,
+    int copies = 1,
+    List<Uint8List>? copyVariants,
+    String? idempotencyKey,
+    bool deduplicate = false,
+    String? overflow,
+    Duration? overflowTimeout,
+  }) async {
+    final int result = await methodChannel.invokeMethod(
+      'printRawJob',
+      {
+        'printerName': printerName ?? '',
+        'data': data,
+        'useRawDatatype': useRawDatatype,
+        if (timeout != null) 'timeoutMs': timeout.inMilliseconds,
+        'copies': copies,
+        if (copyVariants != null) 'copyVariants': copyVariants,
+        if (idempotencyKey != null) 'idempotencyKey': idempotencyKey,
+        'deduplicate': deduplicate,
+        if (overflow != null) 'overflow': overflow,
+        if (overflowTimeout != null) 'overflowTimeoutMs': overflowTimeout.inMilliseconds,
       },
     );
     return result;
   }
 
+  @override
+  Future<bool> cancelJob(int jobId, {String? printerName}) async {
+    final bool result = await methodChannel.invokeMethod(
+      'cancelJob',
+      {
+        'jobId': jobId,
+        'printerName': printerName ?? '',
+      },
+    );
+    return result;
+  }
+
+  @override
+  Future<bool> setDeduplicationWindow(Duration window) async {
+    final bool result = await methodChannel.invokeMethod(
+      'setDeduplicationWindow',
+      {'windowMs': window.inMilliseconds},
+    );
+    return result;
+  }
+
+  @override
+  Future<bool> setQueueLimits({
+    int? maxJobs,
+    int? maxBytes,
+    int? maxJobsPerPrinter,
+    int? maxBytesPerPrinter,
+    String? overflow,
+    Duration? overflowTimeout,
+    String? spillDirectory,
+  }) async {
+    final bool result = await methodChannel.invokeMethod(
+      'setQueueLimits',
+      {
+        if (maxJobs != null) 'maxJobs': maxJobs,
+        if (maxBytes != null) 'maxBytes': maxBytes,
+        if (maxJobsPerPrinter != null) 'maxJobsPerPrinter': maxJobsPerPrinter,
+        if (maxBytesPerPrinter != null) 'maxBytesPerPrinter': maxBytesPerPrinter,
+        if (overflow != null) 'overflow': overflow,
+        if (overflowTimeout != null) 'overflowTimeoutMs': overflowTimeout.inMilliseconds,
+        if (spillDirectory != null) 'spillDirectory': spillDirectory,
+      },
+    );
+    return result;
+  }
+
+  @override
+  Stream<Map<String, dynamic>> queuePressure() {
+    return queuePressureChannel
+        .receiveBroadcastStream()
+        .map((event) => _convertMap(event as Map<Object?, Object?>));
+  }
+
+  @override
+  Future<bool> setOperationTimeout(Duration timeout) async {
+    final bool result = await methodChannel.invokeMethod(
+      'setOperationTimeout',
+      {'timeoutMs': timeout.inMilliseconds},
+    );
+    return result;
+  }
+
   @override
   Future<bool> printPdf({String? printerName, required Uint8List data, int copies = 1}) async {
     final Map<String, dynamic> args = {
@@ -64,6 +224,25 @@ class MethodChannelWindowsPrinter extends WindowsPrinterPlatform {
     return result;
   }
 
+  @override
+  Future<bool> printImage({
+    String? printerName,
+    required Uint8List rgba,
+    required int width,
+    required int height,
+  }) async {
+    final bool result = await methodChannel.invokeMethod(
+      'printImage',
+      {
+        'printerName': printerName ?? '',
+        'rgba': rgba,
+        'width': width,
+        'height': height,
+      },
+    );
+    return result;
+  }
+
   @override
   Future<bool> setDefaultPrinter(String printerName) async {
     final bool result = await methodChannel.invokeMethod(
@@ -88,6 +267,7 @@ class MethodChannelWindowsPrinter extends WindowsPrinterPlatform {
     required String content,
     String fontName = 'Courier New',
     int fontSize = 12,
+    String mode = 'auto',
   }) async {
     final bool result = await methodChannel.invokeMethod(
       'printRichTextDocument',
@@ -96,11 +276,165 @@ class MethodChannelWindowsPrinter extends WindowsPrinterPlatform {
         'content': content,
         'fontName': fontName,
         'fontSize': fontSize,
+        'mode': mode,
       },
     );
     return result;
   }
 
+  @override
+  Future<Map<String, dynamic>> getMetrics() async {
+    final Map<Object?, Object?> result = await methodChannel.invokeMethod('getMetrics');
+    return _convertMap(result);
+  }
+
+  @override
+  Future<bool> resetMetrics() async {
+    final bool result = await methodChannel.invokeMethod('resetMetrics');
+    return result;
+  }
+
+  @override
+  Future<bool> setReprintCacheLimits({int? maxBytes, int? maxEntries}) async {
+    final bool result = await methodChannel.invokeMethod(
+      'setReprintCacheLimits',
+      {
+        if (maxBytes != null) 'maxBytes': maxBytes,
+        if (maxEntries != null) 'maxEntries': maxEntries,
+      },
+    );
+    return result;
+  }
+
+  @override
+  Future<bool> clearReprintCache() async {
+    final bool result = await methodChannel.invokeMethod('clearReprintCache');
+    return result;
+  }
+
+  @override
+  Future<bool> setTracingEnabled(bool enabled) async {
+    final bool result = await methodChannel.invokeMethod(
+      'setTracingEnabled',
+      {'enabled': enabled},
+    );
+    return result;
+  }
+
+  @override
+  Future<String> dumpTrace({bool clear = true}) async {
+    final String result = await methodChannel.invokeMethod(
+      'dumpTrace',
+      {'clear': clear},
+    );
+    return result;
+  }
+
+  @override
+  Stream<Map<String, dynamic>> jobEvents() {
+    return jobsChannel
+        .receiveBroadcastStream()
+        .map((event) => _convertMap(event as Map<Object?, Object?>));
+  }
+
+  @override
+  Future<Map<String, dynamic>?> getJob(int jobId, {String? printerName}) async {
+    final Map<Object?, Object?>? result = await methodChannel.invokeMethod(
+      'getJob',
+      {
+        'jobId': jobId,
+        'printerName': printerName ?? '',
+      },
+    );
+    return result == null ? null : _convertMap(result);
+  }
+
+  @override
+  Stream<Map<String, dynamic>> discoverPrinters() {
+    return discoveryChannel
+        .receiveBroadcastStream()
+        .map((event) => _convertMap(event as Map<Object?, Object?>));
+  }
+
+  @override
+  Future<Map<String, dynamic>> renderPreview(Uint8List data, {int paperWidth = 576}) async {
+    final Map<Object?, Object?> result = await methodChannel.invokeMethod(
+      'renderPreview',
+      {
+        'data': data,
+        'paperWidth': paperWidth,
+      },
+    );
+    return _convertMap(result);
+  }
+
+  @override
+  Future<Map<String, dynamic>> routeOrder(
+    Map<String, dynamic> order,
+    List<Map<String, dynamic>> stations, {
+    Duration? timeout,
+    int maxConcurrency = 8,
+  }) async {
+    final Map<Object?, Object?> result = await methodChannel.invokeMethod(
+      'routeOrder',
+      {
+        'order': order,
+        'stations': stations,
+        if (timeout != null) 'timeoutMs': timeout.inMilliseconds,
+        'maxConcurrency': maxConcurrency,
+      },
+    );
+    return _convertMap(result);
+  }
+
+  @override
+  Future<Uint8List> encodeLabel(
+    String language,
+    Map<String, dynamic> layout, {
+    String mode = 'label',
+    String? name,
+    Map<int, String>? fields,
+    int copies = 1,
+  }) async {
+    final Uint8List result = await methodChannel.invokeMethod(
+      'encodeLabel',
+      {
+        'language': language,
+        'layout': layout,
+        'mode': mode,
+        if (name != null) 'name': name,
+        if (fields != null) 'fields': fields,
+        'copies': copies,
+      },
+    );
+    return result;
+  }
+
+  @override
+  Future<bool> refreshPrinters() async {
+    final bool result = await methodChannel.invokeMethod('refreshPrinters');
+    return result;
+  }
+
+  @override
+  Stream<Map<String, dynamic>> scanNetwork(
+    String cidr, {
+    List<int>? ports,
+    int? maxInFlight,
+    Duration? connectTimeout,
+    Duration? statusTimeout,
+  }) {
+    return networkScanChannel
+        .receiveBroadcastStream({
+          'cidr': cidr,
+          if (ports != null) 'ports': ports,
+          if (maxInFlight != null) 'maxInFlight': maxInFlight,
+          if (connectTimeout != null) 'connectTimeoutMs': connectTimeout.inMilliseconds,
+          if (statusTimeout != null) 'statusTimeoutMs': statusTimeout.inMilliseconds,
+        })
+        .map((event) => _convertMap(event as Map<Object?, Object?>));
+  }
+
   // Helper to convert from platform channel types to Dart types
   Map<String, dynamic> _convertMap(Map<Object?, Object?> map) {
     final result = <String, dynamic>{};
@@ -110,6 +444,8 @@ class MethodChannelWindowsPrinter extends WindowsPrinterPlatform {
       
       if (value is Map<Object?, Object?>) {
         result[key] = _convertMap(value);
+      } else if (value is Uint8List) {
+        result[key] = value;
       } else if (value is List<Object?>) {
         result[key] = _convertList(value);
       } else {
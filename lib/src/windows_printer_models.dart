@@ -1,3 +1,5 @@
+import 'dart:typed_data';
+
 import 'windows_printer_enums.dart';
 
 /// Text styling options
@@ -63,4 +65,251 @@ class ReceiptItem {
     required this.price,
     this.description,
   });
-}
\ No newline at end of file
+}
+
+/// One element of a [WPLabel]. Positions and sizes are in printer dots.
+///
+/// Text, barcode and QR code elements with a [field] number become
+/// variables of a stored format: the format keeps a placeholder and every
+/// recall sends only the field's value. Outside stored formats [data] is
+/// printed.
+class WPLabelElement {
+  final String type;
+  final int x;
+  final int y;
+  final String data;
+  final int field;
+  final int height;
+  final int width;
+  final WPLabelBarcodeType barcodeType;
+  final bool showText;
+  final Uint8List? rgba;
+  final int imageWidth;
+  final int imageHeight;
+
+  const WPLabelElement._({
+    required this.type,
+    required this.x,
+    required this.y,
+    this.data = '',
+    this.field = 0,
+    this.height = 30,
+    this.width = 0,
+    this.barcodeType = WPLabelBarcodeType.code128,
+    this.showText = true,
+    this.rgba,
+    this.imageWidth = 0,
+    this.imageHeight = 0,
+  });
+
+  /// Text in the printer's scalable (ZPL) or closest built-in (TSPL) font.
+  /// [width] 0 keeps the characters square.
+  const WPLabelElement.text(
+    int x,
+    int y,
+    String data, {
+    int height = 30,
+    int width = 0,
+    int field = 0,
+  }) : this._(type: 'text', x: x, y: y, data: data, height: height, width: width, field: field);
+
+  /// A barcode [height] dots tall with [moduleWidth] dot narrow bars
+  const WPLabelElement.barcode(
+    int x,
+    int y,
+    String data, {
+    WPLabelBarcodeType type = WPLabelBarcodeType.code128,
+    int height = 80,
+    int moduleWidth = 2,
+    bool showText = true,
+    int field = 0,
+  }) : this._(
+          type: 'barcode',
+          x: x,
+          y: y,
+          data: data,
+          barcodeType: type,
+          height: height,
+          width: moduleWidth,
+          showText: showText,
+          field: field,
+        );
+
+  /// A QR code with [moduleSize] dot modules, error correction M
+  const WPLabelElement.qrCode(
+    int x,
+    int y,
+    String data, {
+    int moduleSize = 4,
+    int field = 0,
+  }) : this._(type: 'qrCode', x: x, y: y, data: data, width: moduleSize, field: field);
+
+  /// An RGBA image (4 bytes per pixel), thresholded to black and white.
+  /// ZPL sends it run-length compressed.
+  const WPLabelElement.graphic(
+    int x,
+    int y,
+    Uint8List rgba, {
+    required int width,
+    required int height,
+  }) : this._(type: 'graphic', x: x, y: y, rgba: rgba, imageWidth: width, imageHeight: height);
+
+  Map<String, dynamic> toMap() {
+    return {
+      'type': type,
+      'x': x,
+      'y': y,
+      'data': data,
+      'field': field,
+      'height': height,
+      'width': width,
+      'barcodeType': barcodeType.name,
+      'showText': showText,
+      if (rgba != null) 'rgba': rgba,
+      'imageWidth': imageWidth,
+      'imageHeight': imageHeight,
+    };
+  }
+}
+
+/// A label for a ZPL or TSPL printer, encoded natively by
+/// `WindowsPrinter.encodeLabel`
+class WPLabel {
+  /// Label size in millimetres; 0 leaves the printer's setting alone
+  final int widthMm;
+  final int heightMm;
+
+  /// Gap between labels in millimetres (TSPL only)
+  final int gapMm;
+
+  /// Print head resolution: 8 for 203 dpi, 12 for 300 dpi
+  final int dotsPerMm;
+  final List<WPLabelElement> elements;
+
+  const WPLabel({
+    this.widthMm = 0,
+    this.heightMm = 0,
+    this.gapMm = 2,
+    this.dotsPerMm = 8,
+    required this.elements,
+  });
+
+  /// [withGraphics] false leaves graphics out, which is all a recall needs
+  Map<String, dynamic> toMap({bool withGraphics = true}) {
+    return {
+      'widthMm': widthMm,
+      'heightMm': heightMm,
+      'gapMm': gapMm,
+      'dotsPerMm': dotsPerMm,
+      'elements': [
+        for (final element in elements)
+          if (withGraphics || element.type != 'graphic') element.toMap(),
+      ],
+    };
+  }
+}
+
+/// One line of a [WPOrder]
+class WPOrderItem {
+  final String name;
+
+  /// Routing key matched against [WPOrderStation.categories]
+  final String category;
+  final int quantity;
+
+  /// Modifiers printed under the item, such as 'no onions'
+  final List<String> notes;
+
+  /// Printed on stations that show prices
+  final String? price;
+
+  const WPOrderItem({
+    required this.name,
+    required this.category,
+    this.quantity = 1,
+    this.notes = const [],
+    this.price,
+  });
+
+  Map<String, dynamic> toMap() {
+    return {
+      'name': name,
+      'category': category,
+      'quantity': quantity,
+      'notes': notes,
+      if (price != null) 'price': price,
+    };
+  }
+}
+
+/// An order routed to station printers by `WindowsPrinter.routeOrder`
+class WPOrder {
+  /// Printed large on every ticket, such as 'Order 42'
+  final String title;
+
+  /// Lines under the title: table, server, time
+  final List<String> details;
+  final List<WPOrderItem> items;
+
+  /// Printed at the bottom of every ticket
+  final String? note;
+
+  /// Printed on stations that show prices
+  final String? total;
+
+  const WPOrder({
+    required this.title,
+    this.details = const [],
+    required this.items,
+    this.note,
+    this.total,
+  });
+
+  Map<String, dynamic> toMap() {
+    return {
+      'title': title,
+      'details': details,
+      'items': [for (final item in items) item.toMap()],
+      if (note != null) 'note': note,
+      if (total != null) 'total': total,
+    };
+  }
+}
+
+/// A printer that receives the items of some categories of each order
+class WPOrderStation {
+  /// Printed at the top of the ticket, such as 'KITCHEN'
+  final String name;
+
+  /// Null for the default printer
+  final String? printerName;
+
+  /// Categories printed here; empty receives every item, as for a
+  /// customer receipt
+  final List<String> categories;
+  final WPPaperSize paperSize;
+
+  /// Print item prices and the order total
+  final bool showPrices;
+  final int copies;
+
+  const WPOrderStation({
+    required this.name,
+    this.printerName,
+    this.categories = const [],
+    this.paperSize = WPPaperSize.mm80,
+    this.showPrices = false,
+    this.copies = 1,
+  });
+
+  Map<String, dynamic> toMap() {
+    return {
+      'name': name,
+      if (printerName != null) 'printerName': printerName,
+      'categories': categories,
+      'paperWidth': paperSize.width,
+      'showPrices': showPrices,
+      'copies': copies,
+    };
+  }
+}
@@ -29,7 +29,21 @@ abstract class WindowsPrinterPlatform extends PlatformInterface {
   Future<List<String>> getAvailablePrinters();
 
   /// Get detailed properties of a printer
-  Future<Map<String, dynamic>> getPrinterProperties(String printerName);
+  Future<Map<String, dynamic>> getPrinterProperties(
+    String printerName, {
+    List<String>? fields,
+  });
+
+  /// Get properties of many printers in parallel, keyed by printer name
+  Future<Map<String, Map<String, dynamic>>> getPrinterPropertiesBatch(
+    List<String> printerNames, {
+    Duration timeout = const Duration(seconds: 5),
+    int maxConcurrency = 8,
+    List<String>? fields,
+  });
+
+  /// Get a printer's status and status messages
+  Future<Map<String, dynamic>> getPrinterStatus(String printerName);
 
   /// Get detailed paper size information for a printer
   Future<Map<String, dynamic>> getPaperSizeDetails(String printerName);
@@ -39,8 +53,58 @@ abstract class WindowsPrinterPlatform extends PlatformInterface {
     String? printerName,
     required Uint8List data,
     bool useRawDatatype = true, // true=RAW (thermal), false=TEXT (regular)
+    Duration? timeout,
+    int copies = 1,
+    List<Uint8List>? copyVariants,
+    String? idempotencyKey,
+    bool deduplicate = false,
+    String? overflow,
+    Duration? overflowTimeout,
+  });
+
+  /// Print raw data like [printRawData] and return the spooler job id
+  Future<int> printRawJob({
+    String? printerName,
+    required Uint8List data,
+    bool useRawDatatype = true,
+    Duration? timeout,
+    int copies = 1,
+    List<Uint8List>? copyVariants,
+    String? idempotencyKey,
+    bool deduplicate = false,
+    String? overflow,
+    Duration? overflowTimeout,
   });
 
+  /// Cancel a spooler job
+  Future<bool> cancelJob(int jobId, {String? printerName});
+
+  /// Stream state changes of submitted raw print jobs
+  Stream<Map<String, dynamic>> jobEvents();
+
+  /// Last known state of a submitted raw print job, or null if unknown
+  Future<Map<String, dynamic>?> getJob(int jobId, {String? printerName});
+
+  /// Set how long raw submissions are remembered for deduplication
+  Future<bool> setDeduplicationWindow(Duration window);
+
+  /// Limit the raw print data waiting to be spooled
+  Future<bool> setQueueLimits({
+    int? maxJobs,
+    int? maxBytes,
+    int? maxJobsPerPrinter,
+    int? maxBytesPerPrinter,
+    String? overflow,
+    Duration? overflowTimeout,
+    String? spillDirectory,
+  });
+
+  /// Stream changes of backpressure on the queue limits
+  Stream<Map<String, dynamic>> queuePressure();
+
+  /// Set the deadline for every spooler-backed call
+  Future<bool> setOperationTimeout(Duration timeout);
+
   /// Print PDF data
   Future<bool> printPdf({
     String? printerName,
@@ -48,17 +112,82 @@ abstract class WindowsPrinterPlatform extends PlatformInterface {
     int copies = 1,
   });
 
+  /// Print RGBA pixels scaled to the page through the printer driver
+  Future<bool> printImage({
+    String? printerName,
+    required Uint8List rgba,
+    required int width,
+    required int height,
+  });
+
   /// Set default printer
   Future<bool> setDefaultPrinter(String printerName);
 
   /// Open printer properties dialog
   Future<bool> openPrinterProperties(String printerName);
 
-  /// Print rich text document with inline formatting
+  /// Print rich text document with inline formatting. [mode] is `auto`,
+  /// `gdi` or `escPos`.
   Future<bool> printRichTextDocument({
     required String printerName,
     required String content,
     String fontName = 'Courier New',
     int fontSize = 12,
+    String mode = 'auto',
+  });
+
+  /// Get native latency histograms and counters for the print path
+  Future<Map<String, dynamic>> getMetrics();
+
+  /// Reset native metrics
+  Future<bool> resetMetrics();
+
+  /// Limit the prepared output kept for reprinting
+  Future<bool> setReprintCacheLimits({int? maxBytes, int? maxEntries});
+
+  /// Drop all prepared output kept for reprinting
+  Future<bool> clearReprintCache();
+
+  /// Enable or disable native span tracing
+  Future<bool> setTracingEnabled(bool enabled);
+
+  /// Export recorded spans as Chrome trace-event JSON
+  Future<String> dumpTrace({bool clear = true});
+
+  /// Stream printer discovery events: a snapshot, then added/removed printers
+  Stream<Map<String, dynamic>> discoverPrinters();
+
+  /// Re-enumerate printers for active discovery listeners
+  Future<bool> refreshPrinters();
+
+  /// Probe an IPv4 range for network printers
+  Stream<Map<String, dynamic>> scanNetwork(
+    String cidr, {
+    List<int>? ports,
+    int? maxInFlight,
+    Duration? connectTimeout,
+    Duration? statusTimeout,
+  });
+
+  /// Render ESC/POS bytes to a PNG the way a receipt printer would print them
+  Future<Map<String, dynamic>> renderPreview(Uint8List data, {int paperWidth = 576});
+
+  /// Print an order's tickets on every station printer at once
+  Future<Map<String, dynamic>> routeOrder(
+    Map<String, dynamic> order,
+    List<Map<String, dynamic>> stations, {
+    Duration? timeout,
+    int maxConcurrency = 8,
+  });
+
+  /// Encode a label layout as ZPL or TSPL. [mode] is 'label', 'format' or
+  /// 'recall'; the last two need a stored format [name].
+  Future<Uint8List> encodeLabel(
+    String language,
+    Map<String, dynamic> layout, {
+    String mode = 'label',
+    String? name,
+    Map<int, String>? fields,
+    int copies = 1,
   });
 }
\ No newline at end of file
@@ -1,3 +1,4 @@
+import 'dart:async';
 import 'dart:typed_data';
 import 'src/windows_printer_platform_interface.dart';
 import 'windows_printer.dart';
@@ -7,6 +8,7 @@ export 'src/windows_printer_models.dart';
 export 'src/windows_printer_enums.dart';
 export 'src/esc_pos/windows_printer_esc_pos_generator.dart';
 export 'src/esc_pos/windows_printer_receipt_builder.dart';
+export 'src/windows_printer_ffi.dart';
 
 class WindowsPrinter {
   /// Get the list of available printers
@@ -15,8 +17,72 @@ class WindowsPrinter {
   }
 
   /// Get detailed properties of a printer
-  static Future<Map<String, dynamic>> getPrinterProperties(String printerName) {
-    return WindowsPrinterPlatform.instance.getPrinterProperties(printerName);
+  ///
+  /// [fields] limits the result to the named sections, and only those are
+  /// queried: `'isDefault'`, `'status'`, `'info'`, `'attributes'`, `'queue'`,
+  /// `'paperSizes'` and `'resolutions'`. Paper sizes and resolutions come
+  /// from the driver and cost far more than the rest, so leave them out
+  /// when polling. Null returns every section.
+  ///
+  /// Example:
+  /// ```dart
+  /// final props = await WindowsPrinter.getPrinterProperties(
+  ///   'Kitchen',
+  ///   fields: ['isDefault', 'status', 'queue'],
+  /// );
+  /// ```
+  static Future<Map<String, dynamic>> getPrinterProperties(
+    String printerName, {
+    List<String>? fields,
+  }) {
+    return WindowsPrinterPlatform.instance
+        .getPrinterProperties(printerName, fields: fields);
+  }
+
+  /// Get a printer's `status` bits and `statusMessages`
+  ///
+  /// The cheapest query there is, one small spooler call, so suited to
+  /// polling many printers. Same as [getPrinterProperties] with
+  /// `fields: ['status']`.
+  static Future<Map<String, dynamic>> getPrinterStatus(String printerName) {
+    return WindowsPrinterPlatform.instance.getPrinterStatus(printerName);
+  }
+
+  /// Get detailed properties of many printers at once
+  ///
+  /// Printers are queried in parallel on up to [maxConcurrency] native
+  /// threads, and each one gets [timeout] to answer, so a single unreachable
+  /// network printer no longer stalls the rest. The result maps each printer
+  /// name to the same properties [getPrinterProperties] returns. A printer
+  /// that missed its deadline maps to `{'timedOut': true, 'error': 'Timed out',
+  /// 'elapsedMs': ...}` instead. [fields] selects sections as it does for
+  /// [getPrinterProperties].
+  ///
+  /// Example:
+  /// ```dart
+  /// final printers = await WindowsPrinter.getAvailablePrinters();
+  /// final properties = await WindowsPrinter.getPrinterPropertiesBatch(
+  ///   printers,
+  ///   timeout: const Duration(seconds: 2),
+  /// );
+  /// for (final entry in properties.entries) {
+  ///   if (entry.value['timedOut'] == true) {
+  ///     print('${entry.key} did not answer');
+  ///   }
+  /// }
+  /// ```
+  static Future<Map<String, Map<String, dynamic>>> getPrinterPropertiesBatch(
+    List<String> printerNames, {
+    Duration timeout = const Duration(seconds: 5),
+    int maxConcurrency = 8,
+    List<String>? fields,
+  }) {
+    return WindowsPrinterPlatform.instance.getPrinterPropertiesBatch(
+      printerNames,
+      timeout: timeout,
+      maxConcurrency: maxConcurrency,
+      fields: fields,
+    );
   }
 
   /// Get detailed paper size information for a printer
@@ -40,19 +106,243 @@ class WindowsPrinter {
   /// - Barcode printing now works with proper ESC/POS sequences
   /// - Image printing now supported with monochrome bitmap conversion
   /// - QR codes enhanced with error correction and size options
+  ///
+  /// **Timeouts:** the job must be spooled within [timeout] (default: the
+  /// operation timeout, see [setOperationTimeout]). Otherwise the job is
+  /// cancelled and a `PlatformException` with code `TIMEOUT` is thrown; its
+  /// `details['jobId']` is the cancelled job, or 0 if none was started.
+  ///
+  /// **Copies:** [copies] (1 to 999) are printed by one job and [data] is
+  /// sent to the plugin once. TEXT jobs leave the copies to the driver where
+  /// it can make them; otherwise the data is repeated natively. Entry `i` of
+  /// [copyVariants] is printed on copy `i` only, after the last printed line
+  /// and before the closing feeds and cut, e.g. a "MERCHANT COPY" footer.
+  ///
+  /// **Duplicates:** a job with the same [idempotencyKey] as one printed on
+  /// the same printer within the deduplication window (one minute by
+  /// default, see [setDeduplicationWindow]) is acknowledged without printing
+  /// again. With [deduplicate] and no key, the same data, datatype and
+  /// copies count as the same job. Failed jobs are not remembered.
+  ///
+  /// **Queue limits:** when the limits set by [setQueueLimits] are reached
+  /// the job is handled by [overflow] (default: the policy set there). A
+  /// rejected job, or one that waited longer than [overflowTimeout], throws
+  /// a `PlatformException` with code `QUEUE_FULL`; its `details` hold
+  /// `printerName`, `timedOut`, `pendingJobs` and `pendingBytes`.
   static Future<bool> printRawData({
     String? printerName, // null = use default printer
     required Uint8List data,
     bool useRawDatatype = true, // true=RAW (thermal), false=TEXT (regular)
+    Duration? timeout,
+    int copies = 1,
+    List<Uint8List>? copyVariants,
+    String? idempotencyKey,
+    bool deduplicate = false,
+    WPOverflowPolicy? overflow,
+    Duration? overflowTimeout,
   }) {
     return WindowsPrinterPlatform.instance.printRawData(
       printerName: printerName,
       data: data,
       useRawDatatype: useRawDatatype,
+      timeout: timeout,
+      copies: copies,
+      copyVariants: copyVariants,
+      idempotencyKey: idempotencyKey,
+      deduplicate: deduplicate,
+      overflow: overflow?.name,
+      overflowTimeout: overflowTimeout,
     );
   }
 
+  /// Print raw data like [printRawData] and return the spooler job id
+  ///
+  /// The job's progress is reported on [jobEvents] and by [getJob];
+  /// [waitForJob] waits until it has printed. A duplicate (see
+  /// [printRawData]) returns the id of the job that printed.
+  static Future<int> printRawJob({
+    String? printerName, // null = use default printer
+    required Uint8List data,
+    bool useRawDatatype = true,
+    Duration? timeout,
+    int copies = 1,
+    List<Uint8List>? copyVariants,
+    String? idempotencyKey,
+    bool deduplicate = false,
+    WPOverflowPolicy? overflow,
+    Duration? overflowTimeout,
+  }) {
+    return WindowsPrinterPlatform.instance.printRawJob(
+      printerName: printerName,
+      data: data,
+      useRawDatatype: useRawDatatype,
+      timeout: timeout,
+      copies: copies,
+      copyVariants: copyVariants,
+      idempotencyKey: idempotencyKey,
+      deduplicate: deduplicate,
+      overflow: overflow?.name,
+      overflowTimeout: overflowTimeout,
+    );
+  }
+
+  /// Follow raw print jobs through the spooler queue
+  ///
+  /// Every job submitted with [printRawData] or [printRawJob] is reported
+  /// when its `state` changes: `spooling`, `printing`, `error` (the printer
+  /// is offline, out of paper or needs attention; the job may still print),
+  /// and finally `printed` or `deleted`. Each event is a map with `jobId`,
+  /// `printerName`, `documentName`, `state`, `status` (the spooler's
+  /// JOB_STATUS_* bits), `pagesPrinted` and `totalPages`.
+  ///
+  /// The spooler forgets a job once it leaves the queue, so `printed` means
+  /// the whole job was handed to the printer without being deleted.
+  static Stream<Map<String, dynamic>> jobEvents() {
+    return WindowsPrinterPlatform.instance.jobEvents();
+  }
+
+  /// Last known state of a raw print job, in the format of [jobEvents]
+  ///
+  /// Recently finished jobs are remembered; returns null for jobs that were
+  /// not submitted through this plugin. [printerName] null matches the job
+  /// on any printer.
+  static Future<Map<String, dynamic>?> getJob(int jobId, {String? printerName}) {
+    return WindowsPrinterPlatform.instance.getJob(jobId, printerName: printerName);
+  }
+
+  /// Wait until a raw print job has printed or been deleted
+  ///
+  /// Returns the job's final state in the format of [jobEvents]. Throws an
+  /// [ArgumentError] for a job that is not known, and a [TimeoutException]
+  /// if [timeout] passes first.
+  ///
+  /// Example:
+  /// ```dart
+  /// final jobId = await WindowsPrinter.printRawJob(printerName: 'Kitchen', data: ticket);
+  /// final job = await WindowsPrinter.waitForJob(jobId, timeout: const Duration(minutes: 1));
+  /// if (job['state'] != 'printed') print('Ticket was not printed');
+  /// ```
+  static Future<Map<String, dynamic>> waitForJob(
+    int jobId, {
+    String? printerName,
+    Duration? timeout,
+  }) async {
+    bool matches(Map<String, dynamic> job) =>
+        job['jobId'] == jobId && (printerName == null || job['printerName'] == printerName);
+    bool finished(Map<String, dynamic> job) =>
+        job['state'] == 'printed' || job['state'] == 'deleted';
+
+    final completer = Completer<Map<String, dynamic>>();
+    final subscription = jobEvents().listen((job) {
+      if (matches(job) && finished(job) && !completer.isCompleted) completer.complete(job);
+    });
+    try {
+      // The job may have finished before the stream was listened to
+      final known = await getJob(jobId, printerName: printerName);
+      if (known == null) {
+        throw ArgumentError.value(jobId, 'jobId', 'Not a job submitted by this plugin');
+      }
+      if (finished(known) && !completer.isCompleted) completer.complete(known);
+      return await (timeout == null ? completer.future : completer.future.timeout(timeout));
+    } finally {
+      await subscription.cancel();
+    }
+  }
+
+  /// Set how long [printRawData] remembers jobs submitted with an
+  /// `idempotencyKey` or `deduplicate: true`
+  ///
+  /// Each printer remembers its 128 most recent such jobs. [Duration.zero]
+  /// turns deduplication off.
+  static Future<bool> setDeduplicationWindow(Duration window) {
+    return WindowsPrinterPlatform.instance.setDeduplicationWindow(window);
+  }
+
+  /// Limit the raw print data held in memory until it has been spooled
+  ///
+  /// Jobs from [printRawData] and [printRawJob] count against the limits of
+  /// their printer ([maxJobsPerPrinter], [maxBytesPerPrinter]) and against
+  /// the limits shared by all printers ([maxJobs], [maxBytes]). Limits that
+  /// are null or 0 are lifted; every call replaces all of them. A job larger
+  /// than a byte limit still prints once it would be the only one queued.
+  ///
+  /// [overflow] is the default policy when a limit is reached, and
+  /// [overflowTimeout] how long [WPOverflowPolicy.block] and
+  /// [WPOverflowPolicy.spill] wait (null waits until there is room). Spilled
+  /// jobs are written to [spillDirectory], or the temporary directory.
+  /// Waiting jobs for one printer print in the order they were submitted.
+  ///
+  /// Example:
+  /// ```dart
+  /// await WindowsPrinter.setQueueLimits(
+  ///   maxBytes: 64 << 20,
+  ///   maxJobsPerPrinter: 20,
+  ///   overflow: WPOverflowPolicy.block,
+  ///   overflowTimeout: const Duration(seconds: 30),
+  /// );
+  /// ```
+  static Future<bool> setQueueLimits({
+    int? maxJobs,
+    int? maxBytes,
+    int? maxJobsPerPrinter,
+    int? maxBytesPerPrinter,
+    WPOverflowPolicy overflow = WPOverflowPolicy.reject,
+    Duration? overflowTimeout,
+    String? spillDirectory,
+  }) {
+    return WindowsPrinterPlatform.instance.setQueueLimits(
+      maxJobs: maxJobs,
+      maxBytes: maxBytes,
+      maxJobsPerPrinter: maxJobsPerPrinter,
+      maxBytesPerPrinter: maxBytesPerPrinter,
+      overflow: overflow.name,
+      overflowTimeout: overflowTimeout,
+      spillDirectory: spillDirectory,
+    );
+  }
+
+  /// Follow backpressure on the limits set by [setQueueLimits]
+  ///
+  /// An event with `full: true` is sent when a job first finds a limit
+  /// reached, and one with `full: false` once the queue has drained to half
+  /// of every limit with no job waiting. Each event is a map with
+  /// `printerName` (null for the limits shared by all printers), `full`,
+  /// `pendingJobs` and `pendingBytes`.
+  static Stream<Map<String, dynamic>> queuePressure() {
+    return WindowsPrinterPlatform.instance.queuePressure();
+  }
+
+  /// Cancel and delete a job in the printer's queue
+  ///
+  /// [printerName] defaults to the default printer.
+  static Future<bool> cancelJob(int jobId, {String? printerName}) {
+    return WindowsPrinterPlatform.instance.cancelJob(jobId, printerName: printerName);
+  }
+
+  /// Set the deadline for calls that talk to the print spooler
+  ///
+  /// Applies to printer queries, printing and [setDefaultPrinter]; the
+  /// default is 30 seconds. A call that misses the deadline throws a
+  /// `PlatformException` with code `TIMEOUT` and is abandoned in the
+  /// background, so an offline network queue can no longer hang the app.
+  ///
+  /// Example:
+  /// ```dart
+  /// await WindowsPrinter.setOperationTimeout(const Duration(seconds: 5));
+  /// try {
+  ///   await WindowsPrinter.printRawData(printerName: 'Kitchen', data: ticket);
+  /// } on PlatformException catch (e) {
+  ///   if (e.code == 'TIMEOUT') print('Kitchen printer is not responding');
+  /// }
+  /// ```
+  static Future<bool> setOperationTimeout(Duration timeout) {
+    return WindowsPrinterPlatform.instance.setOperationTimeout(timeout);
+  }
+
   /// Print PDF data
+  ///
+  /// A PDF printed again on the same printer reuses the file prepared the
+  /// first time, see [setReprintCacheLimits].
   static Future<bool> printPdf({
     String? printerName,
     required Uint8List data,
@@ -65,6 +355,29 @@ class WindowsPrinter {
     );
   }
 
+  /// Print an image on one page through the printer driver
+  ///
+  /// [rgba] holds [width] x [height] pixels, four bytes each, e.g. from
+  /// `ui.Image.toByteData(format: ui.ImageByteFormat.rawRgba)`. The image is
+  /// scaled natively to fit the printable area, keeping its aspect ratio,
+  /// centered at the top of the page; transparent pixels are left as paper.
+  /// It is handed to the driver in bands, so even a full page at 600 dpi
+  /// never needs one page-sized bitmap. For receipt printers, print
+  /// ESC/POS raster images with [printRawData] instead.
+  static Future<bool> printImage({
+    String? printerName, // null = use default printer
+    required Uint8List rgba,
+    required int width,
+    required int height,
+  }) {
+    return WindowsPrinterPlatform.instance.printImage(
+      printerName: printerName,
+      rgba: rgba,
+      width: width,
+      height: height,
+    );
+  }
+
   /// Sets the specified printer as system default (affects all applications)
   static Future<bool> setDefaultPrinter(String printerName) {
     return WindowsPrinterPlatform.instance.setDefaultPrinter(printerName);
@@ -83,11 +396,18 @@ class WindowsPrinter {
   /// - `##large text##` for large header text
   /// - Regular text for normal formatting
   /// 
-  /// ⚠️ **EXPERIMENTAL**: Best suited for regular printers, not thermal printers.
-  /// 
   /// **Printer Type Guide:**
-  /// - ✅ **Regular printers**: Use this method for formatted text
-  /// - ❌ **Thermal printers**: Use `printRawData(useRawDatatype: true)` with ESC/POS commands instead
+  /// - ✅ **Regular printers**: The text is rendered by the driver with [fontName]
+  ///   and [fontSize]
+  /// - ✅ **Thermal printers**: With [mode] `WPRichTextMode.auto` receipt
+  ///   printers are detected from their driver and paper width and get the
+  ///   markup as ESC/POS text commands in their own fonts: bold is emphasized,
+  ///   italic is underlined and large text is double size. The job is cut at
+  ///   the end. Use `WPRichTextMode.gdi` or `WPRichTextMode.escPos` to force a path.
+  ///
+  /// A document printed again with the same printer, mode, font and size
+  /// skips printer detection, encoding and text layout, see
+  /// [setReprintCacheLimits].
   /// 
   /// Example:
   /// ```dart
@@ -111,12 +431,321 @@ class WindowsPrinter {
     required String content,
     String fontName = 'Courier New',
     int fontSize = 12,
+    WPRichTextMode mode = WPRichTextMode.auto,
   }) {
     return WindowsPrinterPlatform.instance.printRichTextDocument(
       printerName: printerName,
       content: content,
       fontName: fontName,
       fontSize: fontSize,
+      mode: mode.name,
+    );
+  }
+
+  /// Get native latency and throughput metrics for the print path
+  ///
+  /// The returned map contains:
+  /// - `stages`: latency histograms for argument decoding, result encoding,
+  ///   `openPrinter`, `queryPrinter`, `startDocPrinter`, `writePrinter` and
+  ///   `endDocPrinter`
+  /// - `methods`: per channel method latency, `failures` and `callsPerSecond`
+  /// - `errors`: failure counts by stage and Win32 error `code`
+  /// - `bytesWritten`, `queueDepth`, `peakQueueDepth` and `elapsedSeconds`
+  /// - `pendingJobs`, `pendingBytes` and `peakPendingBytes`: raw print data
+  ///   waiting to be spooled; `spilledBytes` of it waits on disk (see
+  ///   [setQueueLimits])
+  /// - `rejectedJobs`, `blockedJobs` and `spilledJobs`: jobs that found a
+  ///   queue limit reached
+  /// - `reprintCache`: see [setReprintCacheLimits]
+  ///
+  /// Each histogram reports `count`, `totalNs`, `minNs`, `maxNs`, `meanNs`,
+  /// `p50Ns`, `p90Ns`, `p99Ns` and `p999Ns`. Percentiles are accurate to
+  /// within about 6%.
+  static Future<Map<String, dynamic>> getMetrics() {
+    return WindowsPrinterPlatform.instance.getMetrics();
+  }
+
+  /// Reset all native metrics and restart the `elapsedSeconds` clock
+  static Future<bool> resetMetrics() {
+    return WindowsPrinterPlatform.instance.resetMetrics();
+  }
+
+  /// Limit the output kept for documents printed again and again
+  ///
+  /// [printRichTextDocument] keeps what it prepared for a printer (the
+  /// ESC/POS bytes or the GDI text layout) keyed by a hash of the content,
+  /// printer and settings, and reprints it without preparing it again. A
+  /// GDI layout still opens the printer and creates its fonts; only
+  /// measuring the text is skipped. [printPdf] is not cached. The least recently used documents are
+  /// evicted beyond [maxBytes] (32 MB by default) or [maxEntries] (64);
+  /// null keeps a limit and 0 turns the cache off. `getMetrics()['reprintCache']` reports its `entries`,
+  /// `bytes`, `hits`, `misses` and `evictions`.
+  static Future<bool> setReprintCacheLimits({int? maxBytes, int? maxEntries}) {
+    return WindowsPrinterPlatform.instance
+        .setReprintCacheLimits(maxBytes: maxBytes, maxEntries: maxEntries);
+  }
+
+  /// Forget every document kept by the reprint cache and delete its
+  /// temporary files, e.g. after printer settings changed
+  static Future<bool> clearReprintCache() {
+    return WindowsPrinterPlatform.instance.clearReprintCache();
+  }
+
+  /// Enable or disable native span tracing of the print path
+  ///
+  /// While enabled, every channel call and each native stage (argument
+  /// decoding, `OpenPrinter`, `StartDocPrinter`, `WritePrinter`,
+  /// `EndDocPrinter`, result encoding) is recorded into a ring buffer that
+  /// keeps the most recent 4096 spans. Tracing is off by default and costs
+  /// next to nothing while disabled.
+  static Future<bool> setTracingEnabled(bool enabled) {
+    return WindowsPrinterPlatform.instance.setTracingEnabled(enabled);
+  }
+
+  /// Export the recorded spans as Chrome trace-event JSON
+  ///
+  /// Save the result to a `.json` file and open it in https://ui.perfetto.dev
+  /// or `chrome://tracing`. Set [clear] to `false` to keep the spans in the
+  /// buffer after exporting.
+  ///
+  /// Example:
+  /// ```dart
+  /// await WindowsPrinter.setTracingEnabled(true);
+  /// await WindowsPrinter.printRawData(data: receipt);
+  /// await File('print_trace.json').writeAsString(await WindowsPrinter.dumpTrace());
+  /// ```
+  static Future<String> dumpTrace({bool clear = true}) {
+    return WindowsPrinterPlatform.instance.dumpTrace(clear: clear);
+  }
+
+  /// Discover printers incrementally without blocking on slow print servers
+  ///
+  /// The first event is a `snapshot` with every printer known so far. On a
+  /// cold start it is served from the cache of the previous run
+  /// (`fromCache: true`). Local printers follow immediately, and printer
+  /// connections stream in as `added` events as the spooler resolves them.
+  /// After that only `added` and `removed` events are sent, and `complete`
+  /// marks the end of each full enumeration.
+  ///
+  /// Each event is a map with `type`, `printers` (a list of
+  /// `{name, isLocal}` maps) and `fromCache`.
+  ///
+  /// Example:
+  /// ```dart
+  /// final printers = <String>{};
+  /// WindowsPrinter.discoverPrinters().listen((event) {
+  ///   final names = (event['printers'] as List).map((p) => p['name'] as String);
+  ///   switch (event['type']) {
+  ///     case 'snapshot':
+  ///       printers..clear()..addAll(names);
+  ///     case 'added':
+  ///       printers.addAll(names);
+  ///     case 'removed':
+  ///       printers.removeAll(names);
+  ///   }
+  /// });
+  /// ```
+  static Stream<Map<String, dynamic>> discoverPrinters() {
+    return WindowsPrinterPlatform.instance.discoverPrinters();
+  }
+
+  /// Re-enumerate printers while [discoverPrinters] is being listened to
+  ///
+  /// Listeners receive only the differences. Returns `false` when no
+  /// discovery stream is active.
+  static Future<bool> refreshPrinters() {
+    return WindowsPrinterPlatform.instance.refreshPrinters();
+  }
+
+  /// Find Ethernet printers on a subnet
+  ///
+  /// Probes every address in [cidr] (e.g. `192.168.1.0/24`, at most a /16)
+  /// for the raw (9100), LPD (515) and IPP (631) ports, or for [ports] if
+  /// given. Hosts that accept on port 9100 are sent an ESC/POS status request
+  /// so receipt printers can be told apart from other devices.
+  ///
+  /// Each host with an open port is reported as a `found` event with
+  /// `address`, `openPorts`, `escPos`, `statusByte`, `scanned` and `total`.
+  /// A final `complete` event carries `scanned`, `total`, `cancelled` and
+  /// `elapsedMs`, after which the stream closes. Cancelling the subscription
+  /// stops the scan.
+  ///
+  /// Probes run concurrently ([maxInFlight], default 1024), so a /22 takes
+  /// a few seconds. [connectTimeout] (default 400 ms) and [statusTimeout]
+  /// (default 300 ms) bound each probe.
+  ///
+  /// Example:
+  /// ```dart
+  /// WindowsPrinter.scanNetwork('192.168.1.0/24').listen((event) {
+  ///   if (event['type'] == 'found' && event['escPos'] == true) {
+  ///     print('Receipt printer at ${event['address']}');
+  ///   }
+  /// });
+  /// ```
+  static Stream<Map<String, dynamic>> scanNetwork(
+    String cidr, {
+    List<int>? ports,
+    int? maxInFlight,
+    Duration? connectTimeout,
+    Duration? statusTimeout,
+  }) {
+    return WindowsPrinterPlatform.instance.scanNetwork(
+      cidr,
+      ports: ports,
+      maxInFlight: maxInFlight,
+      connectTimeout: connectTimeout,
+      statusTimeout: statusTimeout,
+    );
+  }
+
+  /// Preview what a receipt printer would print for ESC/POS [data]
+  ///
+  /// Interprets the bytes natively (text styles, ESC * and GS v 0 images,
+  /// barcodes, QR codes, feeds and cuts) without a printer. Returns a map with
+  /// `png` (a 1-bit PNG as `Uint8List`), `width` and `height` in dots,
+  /// `cuts` (dot rows where the paper is cut), `drawerPulses`, `beeps`,
+  /// `unknownCommands` and `truncated`. Text prints in the printer's built-in
+  /// ASCII font; other characters show as '?'.
+  ///
+  /// Example:
+  /// ```dart
+  /// final generator = WPESCPOSGenerator(paperSize: WPPaperSize.mm58)
+  ///   ..text('Hello')
+  ///   ..cut();
+  /// final preview = await WindowsPrinter.renderPreview(
+  ///   Uint8List.fromList(generator.getBytes()),
+  ///   paperSize: WPPaperSize.mm58,
+  /// );
+  /// final image = Image.memory(preview['png']);
+  /// ```
+  static Future<Map<String, dynamic>> renderPreview(
+    Uint8List data, {
+    WPPaperSize paperSize = WPPaperSize.mm80,
+  }) {
+    return WindowsPrinterPlatform.instance.renderPreview(data, paperWidth: paperSize.width);
+  }
+
+  /// Print [order] on every station printer at once
+  ///
+  /// Each item goes to the [stations] whose categories include its
+  /// category. Every station with items gets its own ESC/POS ticket, and
+  /// all tickets are encoded and submitted in parallel natively, so the
+  /// order takes as long as the slowest printer rather than the sum of all
+  /// of them. A printer that fails or misses [timeout] does not hold up
+  /// the others.
+  ///
+  /// Returns `tickets`, one per station with items: `station` (index into
+  /// [stations]), `printerName`, `items` (indices into the order's items),
+  /// `success`, `timedOut`, `jobId`, `errorCode` and `elapsedMs`. Printed
+  /// tickets appear on [jobEvents]. `unroutedItems` lists items no station
+  /// takes, and `elapsedMs` is the time until the last ticket was submitted.
+  ///
+  /// Example:
+  /// ```dart
+  /// final result = await WindowsPrinter.routeOrder(
+  ///   WPOrder(title: 'Order 42', details: ['Table 7'], items: [
+  ///     WPOrderItem(name: 'Burger', category: 'grill', notes: ['no onions']),
+  ///     WPOrderItem(name: 'IPA', category: 'drinks'),
+  ///   ]),
+  ///   [
+  ///     WPOrderStation(name: 'KITCHEN', printerName: 'Kitchen', categories: ['grill']),
+  ///     WPOrderStation(name: 'BAR', printerName: 'Bar', categories: ['drinks']),
+  ///   ],
+  /// );
+  /// ```
+  static Future<Map<String, dynamic>> routeOrder(
+    WPOrder order,
+    List<WPOrderStation> stations, {
+    Duration? timeout,
+    int maxConcurrency = 8,
+  }) {
+    return WindowsPrinterPlatform.instance.routeOrder(
+      order.toMap(),
+      [for (final station in stations) station.toMap()],
+      timeout: timeout,
+      maxConcurrency: maxConcurrency,
+    );
+  }
+
+  /// Encode [label] as ZPL or TSPL commands for a label printer
+  ///
+  /// Send the bytes with [printRawData]. Fields print their element's data.
+  ///
+  /// Example:
+  /// ```dart
+  /// final bytes = await WindowsPrinter.encodeLabel(
+  ///   WPLabel(widthMm: 50, heightMm: 30, elements: [
+  ///     WPLabelElement.text(20, 20, 'Blue Mug', height: 40),
+  ///     WPLabelElement.barcode(20, 80, '4006381333931', type: WPLabelBarcodeType.ean13),
+  ///   ]),
+  ///   language: WPLabelLanguage.zpl,
+  /// );
+  /// await WindowsPrinter.printRawData(printerName: 'Zebra ZD420', data: bytes);
+  /// ```
+  static Future<Uint8List> encodeLabel(
+    WPLabel label, {
+    required WPLabelLanguage language,
+    int copies = 1,
+  }) {
+    return WindowsPrinterPlatform.instance.encodeLabel(
+      language.name,
+      label.toMap(),
+      copies: copies,
+    );
+  }
+
+  /// Encode commands that store [label] on the printer as [name] without
+  /// printing it
+  ///
+  /// Send once (ZPL keeps it as `R:NAME.ZPL`, TSPL as the program
+  /// `NAME.BAS`); afterwards [encodeLabelRecall] prints it by sending only
+  /// the field values, which for a label with graphics is a small fraction
+  /// of the full label. [name] is 1 to 8 letters, digits or underscores.
+  static Future<Uint8List> encodeLabelFormat(
+    WPLabel label, {
+    required WPLabelLanguage language,
+    required String name,
+  }) {
+    return WindowsPrinterPlatform.instance.encodeLabel(
+      language.name,
+      label.toMap(),
+      mode: 'format',
+      name: name,
+    );
+  }
+
+  /// Encode commands that print the stored format [name] with [fields]
+  /// filled in, keyed by [WPLabelElement] field number
+  ///
+  /// [label] is the layout passed to [encodeLabelFormat]; its graphics are
+  /// not sent. Unknown field numbers are ignored.
+  ///
+  /// Example:
+  /// ```dart
+  /// await WindowsPrinter.printRawData(
+  ///   printerName: 'Zebra ZD420',
+  ///   data: await WindowsPrinter.encodeLabelRecall(
+  ///     label,
+  ///     language: WPLabelLanguage.zpl,
+  ///     name: 'SHELF',
+  ///     fields: {1: 'Blue Mug', 2: '4006381333931'},
+  ///   ),
+  /// );
+  /// ```
+  static Future<Uint8List> encodeLabelRecall(
+    WPLabel label, {
+    required WPLabelLanguage language,
+    required String name,
+    required Map<int, String> fields,
+    int copies = 1,
+  }) {
+    return WindowsPrinterPlatform.instance.encodeLabel(
+      language.name,
+      label.toMap(withGraphics: false),
+      mode: 'recall',
+      name: name,
+      fields: fields,
+      copies: copies,
     );
   }
 
@@ -0,0 +1,251 @@
+#include "batch_query.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace windows_printer {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<size_t> abandonedWorkers{0};
+std::atomic<size_t> abandonedWorkerLimit{kDefaultAbandonedWorkerLimit};
+
+enum class ItemPhase {
+  kPending = 0,
+  kRunning,
+  kCompleted,
+  kTimedOut,
+};
+
+struct BatchItem {
+  ItemPhase phase = ItemPhase::kPending;
+  Clock::time_point start;
+  std::chrono::nanoseconds elapsed{0};
+};
+
+struct BatchState {
+  std::function<void(size_t)> task;
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<BatchItem> items;
+  size_t next = 0;
+  size_t settled = 0;
+  // Workers still taking items; abandoned ones are not counted
+  size_t workers = 0;
+};
+
+void RunWorker(std::shared_ptr<BatchState> state) {
+  std::unique_lock<std::mutex> lock(state->mutex);
+  while (state->next < state->items.size()) {
+    const size_t index = state->next++;
+    BatchItem& item = state->items[index];
+    item.phase = ItemPhase::kRunning;
+    item.start = Clock::now();
+    // The coordinator arms a deadline for every running item
+    state->changed.notify_all();
+
+    lock.unlock();
+    state->task(index);
+    lock.lock();
+
+    if (item.phase != ItemPhase::kRunning) {
+      // Timed out while we were blocked; a replacement worker took our place
+      abandonedWorkers--;
+      return;
+    }
+    item.phase = ItemPhase::kCompleted;
+    item.elapsed = Clock::now() - item.start;
+    state->settled++;
+    state->changed.notify_all();
+  }
+  state->workers--;
+}
+
+// A RunWithDeadline call, settled by whichever of its worker and the
+// deadline thread gets there first
+struct DeadlineCall {
+  std::mutex mutex;
+  bool settled = false;
+  std::function<void(bool)> done;
+};
+
+void Settle(DeadlineCall& call, bool completed) {
+  std::function<void(bool)> done;
+  {
+    std::lock_guard<std::mutex> lock(call.mutex);
+    if (call.settled) {
+      // The worker of a call that already timed out has returned
+      if (completed) abandonedWorkers--;
+      return;
+    }
+    call.settled = true;
+    done = std::move(call.done);
+    if (!completed) abandonedWorkers++;
+  }
+  done(completed);
+}
+
+// Times out every RunWithDeadline call, so waiting for a deadline does not
+// cost a thread per call. Started on first use.
+class DeadlineThread {
+ public:
+  void Arm(Clock::time_point deadline, std::shared_ptr<DeadlineCall> call) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!started_) {
+      started_ = true;
+      std::thread([this]() { Run(); }).detach();
+    }
+    pending_.emplace(deadline, std::move(call));
+    changed_.notify_one();
+  }
+
+ private:
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      if (pending_.empty()) {
+        changed_.wait(lock);
+        continue;
+      }
+      auto next = pending_.begin();
+      if (Clock::now() < next->first) {
+        changed_.wait_until(lock, next->first);
+        continue;
+      }
+      std::shared_ptr<DeadlineCall> call = std::move(next->second);
+      pending_.erase(next);
+      lock.unlock();
+      Settle(*call, false);
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  // Calls that completed stay until their deadline, without their done
+  std::multimap<Clock::time_point, std::shared_ptr<DeadlineCall>> pending_;
+  bool started_ = false;
+};
+
+DeadlineThread& SharedDeadlineThread() {
+  // Never destroyed: its thread runs until the process exits
+  static DeadlineThread* deadlines = new DeadlineThread();
+  return *deadlines;
+}
+
+// Called with the state locked
+bool StartWorker(const std::shared_ptr<BatchState>& state) {
+  if (abandonedWorkers.load() >= abandonedWorkerLimit.load()) return false;
+  state->workers++;
+  std::thread(RunWorker, state).detach();
+  return true;
+}
+
+}  // namespace
+
+size_t AbandonedWorkerCount() {
+  return abandonedWorkers.load();
+}
+
+void SetAbandonedWorkerLimit(size_t limit) {
+  abandonedWorkerLimit = limit;
+}
+
+bool RunAbandoned(std::function<void()> task) {
+  // Counted first so that concurrent callers cannot all pass the check
+  if (abandonedWorkers.fetch_add(1) >= abandonedWorkerLimit.load()) {
+    abandonedWorkers--;
+    return false;
+  }
+  std::thread([task = std::move(task)]() {
+    task();
+    abandonedWorkers--;
+  }).detach();
+  return true;
+}
+
+void RunWithDeadline(std::function<void()> task, std::chrono::milliseconds timeout,
+                     std::function<void(bool completed)> done) {
+  if (abandonedWorkers.load() >= abandonedWorkerLimit.load()) {
+    done(false);
+    return;
+  }
+  auto call = std::make_shared<DeadlineCall>();
+  call->done = std::move(done);
+  SharedDeadlineThread().Arm(Clock::now() + timeout, call);
+  std::thread([call, task = std::move(task)]() {
+    task();
+    Settle(*call, true);
+  }).detach();
+}
+
+std::vector<BatchItemOutcome> RunBatch(size_t count, std::function<void(size_t index)> task,
+                                       const BatchOptions& options) {
+  std::vector<BatchItemOutcome> outcomes(count);
+  if (count == 0) return outcomes;
+
+  auto state = std::make_shared<BatchState>();
+  state->task = std::move(task);
+  state->items.resize(count);
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  const size_t workers = std::clamp<size_t>(options.maxConcurrency, 1, count);
+  for (size_t i = 0; i < workers; i++) {
+    if (!StartWorker(state)) break;
+  }
+
+  while (state->settled < count) {
+    const Clock::time_point now = Clock::now();
+    std::optional<Clock::time_point> nextDeadline;
+    for (BatchItem& item : state->items) {
+      if (item.phase != ItemPhase::kRunning) continue;
+
+      const Clock::time_point deadline = item.start + options.timeout;
+      if (now < deadline) {
+        nextDeadline = nextDeadline ? std::min(*nextDeadline, deadline) : deadline;
+        continue;
+      }
+
+      item.phase = ItemPhase::kTimedOut;
+      item.elapsed = options.timeout;
+      state->settled++;
+      state->workers--;
+      abandonedWorkers++;
+      if (state->next < count) {
+        StartWorker(state);
+      }
+    }
+
+    if (state->workers == 0) {
+      // Nothing is left to take the remaining items
+      for (; state->next < count; state->next++) {
+        state->items[state->next].phase = ItemPhase::kTimedOut;
+        state->settled++;
+      }
+    }
+
+    if (state->settled == count) break;
+    if (nextDeadline) {
+      state->changed.wait_until(lock, *nextDeadline);
+    } else {
+      state->changed.wait(lock);
+    }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    const BatchItem& item = state->items[i];
+    outcomes[i].status = item.phase == ItemPhase::kCompleted ? BatchItemStatus::kCompleted
+                                                             : BatchItemStatus::kTimedOut;
+    outcomes[i].elapsed = item.elapsed;
+  }
+  return outcomes;
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,149 @@
+#ifndef FLUTTER_PLUGIN_BATCH_QUERY_H_
+#define FLUTTER_PLUGIN_BATCH_QUERY_H_
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace windows_printer {
+
+struct BatchOptions {
+  /// Most items running at once, not counting calls abandoned after their
+  /// deadline
+  size_t maxConcurrency = 8;
+  /// Deadline for each item, measured from when a worker picks it up
+  std::chrono::milliseconds timeout{5000};
+};
+
+enum class BatchItemStatus {
+  kCompleted = 0,
+  kTimedOut,
+};
+
+struct BatchItemOutcome {
+  BatchItemStatus status = BatchItemStatus::kCompleted;
+  /// Time the item ran for, the timeout if it did not finish, or zero if it
+  /// never started because too many abandoned calls were still running
+  std::chrono::nanoseconds elapsed{0};
+};
+
+/// Abandoned calls that may hold a thread at once, over the whole process
+constexpr size_t kDefaultAbandonedWorkerLimit = 32;
+
+/// Calls that passed their deadline and have not returned yet
+size_t AbandonedWorkerCount();
+
+/// While this many calls are abandoned, no new worker is started
+void SetAbandonedWorkerLimit(size_t limit);
+
+// Runs task(0) .. task(count - 1) on a bounded set of worker threads and
+// returns once every item has finished or passed its deadline. Blocking
+// spooler calls cannot be interrupted, so a worker stuck past its deadline is
+// abandoned: it is replaced by a fresh worker, keeps running in the
+// background and exits when its call finally returns. task is kept alive
+// until then, so it must not capture anything owned by the caller's stack.
+//
+// A spooler that stops answering would otherwise cost a thread per call, so
+// no worker is started while the abandoned worker limit is reached. Items
+// left without a worker time out at once.
+std::vector<BatchItemOutcome> RunBatch(size_t count, std::function<void(size_t index)> task,
+                                       const BatchOptions& options);
+
+/// Run task on a detached thread that counts as abandoned until it returns,
+/// for work nobody waits for. Returns false without running it if the
+/// abandoned worker limit is reached.
+bool RunAbandoned(std::function<void()> task);
+
+template <typename Result>
+struct BatchQueryResult {
+  std::string name;
+  BatchItemStatus status = BatchItemStatus::kCompleted;
+  std::chrono::nanoseconds elapsed{0};
+  /// Default constructed when the query timed out
+  Result value{};
+};
+
+/// Call query(name) for every name through RunBatch. Results come back in the
+/// order of names.
+template <typename Result>
+std::vector<BatchQueryResult<Result>> QueryBatch(
+    const std::vector<std::string>& names,
+    std::function<Result(const std::string& name)> query,
+    const BatchOptions& options) {
+  // Workers write different elements concurrently, which std::vector<bool> cannot do
+  static_assert(!std::is_same<Result, bool>::value, "use a wider type than bool");
+
+  // Shared with the workers so a query that outlives its deadline still has
+  // somewhere to write after this function returns
+  auto sharedNames = std::make_shared<const std::vector<std::string>>(names);
+  auto values = std::make_shared<std::vector<Result>>(names.size());
+  std::vector<BatchItemOutcome> outcomes = RunBatch(
+      names.size(),
+      [sharedNames, values, query = std::move(query)](size_t index) {
+        (*values)[index] = query((*sharedNames)[index]);
+      },
+      options);
+
+  std::vector<BatchQueryResult<Result>> results(names.size());
+  for (size_t i = 0; i < names.size(); i++) {
+    results[i].name = names[i];
+    results[i].status = outcomes[i].status;
+    results[i].elapsed = outcomes[i].elapsed;
+    // Only completed slots are read: an abandoned worker may still write its own
+    if (outcomes[i].status == BatchItemStatus::kCompleted) {
+      results[i].value = std::move((*values)[i]);
+    }
+  }
+  return results;
+}
+
+/// Run call on a worker thread and wait at most timeout for it. Returns
+/// std::nullopt if the deadline passed; the call is then abandoned as in
+/// RunBatch, so it must own everything it touches. Also std::nullopt, at
+/// once and without calling it, if the abandoned worker limit is reached.
+template <typename Result>
+std::optional<Result> CallWithDeadline(std::function<Result()> call,
+                                       std::chrono::milliseconds timeout) {
+  auto value = std::make_shared<std::optional<Result>>();
+  BatchOptions options;
+  options.maxConcurrency = 1;
+  options.timeout = timeout;
+  std::vector<BatchItemOutcome> outcomes = RunBatch(
+      1, [value, call = std::move(call)](size_t) { value->emplace(call()); }, options);
+  if (outcomes[0].status != BatchItemStatus::kCompleted) {
+    return std::nullopt;
+  }
+  return std::move(*value);
+}
+
+/// Run task on a worker thread without waiting for it. done(true) follows on
+/// that thread once task returns, or done(false) on a thread shared by every
+/// call once timeout has passed; only the first of the two is called, so
+/// done must not block. Past its deadline the call is abandoned as in
+/// RunBatch. done(false) is called at once, without running task, if the
+/// abandoned worker limit is reached.
+void RunWithDeadline(std::function<void()> task, std::chrono::milliseconds timeout,
+                     std::function<void(bool completed)> done);
+
+/// CallWithDeadline that hands the result to done instead of waiting for it,
+/// so a call holds one thread rather than two
+template <typename Result>
+void CallWithDeadlineAsync(std::function<Result()> call, std::chrono::milliseconds timeout,
+                           std::function<void(std::optional<Result> result)> done) {
+  auto value = std::make_shared<std::optional<Result>>();
+  RunWithDeadline(
+      [value, call = std::move(call)]() { value->emplace(call()); }, timeout,
+      [value, done = std::move(done)](bool completed) {
+        done(completed ? std::move(*value) : std::optional<Result>());
+      });
+}
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_BATCH_QUERY_H_
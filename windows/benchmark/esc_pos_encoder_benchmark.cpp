@@ -0,0 +1,61 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+
+namespace windows_printer {
+namespace {
+
+// A typical restaurant receipt: header, a dozen items, totals, barcode and QR
+void BM_EscPosReceipt(benchmark::State& state) {
+  EscPosTextStyle header;
+  header.bold = true;
+  header.align = EscPosTextAlign::kCenter;
+  header.size = EscPosTextSize::kDoubleHeightWidth;
+  size_t bytes = 0;
+
+  for (auto _ : state) {
+    EscPosEncoder encoder;
+    encoder.Text("THE CORNER CAFE", header);
+    encoder.Text("12 Main Street");
+    encoder.Separator();
+    for (int i = 0; i < 12; i++) {
+      encoder.Text("1 x Flat white                 4.50");
+    }
+    encoder.Separator();
+    encoder.Text("TOTAL                         54.00", header);
+    encoder.Barcode(EscPosBarcodeType::kCode128, "ORDER-000123");
+    encoder.QrCode("https://example.com/receipt/000123");
+    encoder.Feed(3);
+    encoder.Cut();
+    bytes = encoder.Bytes().size();
+    benchmark::DoNotOptimize(encoder.Bytes().data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+BENCHMARK(BM_EscPosReceipt);
+
+// Rasterizing an RGBA logo into ESC * 24-dot bands at 58mm and 80mm widths
+void BM_EscPosImage(benchmark::State& state) {
+  const int width = static_cast<int>(state.range(0));
+  const int height = static_cast<int>(state.range(1));
+  std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+  for (size_t i = 0; i < rgba.size(); i++) {
+    rgba[i] = static_cast<uint8_t>((i * 2654435761u) >> 24);
+  }
+
+  for (auto _ : state) {
+    EscPosEncoder encoder;
+    encoder.Image(rgba.data(), rgba.size(), width, height);
+    benchmark::DoNotOptimize(encoder.Bytes().data());
+  }
+  state.SetItemsProcessed(state.iterations() * width * height);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * rgba.size()));
+}
+BENCHMARK(BM_EscPosImage)->Args({384, 200})->Args({576, 300})->Args({576, 1200});
+
+}  // namespace
+}  // namespace windows_printer
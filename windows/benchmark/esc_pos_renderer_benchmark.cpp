@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+#include "esc_pos_renderer.h"
+
+namespace windows_printer {
+namespace {
+
+std::vector<uint8_t> Receipt(int items) {
+  EscPosTextStyle header;
+  header.bold = true;
+  header.align = EscPosTextAlign::kCenter;
+  header.size = EscPosTextSize::kDoubleHeightWidth;
+
+  EscPosEncoder encoder;
+  encoder.Text("THE CORNER CAFE", header);
+  encoder.Text("12 Main Street");
+  encoder.Separator();
+  for (int i = 0; i < items; i++) {
+    encoder.Text("1 x Flat white                 4.50");
+  }
+  encoder.Separator();
+  encoder.Text("TOTAL                         54.00", header);
+  encoder.Barcode(EscPosBarcodeType::kCode128, "ORDER-000123");
+  encoder.QrCode("https://example.com/receipt/000123");
+  encoder.Feed(3);
+  encoder.Cut();
+  return encoder.Bytes();
+}
+
+// Interpreting a receipt into a bitmap, the work behind each preview
+void BM_EscPosRender(benchmark::State& state) {
+  const std::vector<uint8_t> bytes = Receipt(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    EscPosPreview preview = RenderEscPos(bytes.data(), bytes.size());
+    benchmark::DoNotOptimize(preview.bitmap.Row(0));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes.size()));
+}
+BENCHMARK(BM_EscPosRender)->Arg(12)->Arg(200);
+
+// Rendering plus PNG encoding, as returned to Dart
+void BM_EscPosPreviewPng(benchmark::State& state) {
+  const std::vector<uint8_t> bytes = Receipt(12);
+  size_t pngBytes = 0;
+  for (auto _ : state) {
+    std::vector<uint8_t> png = RenderEscPos(bytes.data(), bytes.size()).bitmap.EncodePng();
+    pngBytes = png.size();
+    benchmark::DoNotOptimize(png.data());
+  }
+  state.counters["png_bytes"] = static_cast<double>(pngBytes);
+}
+BENCHMARK(BM_EscPosPreviewPng);
+
+}  // namespace
+}  // namespace windows_printer
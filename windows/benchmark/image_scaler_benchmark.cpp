@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "image_scaler.h"
+
+namespace windows_printer {
+namespace {
+
+// A photo or logo as decoded, then fit to A4 at 600 dpi (4760 x 6779
+// printable) or to an 80 mm label at 203 dpi
+constexpr int kImageWidth = 1200;
+constexpr int kImageHeight = 1600;
+constexpr size_t kBandBytes = 2 << 20;
+
+std::vector<uint8_t> MakeImage() {
+  std::vector<uint8_t> rgba(static_cast<size_t>(kImageWidth) * kImageHeight * 4);
+  for (size_t i = 0; i < rgba.size(); i++) {
+    rgba[i] = static_cast<uint8_t>(i * 31 + (i >> 12));
+  }
+  return rgba;
+}
+
+// Straightforward per-pixel bilinear in floating point into one bitmap of
+// the whole target, kept as the baseline for the banded fixed-point scaler
+void BaselineScale(const std::vector<uint8_t>& rgba, int targetWidth, int targetHeight,
+                   std::vector<uint8_t>* out) {
+  out->resize(static_cast<size_t>(targetWidth) * targetHeight * 4);
+  const float scaleX = static_cast<float>(kImageWidth) / targetWidth;
+  const float scaleY = static_cast<float>(kImageHeight) / targetHeight;
+  for (int y = 0; y < targetHeight; y++) {
+    const float sy = std::max(0.0f, (y + 0.5f) * scaleY - 0.5f);
+    const int y0 = std::min(static_cast<int>(sy), kImageHeight - 1);
+    const int y1 = std::min(y0 + 1, kImageHeight - 1);
+    const float wy = sy - y0;
+    for (int x = 0; x < targetWidth; x++) {
+      const float sx = std::max(0.0f, (x + 0.5f) * scaleX - 0.5f);
+      const int x0 = std::min(static_cast<int>(sx), kImageWidth - 1);
+      const int x1 = std::min(x0 + 1, kImageWidth - 1);
+      const float wx = sx - x0;
+      for (int c = 0; c < 3; c++) {
+        auto at = [&](int px, int py) {
+          const uint8_t* pixel = &rgba[(static_cast<size_t>(py) * kImageWidth + px) * 4];
+          return pixel[c] * pixel[3] / 255.0f + 255 - pixel[3];
+        };
+        const float top = at(x0, y0) * (1 - wx) + at(x1, y0) * wx;
+        const float bottom = at(x0, y1) * (1 - wx) + at(x1, y1) * wx;
+        (*out)[(static_cast<size_t>(y) * targetWidth + x) * 4 + 2 - c] =
+            static_cast<uint8_t>(top * (1 - wy) + bottom * wy + 0.5f);
+      }
+    }
+  }
+}
+
+void BM_ImageScaleBanded(benchmark::State& state) {
+  const std::vector<uint8_t> rgba = MakeImage();
+  const ImageRect rect = FitImage(kImageWidth, kImageHeight, static_cast<int>(state.range(0)),
+                                  static_cast<int>(state.range(1)));
+  for (auto _ : state) {
+    ImageScaler scaler(rgba.data(), kImageWidth, kImageHeight, rect.width, rect.height);
+    ForEachImageBand(scaler, kBandBytes, [](const ImageBand& band) {
+      benchmark::DoNotOptimize(band.bgrx);
+      return true;
+    });
+  }
+  state.SetItemsProcessed(state.iterations() * rect.width * rect.height);
+}
+BENCHMARK(BM_ImageScaleBanded)->Args({4760, 6779})->Args({640, 1200})->Unit(benchmark::kMillisecond);
+
+void BM_ImageScaleBaseline(benchmark::State& state) {
+  const std::vector<uint8_t> rgba = MakeImage();
+  const ImageRect rect = FitImage(kImageWidth, kImageHeight, static_cast<int>(state.range(0)),
+                                  static_cast<int>(state.range(1)));
+  std::vector<uint8_t> out;
+  for (auto _ : state) {
+    BaselineScale(rgba, rect.width, rect.height, &out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * rect.width * rect.height);
+}
+BENCHMARK(BM_ImageScaleBaseline)->Args({4760, 6779})->Args({640, 1200})->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace windows_printer
@@ -0,0 +1,47 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "in_memory_spooler.h"
+#include "print_job.h"
+
+namespace windows_printer {
+namespace {
+
+// End-to-end raw submission, including metrics and queue accounting, against
+// an in-memory spooler. Measures the plugin's own overhead per job.
+void BM_SubmitRawJob(benchmark::State& state) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+  spooler->SetDiscardData(true);
+  std::vector<uint8_t> data(static_cast<size_t>(state.range(0)), 0x41);
+
+  for (auto _ : state) {
+    RawPrintResult result = SubmitRawJob(spooler, "Receipt", data.data(), data.size());
+    benchmark::DoNotOptimize(result.success);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+BENCHMARK(BM_SubmitRawJob)->Arg(512)->Arg(64 << 10)->ThreadRange(1, 8)->UseRealTime();
+
+// Deduplication key of a job, up to a 4 MB raster image; compare with
+// BM_SubmitRawJob at the same size
+void BM_RawJobContentKey(benchmark::State& state) {
+  std::vector<uint8_t> data(static_cast<size_t>(state.range(0)));
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>(i * 131);
+  }
+  RawPrintOptions options;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(RawJobContentKey(data.data(), data.size(), options));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+BENCHMARK(BM_RawJobContentKey)->Arg(512)->Arg(64 << 10)->Arg(4 << 20);
+
+}  // namespace
+}  // namespace windows_printer
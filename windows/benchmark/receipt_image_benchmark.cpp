@@ -0,0 +1,122 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+#include "image_decoder.h"
+#include "receipt_image.h"
+#include "test/test_images.h"
+
+namespace windows_printer {
+namespace {
+
+// A phone photo of a menu item or a large logo, printed 576 dots across
+constexpr int kPhotoWidth = 2400;
+constexpr int kPhotoHeight = 1600;
+constexpr int kPaperWidth = 576;
+
+const std::vector<uint8_t>& Encoded(bool jpeg) {
+  static const std::vector<uint8_t> rgba = test::TestPhoto(kPhotoWidth, kPhotoHeight);
+  static const std::vector<uint8_t> png =
+      test::EncodeTestPng(rgba.data(), kPhotoWidth, kPhotoHeight);
+  static const std::vector<uint8_t> photo =
+      test::EncodeTestJpeg(rgba.data(), kPhotoWidth, kPhotoHeight, 85);
+  return jpeg ? photo : png;
+}
+
+// Collects the whole image as RGBA, as a general purpose decoder hands it
+// over
+class RgbaImage : public GrayRowSink {
+public:
+  bool Begin(int width, int height) override {
+    width_ = width;
+    height_ = height;
+    rgba_.assign(static_cast<size_t>(width) * height * 4, 255);
+    return true;
+  }
+
+  void Row(int y, const uint8_t* gray) override {
+    uint8_t* pixel = &rgba_[static_cast<size_t>(y) * width_ * 4];
+    for (int x = 0; x < width_; x++, pixel += 4) {
+      pixel[0] = pixel[1] = pixel[2] = gray[x];
+    }
+  }
+
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<uint8_t> rgba_;
+};
+
+// The path images take in the Dart receipt builder: decode everything to
+// RGBA, resize it in floating point, then threshold every pixel in
+// EscPosEncoder::Image. Decoding reuses the native decoder, so this only
+// counts the cost of the full-size intermediate images.
+void BaselineEncode(const std::vector<uint8_t>& data, EscPosEncoder* encoder) {
+  RgbaImage image;
+  std::string error;
+  DecodeGrayImage(data.data(), data.size(), image, &error);
+  const int targetWidth = kPaperWidth;
+  const int targetHeight = image.height_ * targetWidth / image.width_;
+  std::vector<uint8_t> resized(static_cast<size_t>(targetWidth) * targetHeight * 4);
+  const float scaleX = static_cast<float>(image.width_) / targetWidth;
+  const float scaleY = static_cast<float>(image.height_) / targetHeight;
+  for (int y = 0; y < targetHeight; y++) {
+    const float sy = std::max(0.0f, (y + 0.5f) * scaleY - 0.5f);
+    const int y0 = std::min(static_cast<int>(sy), image.height_ - 1);
+    const int y1 = std::min(y0 + 1, image.height_ - 1);
+    const float wy = sy - y0;
+    for (int x = 0; x < targetWidth; x++) {
+      const float sx = std::max(0.0f, (x + 0.5f) * scaleX - 0.5f);
+      const int x0 = std::min(static_cast<int>(sx), image.width_ - 1);
+      const int x1 = std::min(x0 + 1, image.width_ - 1);
+      const float wx = sx - x0;
+      for (int c = 0; c < 4; c++) {
+        auto at = [&](int px, int py) {
+          const size_t index = (static_cast<size_t>(py) * image.width_ + px) * 4 + c;
+          return static_cast<float>(image.rgba_[index]);
+        };
+        const float top = at(x0, y0) * (1 - wx) + at(x1, y0) * wx;
+        const float bottom = at(x0, y1) * (1 - wx) + at(x1, y1) * wx;
+        resized[(static_cast<size_t>(y) * targetWidth + x) * 4 + c] =
+            static_cast<uint8_t>(top * (1 - wy) + bottom * wy + 0.5f);
+      }
+    }
+  }
+  encoder->Image(resized.data(), resized.size(), targetWidth, targetHeight);
+}
+
+void BM_ReceiptImageFused(benchmark::State& state) {
+  const std::vector<uint8_t>& data = Encoded(state.range(0) != 0);
+  ReceiptImageOptions options;
+  options.width = kPaperWidth;
+  options.dither = state.range(1) != 0;
+  for (auto _ : state) {
+    MonoBitmap bitmap;
+    RasterizeReceiptImage(data.data(), data.size(), options, &bitmap, nullptr);
+    EscPosEncoder encoder;
+    encoder.Bitmap(bitmap);
+    benchmark::DoNotOptimize(encoder.Bytes().data());
+  }
+  state.SetItemsProcessed(state.iterations() * kPhotoWidth * kPhotoHeight);
+}
+BENCHMARK(BM_ReceiptImageFused)
+    ->ArgsProduct({{0, 1}, {0, 1}})
+    ->ArgNames({"jpeg", "dither"})
+    ->Unit(benchmark::kMillisecond);
+
+void BM_ReceiptImageBaseline(benchmark::State& state) {
+  const std::vector<uint8_t>& data = Encoded(state.range(0) != 0);
+  for (auto _ : state) {
+    EscPosEncoder encoder;
+    BaselineEncode(data, &encoder);
+    benchmark::DoNotOptimize(encoder.Bytes().data());
+  }
+  state.SetItemsProcessed(state.iterations() * kPhotoWidth * kPhotoHeight);
+}
+BENCHMARK(BM_ReceiptImageBaseline)->Arg(0)->Arg(1)->ArgName("jpeg")->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace windows_printer
@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+#include "rich_text.h"
+
+namespace windows_printer {
+namespace {
+
+std::string MakeDocument(int lines) {
+  std::string document;
+  for (int i = 0; i < lines; i++) {
+    switch (i % 4) {
+      case 0:
+        document += "##Order 1042##\n";
+        break;
+      case 1:
+        document += "**2 x** Margherita pizza *extra basil*        24.00\n";
+        break;
+      case 2:
+        document += "Plain item line without any markup at all      3.50\n";
+        break;
+      default:
+        document += "***Note:*** deliver to the **back door**\n";
+        break;
+    }
+  }
+  return document;
+}
+
+void BM_RichTextParseLine(benchmark::State& state) {
+  const std::string line = "**2 x** Margherita pizza *extra basil* ##24.00##";
+  for (auto _ : state) {
+    RichTextLine parsed = ParseRichTextLine(line, 20);
+    benchmark::DoNotOptimize(parsed.runs.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * line.size()));
+}
+BENCHMARK(BM_RichTextParseLine);
+
+void BM_RichTextLayout(benchmark::State& state) {
+  const std::string document = MakeDocument(static_cast<int>(state.range(0)));
+  // Stands in for GetTextExtentPoint32 with a fixed-pitch font
+  RichTextMeasure measure = [](RichTextFont font, std::string_view text) {
+    return static_cast<int>(text.size()) * (font == RichTextFont::kLarge ? 14 : 10);
+  };
+
+  for (auto _ : state) {
+    std::vector<PositionedRichTextRun> runs = LayoutRichText(document, 50, 50, 20, measure);
+    benchmark::DoNotOptimize(runs.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * document.size()));
+}
+BENCHMARK(BM_RichTextLayout)->Arg(40)->Arg(1000);
+
+// The ESC/POS path: no fonts to create and nothing to measure or rasterize
+void BM_RichTextEscPos(benchmark::State& state) {
+  const std::string document = MakeDocument(static_cast<int>(state.range(0)));
+  EscPosEncoder encoder;
+  for (auto _ : state) {
+    encoder.Clear();
+    EncodeRichTextEscPos(document, &encoder);
+    benchmark::DoNotOptimize(encoder.Bytes().data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * document.size()));
+}
+BENCHMARK(BM_RichTextEscPos)->Arg(40)->Arg(1000);
+
+}  // namespace
+}  // namespace windows_printer
@@ -0,0 +1,47 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "spsc_ring.h"
+
+namespace windows_printer {
+namespace {
+
+// Streaming 4 MB of label data through a ring of the given size, with the
+// producer on its own thread writing 512-byte labels and the benchmark
+// thread draining it as the printer writer would
+void BM_SpscRingThroughput(benchmark::State& state) {
+  constexpr uint64_t kTotal = 4 << 20;
+  const size_t capacity = static_cast<size_t>(state.range(0));
+  std::vector<uint8_t> label(512, 0x1B);
+  std::vector<uint8_t> out(64 << 10);
+
+  for (auto _ : state) {
+    SpscRing ring(capacity);
+    std::thread producer([&ring, &label]() {
+      uint64_t position = 0;
+      while (position < kTotal) {
+        size_t size = std::min<uint64_t>(label.size(), kTotal - position);
+        size_t written = ring.Write(label.data(), size);
+        if (written == 0) std::this_thread::yield();
+        position += written;
+      }
+    });
+    uint64_t position = 0;
+    while (position < kTotal) {
+      size_t read = ring.Read(out.data(), out.size());
+      if (read == 0) std::this_thread::yield();
+      position += read;
+    }
+    producer.join();
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * kTotal));
+}
+BENCHMARK(BM_SpscRingThroughput)->Arg(4 << 10)->Arg(64 << 10)->Arg(1 << 20)->UseRealTime();
+
+}  // namespace
+}  // namespace windows_printer
@@ -0,0 +1,140 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+
+#include "string_convert.h"
+#include "string_intern.h"
+
+namespace windows_printer {
+namespace {
+
+// Printer names, ports and receipt lines are nearly always ASCII
+const char kAsciiText[] = "EPSON TM-T88VI Receipt on \\\\print-server\\kitchen-01";
+// Mixed Latin, CJK and an emoji
+const char kMixedText[] =
+    "Caf\xC3\xA9 \xE5\x8E\xA8\xE6\x88\xBF\xE6\x89\x93\xE5\x8D\xB0\xE6\x9C\xBA "
+    "\xF0\x9F\x96\xA8 Stra\xC3\x9F" "e";
+
+std::string Repeat(const char* text, int64_t count) {
+  std::string result;
+  for (int64_t i = 0; i < count; i++) {
+    result += text;
+  }
+  return result;
+}
+
+// The previous converter, which validated and appended one code point at a
+// time, kept as the baseline for the ASCII fast path
+char32_t BaselineDecode(const std::string& utf8, size_t* pos) {
+  const uint8_t lead = static_cast<uint8_t>(utf8[(*pos)++]);
+  if (lead < 0x80) return lead;
+
+  int length;
+  char32_t codePoint;
+  char32_t minimum;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    length = 2;
+    codePoint = lead & 0x1F;
+    minimum = 0x80;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    length = 3;
+    codePoint = lead & 0x0F;
+    minimum = 0x800;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    length = 4;
+    codePoint = lead & 0x07;
+    minimum = 0x10000;
+  } else {
+    return 0xFFFD;
+  }
+  for (int i = 1; i < length; i++) {
+    if (*pos >= utf8.size() || (static_cast<uint8_t>(utf8[*pos]) & 0xC0) != 0x80) return 0xFFFD;
+    codePoint = (codePoint << 6) | (static_cast<uint8_t>(utf8[(*pos)++]) & 0x3F);
+  }
+  if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+    return 0xFFFD;
+  }
+  return codePoint;
+}
+
+std::u16string BaselineUtf8ToUtf16(const std::string& utf8) {
+  std::u16string utf16;
+  utf16.reserve(utf8.size());
+  size_t pos = 0;
+  while (pos < utf8.size()) {
+    char32_t codePoint = BaselineDecode(utf8, &pos);
+    if (codePoint < 0x10000) {
+      utf16 += static_cast<char16_t>(codePoint);
+    } else {
+      codePoint -= 0x10000;
+      utf16 += static_cast<char16_t>(0xD800 + (codePoint >> 10));
+      utf16 += static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+    }
+  }
+  return utf16;
+}
+
+void BM_BaselineUtf8ToUtf16(benchmark::State& state, const char* text) {
+  const std::string utf8 = Repeat(text, state.range(0));
+  for (auto _ : state) {
+    std::u16string utf16 = BaselineUtf8ToUtf16(utf8);
+    benchmark::DoNotOptimize(utf16.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * utf8.size()));
+}
+BENCHMARK_CAPTURE(BM_BaselineUtf8ToUtf16, ascii, kAsciiText)->Arg(1)->Arg(64);
+BENCHMARK_CAPTURE(BM_BaselineUtf8ToUtf16, mixed, kMixedText)->Arg(1)->Arg(64);
+
+void BM_Utf8ToUtf16(benchmark::State& state, const char* text) {
+  const std::string utf8 = Repeat(text, state.range(0));
+  for (auto _ : state) {
+    std::u16string utf16 = Utf8ToUtf16<char16_t>(utf8);
+    benchmark::DoNotOptimize(utf16.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * utf8.size()));
+}
+BENCHMARK_CAPTURE(BM_Utf8ToUtf16, ascii, kAsciiText)->Arg(1)->Arg(64);
+BENCHMARK_CAPTURE(BM_Utf8ToUtf16, mixed, kMixedText)->Arg(1)->Arg(64);
+
+void BM_Utf16ToUtf8(benchmark::State& state, const char* text) {
+  const std::u16string utf16 = Utf8ToUtf16<char16_t>(Repeat(text, state.range(0)));
+  for (auto _ : state) {
+    std::string utf8 = Utf16ToUtf8<char16_t>(utf16);
+    benchmark::DoNotOptimize(utf8.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * utf16.size() * 2));
+}
+BENCHMARK_CAPTURE(BM_Utf16ToUtf8, ascii, kAsciiText)->Arg(1)->Arg(64);
+BENCHMARK_CAPTURE(BM_Utf16ToUtf8, mixed, kMixedText)->Arg(1)->Arg(64);
+
+// Converting into a reused buffer, as for each text run of a document
+void BM_Utf8ToUtf16Buffer(benchmark::State& state, const char* text) {
+  const std::string utf8 = Repeat(text, state.range(0));
+  std::u16string buffer(MaxUtf16Length(utf8.size()), u'\0');
+  for (auto _ : state) {
+    size_t units = Utf8ToUtf16(utf8, &buffer[0]);
+    benchmark::DoNotOptimize(units);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * utf8.size()));
+}
+BENCHMARK_CAPTURE(BM_Utf8ToUtf16Buffer, ascii, kAsciiText)->Arg(1)->Arg(64);
+BENCHMARK_CAPTURE(BM_Utf8ToUtf16Buffer, mixed, kMixedText)->Arg(1)->Arg(64);
+
+// A printer name looked up in the intern table instead of converted
+void BM_InternPrinterName(benchmark::State& state) {
+  Utf16InternTable<char16_t> table;
+  for (int i = 0; i < 32; i++) {
+    table.Intern("Printer " + std::to_string(i));
+  }
+  const std::string name(kAsciiText);
+  for (auto _ : state) {
+    std::shared_ptr<const std::u16string> wide = table.Intern(name);
+    benchmark::DoNotOptimize(wide.get());
+  }
+}
+BENCHMARK(BM_InternPrinterName);
+
+}  // namespace
+}  // namespace windows_printer
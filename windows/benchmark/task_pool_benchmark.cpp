@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+#include "image_scaler.h"
+#include "receipt_image.h"
+#include "task_pool.h"
+#include "test/test_images.h"
+
+namespace windows_printer {
+namespace {
+
+// A receipt with a logo and a few item photos, each printed 576 dots across
+constexpr int kReceiptImages = 8;
+constexpr int kPhotoWidth = 1600;
+constexpr int kPhotoHeight = 1200;
+
+const std::vector<std::vector<uint8_t>>& ReceiptImages() {
+  static const std::vector<std::vector<uint8_t>> images = [] {
+    const std::vector<uint8_t> rgba = test::TestPhoto(kPhotoWidth, kPhotoHeight);
+    std::vector<std::vector<uint8_t>> encoded;
+    for (int i = 0; i < kReceiptImages; i++) {
+      encoded.push_back(i % 2 == 0
+                            ? test::EncodeTestJpeg(rgba.data(), kPhotoWidth, kPhotoHeight, 85)
+                            : test::EncodeTestPng(rgba.data(), kPhotoWidth, kPhotoHeight));
+    }
+    return encoded;
+  }();
+  return images;
+}
+
+// Decode, rasterize and encode every image of a receipt, one task each.
+// Argument: pool threads. Scales with cores until each has an image.
+void BM_ReceiptImagesParallel(benchmark::State& state) {
+  const std::vector<std::vector<uint8_t>>& images = ReceiptImages();
+  TaskPool pool(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    std::vector<std::vector<uint8_t>> outputs(images.size());
+    ParallelFor(pool, images.size(), 1, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        MonoBitmap bitmap;
+        RasterizeReceiptImage(images[i].data(), images[i].size(), ReceiptImageOptions(), &bitmap,
+                              nullptr);
+        EscPosEncoder encoder;
+        encoder.Bitmap(bitmap);
+        outputs[i] = encoder.Bytes();
+      }
+    });
+    benchmark::DoNotOptimize(outputs.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kReceiptImages);
+}
+BENCHMARK(BM_ReceiptImagesParallel)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->ArgName("threads")
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// One large image through the driver path, each band's rows split across
+// the pool. Argument: pool threads.
+void BM_ImageBandsParallel(benchmark::State& state) {
+  const std::vector<uint8_t> rgba = test::TestPhoto(kPhotoWidth, kPhotoHeight);
+  const ImageRect rect = FitImage(kPhotoWidth, kPhotoHeight, 4760, 6779);
+  TaskPool pool(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    ImageScaler scaler(rgba.data(), kPhotoWidth, kPhotoHeight, rect.width, rect.height);
+    ForEachImageBand(scaler, 2 << 20, pool, [](const ImageBand& band) {
+      benchmark::DoNotOptimize(band.bgrx);
+      return true;
+    });
+  }
+  state.SetItemsProcessed(state.iterations() * rect.width * rect.height);
+}
+BENCHMARK(BM_ImageBandsParallel)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->ArgName("threads")
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Cost of the pool itself: many tiny tasks. Argument: pool threads.
+void BM_TaskPoolOverhead(benchmark::State& state) {
+  TaskPool pool(static_cast<size_t>(state.range(0)));
+  constexpr size_t kTasks = 4096;
+  for (auto _ : state) {
+    ParallelFor(pool, kTasks, 1, [](size_t begin, size_t) { benchmark::DoNotOptimize(begin); });
+  }
+  state.SetItemsProcessed(state.iterations() * kTasks);
+}
+BENCHMARK(BM_TaskPoolOverhead)->Arg(1)->Arg(4)->ArgName("threads")->UseRealTime();
+
+}  // namespace
+}  // namespace windows_printer
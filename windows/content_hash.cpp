@@ -0,0 +1,153 @@
+#include "content_hash.h"
+
+#include <cstring>
+
+namespace windows_printer {
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+constexpr size_t kStripeSize = 32;
+
+uint64_t RotateLeft(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+// Little-endian loads; every target of the plugin is little-endian
+uint64_t Read64(const uint8_t* data) {
+  uint64_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint32_t Read32(const uint8_t* data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint64_t Round(uint64_t lane, uint64_t input) {
+  lane += input * kPrime2;
+  lane = RotateLeft(lane, 31);
+  return lane * kPrime1;
+}
+
+uint64_t MergeLane(uint64_t hash, uint64_t lane) {
+  hash ^= Round(0, lane);
+  return hash * kPrime1 + kPrime4;
+}
+
+void InitLanes(uint64_t seed, uint64_t* lanes) {
+  lanes[0] = seed + kPrime1 + kPrime2;
+  lanes[1] = seed + kPrime2;
+  lanes[2] = seed;
+  lanes[3] = seed - kPrime1;
+}
+
+// Consumes whole stripes and returns the number of bytes consumed
+size_t ConsumeStripes(const uint8_t* data, size_t size, uint64_t* lanes) {
+  uint64_t lane0 = lanes[0];
+  uint64_t lane1 = lanes[1];
+  uint64_t lane2 = lanes[2];
+  uint64_t lane3 = lanes[3];
+  size_t pos = 0;
+  for (; pos + kStripeSize <= size; pos += kStripeSize) {
+    lane0 = Round(lane0, Read64(data + pos));
+    lane1 = Round(lane1, Read64(data + pos + 8));
+    lane2 = Round(lane2, Read64(data + pos + 16));
+    lane3 = Round(lane3, Read64(data + pos + 24));
+  }
+  lanes[0] = lane0;
+  lanes[1] = lane1;
+  lanes[2] = lane2;
+  lanes[3] = lane3;
+  return pos;
+}
+
+// Mixes the fewer than 32 trailing bytes into hash and finalizes it
+uint64_t Finish(uint64_t hash, const uint8_t* tail, size_t size) {
+  size_t pos = 0;
+  for (; pos + 8 <= size; pos += 8) {
+    hash ^= Round(0, Read64(tail + pos));
+    hash = RotateLeft(hash, 27) * kPrime1 + kPrime4;
+  }
+  if (pos + 4 <= size) {
+    hash ^= static_cast<uint64_t>(Read32(tail + pos)) * kPrime1;
+    hash = RotateLeft(hash, 23) * kPrime2 + kPrime3;
+    pos += 4;
+  }
+  for (; pos < size; pos++) {
+    hash ^= tail[pos] * kPrime5;
+    hash = RotateLeft(hash, 11) * kPrime1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+uint64_t DigestLanes(uint64_t seed, const uint64_t* lanes, uint64_t totalSize, const uint8_t* tail,
+                    size_t tailSize) {
+  uint64_t hash;
+  if (totalSize >= kStripeSize) {
+    hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) +
+           RotateLeft(lanes[3], 18);
+    for (int i = 0; i < 4; i++) {
+      hash = MergeLane(hash, lanes[i]);
+    }
+  } else {
+    hash = seed + kPrime5;
+  }
+  hash += totalSize;
+  return Finish(hash, tail, tailSize);
+}
+
+}  // namespace
+
+uint64_t Hash64(const void* data, size_t size, uint64_t seed) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  uint64_t lanes[4];
+  InitLanes(seed, lanes);
+  size_t consumed = ConsumeStripes(bytes, size, lanes);
+  return DigestLanes(seed, lanes, size, bytes + consumed, size - consumed);
+}
+
+Hasher64::Hasher64(uint64_t seed) : seed_(seed) {
+  InitLanes(seed, lanes_);
+}
+
+void Hasher64::Update(const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  totalSize_ += size;
+
+  if (buffered_ + size < kStripeSize) {
+    if (size > 0) std::memcpy(buffer_ + buffered_, bytes, size);
+    buffered_ += size;
+    return;
+  }
+  if (buffered_ > 0) {
+    const size_t fill = kStripeSize - buffered_;
+    std::memcpy(buffer_ + buffered_, bytes, fill);
+    ConsumeStripes(buffer_, kStripeSize, lanes_);
+    bytes += fill;
+    size -= fill;
+    buffered_ = 0;
+  }
+  const size_t consumed = ConsumeStripes(bytes, size, lanes_);
+  buffered_ = size - consumed;
+  if (buffered_ > 0) std::memcpy(buffer_, bytes + consumed, buffered_);
+}
+
+uint64_t Hasher64::Digest() const {
+  return DigestLanes(seed_, lanes_, totalSize_, buffer_, buffered_);
+}
+
+}  // namespace windows_printer
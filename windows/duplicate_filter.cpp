@@ -0,0 +1,82 @@
+#include "duplicate_filter.h"
+
+namespace windows_printer {
+
+DuplicateFilter::DuplicateFilter(DuplicateFilterOptions options)
+    : capacityPerPrinter_(options.capacityPerPrinter > 0 ? options.capacityPerPrinter : 1),
+      window_(options.window) {}
+
+void DuplicateFilter::SetWindow(std::chrono::milliseconds window) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  window_ = window;
+}
+
+bool DuplicateFilter::Claim(const std::string& printerName, uint64_t key, uint32_t* jobId,
+                            Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (window_.count() <= 0) return true;
+
+  PrinterWindow& printer = printers_[printerName];
+  auto found = printer.index.find(key);
+  if (found != printer.index.end()) {
+    Entry& entry = *found->second;
+    if (now - entry.claimed < window_) {
+      *jobId = entry.jobId;
+      // A duplicate keeps the entry from being evicted, not from expiring
+      printer.entries.splice(printer.entries.begin(), printer.entries, found->second);
+      return false;
+    }
+    printer.entries.erase(found->second);
+    printer.index.erase(found);
+  }
+
+  printer.entries.push_front(Entry{key, now, 0});
+  printer.index[key] = printer.entries.begin();
+  if (printer.entries.size() > capacityPerPrinter_) {
+    printer.index.erase(printer.entries.back().key);
+    printer.entries.pop_back();
+  }
+  return true;
+}
+
+void DuplicateFilter::Complete(const std::string& printerName, uint64_t key, uint32_t jobId) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry* entry = Find(printerName, key);
+  if (entry != nullptr) {
+    entry->jobId = jobId;
+  }
+}
+
+void DuplicateFilter::Release(const std::string& printerName, uint64_t key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto printer = printers_.find(printerName);
+  if (printer == printers_.end()) return;
+  auto found = printer->second.index.find(key);
+  if (found == printer->second.index.end()) return;
+  printer->second.entries.erase(found->second);
+  printer->second.index.erase(found);
+}
+
+size_t DuplicateFilter::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t size = 0;
+  for (const auto& printer : printers_) {
+    size += printer.second.entries.size();
+  }
+  return size;
+}
+
+void DuplicateFilter::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  printers_.clear();
+}
+
+DuplicateFilter::Entry* DuplicateFilter::Find(const std::string& printerName, uint64_t key) {
+  auto printer = printers_.find(printerName);
+  if (printer == printers_.end()) return nullptr;
+  auto found = printer->second.index.find(key);
+  if (found == printer->second.index.end()) return nullptr;
+  return &*found->second;
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,77 @@
+#ifndef FLUTTER_PLUGIN_DUPLICATE_FILTER_H_
+#define FLUTTER_PLUGIN_DUPLICATE_FILTER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace windows_printer {
+
+struct DuplicateFilterOptions {
+  /// Submissions remembered per printer; the least recently seen is
+  /// forgotten first
+  size_t capacityPerPrinter = 128;
+  /// How long a submission is remembered; zero turns the filter off
+  std::chrono::milliseconds window{60000};
+};
+
+// Recognizes repeated submissions, such as a retried request or a double
+// tapped print button, by a 64-bit key: a hash of the caller's idempotency
+// key or of the job's content. Each printer has its own bounded LRU window.
+class DuplicateFilter {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit DuplicateFilter(DuplicateFilterOptions options = DuplicateFilterOptions());
+
+  DuplicateFilter(const DuplicateFilter&) = delete;
+  DuplicateFilter& operator=(const DuplicateFilter&) = delete;
+
+  void SetWindow(std::chrono::milliseconds window);
+
+  /// Claim key for a new submission to printerName. Returns false for a
+  /// duplicate of a submission claimed within the window, with the original
+  /// job id in *jobId (0 while the original is still being submitted).
+  bool Claim(const std::string& printerName, uint64_t key, uint32_t* jobId,
+             Clock::time_point now = Clock::now());
+
+  /// Record the job id of a claimed submission that succeeded
+  void Complete(const std::string& printerName, uint64_t key, uint32_t jobId);
+
+  /// Forget a claimed submission that failed, so a retry prints
+  void Release(const std::string& printerName, uint64_t key);
+
+  /// Number of submissions remembered across all printers
+  size_t Size() const;
+
+  void Clear();
+
+private:
+  struct Entry {
+    uint64_t key = 0;
+    Clock::time_point claimed;
+    uint32_t jobId = 0;
+  };
+
+  // Most recently seen first
+  struct PrinterWindow {
+    std::list<Entry> entries;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+  };
+
+  // Finds a remembered entry; must be called with mutex_ held
+  Entry* Find(const std::string& printerName, uint64_t key);
+
+  const size_t capacityPerPrinter_;
+  mutable std::mutex mutex_;
+  std::chrono::milliseconds window_;
+  std::unordered_map<std::string, PrinterWindow> printers_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_DUPLICATE_FILTER_H_
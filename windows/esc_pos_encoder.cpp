@@ -0,0 +1,268 @@
+#include "esc_pos_encoder.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace windows_printer {
+
+namespace {
+
+constexpr uint8_t kEsc = 0x1B;
+constexpr uint8_t kGs = 0x1D;
+constexpr uint8_t kLf = 0x0A;
+constexpr uint8_t kCr = 0x0D;
+constexpr int kImageBandHeight = 24;
+
+bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+bool AllDigits(std::string_view data) {
+  return std::all_of(data.begin(), data.end(), IsDigit);
+}
+
+bool DigitsInRange(std::string_view data, size_t minLength, size_t maxLength) {
+  return data.size() >= minLength && data.size() <= maxLength && AllDigits(data);
+}
+
+bool AllOf(std::string_view data, std::string_view allowedSymbols, bool allowUpper) {
+  return std::all_of(data.begin(), data.end(), [&](char c) {
+    return IsDigit(c) || (allowUpper && c >= 'A' && c <= 'Z') ||
+           allowedSymbols.find(c) != std::string_view::npos;
+  });
+}
+
+}  // namespace
+
+EscPosEncoder::EscPosEncoder(EscPosPaperSize paperSize)
+    : paperSize_(paperSize), buffer_{kEsc, 0x40} {}
+
+void EscPosEncoder::Clear() {
+  // Keeps the buffer's capacity for the next document
+  buffer_.clear();
+  buffer_.push_back(kEsc);
+  buffer_.push_back(0x40);
+}
+
+void EscPosEncoder::Text(std::string_view text, const EscPosTextStyle& style) {
+  SetAlignment(style.align);
+  SetTextFormatting(style);
+
+  Append(text);
+  Append({kCr, kLf});
+
+  ResetFormatting();
+}
+
+void EscPosEncoder::Feed(int lines) {
+  for (int i = 0; i < lines; i++) {
+    buffer_.push_back(kLf);
+  }
+}
+
+void EscPosEncoder::Separator(std::string_view pattern) {
+  const int lineWidth = static_cast<int>(paperSize_) / 12;
+  std::string line;
+  line.reserve(pattern.size() * lineWidth);
+  for (int i = 0; i < lineWidth; i++) {
+    line.append(pattern);
+  }
+  Text(line);
+}
+
+void EscPosEncoder::Cut(bool partial) {
+  Append({kGs, 0x56, static_cast<uint8_t>(partial ? 0x01 : 0x00)});
+  Append({kGs, 0x56, 0x41, static_cast<uint8_t>(partial ? 1 : 0)});
+}
+
+void EscPosEncoder::OpenDrawer(int pin, int onTime, int offTime) {
+  Append({kEsc, 0x70, static_cast<uint8_t>(pin), static_cast<uint8_t>(onTime),
+          static_cast<uint8_t>(offTime)});
+}
+
+void EscPosEncoder::Beep(int count, int duration) {
+  for (int i = 0; i < count; i++) {
+    Append({kEsc, 0x42, static_cast<uint8_t>(std::clamp(duration, 1, 9))});
+    buffer_.push_back(0x07);  // BEL character
+
+    if (i < count - 1) {
+      buffer_.push_back(kLf);
+    }
+  }
+}
+
+bool EscPosEncoder::Barcode(EscPosBarcodeType type, std::string_view data, int height,
+                            int width, bool showText) {
+  if (!IsValidBarcodeData(type, data)) {
+    return false;
+  }
+
+  SetAlignment(EscPosTextAlign::kCenter);
+
+  Append({kGs, 0x48, static_cast<uint8_t>(showText ? 0x02 : 0x00)});
+  Append({kGs, 0x66, 0x00});
+  Append({kGs, 0x77, static_cast<uint8_t>(std::clamp(width, 2, 6))});
+  Append({kGs, 0x68, static_cast<uint8_t>(std::clamp(height, 1, 255))});
+  Append({kGs, 0x6B, static_cast<uint8_t>(type)});
+
+  if (static_cast<uint8_t>(type) <= 6) {
+    // Function A: NUL-terminated data
+    Append(data);
+    buffer_.push_back(0x00);
+  } else {
+    // Function B: length-prefixed data
+    buffer_.push_back(static_cast<uint8_t>(data.size() & 0xFF));
+    Append(data);
+  }
+
+  Append({kCr, kLf});
+  return true;
+}
+
+void EscPosEncoder::QrCode(std::string_view data, int size, int errorCorrection) {
+  const size_t length = data.size() + 3;
+
+  // Store the symbol data
+  Append({kGs, 0x28, 0x6B, static_cast<uint8_t>(length & 0xFF),
+          static_cast<uint8_t>((length >> 8) & 0xFF), 0x31, 0x50, 0x30});
+  Append(data);
+
+  // Module size, error correction level, then print
+  Append({kGs, 0x28, 0x6B, 0x03, 0x00, 0x31, 0x43, static_cast<uint8_t>(size)});
+  Append({kGs, 0x28, 0x6B, 0x03, 0x00, 0x31, 0x45, static_cast<uint8_t>(errorCorrection)});
+  Append({kGs, 0x28, 0x6B, 0x03, 0x00, 0x31, 0x51, 0x30});
+}
+
+void EscPosEncoder::Image(const uint8_t* rgba, size_t length, int width, int height) {
+  if (rgba == nullptr || length == 0 || width <= 0 || height <= 0) return;
+
+  // 24-dot line spacing so consecutive bands touch
+  Append({kEsc, 0x33, 24});
+
+  const size_t bandBytes = static_cast<size_t>(width) * 3;
+  for (int y = 0; y < height; y += kImageBandHeight) {
+    Append({kEsc, 0x2A, 33, static_cast<uint8_t>(width & 0xFF),
+            static_cast<uint8_t>((width >> 8) & 0xFF)});
+
+    // Three bytes per column, least significant bit at the top of each byte
+    const size_t bandStart = buffer_.size();
+    buffer_.resize(bandStart + bandBytes, 0);
+    uint8_t* column = buffer_.data() + bandStart;
+    const int rows = std::min(kImageBandHeight, height - y);
+    for (int bit = 0; bit < rows; bit++) {
+      const size_t rowStart = (static_cast<size_t>(y + bit) * width) * 4;
+      const uint8_t mask = static_cast<uint8_t>(1 << (bit & 7));
+      const int byteIndex = bit >> 3;
+      for (int x = 0; x < width; x++) {
+        const size_t pixelIndex = rowStart + static_cast<size_t>(x) * 4;
+        if (pixelIndex + 3 >= length) break;
+        const uint8_t* pixel = rgba + pixelIndex;
+        const double gray = std::round(pixel[0] * 0.299 + pixel[1] * 0.587 + pixel[2] * 0.114);
+        if (gray < 128) {
+          column[x * 3 + byteIndex] |= mask;
+        }
+      }
+    }
+
+    buffer_.push_back(kLf);
+  }
+
+  // Restore default line spacing
+  Append({kEsc, 0x32});
+}
+
+void EscPosEncoder::Bitmap(const MonoBitmap& bitmap) {
+  const int width = bitmap.Width();
+  const int height = bitmap.Height();
+  if (width <= 0 || height <= 0) return;
+
+  Append({kEsc, 0x33, 24});
+
+  const size_t bandBytes = static_cast<size_t>(width) * 3;
+  for (int y = 0; y < height; y += kImageBandHeight) {
+    Append({kEsc, 0x2A, 33, static_cast<uint8_t>(width & 0xFF),
+            static_cast<uint8_t>((width >> 8) & 0xFF)});
+
+    const size_t bandStart = buffer_.size();
+    buffer_.resize(bandStart + bandBytes, 0);
+    uint8_t* column = buffer_.data() + bandStart;
+    const int rows = std::min(kImageBandHeight, height - y);
+    for (int bit = 0; bit < rows; bit++) {
+      const uint8_t* dots = bitmap.Row(y + bit);
+      const uint8_t mask = static_cast<uint8_t>(0x80 >> (bit & 7));
+      const int byteIndex = bit >> 3;
+      for (size_t byte = 0; byte < bitmap.Stride(); byte++) {
+        if (dots[byte] == 0) continue;
+        for (int x = static_cast<int>(byte) * 8; x < std::min(width, static_cast<int>(byte) * 8 + 8);
+             x++) {
+          if (dots[byte] & (0x80 >> (x & 7))) {
+            column[x * 3 + byteIndex] |= mask;
+          }
+        }
+      }
+    }
+
+    buffer_.push_back(kLf);
+  }
+
+  Append({kEsc, 0x32});
+}
+
+void EscPosEncoder::Raw(const uint8_t* data, size_t length) {
+  buffer_.insert(buffer_.end(), data, data + length);
+}
+
+bool EscPosEncoder::IsValidBarcodeData(EscPosBarcodeType type, std::string_view data) {
+  if (data.empty()) return false;
+
+  switch (type) {
+    case EscPosBarcodeType::kUpcA:
+      return DigitsInRange(data, 11, 12);
+    case EscPosBarcodeType::kUpcE:
+      return DigitsInRange(data, 6, 8);
+    case EscPosBarcodeType::kEan13:
+      return DigitsInRange(data, 12, 13);
+    case EscPosBarcodeType::kEan8:
+      return DigitsInRange(data, 7, 8);
+    case EscPosBarcodeType::kCode39:
+      return AllOf(data, " -.$/+%", true) && data.size() <= 255;
+    case EscPosBarcodeType::kCode128:
+      return data.size() <= 255;
+    case EscPosBarcodeType::kCodabar:
+      return AllOf(data, "-.$/+", false) && data.size() <= 255;
+    case EscPosBarcodeType::kCode93:
+      return data.size() <= 255;
+    case EscPosBarcodeType::kItf:
+      return AllDigits(data) && data.size() % 2 == 0 && data.size() <= 255;
+  }
+  return false;
+}
+
+void EscPosEncoder::SetAlignment(EscPosTextAlign align) {
+  Append({kEsc, 0x61, static_cast<uint8_t>(align)});
+}
+
+void EscPosEncoder::SetTextFormatting(const EscPosTextStyle& style) {
+  Append({kEsc, 0x45, static_cast<uint8_t>(style.bold ? 1 : 0)});
+  Append({kEsc, 0x2D, static_cast<uint8_t>(style.underline ? 1 : 0)});
+  Append({kGs, 0x21, static_cast<uint8_t>(style.size)});
+  Append({kGs, 0x42, static_cast<uint8_t>(style.invert ? 1 : 0)});
+}
+
+void EscPosEncoder::ResetFormatting() {
+  Append({kEsc, 0x45, 0});
+  Append({kEsc, 0x2D, 0});
+  Append({kGs, 0x21, 0});
+  Append({kGs, 0x42, 0});
+  Append({kEsc, 0x61, 0});
+}
+
+void EscPosEncoder::Append(std::initializer_list<uint8_t> bytes) {
+  buffer_.insert(buffer_.end(), bytes.begin(), bytes.end());
+}
+
+void EscPosEncoder::Append(std::string_view bytes) {
+  buffer_.insert(buffer_.end(), bytes.begin(), bytes.end());
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,118 @@
+#ifndef FLUTTER_PLUGIN_ESC_POS_ENCODER_H_
+#define FLUTTER_PLUGIN_ESC_POS_ENCODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mono_bitmap.h"
+
+namespace windows_printer {
+
+/// Thermal paper widths in dots
+enum class EscPosPaperSize {
+  kMm58 = 384,
+  kMm80 = 576,
+};
+
+enum class EscPosTextAlign : uint8_t {
+  kLeft = 0,
+  kCenter = 1,
+  kRight = 2,
+};
+
+enum class EscPosTextSize : uint8_t {
+  kNormal = 0x00,
+  kDoubleHeight = 0x10,
+  kDoubleWidth = 0x20,
+  kDoubleHeightWidth = 0x30,
+};
+
+enum class EscPosBarcodeType : uint8_t {
+  kUpcA = 0,
+  kUpcE = 1,
+  kEan13 = 2,
+  kEan8 = 3,
+  kCode39 = 4,
+  kItf = 5,
+  kCodabar = 6,
+  kCode93 = 72,
+  kCode128 = 73,
+};
+
+struct EscPosTextStyle {
+  bool bold = false;
+  bool underline = false;
+  EscPosTextAlign align = EscPosTextAlign::kLeft;
+  EscPosTextSize size = EscPosTextSize::kNormal;
+  bool invert = false;
+};
+
+// Native ESC/POS command generator. The output is byte-for-byte identical to
+// the Dart WPESCPOSGenerator so receipts can be built on either side.
+class EscPosEncoder {
+public:
+  explicit EscPosEncoder(EscPosPaperSize paperSize = EscPosPaperSize::kMm80);
+
+  /// Generated bytes, starting with ESC @
+  const std::vector<uint8_t>& Bytes() const { return buffer_; }
+
+  /// Clear the buffer back to a single ESC @
+  void Clear();
+
+  /// Add a line of UTF-8 text with optional styling
+  void Text(std::string_view text, const EscPosTextStyle& style = EscPosTextStyle());
+
+  /// Add line feeds
+  void Feed(int lines = 1);
+
+  /// Add a line of repeated characters spanning the paper width
+  void Separator(std::string_view pattern = "-");
+
+  /// Cut the paper
+  void Cut(bool partial = true);
+
+  /// Open cash drawer
+  void OpenDrawer(int pin = 0, int onTime = 60, int offTime = 120);
+
+  /// Make beep sound
+  void Beep(int count = 1, int duration = 3);
+
+  /// Add barcode. Returns false and adds nothing if data is invalid for type.
+  bool Barcode(EscPosBarcodeType type, std::string_view data, int height = 162,
+               int width = 3, bool showText = true);
+
+  /// Add QR code
+  void QrCode(std::string_view data, int size = 6, int errorCorrection = 1);
+
+  /// Add an RGBA image as 24-dot bit image bands
+  void Image(const uint8_t* rgba, size_t length, int width, int height);
+
+  /// Add a 1-bit image, such as one from RasterizeReceiptImage, as 24-dot
+  /// bit image bands with the most significant bit at the top, the order
+  /// printers and EscPosRenderer read
+  void Bitmap(const MonoBitmap& bitmap);
+
+  /// Add raw bytes directly
+  void Raw(const uint8_t* data, size_t length);
+
+  /// Whether data is accepted by Barcode for the given type
+  static bool IsValidBarcodeData(EscPosBarcodeType type, std::string_view data);
+
+private:
+  void SetAlignment(EscPosTextAlign align);
+  void SetTextFormatting(const EscPosTextStyle& style);
+  void ResetFormatting();
+  void Append(std::initializer_list<uint8_t> bytes);
+  void Append(std::string_view bytes);
+
+  EscPosPaperSize paperSize_;
+  std::vector<uint8_t> buffer_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_ESC_POS_ENCODER_H_
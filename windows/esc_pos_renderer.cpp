@@ -0,0 +1,803 @@
+#include "esc_pos_renderer.h"
+
+#include <array>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "esc_pos_symbols.h"
+
+namespace windows_printer {
+
+namespace {
+
+constexpr uint8_t kHt = 0x09;
+constexpr uint8_t kLf = 0x0A;
+constexpr uint8_t kDle = 0x10;
+constexpr uint8_t kEsc = 0x1B;
+constexpr uint8_t kFs = 0x1C;
+constexpr uint8_t kGs = 0x1D;
+
+constexpr int kDefaultLineSpacing = 30;
+constexpr int kTabColumns = 8;
+
+// 5x7 glyphs for 0x20-0x7E, one byte per column, least significant bit at
+// the top
+constexpr uint8_t kFont5x7[95][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x56, 0x20, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00},
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x14, 0x08, 0x3E, 0x08, 0x14}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+    {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00},
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},
+    {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31}, {0x18, 0x14, 0x12, 0x7F, 0x10},
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00},
+    {0x00, 0x56, 0x36, 0x00, 0x00}, {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06}, {0x32, 0x49, 0x79, 0x41, 0x3E},
+    {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01},
+    {0x3E, 0x41, 0x49, 0x49, 0x7A}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40},
+    {0x7F, 0x02, 0x0C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46},
+    {0x46, 0x49, 0x49, 0x49, 0x31}, {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F},
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63},
+    {0x07, 0x08, 0x70, 0x08, 0x07}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x00},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7F, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04},
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78},
+    {0x7F, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20}, {0x38, 0x44, 0x44, 0x48, 0x7F},
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x08, 0x7E, 0x09, 0x01, 0x02}, {0x0C, 0x52, 0x52, 0x52, 0x3E},
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x44, 0x3D, 0x00},
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x18, 0x04, 0x78},
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0x7C, 0x14, 0x14, 0x14, 0x08},
+    {0x08, 0x14, 0x14, 0x18, 0x7C}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},
+    {0x04, 0x3F, 0x44, 0x40, 0x20}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C},
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0C, 0x50, 0x50, 0x50, 0x3C},
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x7F, 0x00, 0x00},
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x10, 0x08, 0x08, 0x10, 0x08},
+};
+
+constexpr int kReplacementGlyph = '?' - 0x20;
+
+// Character cell of font A (12x24) and font B (9x17), and how the 5x7 glyphs
+// are scaled and placed in it
+struct FontMetrics {
+  int width;
+  int height;
+  int scaleX;
+  int scaleY;
+  int offsetX;
+  int offsetY;
+};
+constexpr std::array<FontMetrics, 2> kFonts = {FontMetrics{12, 24, 2, 3, 1, 1},
+                                               FontMetrics{9, 17, 1, 2, 2, 1}};
+
+// ESC * modes: dots per column and how far each dot is stretched
+struct BitImageMode {
+  int mode;
+  int columnBytes;
+  int scaleX;
+  int scaleY;
+};
+constexpr std::array<BitImageMode, 4> kBitImageModes = {
+    BitImageMode{0, 1, 2, 3}, BitImageMode{1, 1, 1, 3}, BitImageMode{32, 3, 2, 1},
+    BitImageMode{33, 3, 1, 1}};
+
+struct TextState {
+  int font = 0;
+  int widthScale = 1;
+  int heightScale = 1;
+  bool bold = false;
+  int underline = 0;
+  bool invert = false;
+  int characterSpacing = 0;
+  EscPosTextAlign align = EscPosTextAlign::kLeft;
+  int lineSpacing = kDefaultLineSpacing;
+};
+
+struct BarcodeState {
+  int height = 162;
+  int moduleWidth = 3;
+  int hriPosition = 0;
+  int hriFont = 0;
+};
+
+struct QrState {
+  std::string data;
+  int moduleSize = 3;
+  QrErrorCorrection level = QrErrorCorrection::kLow;
+};
+
+// Something waiting in the line buffer; lines are printed bottom-aligned
+struct LineItem {
+  int x;
+  const MonoBitmap* bitmap;
+  /// Cell width including character spacing
+  int advance;
+  int underline;
+  bool invert;
+};
+
+class Renderer {
+public:
+  Renderer(const uint8_t* data, size_t length, const EscPosPreviewOptions& options)
+      : data_(data),
+        length_(length),
+        paperWidth_(options.paperWidth > 0 ? options.paperWidth : 1),
+        maxHeight_(options.maxHeight > 0 ? options.maxHeight : 1),
+        markCuts_(options.markCuts) {
+    preview_.bitmap = MonoBitmap(paperWidth_, 0);
+  }
+
+  EscPosPreview Run() {
+    while (position_ < length_ && !preview_.truncated) {
+      const uint8_t byte = data_[position_];
+      if (byte == kEsc) {
+        Escape();
+      } else if (byte == kGs) {
+        GroupSeparator();
+      } else if (byte == kDle) {
+        RealTime();
+      } else if (byte == kFs) {
+        FileSeparator();
+      } else if (byte == kLf) {
+        position_++;
+        PrintLine(text_.lineSpacing);
+      } else if (byte == kHt) {
+        position_++;
+        Tab();
+      } else if (byte < 0x20 || byte == 0x7F) {
+        // CR, BEL and other controls do not move the paper
+        position_++;
+      } else {
+        Character();
+      }
+    }
+    if (!line_.empty()) {
+      PrintLine(0);
+    }
+
+    int height = y_ > extent_ ? y_ : extent_;
+    if (height > maxHeight_) height = maxHeight_;
+    preview_.bitmap.Resize(height > 0 ? height : 1);
+    return std::move(preview_);
+  }
+
+private:
+  bool Available(size_t count) const { return length_ - position_ >= count; }
+  uint8_t At(size_t offset) const { return data_[position_ + offset]; }
+
+  // The command was cut off by the end of the stream
+  void Truncated() { position_ = length_; }
+
+  void Unknown(size_t length) {
+    preview_.unknownCommands++;
+    position_ = Available(length) ? position_ + length : length_;
+  }
+
+  void Reset() {
+    line_.clear();
+    lineImages_.clear();
+    lineX_ = 0;
+    text_ = TextState();
+    barcode_ = BarcodeState();
+    qr_ = QrState();
+  }
+
+  void Escape() {
+    if (!Available(2)) return Truncated();
+    const uint8_t command = At(1);
+    // Commands with a single parameter byte
+    if (command == '!' || command == ' ' || command == '-' || command == '3' ||
+        command == 'E' || command == 'G' || command == 'J' || command == 'M' ||
+        command == 'a' || command == 'd' || command == 'B' || command == 't' ||
+        command == 'R' || command == '{' || command == 'V' || command == 'U' ||
+        command == '=' || command == 'r') {
+      if (!Available(3)) return Truncated();
+      const int n = At(2);
+      position_ += 3;
+      switch (command) {
+        case '!':
+          text_.font = n & 0x01;
+          text_.bold = (n & 0x08) != 0;
+          text_.heightScale = (n & 0x10) ? 2 : 1;
+          text_.widthScale = (n & 0x20) ? 2 : 1;
+          text_.underline = (n & 0x80) ? 1 : 0;
+          break;
+        case ' ':
+          text_.characterSpacing = n;
+          break;
+        case '-':
+          text_.underline = (n & 0x0F) <= 2 ? n & 0x0F : 0;
+          break;
+        case '3':
+          text_.lineSpacing = n;
+          break;
+        case 'E':
+        case 'G':
+          text_.bold = (n & 0x01) != 0;
+          break;
+        case 'J':
+          PrintLine(n);
+          break;
+        case 'M':
+          text_.font = n & 0x01;
+          break;
+        case 'a':
+          if ((n & 0x0F) <= 2) text_.align = static_cast<EscPosTextAlign>(n & 0x0F);
+          break;
+        case 'd':
+          PrintLine(n * text_.lineSpacing);
+          break;
+        case 'B':
+          preview_.beeps++;
+          break;
+        default:
+          // Code pages, rotation and similar settings do not change the preview
+          break;
+      }
+      return;
+    }
+
+    switch (command) {
+      case '@':
+        position_ += 2;
+        Reset();
+        return;
+      case '2':
+        position_ += 2;
+        text_.lineSpacing = kDefaultLineSpacing;
+        return;
+      case '$': {
+        if (!Available(4)) return Truncated();
+        const int x = At(2) | At(3) << 8;
+        position_ += 4;
+        lineX_ = x < paperWidth_ ? x : paperWidth_;
+        return;
+      }
+      case 'p':
+        if (!Available(5)) return Truncated();
+        position_ += 5;
+        preview_.drawerPulses++;
+        return;
+      case 'c':
+        if (!Available(4)) return Truncated();
+        position_ += 4;
+        return;
+      case '*':
+        return BitImage();
+      case '(':
+        return Unknown(LengthPrefixedSize());
+      default:
+        return Unknown(2);
+    }
+  }
+
+  void GroupSeparator() {
+    if (!Available(2)) return Truncated();
+    const uint8_t command = At(1);
+    switch (command) {
+      case '!': {
+        if (!Available(3)) return Truncated();
+        const int n = At(2);
+        position_ += 3;
+        text_.widthScale = ((n >> 4) & 0x07) + 1;
+        text_.heightScale = (n & 0x07) + 1;
+        return;
+      }
+      case 'B':
+        if (!Available(3)) return Truncated();
+        text_.invert = (At(2) & 0x01) != 0;
+        position_ += 3;
+        return;
+      case 'H':
+        if (!Available(3)) return Truncated();
+        barcode_.hriPosition = At(2) & 0x03;
+        position_ += 3;
+        return;
+      case 'f':
+        if (!Available(3)) return Truncated();
+        barcode_.hriFont = At(2) & 0x01;
+        position_ += 3;
+        return;
+      case 'h':
+        if (!Available(3)) return Truncated();
+        if (At(2) > 0) barcode_.height = At(2);
+        position_ += 3;
+        return;
+      case 'w':
+        if (!Available(3)) return Truncated();
+        if (At(2) >= 1 && At(2) <= 6) barcode_.moduleWidth = At(2);
+        position_ += 3;
+        return;
+      case 'V':
+        return Cut();
+      case 'k':
+        return Barcode();
+      case 'v':
+        return RasterImage();
+      case '(':
+        if (Available(3) && At(2) == 'k') return Symbol();
+        return Unknown(LengthPrefixedSize());
+      case 'L':
+      case 'W':
+      case 'P':
+        if (!Available(4)) return Truncated();
+        position_ += 4;
+        return;
+      case 'a':
+      case 'I':
+      case 'r':
+        if (!Available(3)) return Truncated();
+        position_ += 3;
+        return;
+      default:
+        return Unknown(2);
+    }
+  }
+
+  void RealTime() {
+    if (!Available(2)) return Truncated();
+    if (At(1) == 0x04 || At(1) == 0x05) {
+      if (!Available(3)) return Truncated();
+      position_ += 3;
+      return;
+    }
+    if (At(1) == 0x14) {
+      if (!Available(5)) return Truncated();
+      // Function 1 pulses the drawer kick-out connector
+      if (At(2) == 1) preview_.drawerPulses++;
+      position_ += 5;
+      return;
+    }
+    // A lone DLE has no meaning outside a command
+    position_++;
+  }
+
+  void FileSeparator() {
+    if (!Available(2)) return Truncated();
+    const uint8_t command = At(1);
+    if (command == '&' || command == '.') {
+      position_ += 2;
+      return;
+    }
+    if (command == '!' || command == '-' || command == 'C') {
+      if (!Available(3)) return Truncated();
+      position_ += 3;
+      return;
+    }
+    if (command == '(') return Unknown(LengthPrefixedSize());
+    Unknown(2);
+  }
+
+  // Size of an ESC ( / GS ( / FS ( command: three bytes, a 16-bit length and
+  // that many parameter bytes
+  size_t LengthPrefixedSize() const {
+    if (!Available(5)) return length_ - position_;
+    return 5 + static_cast<size_t>(At(3) | At(4) << 8);
+  }
+
+  // --- Text ---
+
+  const MonoBitmap* Glyph(int index) {
+    const int key = index | text_.font << 7 | (text_.widthScale - 1) << 8 |
+                    (text_.heightScale - 1) << 11 | (text_.bold ? 1 : 0) << 14;
+    auto it = glyphs_.find(key);
+    if (it != glyphs_.end()) return &it->second;
+
+    const FontMetrics& font = kFonts[static_cast<size_t>(text_.font)];
+    const int scaleX = font.scaleX * text_.widthScale;
+    const int scaleY = font.scaleY * text_.heightScale;
+    MonoBitmap glyph(font.width * text_.widthScale, font.height * text_.heightScale);
+    for (int column = 0; column < 5; column++) {
+      const uint8_t bits = kFont5x7[index][column];
+      for (int row = 0; row < 7; row++) {
+        if (!(bits & (1 << row))) continue;
+        glyph.FillRect((font.offsetX + column * font.scaleX) * text_.widthScale,
+                       (font.offsetY + row * font.scaleY) * text_.heightScale, scaleX, scaleY);
+      }
+    }
+    if (text_.bold) {
+      // Emphasized text is struck twice, one dot apart
+      for (int y = 0; y < glyph.Height(); y++) {
+        for (int x = glyph.Width() - 1; x > 0; x--) {
+          if (glyph.Get(x - 1, y)) glyph.Set(x, y);
+        }
+      }
+    }
+    return &glyphs_.emplace(key, std::move(glyph)).first->second;
+  }
+
+  int CharacterAdvance() const {
+    return (kFonts[static_cast<size_t>(text_.font)].width + text_.characterSpacing) *
+           text_.widthScale;
+  }
+
+  void AddToLine(const MonoBitmap* bitmap, int advance, int underline, bool invert) {
+    if (line_.empty()) lineAlign_ = text_.align;
+    // Items that do not fit on the paper start the next line
+    if (lineX_ > 0 && lineX_ + bitmap->Width() > paperWidth_) {
+      PrintLine(text_.lineSpacing);
+      lineAlign_ = text_.align;
+    }
+    line_.push_back(LineItem{lineX_, bitmap, advance, underline, invert});
+    lineX_ += advance;
+  }
+
+  void Character() {
+    const uint8_t lead = data_[position_];
+    int index = kReplacementGlyph;
+    size_t length = 1;
+    if (lead < 0x80) {
+      index = lead - 0x20;
+    } else {
+      // Anything outside ASCII prints as one replacement glyph per UTF-8
+      // sequence; invalid bytes print one each
+      const size_t expected = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+      while (length < expected && position_ + length < length_ &&
+             (data_[position_ + length] & 0xC0) == 0x80) {
+        length++;
+      }
+      if (length != expected) length = 1;
+    }
+    position_ += length;
+    AddToLine(Glyph(index), CharacterAdvance(), text_.underline, text_.invert);
+  }
+
+  void Tab() {
+    const int stop = kTabColumns * CharacterAdvance();
+    const int next = (lineX_ / stop + 1) * stop;
+    if (line_.empty()) lineAlign_ = text_.align;
+    lineX_ = next < paperWidth_ ? next : paperWidth_;
+  }
+
+  // --- Paper ---
+
+  // Grow the paper to cover `bottom`; false once the limit is reached
+  bool Reserve(int bottom) {
+    if (bottom > maxHeight_) {
+      preview_.truncated = true;
+      bottom = maxHeight_;
+    }
+    if (bottom > extent_) extent_ = bottom;
+    if (bottom > preview_.bitmap.Height()) {
+      preview_.bitmap.Resize(bottom);
+    }
+    return !preview_.truncated;
+  }
+
+  int AlignedX(int width, EscPosTextAlign align) const {
+    if (width >= paperWidth_) return 0;
+    switch (align) {
+      case EscPosTextAlign::kCenter:
+        return (paperWidth_ - width) / 2;
+      case EscPosTextAlign::kRight:
+        return paperWidth_ - width;
+      default:
+        return 0;
+    }
+  }
+
+  // Print the line buffer and feed by `feed` dots, or the line height if that
+  // is taller
+  void PrintLine(int feed) {
+    int lineHeight = 0;
+    int lineWidth = 0;
+    for (const LineItem& item : line_) {
+      if (item.bitmap->Height() > lineHeight) lineHeight = item.bitmap->Height();
+      if (item.x + item.advance > lineWidth) lineWidth = item.x + item.advance;
+    }
+
+    if (!line_.empty()) {
+      Reserve(y_ + lineHeight);
+      const int left = AlignedX(lineWidth, lineAlign_);
+      MonoBitmap& paper = preview_.bitmap;
+      for (const LineItem& item : line_) {
+        const MonoBitmap& bitmap = *item.bitmap;
+        const int x = left + item.x;
+        const int top = y_ + lineHeight - bitmap.Height();
+        if (item.invert) {
+          paper.FillRect(x, top, item.advance, bitmap.Height());
+          paper.Blit(bitmap.Row(0), bitmap.Stride(), bitmap.Width(), bitmap.Height(), x, top,
+                     BlitMode::kClear);
+        } else {
+          paper.Blit(bitmap.Row(0), bitmap.Stride(), bitmap.Width(), bitmap.Height(), x, top);
+        }
+        if (item.underline > 0) {
+          paper.FillRect(x, y_ + lineHeight - item.underline, item.advance, item.underline,
+                         !item.invert);
+        }
+      }
+      printedSinceCut_ = true;
+    }
+
+    y_ += feed > lineHeight ? feed : lineHeight;
+    Reserve(y_);
+    line_.clear();
+    lineImages_.clear();
+    lineX_ = 0;
+  }
+
+  void PrintPending() {
+    if (!line_.empty()) PrintLine(0);
+  }
+
+  void Cut() {
+    if (!Available(3)) return Truncated();
+    const int mode = At(2);
+    size_t length = 3;
+    int feed = 0;
+    if (mode == 65 || mode == 66 || mode == 97 || mode == 98) {
+      if (!Available(4)) return Truncated();
+      feed = At(3);
+      length = 4;
+    }
+    position_ += length;
+    PrintPending();
+    y_ += feed;
+    if (!Reserve(y_)) return;
+
+    // A second cut with nothing printed since the first one does not
+    // separate anything (the generator sends GS V m and GS V A n together)
+    if (!preview_.cuts.empty() && !printedSinceCut_) return;
+    preview_.cuts.push_back(y_);
+    printedSinceCut_ = false;
+    if (markCuts_ && Reserve(y_ + 1)) {
+      for (int x = 0; x < paperWidth_; x += 8) {
+        preview_.bitmap.FillRect(x, y_, 4, 1);
+      }
+      y_ += 1;
+    }
+  }
+
+  // --- Images ---
+
+  void BitImage() {
+    if (!Available(5)) return Truncated();
+    const int mode = At(2);
+    const int columns = At(3) | At(4) << 8;
+    const BitImageMode* format = nullptr;
+    for (const BitImageMode& candidate : kBitImageModes) {
+      if (candidate.mode == mode) format = &candidate;
+    }
+    if (format == nullptr) return Unknown(5);
+    const size_t size = static_cast<size_t>(columns) * format->columnBytes;
+    if (!Available(5 + size)) return Truncated();
+    const uint8_t* column = data_ + position_ + 5;
+    position_ += 5 + size;
+    if (columns == 0) return;
+
+    // Columns of vertical dots, most significant bit at the top
+    const int dots = format->columnBytes * 8;
+    lineImages_.emplace_back(columns * format->scaleX, dots * format->scaleY);
+    MonoBitmap& image = lineImages_.back();
+    for (int x = 0; x < columns; x++) {
+      for (int dot = 0; dot < dots; dot++) {
+        const uint8_t byte = column[static_cast<size_t>(x) * format->columnBytes + dot / 8];
+        if (byte & (0x80 >> (dot % 8))) {
+          image.FillRect(x * format->scaleX, dot * format->scaleY, format->scaleX,
+                         format->scaleY);
+        }
+      }
+    }
+    AddToLine(&image, image.Width(), 0, false);
+  }
+
+  void RasterImage() {
+    if (!Available(8)) return Truncated();
+    if (At(2) != '0') return Unknown(3);
+    const int mode = At(3);
+    const int widthBytes = At(4) | At(5) << 8;
+    const int height = At(6) | At(7) << 8;
+    const size_t size = static_cast<size_t>(widthBytes) * height;
+    if (!Available(8 + size)) return Truncated();
+    const uint8_t* rows = data_ + position_ + 8;
+    position_ += 8 + size;
+    PrintPending();
+    if (widthBytes == 0 || height == 0) return;
+
+    const int scaleX = (mode & 0x01) ? 2 : 1;
+    const int scaleY = (mode & 0x02) ? 2 : 1;
+    const int width = widthBytes * 8 * scaleX;
+    const int x = AlignedX(width, text_.align);
+    Reserve(y_ + height * scaleY);
+    if (scaleX == 1 && scaleY == 1) {
+      preview_.bitmap.Blit(rows, static_cast<size_t>(widthBytes), width, height, x, y_);
+    } else {
+      for (int row = 0; row < height; row++) {
+        const uint8_t* bits = rows + static_cast<size_t>(row) * widthBytes;
+        for (int column = 0; column < widthBytes * 8; column++) {
+          if (bits[column >> 3] & (0x80 >> (column & 7))) {
+            preview_.bitmap.FillRect(x + column * scaleX, y_ + row * scaleY, scaleX, scaleY);
+          }
+        }
+      }
+    }
+    y_ += height * scaleY;
+    printedSinceCut_ = true;
+  }
+
+  // --- Symbols ---
+
+  // Human readable text under or over a barcode, centered on it
+  void DrawHri(const std::string& text, int centerX) {
+    const TextState saved = text_;
+    text_ = TextState();
+    text_.font = barcode_.hriFont;
+    const int advance = CharacterAdvance();
+    const int height = kFonts[static_cast<size_t>(text_.font)].height;
+    int x = centerX - static_cast<int>(text.size()) * advance / 2;
+    Reserve(y_ + height);
+    for (char c : text) {
+      const int index = c >= 0x20 && c < 0x7F ? c - 0x20 : kReplacementGlyph;
+      const MonoBitmap* glyph = Glyph(index);
+      preview_.bitmap.Blit(glyph->Row(0), glyph->Stride(), glyph->Width(), glyph->Height(), x,
+                           y_);
+      x += advance;
+    }
+    y_ += height;
+    text_ = saved;
+  }
+
+  void Barcode() {
+    if (!Available(3)) return Truncated();
+    const int m = At(2);
+    std::string_view content;
+    int type = m;
+    if (m <= 6) {
+      // Function A: NUL-terminated
+      size_t end = position_ + 3;
+      while (end < length_ && data_[end] != 0) end++;
+      if (end >= length_) return Truncated();
+      content = std::string_view(reinterpret_cast<const char*>(data_ + position_ + 3),
+                                 end - position_ - 3);
+      position_ = end + 1;
+    } else if (m >= 65 && m <= 73) {
+      // Function B: length-prefixed
+      if (!Available(4)) return Truncated();
+      const size_t size = At(3);
+      if (!Available(4 + size)) return Truncated();
+      content = std::string_view(reinterpret_cast<const char*>(data_ + position_ + 4), size);
+      position_ += 4 + size;
+      type = m <= 71 ? m - 65 : m;
+    } else {
+      return Unknown(3);
+    }
+    PrintPending();
+
+    const LinearBarcode barcode =
+        EncodeLinearBarcode(static_cast<EscPosBarcodeType>(type), content);
+    if (barcode.modules.empty()) {
+      preview_.unknownCommands++;
+      return;
+    }
+    const int width = static_cast<int>(barcode.modules.size()) * barcode_.moduleWidth;
+    // Printers skip barcodes that do not fit the print area
+    if (width > paperWidth_) return;
+    const int x = AlignedX(width, text_.align);
+
+    if (barcode_.hriPosition & 0x01) DrawHri(barcode.text, x + width / 2);
+    if (!Reserve(y_ + barcode_.height)) return;
+    for (size_t start = 0; start < barcode.modules.size();) {
+      size_t end = start;
+      while (end < barcode.modules.size() && barcode.modules[end] == barcode.modules[start]) {
+        end++;
+      }
+      if (barcode.modules[start]) {
+        preview_.bitmap.FillRect(x + static_cast<int>(start) * barcode_.moduleWidth, y_,
+                                 static_cast<int>(end - start) * barcode_.moduleWidth,
+                                 barcode_.height);
+      }
+      start = end;
+    }
+    y_ += barcode_.height;
+    if (barcode_.hriPosition & 0x02) DrawHri(barcode.text, x + width / 2);
+    printedSinceCut_ = true;
+  }
+
+  // GS ( k: only the QR code functions (cn 49) are interpreted
+  void Symbol() {
+    const size_t size = LengthPrefixedSize();
+    if (!Available(size) || size < 7) return Unknown(size);
+    const uint8_t* parameters = data_ + position_ + 5;
+    const size_t count = size - 5;
+    position_ += size;
+    if (parameters[0] != 49) {
+      preview_.unknownCommands++;
+      return;
+    }
+
+    switch (parameters[1]) {
+      case 65:  // Model
+      case 82:  // Transmit size
+        break;
+      case 67:
+        if (count >= 3 && parameters[2] >= 1 && parameters[2] <= 16) {
+          qr_.moduleSize = parameters[2];
+        }
+        break;
+      case 69:
+        // Spec values are 48-51; 0-3 are accepted as many printers do
+        if (count >= 3 && (parameters[2] & 0x0F) <= 3) {
+          qr_.level = static_cast<QrErrorCorrection>(parameters[2] & 0x0F);
+        }
+        break;
+      case 80:
+        if (count >= 3) {
+          qr_.data.assign(reinterpret_cast<const char*>(parameters + 3), count - 3);
+        }
+        break;
+      case 81:
+        PrintQrCode();
+        break;
+      default:
+        preview_.unknownCommands++;
+        break;
+    }
+  }
+
+  void PrintQrCode() {
+    PrintPending();
+    if (qr_.data.empty()) return;
+    const QrCode code = EncodeQrCode(qr_.data, qr_.level);
+    if (code.size == 0) {
+      preview_.unknownCommands++;
+      return;
+    }
+    const int side = code.size * qr_.moduleSize;
+    if (side > paperWidth_) return;
+    const int x = AlignedX(side, text_.align);
+    if (!Reserve(y_ + side)) return;
+    for (int row = 0; row < code.size; row++) {
+      for (int start = 0; start < code.size;) {
+        int end = start;
+        while (end < code.size && code.Module(end, row) == code.Module(start, row)) end++;
+        if (code.Module(start, row)) {
+          preview_.bitmap.FillRect(x + start * qr_.moduleSize, y_ + row * qr_.moduleSize,
+                                   (end - start) * qr_.moduleSize, qr_.moduleSize);
+        }
+        start = end;
+      }
+    }
+    y_ += side;
+    printedSinceCut_ = true;
+  }
+
+  const uint8_t* data_;
+  const size_t length_;
+  size_t position_ = 0;
+  const int paperWidth_;
+  const int maxHeight_;
+  const bool markCuts_;
+
+  EscPosPreview preview_;
+  int y_ = 0;
+  int extent_ = 0;
+  bool printedSinceCut_ = false;
+
+  TextState text_;
+  BarcodeState barcode_;
+  QrState qr_;
+
+  std::vector<LineItem> line_;
+  // Bitmaps of ESC * images in the line buffer; a deque keeps them in place
+  std::deque<MonoBitmap> lineImages_;
+  EscPosTextAlign lineAlign_ = EscPosTextAlign::kLeft;
+  int lineX_ = 0;
+
+  // Rendered glyphs by character, font, scale and emphasis
+  std::unordered_map<int, MonoBitmap> glyphs_;
+};
+
+}  // namespace
+
+EscPosPreview RenderEscPos(const uint8_t* data, size_t length,
+                           const EscPosPreviewOptions& options) {
+  if (data == nullptr) length = 0;
+  return Renderer(data, length, options).Run();
+}
+
+}  // namespace windows_printer
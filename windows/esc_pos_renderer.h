@@ -0,0 +1,44 @@
+#ifndef FLUTTER_PLUGIN_ESC_POS_RENDERER_H_
+#define FLUTTER_PLUGIN_ESC_POS_RENDERER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+#include "mono_bitmap.h"
+
+namespace windows_printer {
+
+struct EscPosPreviewOptions {
+  /// Printable width in dots
+  int paperWidth = static_cast<int>(EscPosPaperSize::kMm80);
+  /// Longest receipt rendered, in dots; anything below is dropped
+  int maxHeight = 32000;
+  /// Draw a dashed line across the paper where it is cut
+  bool markCuts = true;
+};
+
+struct EscPosPreview {
+  /// The printed paper, at least one dot row tall
+  MonoBitmap bitmap;
+  /// Dot row of each cut, top to bottom
+  std::vector<int> cuts;
+  int drawerPulses = 0;
+  int beeps = 0;
+  /// Commands that were skipped because they are not interpreted
+  int unknownCommands = 0;
+  /// The receipt was longer than maxHeight
+  bool truncated = false;
+};
+
+/// Print an ESC/POS byte stream to a bitmap the way a thermal receipt printer
+/// would: text in the printer's 12x24 and 9x17 fonts with ESC !/GS ! styles,
+/// ESC * and GS v 0 images, GS k barcodes and GS ( k QR codes. Text is read
+/// as UTF-8; characters outside printable ASCII print as '?'.
+EscPosPreview RenderEscPos(const uint8_t* data, size_t length,
+                           const EscPosPreviewOptions& options = EscPosPreviewOptions());
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_ESC_POS_RENDERER_H_
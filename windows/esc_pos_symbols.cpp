@@ -0,0 +1,692 @@
+#include "esc_pos_symbols.h"
+
+#include <array>
+#include <cstdlib>
+
+namespace windows_printer {
+
+namespace {
+
+// --- Linear barcodes ---
+
+constexpr int kNarrow = 1;
+constexpr int kWide = 3;
+
+void AppendElement(std::vector<bool>& modules, bool bar, int width) {
+  modules.insert(modules.end(), static_cast<size_t>(width), bar);
+}
+
+// Append a pattern of alternating elements starting with a bar; bit i of
+// wide (from the most significant of count bits) marks a wide element
+void AppendWideNarrow(std::vector<bool>& modules, uint16_t wide, int count) {
+  for (int i = 0; i < count; i++) {
+    const bool isWide = (wide >> (count - 1 - i)) & 1;
+    AppendElement(modules, i % 2 == 0, isWide ? kWide : kNarrow);
+  }
+}
+
+// Append `count` bits of pattern, most significant first; 1 is a bar
+void AppendBits(std::vector<bool>& modules, uint32_t pattern, int count) {
+  for (int i = count - 1; i >= 0; i--) {
+    modules.push_back(((pattern >> i) & 1) != 0);
+  }
+}
+
+bool IsDigits(std::string_view data) {
+  for (char c : data) {
+    if (c < '0' || c > '9') return false;
+  }
+  return !data.empty();
+}
+
+// Check digit for EAN/UPC: weights 3 and 1 alternate from the rightmost digit
+char UpcCheckDigit(std::string_view digits) {
+  int sum = 0;
+  for (size_t i = 0; i < digits.size(); i++) {
+    const int weight = (digits.size() - i) % 2 == 1 ? 3 : 1;
+    sum += (digits[i] - '0') * weight;
+  }
+  return static_cast<char>('0' + (10 - sum % 10) % 10);
+}
+
+// Left-hand odd parity (L) codes; R codes are their complement and even
+// parity (G) codes the R codes reversed
+constexpr std::array<uint8_t, 10> kEanLeftCodes = {0x0D, 0x19, 0x13, 0x3D, 0x23,
+                                                   0x31, 0x2F, 0x3B, 0x37, 0x0B};
+// Parity of the six left digits of an EAN-13 by its first digit; 1 is G
+constexpr std::array<uint8_t, 10> kEan13Parity = {0x00, 0x0B, 0x0D, 0x0E, 0x13,
+                                                  0x19, 0x1C, 0x15, 0x16, 0x1A};
+
+uint8_t EanRightCode(int digit) {
+  return static_cast<uint8_t>(~kEanLeftCodes[digit] & 0x7F);
+}
+
+uint8_t EanEvenCode(int digit) {
+  const uint8_t right = EanRightCode(digit);
+  uint8_t reversed = 0;
+  for (int i = 0; i < 7; i++) {
+    reversed = static_cast<uint8_t>((reversed << 1) | ((right >> i) & 1));
+  }
+  return reversed;
+}
+
+LinearBarcode EncodeEan13(const std::string& digits12) {
+  LinearBarcode barcode;
+  barcode.text = digits12 + UpcCheckDigit(digits12);
+  const uint8_t parity = kEan13Parity[barcode.text[0] - '0'];
+  AppendBits(barcode.modules, 0x5, 3);
+  for (int i = 1; i <= 6; i++) {
+    const int digit = barcode.text[i] - '0';
+    const bool even = (parity >> (6 - i)) & 1;
+    AppendBits(barcode.modules, even ? EanEvenCode(digit) : kEanLeftCodes[digit], 7);
+  }
+  AppendBits(barcode.modules, 0x0A, 5);
+  for (int i = 7; i <= 12; i++) {
+    AppendBits(barcode.modules, EanRightCode(barcode.text[i] - '0'), 7);
+  }
+  AppendBits(barcode.modules, 0x5, 3);
+  return barcode;
+}
+
+LinearBarcode EncodeEan8(std::string_view data) {
+  LinearBarcode barcode;
+  barcode.text = std::string(data.substr(0, 7));
+  barcode.text += UpcCheckDigit(barcode.text);
+  AppendBits(barcode.modules, 0x5, 3);
+  for (int i = 0; i < 4; i++) {
+    AppendBits(barcode.modules, kEanLeftCodes[barcode.text[i] - '0'], 7);
+  }
+  AppendBits(barcode.modules, 0x0A, 5);
+  for (int i = 4; i < 8; i++) {
+    AppendBits(barcode.modules, EanRightCode(barcode.text[i] - '0'), 7);
+  }
+  AppendBits(barcode.modules, 0x5, 3);
+  return barcode;
+}
+
+// Nine elements per character, three of them wide
+constexpr std::string_view kCode39Characters = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ-. $/+%*";
+constexpr std::array<uint16_t, 44> kCode39Patterns = {
+    0x034, 0x121, 0x061, 0x160, 0x031, 0x130, 0x070, 0x025, 0x124, 0x064, 0x109,
+    0x049, 0x148, 0x019, 0x118, 0x058, 0x00D, 0x10C, 0x04C, 0x01C, 0x103, 0x043,
+    0x142, 0x013, 0x112, 0x052, 0x007, 0x106, 0x046, 0x016, 0x181, 0x0C1, 0x1C0,
+    0x091, 0x190, 0x0D0, 0x085, 0x184, 0x0C4, 0x0A8, 0x0A2, 0x08A, 0x02A, 0x094};
+
+LinearBarcode EncodeCode39(std::string_view data) {
+  LinearBarcode barcode;
+  barcode.text = std::string(data);
+  const std::string framed = "*" + barcode.text + "*";
+  for (size_t i = 0; i < framed.size(); i++) {
+    const size_t index = kCode39Characters.find(framed[i]);
+    if (index == std::string_view::npos) return LinearBarcode();
+    if (i > 0) AppendElement(barcode.modules, false, kNarrow);
+    AppendWideNarrow(barcode.modules, kCode39Patterns[index], 9);
+  }
+  return barcode;
+}
+
+// Five elements per digit, two of them wide
+constexpr std::array<uint8_t, 10> kItfPatterns = {0x06, 0x11, 0x09, 0x18, 0x05,
+                                                  0x14, 0x0C, 0x03, 0x12, 0x0A};
+
+LinearBarcode EncodeItf(std::string_view data) {
+  LinearBarcode barcode;
+  barcode.text = std::string(data);
+  AppendWideNarrow(barcode.modules, 0x0, 4);
+  for (size_t i = 0; i + 1 < data.size(); i += 2) {
+    const uint8_t bars = kItfPatterns[data[i] - '0'];
+    const uint8_t spaces = kItfPatterns[data[i + 1] - '0'];
+    for (int element = 4; element >= 0; element--) {
+      AppendElement(barcode.modules, true, (bars >> element) & 1 ? kWide : kNarrow);
+      AppendElement(barcode.modules, false, (spaces >> element) & 1 ? kWide : kNarrow);
+    }
+  }
+  AppendElement(barcode.modules, true, kWide);
+  AppendElement(barcode.modules, false, kNarrow);
+  AppendElement(barcode.modules, true, kNarrow);
+  return barcode;
+}
+
+// Seven elements per character
+constexpr std::string_view kCodabarCharacters = "0123456789-$:/.+ABCD";
+constexpr std::array<uint8_t, 20> kCodabarPatterns = {
+    0x03, 0x06, 0x09, 0x60, 0x12, 0x42, 0x21, 0x24, 0x30, 0x48,
+    0x0C, 0x18, 0x45, 0x51, 0x54, 0x15, 0x1A, 0x29, 0x0B, 0x0E};
+
+LinearBarcode EncodeCodabar(std::string_view data) {
+  LinearBarcode barcode;
+  barcode.text = std::string(data);
+  // Printers expect start and stop characters; add A..A when they are missing
+  std::string framed = barcode.text;
+  if (framed.empty() || kCodabarCharacters.find(framed.front()) < 16) {
+    framed = "A" + framed + "A";
+  }
+  for (size_t i = 0; i < framed.size(); i++) {
+    const size_t index = kCodabarCharacters.find(framed[i]);
+    if (index == std::string_view::npos) return LinearBarcode();
+    if (i > 0) AppendElement(barcode.modules, false, kNarrow);
+    AppendWideNarrow(barcode.modules, kCodabarPatterns[index], 7);
+  }
+  return barcode;
+}
+
+// Bar and space widths of the 107 CODE128 symbols, packed as decimal digits
+constexpr std::array<uint32_t, 107> kCode128Widths = {
+    212222, 222122, 222221, 121223, 121322, 131222, 122213, 122312, 132212, 221213, 221312,
+    231212, 112232, 122132, 122231, 113222, 123122, 123221, 223211, 221132, 221231, 213212,
+    223112, 312131, 311222, 321122, 321221, 312212, 322112, 322211, 212123, 212321, 232121,
+    111323, 131123, 131321, 112313, 132113, 132311, 211313, 231113, 231311, 112133, 112331,
+    132131, 113123, 113321, 133121, 313121, 211331, 231131, 213113, 213311, 213131, 311123,
+    311321, 331121, 312113, 312311, 332111, 314111, 221411, 431111, 111224, 111422, 121124,
+    121421, 141122, 141221, 112214, 112412, 122114, 122411, 142112, 142211, 241211, 221114,
+    413111, 241112, 134111, 111242, 121142, 121241, 114212, 124112, 124211, 411212, 421112,
+    421211, 212141, 214121, 412121, 111143, 111341, 131141, 114113, 114311, 411113, 411311,
+    113141, 114131, 311141, 411131, 211412, 211214, 211232, 2331112};
+
+constexpr int kCode128StartA = 103;
+constexpr int kCode128Fnc1 = 102;
+constexpr int kCode128Stop = 106;
+// Symbol that switches to code set A, B or C
+constexpr std::array<int, 3> kCode128CodeSwitch = {101, 100, 99};
+
+void AppendCode128Symbol(std::vector<bool>& modules, int value) {
+  uint32_t widths = kCode128Widths[value];
+  char digits[8];
+  int count = 0;
+  for (; widths > 0; widths /= 10) digits[count++] = static_cast<char>(widths % 10);
+  for (int i = count - 1; i >= 0; i--) {
+    AppendElement(modules, (count - 1 - i) % 2 == 0, digits[i]);
+  }
+}
+
+// ESC/POS CODE128 data selects code sets inline: "{A", "{B" and "{C" switch,
+// "{1" is FNC1 and "{{" a literal brace. Data that does not start with a
+// code set is read as code set B, as most printers do.
+LinearBarcode EncodeCode128(std::string_view data) {
+  std::vector<int> values;
+  std::string text;
+  int codeSet = 1;
+  size_t i = 0;
+  if (data.size() >= 2 && data[0] == '{' && data[1] >= 'A' && data[1] <= 'C') {
+    codeSet = data[1] - 'A';
+    i = 2;
+  }
+  values.push_back(kCode128StartA + codeSet);
+
+  while (i < data.size()) {
+    if (data[i] == '{' && i + 1 < data.size() && data[i + 1] != '{') {
+      const char selector = data[i + 1];
+      i += 2;
+      if (selector >= 'A' && selector <= 'C') {
+        const int next = selector - 'A';
+        if (next != codeSet) {
+          values.push_back(kCode128CodeSwitch[next]);
+          codeSet = next;
+        }
+      } else if (selector == '1') {
+        values.push_back(kCode128Fnc1);
+      }
+      continue;
+    }
+    if (data[i] == '{') i++;
+
+    const int c = static_cast<uint8_t>(data[i]);
+    if (codeSet == 2) {
+      if (i + 1 >= data.size() || !IsDigits(data.substr(i, 2))) return LinearBarcode();
+      values.push_back((data[i] - '0') * 10 + (data[i + 1] - '0'));
+      text.append(data.substr(i, 2));
+      i += 2;
+      continue;
+    }
+    if (codeSet == 0 && c < 96) {
+      values.push_back(c < 32 ? c + 64 : c - 32);
+    } else if (codeSet == 1 && c >= 32 && c < 128) {
+      values.push_back(c - 32);
+    } else {
+      return LinearBarcode();
+    }
+    text.push_back(static_cast<char>(c));
+    i++;
+  }
+
+  int checksum = values[0];
+  for (size_t position = 1; position < values.size(); position++) {
+    checksum += values[position] * static_cast<int>(position);
+  }
+  values.push_back(checksum % 103);
+  values.push_back(kCode128Stop);
+
+  LinearBarcode barcode;
+  barcode.text = std::move(text);
+  for (int value : values) {
+    AppendCode128Symbol(barcode.modules, value);
+  }
+  return barcode;
+}
+
+// --- QR codes ---
+
+// Indexed by error correction level then version; from ISO/IEC 18004 table 9
+constexpr int8_t kEccCodewordsPerBlock[4][41] = {
+    {-1, 7,  10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28,
+     28, 28, 30, 30, 26, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},
+    {-1, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26, 30, 22, 22, 24, 24, 28, 28, 26, 26, 26,
+     26, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28},
+    {-1, 13, 22, 18, 26, 18, 24, 18, 22, 20, 24, 28, 26, 24, 20, 30, 24, 28, 28, 26, 30,
+     28, 30, 30, 30, 30, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},
+    {-1, 17, 28, 22, 16, 22, 28, 26, 26, 24, 28, 24, 28, 22, 24, 24, 30, 28, 28, 26, 28,
+     30, 24, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},
+};
+constexpr int8_t kErrorCorrectionBlocks[4][41] = {
+    {-1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4, 4, 4, 4, 4, 6, 6, 6, 6, 7, 8,
+     8,  9, 9, 10, 12, 12, 12, 13, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 24, 25},
+    {-1, 1,  1,  1,  2,  2,  4,  4,  4,  5,  5,  5,  8,  9,  9,  10, 10, 11, 13, 14, 16,
+     17, 17, 18, 20, 21, 23, 25, 26, 28, 29, 31, 33, 35, 37, 38, 40, 43, 45, 47, 49},
+    {-1, 1,  1,  2,  2,  4,  4,  6,  6,  8,  8,  8,  10, 12, 16, 12, 17, 16, 18, 21, 20,
+     23, 23, 25, 27, 29, 34, 34, 35, 38, 40, 43, 45, 48, 51, 53, 56, 59, 62, 65, 68},
+    {-1, 1,  1,  2,  4,  4,  4,  5,  6,  8,  8,  11, 11, 16, 16, 18, 16, 19, 21, 25, 25,
+     25, 34, 30, 32, 35, 37, 40, 42, 45, 48, 51, 54, 57, 60, 63, 66, 70, 74, 77, 81},
+};
+// Format information value of each level
+constexpr std::array<int, 4> kFormatLevelBits = {1, 0, 3, 2};
+
+int RawDataModules(int version) {
+  int modules = (16 * version + 128) * version + 64;
+  if (version >= 2) {
+    const int alignments = version / 7 + 2;
+    modules -= (25 * alignments - 10) * alignments - 55;
+    if (version >= 7) modules -= 36;
+  }
+  return modules;
+}
+
+int DataCodewords(int version, int level) {
+  return RawDataModules(version) / 8 -
+         kEccCodewordsPerBlock[level][version] * kErrorCorrectionBlocks[level][version];
+}
+
+uint8_t GfMultiply(uint8_t x, uint8_t y) {
+  int z = 0;
+  for (int i = 7; i >= 0; i--) {
+    z = (z << 1) ^ ((z >> 7) * 0x11D);
+    z ^= ((y >> i) & 1) * x;
+  }
+  return static_cast<uint8_t>(z);
+}
+
+std::vector<uint8_t> ReedSolomonDivisor(int degree) {
+  std::vector<uint8_t> result(static_cast<size_t>(degree), 0);
+  result.back() = 1;
+  uint8_t root = 1;
+  for (int i = 0; i < degree; i++) {
+    for (size_t j = 0; j < result.size(); j++) {
+      result[j] = GfMultiply(result[j], root);
+      if (j + 1 < result.size()) result[j] ^= result[j + 1];
+    }
+    root = GfMultiply(root, 0x02);
+  }
+  return result;
+}
+
+std::vector<uint8_t> ReedSolomonRemainder(const uint8_t* data, size_t size,
+                                          const std::vector<uint8_t>& divisor) {
+  std::vector<uint8_t> result(divisor.size(), 0);
+  for (size_t i = 0; i < size; i++) {
+    const uint8_t factor = data[i] ^ result[0];
+    result.erase(result.begin());
+    result.push_back(0);
+    for (size_t j = 0; j < result.size(); j++) {
+      result[j] ^= GfMultiply(divisor[j], factor);
+    }
+  }
+  return result;
+}
+
+class QrBuilder {
+public:
+  QrBuilder(int version, int level)
+      : version_(version),
+        level_(level),
+        size_(version * 4 + 17),
+        modules_(static_cast<size_t>(size_) * size_, 0),
+        isFunction_(modules_.size(), 0) {}
+
+  void DrawFunctionPatterns() {
+    for (int i = 0; i < size_; i++) {
+      SetFunction(6, i, i % 2 == 0);
+      SetFunction(i, 6, i % 2 == 0);
+    }
+    DrawFinder(3, 3);
+    DrawFinder(size_ - 4, 3);
+    DrawFinder(3, size_ - 4);
+
+    const std::vector<int> positions = AlignmentPositions();
+    const size_t count = positions.size();
+    for (size_t i = 0; i < count; i++) {
+      for (size_t j = 0; j < count; j++) {
+        // The three corners hold finder patterns
+        if ((i == 0 && j == 0) || (i == 0 && j == count - 1) || (i == count - 1 && j == 0)) {
+          continue;
+        }
+        DrawAlignment(positions[i], positions[j]);
+      }
+    }
+
+    // Reserve the format areas; they are written once the mask is chosen
+    DrawFormatBits(0);
+    DrawVersion();
+  }
+
+  void DrawCodewords(const std::vector<uint8_t>& codewords) {
+    size_t bit = 0;
+    const size_t totalBits = codewords.size() * 8;
+    for (int right = size_ - 1; right >= 1; right -= 2) {
+      if (right == 6) right = 5;
+      for (int vertical = 0; vertical < size_; vertical++) {
+        for (int j = 0; j < 2; j++) {
+          const int x = right - j;
+          const bool upward = ((right + 1) & 2) == 0;
+          const int y = upward ? size_ - 1 - vertical : vertical;
+          if (!isFunction_[Index(x, y)] && bit < totalBits) {
+            modules_[Index(x, y)] = (codewords[bit >> 3] >> (7 - (bit & 7))) & 1;
+            bit++;
+          }
+        }
+      }
+    }
+  }
+
+  // Applying the same mask twice undoes it
+  void ApplyMask(int mask) {
+    for (int y = 0; y < size_; y++) {
+      for (int x = 0; x < size_; x++) {
+        bool invert = false;
+        switch (mask) {
+          case 0: invert = (x + y) % 2 == 0; break;
+          case 1: invert = y % 2 == 0; break;
+          case 2: invert = x % 3 == 0; break;
+          case 3: invert = (x + y) % 3 == 0; break;
+          case 4: invert = (x / 3 + y / 2) % 2 == 0; break;
+          case 5: invert = x * y % 2 + x * y % 3 == 0; break;
+          case 6: invert = (x * y % 2 + x * y % 3) % 2 == 0; break;
+          default: invert = ((x + y) % 2 + x * y % 3) % 2 == 0; break;
+        }
+        if (invert && !isFunction_[Index(x, y)]) {
+          modules_[Index(x, y)] ^= 1;
+        }
+      }
+    }
+  }
+
+  void DrawFormatBits(int mask) {
+    const int data = kFormatLevelBits[level_] << 3 | mask;
+    int remainder = data;
+    for (int i = 0; i < 10; i++) {
+      remainder = (remainder << 1) ^ ((remainder >> 9) * 0x537);
+    }
+    const int bits = (data << 10 | remainder) ^ 0x5412;
+
+    for (int i = 0; i <= 5; i++) SetFunction(8, i, Bit(bits, i));
+    SetFunction(8, 7, Bit(bits, 6));
+    SetFunction(8, 8, Bit(bits, 7));
+    SetFunction(7, 8, Bit(bits, 8));
+    for (int i = 9; i < 15; i++) SetFunction(14 - i, 8, Bit(bits, i));
+
+    for (int i = 0; i < 8; i++) SetFunction(size_ - 1 - i, 8, Bit(bits, i));
+    for (int i = 8; i < 15; i++) SetFunction(8, size_ - 15 + i, Bit(bits, i));
+    SetFunction(8, size_ - 8, true);
+  }
+
+  // Score from ISO/IEC 18004 section 7.8.3; lower is better
+  int Penalty() const {
+    int penalty = 0;
+    for (int a = 0; a < size_; a++) {
+      int runRows = 0;
+      int runColumns = 0;
+      for (int b = 0; b < size_; b++) {
+        runRows = b > 0 && Get(b, a) == Get(b - 1, a) ? runRows + 1 : 1;
+        if (runRows == 5) penalty += 3;
+        if (runRows > 5) penalty++;
+        runColumns = b > 0 && Get(a, b) == Get(a, b - 1) ? runColumns + 1 : 1;
+        if (runColumns == 5) penalty += 3;
+        if (runColumns > 5) penalty++;
+
+        // 1:1:3:1:1 finder-like pattern with four light modules on one side
+        if (b + 10 < size_) {
+          if (MatchesFinderLike(b, a, 1, 0)) penalty += 40;
+          if (MatchesFinderLike(a, b, 0, 1)) penalty += 40;
+        }
+      }
+    }
+
+    int dark = 0;
+    for (int y = 0; y < size_; y++) {
+      for (int x = 0; x < size_; x++) {
+        if (Get(x, y)) dark++;
+        if (x + 1 < size_ && y + 1 < size_) {
+          const bool color = Get(x, y);
+          if (color == Get(x + 1, y) && color == Get(x, y + 1) && color == Get(x + 1, y + 1)) {
+            penalty += 3;
+          }
+        }
+      }
+    }
+    const int total = size_ * size_;
+    const int k = (std::abs(dark * 20 - total * 10) + total - 1) / total - 1;
+    return penalty + k * 10;
+  }
+
+  QrCode Finish(int mask) {
+    QrCode code;
+    code.size = size_;
+    code.version = version_;
+    code.mask = mask;
+    code.modules = std::move(modules_);
+    return code;
+  }
+
+private:
+  size_t Index(int x, int y) const { return static_cast<size_t>(y) * size_ + x; }
+  bool Get(int x, int y) const { return modules_[Index(x, y)] != 0; }
+  static bool Bit(int value, int index) { return ((value >> index) & 1) != 0; }
+
+  void SetFunction(int x, int y, bool dark) {
+    modules_[Index(x, y)] = dark ? 1 : 0;
+    isFunction_[Index(x, y)] = 1;
+  }
+
+  void DrawFinder(int x, int y) {
+    for (int dy = -4; dy <= 4; dy++) {
+      for (int dx = -4; dx <= 4; dx++) {
+        const int distance = std::abs(dx) > std::abs(dy) ? std::abs(dx) : std::abs(dy);
+        const int xx = x + dx;
+        const int yy = y + dy;
+        if (xx >= 0 && xx < size_ && yy >= 0 && yy < size_) {
+          SetFunction(xx, yy, distance != 2 && distance != 4);
+        }
+      }
+    }
+  }
+
+  void DrawAlignment(int x, int y) {
+    for (int dy = -2; dy <= 2; dy++) {
+      for (int dx = -2; dx <= 2; dx++) {
+        const int distance = std::abs(dx) > std::abs(dy) ? std::abs(dx) : std::abs(dy);
+        SetFunction(x + dx, y + dy, distance != 1);
+      }
+    }
+  }
+
+  void DrawVersion() {
+    if (version_ < 7) return;
+    int remainder = version_;
+    for (int i = 0; i < 12; i++) {
+      remainder = (remainder << 1) ^ ((remainder >> 11) * 0x1F25);
+    }
+    const int bits = version_ << 12 | remainder;
+    for (int i = 0; i < 18; i++) {
+      const bool bit = Bit(bits, i);
+      const int a = size_ - 11 + i % 3;
+      const int b = i / 3;
+      SetFunction(a, b, bit);
+      SetFunction(b, a, bit);
+    }
+  }
+
+  std::vector<int> AlignmentPositions() const {
+    if (version_ == 1) return {};
+    const int count = version_ / 7 + 2;
+    const int step = version_ == 32 ? 26 : (version_ * 4 + count * 2 + 1) / (count * 2 - 2) * 2;
+    std::vector<int> positions(static_cast<size_t>(count));
+    positions[0] = 6;
+    for (int i = count - 1, position = size_ - 7; i >= 1; i--, position -= step) {
+      positions[static_cast<size_t>(i)] = position;
+    }
+    return positions;
+  }
+
+  bool MatchesFinderLike(int x, int y, int dx, int dy) const {
+    static constexpr std::array<bool, 11> kPattern = {true, false, true, true,  true, false,
+                                                      true, false, false, false, false};
+    bool forward = true;
+    bool backward = true;
+    for (int i = 0; i < 11; i++) {
+      const bool dark = Get(x + dx * i, y + dy * i);
+      forward = forward && dark == kPattern[static_cast<size_t>(i)];
+      backward = backward && dark == kPattern[static_cast<size_t>(10 - i)];
+    }
+    return forward || backward;
+  }
+
+  const int version_;
+  const int level_;
+  const int size_;
+  std::vector<uint8_t> modules_;
+  std::vector<uint8_t> isFunction_;
+};
+
+}  // namespace
+
+LinearBarcode EncodeLinearBarcode(EscPosBarcodeType type, std::string_view data) {
+  if (!EscPosEncoder::IsValidBarcodeData(type, data)) {
+    return LinearBarcode();
+  }
+  switch (type) {
+    case EscPosBarcodeType::kUpcA: {
+      // UPC-A is an EAN-13 with a leading zero that is not printed
+      LinearBarcode barcode = EncodeEan13("0" + std::string(data.substr(0, 11)));
+      barcode.text.erase(0, 1);
+      return barcode;
+    }
+    case EscPosBarcodeType::kEan13:
+      return EncodeEan13(std::string(data.substr(0, 12)));
+    case EscPosBarcodeType::kEan8:
+      return EncodeEan8(data);
+    case EscPosBarcodeType::kCode39:
+      return EncodeCode39(data);
+    case EscPosBarcodeType::kItf:
+      return EncodeItf(data);
+    case EscPosBarcodeType::kCodabar:
+      return EncodeCodabar(data);
+    case EscPosBarcodeType::kCode128:
+      return EncodeCode128(data);
+    case EscPosBarcodeType::kUpcE:
+    case EscPosBarcodeType::kCode93:
+      break;
+  }
+  return LinearBarcode();
+}
+
+QrCode EncodeQrCode(std::string_view data, QrErrorCorrection level, int mask) {
+  const int levelIndex = static_cast<int>(level);
+  int version = 1;
+  for (; version <= 40; version++) {
+    const int countBits = version <= 9 ? 8 : 16;
+    const size_t neededBits = 4 + countBits + data.size() * 8;
+    if (data.size() < (size_t{1} << countBits) &&
+        neededBits <= static_cast<size_t>(DataCodewords(version, levelIndex)) * 8) {
+      break;
+    }
+  }
+  if (version > 40) return QrCode();
+
+  // Byte mode segment, terminator and padding
+  const size_t capacity = static_cast<size_t>(DataCodewords(version, levelIndex));
+  std::vector<uint8_t> codewords;
+  codewords.reserve(capacity);
+  uint32_t buffer = 0;
+  int bufferBits = 0;
+  auto appendBits = [&](uint32_t value, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+      buffer = (buffer << 1) | ((value >> i) & 1);
+      if (++bufferBits == 8) {
+        codewords.push_back(static_cast<uint8_t>(buffer));
+        buffer = 0;
+        bufferBits = 0;
+      }
+    }
+  };
+  appendBits(0x4, 4);
+  appendBits(static_cast<uint32_t>(data.size()), version <= 9 ? 8 : 16);
+  for (char c : data) {
+    appendBits(static_cast<uint8_t>(c), 8);
+  }
+  const size_t usedBits = codewords.size() * 8 + static_cast<size_t>(bufferBits);
+  const size_t terminator = capacity * 8 - usedBits < 4 ? capacity * 8 - usedBits : 4;
+  appendBits(0, static_cast<int>(terminator));
+  if (bufferBits > 0) appendBits(0, 8 - bufferBits);
+  for (uint8_t pad = 0xEC; codewords.size() < capacity; pad ^= 0xEC ^ 0x11) {
+    codewords.push_back(pad);
+  }
+
+  // Split into blocks, add error correction and interleave
+  const int blocks = kErrorCorrectionBlocks[levelIndex][version];
+  const int eccLength = kEccCodewordsPerBlock[levelIndex][version];
+  const int rawCodewords = RawDataModules(version) / 8;
+  const int shortBlocks = blocks - rawCodewords % blocks;
+  const int shortBlockLength = rawCodewords / blocks;
+  const std::vector<uint8_t> divisor = ReedSolomonDivisor(eccLength);
+  std::vector<std::vector<uint8_t>> blockData;
+  size_t offset = 0;
+  for (int i = 0; i < blocks; i++) {
+    const size_t length = static_cast<size_t>(shortBlockLength - eccLength + (i < shortBlocks ? 0 : 1));
+    std::vector<uint8_t> block(codewords.begin() + offset, codewords.begin() + offset + length);
+    std::vector<uint8_t> ecc = ReedSolomonRemainder(block.data(), block.size(), divisor);
+    offset += length;
+    // Padding so all blocks line up; skipped when interleaving
+    if (i < shortBlocks) block.push_back(0);
+    block.insert(block.end(), ecc.begin(), ecc.end());
+    blockData.push_back(std::move(block));
+  }
+  std::vector<uint8_t> interleaved;
+  interleaved.reserve(static_cast<size_t>(rawCodewords));
+  for (size_t i = 0; i < blockData[0].size(); i++) {
+    for (size_t j = 0; j < blockData.size(); j++) {
+      if (i != static_cast<size_t>(shortBlockLength - eccLength) || j >= static_cast<size_t>(shortBlocks)) {
+        interleaved.push_back(blockData[j][i]);
+      }
+    }
+  }
+
+  QrBuilder builder(version, levelIndex);
+  builder.DrawFunctionPatterns();
+  builder.DrawCodewords(interleaved);
+  if (mask < 0 || mask > 7) {
+    int lowest = 0;
+    for (int candidate = 0; candidate < 8; candidate++) {
+      builder.ApplyMask(candidate);
+      builder.DrawFormatBits(candidate);
+      const int penalty = builder.Penalty();
+      if (candidate == 0 || penalty < lowest) {
+        lowest = penalty;
+        mask = candidate;
+      }
+      builder.ApplyMask(candidate);
+    }
+  }
+  builder.ApplyMask(mask);
+  builder.DrawFormatBits(mask);
+  return builder.Finish(mask);
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,50 @@
+#ifndef FLUTTER_PLUGIN_ESC_POS_SYMBOLS_H_
+#define FLUTTER_PLUGIN_ESC_POS_SYMBOLS_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+
+namespace windows_printer {
+
+struct LinearBarcode {
+  /// One entry per module, left to right; true is a bar. Wide elements of
+  /// two-width symbologies are three modules.
+  std::vector<bool> modules;
+  /// Human readable interpretation, including any computed check digit
+  std::string text;
+};
+
+/// Module pattern of a 1D barcode as a printer would print it from GS k data.
+/// Returns no modules if data is not valid for type; UPC-E and CODE93 are
+/// not supported.
+LinearBarcode EncodeLinearBarcode(EscPosBarcodeType type, std::string_view data);
+
+enum class QrErrorCorrection {
+  kLow = 0,
+  kMedium,
+  kQuartile,
+  kHigh,
+};
+
+struct QrCode {
+  /// Modules per side; 0 if the data does not fit in version 40
+  int size = 0;
+  int version = 0;
+  int mask = 0;
+  /// Row-major, 1 is a dark module
+  std::vector<uint8_t> modules;
+
+  bool Module(int x, int y) const { return modules[static_cast<size_t>(y) * size + x] != 0; }
+};
+
+/// Encode data in byte mode at the smallest version that fits. mask selects
+/// a mask pattern 0-7; -1 picks the one with the lowest penalty score.
+QrCode EncodeQrCode(std::string_view data, QrErrorCorrection level, int mask = -1);
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_ESC_POS_SYMBOLS_H_
@@ -0,0 +1,37 @@
+#ifndef FLUTTER_PLUGIN_FFI_RUNTIME_H_
+#define FLUTTER_PLUGIN_FFI_RUNTIME_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "job_tracker.h"
+#include "print_budget.h"
+#include "raw_print_stream.h"
+#include "spooler_backend.h"
+
+namespace windows_printer {
+
+/// Receives the events of every stream opened through
+/// WindowsPrinterStreamOpen, on the stream's writer thread. Must not block
+/// or install a runtime.
+using FfiStreamListener =
+    std::function<void(uint32_t streamId, const PrintStreamEvent& event)>;
+
+/// Backend and tracker behind the exported WindowsPrinter* functions of
+/// include/windows_printer/windows_printer_ffi.h. The plugin installs the
+/// Win32 spooler and its own tracker, so jobs submitted through FFI appear on
+/// jobEvents too; tests install an InMemorySpooler. Null pointers uninstall
+/// them, after which calls fail with WINDOWS_PRINTER_FFI_NOT_READY. Calls in
+/// progress and open streams keep their own references. Stream events go to
+/// whichever streamListener is installed when they happen; installing waits
+/// for a listener call in progress. Submitted data is charged to budget,
+/// when there is one.
+void InstallFfiRuntime(std::shared_ptr<SpoolerBackend> backend,
+                       std::shared_ptr<JobTracker> tracker,
+                       FfiStreamListener streamListener = nullptr,
+                       std::shared_ptr<PrintBudget> budget = nullptr);
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_FFI_RUNTIME_H_
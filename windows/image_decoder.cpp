@@ -0,0 +1,1404 @@
+#include "image_decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace windows_printer {
+
+namespace {
+
+// Interlaced PNGs are gathered into a gray plane of at most this many bytes
+constexpr size_t kMaxInterlacedPlane = 64 << 20;
+
+uint32_t ReadBigEndian32(const uint8_t* bytes) {
+  return static_cast<uint32_t>(bytes[0]) << 24 | static_cast<uint32_t>(bytes[1]) << 16 |
+         static_cast<uint32_t>(bytes[2]) << 8 | bytes[3];
+}
+
+uint16_t ReadBigEndian16(const uint8_t* bytes) {
+  return static_cast<uint16_t>(bytes[0] << 8 | bytes[1]);
+}
+
+// Rec. 601 weights in 1/65536, as the ESC/POS image threshold uses
+uint8_t Luminance(int r, int g, int b) {
+  return static_cast<uint8_t>((19595 * r + 38470 * g + 7471 * b + 32768) >> 16);
+}
+
+// Gray seen through alpha on white paper
+uint8_t OnWhite(int gray, int alpha) {
+  return static_cast<uint8_t>(255 - ((255 - gray) * alpha + 127) / 255);
+}
+
+bool Fail(std::string* error, const char* message) {
+  if (error) *error = message;
+  return false;
+}
+
+// --- Inflate ---
+
+// Codes up to this long are decoded with one table lookup
+constexpr int kInflateFastBits = 9;
+constexpr size_t kInflateWindow = 32768;
+constexpr int kMaxMatchLength = 258;
+
+constexpr std::array<uint16_t, 29> kLengthBase = {3,  4,  5,  6,  7,  8,  9,  10,  11,  13,
+                                                  15, 17, 19, 23, 27, 31, 35, 43,  51,  59,
+                                                  67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::array<uint8_t, 29> kLengthExtraBits = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr std::array<uint16_t, 30> kDistanceBase = {
+    1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr std::array<uint8_t, 30> kDistanceExtraBits = {0, 0, 0, 0, 1, 1, 2,  2,  3,  3,
+                                                        4, 4, 5, 5, 6, 6, 7,  7,  8,  8,
+                                                        9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr std::array<uint8_t, 19> kCodeLengthOrder = {16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                                      11, 4,  12, 3, 13, 2, 14, 1, 15};
+
+// Canonical Huffman code of a deflate block
+struct InflateTable {
+  // Indexed by the next kInflateFastBits input bits: length << 9 | symbol,
+  // 0 for longer codes
+  std::array<uint16_t, 1 << kInflateFastBits> fast{};
+  std::array<uint16_t, 16> counts{};
+  // Symbols ordered by code
+  std::array<uint16_t, 288> symbols{};
+};
+
+// Incomplete codes are allowed, as deflate uses them for a single distance
+bool BuildInflateTable(InflateTable& table, const uint8_t* lengths, int count) {
+  table.fast.fill(0);
+  table.counts.fill(0);
+  for (int i = 0; i < count; i++) {
+    table.counts[lengths[i]]++;
+  }
+  table.counts[0] = 0;
+  int left = 1;
+  for (int length = 1; length < 16; length++) {
+    left = (left << 1) - table.counts[length];
+    if (left < 0) return false;
+  }
+
+  std::array<uint16_t, 16> offsets{};
+  for (int length = 1; length < 15; length++) {
+    offsets[length + 1] = static_cast<uint16_t>(offsets[length] + table.counts[length]);
+  }
+  for (int i = 0; i < count; i++) {
+    if (lengths[i] != 0) {
+      table.symbols[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+    }
+  }
+
+  // Codes arrive most significant bit first, so the table is indexed by the
+  // code reversed
+  int code = 0;
+  int index = 0;
+  for (int length = 1; length <= kInflateFastBits; length++) {
+    for (int i = 0; i < table.counts[length]; i++, code++) {
+      int reversed = 0;
+      for (int bit = 0; bit < length; bit++) {
+        reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+      }
+      const uint16_t entry = static_cast<uint16_t>(length << 9 | table.symbols[index++]);
+      for (int fill = reversed; fill < (1 << kInflateFastBits); fill += 1 << length) {
+        table.fast[fill] = entry;
+      }
+    }
+    code <<= 1;
+  }
+  return true;
+}
+
+const InflateTable& FixedLiteralTable() {
+  static const InflateTable table = []() {
+    std::array<uint8_t, 288> lengths{};
+    std::fill(lengths.begin(), lengths.begin() + 144, 8);
+    std::fill(lengths.begin() + 144, lengths.begin() + 256, 9);
+    std::fill(lengths.begin() + 256, lengths.begin() + 280, 7);
+    std::fill(lengths.begin() + 280, lengths.end(), 8);
+    InflateTable built;
+    BuildInflateTable(built, lengths.data(), static_cast<int>(lengths.size()));
+    return built;
+  }();
+  return table;
+}
+
+const InflateTable& FixedDistanceTable() {
+  static const InflateTable table = []() {
+    std::array<uint8_t, 30> lengths{};
+    lengths.fill(5);
+    InflateTable built;
+    BuildInflateTable(built, lengths.data(), static_cast<int>(lengths.size()));
+    return built;
+  }();
+  return table;
+}
+
+// Inflates a zlib stream's deflate data, handing the output over in chunks
+// and keeping only the window that matches refer back into
+class Inflater {
+public:
+  // write returns false once it needs no more output
+  using Writer = std::function<bool(const uint8_t* data, size_t size)>;
+
+  Inflater(const uint8_t* data, size_t size, Writer write)
+      : data_(data), size_(size), write_(std::move(write)), window_(kInflateWindow * 4) {}
+
+  bool Inflate(std::string* error) {
+    bool last = false;
+    while (!last && !stopped_) {
+      last = Bits(1) != 0;
+      const uint32_t type = Bits(2);
+      bool ok;
+      if (type == 0) {
+        ok = Stored(error);
+      } else if (type == 1) {
+        ok = Compressed(FixedLiteralTable(), FixedDistanceTable(), error);
+      } else if (type == 2) {
+        ok = Dynamic(error);
+      } else {
+        ok = Fail(error, "Corrupt PNG data");
+      }
+      if (!ok) return false;
+      if (Truncated()) return Fail(error, "Truncated PNG data");
+    }
+    if (!stopped_) Flush();
+    return true;
+  }
+
+private:
+  bool Truncated() const {
+    return (position_ + overrun_) * 8 - static_cast<size_t>(count_) > size_ * 8;
+  }
+
+  // Past the end the input reads as zeros; Truncated tells
+  void Refill() {
+    while (count_ <= 56) {
+      uint64_t byte = 0;
+      if (position_ < size_) {
+        byte = data_[position_++];
+      } else {
+        overrun_++;
+      }
+      bits_ |= byte << count_;
+      count_ += 8;
+    }
+  }
+
+  uint32_t Bits(int count) {
+    if (count_ < count) Refill();
+    const uint32_t value = static_cast<uint32_t>(bits_ & ((uint64_t{1} << count) - 1));
+    bits_ >>= count;
+    count_ -= count;
+    return value;
+  }
+
+  int Decode(const InflateTable& table) {
+    if (count_ < 16) Refill();
+    const uint16_t entry = table.fast[bits_ & ((1 << kInflateFastBits) - 1)];
+    if (entry != 0) {
+      const int length = entry >> 9;
+      bits_ >>= length;
+      count_ -= length;
+      return entry & 0x1FF;
+    }
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int length = 1; length < 16; length++) {
+      code |= static_cast<int>((bits_ >> (length - 1)) & 1);
+      const int count = table.counts[length];
+      if (code - first < count) {
+        bits_ >>= length;
+        count_ -= length;
+        return table.symbols[index + code - first];
+      }
+      index += count;
+      first = (first + count) << 1;
+      code <<= 1;
+    }
+    return -1;
+  }
+
+  // Hand over the output not yet written
+  void Flush() {
+    if (end_ > flushed_ && !write_(window_.data() + flushed_, end_ - flushed_)) {
+      stopped_ = true;
+    }
+    flushed_ = end_;
+  }
+
+  // Make room for at least kMaxMatchLength bytes, keeping the window
+  void Slide() {
+    Flush();
+    std::memmove(window_.data(), window_.data() + end_ - kInflateWindow, kInflateWindow);
+    end_ = kInflateWindow;
+    flushed_ = end_;
+  }
+
+  bool Stored(std::string* error) {
+    Bits(count_ % 8);
+    const uint32_t length = Bits(16);
+    if ((length ^ 0xFFFF) != Bits(16)) return Fail(error, "Corrupt PNG data");
+    size_t remaining = length;
+    while (remaining > 0 && count_ >= 8) {
+      if (end_ == window_.size()) Slide();
+      window_[end_++] = static_cast<uint8_t>(Bits(8));
+      remaining--;
+    }
+    // The bit buffer is empty here unless it ran past the end
+    if (remaining > 0 && (overrun_ > 0 || size_ - position_ < remaining)) {
+      return Fail(error, "Truncated PNG data");
+    }
+    while (remaining > 0 && !stopped_) {
+      if (end_ == window_.size()) Slide();
+      const size_t chunk = std::min(remaining, window_.size() - end_);
+      std::memcpy(window_.data() + end_, data_ + position_, chunk);
+      end_ += chunk;
+      position_ += chunk;
+      remaining -= chunk;
+    }
+    total_ += length;
+    return true;
+  }
+
+  bool Dynamic(std::string* error) {
+    const int literals = static_cast<int>(Bits(5)) + 257;
+    const int distances = static_cast<int>(Bits(5)) + 1;
+    const int codeLengths = static_cast<int>(Bits(4)) + 4;
+    if (literals > 286 || distances > 30) return Fail(error, "Corrupt PNG data");
+
+    std::array<uint8_t, 19> lengthLengths{};
+    for (int i = 0; i < codeLengths; i++) {
+      lengthLengths[kCodeLengthOrder[i]] = static_cast<uint8_t>(Bits(3));
+    }
+    InflateTable lengthTable;
+    if (!BuildInflateTable(lengthTable, lengthLengths.data(), 19)) {
+      return Fail(error, "Corrupt PNG data");
+    }
+
+    std::array<uint8_t, 286 + 30> lengths{};
+    int count = 0;
+    while (count < literals + distances) {
+      const int symbol = Decode(lengthTable);
+      if (symbol < 0) return Fail(error, "Corrupt PNG data");
+      if (symbol < 16) {
+        lengths[count++] = static_cast<uint8_t>(symbol);
+        continue;
+      }
+      uint8_t value = 0;
+      int repeat;
+      if (symbol == 16) {
+        if (count == 0) return Fail(error, "Corrupt PNG data");
+        value = lengths[count - 1];
+        repeat = 3 + static_cast<int>(Bits(2));
+      } else if (symbol == 17) {
+        repeat = 3 + static_cast<int>(Bits(3));
+      } else {
+        repeat = 11 + static_cast<int>(Bits(7));
+      }
+      if (count + repeat > literals + distances) return Fail(error, "Corrupt PNG data");
+      std::fill(lengths.begin() + count, lengths.begin() + count + repeat, value);
+      count += repeat;
+    }
+    if (lengths[256] == 0) return Fail(error, "Corrupt PNG data");
+
+    InflateTable literalTable;
+    InflateTable distanceTable;
+    if (!BuildInflateTable(literalTable, lengths.data(), literals) ||
+        !BuildInflateTable(distanceTable, lengths.data() + literals, distances)) {
+      return Fail(error, "Corrupt PNG data");
+    }
+    return Compressed(literalTable, distanceTable, error);
+  }
+
+  bool Compressed(const InflateTable& literalTable, const InflateTable& distanceTable,
+                  std::string* error) {
+    while (!stopped_) {
+      int symbol = Decode(literalTable);
+      if (symbol < 256) {
+        if (symbol < 0) return Fail(error, "Corrupt PNG data");
+        if (end_ == window_.size()) Slide();
+        window_[end_++] = static_cast<uint8_t>(symbol);
+        total_++;
+        continue;
+      }
+      if (symbol == 256) return true;
+
+      symbol -= 257;
+      if (symbol >= 29) return Fail(error, "Corrupt PNG data");
+      const int length = kLengthBase[symbol] + static_cast<int>(Bits(kLengthExtraBits[symbol]));
+      const int distanceSymbol = Decode(distanceTable);
+      if (distanceSymbol < 0 || distanceSymbol >= 30) return Fail(error, "Corrupt PNG data");
+      const size_t distance =
+          kDistanceBase[distanceSymbol] + Bits(kDistanceExtraBits[distanceSymbol]);
+      if (distance > total_) return Fail(error, "Corrupt PNG data");
+      if (Truncated()) return Fail(error, "Truncated PNG data");
+
+      if (end_ + kMaxMatchLength > window_.size()) Slide();
+      // Byte by byte: the source may overlap the bytes being written
+      uint8_t* out = window_.data() + end_;
+      const uint8_t* from = out - distance;
+      for (int i = 0; i < length; i++) {
+        out[i] = from[i];
+      }
+      end_ += length;
+      total_ += length;
+    }
+    return true;
+  }
+
+  const uint8_t* data_;
+  size_t size_;
+  Writer write_;
+  size_t position_ = 0;
+  // Zero bytes read past the end
+  size_t overrun_ = 0;
+  uint64_t bits_ = 0;
+  int count_ = 0;
+
+  std::vector<uint8_t> window_;
+  size_t end_ = 0;
+  size_t flushed_ = 0;
+  uint64_t total_ = 0;
+  bool stopped_ = false;
+};
+
+// --- PNG ---
+
+constexpr uint8_t kPngSignature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+
+struct PngPass {
+  int x;
+  int y;
+  int stepX;
+  int stepY;
+};
+
+constexpr std::array<PngPass, 7> kAdam7 = {{
+    {0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4},
+    {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2},
+}};
+
+class PngDecoder {
+public:
+  PngDecoder(const uint8_t* data, size_t size, GrayRowSink& sink, std::string* error)
+      : data_(data), size_(size), sink_(sink), error_(error) {}
+
+  bool Decode() {
+    if (!ReadChunks()) return false;
+    if (!sink_.Begin(width_, height_)) return Fail(error_, "Image refused");
+
+    const uint8_t* stream = idat_.empty() ? compressed_.data() : idat_.data();
+    const size_t streamSize = idat_.empty() ? compressed_.size() : idat_.size();
+    if (streamSize < 2 || (stream[0] & 0x0F) != 8 || (stream[0] << 8 | stream[1]) % 31 != 0 ||
+        (stream[1] & 0x20) != 0) {
+      return Fail(error_, "Corrupt PNG data");
+    }
+
+    const int bitsPerPixel = depth_ * Channels();
+    filterBytes_ = std::max(1, bitsPerPixel / 8);
+    gray_.resize(width_);
+    if (interlaced_) {
+      const size_t planeSize = static_cast<size_t>(width_) * height_;
+      if (planeSize > kMaxInterlacedPlane) return Fail(error_, "Interlaced PNG is too large");
+      plane_.assign(planeSize, 255);
+      pass_ = -1;
+    } else {
+      pass_ = 0;
+      passWidth_ = width_;
+      passHeight_ = height_;
+    }
+    rowBytes_ = 0;
+    if (!NextPass()) return FinishPlane();
+
+    Inflater inflater(stream + 2, streamSize - 2, [this](const uint8_t* bytes, size_t count) {
+      return Write(bytes, count);
+    });
+    if (!inflater.Inflate(error_)) return false;
+    if (failed_) return Fail(error_, "Corrupt PNG data");
+    if (pass_ < static_cast<int>(interlaced_ ? kAdam7.size() : 1)) {
+      return Fail(error_, "Truncated PNG data");
+    }
+    return FinishPlane();
+  }
+
+private:
+  int Channels() const {
+    switch (colorType_) {
+      case 2:
+        return 3;
+      case 4:
+        return 2;
+      case 6:
+        return 4;
+      default:
+        return 1;
+    }
+  }
+
+  bool ReadChunks() {
+    bool haveHeader = false;
+    bool haveEnd = false;
+    size_t idatChunks = 0;
+    size_t position = sizeof(kPngSignature);
+    while (!haveEnd) {
+      if (size_ - position < 12) return Fail(error_, "Truncated PNG data");
+      const uint32_t length = ReadBigEndian32(data_ + position);
+      const uint8_t* type = data_ + position + 4;
+      const uint8_t* chunk = data_ + position + 8;
+      if (length > size_ - position - 12) return Fail(error_, "Truncated PNG data");
+      position += 12 + static_cast<size_t>(length);
+
+      if (std::memcmp(type, "IHDR", 4) == 0) {
+        if (length != 13) return Fail(error_, "Corrupt PNG header");
+        const uint32_t width = ReadBigEndian32(chunk);
+        const uint32_t height = ReadBigEndian32(chunk + 4);
+        depth_ = chunk[8];
+        colorType_ = chunk[9];
+        interlaced_ = chunk[12] == 1;
+        if (width == 0 || height == 0 || chunk[10] != 0 || chunk[11] != 0 || chunk[12] > 1) {
+          return Fail(error_, "Corrupt PNG header");
+        }
+        if (width > kMaxImageDimension || height > kMaxImageDimension) {
+          return Fail(error_, "Image is too large");
+        }
+        width_ = static_cast<int>(width);
+        height_ = static_cast<int>(height);
+        if (!ValidDepth()) return Fail(error_, "Unsupported PNG format");
+        haveHeader = true;
+      } else if (!haveHeader) {
+        return Fail(error_, "Corrupt PNG header");
+      } else if (std::memcmp(type, "PLTE", 4) == 0) {
+        if (length % 3 != 0 || length > 768) return Fail(error_, "Corrupt PNG palette");
+        paletteSize_ = static_cast<int>(length / 3);
+        for (int i = 0; i < paletteSize_; i++) {
+          palette_[i] = Luminance(chunk[i * 3], chunk[i * 3 + 1], chunk[i * 3 + 2]);
+        }
+      } else if (std::memcmp(type, "tRNS", 4) == 0) {
+        if (colorType_ == 3) {
+          const size_t count = std::min<size_t>(length, 256);
+          for (size_t i = 0; i < count; i++) {
+            alpha_[i] = chunk[i];
+          }
+        } else if (colorType_ == 0 && length >= 2) {
+          hasKey_ = true;
+          key_[0] = ReadBigEndian16(chunk);
+        } else if (colorType_ == 2 && length >= 6) {
+          hasKey_ = true;
+          for (int i = 0; i < 3; i++) {
+            key_[i] = ReadBigEndian16(chunk + i * 2);
+          }
+        }
+      } else if (std::memcmp(type, "IDAT", 4) == 0) {
+        // A single IDAT is inflated in place; several are joined first
+        if (idatChunks == 0) {
+          idat_ = {chunk, length};
+        } else {
+          if (idatChunks == 1) {
+            compressed_.assign(idat_.data(), idat_.data() + idat_.size());
+          }
+          compressed_.insert(compressed_.end(), chunk, chunk + length);
+          idat_ = {};
+        }
+        idatChunks++;
+      } else if (std::memcmp(type, "IEND", 4) == 0) {
+        haveEnd = true;
+      } else if ((type[0] & 0x20) == 0) {
+        return Fail(error_, "Unsupported PNG format");
+      }
+      if (position == size_) break;
+    }
+    if (!haveHeader) return Fail(error_, "Corrupt PNG header");
+    if (idatChunks == 0) return Fail(error_, "Truncated PNG data");
+    if (colorType_ == 3 && paletteSize_ == 0) return Fail(error_, "Corrupt PNG palette");
+
+    // Palette entries become gray on white once, not per pixel
+    for (int i = 0; i < 256; i++) {
+      paletteGray_[i] = i < paletteSize_ ? OnWhite(palette_[i], alpha_[i]) : 0;
+    }
+    return true;
+  }
+
+  bool ValidDepth() const {
+    switch (colorType_) {
+      case 0:
+        return depth_ == 1 || depth_ == 2 || depth_ == 4 || depth_ == 8 || depth_ == 16;
+      case 3:
+        return depth_ == 1 || depth_ == 2 || depth_ == 4 || depth_ == 8;
+      case 2:
+      case 4:
+      case 6:
+        return depth_ == 8 || depth_ == 16;
+      default:
+        return false;
+    }
+  }
+
+  // Move to the next pass with pixels in it. False after the last pass.
+  bool NextPass() {
+    if (!interlaced_) {
+      if (rowBytes_ != 0) {
+        pass_ = 1;
+        return false;
+      }
+    } else {
+      do {
+        pass_++;
+        if (pass_ >= static_cast<int>(kAdam7.size())) return false;
+        const PngPass& pass = kAdam7[pass_];
+        passWidth_ = width_ > pass.x ? (width_ - pass.x + pass.stepX - 1) / pass.stepX : 0;
+        passHeight_ = height_ > pass.y ? (height_ - pass.y + pass.stepY - 1) / pass.stepY : 0;
+      } while (passWidth_ == 0 || passHeight_ == 0);
+    }
+    rowBytes_ = (static_cast<size_t>(passWidth_) * depth_ * Channels() + 7) / 8;
+    row_.assign(rowBytes_ + 1, 0);
+    previous_.assign(rowBytes_, 0);
+    filled_ = 0;
+    passRow_ = 0;
+    return true;
+  }
+
+  // Inflated bytes: filter type and scanline, row after row
+  bool Write(const uint8_t* bytes, size_t count) {
+    while (count > 0) {
+      const size_t chunk = std::min(count, row_.size() - filled_);
+      std::memcpy(row_.data() + filled_, bytes, chunk);
+      filled_ += chunk;
+      bytes += chunk;
+      count -= chunk;
+      if (filled_ < row_.size()) break;
+
+      if (!Unfilter()) {
+        failed_ = true;
+        return false;
+      }
+      ConvertRow(row_.data() + 1);
+      const int y = interlaced_ ? kAdam7[pass_].y + passRow_ * kAdam7[pass_].stepY : passRow_;
+      if (interlaced_) {
+        const PngPass& pass = kAdam7[pass_];
+        uint8_t* target = plane_.data() + static_cast<size_t>(y) * width_ + pass.x;
+        for (int x = 0; x < passWidth_; x++) {
+          target[static_cast<size_t>(x) * pass.stepX] = gray_[x];
+        }
+      } else {
+        sink_.Row(y, gray_.data());
+      }
+      std::memcpy(previous_.data(), row_.data() + 1, rowBytes_);
+      filled_ = 0;
+      if (++passRow_ == passHeight_ && !NextPass()) return false;
+    }
+    return true;
+  }
+
+  bool Unfilter() {
+    uint8_t* row = row_.data() + 1;
+    const uint8_t* above = previous_.data();
+    const size_t left = filterBytes_;
+    switch (row_[0]) {
+      case 0:
+        break;
+      case 1:
+        for (size_t i = left; i < rowBytes_; i++) {
+          row[i] = static_cast<uint8_t>(row[i] + row[i - left]);
+        }
+        break;
+      case 2:
+        for (size_t i = 0; i < rowBytes_; i++) {
+          row[i] = static_cast<uint8_t>(row[i] + above[i]);
+        }
+        break;
+      case 3:
+        for (size_t i = 0; i < rowBytes_; i++) {
+          const int a = i >= left ? row[i - left] : 0;
+          row[i] = static_cast<uint8_t>(row[i] + ((a + above[i]) >> 1));
+        }
+        break;
+      case 4:
+        for (size_t i = 0; i < rowBytes_; i++) {
+          const int a = i >= left ? row[i - left] : 0;
+          const int b = above[i];
+          const int c = i >= left ? above[i - left] : 0;
+          const int p = a + b - c;
+          const int pa = std::abs(p - a);
+          const int pb = std::abs(p - b);
+          const int pc = std::abs(p - c);
+          const int predicted = pa <= pb && pa <= pc ? a : (pb <= pc ? b : c);
+          row[i] = static_cast<uint8_t>(row[i] + predicted);
+        }
+        break;
+      default:
+        return false;
+    }
+    return true;
+  }
+
+  // Sample x of a row packed at depth bits per sample, 1 to 8
+  int PackedSample(const uint8_t* row, int x) const {
+    const size_t bit = static_cast<size_t>(x) * depth_;
+    return (row[bit / 8] >> (8 - depth_ - bit % 8)) & ((1 << depth_) - 1);
+  }
+
+  void ConvertRow(const uint8_t* row) {
+    uint8_t* gray = gray_.data();
+    const int count = passWidth_;
+    const bool wide = depth_ == 16;
+    switch (colorType_) {
+      case 0:
+        if (depth_ < 8) {
+          const int scale = 255 / ((1 << depth_) - 1);
+          for (int x = 0; x < count; x++) {
+            const int sample = PackedSample(row, x);
+            gray[x] = hasKey_ && sample == key_[0] ? 255 : static_cast<uint8_t>(sample * scale);
+          }
+        } else if (!wide) {
+          for (int x = 0; x < count; x++) {
+            gray[x] = hasKey_ && row[x] == key_[0] ? 255 : row[x];
+          }
+        } else {
+          for (int x = 0; x < count; x++) {
+            gray[x] = hasKey_ && ReadBigEndian16(row + x * 2) == key_[0] ? 255 : row[x * 2];
+          }
+        }
+        break;
+      case 2:
+        for (int x = 0; x < count; x++) {
+          const uint8_t* pixel = row + x * (wide ? 6 : 3);
+          const int step = wide ? 2 : 1;
+          if (hasKey_ && (wide ? ReadBigEndian16(pixel) == key_[0] &&
+                                     ReadBigEndian16(pixel + 2) == key_[1] &&
+                                     ReadBigEndian16(pixel + 4) == key_[2]
+                               : pixel[0] == key_[0] && pixel[1] == key_[1] &&
+                                     pixel[2] == key_[2])) {
+            gray[x] = 255;
+          } else {
+            gray[x] = Luminance(pixel[0], pixel[step], pixel[step * 2]);
+          }
+        }
+        break;
+      case 3:
+        if (depth_ == 8) {
+          for (int x = 0; x < count; x++) {
+            gray[x] = paletteGray_[row[x]];
+          }
+        } else {
+          for (int x = 0; x < count; x++) {
+            gray[x] = paletteGray_[PackedSample(row, x)];
+          }
+        }
+        break;
+      case 4:
+        for (int x = 0; x < count; x++) {
+          const uint8_t* pixel = row + x * (wide ? 4 : 2);
+          gray[x] = OnWhite(pixel[0], pixel[wide ? 2 : 1]);
+        }
+        break;
+      case 6:
+        for (int x = 0; x < count; x++) {
+          const uint8_t* pixel = row + x * (wide ? 8 : 4);
+          const int step = wide ? 2 : 1;
+          gray[x] = OnWhite(Luminance(pixel[0], pixel[step], pixel[step * 2]), pixel[step * 3]);
+        }
+        break;
+    }
+  }
+
+  // Interlaced images are complete only after the last pass
+  bool FinishPlane() {
+    if (interlaced_) {
+      for (int y = 0; y < height_; y++) {
+        sink_.Row(y, plane_.data() + static_cast<size_t>(y) * width_);
+      }
+    }
+    return true;
+  }
+
+  struct Span {
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+    bool empty() const { return bytes == nullptr; }
+  };
+
+  const uint8_t* data_;
+  size_t size_;
+  GrayRowSink& sink_;
+  std::string* error_;
+
+  int width_ = 0;
+  int height_ = 0;
+  int depth_ = 0;
+  int colorType_ = 0;
+  bool interlaced_ = false;
+  int paletteSize_ = 0;
+  std::array<uint8_t, 256> palette_{};
+  std::array<uint8_t, 256> alpha_ = []() {
+    std::array<uint8_t, 256> opaque;
+    opaque.fill(255);
+    return opaque;
+  }();
+  std::array<uint8_t, 256> paletteGray_{};
+  bool hasKey_ = false;
+  std::array<int, 3> key_{};
+
+  Span idat_;
+  std::vector<uint8_t> compressed_;
+
+  size_t filterBytes_ = 1;
+  int pass_ = 0;
+  int passWidth_ = 0;
+  int passHeight_ = 0;
+  int passRow_ = 0;
+  size_t rowBytes_ = 0;
+  std::vector<uint8_t> row_;
+  std::vector<uint8_t> previous_;
+  size_t filled_ = 0;
+  std::vector<uint8_t> gray_;
+  std::vector<uint8_t> plane_;
+  bool failed_ = false;
+};
+
+// --- JPEG ---
+
+// Codes up to this long are decoded with one table lookup
+constexpr int kJpegFastBits = 9;
+
+// Natural order index of each zigzag position
+constexpr std::array<uint8_t, 64> kDezigzag = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33, 40, 48,
+    41, 34, 27, 20, 13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23,
+    30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+struct JpegTable {
+  bool present = false;
+  // Indexed by the next kJpegFastBits input bits: length << 8 | symbol, 0
+  // for longer codes
+  std::array<uint16_t, 1 << kJpegFastBits> fast{};
+  // Largest code of each length, -1 for none
+  std::array<int32_t, 17> maxCode{};
+  // Symbol index of a code of each length, less the code
+  std::array<int32_t, 17> offsets{};
+  std::array<uint8_t, 256> symbols{};
+};
+
+struct JpegComponent {
+  int id = 0;
+  int h = 1;
+  int v = 1;
+  int quantTable = 0;
+  int dcTable = 0;
+  int acTable = 0;
+  int dcPrediction = 0;
+  // Transformed by this decode, rather than only entropy decoded
+  bool needed = false;
+  // One row of blocks of the component
+  std::vector<uint8_t> band;
+  size_t stride = 0;
+};
+
+// Fixed point inverse DCT with 12 fractional bits, the accurate integer
+// method of the IJG library
+constexpr int32_t Fixed(double value) {
+  return static_cast<int32_t>(value * 4096 + 0.5);
+}
+
+constexpr int32_t kIdct0541 = Fixed(0.5411961);
+constexpr int32_t kIdct1847 = Fixed(-1.847759065);
+constexpr int32_t kIdct0765 = Fixed(0.765366865);
+constexpr int32_t kIdct1175 = Fixed(1.175875602);
+constexpr int32_t kIdct0298 = Fixed(0.298631336);
+constexpr int32_t kIdct2053 = Fixed(2.053119869);
+constexpr int32_t kIdct3072 = Fixed(3.072711026);
+constexpr int32_t kIdct1501 = Fixed(1.501321110);
+constexpr int32_t kIdct0899 = Fixed(-0.899976223);
+constexpr int32_t kIdct2562 = Fixed(-2.562915447);
+constexpr int32_t kIdct1961 = Fixed(-1.961570560);
+constexpr int32_t kIdct0390 = Fixed(-0.390180644);
+
+uint8_t ClampSample(int64_t value) {
+  return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// Coefficients are kept to the range of 16 bits, as in the IJG library;
+// the 1D transforms work in 64 bits so that corrupt data cannot overflow
+int32_t ClampCoefficient(int64_t value) {
+  return static_cast<int32_t>(std::min<int64_t>(std::max<int64_t>(value, -32768), 32767));
+}
+
+struct IdctOutput {
+  int64_t x0, x1, x2, x3, t0, t1, t2, t3;
+};
+
+inline IdctOutput Idct1D(int64_t s0, int64_t s1, int64_t s2, int64_t s3, int64_t s4, int64_t s5,
+                         int64_t s6, int64_t s7) {
+  IdctOutput out;
+  int64_t p1 = (s2 + s6) * kIdct0541;
+  const int64_t even2 = p1 + s6 * kIdct1847;
+  const int64_t even3 = p1 + s2 * kIdct0765;
+  const int64_t even0 = (s0 + s4) * 4096;
+  const int64_t even1 = (s0 - s4) * 4096;
+  out.x0 = even0 + even3;
+  out.x3 = even0 - even3;
+  out.x1 = even1 + even2;
+  out.x2 = even1 - even2;
+
+  int64_t t0 = s7;
+  int64_t t1 = s5;
+  int64_t t2 = s3;
+  int64_t t3 = s1;
+  int64_t p3 = t0 + t2;
+  int64_t p4 = t1 + t3;
+  p1 = t0 + t3;
+  int64_t p2 = t1 + t2;
+  const int64_t p5 = (p3 + p4) * kIdct1175;
+  t0 *= kIdct0298;
+  t1 *= kIdct2053;
+  t2 *= kIdct3072;
+  t3 *= kIdct1501;
+  p1 = p5 + p1 * kIdct0899;
+  p2 = p5 + p2 * kIdct2562;
+  p3 *= kIdct1961;
+  p4 *= kIdct0390;
+  out.t3 = t3 + p1 + p4;
+  out.t2 = t2 + p2 + p3;
+  out.t1 = t1 + p2 + p4;
+  out.t0 = t0 + p1 + p3;
+  return out;
+}
+
+// Dequantized coefficients in natural order to 8x8 samples
+void InverseDct(const int32_t* coefficients, uint8_t* out, size_t stride) {
+  int32_t columns[64];
+  for (int i = 0; i < 8; i++) {
+    const int32_t* d = coefficients + i;
+    int32_t* v = columns + i;
+    if (d[8] == 0 && d[16] == 0 && d[24] == 0 && d[32] == 0 && d[40] == 0 && d[48] == 0 &&
+        d[56] == 0) {
+      const int32_t dc = d[0] * 4;
+      for (int row = 0; row < 8; row++) {
+        v[row * 8] = dc;
+      }
+      continue;
+    }
+    IdctOutput o = Idct1D(d[0], d[8], d[16], d[24], d[32], d[40], d[48], d[56]);
+    // Keep two extra bits of the 12 fractional ones
+    o.x0 += 512;
+    o.x1 += 512;
+    o.x2 += 512;
+    o.x3 += 512;
+    v[0] = static_cast<int32_t>((o.x0 + o.t3) >> 10);
+    v[56] = static_cast<int32_t>((o.x0 - o.t3) >> 10);
+    v[8] = static_cast<int32_t>((o.x1 + o.t2) >> 10);
+    v[48] = static_cast<int32_t>((o.x1 - o.t2) >> 10);
+    v[16] = static_cast<int32_t>((o.x2 + o.t1) >> 10);
+    v[40] = static_cast<int32_t>((o.x2 - o.t1) >> 10);
+    v[24] = static_cast<int32_t>((o.x3 + o.t0) >> 10);
+    v[32] = static_cast<int32_t>((o.x3 - o.t0) >> 10);
+  }
+
+  for (int i = 0; i < 8; i++, out += stride) {
+    const int32_t* v = columns + i * 8;
+    IdctOutput o = Idct1D(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+    // 12 fractional bits, 2 kept from the columns and 3 from the two
+    // passes' scale of sqrt(8) each: round, and level shift by 128
+    const int64_t bias = 65536 + (128 << 17);
+    o.x0 += bias;
+    o.x1 += bias;
+    o.x2 += bias;
+    o.x3 += bias;
+    out[0] = ClampSample((o.x0 + o.t3) >> 17);
+    out[7] = ClampSample((o.x0 - o.t3) >> 17);
+    out[1] = ClampSample((o.x1 + o.t2) >> 17);
+    out[6] = ClampSample((o.x1 - o.t2) >> 17);
+    out[2] = ClampSample((o.x2 + o.t1) >> 17);
+    out[5] = ClampSample((o.x2 - o.t1) >> 17);
+    out[3] = ClampSample((o.x3 + o.t0) >> 17);
+    out[4] = ClampSample((o.x3 - o.t0) >> 17);
+  }
+}
+
+bool BuildJpegTable(JpegTable& table, const uint8_t* counts, const uint8_t* symbols, int total) {
+  table.fast.fill(0);
+  std::copy(symbols, symbols + total, table.symbols.begin());
+  int code = 0;
+  int index = 0;
+  for (int length = 1; length <= 16; length++) {
+    table.offsets[length] = index - code;
+    for (int i = 0; i < counts[length - 1]; i++, index++, code++) {
+      // More codes than the length allows
+      if (code >= (1 << length)) return false;
+      if (length <= kJpegFastBits) {
+        const int first = code << (kJpegFastBits - length);
+        const uint16_t entry = static_cast<uint16_t>(length << 8 | symbols[index]);
+        for (int fill = 0; fill < (1 << (kJpegFastBits - length)); fill++) {
+          table.fast[first + fill] = entry;
+        }
+      }
+    }
+    table.maxCode[length] = counts[length - 1] > 0 ? code - 1 : -1;
+    code <<= 1;
+  }
+  table.present = true;
+  return true;
+}
+
+class JpegDecoder {
+public:
+  JpegDecoder(const uint8_t* data, size_t size, GrayRowSink& sink, std::string* error)
+      : data_(data), size_(size), sink_(sink), error_(error) {}
+
+  bool Decode() {
+    size_t position = 2;
+    for (;;) {
+      // Markers may be padded with any number of 0xFF bytes
+      while (position < size_ && data_[position] != 0xFF) position++;
+      while (position < size_ && data_[position] == 0xFF) position++;
+      if (position >= size_) break;
+      const uint8_t marker = data_[position++];
+      if (marker == 0xD9) break;
+      if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) continue;
+
+      if (size_ - position < 2) break;
+      const size_t length = ReadBigEndian16(data_ + position);
+      if (length < 2 || length > size_ - position) break;
+      const uint8_t* segment = data_ + position + 2;
+      const size_t segmentSize = length - 2;
+      position += length;
+
+      bool ok = true;
+      if (marker == 0xC0 || marker == 0xC1) {
+        if (!ReadFrame(segment, segmentSize)) return false;
+      } else if ((marker >= 0xC2 && marker <= 0xCF) && marker != 0xC4 && marker != 0xC8 &&
+                 marker != 0xCC) {
+        return Fail(error_, "Only baseline JPEG images are supported");
+      } else if (marker == 0xC4) {
+        ok = ReadHuffmanTables(segment, segmentSize);
+      } else if (marker == 0xDB) {
+        ok = ReadQuantTables(segment, segmentSize);
+      } else if (marker == 0xDD) {
+        ok = segmentSize >= 2;
+        if (ok) restartInterval_ = ReadBigEndian16(segment);
+      } else if (marker == 0xEE) {
+        if (segmentSize >= 12 && std::memcmp(segment, "Adobe", 5) == 0) {
+          adobeTransform_ = segment[11];
+        }
+      } else if (marker == 0xDA) {
+        if (!ReadScan(segment, segmentSize, &position)) return false;
+        if (rowsDone_ == height_) return true;
+        continue;
+      }
+      if (!ok) return Fail(error_, "Corrupt JPEG data");
+    }
+    if (width_ == 0) return Fail(error_, "Corrupt JPEG data");
+    return Fail(error_, "Truncated JPEG data");
+  }
+
+private:
+  bool ReadFrame(const uint8_t* segment, size_t size) {
+    if (width_ != 0 || size < 6) return Fail(error_, "Corrupt JPEG data");
+    if (segment[0] != 8) return Fail(error_, "Only 8-bit JPEG images are supported");
+    height_ = ReadBigEndian16(segment + 1);
+    width_ = ReadBigEndian16(segment + 3);
+    const int count = segment[5];
+    if (width_ == 0 || height_ == 0) return Fail(error_, "Unsupported JPEG format");
+    if (width_ > kMaxImageDimension || height_ > kMaxImageDimension) {
+      return Fail(error_, "Image is too large");
+    }
+    if (count != 1 && count != 3) return Fail(error_, "Unsupported JPEG color format");
+    if (size < 6 + static_cast<size_t>(count) * 3) return Fail(error_, "Corrupt JPEG data");
+
+    components_.resize(count);
+    for (int i = 0; i < count; i++) {
+      JpegComponent& component = components_[i];
+      const uint8_t* spec = segment + 6 + i * 3;
+      component.id = spec[0];
+      component.h = spec[1] >> 4;
+      component.v = spec[1] & 0x0F;
+      component.quantTable = spec[2];
+      if (component.h < 1 || component.h > 4 || component.v < 1 || component.v > 4 ||
+          component.quantTable > 3) {
+        return Fail(error_, "Corrupt JPEG data");
+      }
+      // A lone component is never interleaved, whatever its factors say
+      if (count == 1) component.h = component.v = 1;
+      maxH_ = std::max(maxH_, component.h);
+      maxV_ = std::max(maxV_, component.v);
+    }
+
+    // Color stored as RGB rather than YCbCr needs all three components;
+    // otherwise luminance is the first component alone
+    rgb_ = count == 3 && (adobeTransform_ == 0 || (components_[0].id == 'R' &&
+                                                   components_[1].id == 'G' &&
+                                                   components_[2].id == 'B'));
+    if (rgb_) {
+      for (JpegComponent& component : components_) {
+        if (component.h != maxH_ || component.v != maxV_) {
+          return Fail(error_, "Unsupported JPEG color format");
+        }
+        component.needed = true;
+      }
+    } else {
+      components_[0].needed = true;
+    }
+
+    gray_.resize(width_);
+    if (!sink_.Begin(width_, height_)) return Fail(error_, "Image refused");
+    return true;
+  }
+
+  bool ReadHuffmanTables(const uint8_t* segment, size_t size) {
+    while (size > 0) {
+      if (size < 17) return false;
+      const int tableClass = segment[0] >> 4;
+      const int id = segment[0] & 0x0F;
+      if (tableClass > 1 || id > 3) return false;
+      int total = 0;
+      for (int i = 0; i < 16; i++) {
+        total += segment[1 + i];
+      }
+      if (total > 256 || size < 17 + static_cast<size_t>(total)) return false;
+      JpegTable& table = tableClass == 0 ? dcTables_[id] : acTables_[id];
+      if (!BuildJpegTable(table, segment + 1, segment + 17, total)) return false;
+      segment += 17 + total;
+      size -= 17 + total;
+    }
+    return true;
+  }
+
+  bool ReadQuantTables(const uint8_t* segment, size_t size) {
+    while (size > 0) {
+      const int precision = segment[0] >> 4;
+      const int id = segment[0] & 0x0F;
+      const size_t tableSize = precision == 0 ? 64 : 128;
+      if (precision > 1 || id > 3 || size < 1 + tableSize) return false;
+      for (int i = 0; i < 64; i++) {
+        quantTables_[id][i] =
+            precision == 0 ? segment[1 + i] : ReadBigEndian16(segment + 1 + i * 2);
+      }
+      segment += 1 + tableSize;
+      size -= 1 + tableSize;
+    }
+    return true;
+  }
+
+  // Decode the scan whose header is segment and whose entropy coded data
+  // starts at *position, leaving *position at the marker after it
+  bool ReadScan(const uint8_t* segment, size_t size, size_t* position) {
+    if (width_ == 0 || size < 1) return Fail(error_, "Corrupt JPEG data");
+    const int count = segment[0];
+    if (count < 1 || count > static_cast<int>(components_.size()) ||
+        size < 4 + static_cast<size_t>(count) * 2) {
+      return Fail(error_, "Corrupt JPEG data");
+    }
+    scan_.clear();
+    bool needed = false;
+    for (int i = 0; i < count; i++) {
+      const int id = segment[1 + i * 2];
+      const int tables = segment[2 + i * 2];
+      auto found =
+          std::find_if(components_.begin(), components_.end(),
+                       [id](const JpegComponent& component) { return component.id == id; });
+      if (found == components_.end()) return Fail(error_, "Corrupt JPEG data");
+      found->dcTable = tables >> 4;
+      found->acTable = tables & 0x0F;
+      if (found->dcTable > 3 || found->acTable > 3 || !dcTables_[found->dcTable].present ||
+          !acTables_[found->acTable].present) {
+        return Fail(error_, "Corrupt JPEG data");
+      }
+      needed = needed || found->needed;
+      scan_.push_back(&*found);
+    }
+
+    position_ = *position;
+    if (!needed) {
+      SkipEntropyData();
+    } else if (count == static_cast<int>(components_.size()) && count > 1) {
+      if (!DecodeInterleaved()) return false;
+    } else if (count == 1 && !rgb_ &&
+               (components_.size() == 1 || (scan_[0]->h == maxH_ && scan_[0]->v == maxV_))) {
+      if (!DecodeSingle()) return false;
+    } else {
+      return Fail(error_, "Unsupported JPEG scan layout");
+    }
+    *position = position_;
+    return true;
+  }
+
+  void ResetBits() {
+    bits_ = 0;
+    count_ = 0;
+    padding_ = 0;
+    marker_ = false;
+  }
+
+  // Entropy coded bytes, with stuffed zeros dropped. Zeros are fed once a
+  // marker is reached, or once the data ends, which Exhausted tells.
+  void Refill() {
+    while (count_ <= 56) {
+      uint64_t byte = 0;
+      if (!marker_ && position_ >= size_) {
+        padding_ = std::min(padding_ + 8, 64);
+      } else if (!marker_) {
+        byte = data_[position_];
+        if (byte != 0xFF) {
+          position_++;
+        } else if (position_ + 1 < size_ && data_[position_ + 1] == 0) {
+          position_ += 2;
+        } else {
+          marker_ = true;
+          byte = 0;
+        }
+      }
+      bits_ = bits_ << 8 | byte;
+      count_ += 8;
+    }
+  }
+
+  // Bits were taken from past the end of the data
+  bool Exhausted() const { return padding_ > count_; }
+
+  int Bits(int count) {
+    if (count_ < count) Refill();
+    count_ -= count;
+    return static_cast<int>((bits_ >> count_) & ((1u << count) - 1));
+  }
+
+  int Decode(const JpegTable& table) {
+    if (count_ < 16) Refill();
+    const uint16_t entry =
+        table.fast[(bits_ >> (count_ - kJpegFastBits)) & ((1 << kJpegFastBits) - 1)];
+    if (entry != 0) {
+      count_ -= entry >> 8;
+      return entry & 0xFF;
+    }
+    for (int length = kJpegFastBits + 1; length <= 16; length++) {
+      const int code = static_cast<int>((bits_ >> (count_ - length)) & ((1u << length) - 1));
+      if (code <= table.maxCode[length]) {
+        count_ -= length;
+        return table.symbols[(code + table.offsets[length]) & 0xFF];
+      }
+    }
+    return -1;
+  }
+
+  // A magnitude category and its bits to a signed value
+  int Receive(int category) {
+    if (category == 0) return 0;
+    const int value = Bits(category);
+    return value < (1 << (category - 1)) ? value - (1 << category) + 1 : value;
+  }
+
+  // Entropy decode one block, and dequantize it into coefficients unless
+  // that is null. False on corrupt data.
+  bool DecodeBlock(JpegComponent& component, int32_t* coefficients) {
+    const int category = Decode(dcTables_[component.dcTable]);
+    if (category < 0 || category > 16) return false;
+    // Clamped so that corrupt data cannot overflow it
+    component.dcPrediction =
+        std::min(std::max(component.dcPrediction + Receive(category), -65535), 65535);
+    const uint16_t* quant = quantTables_[component.quantTable].data();
+    if (coefficients) {
+      std::memset(coefficients, 0, 64 * sizeof(int32_t));
+      coefficients[0] = ClampCoefficient(int64_t{component.dcPrediction} * quant[0]);
+    }
+    const JpegTable& ac = acTables_[component.acTable];
+    for (int k = 1; k < 64;) {
+      const int symbol = Decode(ac);
+      if (symbol < 0) return false;
+      const int run = symbol >> 4;
+      const int magnitude = symbol & 0x0F;
+      if (magnitude == 0) {
+        if (run != 15) break;
+        k += 16;
+        continue;
+      }
+      k += run;
+      if (k > 63) return false;
+      const int value = Receive(magnitude);
+      if (coefficients) coefficients[kDezigzag[k]] = ClampCoefficient(int64_t{value} * quant[k]);
+      k++;
+    }
+    return true;
+  }
+
+  // Between restart intervals: the bit stream realigns and predictions reset
+  void Restart() {
+    ResetBits();
+    if (position_ + 1 < size_ && data_[position_] == 0xFF && data_[position_ + 1] >= 0xD0 &&
+        data_[position_ + 1] <= 0xD7) {
+      position_ += 2;
+    }
+    for (JpegComponent& component : components_) {
+      component.dcPrediction = 0;
+    }
+  }
+
+  void BeginScan() {
+    ResetBits();
+    for (JpegComponent& component : components_) {
+      component.dcPrediction = 0;
+    }
+  }
+
+  // Move past entropy coded data to the next marker other than a restart
+  void SkipEntropyData() {
+    while (position_ + 1 < size_) {
+      if (data_[position_] == 0xFF && data_[position_ + 1] != 0 &&
+          (data_[position_ + 1] < 0xD0 || data_[position_ + 1] > 0xD7)) {
+        return;
+      }
+      position_++;
+    }
+    position_ = size_;
+  }
+
+  bool DecodeInterleaved() {
+    BeginScan();
+    const int mcuWidth = 8 * maxH_;
+    const int mcuHeight = 8 * maxV_;
+    const int mcusAcross = (width_ + mcuWidth - 1) / mcuWidth;
+    const int mcusDown = (height_ + mcuHeight - 1) / mcuHeight;
+    for (JpegComponent& component : components_) {
+      if (!component.needed) continue;
+      component.stride = static_cast<size_t>(mcusAcross) * component.h * 8;
+      component.band.assign(component.stride * component.v * 8, 0);
+    }
+
+    int32_t coefficients[64];
+    int mcu = 0;
+    for (int mcuY = 0; mcuY < mcusDown; mcuY++) {
+      for (int mcuX = 0; mcuX < mcusAcross; mcuX++, mcu++) {
+        if (restartInterval_ != 0 && mcu != 0 && mcu % restartInterval_ == 0) Restart();
+        for (JpegComponent* component : scan_) {
+          for (int blockY = 0; blockY < component->v; blockY++) {
+            for (int blockX = 0; blockX < component->h; blockX++) {
+              if (!DecodeBlock(*component, component->needed ? coefficients : nullptr)) {
+                return Fail(error_, "Corrupt JPEG data");
+              }
+              if (component->needed) {
+                InverseDct(coefficients,
+                           component->band.data() + blockY * 8 * component->stride +
+                               (static_cast<size_t>(mcuX) * component->h + blockX) * 8,
+                           component->stride);
+              }
+            }
+          }
+        }
+      }
+      if (Exhausted()) return Fail(error_, "Truncated JPEG data");
+      EmitRows(mcuY * mcuHeight, std::min(mcuHeight, height_ - mcuY * mcuHeight));
+    }
+    SkipEntropyData();
+    return true;
+  }
+
+  bool DecodeSingle() {
+    BeginScan();
+    JpegComponent& component = *scan_[0];
+    const int blocksAcross = (width_ + 7) / 8;
+    const int blocksDown = (height_ + 7) / 8;
+    component.stride = static_cast<size_t>(blocksAcross) * 8;
+    component.band.assign(component.stride * 8, 0);
+
+    int32_t coefficients[64];
+    int block = 0;
+    for (int blockY = 0; blockY < blocksDown; blockY++) {
+      for (int blockX = 0; blockX < blocksAcross; blockX++, block++) {
+        if (restartInterval_ != 0 && block != 0 && block % restartInterval_ == 0) Restart();
+        if (!DecodeBlock(component, coefficients)) return Fail(error_, "Corrupt JPEG data");
+        InverseDct(coefficients, component.band.data() + static_cast<size_t>(blockX) * 8,
+                   component.stride);
+      }
+      if (Exhausted()) return Fail(error_, "Truncated JPEG data");
+      EmitRows(blockY * 8, std::min(8, height_ - blockY * 8));
+    }
+    SkipEntropyData();
+    return true;
+  }
+
+  // Hand over image rows [top, top + rows) from the components' bands,
+  // which start at row top
+  void EmitRows(int top, int rows) {
+    for (int row = 0; row < rows; row++) {
+      if (rgb_) {
+        const uint8_t* r = components_[0].band.data() + row * components_[0].stride;
+        const uint8_t* g = components_[1].band.data() + row * components_[1].stride;
+        const uint8_t* b = components_[2].band.data() + row * components_[2].stride;
+        for (int x = 0; x < width_; x++) {
+          gray_[x] = Luminance(r[x], g[x], b[x]);
+        }
+        sink_.Row(top + row, gray_.data());
+        continue;
+      }
+      const JpegComponent& luma = components_[0];
+      const uint8_t* source = luma.band.data() + (row * luma.v / maxV_) * luma.stride;
+      if (luma.h == maxH_) {
+        sink_.Row(top + row, source);
+        continue;
+      }
+      for (int x = 0; x < width_; x++) {
+        gray_[x] = source[x * luma.h / maxH_];
+      }
+      sink_.Row(top + row, gray_.data());
+    }
+    rowsDone_ = top + rows;
+  }
+
+  const uint8_t* data_;
+  size_t size_;
+  GrayRowSink& sink_;
+  std::string* error_;
+
+  int width_ = 0;
+  int height_ = 0;
+  int maxH_ = 1;
+  int maxV_ = 1;
+  bool rgb_ = false;
+  int adobeTransform_ = -1;
+  int restartInterval_ = 0;
+  std::vector<JpegComponent> components_;
+  std::vector<JpegComponent*> scan_;
+  std::array<std::array<uint16_t, 64>, 4> quantTables_{};
+  std::array<JpegTable, 4> dcTables_;
+  std::array<JpegTable, 4> acTables_;
+  std::vector<uint8_t> gray_;
+  int rowsDone_ = 0;
+
+  size_t position_ = 0;
+  uint64_t bits_ = 0;
+  int count_ = 0;
+  int padding_ = 0;
+  bool marker_ = false;
+};
+
+}  // namespace
+
+ImageFormat DetectImageFormat(const uint8_t* data, size_t size) {
+  if (data == nullptr) return ImageFormat::kUnknown;
+  if (size >= sizeof(kPngSignature) &&
+      std::memcmp(data, kPngSignature, sizeof(kPngSignature)) == 0) {
+    return ImageFormat::kPng;
+  }
+  if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF) {
+    return ImageFormat::kJpeg;
+  }
+  return ImageFormat::kUnknown;
+}
+
+bool DecodeGrayImage(const uint8_t* data, size_t size, GrayRowSink& sink, std::string* error) {
+  switch (DetectImageFormat(data, size)) {
+    case ImageFormat::kPng:
+      return PngDecoder(data, size, sink, error).Decode();
+    case ImageFormat::kJpeg:
+      return JpegDecoder(data, size, sink, error).Decode();
+    default:
+      return Fail(error, "Not a PNG or JPEG image");
+  }
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,46 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_DECODER_H_
+#define FLUTTER_PLUGIN_IMAGE_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace windows_printer {
+
+enum class ImageFormat {
+  kUnknown = 0,
+  kPng,
+  kJpeg,
+};
+
+/// Images wider or taller than this are refused
+constexpr int kMaxImageDimension = 16384;
+
+/// Format of encoded image data, judged by its signature
+ImageFormat DetectImageFormat(const uint8_t* data, size_t size);
+
+// Receives a decoded image one row at a time, top to bottom
+class GrayRowSink {
+public:
+  virtual ~GrayRowSink() = default;
+
+  /// The image size, before the first row. Returning false stops decoding.
+  virtual bool Begin(int width, int height) = 0;
+
+  /// Row y as width luminance values, transparency blended onto white. The
+  /// row is only valid during the call.
+  virtual void Row(int y, const uint8_t* gray) = 0;
+};
+
+/// Decode a PNG or baseline JPEG straight to luminance rows, without ever
+/// holding the full image in color. PNG data is inflated and unfiltered one
+/// scanline at a time (interlaced images are gathered into one gray plane
+/// first); JPEG data is decoded one row of blocks at a time and only its
+/// luminance component is transformed. Returns false with a message in
+/// *error for data that is not a supported image, is corrupt or is refused
+/// by the sink; rows already delivered stay delivered.
+bool DecodeGrayImage(const uint8_t* data, size_t size, GrayRowSink& sink, std::string* error);
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_IMAGE_DECODER_H_
@@ -0,0 +1,289 @@
+#include "image_scaler.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WINDOWS_PRINTER_HAS_SSE2 1
+#endif
+
+namespace windows_printer {
+
+namespace {
+
+constexpr int kBytesPerPixel = 4;
+
+// Fewest rows ForEachImageBand gives one task
+constexpr int kMinSliceRows = 16;
+
+// Maps each of targetSize pixels to the two nearest of size source pixels,
+// sampling at pixel centers, with the weight of the second in 1/256
+void MapAxis(int size, int targetSize, std::vector<int>* first, std::vector<int>* second,
+             std::vector<uint16_t>* weights) {
+  first->resize(targetSize);
+  second->resize(targetSize);
+  weights->resize(targetSize);
+  const double scale = static_cast<double>(size) / targetSize;
+  for (int t = 0; t < targetSize; t++) {
+    const double position = std::max(0.0, (t + 0.5) * scale - 0.5);
+    int index = static_cast<int>(position);
+    int weight = static_cast<int>((position - index) * 256 + 0.5);
+    if (index >= size - 1) {
+      index = size - 1;
+      weight = 0;
+    }
+    (*first)[t] = index;
+    (*second)[t] = std::min(index + 1, size - 1);
+    (*weights)[t] = static_cast<uint16_t>(weight);
+  }
+}
+
+uint8_t Lerp(uint8_t a, uint8_t b, int weight) {
+  return static_cast<uint8_t>((a * (256 - weight) + b * weight + 128) >> 8);
+}
+
+// x / 255 rounded, for x up to 65280
+inline int DivideBy255(int x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+// RGBA onto white paper, as BGR plus an unused byte
+void BlendRow(const uint8_t* rgba, int width, uint8_t* bgrx) {
+  int x = 0;
+#ifdef WINDOWS_PRINTER_HAS_SSE2
+  // Four pixels per step: c * a + 255 * (255 - a) stays within 16 bits
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max = _mm_set1_epi16(255);
+  const __m128i half = _mm_set1_epi16(128);
+  const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+  auto blend = [&](__m128i pixels) {
+    __m128i alpha = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+    alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(pixels, alpha),
+                                _mm_mullo_epi16(max, _mm_sub_epi16(max, alpha)));
+    sum = _mm_add_epi16(sum, half);
+    sum = _mm_srli_epi16(_mm_add_epi16(sum, _mm_srli_epi16(sum, 8)), 8);
+    // RGBA to BGRA
+    sum = _mm_shufflelo_epi16(sum, _MM_SHUFFLE(3, 0, 1, 2));
+    return _mm_shufflehi_epi16(sum, _MM_SHUFFLE(3, 0, 1, 2));
+  };
+  for (; x + 4 <= width; x += 4) {
+    const __m128i pixels =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + x * kBytesPerPixel));
+    const __m128i low = blend(_mm_unpacklo_epi8(pixels, zero));
+    const __m128i high = blend(_mm_unpackhi_epi8(pixels, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(bgrx + x * kBytesPerPixel),
+                     _mm_or_si128(_mm_packus_epi16(low, high), opaque));
+  }
+#endif
+  for (; x < width; x++) {
+    const uint8_t* pixel = rgba + x * kBytesPerPixel;
+    uint8_t* out = bgrx + x * kBytesPerPixel;
+    const int alpha = pixel[3];
+    const int white = 255 * (255 - alpha);
+    out[0] = static_cast<uint8_t>(DivideBy255(pixel[2] * alpha + white));
+    out[1] = static_cast<uint8_t>(DivideBy255(pixel[1] * alpha + white));
+    out[2] = static_cast<uint8_t>(DivideBy255(pixel[0] * alpha + white));
+    out[3] = 255;
+  }
+}
+
+void ScaleRowHorizontally(const uint8_t* source, const uint32_t* left, const uint32_t* right,
+                          const uint16_t* weights, int targetWidth, uint8_t* out) {
+  int x = 0;
+#ifdef WINDOWS_PRINTER_HAS_SSE2
+  // Two target pixels, eight channels, per step in 16-bit lanes; the sums
+  // stay below 65536
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i full = _mm_set1_epi16(256);
+  const __m128i half = _mm_set1_epi16(128);
+  auto pixels = [source](uint32_t first, uint32_t second) {
+    int32_t a;
+    int32_t b;
+    std::memcpy(&a, source + first, sizeof(a));
+    std::memcpy(&b, source + second, sizeof(b));
+    return _mm_unpacklo_epi32(_mm_cvtsi32_si128(a), _mm_cvtsi32_si128(b));
+  };
+  for (; x + 2 <= targetWidth; x += 2) {
+    const __m128i a = _mm_unpacklo_epi8(pixels(left[x], left[x + 1]), zero);
+    const __m128i b = _mm_unpacklo_epi8(pixels(right[x], right[x + 1]), zero);
+    const __m128i weight =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + x * kBytesPerPixel));
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a, _mm_sub_epi16(full, weight)),
+                                _mm_mullo_epi16(b, weight));
+    sum = _mm_srli_epi16(_mm_add_epi16(sum, half), 8);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * kBytesPerPixel),
+                     _mm_packus_epi16(sum, sum));
+  }
+#endif
+  for (; x < targetWidth; x++) {
+    const uint8_t* a = source + left[x];
+    const uint8_t* b = source + right[x];
+    const int weight = weights[x * kBytesPerPixel];
+    uint8_t* pixel = out + x * kBytesPerPixel;
+    for (int channel = 0; channel < kBytesPerPixel; channel++) {
+      pixel[channel] = Lerp(a[channel], b[channel], weight);
+    }
+  }
+}
+
+void BlendRowsVertically(const uint8_t* top, const uint8_t* bottom, int weight, size_t size,
+                         uint8_t* out) {
+  if (weight == 0) {
+    std::memcpy(out, top, size);
+    return;
+  }
+  size_t i = 0;
+#ifdef WINDOWS_PRINTER_HAS_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i half = _mm_set1_epi16(128);
+  const __m128i second = _mm_set1_epi16(static_cast<short>(weight));
+  const __m128i first = _mm_set1_epi16(static_cast<short>(256 - weight));
+  auto blend = [&](__m128i a, __m128i b) {
+    const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a, first), _mm_mullo_epi16(b, second));
+    return _mm_srli_epi16(_mm_add_epi16(sum, half), 8);
+  };
+  for (; i + 16 <= size; i += 16) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + i));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + i));
+    const __m128i low = blend(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+    const __m128i high = blend(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+  }
+#endif
+  for (; i < size; i++) {
+    out[i] = Lerp(top[i], bottom[i], weight);
+  }
+}
+
+}  // namespace
+
+ImageRect FitImage(int imageWidth, int imageHeight, int areaWidth, int areaHeight) {
+  ImageRect rect;
+  if (imageWidth <= 0 || imageHeight <= 0 || areaWidth <= 0 || areaHeight <= 0) return rect;
+  const int64_t widthLimited = static_cast<int64_t>(imageWidth) * areaHeight;
+  const int64_t heightLimited = static_cast<int64_t>(imageHeight) * areaWidth;
+  if (widthLimited >= heightLimited) {
+    rect.width = areaWidth;
+    rect.height = static_cast<int>((heightLimited + imageWidth / 2) / imageWidth);
+  } else {
+    rect.height = areaHeight;
+    rect.width = static_cast<int>((widthLimited + imageHeight / 2) / imageHeight);
+  }
+  rect.width = std::max(rect.width, 1);
+  rect.height = std::max(rect.height, 1);
+  rect.x = (areaWidth - rect.width) / 2;
+  return rect;
+}
+
+ImageScaler::ImageScaler(const uint8_t* rgba, int width, int height, int targetWidth,
+                         int targetHeight)
+    : rgba_(rgba),
+      width_(width),
+      targetWidth_(targetWidth),
+      targetHeight_(targetHeight) {
+  std::vector<int> left;
+  std::vector<int> right;
+  std::vector<uint16_t> weights;
+  MapAxis(width, targetWidth, &left, &right, &weights);
+  left_.resize(targetWidth);
+  right_.resize(targetWidth);
+  columnWeights_.resize(static_cast<size_t>(targetWidth) * kBytesPerPixel);
+  for (int x = 0; x < targetWidth; x++) {
+    left_[x] = static_cast<uint32_t>(left[x] * kBytesPerPixel);
+    right_[x] = static_cast<uint32_t>(right[x] * kBytesPerPixel);
+    std::fill_n(columnWeights_.begin() + x * kBytesPerPixel, kBytesPerPixel, weights[x]);
+  }
+  MapAxis(height, targetHeight, &top_, &bottom_, &rowWeights_);
+
+  blended_.resize(static_cast<size_t>(width) * kBytesPerPixel);
+  for (auto& row : rows_) {
+    row.resize(static_cast<size_t>(targetWidth) * kBytesPerPixel);
+  }
+}
+
+void ImageScaler::ScaleRows(int top, int rows, uint8_t* out, size_t stride) {
+  const size_t rowBytes = static_cast<size_t>(targetWidth_) * kBytesPerPixel;
+  for (int y = top; y < top + rows; y++, out += stride) {
+    const uint8_t* upper = HorizontalRow(top_[y], bottom_[y]);
+    const uint8_t* lower = HorizontalRow(bottom_[y], top_[y]);
+    BlendRowsVertically(upper, lower, rowWeights_[y], rowBytes, out);
+  }
+}
+
+const uint8_t* ImageScaler::HorizontalRow(int y, int keep) {
+  for (int slot = 0; slot < 2; slot++) {
+    if (cachedRows_[slot] == y) return rows_[slot].data();
+  }
+  // Rows are mostly asked for top to bottom, so the upper one goes first
+  int slot = cachedRows_[0] <= cachedRows_[1] ? 0 : 1;
+  if (cachedRows_[slot] == keep) slot = 1 - slot;
+
+  BlendRow(rgba_ + static_cast<size_t>(y) * width_ * kBytesPerPixel, width_, blended_.data());
+  ScaleRowHorizontally(blended_.data(), left_.data(), right_.data(), columnWeights_.data(),
+                       targetWidth_, rows_[slot].data());
+  cachedRows_[slot] = y;
+  return rows_[slot].data();
+}
+
+int ImageBandRows(int width, size_t maxBytes) {
+  const size_t rowBytes = static_cast<size_t>(std::max(width, 1)) * kBytesPerPixel;
+  return static_cast<int>(std::min<size_t>(std::max<size_t>(maxBytes / rowBytes, 1), 1 << 20));
+}
+
+bool ForEachImageBand(ImageScaler& scaler, size_t maxBandBytes,
+                      const std::function<bool(const ImageBand& band)>& draw) {
+  const int height = scaler.TargetHeight();
+  const int bandRows = std::min(ImageBandRows(scaler.TargetWidth(), maxBandBytes), height);
+  if (bandRows <= 0) return true;
+
+  ImageBand band;
+  band.width = scaler.TargetWidth();
+  band.stride = static_cast<size_t>(band.width) * kBytesPerPixel;
+  std::vector<uint8_t> buffer(band.stride * bandRows);
+  band.bgrx = buffer.data();
+  for (band.top = 0; band.top < height; band.top += band.rows) {
+    band.rows = std::min(bandRows, height - band.top);
+    scaler.ScaleRows(band.top, band.rows, buffer.data(), band.stride);
+    if (!draw(band)) return false;
+  }
+  return true;
+}
+
+bool ForEachImageBand(ImageScaler& scaler, size_t maxBandBytes, TaskPool& pool,
+                      const std::function<bool(const ImageBand& band)>& draw) {
+  const int height = scaler.TargetHeight();
+  const int bandRows = std::min(ImageBandRows(scaler.TargetWidth(), maxBandBytes), height);
+  if (bandRows <= 0) return true;
+  // Slices shorter than kMinSliceRows cost more to hand out than to scale
+  const int slices = static_cast<int>(
+      std::clamp<size_t>(static_cast<size_t>(bandRows / kMinSliceRows), 1, pool.Threads()));
+  if (slices == 1) return ForEachImageBand(scaler, maxBandBytes, draw);
+
+  // Slice s of every band goes to copy s, so each copy still scales runs of
+  // consecutive rows
+  std::vector<ImageScaler> copies(slices - 1, scaler);
+  ImageBand band;
+  band.width = scaler.TargetWidth();
+  band.stride = static_cast<size_t>(band.width) * kBytesPerPixel;
+  std::vector<uint8_t> buffer(band.stride * bandRows);
+  band.bgrx = buffer.data();
+  for (band.top = 0; band.top < height; band.top += band.rows) {
+    band.rows = std::min(bandRows, height - band.top);
+    ParallelFor(pool, slices, 1, [&](size_t begin, size_t end) {
+      for (size_t slice = begin; slice < end; slice++) {
+        const int first = band.rows * static_cast<int>(slice) / slices;
+        const int last = band.rows * static_cast<int>(slice + 1) / slices;
+        ImageScaler& part = slice == 0 ? scaler : copies[slice - 1];
+        part.ScaleRows(band.top + first, last - first, buffer.data() + first * band.stride,
+                       band.stride);
+      }
+    });
+    if (!draw(band)) return false;
+  }
+  return true;
+}
+
+}  // namespace windows_printer
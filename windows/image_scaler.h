@@ -0,0 +1,97 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_SCALER_H_
+#define FLUTTER_PLUGIN_IMAGE_SCALER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "task_pool.h"
+
+namespace windows_printer {
+
+/// Where a scaled image lands on the page, in device pixels
+struct ImageRect {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+/// The largest rectangle with the image's aspect ratio that fits in an area
+/// of areaWidth x areaHeight, centered horizontally and at the top. Empty
+/// for an empty image or area.
+ImageRect FitImage(int imageWidth, int imageHeight, int areaWidth, int areaHeight);
+
+// Bilinear scaler from RGBA to the rows of a top-down 32-bit DIB: BGR with
+// the fourth byte unused, transparent pixels blended onto white paper. Rows
+// are produced on demand, so a page is scaled one band at a time and only
+// the band is ever held at the target size. The filter is separable; with
+// SSE2 both passes work on several channels at once.
+class ImageScaler {
+public:
+  /// rgba holds width * height pixels, both at least 1, and must outlive
+  /// the scaler
+  ImageScaler(const uint8_t* rgba, int width, int height, int targetWidth, int targetHeight);
+
+  /// A copy scales independently of the original, so copies can scale
+  /// different rows on different threads
+  ImageScaler(const ImageScaler&) = default;
+  ImageScaler& operator=(const ImageScaler&) = delete;
+
+  int TargetWidth() const { return targetWidth_; }
+  int TargetHeight() const { return targetHeight_; }
+
+  /// Scale target rows [top, top + rows) into out, stride bytes apart.
+  /// Fastest when called for consecutive rows.
+  void ScaleRows(int top, int rows, uint8_t* out, size_t stride);
+
+private:
+  // Source row y blended onto white and scaled horizontally, into whichever
+  // of the two cached rows does not hold row keep; returns that row
+  const uint8_t* HorizontalRow(int y, int keep);
+
+  const uint8_t* rgba_;
+  int width_;
+  int targetWidth_;
+  int targetHeight_;
+  // Per target column: byte offsets of the two source pixels, and the
+  // weight of the second in 1/256, repeated for each channel
+  std::vector<uint32_t> left_;
+  std::vector<uint32_t> right_;
+  std::vector<uint16_t> columnWeights_;
+  // Per target row: the two source rows and the weight of the second
+  std::vector<int> top_;
+  std::vector<int> bottom_;
+  std::vector<uint16_t> rowWeights_;
+  std::vector<uint8_t> blended_;
+  std::vector<uint8_t> rows_[2];
+  int cachedRows_[2] = {-1, -1};
+};
+
+/// One band of scaled rows, valid only during the callback
+struct ImageBand {
+  int top = 0;
+  int rows = 0;
+  int width = 0;
+  const uint8_t* bgrx = nullptr;
+  size_t stride = 0;
+};
+
+/// Rows of a 32-bit image width pixels wide that fit in maxBytes, at least 1
+int ImageBandRows(int width, size_t maxBytes);
+
+/// Scale the whole target in bands of at most maxBandBytes (or single rows
+/// when a row is larger), top to bottom through one reused buffer. Stops
+/// and returns false as soon as draw does.
+bool ForEachImageBand(ImageScaler& scaler, size_t maxBandBytes,
+                      const std::function<bool(const ImageBand& band)>& draw);
+
+/// As above, with each band's rows split into slices scaled in parallel on
+/// pool, each by its own copy of scaler. The bands are the same.
+bool ForEachImageBand(ImageScaler& scaler, size_t maxBandBytes, TaskPool& pool,
+                      const std::function<bool(const ImageBand& band)>& draw);
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_IMAGE_SCALER_H_
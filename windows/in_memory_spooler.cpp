@@ -0,0 +1,297 @@
+#include "in_memory_spooler.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace windows_printer {
+
+namespace {
+
+thread_local uint32_t lastError = 0;
+
+bool Fail(uint32_t error) {
+  lastError = error;
+  return false;
+}
+
+}  // namespace
+
+void InMemorySpooler::AddPrinter(const std::string& printerName) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (std::find(printers_.begin(), printers_.end(), printerName) == printers_.end()) {
+    printers_.push_back(printerName);
+  }
+}
+
+void InMemorySpooler::SetDefaultPrinter(const std::string& printerName) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  defaultPrinter_ = printerName;
+}
+
+void InMemorySpooler::FailNext(SpoolerCall call, uint32_t error, int count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pendingFailures_[static_cast<int>(call)] = count;
+  failureErrors_[static_cast<int>(call)] = error;
+}
+
+void InMemorySpooler::HangNext(SpoolerCall call, int count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pendingHangs_[static_cast<int>(call)] = count;
+}
+
+void InMemorySpooler::ReleaseHangs() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::fill(std::begin(pendingHangs_), std::end(pendingHangs_), 0);
+  releaseGeneration_++;
+  hangChanged_.notify_all();
+}
+
+size_t InMemorySpooler::HungCallCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return hungCalls_;
+}
+
+void InMemorySpooler::SetMaxWriteSize(uint32_t maxWriteSize) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  maxWriteSize_ = maxWriteSize;
+}
+
+void InMemorySpooler::SetDiscardData(bool discardData) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  discardData_ = discardData;
+}
+
+void InMemorySpooler::SetMakesCopies(bool makesCopies) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  makesCopies_ = makesCopies;
+}
+
+bool InMemorySpooler::SetJobStatus(uint32_t jobId, uint32_t status) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = jobs_.find(jobId);
+  if (it == jobs_.end() || !it->second.queued) {
+    return Fail(kErrorInvalidParameter);
+  }
+  it->second.status = status;
+  return true;
+}
+
+bool InMemorySpooler::FinishJob(uint32_t jobId) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = jobs_.find(jobId);
+  if (it == jobs_.end() || !it->second.queued) {
+    return Fail(kErrorInvalidParameter);
+  }
+  it->second.queued = false;
+  return true;
+}
+
+std::vector<SpooledJob> InMemorySpooler::Jobs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<SpooledJob> jobs;
+  jobs.reserve(jobs_.size());
+  for (const auto& entry : jobs_) {
+    jobs.push_back(entry.second);
+  }
+  return jobs;
+}
+
+uint64_t InMemorySpooler::CompletedJobCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return completedJobs_;
+}
+
+size_t InMemorySpooler::OpenHandleCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return handles_.size();
+}
+
+bool InMemorySpooler::DefaultPrinterName(std::string* name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (defaultPrinter_.empty()) {
+    return Fail(kErrorNoDefaultPrinter);
+  }
+  *name = defaultPrinter_;
+  return true;
+}
+
+bool InMemorySpooler::Open(const std::string& printerName, PrinterHandle* handle) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  WaitIfHung(lock, SpoolerCall::kOpen, nullptr);
+  if (ShouldFail(SpoolerCall::kOpen)) return false;
+  if (std::find(printers_.begin(), printers_.end(), printerName) == printers_.end()) {
+    return Fail(kErrorInvalidPrinterName);
+  }
+  uintptr_t id = nextHandle_++;
+  handles_[id].printerName = printerName;
+  *handle = reinterpret_cast<PrinterHandle>(id);
+  return true;
+}
+
+uint32_t InMemorySpooler::StartDocument(PrinterHandle handle, const RawDocInfo& docInfo) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  WaitIfHung(lock, SpoolerCall::kStartDocument, handle);
+  OpenHandle* open = FindHandle(handle);
+  if (open == nullptr || ShouldFail(SpoolerCall::kStartDocument)) return 0;
+
+  SpooledJob& job = jobs_[nextJobId_];
+  job.jobId = nextJobId_++;
+  job.printerName = open->printerName;
+  job.documentName = docInfo.documentName;
+  job.datatype = docInfo.datatype;
+  job.queued = true;
+  job.status = kJobStatusSpooling;
+  open->jobId = job.jobId;
+  return job.jobId;
+}
+
+bool InMemorySpooler::StartPage(PrinterHandle handle) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!WaitIfHung(lock, SpoolerCall::kStartPage, handle)) return false;
+  OpenHandle* open = FindHandle(handle);
+  if (open == nullptr || JobCancelled(*open)) return false;
+  return !ShouldFail(SpoolerCall::kStartPage);
+}
+
+bool InMemorySpooler::Write(PrinterHandle handle, const uint8_t* data, uint32_t size,
+                            uint32_t* bytesWritten) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  *bytesWritten = 0;
+  if (!WaitIfHung(lock, SpoolerCall::kWrite, handle)) return false;
+  OpenHandle* open = FindHandle(handle);
+  if (open == nullptr || JobCancelled(*open) || ShouldFail(SpoolerCall::kWrite)) return false;
+  if (open->jobId == 0) return Fail(kErrorInvalidHandle);
+
+  uint32_t accepted = maxWriteSize_ == 0 ? size : std::min(size, maxWriteSize_);
+  if (!discardData_) {
+    std::vector<uint8_t>& jobData = jobs_[open->jobId].data;
+    jobData.insert(jobData.end(), data, data + accepted);
+  }
+  *bytesWritten = accepted;
+  return true;
+}
+
+bool InMemorySpooler::EndPage(PrinterHandle handle) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return FindHandle(handle) != nullptr;
+}
+
+bool InMemorySpooler::EndDocument(PrinterHandle handle) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!WaitIfHung(lock, SpoolerCall::kEndDocument, handle)) return false;
+  OpenHandle* open = FindHandle(handle);
+  if (open == nullptr || ShouldFail(SpoolerCall::kEndDocument)) return false;
+  if (open->jobId == 0) return Fail(kErrorInvalidHandle);
+  if (JobCancelled(*open)) {
+    open->jobId = 0;
+    return false;
+  }
+  if (discardData_) {
+    jobs_.erase(open->jobId);
+  } else {
+    SpooledJob& job = jobs_[open->jobId];
+    job.completed = true;
+    job.status &= ~kJobStatusSpooling;
+  }
+  completedJobs_++;
+  open->jobId = 0;
+  return true;
+}
+
+bool InMemorySpooler::Close(PrinterHandle handle) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (handles_.erase(reinterpret_cast<uintptr_t>(handle)) == 0) {
+    return Fail(kErrorInvalidHandle);
+  }
+  return true;
+}
+
+bool InMemorySpooler::SetJobCopies(PrinterHandle handle, uint32_t jobId, uint32_t copies) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  OpenHandle* open = FindHandle(handle);
+  if (open == nullptr) return false;
+  if (open->jobId == 0 || open->jobId != jobId) return Fail(kErrorInvalidParameter);
+  if (!makesCopies_) return Fail(kErrorNotSupported);
+  jobs_[jobId].copies = copies;
+  return true;
+}
+
+bool InMemorySpooler::CancelJob(const std::string& printerName, uint32_t jobId) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = jobs_.find(jobId);
+  if (it == jobs_.end() || it->second.printerName != printerName) {
+    return Fail(kErrorInvalidParameter);
+  }
+  it->second.cancelled = true;
+  it->second.queued = false;
+  hangChanged_.notify_all();
+  return true;
+}
+
+bool InMemorySpooler::EnumerateJobs(const std::string& printerName, std::vector<QueuedJob>* jobs) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  WaitIfHung(lock, SpoolerCall::kEnumerateJobs, nullptr);
+  if (ShouldFail(SpoolerCall::kEnumerateJobs)) return false;
+  if (std::find(printers_.begin(), printers_.end(), printerName) == printers_.end()) {
+    return Fail(kErrorInvalidPrinterName);
+  }
+  jobs->clear();
+  for (const auto& entry : jobs_) {
+    const SpooledJob& job = entry.second;
+    if (!job.queued || job.printerName != printerName) continue;
+    QueuedJob queued;
+    queued.jobId = job.jobId;
+    queued.status = job.status;
+    jobs->push_back(queued);
+  }
+  return true;
+}
+
+uint32_t InMemorySpooler::LastError() const {
+  return lastError;
+}
+
+bool InMemorySpooler::ShouldFail(SpoolerCall call) {
+  int index = static_cast<int>(call);
+  if (pendingFailures_[index] == 0) return false;
+  pendingFailures_[index]--;
+  lastError = failureErrors_[index];
+  return true;
+}
+
+bool InMemorySpooler::WaitIfHung(std::unique_lock<std::mutex>& lock, SpoolerCall call,
+                                 PrinterHandle handle) {
+  int index = static_cast<int>(call);
+  if (pendingHangs_[index] == 0) return true;
+  pendingHangs_[index]--;
+
+  const uint64_t generation = releaseGeneration_;
+  bool cancelled = false;
+  hungCalls_++;
+  hangChanged_.wait(lock, [this, generation, handle, &cancelled]() {
+    auto it = handles_.find(reinterpret_cast<uintptr_t>(handle));
+    cancelled = it != handles_.end() && JobCancelled(it->second);
+    return cancelled || releaseGeneration_ != generation;
+  });
+  hungCalls_--;
+  return !cancelled;
+}
+
+bool InMemorySpooler::JobCancelled(const OpenHandle& open) {
+  if (open.jobId == 0) return false;
+  auto it = jobs_.find(open.jobId);
+  if (it == jobs_.end() || !it->second.cancelled) return false;
+  lastError = kErrorPrintCancelled;
+  return true;
+}
+
+InMemorySpooler::OpenHandle* InMemorySpooler::FindHandle(PrinterHandle handle) {
+  auto it = handles_.find(reinterpret_cast<uintptr_t>(handle));
+  if (it == handles_.end()) {
+    lastError = kErrorInvalidHandle;
+    return nullptr;
+  }
+  return &it->second;
+}
+
+}  // namespace windows_printer
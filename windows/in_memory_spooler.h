@@ -0,0 +1,150 @@
+#ifndef FLUTTER_PLUGIN_IN_MEMORY_SPOOLER_H_
+#define FLUTTER_PLUGIN_IN_MEMORY_SPOOLER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "spooler_backend.h"
+
+namespace windows_printer {
+
+/// Spooler calls that can be made to fail or hang
+enum class SpoolerCall {
+  kOpen = 0,
+  kStartDocument,
+  kStartPage,
+  kWrite,
+  kEndDocument,
+  kEnumerateJobs,
+  kCount
+};
+
+/// A document received by InMemorySpooler
+struct SpooledJob {
+  uint32_t jobId = 0;
+  std::string printerName;
+  std::string documentName;
+  std::string datatype;
+  std::vector<uint8_t> data;
+  /// Copy count set with SetJobCopies
+  uint32_t copies = 1;
+  /// Set once EndDocument succeeded
+  bool completed = false;
+  /// Set by CancelJob
+  bool cancelled = false;
+  /// Listed by EnumerateJobs from StartDocument until FinishJob or CancelJob
+  bool queued = false;
+  /// kJobStatus* bits while queued
+  uint32_t status = 0;
+};
+
+// Thread-safe SpoolerBackend that keeps jobs in memory. Used by the unit
+// tests and benchmarks in place of the Windows spooler.
+class InMemorySpooler : public SpoolerBackend {
+public:
+  /// Error codes match their Win32 equivalents
+  static constexpr uint32_t kErrorInvalidHandle = 6;
+  static constexpr uint32_t kErrorNotSupported = 50;
+  static constexpr uint32_t kErrorPrintCancelled = 63;
+  static constexpr uint32_t kErrorInvalidParameter = 87;
+  static constexpr uint32_t kErrorInvalidPrinterName = 1801;
+  static constexpr uint32_t kErrorNoDefaultPrinter = 1814;
+
+  void AddPrinter(const std::string& printerName);
+  void SetDefaultPrinter(const std::string& printerName);
+
+  /// Make the next count calls of the given kind fail with error
+  void FailNext(SpoolerCall call, uint32_t error, int count = 1);
+
+  /// Make the next count calls of the given kind block until ReleaseHangs()
+  /// or, once a job has started on the handle, until the job is cancelled
+  void HangNext(SpoolerCall call, int count = 1);
+
+  /// Unblock every hung call and stop hanging new ones
+  void ReleaseHangs();
+
+  /// Number of calls blocked right now
+  size_t HungCallCount() const;
+
+  /// Accept at most this many bytes per Write call (0 = unlimited)
+  void SetMaxWriteSize(uint32_t maxWriteSize);
+
+  /// Drop job data and forget jobs once they complete (for benchmarks)
+  void SetDiscardData(bool discardData);
+
+  /// Let SetJobCopies succeed, as for a driver that makes copies. Off by
+  /// default, like a receipt printer taking RAW data.
+  void SetMakesCopies(bool makesCopies);
+
+  /// Simulate the printer: replace a queued job's kJobStatus* bits
+  bool SetJobStatus(uint32_t jobId, uint32_t status);
+
+  /// Take a job off its queue, as the spooler does once it has printed
+  bool FinishJob(uint32_t jobId);
+
+  /// Every job started so far, in job id order
+  std::vector<SpooledJob> Jobs() const;
+
+  /// Number of jobs that reached EndDocument
+  uint64_t CompletedJobCount() const;
+
+  /// Number of printer handles currently open
+  size_t OpenHandleCount() const;
+
+  bool DefaultPrinterName(std::string* name) override;
+  bool Open(const std::string& printerName, PrinterHandle* handle) override;
+  uint32_t StartDocument(PrinterHandle handle, const RawDocInfo& docInfo) override;
+  bool StartPage(PrinterHandle handle) override;
+  bool Write(PrinterHandle handle, const uint8_t* data, uint32_t size,
+             uint32_t* bytesWritten) override;
+  bool EndPage(PrinterHandle handle) override;
+  bool EndDocument(PrinterHandle handle) override;
+  bool Close(PrinterHandle handle) override;
+  bool SetJobCopies(PrinterHandle handle, uint32_t jobId, uint32_t copies) override;
+  bool CancelJob(const std::string& printerName, uint32_t jobId) override;
+  bool EnumerateJobs(const std::string& printerName, std::vector<QueuedJob>* jobs) override;
+  uint32_t LastError() const override;
+
+private:
+  struct OpenHandle {
+    std::string printerName;
+    /// Job started on this handle, 0 if none
+    uint32_t jobId = 0;
+  };
+
+  // Consumes a pending injected failure; must be called with mutex_ held
+  bool ShouldFail(SpoolerCall call);
+  // Blocks while an injected hang is pending for call. Returns false (with
+  // lastError set) if the handle's job was cancelled meanwhile.
+  bool WaitIfHung(std::unique_lock<std::mutex>& lock, SpoolerCall call, PrinterHandle handle);
+  // Finds an open handle; must be called with mutex_ held
+  OpenHandle* FindHandle(PrinterHandle handle);
+  // Fails calls on a handle whose job was cancelled; mutex_ held
+  bool JobCancelled(const OpenHandle& open);
+
+  mutable std::mutex mutex_;
+  std::condition_variable hangChanged_;
+  std::vector<std::string> printers_;
+  std::string defaultPrinter_;
+  std::map<uintptr_t, OpenHandle> handles_;
+  uintptr_t nextHandle_ = 1;
+  std::map<uint32_t, SpooledJob> jobs_;
+  uint32_t nextJobId_ = 1;
+  uint64_t completedJobs_ = 0;
+  uint32_t maxWriteSize_ = 0;
+  bool discardData_ = false;
+  bool makesCopies_ = false;
+  int pendingFailures_[static_cast<int>(SpoolerCall::kCount)] = {};
+  uint32_t failureErrors_[static_cast<int>(SpoolerCall::kCount)] = {};
+  int pendingHangs_[static_cast<int>(SpoolerCall::kCount)] = {};
+  uint64_t releaseGeneration_ = 0;
+  size_t hungCalls_ = 0;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_IN_MEMORY_SPOOLER_H_
@@ -0,0 +1,238 @@
+#ifndef FLUTTER_PLUGIN_WINDOWS_PRINTER_FFI_H_
+#define FLUTTER_PLUGIN_WINDOWS_PRINTER_FFI_H_
+
+// Synchronous C ABI for dart:ffi. Print data is read straight from the
+// caller's memory instead of being encoded by the method channel codec.
+//
+// The ABI is stable: functions are only ever added, enum values keep their
+// numbers and structs only grow at the end. Callers check
+// WindowsPrinterFfiVersion() before using anything newer than version 1;
+// the WindowsPrinterStream* functions need version 2, the print data
+// budget's result and metrics version 3,
+// WindowsPrinterEncodeReceiptImage version 4 and
+// WindowsPrinterEncodeReceiptImages version 5.
+//
+// Every function is safe to call from any thread. Calls block the calling
+// thread, so a Dart isolate waits until the spooler has taken the job. The
+// stream functions are the exception: they never wait for the spooler.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Only looked up at run time by dart:ffi, never linked against, so there is
+// no dllimport side.
+#if defined(_WIN32)
+#define WINDOWS_PRINTER_FFI_EXPORT __declspec(dllexport)
+#else
+#define WINDOWS_PRINTER_FFI_EXPORT __attribute__((visibility("default")))
+#endif
+
+#define WINDOWS_PRINTER_FFI_VERSION 5
+
+// Results of the WindowsPrinter* calls
+#define WINDOWS_PRINTER_FFI_OK 0
+#define WINDOWS_PRINTER_FFI_INVALID_ARGUMENT -1
+// The plugin has not been registered yet, or was unloaded
+#define WINDOWS_PRINTER_FFI_NOT_READY -2
+// A spooler call failed; the job's errorCode holds its Win32 error
+#define WINDOWS_PRINTER_FFI_FAILED -3
+// The deadline passed and the job, if it had started, was cancelled
+#define WINDOWS_PRINTER_FFI_TIMED_OUT -4
+// No tracked or recently finished job has that id
+#define WINDOWS_PRINTER_FFI_NOT_FOUND -5
+// The print data budget set by setQueueLimits had no room for the job
+// within its wait (version 3)
+#define WINDOWS_PRINTER_FFI_QUEUE_FULL -6
+// WindowsPrinterStreamCommit took the data, but the stream is above its high
+// watermark; write again after its WINDOWS_PRINTER_STREAM_WRITABLE event
+#define WINDOWS_PRINTER_FFI_PAUSED 1
+
+// WindowsPrinterJob.state, as reported on jobEvents
+#define WINDOWS_PRINTER_JOB_SPOOLING 0
+#define WINDOWS_PRINTER_JOB_PRINTING 1
+#define WINDOWS_PRINTER_JOB_PRINTED 2
+#define WINDOWS_PRINTER_JOB_ERROR 3
+#define WINDOWS_PRINTER_JOB_DELETED 4
+
+// Indices into WindowsPrinterMetrics.stages
+#define WINDOWS_PRINTER_STAGE_DECODE_ARGUMENTS 0
+#define WINDOWS_PRINTER_STAGE_ENCODE_RESULT 1
+#define WINDOWS_PRINTER_STAGE_OPEN_PRINTER 2
+#define WINDOWS_PRINTER_STAGE_QUERY_PRINTER 3
+#define WINDOWS_PRINTER_STAGE_START_DOC_PRINTER 4
+#define WINDOWS_PRINTER_STAGE_WRITE_PRINTER 5
+#define WINDOWS_PRINTER_STAGE_END_DOC_PRINTER 6
+#define WINDOWS_PRINTER_STAGE_COUNT 7
+
+// Stream events, delivered on the plugin's windows_printer/streams channel
+#define WINDOWS_PRINTER_STREAM_STARTED 0
+#define WINDOWS_PRINTER_STREAM_WRITABLE 1
+#define WINDOWS_PRINTER_STREAM_FINISHED 2
+#define WINDOWS_PRINTER_STREAM_FAILED 3
+#define WINDOWS_PRINTER_STREAM_CANCELLED 4
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct WindowsPrinterJob {
+  // Spooler job id, 0 if the job never started
+  uint32_t jobId;
+  // WINDOWS_PRINTER_JOB_*
+  int32_t state;
+  // JOB_STATUS_* bits last listed by the spooler
+  uint32_t status;
+  // Win32 error of the first failed spooler call, 0 on success
+  uint32_t errorCode;
+  uint32_t pagesPrinted;
+  uint32_t totalPages;
+  // Bytes handed to the spooler by this submission
+  uint64_t bytesWritten;
+} WindowsPrinterJob;
+
+typedef struct WindowsPrinterStageMetrics {
+  uint64_t count;
+  uint64_t p50Ns;
+  uint64_t p99Ns;
+  uint64_t maxNs;
+} WindowsPrinterStageMetrics;
+
+typedef struct WindowsPrinterMetrics {
+  // Set by the caller to sizeof(WindowsPrinterMetrics); fields past it are
+  // left alone, so older callers keep working when fields are added
+  uint32_t structSize;
+  uint32_t reserved;
+  uint64_t bytesWritten;
+  uint64_t queueDepth;
+  uint64_t peakQueueDepth;
+  // Failed spooler calls of every stage and error code
+  uint64_t failures;
+  WindowsPrinterStageMetrics stages[WINDOWS_PRINTER_STAGE_COUNT];
+  // Version 3: print data held under the budget, and submissions that
+  // found it full
+  uint64_t pendingJobs;
+  uint64_t pendingBytes;
+  uint64_t peakPendingBytes;
+  uint64_t spilledBytes;
+  uint64_t rejectedJobs;
+  uint64_t blockedJobs;
+  uint64_t spilledJobs;
+} WindowsPrinterMetrics;
+
+// One raw job fed continuously from a lock-free ring buffer in native
+// memory (version 2)
+typedef struct WindowsPrinterStream WindowsPrinterStream;
+
+typedef struct WindowsPrinterStreamInfo {
+  uint32_t streamId;
+  // Spooler job id once the job has started, otherwise 0
+  uint32_t jobId;
+  uint64_t capacity;
+  // Bytes committed and not yet handed to the spooler
+  uint64_t buffered;
+  uint64_t bytesWritten;
+  // Nonzero once a spooler call failed; commits fail from then on
+  int32_t failed;
+  uint32_t reserved;
+} WindowsPrinterStreamInfo;
+
+// WINDOWS_PRINTER_FFI_VERSION of the loaded plugin
+WINDOWS_PRINTER_FFI_EXPORT int32_t WindowsPrinterFfiVersion(void);
+
+// Native memory Dart can fill through Pointer.asTypedList and pass to
+// WindowsPrinterSubmitRawJob without another copy. NULL if size is 0 or the
+// allocation fails.
+WINDOWS_PRINTER_FFI_EXPORT uint8_t* WindowsPrinterAllocate(uint64_t size);
+WINDOWS_PRINTER_FFI_EXPORT void WindowsPrinterFree(void* buffer);
+
+// Print size bytes at data as one raw document, like printRawJob. A NULL or
+// empty printerName (UTF-8) selects the default printer. useRawDatatype
+// chooses "RAW" over "TEXT"; copies is 1 to 999. timeoutMs 0 waits as long
+// as the spooler does and writes straight from data; otherwise data is
+// copied once so the job can be abandoned at the deadline. On return *job
+// holds the job id, errorCode and bytesWritten, and a started job is
+// followed like one submitted through the method channel.
+//
+// The data counts against the print data budget until the job is spooled
+// or, when abandoned, its spooler call returns. A full budget fails at once
+// with WINDOWS_PRINTER_FFI_QUEUE_FULL, whatever its overflow policy, as
+// waiting for room would block the calling isolate.
+WINDOWS_PRINTER_FFI_EXPORT int32_t WindowsPrinterSubmitRawJob(
+    const char* printerName, const uint8_t* data, uint64_t size,
+    int32_t useRawDatatype, int32_t copies, uint32_t timeoutMs,
+    WindowsPrinterJob* job);
+
+// Latest known state of a job submitted by either path. A NULL or empty
+// printerName matches the job on any printer. Does not wait for the spooler.
+WINDOWS_PRINTER_FFI_EXPORT int32_t WindowsPrinterGetJob(
+    const char* printerName, uint32_t jobId, WindowsPrinterJob* job);
+
+// Copy the counters and stage latencies that getMetrics reports. Fields past
+// metrics->structSize are left alone; it must cover at least the version 1
+// fields.
+WINDOWS_PRINTER_FFI_EXPORT int32_t WindowsPrinterGetMetrics(
+    WindowsPrinterMetrics* metrics);
+
+// Start a raw job on printerName (UTF-8, NULL or empty for the default
+// printer) fed through a ring buffer of capacity bytes, rounded up to a power
+// of two; 0 selects 1 MiB. A commit reaching highWatermark buffered bytes
+// returns WINDOWS_PRINTER_FFI_PAUSED, and WINDOWS_PRINTER_STREAM_WRITABLE
+// follows once the buffer drains to lowWatermark; 0 selects three quarters
+// and a quarter of the capacity. A writer thread opens the printer and
+// writes as data arrives; its events carry *streamId. Returns without
+// waiting for the spooler.
+WINDOWS_PRINTER_FFI_EXPORT int32_t WindowsPrinterStreamOpen(
+    const char* printerName, uint64_t capacity, uint64_t lowWatermark,
+    uint64_t highWatermark, int32_t useRawDatatype,
+    WindowsPrinterStream** stream, uint32_t* streamId);
+
+// Contiguous free space in the ring buffer to write into, its size in
+// *length. *length is 0 when the buffer is full or the stream has failed.
+// The memory stays valid until the stream is closed. Lock-free.
+WINDOWS_PRINTER_FFI_EXPORT uint8_t* WindowsPrinterStreamReserve(
+    WindowsPrinterStream* stream, uint64_t* length);
+
+// Hand the first length bytes of the last reserved space to the writer.
+// Returns WINDOWS_PRINTER_FFI_OK, WINDOWS_PRINTER_FFI_PAUSED, or
+// WINDOWS_PRINTER_FFI_FAILED once the stream has failed. Lock-free.
+WINDOWS_PRINTER_FFI_EXPORT int32_t WindowsPrinterStreamCommit(
+    WindowsPrinterStream* stream, uint64_t length);
+
+WINDOWS_PRINTER_FFI_EXPORT int32_t WindowsPrinterStreamGetInfo(
+    WindowsPrinterStream* stream, WindowsPrinterStreamInfo* info);
+
+// Release the handle. With abort 0 the writer prints everything committed
+// and ends the job (WINDOWS_PRINTER_STREAM_FINISHED); otherwise the job is
+// cancelled (WINDOWS_PRINTER_STREAM_CANCELLED). Returns without waiting.
+WINDOWS_PRINTER_FFI_EXPORT int32_t WindowsPrinterStreamClose(
+    WindowsPrinterStream* stream, int32_t abort);
+
+// Decode a PNG or baseline JPEG image and encode it as ESC/POS bit image
+// bands width dots across (384 for 58 mm paper, 576 for 80 mm), keeping its
+// aspect ratio. dither 0 thresholds at 128 like WPESCPOSGenerator.image;
+// otherwise the image is Floyd-Steinberg dithered. The full-size image is
+// never held in color: rows are scaled and dithered as they are decoded. On
+// success *output holds *outputSize bytes to release with WindowsPrinterFree.
+// On failure a NUL-terminated message of at most errorSize bytes is written
+// to error when it is not NULL. Does not need the plugin to be registered
+// (version 4).
+WINDOWS_PRINTER_FFI_EXPORT int32_t WindowsPrinterEncodeReceiptImage(
+    const uint8_t* image, uint64_t size, int32_t width, int32_t dither,
+    uint8_t** output, uint64_t* outputSize, char* error, uint32_t errorSize);
+
+// Encode count images as WindowsPrinterEncodeReceiptImage does, in parallel
+// on the plugin's shared worker threads. results[i] is image i's result;
+// when it is WINDOWS_PRINTER_FFI_OK, outputs[i] holds outputSizes[i] bytes
+// to release with WindowsPrinterFree, otherwise it is NULL. Returns the
+// first failure in image order, with its message in error, or
+// WINDOWS_PRINTER_FFI_OK when every image was encoded (version 5).
+WINDOWS_PRINTER_FFI_EXPORT int32_t WindowsPrinterEncodeReceiptImages(
+    uint32_t count, const uint8_t* const* images, const uint64_t* sizes, int32_t width,
+    int32_t dither, uint8_t** outputs, uint64_t* outputSizes, int32_t* results, char* error,
+    uint32_t errorSize);
+
+#if defined(__cplusplus)
+}  // extern "C"
+#endif
+
+#endif  // FLUTTER_PLUGIN_WINDOWS_PRINTER_FFI_H_
@@ -0,0 +1,241 @@
+#include "job_tracker.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace windows_printer {
+
+namespace {
+
+// ERROR_INVALID_PRINTER_NAME; the printer was removed with its queue
+constexpr uint32_t kErrorInvalidPrinterName = 1801;
+
+constexpr uint32_t kErrorStatusBits = kJobStatusError | kJobStatusOffline | kJobStatusPaperOut |
+                                      kJobStatusBlockedDevq | kJobStatusUserIntervention;
+
+// Bits after which a job leaving the queue cannot have printed. Spooling is
+// not one of them: streams and short jobs often print between two polls.
+constexpr uint32_t kDeletingStatusBits = kJobStatusDeleting | kJobStatusDeleted;
+
+using JobKey = std::pair<std::string, uint32_t>;
+
+struct ActiveJob {
+  TrackedJob job;
+  /// Cancelled through MarkCancelled
+  bool cancelled = false;
+};
+
+bool MatchesJob(const JobKey& key, const std::string& printerName, uint32_t jobId) {
+  return key.second == jobId && (printerName.empty() || key.first == printerName);
+}
+
+}  // namespace
+
+JobState JobStateFromStatus(uint32_t status) {
+  if ((status & (kJobStatusDeleting | kJobStatusDeleted)) != 0) return JobState::kDeleted;
+  // Set instead of leaving the queue when the printer keeps printed documents
+  if ((status & kJobStatusPrinted) != 0) return JobState::kPrinted;
+  if ((status & kErrorStatusBits) != 0) return JobState::kError;
+  // Complete means sent to the printer, which may still be printing it
+  if ((status & (kJobStatusPrinting | kJobStatusComplete)) != 0) return JobState::kPrinting;
+  return JobState::kSpooling;
+}
+
+bool IsFinalJobState(JobState state) {
+  return state == JobState::kPrinted || state == JobState::kDeleted;
+}
+
+struct JobTracker::State {
+  std::shared_ptr<SpoolerBackend> backend;
+  JobTrackerOptions options;
+
+  mutable std::mutex mutex;
+  std::condition_variable wakeup;
+  // Ordered by printer so a poll walks each printer's jobs together
+  std::map<JobKey, ActiveJob> active;
+  // Oldest first
+  std::deque<TrackedJob> finished;
+  JobListener listener;
+  bool pollerStarted = false;
+  bool stopped = false;
+
+  // Must be called with mutex held
+  void Emit(const TrackedJob& job) {
+    if (listener) listener(job);
+  }
+
+  // Reports a job's final state and moves it to the history; mutex held
+  std::map<JobKey, ActiveJob>::iterator Finish(std::map<JobKey, ActiveJob>::iterator it,
+                                               JobState state) {
+    TrackedJob& job = it->second.job;
+    job.state = state;
+    Emit(job);
+    finished.push_back(std::move(job));
+    while (finished.size() > options.finishedJobHistory) {
+      finished.pop_front();
+    }
+    return active.erase(it);
+  }
+};
+
+JobTracker::JobTracker(std::shared_ptr<SpoolerBackend> backend, JobTrackerOptions options)
+    : state_(std::make_shared<State>()) {
+  state_->backend = std::move(backend);
+  state_->options = options;
+}
+
+JobTracker::~JobTracker() {
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->stopped = true;
+    state_->listener = nullptr;
+  }
+  state_->wakeup.notify_all();
+}
+
+void JobTracker::SetListener(JobListener listener) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->listener = std::move(listener);
+}
+
+void JobTracker::Track(const std::string& printerName, uint32_t jobId,
+                       const std::string& documentName) {
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    auto inserted = state_->active.emplace(JobKey(printerName, jobId), ActiveJob());
+    if (!inserted.second) return;
+    TrackedJob& job = inserted.first->second.job;
+    job.jobId = jobId;
+    job.printerName = printerName;
+    job.documentName = documentName;
+    state_->Emit(job);
+
+    if (!state_->pollerStarted && state_->options.pollInterval.count() > 0) {
+      state_->pollerStarted = true;
+      std::thread(&JobTracker::RunPoller, state_).detach();
+    }
+  }
+  state_->wakeup.notify_all();
+}
+
+void JobTracker::MarkCancelled(const std::string& printerName, uint32_t jobId) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  for (auto& entry : state_->active) {
+    if (MatchesJob(entry.first, printerName, jobId)) {
+      entry.second.cancelled = true;
+    }
+  }
+}
+
+void JobTracker::Poll() {
+  PollQueues(*state_);
+}
+
+bool JobTracker::Find(const std::string& printerName, uint32_t jobId, TrackedJob* job) const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  for (const auto& entry : state_->active) {
+    if (MatchesJob(entry.first, printerName, jobId)) {
+      *job = entry.second.job;
+      return true;
+    }
+  }
+  for (auto it = state_->finished.rbegin(); it != state_->finished.rend(); ++it) {
+    if (MatchesJob(JobKey(it->printerName, it->jobId), printerName, jobId)) {
+      *job = *it;
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t JobTracker::ActiveJobCount() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->active.size();
+}
+
+void JobTracker::PollQueues(State& state) {
+  std::vector<std::string> printers;
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (const auto& entry : state.active) {
+      if (printers.empty() || printers.back() != entry.first.first) {
+        printers.push_back(entry.first.first);
+      }
+    }
+  }
+
+  std::vector<QueuedJob> queue;
+  for (const std::string& printerName : printers) {
+    // Listed without the lock; a remote queue can take a while to answer
+    queue.clear();
+    const bool listed = state.backend->EnumerateJobs(printerName, &queue);
+    const uint32_t error = listed ? 0 : state.backend->LastError();
+    std::sort(queue.begin(), queue.end(),
+              [](const QueuedJob& a, const QueuedJob& b) { return a.jobId < b.jobId; });
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.stopped) return;
+    auto it = state.active.lower_bound(JobKey(printerName, 0));
+    while (it != state.active.end() && it->first.first == printerName) {
+      if (!listed) {
+        // Other failures are retried on the next poll
+        if (error == kErrorInvalidPrinterName) {
+          it = state.Finish(it, JobState::kDeleted);
+        } else {
+          ++it;
+        }
+        continue;
+      }
+
+      const uint32_t jobId = it->first.second;
+      auto queued = std::lower_bound(
+          queue.begin(), queue.end(), jobId,
+          [](const QueuedJob& entry, uint32_t id) { return entry.jobId < id; });
+      TrackedJob& job = it->second.job;
+      if (queued == queue.end() || queued->jobId != jobId) {
+        const bool deleted = it->second.cancelled || (job.status & kDeletingStatusBits) != 0;
+        it = state.Finish(it, deleted ? JobState::kDeleted : JobState::kPrinted);
+        continue;
+      }
+
+      job.status = queued->status;
+      job.pagesPrinted = queued->pagesPrinted;
+      job.totalPages = queued->totalPages;
+      const JobState next = JobStateFromStatus(queued->status);
+      if (IsFinalJobState(next)) {
+        it = state.Finish(it, next);
+        continue;
+      }
+      if (next != job.state) {
+        job.state = next;
+        state.Emit(job);
+      }
+      ++it;
+    }
+  }
+}
+
+void JobTracker::RunPoller(std::shared_ptr<State> state) {
+  std::unique_lock<std::mutex> lock(state->mutex);
+  while (!state->stopped) {
+    if (state->active.empty()) {
+      state->wakeup.wait(lock, [&state]() { return state->stopped || !state->active.empty(); });
+      continue;
+    }
+    if (state->wakeup.wait_for(lock, state->options.pollInterval,
+                               [&state]() { return state->stopped; })) {
+      break;
+    }
+    lock.unlock();
+    PollQueues(*state);
+    lock.lock();
+  }
+}
+
+}  // namespace windows_printer
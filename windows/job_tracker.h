@@ -0,0 +1,108 @@
+#ifndef FLUTTER_PLUGIN_JOB_TRACKER_H_
+#define FLUTTER_PLUGIN_JOB_TRACKER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "spooler_backend.h"
+
+namespace windows_printer {
+
+enum class JobState {
+  /// In the queue, receiving data or waiting for the printer
+  kSpooling = 0,
+  kPrinting,
+  /// Final: sent to the printer and gone from the queue
+  kPrinted,
+  /// Held up by the printer, e.g. offline or out of paper. The job stays
+  /// queued and may still print.
+  kError,
+  /// Final: cancelled or deleted before it printed
+  kDeleted,
+};
+
+/// State that a queued job's kJobStatus* bits stand for
+JobState JobStateFromStatus(uint32_t status);
+
+/// Whether no further events follow a job in this state
+bool IsFinalJobState(JobState state);
+
+struct TrackedJob {
+  uint32_t jobId = 0;
+  std::string printerName;
+  std::string documentName;
+  JobState state = JobState::kSpooling;
+  /// kJobStatus* bits last listed by the spooler
+  uint32_t status = 0;
+  uint32_t pagesPrinted = 0;
+  uint32_t totalPages = 0;
+};
+
+/// Receives a job each time its state changes. Called with the tracker lock
+/// held, from the thread calling Track or from the poller, so it must be
+/// quick and must not call back into JobTracker.
+using JobListener = std::function<void(const TrackedJob& job)>;
+
+struct JobTrackerOptions {
+  /// How often the queues are listed while jobs are tracked; zero lists them
+  /// only when Poll() is called
+  std::chrono::milliseconds pollInterval{250};
+  /// Finished jobs kept for Find
+  size_t finishedJobHistory = 64;
+};
+
+// Follows submitted jobs through the spooler queue and reports each state
+// change. A poll lists the queue of every printer with tracked jobs once,
+// however many jobs it holds. The spooler forgets a job when it leaves the
+// queue, so a job that disappears is reported printed unless it was last
+// seen being deleted, or was cancelled through MarkCancelled.
+class JobTracker {
+public:
+  explicit JobTracker(std::shared_ptr<SpoolerBackend> backend,
+                      JobTrackerOptions options = JobTrackerOptions());
+
+  /// Does not wait for a poll in progress; the poller keeps its own
+  /// reference to the shared state and exits on its own.
+  ~JobTracker();
+
+  JobTracker(const JobTracker&) = delete;
+  JobTracker& operator=(const JobTracker&) = delete;
+
+  /// Replaces any previous listener
+  void SetListener(JobListener listener);
+
+  /// Start following a job submitted to printerName and report it spooling.
+  /// A job that is already tracked is left as it is.
+  void Track(const std::string& printerName, uint32_t jobId, const std::string& documentName);
+
+  /// Report a job cancelled through this process as deleted once it leaves
+  /// the queue. An empty printerName matches the job on any printer.
+  void MarkCancelled(const std::string& printerName, uint32_t jobId);
+
+  /// List the queues once and report what changed. Called by the poller;
+  /// tests call it directly.
+  void Poll();
+
+  /// A tracked or recently finished job. An empty printerName matches the
+  /// job on any printer.
+  bool Find(const std::string& printerName, uint32_t jobId, TrackedJob* job) const;
+
+  /// Number of jobs still being followed
+  size_t ActiveJobCount() const;
+
+private:
+  struct State;
+
+  static void PollQueues(State& state);
+  static void RunPoller(std::shared_ptr<State> state);
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_JOB_TRACKER_H_
@@ -0,0 +1,203 @@
+#include "label_layout.h"
+
+#include <algorithm>
+
+#include "mono_bitmap.h"
+#include "tspl_encoder.h"
+#include "zpl_encoder.h"
+
+namespace windows_printer {
+
+namespace {
+
+// Keeps field variables to two digits (F99$) and sizes within what the
+// printers accept
+constexpr int kMaxField = 99;
+constexpr int kMaxDots = 32000;
+
+bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+bool DigitsInRange(std::string_view data, size_t minLength, size_t maxLength) {
+  return data.size() >= minLength && data.size() <= maxLength &&
+         std::all_of(data.begin(), data.end(), IsDigit);
+}
+
+const LabelElement* FindField(const LabelLayout& layout, int field) {
+  if (field <= 0) return nullptr;
+  for (const LabelElement& element : layout.elements) {
+    if (element.field == field) return &element;
+  }
+  return nullptr;
+}
+
+MonoBitmap ElementBitmap(const LabelElement& element) {
+  return MonoBitmap::FromRgba(element.rgba.data(), element.rgba.size(), element.imageWidth,
+                              element.imageHeight);
+}
+
+// Fields become placeholders only in stored formats. ZplEncoder and
+// TsplEncoder share the element methods.
+template <typename Encoder>
+void EncodeElements(const LabelLayout& layout, bool format, Encoder* encoder) {
+  for (const LabelElement& element : layout.elements) {
+    const int field = format ? element.field : 0;
+    switch (element.type) {
+      case LabelElementType::kText:
+        encoder->Text(element.x, element.y, element.data, element.height, element.width, field);
+        break;
+      case LabelElementType::kBarcode:
+        encoder->Barcode(element.x, element.y, element.barcodeType, element.data, element.height,
+                         element.width > 0 ? element.width : 2, element.showText, field);
+        break;
+      case LabelElementType::kQrCode:
+        encoder->QrCode(element.x, element.y, element.data, element.width > 0 ? element.width : 4,
+                        field);
+        break;
+      case LabelElementType::kGraphic:
+        encoder->Graphic(element.x, element.y, ElementBitmap(element));
+        break;
+    }
+  }
+}
+
+}  // namespace
+
+bool IsValidLabelBarcodeData(LabelBarcodeType type, std::string_view data) {
+  switch (type) {
+    case LabelBarcodeType::kCode128:
+      return !data.empty() && data.size() <= 255 &&
+             std::all_of(data.begin(), data.end(), [](char c) { return c >= 0x20 && c < 0x7F; });
+    case LabelBarcodeType::kCode39:
+      return !data.empty() && data.size() <= 255 &&
+             std::all_of(data.begin(), data.end(), [](char c) {
+               return IsDigit(c) || (c >= 'A' && c <= 'Z') ||
+                      std::string_view(" -.$/+%").find(c) != std::string_view::npos;
+             });
+    case LabelBarcodeType::kEan13:
+      return DigitsInRange(data, 12, 13);
+    case LabelBarcodeType::kEan8:
+      return DigitsInRange(data, 7, 8);
+    case LabelBarcodeType::kUpcA:
+      return DigitsInRange(data, 11, 12);
+  }
+  return false;
+}
+
+bool IsValidLabelFormatName(std::string_view name) {
+  return !name.empty() && name.size() <= 8 && std::all_of(name.begin(), name.end(), [](char c) {
+    return IsDigit(c) || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+  });
+}
+
+std::string ValidateLabelLayout(const LabelLayout& layout) {
+  if (layout.dotsPerMm < 1 || layout.dotsPerMm > 24) {
+    return "dotsPerMm must be between 1 and 24";
+  }
+  if (layout.widthMm < 0 || layout.heightMm < 0 || layout.gapMm < 0 ||
+      layout.widthMm > kMaxDots || layout.heightMm > kMaxDots || layout.gapMm > kMaxDots ||
+      layout.widthMm * layout.dotsPerMm > kMaxDots ||
+      layout.heightMm * layout.dotsPerMm > kMaxDots) {
+    return "Label size is out of range";
+  }
+  for (size_t i = 0; i < layout.elements.size(); i++) {
+    const LabelElement& element = layout.elements[i];
+    const std::string name = "Element " + std::to_string(i);
+    if (element.x < 0 || element.y < 0 || element.x > kMaxDots || element.y > kMaxDots) {
+      return name + ": position is out of range";
+    }
+    if (element.field < 0 || element.field > kMaxField) {
+      return name + ": field must be between 1 and " + std::to_string(kMaxField);
+    }
+    if (element.field > 0 && element.type == LabelElementType::kGraphic) {
+      return name + ": graphics cannot be fields";
+    }
+    if (element.height < 1 || element.height > kMaxDots || element.width < 0 ||
+        element.width > kMaxDots) {
+      return name + ": size is out of range";
+    }
+    switch (element.type) {
+      case LabelElementType::kText:
+        break;
+      case LabelElementType::kBarcode:
+        if (element.field == 0 && !IsValidLabelBarcodeData(element.barcodeType, element.data)) {
+          return name + ": data is invalid for the barcode type";
+        }
+        break;
+      case LabelElementType::kQrCode:
+        if (element.field == 0 && element.data.empty()) {
+          return name + ": QR code data is empty";
+        }
+        break;
+      case LabelElementType::kGraphic:
+        if (element.imageWidth < 1 || element.imageHeight < 1 ||
+            element.imageWidth > kMaxDots || element.imageHeight > kMaxDots ||
+            element.rgba.size() <
+                static_cast<size_t>(element.imageWidth) * element.imageHeight * 4) {
+          return name + ": graphic needs width * height * 4 bytes of RGBA";
+        }
+        break;
+    }
+  }
+  return std::string();
+}
+
+std::vector<uint8_t> EncodeLabel(LabelLanguage language, const LabelLayout& layout, int copies) {
+  if (language == LabelLanguage::kTspl) {
+    TsplEncoder encoder;
+    encoder.Setup(layout.widthMm, layout.heightMm, layout.gapMm);
+    EncodeElements(layout, false, &encoder);
+    encoder.Print(copies);
+    return encoder.Bytes();
+  }
+  ZplEncoder encoder;
+  encoder.StartLabel(layout.widthMm * layout.dotsPerMm, layout.heightMm * layout.dotsPerMm);
+  EncodeElements(layout, false, &encoder);
+  encoder.EndLabel(copies);
+  return encoder.Bytes();
+}
+
+std::vector<uint8_t> EncodeLabelFormat(LabelLanguage language, const LabelLayout& layout,
+                                       std::string_view name) {
+  if (language == LabelLanguage::kTspl) {
+    TsplEncoder encoder;
+    encoder.StartFormat(name);
+    encoder.Setup(layout.widthMm, layout.heightMm, layout.gapMm);
+    EncodeElements(layout, true, &encoder);
+    encoder.Print(1);
+    encoder.EndFormat();
+    return encoder.Bytes();
+  }
+  ZplEncoder encoder;
+  encoder.StartFormat(name, layout.widthMm * layout.dotsPerMm, layout.heightMm * layout.dotsPerMm);
+  EncodeElements(layout, true, &encoder);
+  encoder.EndLabel();
+  return encoder.Bytes();
+}
+
+std::vector<uint8_t> EncodeLabelRecall(LabelLanguage language, const LabelLayout& layout,
+                                       std::string_view name,
+                                       const std::map<int, std::string>& fields, int copies) {
+  if (language == LabelLanguage::kTspl) {
+    TsplEncoder encoder;
+    for (const auto& [field, value] : fields) {
+      if (FindField(layout, field)) encoder.FieldData(field, value);
+    }
+    // The stored program prints one label per run
+    for (int i = 0; i < std::max(1, copies); i++) {
+      encoder.RunFormat(name);
+    }
+    return encoder.Bytes();
+  }
+  ZplEncoder encoder;
+  encoder.RecallFormat(name);
+  for (const auto& [field, value] : fields) {
+    const LabelElement* element = FindField(layout, field);
+    if (element) encoder.FieldData(field, value, element->type == LabelElementType::kQrCode);
+  }
+  encoder.EndLabel(copies);
+  return encoder.Bytes();
+}
+
+}  // namespace windows_printer
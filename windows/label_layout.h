@@ -0,0 +1,101 @@
+#ifndef FLUTTER_PLUGIN_LABEL_LAYOUT_H_
+#define FLUTTER_PLUGIN_LABEL_LAYOUT_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace windows_printer {
+
+/// Command language of a label printer
+enum class LabelLanguage {
+  /// Zebra Programming Language II
+  kZpl = 0,
+  /// TSC Printer Language
+  kTspl,
+};
+
+enum class LabelBarcodeType {
+  kCode128 = 0,
+  kCode39,
+  kEan13,
+  kEan8,
+  kUpcA,
+};
+
+enum class LabelElementType {
+  kText = 0,
+  kBarcode,
+  kQrCode,
+  kGraphic,
+};
+
+struct LabelElement {
+  LabelElementType type = LabelElementType::kText;
+  /// Top-left corner in dots
+  int x = 0;
+  int y = 0;
+  /// Fixed content of a text, barcode or QR code element
+  std::string data;
+  /// Variable field number, 1 or more, in place of data. A stored format
+  /// keeps a placeholder that every recall fills. 0 for fixed content.
+  int field = 0;
+  /// Text: character height. Barcode: bar height. In dots.
+  int height = 30;
+  /// Text: character width in dots, 0 for the height. Barcode: narrow bar
+  /// width in dots. QR code: module size in dots.
+  int width = 0;
+  LabelBarcodeType barcodeType = LabelBarcodeType::kCode128;
+  /// Print a barcode's digits under it
+  bool showText = true;
+  /// Graphic: RGBA pixels, thresholded like ESC/POS images
+  std::vector<uint8_t> rgba;
+  int imageWidth = 0;
+  int imageHeight = 0;
+};
+
+struct LabelLayout {
+  /// Label size; 0 leaves the printer's setting alone
+  int widthMm = 0;
+  int heightMm = 0;
+  /// Gap between labels (TSPL only)
+  int gapMm = 2;
+  /// Print head resolution: 8 for 203 dpi, 12 for 300 dpi
+  int dotsPerMm = 8;
+  std::vector<LabelElement> elements;
+};
+
+/// Whether data can be encoded as a barcode of type by both languages
+bool IsValidLabelBarcodeData(LabelBarcodeType type, std::string_view data);
+
+/// Stored format names are 1 to 8 letters, digits or underscores, so they
+/// are valid file names on both Zebra (R:NAME.ZPL) and TSC (NAME.BAS)
+/// printers
+bool IsValidLabelFormatName(std::string_view name);
+
+/// Check a layout before encoding it. Returns an empty string when it is
+/// valid, otherwise a message naming the offending element.
+std::string ValidateLabelLayout(const LabelLayout& layout);
+
+/// A complete label printed copies times. Variable fields print their data.
+std::vector<uint8_t> EncodeLabel(LabelLanguage language, const LabelLayout& layout,
+                                 int copies = 1);
+
+/// Store the layout on the printer as name without printing it. Sent once;
+/// afterwards EncodeLabelRecall prints it by sending only the fields.
+std::vector<uint8_t> EncodeLabelFormat(LabelLanguage language, const LabelLayout& layout,
+                                       std::string_view name);
+
+/// Print the stored format name with its variable fields filled, copies
+/// times. layout is the stored one; only its fields' element types are
+/// used, so graphics may be left out. Unknown field numbers are ignored.
+std::vector<uint8_t> EncodeLabelRecall(LabelLanguage language, const LabelLayout& layout,
+                                       std::string_view name,
+                                       const std::map<int, std::string>& fields,
+                                       int copies = 1);
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_LABEL_LAYOUT_H_
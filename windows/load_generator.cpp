@@ -0,0 +1,273 @@
+#include "load_generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+#include <utility>
+
+#include "job_tracker.h"
+#include "print_job.h"
+
+namespace windows_printer {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct PendingJob {
+  Clock::time_point start;
+  size_t priority = 0;
+};
+
+// Shared by the submitting threads and the tracker's listener
+struct LoadState {
+  std::mutex mutex;
+  std::map<std::pair<std::string, uint32_t>, PendingJob> pending;
+  std::atomic<uint64_t> submitted{0};
+  std::atomic<uint64_t> printed{0};
+  std::atomic<uint64_t> failed{0};
+  std::atomic<uint64_t> bytes{0};
+  LatencyHistogram submitLatency;
+  LatencyHistogram completeLatency;
+  /// One per distinct priority, highest first
+  std::vector<int> priorities;
+  std::vector<std::unique_ptr<LatencyHistogram>> priorityLatency;
+};
+
+uint64_t Nanos(Clock::duration duration) {
+  return static_cast<uint64_t>(
+      std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+}
+
+// Diagonal stripes, so the image bands are not all blank or all black
+std::vector<uint8_t> MakeLogo(int width, int height) {
+  std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4, 0xFF);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      if ((x + y) / 8 % 2 == 0) {
+        uint8_t* pixel = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+        pixel[0] = pixel[1] = pixel[2] = 0;
+      }
+    }
+  }
+  return rgba;
+}
+
+std::vector<uint8_t> EncodeJob(const LoadJobKind& kind, const std::vector<uint8_t>& logo,
+                               uint64_t number) {
+  EscPosEncoder encoder(kind.paperSize);
+  if (!logo.empty()) {
+    encoder.Image(logo.data(), logo.size(), kind.imageWidth, kind.imageHeight);
+  }
+  EscPosTextStyle heading;
+  heading.align = EscPosTextAlign::kCenter;
+  heading.bold = true;
+  heading.size = EscPosTextSize::kDoubleHeight;
+  encoder.Text("Order " + std::to_string(number), heading);
+  encoder.Separator();
+  for (int line = 0; line < kind.lines; line++) {
+    encoder.Text(std::to_string(line % 3 + 1) + " x Item " + std::to_string(line) +
+                 "                 " + std::to_string(line % 20 + 1) + ".50");
+  }
+  encoder.Separator();
+  encoder.Feed(3);
+  encoder.Cut();
+  return encoder.Bytes();
+}
+
+void RunSubmitter(size_t thread, const std::shared_ptr<SpoolerBackend>& backend,
+                  JobTracker& tracker, LoadState& state, const LoadOptions& options,
+                  const std::vector<std::vector<uint8_t>>& logos,
+                  const std::vector<size_t>& kindPriority, Clock::time_point start,
+                  Clock::time_point end) {
+  std::mt19937 random(options.seed + static_cast<uint32_t>(thread));
+  std::vector<double> weights;
+  for (const LoadJobKind& kind : options.mix) {
+    weights.push_back(kind.weight);
+  }
+  std::discrete_distribution<size_t> pickKind(weights.begin(), weights.end());
+
+  RawPrintOptions printOptions;
+  printOptions.timeout = options.timeout;
+  for (uint64_t job = 0;; job++) {
+    Clock::time_point jobStart = Clock::now();
+    if (options.jobsPerSecond > 0.0) {
+      // Threads take turns at the overall rate
+      const double slot = static_cast<double>(job * options.threads + thread);
+      jobStart = start + std::chrono::duration_cast<Clock::duration>(
+                             std::chrono::duration<double>(slot / options.jobsPerSecond));
+      if (jobStart >= end) return;
+      std::this_thread::sleep_until(jobStart);
+    } else if (jobStart >= end) {
+      return;
+    }
+
+    const size_t kindIndex = pickKind(random);
+    const LoadJobKind& kind = options.mix[kindIndex];
+    const std::string& printerName = options.printers[(thread + job) % options.printers.size()];
+    const std::vector<uint8_t> data = EncodeJob(kind, logos[kindIndex], job);
+    printOptions.documentName = kind.name;
+
+    const Clock::time_point submitStart = Clock::now();
+    RawPrintResult result =
+        SubmitRawJob(backend, printerName, data.data(), data.size(), printOptions);
+    state.submitLatency.Record(Nanos(Clock::now() - submitStart));
+    state.submitted.fetch_add(1, std::memory_order_relaxed);
+    if (!result.success) {
+      state.failed.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    state.bytes.fetch_add(data.size(), std::memory_order_relaxed);
+    {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      state.pending[{result.printerName, result.jobId}] = {jobStart, kindPriority[kindIndex]};
+    }
+    tracker.Track(result.printerName, result.jobId, kind.name);
+  }
+}
+
+}  // namespace
+
+LoadReport RunLoad(std::shared_ptr<SpoolerBackend> backend, const LoadOptions& options) {
+  LoadReport report;
+  if (options.printers.empty() || options.mix.empty() || options.threads == 0) {
+    return report;
+  }
+
+  auto state = std::make_shared<LoadState>();
+  std::vector<size_t> kindPriority;
+  for (const LoadJobKind& kind : options.mix) {
+    state->priorities.push_back(kind.priority);
+  }
+  std::sort(state->priorities.begin(), state->priorities.end(), std::greater<int>());
+  state->priorities.erase(std::unique(state->priorities.begin(), state->priorities.end()),
+                          state->priorities.end());
+  for (const LoadJobKind& kind : options.mix) {
+    kindPriority.push_back(static_cast<size_t>(
+        std::find(state->priorities.begin(), state->priorities.end(), kind.priority) -
+        state->priorities.begin()));
+  }
+  for (size_t i = 0; i < state->priorities.size(); i++) {
+    state->priorityLatency.push_back(std::make_unique<LatencyHistogram>());
+  }
+  std::vector<std::vector<uint8_t>> logos;
+  for (const LoadJobKind& kind : options.mix) {
+    logos.push_back(kind.imageWidth > 0 && kind.imageHeight > 0
+                        ? MakeLogo(kind.imageWidth, kind.imageHeight)
+                        : std::vector<uint8_t>());
+  }
+
+  JobTrackerOptions trackerOptions;
+  trackerOptions.pollInterval = options.pollInterval;
+  // Jobs are looked up through the listener, not Find
+  trackerOptions.finishedJobHistory = 1;
+  JobTracker tracker(backend, trackerOptions);
+  tracker.SetListener([state](const TrackedJob& job) {
+    if (!IsFinalJobState(job.state)) return;
+    const Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(state->mutex);
+    auto iter = state->pending.find({job.printerName, job.jobId});
+    if (iter == state->pending.end()) return;
+    if (job.state == JobState::kPrinted) {
+      const uint64_t latency = Nanos(now - iter->second.start);
+      state->completeLatency.Record(latency);
+      state->priorityLatency[iter->second.priority]->Record(latency);
+      state->printed.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      state->failed.fetch_add(1, std::memory_order_relaxed);
+    }
+    state->pending.erase(iter);
+  });
+
+  const Clock::time_point start = Clock::now();
+  const Clock::time_point end = start + options.duration;
+  std::atomic<size_t> running{options.threads};
+  std::vector<std::thread> submitters;
+  for (size_t thread = 0; thread < options.threads; thread++) {
+    submitters.emplace_back([&, thread]() {
+      RunSubmitter(thread, backend, tracker, *state, options, logos, kindPriority, start, end);
+      running.fetch_sub(1);
+    });
+  }
+
+  uint64_t lastPrinted = 0;
+  Clock::time_point lastSample = start;
+  auto takeSample = [&]() {
+    const Clock::time_point now = Clock::now();
+    LoadSample sample;
+    sample.elapsedSeconds = std::chrono::duration<double>(now - start).count();
+    sample.submitted = state->submitted.load(std::memory_order_relaxed);
+    sample.printed = state->printed.load(std::memory_order_relaxed);
+    sample.failed = state->failed.load(std::memory_order_relaxed);
+    const double interval = std::chrono::duration<double>(now - lastSample).count();
+    sample.jobsPerSecond =
+        interval > 0.0 ? static_cast<double>(sample.printed - lastPrinted) / interval : 0.0;
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      sample.outstanding = state->pending.size();
+    }
+    sample.residentBytes = options.memoryProbe ? options.memoryProbe() : 0;
+    sample.p99 = state->completeLatency.Summarize("").p99;
+    lastPrinted = sample.printed;
+    lastSample = now;
+    report.samples.push_back(sample);
+    if (options.onSample) options.onSample(sample);
+  };
+
+  // Sample while the submitters run, which can be past the end of the run
+  // when the printers fall behind, then while the last jobs print
+  const auto step = std::max<std::chrono::milliseconds>(options.pollInterval,
+                                                        std::chrono::milliseconds(1));
+  Clock::time_point nextSample = start + options.sampleInterval;
+  std::optional<Clock::time_point> drainEnd;
+  while (true) {
+    std::this_thread::sleep_for(step);
+    const Clock::time_point now = Clock::now();
+    if (!drainEnd && running.load() == 0) {
+      for (std::thread& submitter : submitters) {
+        submitter.join();
+      }
+      drainEnd = now + options.drainTimeout;
+    }
+    if (drainEnd) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (state->pending.empty() || now >= *drainEnd) break;
+    }
+    if (now >= nextSample) {
+      takeSample();
+      while (nextSample <= now) nextSample += options.sampleInterval;
+    }
+  }
+  takeSample();
+  tracker.SetListener(nullptr);
+
+  const LoadSample& last = report.samples.back();
+  report.elapsedSeconds = last.elapsedSeconds;
+  report.submitted = last.submitted;
+  report.printed = last.printed;
+  report.failed = last.failed;
+  report.outstanding = last.outstanding;
+  report.bytesSubmitted = state->bytes.load(std::memory_order_relaxed);
+  report.jobsPerSecond =
+      report.elapsedSeconds > 0.0 ? static_cast<double>(report.printed) / report.elapsedSeconds
+                                  : 0.0;
+  report.submitLatency = state->submitLatency.Summarize("submit");
+  report.completeLatency = state->completeLatency.Summarize("complete");
+  for (size_t i = 0; i < state->priorities.size(); i++) {
+    LoadPriorityReport priority;
+    priority.priority = state->priorities[i];
+    priority.latency = state->priorityLatency[i]->Summarize("priority " +
+                                                            std::to_string(priority.priority));
+    priority.printed = priority.latency.count;
+    report.priorities.push_back(std::move(priority));
+  }
+  report.memoryGrowthBytes = static_cast<int64_t>(last.residentBytes) -
+                             static_cast<int64_t>(report.samples.front().residentBytes);
+  return report;
+}
+
+}  // namespace windows_printer
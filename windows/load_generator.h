@@ -0,0 +1,112 @@
+#ifndef FLUTTER_PLUGIN_LOAD_GENERATOR_H_
+#define FLUTTER_PLUGIN_LOAD_GENERATOR_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+#include "print_metrics.h"
+#include "spooler_backend.h"
+
+namespace windows_printer {
+
+/// One kind of job in a load mix. Each job is encoded with EscPosEncoder
+/// when it is submitted, like an app building its tickets.
+struct LoadJobKind {
+  std::string name;
+  /// Relative share of the jobs
+  double weight = 1.0;
+  /// Text lines on the receipt
+  int lines = 20;
+  /// Logo printed at the top; 0 for none
+  int imageWidth = 0;
+  int imageHeight = 0;
+  EscPosPaperSize paperSize = EscPosPaperSize::kMm80;
+  /// Reported separately, so a mix can tell kitchen tickets from receipts.
+  /// The print path itself does not reorder jobs.
+  int priority = 0;
+};
+
+/// Progress at one point of a run
+struct LoadSample {
+  double elapsedSeconds = 0.0;
+  uint64_t submitted = 0;
+  uint64_t printed = 0;
+  uint64_t failed = 0;
+  /// Printed since the previous sample
+  double jobsPerSecond = 0.0;
+  /// Submitted jobs not printed yet
+  uint64_t outstanding = 0;
+  /// From LoadOptions::memoryProbe; 0 without one
+  uint64_t residentBytes = 0;
+  /// Submit-to-printed latency over the whole run so far, in nanoseconds
+  uint64_t p99 = 0;
+};
+
+struct LoadOptions {
+  /// Printers jobs are spread over, round robin by thread
+  std::vector<std::string> printers;
+  std::vector<LoadJobKind> mix;
+  /// Submitting threads
+  size_t threads = 8;
+  std::chrono::milliseconds duration{10000};
+  /// Jobs submitted per second by all threads together. 0 submits the next
+  /// job as soon as the previous one is accepted.
+  double jobsPerSecond = 0.0;
+  /// Deadline for each submission, as for printRawData
+  std::chrono::milliseconds timeout{30000};
+  /// How long to wait for jobs still printing once submission stops
+  std::chrono::milliseconds drainTimeout{30000};
+  /// Job queue poll interval; bounds the precision of completion times
+  std::chrono::milliseconds pollInterval{10};
+  std::chrono::milliseconds sampleInterval{1000};
+  uint32_t seed = 1;
+  /// Resident memory of the process in bytes, sampled for growth
+  std::function<uint64_t()> memoryProbe;
+  /// Called with each sample as the run progresses
+  std::function<void(const LoadSample& sample)> onSample;
+};
+
+struct LoadPriorityReport {
+  int priority = 0;
+  uint64_t printed = 0;
+  HistogramSummary latency;
+};
+
+struct LoadReport {
+  double elapsedSeconds = 0.0;
+  uint64_t submitted = 0;
+  uint64_t printed = 0;
+  /// Submissions that failed or timed out, and jobs deleted from the queue
+  uint64_t failed = 0;
+  /// Still printing when the drain timeout passed
+  uint64_t outstanding = 0;
+  uint64_t bytesSubmitted = 0;
+  /// Printed jobs per second over the whole run
+  double jobsPerSecond = 0.0;
+  /// Time spent in SubmitRawJob
+  HistogramSummary submitLatency;
+  /// From each job's submission until it left the printer's queue. With a
+  /// rate, measured from the job's scheduled start, so a stalled printer
+  /// also counts the jobs that queued up behind it.
+  HistogramSummary completeLatency;
+  /// completeLatency per LoadJobKind::priority, highest first
+  std::vector<LoadPriorityReport> priorities;
+  std::vector<LoadSample> samples;
+  /// Resident memory at the last sample minus the first
+  int64_t memoryGrowthBytes = 0;
+};
+
+/// Drive options.mix from options.threads threads into backend for
+/// options.duration through SubmitRawJob, follow the jobs through the queue
+/// with a JobTracker, then wait for the rest to print. Blocks for the run.
+LoadReport RunLoad(std::shared_ptr<SpoolerBackend> backend, const LoadOptions& options);
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_LOAD_GENERATOR_H_
@@ -0,0 +1,340 @@
+#include "mono_bitmap.h"
+
+#include <array>
+#include <cmath>
+
+namespace windows_printer {
+
+namespace {
+
+// Leftmost `count` bits of a byte
+uint8_t LeadingMask(int count) {
+  return static_cast<uint8_t>(0xFF00 >> count);
+}
+
+void Apply(uint8_t& destination, uint8_t bits, BlitMode mode) {
+  if (mode == BlitMode::kOr) {
+    destination |= bits;
+  } else {
+    destination &= static_cast<uint8_t>(~bits);
+  }
+}
+
+// --- PNG ---
+
+const std::array<uint32_t, 256>& CrcTable() {
+  static const std::array<uint32_t, 256> table = []() {
+    std::array<uint32_t, 256> entries{};
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      entries[n] = c;
+    }
+    return entries;
+  }();
+  return table;
+}
+
+void AppendBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+  out.push_back(static_cast<uint8_t>(value >> 24));
+  out.push_back(static_cast<uint8_t>(value >> 16));
+  out.push_back(static_cast<uint8_t>(value >> 8));
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+void AppendChunk(std::vector<uint8_t>& out, const char type[4], const std::vector<uint8_t>& data) {
+  AppendBigEndian(out, static_cast<uint32_t>(data.size()));
+  const size_t crcStart = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+
+  const std::array<uint32_t, 256>& table = CrcTable();
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = crcStart; i < out.size(); i++) {
+    crc = table[(crc ^ out[i]) & 0xFF] ^ (crc >> 8);
+  }
+  AppendBigEndian(out, crc ^ 0xFFFFFFFFu);
+}
+
+// Deflate bit stream: values are packed least significant bit first, Huffman
+// codes most significant bit first
+class BitWriter {
+public:
+  explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+  void Write(uint32_t bits, int count) {
+    accumulator_ |= static_cast<uint64_t>(bits) << used_;
+    used_ += count;
+    while (used_ >= 8) {
+      out_.push_back(static_cast<uint8_t>(accumulator_));
+      accumulator_ >>= 8;
+      used_ -= 8;
+    }
+  }
+
+  void WriteCode(uint32_t code, int length) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; i++) {
+      reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    Write(reversed, length);
+  }
+
+  void Flush() {
+    if (used_ > 0) {
+      out_.push_back(static_cast<uint8_t>(accumulator_));
+      accumulator_ = 0;
+      used_ = 0;
+    }
+  }
+
+private:
+  std::vector<uint8_t>& out_;
+  uint64_t accumulator_ = 0;
+  int used_ = 0;
+};
+
+// Fixed Huffman literal/length code
+void WriteSymbol(BitWriter& writer, int symbol) {
+  if (symbol < 144) {
+    writer.WriteCode(0x30 + symbol, 8);
+  } else if (symbol < 256) {
+    writer.WriteCode(0x190 + symbol - 144, 9);
+  } else if (symbol < 280) {
+    writer.WriteCode(symbol - 256, 7);
+  } else {
+    writer.WriteCode(0xC0 + symbol - 280, 8);
+  }
+}
+
+constexpr size_t kMinMatch = 3;
+constexpr size_t kMaxMatch = 258;
+constexpr std::array<int, 29> kLengthBase = {3,  4,  5,  6,  7,  8,  9,  10,  11,  13,
+                                             15, 17, 19, 23, 27, 31, 35, 43,  51,  59,
+                                             67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::array<int, 29> kLengthExtraBits = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                                  2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr std::array<int, 30> kDistanceBase = {
+    1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr std::array<int, 30> kDistanceExtraBits = {0, 0, 0, 0, 1, 1, 2,  2,  3,  3,
+                                                    4, 4, 5, 5, 6, 6, 7,  7,  8,  8,
+                                                    9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr size_t kMaxDistance = 32768;
+
+void WriteMatch(BitWriter& writer, int length, int distance) {
+  size_t code = kLengthBase.size() - 1;
+  while (kLengthBase[code] > length) code--;
+  WriteSymbol(writer, 257 + static_cast<int>(code));
+  if (kLengthExtraBits[code] > 0) {
+    writer.Write(static_cast<uint32_t>(length - kLengthBase[code]), kLengthExtraBits[code]);
+  }
+
+  code = kDistanceBase.size() - 1;
+  while (kDistanceBase[code] > distance) code--;
+  writer.WriteCode(static_cast<uint32_t>(code), 5);
+  if (kDistanceExtraBits[code] > 0) {
+    writer.Write(static_cast<uint32_t>(distance - kDistanceBase[code]), kDistanceExtraBits[code]);
+  }
+}
+
+size_t MatchLength(const std::vector<uint8_t>& data, size_t position, size_t distance) {
+  size_t length = 0;
+  while (position + length < data.size() && length < kMaxMatch &&
+         data[position + length] == data[position + length - distance]) {
+    length++;
+  }
+  return length;
+}
+
+// zlib stream with a single fixed-Huffman block. Thermal receipts are mostly
+// white, so instead of a general-purpose match finder only two matches are
+// tried: a run of the previous byte and a copy of the scanline above.
+std::vector<uint8_t> Deflate(const std::vector<uint8_t>& data, size_t rowLength) {
+  std::vector<uint8_t> out = {0x78, 0x01};
+  BitWriter writer(out);
+  writer.Write(1, 1);  // Final block
+  writer.Write(1, 2);  // Fixed Huffman codes
+
+  size_t i = 0;
+  while (i < data.size()) {
+    size_t length = i >= 1 ? MatchLength(data, i, 1) : 0;
+    size_t distance = 1;
+    if (i >= rowLength && rowLength <= kMaxDistance) {
+      const size_t above = MatchLength(data, i, rowLength);
+      if (above > length) {
+        length = above;
+        distance = rowLength;
+      }
+    }
+    if (length >= kMinMatch) {
+      WriteMatch(writer, static_cast<int>(length), static_cast<int>(distance));
+      i += length;
+      continue;
+    }
+    WriteSymbol(writer, data[i]);
+    i++;
+  }
+  WriteSymbol(writer, 256);
+  writer.Flush();
+
+  uint32_t a = 1;
+  uint32_t b = 0;
+  for (uint8_t byte : data) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  AppendBigEndian(out, (b << 16) | a);
+  return out;
+}
+
+}  // namespace
+
+MonoBitmap::MonoBitmap(int width, int height)
+    : width_(width < 0 ? 0 : width), stride_((static_cast<size_t>(width_) + 7) / 8) {
+  Resize(height);
+}
+
+MonoBitmap MonoBitmap::FromRgba(const uint8_t* rgba, size_t length, int width, int height) {
+  if (rgba == nullptr || width <= 0 || height <= 0) return MonoBitmap();
+  MonoBitmap bitmap(width, height);
+  for (int y = 0; y < height; y++) {
+    uint8_t* row = bitmap.Row(y);
+    for (int x = 0; x < width; x++) {
+      const size_t pixelIndex = (static_cast<size_t>(y) * width + x) * 4;
+      if (pixelIndex + 3 >= length) return bitmap;
+      const uint8_t* pixel = rgba + pixelIndex;
+      const double gray = std::round(pixel[0] * 0.299 + pixel[1] * 0.587 + pixel[2] * 0.114);
+      if (gray < 128) {
+        row[x >> 3] |= static_cast<uint8_t>(0x80 >> (x & 7));
+      }
+    }
+  }
+  return bitmap;
+}
+
+void MonoBitmap::Resize(int height) {
+  height_ = height < 0 ? 0 : height;
+  data_.resize(static_cast<size_t>(height_) * stride_, 0);
+}
+
+bool MonoBitmap::Get(int x, int y) const {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_) return false;
+  return (Row(y)[x >> 3] & (0x80 >> (x & 7))) != 0;
+}
+
+void MonoBitmap::Set(int x, int y, bool black) {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_) return;
+  uint8_t& byte = Row(y)[x >> 3];
+  const uint8_t bit = static_cast<uint8_t>(0x80 >> (x & 7));
+  byte = black ? (byte | bit) : (byte & static_cast<uint8_t>(~bit));
+}
+
+void MonoBitmap::FillRect(int x, int y, int width, int height, bool black) {
+  int left = x < 0 ? 0 : x;
+  int top = y < 0 ? 0 : y;
+  int right = x + width > width_ ? width_ : x + width;
+  int bottom = y + height > height_ ? height_ : y + height;
+  if (left >= right || top >= bottom) return;
+
+  const int firstByte = left >> 3;
+  const int lastByte = (right - 1) >> 3;
+  const uint8_t firstMask = static_cast<uint8_t>(0xFF >> (left & 7));
+  const uint8_t lastMask = LeadingMask(((right - 1) & 7) + 1);
+  const BlitMode mode = black ? BlitMode::kOr : BlitMode::kClear;
+  for (int row = top; row < bottom; row++) {
+    uint8_t* bytes = Row(row);
+    if (firstByte == lastByte) {
+      Apply(bytes[firstByte], firstMask & lastMask, mode);
+      continue;
+    }
+    Apply(bytes[firstByte], firstMask, mode);
+    for (int i = firstByte + 1; i < lastByte; i++) {
+      bytes[i] = black ? 0xFF : 0x00;
+    }
+    Apply(bytes[lastByte], lastMask, mode);
+  }
+}
+
+void MonoBitmap::Blit(const uint8_t* source, size_t sourceStride, int width, int height, int x,
+                      int y, BlitMode mode) {
+  if (source == nullptr || width <= 0 || height <= 0) return;
+
+  const int sourceBytes = (width + 7) / 8;
+  const uint8_t lastMask = LeadingMask(((width - 1) & 7) + 1);
+  const bool inside = x >= 0 && x + width <= width_;
+  const int shift = x & 7;
+  for (int row = 0; row < height; row++) {
+    const int targetY = y + row;
+    if (targetY < 0) continue;
+    if (targetY >= height_) break;
+    const uint8_t* from = source + static_cast<size_t>(row) * sourceStride;
+    uint8_t* to = Row(targetY);
+
+    if (!inside) {
+      for (int column = 0; column < width; column++) {
+        if (from[column >> 3] & (0x80 >> (column & 7))) {
+          const int targetX = x + column;
+          if (targetX >= 0 && targetX < width_) {
+            Apply(to[targetX >> 3], static_cast<uint8_t>(0x80 >> (targetX & 7)), mode);
+          }
+        }
+      }
+      continue;
+    }
+
+    // Shift whole bytes into place; bits past width are masked off, so the
+    // spill into the next byte never leaves the row
+    uint8_t* target = to + (x >> 3);
+    for (int i = 0; i < sourceBytes; i++) {
+      const uint8_t bits = i == sourceBytes - 1 ? from[i] & lastMask : from[i];
+      if (bits == 0) continue;
+      Apply(target[i], static_cast<uint8_t>(bits >> shift), mode);
+      const uint8_t spill = static_cast<uint8_t>(bits << (8 - shift));
+      if (shift != 0 && spill != 0) {
+        Apply(target[i + 1], spill, mode);
+      }
+    }
+  }
+}
+
+size_t MonoBitmap::CountBlack() const {
+  size_t count = 0;
+  for (uint8_t byte : data_) {
+    for (; byte != 0; byte &= static_cast<uint8_t>(byte - 1)) count++;
+  }
+  return count;
+}
+
+std::vector<uint8_t> MonoBitmap::EncodePng() const {
+  std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+  std::vector<uint8_t> header;
+  AppendBigEndian(header, static_cast<uint32_t>(width_));
+  AppendBigEndian(header, static_cast<uint32_t>(height_));
+  header.push_back(1);  // Bit depth
+  header.push_back(0);  // Grayscale
+  header.push_back(0);  // Deflate
+  header.push_back(0);  // Adaptive filtering
+  header.push_back(0);  // No interlace
+  AppendChunk(png, "IHDR", header);
+
+  // PNG grayscale has 0 as black, so every row is inverted behind a "None"
+  // filter byte
+  std::vector<uint8_t> scanlines;
+  scanlines.reserve(static_cast<size_t>(height_) * (stride_ + 1));
+  for (int y = 0; y < height_; y++) {
+    scanlines.push_back(0);
+    const uint8_t* row = Row(y);
+    for (size_t i = 0; i < stride_; i++) {
+      scanlines.push_back(static_cast<uint8_t>(~row[i]));
+    }
+  }
+  AppendChunk(png, "IDAT", Deflate(scanlines, stride_ + 1));
+  AppendChunk(png, "IEND", {});
+  return png;
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,66 @@
+#ifndef FLUTTER_PLUGIN_MONO_BITMAP_H_
+#define FLUTTER_PLUGIN_MONO_BITMAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace windows_printer {
+
+enum class BlitMode {
+  /// Set the destination dots that are set in the source
+  kOr = 0,
+  /// Clear the destination dots that are set in the source
+  kClear,
+};
+
+// 1-bit image as printed by a thermal head: rows of packed bytes, most
+// significant bit leftmost, a set bit is a black dot. Unused bits at the end
+// of each row are kept clear.
+class MonoBitmap {
+public:
+  MonoBitmap() = default;
+  MonoBitmap(int width, int height);
+
+  /// Threshold RGBA pixels the way ESC/POS images are printed: a dot is
+  /// black when its luminance is below 128. Pixels past length stay white.
+  static MonoBitmap FromRgba(const uint8_t* rgba, size_t length, int width, int height);
+
+  int Width() const { return width_; }
+  int Height() const { return height_; }
+  /// Bytes per row
+  size_t Stride() const { return stride_; }
+
+  uint8_t* Row(int y) { return data_.data() + static_cast<size_t>(y) * stride_; }
+  const uint8_t* Row(int y) const { return data_.data() + static_cast<size_t>(y) * stride_; }
+
+  /// Change the height; new rows are white
+  void Resize(int height);
+
+  bool Get(int x, int y) const;
+  void Set(int x, int y, bool black = true);
+
+  /// Fill a rectangle, clipped to the bitmap
+  void FillRect(int x, int y, int width, int height, bool black = true);
+
+  /// Combine a packed 1-bit source (same layout as Row) into this bitmap with
+  /// its top-left corner at (x, y), clipped to the bitmap
+  void Blit(const uint8_t* source, size_t sourceStride, int width, int height, int x, int y,
+            BlitMode mode = BlitMode::kOr);
+
+  /// Number of black dots
+  size_t CountBlack() const;
+
+  /// Grayscale PNG with bit depth 1
+  std::vector<uint8_t> EncodePng() const;
+
+private:
+  int width_ = 0;
+  int height_ = 0;
+  size_t stride_ = 0;
+  std::vector<uint8_t> data_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_MONO_BITMAP_H_
@@ -0,0 +1,516 @@
+#include "network_scanner.h"
+
+// The socket calls below are the only OS-specific code in the core library;
+// winsock2.h must be included before any other Windows header.
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace windows_printer {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// DLE EOT 1: transmit printer status
+constexpr uint8_t kStatusRequest[] = {0x10, 0x04, 0x01};
+
+// Longest single poll, so Cancel is noticed promptly
+constexpr std::chrono::milliseconds kMaxPollInterval(50);
+
+// Scans wider than this are rejected by ParseCidr
+constexpr int kMinPrefixLength = 16;
+
+// Bits 1 and 4 of a printer status byte are always set, bits 0 and 7 clear
+bool IsPrinterStatusByte(uint8_t status) {
+  return (status & 0x93) == 0x12;
+}
+
+#ifdef _WIN32
+using NativeSocket = SOCKET;
+using PollDescriptor = WSAPOLLFD;
+const NativeSocket kInvalidSocket = INVALID_SOCKET;
+
+bool InitializeSockets() {
+  static const bool initialized = []() {
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+  }();
+  return initialized;
+}
+
+int LastSocketError() {
+  return WSAGetLastError();
+}
+
+bool IsConnectPending(int error) {
+  return error == WSAEWOULDBLOCK;
+}
+
+bool IsOutOfDescriptors(int error) {
+  return error == WSAEMFILE || error == WSAENOBUFS;
+}
+
+bool IsInterrupted(int error) {
+  return error == WSAEINTR;
+}
+
+bool SetNonBlocking(NativeSocket socket) {
+  u_long enabled = 1;
+  return ioctlsocket(socket, FIONBIO, &enabled) == 0;
+}
+
+void CloseSocket(NativeSocket socket) {
+  closesocket(socket);
+}
+
+// Windows before 10 version 2004 does not report refused connections through
+// WSAPoll; those probes are settled by the connect timeout instead.
+int PollSockets(PollDescriptor* descriptors, size_t count, int timeoutMs) {
+  return WSAPoll(descriptors, static_cast<ULONG>(count), timeoutMs);
+}
+
+int SendBytes(NativeSocket socket, const uint8_t* data, size_t size) {
+  return send(socket, reinterpret_cast<const char*>(data), static_cast<int>(size), 0);
+}
+
+int ReceiveBytes(NativeSocket socket, uint8_t* data, size_t size) {
+  return recv(socket, reinterpret_cast<char*>(data), static_cast<int>(size), 0);
+}
+#else
+using NativeSocket = int;
+using PollDescriptor = pollfd;
+const NativeSocket kInvalidSocket = -1;
+
+bool InitializeSockets() {
+  return true;
+}
+
+int LastSocketError() {
+  return errno;
+}
+
+bool IsConnectPending(int error) {
+  return error == EINPROGRESS;
+}
+
+bool IsOutOfDescriptors(int error) {
+  return error == EMFILE || error == ENFILE || error == ENOBUFS;
+}
+
+bool IsInterrupted(int error) {
+  return error == EINTR;
+}
+
+bool SetNonBlocking(NativeSocket socket) {
+  int flags = fcntl(socket, F_GETFL, 0);
+  return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void CloseSocket(NativeSocket socket) {
+  close(socket);
+}
+
+int PollSockets(PollDescriptor* descriptors, size_t count, int timeoutMs) {
+  return poll(descriptors, static_cast<nfds_t>(count), timeoutMs);
+}
+
+int SendBytes(NativeSocket socket, const uint8_t* data, size_t size) {
+  // A printer that resets the connection must not raise SIGPIPE
+#ifdef MSG_NOSIGNAL
+  constexpr int kFlags = MSG_NOSIGNAL;
+#else
+  constexpr int kFlags = 0;
+#endif
+  return static_cast<int>(send(socket, data, size, kFlags));
+}
+
+int ReceiveBytes(NativeSocket socket, uint8_t* data, size_t size) {
+  return static_cast<int>(recv(socket, data, size, 0));
+}
+#endif
+
+// Close with a reset rather than a graceful shutdown. Many receipt printers
+// serve one raw connection at a time, and a scan should not leave thousands
+// of sockets in TIME_WAIT.
+void ResetAndClose(NativeSocket socket) {
+  linger option{};
+  option.l_onoff = 1;
+  option.l_linger = 0;
+  setsockopt(socket, SOL_SOCKET, SO_LINGER, reinterpret_cast<const char*>(&option),
+             sizeof(option));
+  CloseSocket(socket);
+}
+
+bool ConnectSucceeded(NativeSocket socket) {
+  int error = 0;
+  socklen_t length = sizeof(error);
+  if (getsockopt(socket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length) != 0) {
+    return false;
+  }
+  return error == 0;
+}
+
+enum class ConnectStart {
+  kPending = 0,
+  kFailed,
+  kNoDescriptor,
+};
+
+ConnectStart StartConnect(uint32_t address, uint16_t port, NativeSocket* connecting) {
+  NativeSocket socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (socket == kInvalidSocket) {
+    return IsOutOfDescriptors(LastSocketError()) ? ConnectStart::kNoDescriptor
+                                                 : ConnectStart::kFailed;
+  }
+  if (!SetNonBlocking(socket)) {
+    CloseSocket(socket);
+    return ConnectStart::kFailed;
+  }
+
+  sockaddr_in target{};
+  target.sin_family = AF_INET;
+  target.sin_port = htons(port);
+  target.sin_addr.s_addr = htonl(address);
+  // An immediate success is reported as writable by the next poll
+  if (connect(socket, reinterpret_cast<const sockaddr*>(&target), sizeof(target)) != 0 &&
+      !IsConnectPending(LastSocketError())) {
+    CloseSocket(socket);
+    return ConnectStart::kFailed;
+  }
+  *connecting = socket;
+  return ConnectStart::kPending;
+}
+
+enum class ProbePhase {
+  kConnecting = 0,
+  kAwaitingStatus,
+};
+
+struct Probe {
+  uint32_t host = 0;
+  size_t port = 0;
+  ProbePhase phase = ProbePhase::kConnecting;
+  Clock::time_point deadline;
+};
+
+struct HostProgress {
+  size_t remaining = 0;
+  std::vector<bool> open;
+  bool escPos = false;
+  uint8_t statusByte = 0;
+};
+
+// One scan. Probes are started host by host so each host settles soon after
+// its first probe, and the in-flight probes live in two parallel arrays so
+// the descriptors can be handed to poll as they are.
+class ScanRun {
+public:
+  ScanRun(const Ipv4Range& range, const NetworkScanOptions& options,
+          const std::atomic<bool>& cancelled, NetworkScanListener emit)
+      : range_(range),
+        options_(options),
+        cancelled_(cancelled),
+        emit_(std::move(emit)),
+        totalProbes_(static_cast<size_t>(range.count) * options.ports.size()) {}
+
+  /// Returns the kComplete event
+  NetworkScanEvent Execute() {
+    const Clock::time_point start = Clock::now();
+    while (!cancelled_ && (nextProbe_ < totalProbes_ || !probes_.empty())) {
+      StartProbes();
+      if (probes_.empty()) continue;
+
+      int ready = PollSockets(descriptors_.data(), descriptors_.size(), PollTimeoutMs());
+      if (ready < 0 && !IsInterrupted(LastSocketError())) break;
+      ProcessProbes();
+    }
+
+    for (const PollDescriptor& descriptor : descriptors_) {
+      ResetAndClose(static_cast<NativeSocket>(descriptor.fd));
+    }
+
+    NetworkScanEvent complete;
+    complete.type = NetworkScanEventType::kComplete;
+    complete.scanned = scanned_;
+    complete.total = range_.count;
+    complete.cancelled = cancelled_;
+    complete.elapsed = Clock::now() - start;
+    return complete;
+  }
+
+private:
+  void StartProbes() {
+    while (nextProbe_ < totalProbes_ && probes_.size() < options_.maxInFlight) {
+      const uint32_t host = static_cast<uint32_t>(nextProbe_ / options_.ports.size());
+      const size_t port = nextProbe_ % options_.ports.size();
+      NativeSocket socket = kInvalidSocket;
+      ConnectStart started = StartConnect(range_.first + host, options_.ports[port], &socket);
+      if (started == ConnectStart::kNoDescriptor && !probes_.empty()) {
+        // Wait for a probe in flight to give its descriptor back
+        return;
+      }
+
+      nextProbe_++;
+      if (port == 0) {
+        HostProgress& progress = hosts_[host];
+        progress.remaining = options_.ports.size();
+        progress.open.assign(options_.ports.size(), false);
+      }
+      if (started != ConnectStart::kPending) {
+        SettleProbe(host, port, false);
+        continue;
+      }
+
+      Probe probe;
+      probe.host = host;
+      probe.port = port;
+      probe.deadline = Clock::now() + options_.connectTimeout;
+      probes_.push_back(probe);
+      PollDescriptor descriptor{};
+      descriptor.fd = socket;
+      descriptor.events = POLLOUT;
+      descriptors_.push_back(descriptor);
+    }
+  }
+
+  int PollTimeoutMs() const {
+    const Clock::time_point now = Clock::now();
+    Clock::time_point wake = now + kMaxPollInterval;
+    for (const Probe& probe : probes_) {
+      if (probe.deadline < wake) wake = probe.deadline;
+    }
+    if (wake <= now) return 0;
+    // Round up so a probe is not polled again just before its deadline
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(wake - now);
+    return static_cast<int>(wait.count());
+  }
+
+  void ProcessProbes() {
+    const Clock::time_point now = Clock::now();
+    // Backwards, so FinishProbe can move the last probe into the slot
+    for (size_t i = probes_.size(); i-- > 0;) {
+      Probe& probe = probes_[i];
+      PollDescriptor& descriptor = descriptors_[i];
+      const NativeSocket socket = static_cast<NativeSocket>(descriptor.fd);
+      const short events = descriptor.revents;
+      descriptor.revents = 0;
+
+      if (probe.phase == ProbePhase::kConnecting) {
+        if (events & (POLLOUT | POLLERR | POLLHUP)) {
+          if (!ConnectSucceeded(socket)) {
+            FinishProbe(i, false);
+          } else if (options_.ports[probe.port] == options_.statusPort &&
+                     options_.statusTimeout.count() > 0 &&
+                     SendBytes(socket, kStatusRequest, sizeof(kStatusRequest)) ==
+                         static_cast<int>(sizeof(kStatusRequest))) {
+            probe.phase = ProbePhase::kAwaitingStatus;
+            probe.deadline = now + options_.statusTimeout;
+            descriptor.events = POLLIN;
+          } else {
+            FinishProbe(i, true);
+          }
+        } else if (now >= probe.deadline) {
+          FinishProbe(i, false);
+        }
+        continue;
+      }
+
+      if (events & (POLLIN | POLLERR | POLLHUP)) {
+        uint8_t reply[16];
+        if (ReceiveBytes(socket, reply, sizeof(reply)) > 0 && IsPrinterStatusByte(reply[0])) {
+          HostProgress& progress = hosts_[probe.host];
+          progress.escPos = true;
+          progress.statusByte = reply[0];
+        }
+        FinishProbe(i, true);
+      } else if (now >= probe.deadline) {
+        // Open, but not an ESC/POS printer or too busy to answer
+        FinishProbe(i, true);
+      }
+    }
+  }
+
+  void FinishProbe(size_t index, bool open) {
+    const Probe probe = probes_[index];
+    ResetAndClose(static_cast<NativeSocket>(descriptors_[index].fd));
+    probes_[index] = probes_.back();
+    probes_.pop_back();
+    descriptors_[index] = descriptors_.back();
+    descriptors_.pop_back();
+    SettleProbe(probe.host, probe.port, open);
+  }
+
+  void SettleProbe(uint32_t host, size_t port, bool open) {
+    auto it = hosts_.find(host);
+    HostProgress& progress = it->second;
+    if (open) {
+      progress.open[port] = true;
+    }
+    if (--progress.remaining > 0) return;
+
+    scanned_++;
+    NetworkScanEvent found;
+    for (size_t i = 0; i < options_.ports.size(); i++) {
+      if (progress.open[i]) {
+        found.host.openPorts.push_back(options_.ports[i]);
+      }
+    }
+    if (!found.host.openPorts.empty()) {
+      found.type = NetworkScanEventType::kFound;
+      found.host.address = FormatIpv4(range_.first + host);
+      found.host.escPos = progress.escPos;
+      found.host.statusByte = progress.statusByte;
+      found.scanned = scanned_;
+      found.total = range_.count;
+      emit_(found);
+    }
+    hosts_.erase(it);
+  }
+
+  const Ipv4Range range_;
+  const NetworkScanOptions& options_;
+  const std::atomic<bool>& cancelled_;
+  NetworkScanListener emit_;
+
+  const size_t totalProbes_;
+  size_t nextProbe_ = 0;
+  size_t scanned_ = 0;
+  std::vector<Probe> probes_;
+  std::vector<PollDescriptor> descriptors_;
+  std::unordered_map<uint32_t, HostProgress> hosts_;
+};
+
+}  // namespace
+
+bool ParseCidr(std::string_view cidr, Ipv4Range* range) {
+  uint32_t address = 0;
+  size_t position = 0;
+  for (int octet = 0; octet < 4; octet++) {
+    if (octet > 0) {
+      if (position >= cidr.size() || cidr[position] != '.') return false;
+      position++;
+    }
+    uint32_t value = 0;
+    size_t digits = 0;
+    while (position < cidr.size() && cidr[position] >= '0' && cidr[position] <= '9' && digits < 4) {
+      value = value * 10 + static_cast<uint32_t>(cidr[position] - '0');
+      position++;
+      digits++;
+    }
+    if (digits == 0 || digits > 3 || value > 255) return false;
+    address = (address << 8) | value;
+  }
+
+  int prefix = 32;
+  if (position < cidr.size()) {
+    if (cidr[position] != '/' || position + 1 == cidr.size() || cidr.size() - position > 3) {
+      return false;
+    }
+    prefix = 0;
+    for (position++; position < cidr.size(); position++) {
+      if (cidr[position] < '0' || cidr[position] > '9') return false;
+      prefix = prefix * 10 + (cidr[position] - '0');
+    }
+    if (prefix > 32) return false;
+  }
+  if (prefix < kMinPrefixLength) return false;
+
+  const uint64_t size = uint64_t{1} << (32 - prefix);
+  const uint32_t mask = static_cast<uint32_t>(~(size - 1));
+  range->first = address & mask;
+  range->count = static_cast<uint32_t>(size);
+  if (prefix < 31) {
+    range->first++;
+    range->count -= 2;
+  }
+  return true;
+}
+
+std::string FormatIpv4(uint32_t address) {
+  return std::to_string(address >> 24) + "." + std::to_string((address >> 16) & 0xFF) + "." +
+         std::to_string((address >> 8) & 0xFF) + "." + std::to_string(address & 0xFF);
+}
+
+struct NetworkScanner::State {
+  std::mutex mutex;
+  std::condition_variable idle;
+  NetworkScanListener listener;
+  bool running = false;
+  std::atomic<bool> cancelled{false};
+
+  // Must be called with mutex held
+  void Emit(const NetworkScanEvent& event) {
+    if (listener) {
+      listener(event);
+    }
+  }
+};
+
+NetworkScanner::NetworkScanner() : state_(std::make_shared<State>()) {}
+
+NetworkScanner::~NetworkScanner() {
+  Cancel();
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->listener = nullptr;
+}
+
+bool NetworkScanner::Start(const Ipv4Range& range, NetworkScanOptions options,
+                           NetworkScanListener listener) {
+  if (options.ports.empty() || options.maxInFlight == 0 || !InitializeSockets()) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->running) return false;
+    state_->running = true;
+    state_->cancelled = false;
+    state_->listener = std::move(listener);
+  }
+  std::thread(&NetworkScanner::Run, state_, range, std::move(options)).detach();
+  return true;
+}
+
+void NetworkScanner::Cancel() {
+  state_->cancelled = true;
+}
+
+bool NetworkScanner::WaitForIdle(std::chrono::milliseconds timeout) const {
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  return state_->idle.wait_for(lock, timeout, [this]() { return !state_->running; });
+}
+
+void NetworkScanner::Run(std::shared_ptr<State> state, Ipv4Range range,
+                         NetworkScanOptions options) {
+  ScanRun run(range, options, state->cancelled, [&state](const NetworkScanEvent& event) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->Emit(event);
+  });
+  NetworkScanEvent complete = run.Execute();
+
+  std::lock_guard<std::mutex> lock(state->mutex);
+  state->Emit(complete);
+  state->running = false;
+  state->idle.notify_all();
+}
+
+}  // namespace windows_printer
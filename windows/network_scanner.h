@@ -0,0 +1,118 @@
+#ifndef FLUTTER_PLUGIN_NETWORK_SCANNER_H_
+#define FLUTTER_PLUGIN_NETWORK_SCANNER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace windows_printer {
+
+/// Ports Ethernet printers listen on
+constexpr uint16_t kRawPrintPort = 9100;
+constexpr uint16_t kLpdPort = 515;
+constexpr uint16_t kIppPort = 631;
+
+/// Consecutive IPv4 addresses in host byte order
+struct Ipv4Range {
+  uint32_t first = 0;
+  uint32_t count = 0;
+};
+
+/// Parse "a.b.c.d/prefix"; a bare address is a /32. The network and
+/// broadcast addresses are left out for prefixes shorter than /31. Prefixes
+/// shorter than /16 are rejected to keep scans bounded.
+bool ParseCidr(std::string_view cidr, Ipv4Range* range);
+
+/// Dotted-quad form of a host byte order address
+std::string FormatIpv4(uint32_t address);
+
+struct NetworkScanOptions {
+  /// Ports probed on every address
+  std::vector<uint16_t> ports{kRawPrintPort, kLpdPort, kIppPort};
+  /// Most connection attempts in flight at once. Fewer are used if the
+  /// process runs out of socket descriptors.
+  size_t maxInFlight = 1024;
+  /// Deadline for each connection attempt
+  std::chrono::milliseconds connectTimeout{400};
+  /// Port that is sent an ESC/POS real-time status request once it accepts
+  uint16_t statusPort = kRawPrintPort;
+  /// Deadline for the status reply; zero skips the request
+  std::chrono::milliseconds statusTimeout{300};
+};
+
+struct ScannedHost {
+  std::string address;
+  /// Ports that accepted a connection, in the order of NetworkScanOptions::ports
+  std::vector<uint16_t> openPorts;
+  /// The status port answered DLE EOT 1 with a valid printer status byte
+  bool escPos = false;
+  uint8_t statusByte = 0;
+};
+
+enum class NetworkScanEventType {
+  /// A host with at least one open port; sent once all its ports were probed
+  kFound = 0,
+  /// The scan finished or was cancelled; always the last event
+  kComplete,
+};
+
+struct NetworkScanEvent {
+  NetworkScanEventType type = NetworkScanEventType::kFound;
+  /// Set for kFound
+  ScannedHost host;
+  /// Addresses fully probed so far
+  size_t scanned = 0;
+  /// Addresses in the range
+  size_t total = 0;
+  /// Set on kComplete when Cancel stopped the scan early
+  bool cancelled = false;
+  std::chrono::nanoseconds elapsed{0};
+};
+
+/// Receives scan events on the scanner thread, with the scanner lock held, so
+/// it must be quick and must not call back into NetworkScanner.
+using NetworkScanListener = std::function<void(const NetworkScanEvent& event)>;
+
+// Probes an IPv4 range for printer ports. A single background thread drives
+// non-blocking connects through poll, so thousands of probes can be in flight
+// without a thread per address. Hosts whose status port accepts are asked for
+// their ESC/POS printer status (DLE EOT 1) to tell receipt printers apart
+// from other devices that happen to listen there.
+class NetworkScanner {
+public:
+  NetworkScanner();
+
+  /// Cancels a running scan without waiting for it; no events are delivered
+  /// afterwards.
+  ~NetworkScanner();
+
+  NetworkScanner(const NetworkScanner&) = delete;
+  NetworkScanner& operator=(const NetworkScanner&) = delete;
+
+  /// Start scanning range in the background. Returns false if a scan is
+  /// already running or the options are unusable (no ports, or sockets are
+  /// unavailable).
+  bool Start(const Ipv4Range& range, NetworkScanOptions options, NetworkScanListener listener);
+
+  /// Stop the running scan; it completes with cancelled set
+  void Cancel();
+
+  /// Wait until no scan is running (for tests and shutdown)
+  bool WaitForIdle(std::chrono::milliseconds timeout) const;
+
+private:
+  struct State;
+
+  static void Run(std::shared_ptr<State> state, Ipv4Range range, NetworkScanOptions options);
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_NETWORK_SCANNER_H_
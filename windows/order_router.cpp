@@ -0,0 +1,173 @@
+#include "order_router.h"
+
+#include <algorithm>
+#include <memory>
+#include <string_view>
+
+#include "batch_query.h"
+
+namespace windows_printer {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// RouteOrder's own deadline trails the submission's, which cancels the job
+// first; it only catches a worker that never returns
+constexpr std::chrono::milliseconds kDeadlineGrace{1000};
+
+// Printed width in characters, not bytes
+size_t TextWidth(std::string_view text) {
+  return static_cast<size_t>(std::count_if(text.begin(), text.end(), [](char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+  }));
+}
+
+// left and right on one line, right aligned to the paper edge
+std::string Columns(const std::string& left, const std::string& right, size_t lineWidth) {
+  const size_t used = TextWidth(left) + TextWidth(right);
+  return left + std::string(used < lineWidth ? lineWidth - used : 1, ' ') + right;
+}
+
+bool TakesCategory(const OrderStation& station, const std::string& category) {
+  return station.categories.empty() ||
+         std::find(station.categories.begin(), station.categories.end(), category) !=
+             station.categories.end();
+}
+
+}  // namespace
+
+bool OrderRouteResult::AllSucceeded() const {
+  return std::all_of(tickets.begin(), tickets.end(),
+                     [](const StationTicket& ticket) { return ticket.result.success; });
+}
+
+std::vector<std::vector<size_t>> SplitOrder(const Order& order,
+                                            const std::vector<OrderStation>& stations,
+                                            std::vector<size_t>* unrouted) {
+  std::vector<std::vector<size_t>> split(stations.size());
+  for (size_t item = 0; item < order.items.size(); item++) {
+    bool routed = false;
+    for (size_t station = 0; station < stations.size(); station++) {
+      if (TakesCategory(stations[station], order.items[item].category)) {
+        split[station].push_back(item);
+        routed = true;
+      }
+    }
+    if (!routed && unrouted) unrouted->push_back(item);
+  }
+  return split;
+}
+
+std::vector<uint8_t> EncodeStationTicket(const Order& order, const OrderStation& station,
+                                         const std::vector<size_t>& items) {
+  EscPosEncoder encoder(station.paperSize);
+  const size_t lineWidth = static_cast<size_t>(station.paperSize) / 12;
+
+  EscPosTextStyle heading;
+  heading.align = EscPosTextAlign::kCenter;
+  heading.bold = true;
+  heading.size = EscPosTextSize::kDoubleHeightWidth;
+  if (!station.name.empty()) encoder.Text(station.name, heading);
+  heading.size = EscPosTextSize::kDoubleHeight;
+  if (!order.title.empty()) encoder.Text(order.title, heading);
+
+  EscPosTextStyle centered;
+  centered.align = EscPosTextAlign::kCenter;
+  for (const std::string& detail : order.details) {
+    encoder.Text(detail, centered);
+  }
+  encoder.Separator();
+
+  // Kitchen tickets are read at arm's length; receipts need the columns
+  EscPosTextStyle itemStyle;
+  itemStyle.bold = true;
+  if (!station.showPrices) itemStyle.size = EscPosTextSize::kDoubleHeight;
+  for (size_t index : items) {
+    const OrderItem& item = order.items[index];
+    const std::string line = std::to_string(item.quantity) + " x " + item.name;
+    if (station.showPrices && !item.price.empty()) {
+      encoder.Text(Columns(line, item.price, lineWidth), itemStyle);
+    } else {
+      encoder.Text(line, itemStyle);
+    }
+    for (const std::string& note : item.notes) {
+      encoder.Text("   " + note);
+    }
+  }
+
+  if (station.showPrices && !order.total.empty()) {
+    encoder.Separator();
+    EscPosTextStyle totalStyle;
+    totalStyle.bold = true;
+    encoder.Text(Columns("TOTAL", order.total, lineWidth), totalStyle);
+  }
+  if (!order.note.empty()) {
+    encoder.Separator();
+    encoder.Text(order.note);
+  }
+  encoder.Feed(3);
+  encoder.Cut();
+  return encoder.Bytes();
+}
+
+OrderRouteResult RouteOrder(const std::shared_ptr<SpoolerBackend>& backend, const Order& order,
+                            const std::vector<OrderStation>& stations,
+                            const OrderRouteOptions& options) {
+  const Clock::time_point start = Clock::now();
+  OrderRouteResult routeResult;
+  std::vector<std::vector<size_t>> split = SplitOrder(order, stations, &routeResult.unroutedItems);
+  for (size_t station = 0; station < stations.size(); station++) {
+    if (split[station].empty()) continue;
+    StationTicket ticket;
+    ticket.station = station;
+    ticket.items = std::move(split[station]);
+    routeResult.tickets.push_back(std::move(ticket));
+  }
+
+  // Copied for the workers, which may outlive this call past their deadline
+  auto sharedOrder = std::make_shared<const Order>(order);
+  auto sharedStations = std::make_shared<const std::vector<OrderStation>>(stations);
+  auto tickets = std::make_shared<std::vector<StationTicket>>(routeResult.tickets);
+
+  BatchOptions batchOptions;
+  batchOptions.maxConcurrency = options.maxConcurrency;
+  batchOptions.timeout = options.timeout.count() > 0 ? options.timeout + kDeadlineGrace
+                                                     : std::chrono::hours(24);
+  std::vector<BatchItemOutcome> outcomes = RunBatch(
+      tickets->size(),
+      [backend, sharedOrder, sharedStations, tickets, start,
+       timeout = options.timeout](size_t index) {
+        StationTicket& ticket = (*tickets)[index];
+        const OrderStation& station = (*sharedStations)[ticket.station];
+        auto data = std::make_shared<const std::vector<uint8_t>>(
+            EncodeStationTicket(*sharedOrder, station, ticket.items));
+
+        RawPrintOptions printOptions;
+        printOptions.documentName = station.name.empty() ? "Order Ticket" : station.name;
+        printOptions.timeout = timeout;
+        printOptions.copies = station.copies;
+        ticket.result = SubmitRawJob(backend, station.printerName, std::move(data),
+                                     std::move(printOptions));
+        ticket.elapsed = Clock::now() - start;
+      },
+      batchOptions);
+
+  for (size_t i = 0; i < routeResult.tickets.size(); i++) {
+    StationTicket& ticket = routeResult.tickets[i];
+    // Only completed slots are read: an abandoned worker may still write its own
+    if (outcomes[i].status == BatchItemStatus::kCompleted) {
+      ticket.result = std::move((*tickets)[i].result);
+      ticket.elapsed = (*tickets)[i].elapsed;
+    } else {
+      ticket.result.timedOut = true;
+      ticket.result.errorCode = kErrorTimeout;
+      ticket.result.printerName = stations[ticket.station].printerName;
+      ticket.elapsed = Clock::now() - start;
+    }
+  }
+  routeResult.elapsed = Clock::now() - start;
+  return routeResult;
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,105 @@
+#ifndef FLUTTER_PLUGIN_ORDER_ROUTER_H_
+#define FLUTTER_PLUGIN_ORDER_ROUTER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+#include "print_job.h"
+#include "spooler_backend.h"
+
+namespace windows_printer {
+
+struct OrderItem {
+  std::string name;
+  /// Routing key, such as "grill" or "drinks"
+  std::string category;
+  int quantity = 1;
+  /// Modifiers printed under the item, one per line
+  std::vector<std::string> notes;
+  /// Printed on stations that show prices; empty for none
+  std::string price;
+};
+
+struct Order {
+  /// Printed large at the top of every ticket, such as "Order 42"
+  std::string title;
+  /// Lines under the title: table, server, time
+  std::vector<std::string> details;
+  std::vector<OrderItem> items;
+  /// Printed at the bottom of every ticket
+  std::string note;
+  /// Printed on stations that show prices
+  std::string total;
+};
+
+struct OrderStation {
+  /// Printed on the ticket, such as "KITCHEN"
+  std::string name;
+  /// Empty for the default printer
+  std::string printerName;
+  /// Item categories printed here. Empty receives every item, as for a
+  /// customer receipt.
+  std::vector<std::string> categories;
+  EscPosPaperSize paperSize = EscPosPaperSize::kMm80;
+  /// Print item prices and the order total
+  bool showPrices = false;
+  int copies = 1;
+};
+
+struct OrderRouteOptions {
+  /// Stations printing at once
+  size_t maxConcurrency = 8;
+  /// Deadline for each station's ticket
+  std::chrono::milliseconds timeout{30000};
+};
+
+struct StationTicket {
+  /// Index into the stations passed to RouteOrder
+  size_t station = 0;
+  /// Indices into the order's items printed on the ticket
+  std::vector<size_t> items;
+  RawPrintResult result;
+  /// From the start of RouteOrder until the ticket was submitted or failed
+  std::chrono::nanoseconds elapsed{0};
+};
+
+struct OrderRouteResult {
+  /// One per station with items, in station order
+  std::vector<StationTicket> tickets;
+  /// Items whose category no station takes
+  std::vector<size_t> unroutedItems;
+  /// Until the last ticket was submitted: the slowest printer, not the sum
+  std::chrono::nanoseconds elapsed{0};
+
+  bool AllSucceeded() const;
+};
+
+/// The items each station prints, by index, in station order. Items no
+/// station takes are added to unrouted when it is given.
+std::vector<std::vector<size_t>> SplitOrder(const Order& order,
+                                            const std::vector<OrderStation>& stations,
+                                            std::vector<size_t>* unrouted = nullptr);
+
+/// ESC/POS ticket for one station: the station name, the order title and
+/// details, its items large with their notes, prices when the station shows
+/// them, the order note, then a cut
+std::vector<uint8_t> EncodeStationTicket(const Order& order, const OrderStation& station,
+                                         const std::vector<size_t>& items);
+
+/// Encode and submit every station's ticket at the same time, one worker
+/// per station up to maxConcurrency, and wait for all of them. Stations
+/// without items print nothing. One printer failing or timing out does not
+/// hold up the others. Abandoned workers keep their own reference to
+/// backend, as in SubmitRawJob.
+OrderRouteResult RouteOrder(const std::shared_ptr<SpoolerBackend>& backend, const Order& order,
+                            const std::vector<OrderStation>& stations,
+                            const OrderRouteOptions& options = OrderRouteOptions());
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_ORDER_ROUTER_H_
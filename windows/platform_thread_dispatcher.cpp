@@ -0,0 +1,102 @@
+#include "platform_thread_dispatcher.h"
+
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace windows_printer {
+
+// Shared with posters so that threads outliving the dispatcher can still
+// post safely; their tasks are dropped once it is closed.
+struct PlatformThreadDispatcher::Mailbox {
+  HWND window = nullptr;
+  UINT message = 0;
+
+  std::mutex mutex;
+  std::deque<std::function<void()>> tasks;
+  bool closed = false;
+
+  void Post(std::function<void()> task) {
+    if (window == nullptr) {
+      // Headless (e.g. unit tests): there is no message loop to post to
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed) return;
+      }
+      task();
+      return;
+    }
+
+    bool was_empty;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (closed) return;
+      was_empty = tasks.empty();
+      tasks.push_back(std::move(task));
+    }
+    // One message drains the whole queue
+    if (was_empty) {
+      PostMessage(window, message, 0, 0);
+    }
+  }
+
+  void RunPendingTasks() {
+    std::deque<std::function<void()>> pending;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending.swap(tasks);
+    }
+    for (auto& task : pending) {
+      task();
+    }
+  }
+
+  void Close() {
+    std::deque<std::function<void()>> dropped;
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    dropped.swap(tasks);
+  }
+};
+
+PlatformThreadDispatcher::PlatformThreadDispatcher(
+    flutter::PluginRegistrarWindows *registrar)
+    : registrar_(registrar), mailbox_(std::make_shared<Mailbox>()) {
+  mailbox_->message = RegisterWindowMessage(L"WindowsPrinterPlatformThreadTask");
+  if (registrar_ == nullptr || registrar_->GetView() == nullptr) {
+    return;
+  }
+  mailbox_->window = GetAncestor(registrar_->GetView()->GetNativeWindow(), GA_ROOT);
+  window_proc_id_ = registrar_->RegisterTopLevelWindowProcDelegate(
+      [this](HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) {
+        return HandleWindowProc(hwnd, message, wparam, lparam);
+      });
+}
+
+PlatformThreadDispatcher::~PlatformThreadDispatcher() {
+  if (window_proc_id_ != -1) {
+    registrar_->UnregisterTopLevelWindowProcDelegate(window_proc_id_);
+  }
+  mailbox_->Close();
+}
+
+void PlatformThreadDispatcher::Post(std::function<void()> task) {
+  mailbox_->Post(std::move(task));
+}
+
+PlatformThreadDispatcher::PostFunction PlatformThreadDispatcher::GetPoster() const {
+  return [mailbox = mailbox_](std::function<void()> task) {
+    mailbox->Post(std::move(task));
+  };
+}
+
+std::optional<LRESULT> PlatformThreadDispatcher::HandleWindowProc(
+    HWND, UINT message, WPARAM, LPARAM) {
+  if (message != mailbox_->message) {
+    return std::nullopt;
+  }
+  mailbox_->RunPendingTasks();
+  return 0;
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,49 @@
+#ifndef FLUTTER_PLUGIN_PLATFORM_THREAD_DISPATCHER_H_
+#define FLUTTER_PLUGIN_PLATFORM_THREAD_DISPATCHER_H_
+
+#include <windows.h>
+
+#include <flutter/plugin_registrar_windows.h>
+
+#include <functional>
+#include <memory>
+#include <optional>
+
+namespace windows_printer {
+
+// Runs tasks on the platform thread. Channel results and event sinks may only
+// be used from that thread, so background work posts its replies here. Tasks
+// are delivered through a message posted to the top-level window.
+class PlatformThreadDispatcher {
+ public:
+  using PostFunction = std::function<void(std::function<void()> task)>;
+
+  explicit PlatformThreadDispatcher(flutter::PluginRegistrarWindows *registrar);
+  ~PlatformThreadDispatcher();
+
+  // Disallow copy and assign.
+  PlatformThreadDispatcher(const PlatformThreadDispatcher&) = delete;
+  PlatformThreadDispatcher& operator=(const PlatformThreadDispatcher&) = delete;
+
+  // Queue a task; safe to call from any thread. Tasks still queued when the
+  // dispatcher is destroyed are dropped.
+  void Post(std::function<void()> task);
+
+  // Returns a function equivalent to Post that may outlive the dispatcher,
+  // for detached threads. Tasks posted after destruction are dropped.
+  PostFunction GetPoster() const;
+
+ private:
+  struct Mailbox;
+
+  std::optional<LRESULT> HandleWindowProc(HWND hwnd, UINT message, WPARAM wparam,
+                                          LPARAM lparam);
+
+  flutter::PluginRegistrarWindows *registrar_;
+  int window_proc_id_ = -1;
+  std::shared_ptr<Mailbox> mailbox_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_PLATFORM_THREAD_DISPATCHER_H_
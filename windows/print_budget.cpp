@@ -0,0 +1,344 @@
+#include "print_budget.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <utility>
+
+#include "string_convert.h"
+
+namespace windows_printer {
+
+struct PrintReservation::State {
+  // Usage of one printer's limits, or of the global ones
+  struct Scope {
+    size_t jobs = 0;
+    uint64_t bytes = 0;
+    size_t spilledJobs = 0;
+    uint64_t spilledBytes = 0;
+    /// Tickets of the submissions waiting, oldest first; unused globally
+    std::deque<uint64_t> waiting;
+    /// Backpressure was signalled and has not been lifted yet
+    bool full = false;
+  };
+
+  State(PrintBudgetOptions options, PrintMetrics& metrics)
+      : options(std::move(options)), metrics(metrics) {}
+
+  std::mutex mutex;
+  std::condition_variable roomFreed;
+  PrintBudgetOptions options;
+  PrintMetrics& metrics;
+  BackpressureListener listener;
+  Scope global;
+  size_t waiting = 0;
+  std::map<std::string, Scope> printers;
+  uint64_t nextTicket = 1;
+  uint64_t nextSpillFile = 1;
+  /// Keeps the spill files of two processes apart
+  uint64_t spillPrefix = std::random_device()();
+};
+
+namespace {
+
+using State = PrintReservation::State;
+using Scope = PrintReservation::State::Scope;
+
+bool Fits(const Scope& scope, size_t maxJobs, uint64_t maxBytes, uint64_t bytes) {
+  return (maxJobs == 0 || scope.jobs < maxJobs) &&
+         (maxBytes == 0 || scope.jobs == 0 || scope.bytes + bytes <= maxBytes);
+}
+
+bool FitsGlobal(const State& state, uint64_t bytes) {
+  return Fits(state.global, state.options.maxJobs, state.options.maxBytes, bytes);
+}
+
+bool FitsPrinter(const State& state, const Scope& printer, uint64_t bytes) {
+  return Fits(printer, state.options.maxJobsPerPrinter, state.options.maxBytesPerPrinter, bytes);
+}
+
+bool Drained(const Scope& scope, size_t maxJobs, uint64_t maxBytes) {
+  return (maxJobs == 0 || scope.jobs * 2 <= maxJobs) &&
+         (maxBytes == 0 || scope.bytes * 2 <= maxBytes);
+}
+
+// All of these need state.mutex held
+
+void Signal(State& state, const std::string& printerName, Scope& scope, bool full) {
+  if (scope.full == full) return;
+  scope.full = full;
+  if (!state.listener) return;
+  BackpressureEvent event;
+  event.global = &scope == &state.global;
+  event.printerName = printerName;
+  event.full = full;
+  event.jobs = scope.jobs;
+  event.bytes = scope.bytes;
+  state.listener(event);
+}
+
+// Signals the limits a submission found reached. One held back only by the
+// jobs waiting ahead of it found its printer full.
+void SignalFull(State& state, const std::string& printerName, Scope& printer, uint64_t bytes) {
+  const bool globalFull = !FitsGlobal(state, bytes);
+  if (!FitsPrinter(state, printer, bytes) || !globalFull) {
+    Signal(state, printerName, printer, true);
+  }
+  if (globalFull) {
+    Signal(state, std::string(), state.global, true);
+  }
+}
+
+// Lifts backpressure where usage has fallen far enough, and forgets idle
+// printers
+void SignalDrained(State& state) {
+  for (auto iter = state.printers.begin(); iter != state.printers.end();) {
+    Scope& printer = iter->second;
+    if (printer.full && printer.waiting.empty() &&
+        Drained(printer, state.options.maxJobsPerPrinter, state.options.maxBytesPerPrinter)) {
+      Signal(state, iter->first, printer, false);
+    }
+    if (printer.jobs == 0 && printer.waiting.empty() && printer.spilledJobs == 0 &&
+        !printer.full) {
+      iter = state.printers.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  if (state.global.full && state.waiting == 0 &&
+      Drained(state.global, state.options.maxJobs, state.options.maxBytes)) {
+    Signal(state, std::string(), state.global, false);
+  }
+}
+
+PrintBudgetUsage UsageOf(const Scope& scope, size_t waiting) {
+  PrintBudgetUsage usage;
+  usage.jobs = scope.jobs;
+  usage.bytes = scope.bytes;
+  usage.waiting = waiting;
+  usage.spilledJobs = scope.spilledJobs;
+  usage.spilledBytes = scope.spilledBytes;
+  return usage;
+}
+
+std::filesystem::path PathFromUtf8(const std::string& path) {
+#ifdef _WIN32
+  return std::filesystem::path(Utf8ToUtf16<wchar_t>(path));
+#else
+  return std::filesystem::path(path);
+#endif
+}
+
+std::filesystem::path SpillDirectory(const std::string& directory) {
+  if (!directory.empty()) return PathFromUtf8(directory);
+  std::error_code error;
+  std::filesystem::path temporary = std::filesystem::temp_directory_path(error);
+  return error ? std::filesystem::path(".") : temporary;
+}
+
+bool WriteSpillFile(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) return false;
+  file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+  file.close();
+  return !file.fail();
+}
+
+bool ReadSpillFile(const std::filesystem::path& path, size_t size, std::vector<uint8_t>* data) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+  data->resize(size);
+  file.read(reinterpret_cast<char*>(data->data()), static_cast<std::streamsize>(size));
+  return file.gcount() == static_cast<std::streamsize>(size);
+}
+
+void RemoveSpillFile(const std::filesystem::path& path) {
+  std::error_code error;
+  std::filesystem::remove(path, error);
+}
+
+}  // namespace
+
+PrintReservation::PrintReservation(std::shared_ptr<State> state, std::string printerName,
+                                   uint64_t bytes)
+    : state_(std::move(state)), printerName_(std::move(printerName)), bytes_(bytes) {}
+
+PrintReservation::~PrintReservation() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->global.jobs--;
+  state_->global.bytes -= bytes_;
+  Scope& printer = state_->printers[printerName_];
+  printer.jobs--;
+  printer.bytes -= bytes_;
+  state_->metrics.RecordPending(-1, -static_cast<int64_t>(bytes_));
+  SignalDrained(*state_);
+  state_->roomFreed.notify_all();
+}
+
+PrintBudget::PrintBudget(PrintBudgetOptions options, PrintMetrics& metrics)
+    : state_(std::make_shared<State>(std::move(options), metrics)) {}
+
+void PrintBudget::SetOptions(PrintBudgetOptions options) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->options = std::move(options);
+  SignalDrained(*state_);
+  state_->roomFreed.notify_all();
+}
+
+PrintBudgetOptions PrintBudget::Options() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->options;
+}
+
+void PrintBudget::SetListener(BackpressureListener listener) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->listener = std::move(listener);
+}
+
+bool PrintBudget::TryAdmit(const std::string& printerName, uint64_t bytes,
+                           std::shared_ptr<PrintReservation>* reservation) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  Scope& printer = state_->printers[printerName];
+  if (!printer.waiting.empty() || !FitsPrinter(*state_, printer, bytes) ||
+      !FitsGlobal(*state_, bytes)) {
+    SignalDrained(*state_);
+    return false;
+  }
+  *reservation = Charge(printerName, bytes);
+  return true;
+}
+
+AdmitStatus PrintBudget::Admit(const std::string& printerName, uint64_t bytes,
+                               OverflowPolicy policy, std::chrono::milliseconds wait,
+                               std::shared_ptr<PrintReservation>* reservation,
+                               std::vector<uint8_t>* spillData) {
+  State& state = *state_;
+  std::unique_lock<std::mutex> lock(state.mutex);
+  Scope* printer = &state.printers[printerName];
+  if (printer->waiting.empty() && FitsPrinter(state, *printer, bytes) &&
+      FitsGlobal(state, bytes)) {
+    *reservation = Charge(printerName, bytes);
+    return AdmitStatus::kAdmitted;
+  }
+  SignalFull(state, printerName, *printer, bytes);
+  if (policy == OverflowPolicy::kReject) {
+    state.metrics.RecordRejected();
+    if (spillData) spillData->clear();
+    return AdmitStatus::kRejected;
+  }
+
+  // Waits in line behind earlier submissions to the same printer
+  const uint64_t ticket = state.nextTicket++;
+  printer->waiting.push_back(ticket);
+  state.waiting++;
+  auto leaveLine = [&state, &printerName, ticket]() {
+    Scope& scope = state.printers[printerName];
+    scope.waiting.erase(std::find(scope.waiting.begin(), scope.waiting.end(), ticket));
+    state.waiting--;
+    // The next in line may fit now
+    state.roomFreed.notify_all();
+  };
+
+  const bool spill = policy == OverflowPolicy::kSpill && spillData != nullptr;
+  std::filesystem::path spillPath;
+  const size_t spillSize = spill ? spillData->size() : 0;
+  if (spill) {
+    spillPath = SpillDirectory(state.options.spillDirectory) /
+                ("windows_printer_spill_" + std::to_string(state.spillPrefix) + "_" +
+                 std::to_string(state.nextSpillFile++) + ".bin");
+    lock.unlock();
+    const bool written = WriteSpillFile(spillPath, *spillData);
+    lock.lock();
+    if (!written) {
+      RemoveSpillFile(spillPath);
+      leaveLine();
+      SignalDrained(state);
+      spillData->clear();
+      return AdmitStatus::kSpillFailed;
+    }
+    // Frees the memory, not just the contents
+    std::vector<uint8_t>().swap(*spillData);
+    Scope& scope = state.printers[printerName];
+    scope.spilledJobs++;
+    scope.spilledBytes += spillSize;
+    state.global.spilledJobs++;
+    state.global.spilledBytes += spillSize;
+    state.metrics.RecordSpilled(static_cast<int64_t>(spillSize));
+  } else {
+    state.metrics.RecordBlocked();
+  }
+
+  auto admissible = [&state, &printerName, bytes, ticket]() {
+    Scope& scope = state.printers[printerName];
+    return scope.waiting.front() == ticket && FitsPrinter(state, scope, bytes) &&
+           FitsGlobal(state, bytes);
+  };
+  bool admitted;
+  if (wait.count() > 0) {
+    admitted = state.roomFreed.wait_for(lock, wait, admissible);
+  } else {
+    state.roomFreed.wait(lock, admissible);
+    admitted = true;
+  }
+  leaveLine();
+  if (spill) {
+    Scope& scope = state.printers[printerName];
+    scope.spilledJobs--;
+    scope.spilledBytes -= spillSize;
+    state.global.spilledJobs--;
+    state.global.spilledBytes -= spillSize;
+    state.metrics.RecordSpilled(-static_cast<int64_t>(spillSize));
+  }
+  if (!admitted) {
+    state.metrics.RecordRejected();
+    SignalDrained(state);
+    lock.unlock();
+    if (spill) RemoveSpillFile(spillPath);
+    if (spillData) spillData->clear();
+    return AdmitStatus::kTimedOut;
+  }
+
+  std::shared_ptr<PrintReservation> charged = Charge(printerName, bytes);
+  lock.unlock();
+  if (spill) {
+    const bool read = ReadSpillFile(spillPath, spillSize, spillData);
+    RemoveSpillFile(spillPath);
+    if (!read) {
+      spillData->clear();
+      return AdmitStatus::kSpillFailed;
+    }
+  }
+  *reservation = std::move(charged);
+  return AdmitStatus::kAdmitted;
+}
+
+PrintBudgetUsage PrintBudget::Usage() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return UsageOf(state_->global, state_->waiting);
+}
+
+PrintBudgetUsage PrintBudget::Usage(const std::string& printerName) const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  auto iter = state_->printers.find(printerName);
+  if (iter == state_->printers.end()) return PrintBudgetUsage();
+  return UsageOf(iter->second, iter->second.waiting.size());
+}
+
+std::shared_ptr<PrintReservation> PrintBudget::Charge(const std::string& printerName,
+                                                      uint64_t bytes) {
+  State& state = *state_;
+  state.global.jobs++;
+  state.global.bytes += bytes;
+  Scope& printer = state.printers[printerName];
+  printer.jobs++;
+  printer.bytes += bytes;
+  state.metrics.RecordPending(1, static_cast<int64_t>(bytes));
+  return std::shared_ptr<PrintReservation>(new PrintReservation(state_, printerName, bytes));
+}
+
+}  // namespace windows_printer
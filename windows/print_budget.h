@@ -0,0 +1,156 @@
+#ifndef FLUTTER_PLUGIN_PRINT_BUDGET_H_
+#define FLUTTER_PLUGIN_PRINT_BUDGET_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "print_metrics.h"
+
+namespace windows_printer {
+
+/// What a submission does when a limit of its PrintBudget is reached
+enum class OverflowPolicy : int {
+  /// Fail at once
+  kReject = 0,
+  /// Wait for queued jobs to release their data
+  kBlock,
+  /// Like kBlock, but the data waits in a file instead of in memory
+  kSpill,
+};
+
+/// Outcome of PrintBudget::Admit
+enum class AdmitStatus : int {
+  kAdmitted = 0,
+  /// A limit was reached and the policy was kReject
+  kRejected,
+  /// The wait ended before there was room
+  kTimedOut,
+  /// The data could not be written to or read back from its spill file
+  kSpillFailed,
+};
+
+struct PrintBudgetOptions {
+  /// Jobs holding print data at once over all printers; 0 is no limit
+  size_t maxJobs = 0;
+  /// Bytes of print data held at once over all printers; 0 is no limit
+  uint64_t maxBytes = 0;
+  size_t maxJobsPerPrinter = 0;
+  uint64_t maxBytesPerPrinter = 0;
+  /// Policy for callers that do not choose one
+  OverflowPolicy overflow = OverflowPolicy::kReject;
+  /// How long kBlock and kSpill wait for room; zero waits until there is
+  /// room
+  std::chrono::milliseconds wait{0};
+  /// Where kSpill writes its files; empty uses the temporary directory
+  std::string spillDirectory;
+};
+
+/// Usage of one printer's limits, or of the global ones
+struct PrintBudgetUsage {
+  size_t jobs = 0;
+  uint64_t bytes = 0;
+  /// Submissions waiting for room, spilled or not
+  size_t waiting = 0;
+  size_t spilledJobs = 0;
+  uint64_t spilledBytes = 0;
+};
+
+/// A change of backpressure on one printer or on the whole budget
+struct BackpressureEvent {
+  /// The limits shared by every printer rather than printerName's
+  bool global = false;
+  std::string printerName;
+  /// True once a submission found a limit reached; false once usage has
+  /// fallen to half of every limit and nothing is waiting
+  bool full = false;
+  size_t jobs = 0;
+  uint64_t bytes = 0;
+};
+
+/// Called with the budget's lock held, on whichever thread changed the
+/// pressure. Must be quick and must not call back into the budget.
+using BackpressureListener = std::function<void(const BackpressureEvent& event)>;
+
+/// Room held in a PrintBudget for one job's data, given back when the last
+/// copy of the shared_ptr is released. Stays valid after the budget is
+/// destroyed.
+class PrintReservation {
+public:
+  ~PrintReservation();
+
+  PrintReservation(const PrintReservation&) = delete;
+  PrintReservation& operator=(const PrintReservation&) = delete;
+
+  const std::string& PrinterName() const { return printerName_; }
+  uint64_t Bytes() const { return bytes_; }
+
+  /// Shared by a budget and its reservations
+  struct State;
+
+private:
+  friend class PrintBudget;
+
+  PrintReservation(std::shared_ptr<State> state, std::string printerName, uint64_t bytes);
+
+  std::shared_ptr<State> state_;
+  std::string printerName_;
+  uint64_t bytes_;
+};
+
+// Caps the print data held in memory by jobs that have not been handed to
+// the spooler yet, or were abandoned at their deadline with a spooler call
+// still running. Each printer has its own limits on jobs and bytes, and all
+// printers share global ones. Printers are keyed by the name the caller
+// used, so an empty name is the default printer's own entry.
+//
+// A job larger than a byte limit is admitted once it would be alone, so it
+// prints rather than failing for good. Jobs waiting for the same printer
+// are admitted in order, and a new job never overtakes them. Usage is
+// reported to PrintMetrics as the pending and spilled gauges.
+class PrintBudget {
+public:
+  explicit PrintBudget(PrintBudgetOptions options = PrintBudgetOptions(),
+                       PrintMetrics& metrics = PrintMetrics::Instance());
+
+  /// Waiting submissions keep the policy and wait they started with, but
+  /// see the new limits
+  void SetOptions(PrintBudgetOptions options);
+  PrintBudgetOptions Options() const;
+
+  void SetListener(BackpressureListener listener);
+
+  /// Reserve room for bytes of data to printerName without waiting or
+  /// signalling backpressure. Returns false, with *reservation unset, when
+  /// a limit is reached or earlier jobs for the printer are waiting.
+  bool TryAdmit(const std::string& printerName, uint64_t bytes,
+                std::shared_ptr<PrintReservation>* reservation);
+
+  /// Reserve room for bytes of data to printerName, applying policy when a
+  /// limit is reached; wait bounds kBlock and kSpill, zero waiting until
+  /// there is room. kSpill moves *spillData to a file while it waits and
+  /// reads it back once admitted; without spillData it waits like kBlock.
+  /// *spillData is empty after any failure to admit it.
+  AdmitStatus Admit(const std::string& printerName, uint64_t bytes, OverflowPolicy policy,
+                    std::chrono::milliseconds wait,
+                    std::shared_ptr<PrintReservation>* reservation,
+                    std::vector<uint8_t>* spillData = nullptr);
+
+  /// Usage of the global limits
+  PrintBudgetUsage Usage() const;
+  PrintBudgetUsage Usage(const std::string& printerName) const;
+
+private:
+  // Needs the state's mutex held
+  std::shared_ptr<PrintReservation> Charge(const std::string& printerName, uint64_t bytes);
+
+  std::shared_ptr<PrintReservation::State> state_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_PRINT_BUDGET_H_
@@ -0,0 +1,314 @@
+#include "print_job.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "batch_query.h"
+#include "content_hash.h"
+#include "print_metrics.h"
+
+namespace windows_printer {
+
+namespace {
+
+// Shared between a supervised submission and its watchdog
+struct JobProgress {
+  std::mutex mutex;
+  std::string printerName;
+  uint32_t jobId = 0;
+  /// Stage the worker is in, reported as the one that timed out
+  MetricStage stage = MetricStage::kOpenPrinter;
+  /// Set by the watchdog once it has returned a timeout to the caller
+  bool abandoned = false;
+};
+
+// Notes the stage the worker is entering. Returns false once the watchdog
+// has given up, in which case the worker should stop as soon as possible.
+bool EnterStage(JobProgress* progress, MetricStage stage) {
+  if (progress == nullptr) return true;
+  std::lock_guard<std::mutex> lock(progress->mutex);
+  progress->stage = stage;
+  return !progress->abandoned;
+}
+
+// Records a failed spooler call and keeps the first error code in the result
+void RecordFailure(SpoolerBackend& backend, MetricStage stage, RawPrintResult* result) {
+  uint32_t error = backend.LastError();
+  PrintMetrics::Instance().RecordFailure(stage, error);
+  if (result->errorCode == 0) {
+    result->errorCode = error;
+  }
+}
+
+// Writes data in full, continuing after partial writes. Returns false if a
+// write failed or the watchdog gave up.
+bool WriteAll(SpoolerBackend& backend, PrinterHandle handle, const uint8_t* data, size_t size,
+              JobProgress* progress, RawPrintResult* result) {
+  size_t written = 0;
+  while (written < size) {
+    if (!EnterStage(progress, MetricStage::kWritePrinter)) return false;
+    uint32_t chunk = static_cast<uint32_t>(
+        std::min<size_t>(size - written, std::numeric_limits<uint32_t>::max()));
+    uint32_t chunkWritten = 0;
+    if (!backend.Write(handle, data + written, chunk, &chunkWritten)) {
+      RecordFailure(backend, MetricStage::kWritePrinter, result);
+      return false;
+    }
+    if (chunkWritten == 0) return false;
+    written += chunkWritten;
+    result->bytesWritten += chunkWritten;
+  }
+  return true;
+}
+
+// Matches a cut or feed command ending at data[end] and returns its length,
+// or 0. Cuts are GS V m and GS V m n, ESC i and ESC m; feeds are LF, ESC d n
+// and ESC J n.
+size_t TrailingCommandLength(const uint8_t* data, size_t end, bool* isCut) {
+  *isCut = true;
+  if (end >= 4 && data[end - 4] == 0x1D && data[end - 3] == 0x56) {
+    const uint8_t m = data[end - 2];
+    if (m == 0x41 || m == 0x42 || m == 0x61 || m == 0x62 || m == 0x67 || m == 0x68) return 4;
+  }
+  if (end >= 3 && data[end - 3] == 0x1D && data[end - 2] == 0x56) {
+    const uint8_t m = data[end - 1];
+    if (m == 0x00 || m == 0x01 || m == 0x30 || m == 0x31) return 3;
+  }
+  if (end >= 2 && data[end - 2] == 0x1B && (data[end - 1] == 0x69 || data[end - 1] == 0x6D)) {
+    return 2;
+  }
+  *isCut = false;
+  if (end >= 3 && data[end - 3] == 0x1B && (data[end - 2] == 0x64 || data[end - 2] == 0x4A)) {
+    return 3;
+  }
+  if (end >= 1 && data[end - 1] == 0x0A) return 1;
+  return 0;
+}
+
+RawPrintResult Submit(SpoolerBackend& backend, const std::string& printerName,
+                      const uint8_t* data, size_t size, const RawPrintOptions& options,
+                      JobProgress* progress) {
+  RawPrintResult result;
+
+  std::string actualPrinterName = printerName;
+  // If no printer name provided, use the default printer
+  if (actualPrinterName.empty() && !backend.DefaultPrinterName(&actualPrinterName)) {
+    result.errorCode = backend.LastError();
+    return result;
+  }
+  result.printerName = actualPrinterName;
+
+  if (progress != nullptr) {
+    std::lock_guard<std::mutex> lock(progress->mutex);
+    progress->printerName = actualPrinterName;
+  }
+
+  ScopedQueueEntry queueEntry;
+
+  // Open printer
+  if (!EnterStage(progress, MetricStage::kOpenPrinter)) return result;
+  PrinterHandle handle = nullptr;
+  ScopedStageTimer openTimer(MetricStage::kOpenPrinter);
+  if (!backend.Open(actualPrinterName, &handle)) {
+    RecordFailure(backend, MetricStage::kOpenPrinter, &result);
+    return result;
+  }
+  openTimer.Stop();
+  if (!EnterStage(progress, MetricStage::kStartDocPrinter)) {
+    backend.Close(handle);
+    return result;
+  }
+
+  // Start a print job with the caller's data type
+  RawDocInfo docInfo;
+  docInfo.documentName = options.documentName;
+  docInfo.datatype = options.useRawDatatype ? "RAW" : "TEXT";
+
+  ScopedStageTimer startDocTimer(MetricStage::kStartDocPrinter);
+  result.jobId = backend.StartDocument(handle, docInfo);
+  if (result.jobId == 0) {
+    RecordFailure(backend, MetricStage::kStartDocPrinter, &result);
+    backend.Close(handle);
+    return result;
+  }
+
+  // The watchdog cancels jobs it knows about; one that started after it gave
+  // up is cancelled here instead
+  if (progress != nullptr) {
+    bool abandoned;
+    {
+      std::lock_guard<std::mutex> lock(progress->mutex);
+      progress->jobId = result.jobId;
+      abandoned = progress->abandoned;
+    }
+    if (abandoned) {
+      backend.CancelJob(actualPrinterName, result.jobId);
+      backend.EndDocument(handle);
+      backend.Close(handle);
+      return result;
+    }
+  }
+
+  // Start a page
+  if (!backend.StartPage(handle)) {
+    RecordFailure(backend, MetricStage::kStartDocPrinter, &result);
+    backend.EndDocument(handle);
+    backend.Close(handle);
+    return result;
+  }
+  startDocTimer.SetTraceArg("jobId", result.jobId);
+  startDocTimer.Stop();
+
+  // RAW data bypasses the driver, so only other datatypes can leave copies to
+  // the spooler, and only when every copy is the same
+  const uint32_t copies = static_cast<uint32_t>(std::max(options.copies, 1));
+  if (copies > 1 && !options.useRawDatatype && options.copyVariants.empty()) {
+    result.spoolerCopies = backend.SetJobCopies(handle, result.jobId, copies);
+  }
+  const uint32_t sends = result.spoolerCopies ? 1 : copies;
+  const size_t variantOffset =
+      options.copyVariants.empty() ? size : CopyVariantOffset(data, size);
+
+  // Write each copy, continuing after partial writes until it is all spooled
+  ScopedStageTimer writeTimer(MetricStage::kWritePrinter);
+  bool writeOk = true;
+  size_t expected = 0;
+  for (uint32_t copy = 0; copy < sends && writeOk; copy++) {
+    const std::vector<uint8_t>* variant =
+        copy < options.copyVariants.size() ? &options.copyVariants[copy] : nullptr;
+    if (variant == nullptr || variant->empty()) {
+      expected += size;
+      writeOk = WriteAll(backend, handle, data, size, progress, &result);
+      continue;
+    }
+    expected += size + variant->size();
+    writeOk = WriteAll(backend, handle, data, variantOffset, progress, &result) &&
+              WriteAll(backend, handle, variant->data(), variant->size(), progress, &result) &&
+              WriteAll(backend, handle, data + variantOffset, size - variantOffset, progress,
+                       &result);
+  }
+  PrintMetrics::Instance().RecordBytesWritten(result.bytesWritten);
+  writeTimer.SetTraceArg("bytes", static_cast<int64_t>(result.bytesWritten));
+  writeTimer.Stop();
+
+  // End the page and document. An abandoned job is cancelled first, in case
+  // the watchdog could not.
+  if (!EnterStage(progress, MetricStage::kEndDocPrinter)) {
+    backend.CancelJob(actualPrinterName, result.jobId);
+  }
+  ScopedStageTimer endDocTimer(MetricStage::kEndDocPrinter);
+  backend.EndPage(handle);
+  if (!backend.EndDocument(handle)) {
+    RecordFailure(backend, MetricStage::kEndDocPrinter, &result);
+  }
+  backend.Close(handle);
+  endDocTimer.Stop();
+
+  result.success = writeOk && result.bytesWritten == expected;
+  return result;
+}
+
+}  // namespace
+
+size_t CopyVariantOffset(const uint8_t* data, size_t size) {
+  size_t end = size;
+  bool sawCut = false;
+  bool isCut = false;
+  while (size_t length = TrailingCommandLength(data, end, &isCut)) {
+    end -= length;
+    sawCut = sawCut || isCut;
+  }
+  if (!sawCut) return size;
+  // Keep the line feed that finishes the last printed line
+  if (end < size && data[end] == 0x0A) end++;
+  return end;
+}
+
+uint64_t RawJobContentKey(const uint8_t* data, size_t size, const RawPrintOptions& options) {
+  Hasher64 hasher;
+  hasher.Update(data, size);
+  // Lengths keep the data and each variant apart
+  const uint64_t header[3] = {size, options.useRawDatatype ? 1u : 0u,
+                              static_cast<uint64_t>(options.copies)};
+  hasher.Update(header, sizeof(header));
+  for (const std::vector<uint8_t>& variant : options.copyVariants) {
+    const uint64_t variantSize = variant.size();
+    hasher.Update(&variantSize, sizeof(variantSize));
+    hasher.Update(variant.data(), variant.size());
+  }
+  return hasher.Digest();
+}
+
+uint64_t RawJobIdempotencyKey(const std::string& idempotencyKey) {
+  // A different seed separates the two kinds of key
+  constexpr uint64_t kIdempotencyKeySeed = 0x6964656d706f7465ULL;
+  return Hash64(idempotencyKey.data(), idempotencyKey.size(), kIdempotencyKeySeed);
+}
+
+RawPrintResult SubmitRawJob(const std::shared_ptr<SpoolerBackend>& backend,
+                            const std::string& printerName,
+                            const uint8_t* data, size_t size,
+                            const RawPrintOptions& options) {
+  if (options.timeout.count() <= 0) {
+    return Submit(*backend, printerName, data, size, options, nullptr);
+  }
+  // The worker may outlive this call, so it needs its own copy
+  return SubmitRawJob(backend, printerName,
+                      std::make_shared<const std::vector<uint8_t>>(data, data + size), options);
+}
+
+RawPrintResult SubmitRawJob(const std::shared_ptr<SpoolerBackend>& backend,
+                            const std::string& printerName,
+                            std::shared_ptr<const std::vector<uint8_t>> data,
+                            RawPrintOptions options) {
+  if (options.timeout.count() <= 0) {
+    return Submit(*backend, printerName, data->data(), data->size(), options, nullptr);
+  }
+
+  // The worker may outlive this call, so it shares everything it uses, the
+  // backend included
+  const std::chrono::milliseconds timeout = options.timeout;
+  auto progress = std::make_shared<JobProgress>();
+  auto sharedOptions = std::make_shared<const RawPrintOptions>(std::move(options));
+  std::optional<RawPrintResult> completed = CallWithDeadline<RawPrintResult>(
+      [backend, printerName, data, sharedOptions, progress]() {
+        return Submit(*backend, printerName, data->data(), data->size(), *sharedOptions,
+                      progress.get());
+      },
+      timeout);
+  if (completed) {
+    return *completed;
+  }
+
+  RawPrintResult result;
+  result.timedOut = true;
+  result.errorCode = kErrorTimeout;
+  std::string actualPrinterName;
+  MetricStage stage;
+  {
+    std::lock_guard<std::mutex> lock(progress->mutex);
+    progress->abandoned = true;
+    result.jobId = progress->jobId;
+    result.printerName = progress->printerName;
+    actualPrinterName = progress->printerName;
+    stage = progress->stage;
+  }
+  PrintMetrics::Instance().RecordFailure(stage, kErrorTimeout);
+
+  // Cancelling makes the blocked call fail so the worker can clean up. It is
+  // a spooler call itself and may block too, so the caller does not wait.
+  // Past the abandoned worker limit the worker cancels the job itself once
+  // its call returns.
+  if (result.jobId != 0) {
+    const uint32_t jobId = result.jobId;
+    RunAbandoned([backend, actualPrinterName, jobId]() {
+      backend->CancelJob(actualPrinterName, jobId);
+    });
+  }
+  return result;
+}
+
+}  // namespace windows_printer
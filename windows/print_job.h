@@ -0,0 +1,92 @@
+#ifndef FLUTTER_PLUGIN_PRINT_JOB_H_
+#define FLUTTER_PLUGIN_PRINT_JOB_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "spooler_backend.h"
+
+namespace windows_printer {
+
+class PrintReservation;
+
+/// Error code reported when a deadline passes; ERROR_TIMEOUT on Windows
+constexpr uint32_t kErrorTimeout = 1460;
+
+struct RawPrintOptions {
+  /// Spool as "RAW" rather than "TEXT"
+  bool useRawDatatype = true;
+  std::string documentName = "Raw Print Job";
+  /// Deadline for the whole submission; zero waits as long as the spooler does
+  std::chrono::milliseconds timeout{0};
+  /// Copies printed by this one job. TEXT jobs ask the spooler for them where
+  /// the driver makes copies; otherwise the data is sent once per copy.
+  int copies = 1;
+  /// Bytes printed on copy i only, such as a "MERCHANT COPY" footer. They
+  /// start on the line after the data's last printed line, ahead of its
+  /// closing feeds and cut, or at its end when it has no cut. Copies without
+  /// an entry print the data unchanged.
+  std::vector<std::vector<uint8_t>> copyVariants;
+  /// Room held in a PrintBudget for the data. The worker keeps it with the
+  /// data, so a job abandoned at its deadline stays charged until its
+  /// spooler call returns and the data is freed.
+  std::shared_ptr<PrintReservation> reservation;
+};
+
+struct RawPrintResult {
+  bool success = false;
+  /// Set when the deadline passed; errorCode is then kErrorTimeout
+  bool timedOut = false;
+  /// Spooler job id, 0 if the job was never started
+  uint32_t jobId = 0;
+  /// Printer the job was sent to, with the default printer looked up
+  std::string printerName;
+  /// Error code of the first failed spooler call
+  uint32_t errorCode = 0;
+  size_t bytesWritten = 0;
+  /// The spooler made the copies from a single copy of the data
+  bool spoolerCopies = false;
+};
+
+/// Offset in ESC/POS data where per-copy variants are inserted: after the
+/// line feed that ends the last printed line, when the data finishes with
+/// feeds and at least one cut command. Otherwise the end of the data.
+size_t CopyVariantOffset(const uint8_t* data, size_t size);
+
+/// Deduplication key of a raw job's printed output: its data, datatype,
+/// copies and copy variants. A hash, so cheap even for raster images.
+uint64_t RawJobContentKey(const uint8_t* data, size_t size, const RawPrintOptions& options);
+
+/// Deduplication key for a caller-chosen idempotency key. Never equal to a
+/// content key of the same bytes.
+uint64_t RawJobIdempotencyKey(const std::string& idempotencyKey);
+
+/// Send data to a printer as a single raw document. An empty printer name
+/// selects the default printer. Every spooler call is recorded in
+/// PrintMetrics and traced.
+///
+/// With a timeout the spooler calls run on a watchdog-supervised worker and
+/// data is copied first. When the deadline passes the worker is abandoned,
+/// the job is cancelled through backend->CancelJob if it had started (or as
+/// soon as it does), and a timed-out result is returned. The abandoned
+/// worker and the cancellation keep their own reference to backend.
+RawPrintResult SubmitRawJob(const std::shared_ptr<SpoolerBackend>& backend,
+                            const std::string& printerName,
+                            const uint8_t* data, size_t size,
+                            const RawPrintOptions& options = RawPrintOptions());
+
+/// SubmitRawJob for data that is already owned: with a timeout the worker
+/// shares data and takes options over instead of copying them, so the
+/// memory held matches what a PrintBudget charged for.
+RawPrintResult SubmitRawJob(const std::shared_ptr<SpoolerBackend>& backend,
+                            const std::string& printerName,
+                            std::shared_ptr<const std::vector<uint8_t>> data,
+                            RawPrintOptions options);
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_PRINT_JOB_H_
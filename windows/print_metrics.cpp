@@ -0,0 +1,404 @@
+#include "print_metrics.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace windows_printer {
+
+namespace {
+
+int64_t SteadyNowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Index of the most significant set bit; value must be non-zero
+int HighestBit(uint64_t value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index = 0;
+  _BitScanReverse64(&index, value);
+  return static_cast<int>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+  return 63 - __builtin_clzll(value);
+#else
+  int index = 0;
+  while (value >>= 1) index++;
+  return index;
+#endif
+}
+
+uint64_t HashName(std::string_view name) {
+  uint64_t hash = 1469598103934665603ULL;
+  for (char c : name) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+void AtomicMin(std::atomic<uint64_t>& target, uint64_t value) {
+  uint64_t current = target.load(std::memory_order_relaxed);
+  while (value < current &&
+         !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+void AtomicMax(std::atomic<uint64_t>& target, uint64_t value) {
+  uint64_t current = target.load(std::memory_order_relaxed);
+  while (value > current &&
+         !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+const char* const kStageNames[] = {
+  "decodeArguments",
+  "encodeResult",
+  "openPrinter",
+  "queryPrinter",
+  "startDocPrinter",
+  "writePrinter",
+  "endDocPrinter",
+};
+static_assert(sizeof(kStageNames) / sizeof(kStageNames[0]) ==
+                  static_cast<size_t>(MetricStage::kCount),
+              "Every MetricStage needs a name");
+
+}  // namespace
+
+const char* MetricStageName(MetricStage stage) {
+  int index = static_cast<int>(stage);
+  if (index < 0 || index >= static_cast<int>(MetricStage::kCount)) return "unknown";
+  return kStageNames[index];
+}
+
+// LatencyHistogram implementation
+
+int LatencyHistogram::BucketIndex(uint64_t value) {
+  if (value < static_cast<uint64_t>(kSubBucketCount)) {
+    return static_cast<int>(value);
+  }
+  int msb = HighestBit(value);
+  if (msb >= kMaxValueBits) {
+    return kBucketCount - 1;
+  }
+  // Values with their top bit at msb share an octave; the next
+  // kSubBucketBits bits select the linear sub-bucket inside it.
+  int shift = msb - kSubBucketBits;
+  int octave = msb - kSubBucketBits + 1;
+  int subBucket = static_cast<int>((value >> shift) & (kSubBucketCount - 1));
+  return octave * kSubBucketCount + subBucket;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(int index) {
+  if (index < kSubBucketCount) {
+    return static_cast<uint64_t>(index);
+  }
+  int octave = index / kSubBucketCount;
+  int subBucket = index % kSubBucketCount;
+  int shift = octave - 1;
+  uint64_t lower = static_cast<uint64_t>(kSubBucketCount + subBucket) << shift;
+  return lower + ((1ULL << shift) - 1);
+}
+
+void LatencyHistogram::Record(uint64_t value) {
+  buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  AtomicMin(min_, value);
+  AtomicMax(max_, value);
+}
+
+void LatencyHistogram::Reset() {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  sum_.store(0, std::memory_order_relaxed);
+  min_.store(UINT64_MAX, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+HistogramSummary LatencyHistogram::Summarize(std::string name) const {
+  HistogramSummary summary;
+  summary.name = std::move(name);
+
+  // Counts come from the buckets alone, so percentiles stay self-consistent
+  // even when the snapshot races with Record().
+  std::array<uint64_t, kBucketCount> counts;
+  uint64_t total = 0;
+  for (int i = 0; i < kBucketCount; i++) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0) {
+    return summary;
+  }
+
+  summary.count = total;
+  summary.sum = sum_.load(std::memory_order_relaxed);
+  summary.min = min_.load(std::memory_order_relaxed);
+  summary.max = max_.load(std::memory_order_relaxed);
+  if (summary.min > summary.max) summary.min = summary.max;
+  summary.mean = static_cast<double>(summary.sum) / static_cast<double>(total);
+
+  const double quantiles[] = {0.50, 0.90, 0.99, 0.999};
+  uint64_t* outputs[] = {&summary.p50, &summary.p90, &summary.p99, &summary.p999};
+  int next = 0;
+  uint64_t cumulative = 0;
+  for (int i = 0; i < kBucketCount && next < 4; i++) {
+    cumulative += counts[i];
+    while (next < 4 &&
+           static_cast<double>(cumulative) >= quantiles[next] * static_cast<double>(total)) {
+      *outputs[next] = std::clamp(BucketUpperBound(i), summary.min, summary.max);
+      next++;
+    }
+  }
+  return summary;
+}
+
+// PrintMetrics implementation
+
+PrintMetrics::PrintMetrics() {
+  resetTime_.store(SteadyNowNanos(), std::memory_order_relaxed);
+}
+
+PrintMetrics& PrintMetrics::Instance() {
+  static PrintMetrics instance;
+  return instance;
+}
+
+void PrintMetrics::RecordStage(MetricStage stage, uint64_t nanos) {
+  int index = static_cast<int>(stage);
+  if (index < 0 || index >= static_cast<int>(MetricStage::kCount)) return;
+  stages_[index].Record(nanos);
+}
+
+PrintMetrics::MethodSlot* PrintMetrics::FindOrClaimMethod(std::string_view methodName) {
+  if (methodName.size() > kMaxMethodNameLength) {
+    methodName = methodName.substr(0, kMaxMethodNameLength);
+  }
+  uint64_t hash = HashName(methodName);
+  size_t start = static_cast<size_t>(hash % kMaxMethods);
+
+  for (size_t probe = 0; probe < kMaxMethods; probe++) {
+    MethodSlot& slot = methods_[(start + probe) % kMaxMethods];
+    int state = slot.state.load(std::memory_order_acquire);
+
+    if (state == 0) {
+      int expected = 0;
+      if (slot.state.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+        std::memcpy(slot.name, methodName.data(), methodName.size());
+        slot.name[methodName.size()] = '\0';
+        slot.hash.store(hash, std::memory_order_relaxed);
+        slot.state.store(2, std::memory_order_release);
+        return &slot;
+      }
+      state = expected;
+    }
+
+    // Another thread is publishing this slot; the window is a few stores
+    while (state == 1) {
+      std::this_thread::yield();
+      state = slot.state.load(std::memory_order_acquire);
+    }
+
+    if (slot.hash.load(std::memory_order_relaxed) == hash &&
+        methodName == std::string_view(slot.name)) {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+void PrintMetrics::RecordMethod(std::string_view methodName, uint64_t nanos, bool failed) {
+  MethodSlot* slot = FindOrClaimMethod(methodName);
+  if (!slot) return;
+  slot->latency.Record(nanos);
+  if (failed) {
+    slot->failures.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void PrintMetrics::RecordFailure(MetricStage stage, uint32_t errorCode) {
+  uint64_t key = ((static_cast<uint64_t>(stage) << 32) | errorCode) + 1;
+  size_t start = static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 58) % kMaxErrorCodes;
+
+  for (size_t probe = 0; probe < kMaxErrorCodes; probe++) {
+    ErrorSlot& slot = errors_[(start + probe) % kMaxErrorCodes];
+    uint64_t current = slot.key.load(std::memory_order_relaxed);
+    if (current == 0 &&
+        slot.key.compare_exchange_strong(current, key, std::memory_order_relaxed)) {
+      current = key;
+    }
+    if (current == key) {
+      slot.count.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  droppedErrors_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PrintMetrics::RecordBytesWritten(uint64_t bytes) {
+  bytesWritten_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void PrintMetrics::QueueEnter() {
+  int64_t depth = queueDepth_.fetch_add(1, std::memory_order_relaxed) + 1;
+  int64_t peak = peakQueueDepth_.load(std::memory_order_relaxed);
+  while (depth > peak &&
+         !peakQueueDepth_.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {
+  }
+}
+
+void PrintMetrics::QueueExit() {
+  queueDepth_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void PrintMetrics::RecordPending(int64_t jobs, int64_t bytes) {
+  pendingJobs_.fetch_add(jobs, std::memory_order_relaxed);
+  int64_t pending = pendingBytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  int64_t peak = peakPendingBytes_.load(std::memory_order_relaxed);
+  while (pending > peak &&
+         !peakPendingBytes_.compare_exchange_weak(peak, pending, std::memory_order_relaxed)) {
+  }
+}
+
+void PrintMetrics::RecordRejected() {
+  rejectedJobs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PrintMetrics::RecordBlocked() {
+  blockedJobs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PrintMetrics::RecordSpilled(int64_t bytes) {
+  if (bytes > 0) {
+    spilledJobs_.fetch_add(1, std::memory_order_relaxed);
+  }
+  spilledBytes_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+MetricsSnapshot PrintMetrics::Snapshot() const {
+  MetricsSnapshot snapshot;
+  int64_t elapsed = SteadyNowNanos() - resetTime_.load(std::memory_order_relaxed);
+  snapshot.elapsedSeconds = static_cast<double>(elapsed) / 1e9;
+
+  for (int i = 0; i < static_cast<int>(MetricStage::kCount); i++) {
+    snapshot.stages.push_back(stages_[i].Summarize(kStageNames[i]));
+  }
+
+  for (const MethodSlot& slot : methods_) {
+    if (slot.state.load(std::memory_order_acquire) != 2) continue;
+    MethodSummary method;
+    method.latency = slot.latency.Summarize(slot.name);
+    if (method.latency.count == 0) continue;
+    method.failures = slot.failures.load(std::memory_order_relaxed);
+    if (snapshot.elapsedSeconds > 0) {
+      method.callsPerSecond =
+          static_cast<double>(method.latency.count) / snapshot.elapsedSeconds;
+    }
+    snapshot.methods.push_back(std::move(method));
+  }
+  std::sort(snapshot.methods.begin(), snapshot.methods.end(),
+            [](const MethodSummary& a, const MethodSummary& b) {
+              return a.latency.name < b.latency.name;
+            });
+
+  for (const ErrorSlot& slot : errors_) {
+    uint64_t key = slot.key.load(std::memory_order_relaxed);
+    uint64_t count = slot.count.load(std::memory_order_relaxed);
+    if (key == 0 || count == 0) continue;
+    key -= 1;
+    ErrorCount error;
+    error.stage = MetricStageName(static_cast<MetricStage>(key >> 32));
+    error.code = static_cast<uint32_t>(key & 0xFFFFFFFFu);
+    error.count = count;
+    snapshot.errors.push_back(std::move(error));
+  }
+
+  snapshot.droppedErrors = droppedErrors_.load(std::memory_order_relaxed);
+  snapshot.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+  snapshot.queueDepth =
+      static_cast<uint64_t>(std::max<int64_t>(0, queueDepth_.load(std::memory_order_relaxed)));
+  snapshot.peakQueueDepth =
+      static_cast<uint64_t>(std::max<int64_t>(0, peakQueueDepth_.load(std::memory_order_relaxed)));
+  snapshot.pendingJobs =
+      static_cast<uint64_t>(std::max<int64_t>(0, pendingJobs_.load(std::memory_order_relaxed)));
+  snapshot.pendingBytes =
+      static_cast<uint64_t>(std::max<int64_t>(0, pendingBytes_.load(std::memory_order_relaxed)));
+  snapshot.peakPendingBytes = static_cast<uint64_t>(
+      std::max<int64_t>(0, peakPendingBytes_.load(std::memory_order_relaxed)));
+  snapshot.spilledBytes =
+      static_cast<uint64_t>(std::max<int64_t>(0, spilledBytes_.load(std::memory_order_relaxed)));
+  snapshot.rejectedJobs = rejectedJobs_.load(std::memory_order_relaxed);
+  snapshot.blockedJobs = blockedJobs_.load(std::memory_order_relaxed);
+  snapshot.spilledJobs = spilledJobs_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+void PrintMetrics::Reset() {
+  for (auto& stage : stages_) {
+    stage.Reset();
+  }
+  for (auto& slot : methods_) {
+    slot.latency.Reset();
+    slot.failures.store(0, std::memory_order_relaxed);
+  }
+  // Error slots keep their keys so concurrent writers never see a slot
+  // change identity under them; zero counts are left out of snapshots.
+  for (auto& slot : errors_) {
+    slot.count.store(0, std::memory_order_relaxed);
+  }
+  droppedErrors_.store(0, std::memory_order_relaxed);
+  bytesWritten_.store(0, std::memory_order_relaxed);
+  // Jobs in flight are still in flight, so the peak restarts from the
+  // current depth instead of zero.
+  peakQueueDepth_.store(queueDepth_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  peakPendingBytes_.store(pendingBytes_.load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+  rejectedJobs_.store(0, std::memory_order_relaxed);
+  blockedJobs_.store(0, std::memory_order_relaxed);
+  spilledJobs_.store(0, std::memory_order_relaxed);
+  resetTime_.store(SteadyNowNanos(), std::memory_order_relaxed);
+}
+
+// ScopedStageTimer implementation
+
+ScopedStageTimer::ScopedStageTimer(MetricStage stage, PrintMetrics& metrics,
+                                   PrintTracer& tracer)
+    : stage_(stage),
+      metrics_(metrics),
+      tracer_(tracer.IsEnabled() ? &tracer : nullptr),
+      start_(std::chrono::steady_clock::now()) {
+  if (tracer_) {
+    traceStart_ = tracer_->Now();
+  }
+}
+
+ScopedStageTimer::~ScopedStageTimer() {
+  Stop();
+}
+
+void ScopedStageTimer::SetTraceArg(std::string_view name, int64_t value) {
+  traceArgName_ = name;
+  traceArgValue_ = value;
+}
+
+void ScopedStageTimer::Stop() {
+  if (!running_) return;
+  running_ = false;
+  auto elapsed = std::chrono::steady_clock::now() - start_;
+  metrics_.RecordStage(
+      stage_,
+      static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+  if (tracer_) {
+    tracer_->Record(MetricStageName(stage_), "print", traceStart_, tracer_->Now(),
+                    traceArgName_, traceArgValue_);
+  }
+}
+
+}  // namespace windows_printer
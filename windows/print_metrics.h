@@ -0,0 +1,227 @@
+#ifndef FLUTTER_PLUGIN_PRINT_METRICS_H_
+#define FLUTTER_PLUGIN_PRINT_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "print_trace.h"
+
+namespace windows_printer {
+
+/// Stages of the native print path that are timed individually
+enum class MetricStage : int {
+  kDecodeArguments = 0,
+  kEncodeResult,
+  kOpenPrinter,
+  kQueryPrinter,
+  kStartDocPrinter,
+  kWritePrinter,
+  kEndDocPrinter,
+  kCount
+};
+
+/// Returns the name used for a stage in metric snapshots
+const char* MetricStageName(MetricStage stage);
+
+/// Summary of a latency histogram. All values are in nanoseconds.
+struct HistogramSummary {
+  std::string name;
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  uint64_t min = 0;
+  uint64_t max = 0;
+  double mean = 0.0;
+  uint64_t p50 = 0;
+  uint64_t p90 = 0;
+  uint64_t p99 = 0;
+  uint64_t p999 = 0;
+};
+
+/// Latency, failure count and throughput of one channel method
+struct MethodSummary {
+  HistogramSummary latency;
+  uint64_t failures = 0;
+  double callsPerSecond = 0.0;
+};
+
+/// Number of failures seen for one (stage, error code) pair
+struct ErrorCount {
+  std::string stage;
+  uint32_t code = 0;
+  uint64_t count = 0;
+};
+
+/// Point-in-time copy of all metrics
+struct MetricsSnapshot {
+  double elapsedSeconds = 0.0;
+  std::vector<HistogramSummary> stages;
+  std::vector<MethodSummary> methods;
+  std::vector<ErrorCount> errors;
+  /// Failures not attributed to a code because the error table was full
+  uint64_t droppedErrors = 0;
+  uint64_t bytesWritten = 0;
+  uint64_t queueDepth = 0;
+  uint64_t peakQueueDepth = 0;
+  /// Print data held by jobs under a PrintBudget
+  uint64_t pendingJobs = 0;
+  uint64_t pendingBytes = 0;
+  uint64_t peakPendingBytes = 0;
+  /// Bytes waiting in spill files
+  uint64_t spilledBytes = 0;
+  /// Submissions that found a budget limit reached and were turned away,
+  /// waited in memory or waited in a spill file
+  uint64_t rejectedJobs = 0;
+  uint64_t blockedJobs = 0;
+  uint64_t spilledJobs = 0;
+};
+
+/// Log-linear latency histogram in the style of HdrHistogram. Each power of
+/// two is split into 16 linear sub-buckets, which bounds the relative error
+/// of any reported percentile to about 6%. Recording is wait-free.
+class LatencyHistogram {
+public:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBucketCount = 1 << kSubBucketBits;
+  /// Values at or above 2^42 ns (~73 minutes) land in the last bucket
+  static constexpr int kMaxValueBits = 42;
+  static constexpr int kBucketCount =
+      (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount;
+
+  void Record(uint64_t value);
+  void Reset();
+  HistogramSummary Summarize(std::string name) const;
+
+  static int BucketIndex(uint64_t value);
+  static uint64_t BucketUpperBound(int index);
+
+private:
+  std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> min_{UINT64_MAX};
+  std::atomic<uint64_t> max_{0};
+};
+
+/// Process-wide counters and latency histograms for the print path.
+///
+/// Every recording call uses relaxed atomics only, so instrumentation never
+/// takes a lock on the hot path. Snapshot and Reset may run concurrently with
+/// recording; a snapshot taken during a reset can mix old and new values.
+class PrintMetrics {
+public:
+  static constexpr int kMaxMethods = 32;
+  static constexpr int kMaxErrorCodes = 64;
+  static constexpr size_t kMaxMethodNameLength = 47;
+
+  PrintMetrics();
+
+  /// The instance used by the plugin
+  static PrintMetrics& Instance();
+
+  void RecordStage(MetricStage stage, uint64_t nanos);
+  void RecordMethod(std::string_view methodName, uint64_t nanos, bool failed);
+  void RecordFailure(MetricStage stage, uint32_t errorCode);
+  void RecordBytesWritten(uint64_t bytes);
+
+  /// Track jobs that are currently between OpenPrinter and ClosePrinter
+  void QueueEnter();
+  void QueueExit();
+
+  /// Adjust the print data held under a PrintBudget
+  void RecordPending(int64_t jobs, int64_t bytes);
+  void RecordRejected();
+  void RecordBlocked();
+  /// Bytes moved into (positive, counting a spilled job) or out of
+  /// (negative) spill files
+  void RecordSpilled(int64_t bytes);
+
+  MetricsSnapshot Snapshot() const;
+  void Reset();
+
+private:
+  struct MethodSlot {
+    // 0 = free, 1 = being claimed, 2 = ready
+    std::atomic<int> state{0};
+    std::atomic<uint64_t> hash{0};
+    char name[kMaxMethodNameLength + 1] = {0};
+    std::atomic<uint64_t> failures{0};
+    LatencyHistogram latency;
+  };
+
+  struct ErrorSlot {
+    // (stage << 32 | code) + 1, 0 while the slot is unused
+    std::atomic<uint64_t> key{0};
+    std::atomic<uint64_t> count{0};
+  };
+
+  MethodSlot* FindOrClaimMethod(std::string_view methodName);
+
+  std::array<LatencyHistogram, static_cast<int>(MetricStage::kCount)> stages_;
+  std::array<MethodSlot, kMaxMethods> methods_;
+  std::array<ErrorSlot, kMaxErrorCodes> errors_;
+  std::atomic<uint64_t> droppedErrors_{0};
+  std::atomic<uint64_t> bytesWritten_{0};
+  std::atomic<int64_t> queueDepth_{0};
+  std::atomic<int64_t> peakQueueDepth_{0};
+  std::atomic<int64_t> pendingJobs_{0};
+  std::atomic<int64_t> pendingBytes_{0};
+  std::atomic<int64_t> peakPendingBytes_{0};
+  std::atomic<int64_t> spilledBytes_{0};
+  std::atomic<uint64_t> rejectedJobs_{0};
+  std::atomic<uint64_t> blockedJobs_{0};
+  std::atomic<uint64_t> spilledJobs_{0};
+  std::atomic<int64_t> resetTime_{0};
+};
+
+/// Times a stage from construction until Stop() or destruction. When
+/// tracing is enabled the stage is also recorded as a trace span.
+class ScopedStageTimer {
+public:
+  explicit ScopedStageTimer(MetricStage stage,
+                            PrintMetrics& metrics = PrintMetrics::Instance(),
+                            PrintTracer& tracer = PrintTracer::Instance());
+  ~ScopedStageTimer();
+
+  ScopedStageTimer(const ScopedStageTimer&) = delete;
+  ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+  /// Attach a numeric argument to the trace span, e.g. bytes written
+  void SetTraceArg(std::string_view name, int64_t value);
+
+  /// Record the elapsed time now; later calls and the destructor do nothing
+  void Stop();
+
+private:
+  MetricStage stage_;
+  PrintMetrics& metrics_;
+  PrintTracer* tracer_;
+  std::chrono::steady_clock::time_point start_;
+  int64_t traceStart_ = 0;
+  std::string_view traceArgName_;
+  int64_t traceArgValue_ = 0;
+  bool running_ = true;
+};
+
+/// Counts a job in the queue depth gauge for the lifetime of the object
+class ScopedQueueEntry {
+public:
+  explicit ScopedQueueEntry(PrintMetrics& metrics = PrintMetrics::Instance())
+      : metrics_(metrics) {
+    metrics_.QueueEnter();
+  }
+  ~ScopedQueueEntry() { metrics_.QueueExit(); }
+
+  ScopedQueueEntry(const ScopedQueueEntry&) = delete;
+  ScopedQueueEntry& operator=(const ScopedQueueEntry&) = delete;
+
+private:
+  PrintMetrics& metrics_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_PRINT_METRICS_H_
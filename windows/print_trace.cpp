@@ -0,0 +1,176 @@
+#include "print_trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace windows_printer {
+
+namespace {
+
+void AppendJsonString(std::string& out, const std::string& value) {
+  out += '"';
+  for (char c : value) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+          out += escaped;
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+// Chrome trace timestamps are microseconds; keep nanosecond precision
+void AppendMicros(std::string& out, int64_t nanos) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%lld.%03lld",
+                static_cast<long long>(nanos / 1000), static_cast<long long>(nanos % 1000));
+  out += buffer;
+}
+
+}  // namespace
+
+PrintTracer::PrintTracer(size_t capacity)
+    : capacity_(capacity > 0 ? capacity : 1),
+      slots_(new Slot[capacity > 0 ? capacity : 1]()),
+      epoch_(std::chrono::steady_clock::now()) {}
+
+PrintTracer::~PrintTracer() = default;
+
+PrintTracer& PrintTracer::Instance() {
+  static PrintTracer instance;
+  return instance;
+}
+
+int64_t PrintTracer::Now() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - epoch_)
+      .count();
+}
+
+uint32_t PrintTracer::CurrentThreadId() {
+  static std::atomic<uint32_t> nextId{1};
+  thread_local uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+  return id;
+}
+
+void PrintTracer::StoreName(PackedName& target, std::string_view value) {
+  char buffer[kNameWords * 8] = {0};
+  std::memcpy(buffer, value.data(), std::min(value.size(), kMaxNameLength));
+  for (size_t i = 0; i < kNameWords; i++) {
+    uint64_t word;
+    std::memcpy(&word, buffer + i * 8, 8);
+    target[i].store(word, std::memory_order_relaxed);
+  }
+}
+
+std::string PrintTracer::LoadName(const PackedName& source) {
+  char buffer[kNameWords * 8 + 1] = {0};
+  for (size_t i = 0; i < kNameWords; i++) {
+    uint64_t word = source[i].load(std::memory_order_relaxed);
+    std::memcpy(buffer + i * 8, &word, 8);
+  }
+  return std::string(buffer);
+}
+
+void PrintTracer::Record(std::string_view name, std::string_view category, int64_t startNanos,
+                         int64_t endNanos, std::string_view argName, int64_t argValue) {
+  uint64_t index = next_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots_[index % capacity_];
+
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  StoreName(slot.name, name);
+  StoreName(slot.category, category);
+  StoreName(slot.argName, argName);
+  slot.startNanos.store(startNanos, std::memory_order_relaxed);
+  slot.durationNanos.store(std::max<int64_t>(0, endNanos - startNanos), std::memory_order_relaxed);
+  slot.argValue.store(argValue, std::memory_order_relaxed);
+  slot.threadId.store(CurrentThreadId(), std::memory_order_relaxed);
+
+  slot.sequence.store(2 * (index + 1), std::memory_order_release);
+}
+
+std::vector<TraceEvent> PrintTracer::Events() const {
+  std::vector<TraceEvent> events;
+  events.reserve(capacity_);
+
+  for (size_t i = 0; i < capacity_; i++) {
+    const Slot& slot = slots_[i];
+    uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before == 0 || (before & 1) != 0) continue;
+
+    TraceEvent event;
+    event.name = LoadName(slot.name);
+    event.category = LoadName(slot.category);
+    event.argName = LoadName(slot.argName);
+    event.startNanos = slot.startNanos.load(std::memory_order_relaxed);
+    event.durationNanos = slot.durationNanos.load(std::memory_order_relaxed);
+    event.argValue = slot.argValue.load(std::memory_order_relaxed);
+    event.threadId = slot.threadId.load(std::memory_order_relaxed);
+
+    // Skip the slot if a writer reused it while we were reading
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != before) continue;
+
+    events.push_back(std::move(event));
+  }
+
+  std::sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+    return a.startNanos < b.startNanos;
+  });
+  return events;
+}
+
+void PrintTracer::Clear() {
+  for (size_t i = 0; i < capacity_; i++) {
+    slots_[i].sequence.store(0, std::memory_order_relaxed);
+  }
+}
+
+std::string PrintTracer::ToChromeTraceJson() const {
+  return ToChromeTraceJson(Events());
+}
+
+std::string PrintTracer::ToChromeTraceJson(const std::vector<TraceEvent>& events) {
+  std::string json = "{\"traceEvents\":[";
+  bool first = true;
+  for (const TraceEvent& event : events) {
+    if (!first) json += ',';
+    first = false;
+
+    json += "{\"name\":";
+    AppendJsonString(json, event.name);
+    json += ",\"cat\":";
+    AppendJsonString(json, event.category);
+    json += ",\"ph\":\"X\",\"ts\":";
+    AppendMicros(json, event.startNanos);
+    json += ",\"dur\":";
+    AppendMicros(json, event.durationNanos);
+    json += ",\"pid\":1,\"tid\":";
+    json += std::to_string(event.threadId);
+    if (!event.argName.empty()) {
+      json += ",\"args\":{";
+      AppendJsonString(json, event.argName);
+      json += ':';
+      json += std::to_string(event.argValue);
+      json += '}';
+    }
+    json += '}';
+  }
+  json += "],\"displayTimeUnit\":\"ms\"}";
+  return json;
+}
+
+}  // namespace windows_printer
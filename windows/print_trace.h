@@ -0,0 +1,136 @@
+#ifndef FLUTTER_PLUGIN_PRINT_TRACE_H_
+#define FLUTTER_PLUGIN_PRINT_TRACE_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace windows_printer {
+
+/// A completed span, as read back from the trace buffer
+struct TraceEvent {
+  std::string name;
+  std::string category;
+  /// Start time in nanoseconds since the tracer was created
+  int64_t startNanos = 0;
+  int64_t durationNanos = 0;
+  uint32_t threadId = 0;
+  /// Optional numeric argument; omitted from the output when argName is empty
+  std::string argName;
+  int64_t argValue = 0;
+};
+
+/// Span recorder for the native print path.
+///
+/// Spans are written into a fixed-size ring buffer without locks; once the
+/// buffer is full the oldest spans are overwritten. While tracing is disabled
+/// a span costs a single relaxed atomic load.
+class PrintTracer {
+public:
+  static constexpr size_t kDefaultCapacity = 4096;
+  /// Names and categories longer than this are truncated
+  static constexpr size_t kMaxNameLength = 31;
+
+  explicit PrintTracer(size_t capacity = kDefaultCapacity);
+  ~PrintTracer();
+
+  PrintTracer(const PrintTracer&) = delete;
+  PrintTracer& operator=(const PrintTracer&) = delete;
+
+  /// The instance used by the plugin
+  static PrintTracer& Instance();
+
+  void SetEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+  bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /// Nanoseconds since the tracer was created
+  int64_t Now() const;
+
+  void Record(std::string_view name, std::string_view category, int64_t startNanos,
+              int64_t endNanos, std::string_view argName = {}, int64_t argValue = 0);
+
+  /// Spans currently held in the buffer, ordered by start time
+  std::vector<TraceEvent> Events() const;
+  void Clear();
+
+  /// Serializes the buffer as Chrome trace-event JSON (Perfetto compatible)
+  std::string ToChromeTraceJson() const;
+  static std::string ToChromeTraceJson(const std::vector<TraceEvent>& events);
+
+  /// Small, stable id for the calling thread
+  static uint32_t CurrentThreadId();
+
+private:
+  // Strings are stored as relaxed atomic words so that a reader racing with
+  // a writer sees torn data (rejected by the sequence check) rather than a
+  // data race.
+  static constexpr size_t kNameWords = (kMaxNameLength + 1) / 8;
+  using PackedName = std::array<std::atomic<uint64_t>, kNameWords>;
+
+  struct Slot {
+    // 0 = never written, odd = being written, 2 * (index + 1) = complete
+    std::atomic<uint64_t> sequence{0};
+    PackedName name;
+    PackedName category;
+    PackedName argName;
+    std::atomic<int64_t> startNanos{0};
+    std::atomic<int64_t> durationNanos{0};
+    std::atomic<int64_t> argValue{0};
+    std::atomic<uint32_t> threadId{0};
+  };
+
+  static void StoreName(PackedName& target, std::string_view value);
+  static std::string LoadName(const PackedName& source);
+
+  const size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t> next_{0};
+  std::atomic<bool> enabled_{false};
+  const std::chrono::steady_clock::time_point epoch_;
+};
+
+/// Records a span from construction to destruction when tracing is enabled
+class ScopedTraceSpan {
+public:
+  explicit ScopedTraceSpan(std::string_view name, std::string_view category = "print",
+                           PrintTracer& tracer = PrintTracer::Instance())
+      : tracer_(tracer.IsEnabled() ? &tracer : nullptr) {
+    if (tracer_) {
+      name_ = name;
+      category_ = category;
+      start_ = tracer_->Now();
+    }
+  }
+
+  ~ScopedTraceSpan() {
+    if (tracer_) {
+      tracer_->Record(name_, category_, start_, tracer_->Now(), argName_, argValue_);
+    }
+  }
+
+  ScopedTraceSpan(const ScopedTraceSpan&) = delete;
+  ScopedTraceSpan& operator=(const ScopedTraceSpan&) = delete;
+
+  /// Attach a numeric argument, e.g. a byte count or job id
+  void SetArg(std::string_view name, int64_t value) {
+    argName_ = name;
+    argValue_ = value;
+  }
+
+private:
+  PrintTracer* tracer_;
+  std::string_view name_;
+  std::string_view category_;
+  std::string_view argName_;
+  int64_t argValue_ = 0;
+  int64_t start_ = 0;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_PRINT_TRACE_H_
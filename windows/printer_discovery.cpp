@@ -0,0 +1,211 @@
+#include "printer_discovery.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace windows_printer {
+
+namespace {
+
+// One printer per line: "L\t<name>" for local printers, "C\t<name>" for
+// connections. Unknown lines are skipped so the format can grow.
+constexpr char kLocalTag = 'L';
+constexpr char kConnectionTag = 'C';
+
+std::vector<DiscoveredPrinter>::iterator FindPrinter(std::vector<DiscoveredPrinter>& printers,
+                                                     const std::string& name) {
+  return std::find_if(printers.begin(), printers.end(),
+                      [&name](const DiscoveredPrinter& printer) { return printer.name == name; });
+}
+
+}  // namespace
+
+struct PrinterDiscovery::State {
+  std::shared_ptr<PrinterEnumerator> enumerator;
+  std::string snapshotPath;
+
+  mutable std::mutex mutex;
+  mutable std::condition_variable idle;
+  std::vector<DiscoveredPrinter> printers;
+  DiscoveryListener listener;
+  bool loaded = false;
+  bool fromCache = false;
+  bool scanning = false;
+  bool rescanRequested = false;
+
+  // Must be called with mutex held
+  void Emit(DiscoveryEventType type, std::vector<DiscoveredPrinter> changed) {
+    if (!listener) return;
+    DiscoveryEvent event;
+    event.type = type;
+    event.printers = std::move(changed);
+    event.fromCache = type == DiscoveryEventType::kSnapshot && fromCache;
+    listener(event);
+  }
+};
+
+PrinterDiscovery::PrinterDiscovery(std::shared_ptr<PrinterEnumerator> enumerator,
+                                   std::string snapshotPath)
+    : state_(std::make_shared<State>()) {
+  state_->enumerator = std::move(enumerator);
+  state_->snapshotPath = std::move(snapshotPath);
+}
+
+PrinterDiscovery::~PrinterDiscovery() {
+  Stop();
+}
+
+void PrinterDiscovery::Start(DiscoveryListener listener) {
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (!state_->loaded) {
+      state_->loaded = true;
+      if (!state_->snapshotPath.empty()) {
+        state_->printers = LoadSnapshot(state_->snapshotPath);
+        state_->fromCache = !state_->printers.empty();
+      }
+    }
+    state_->listener = std::move(listener);
+    state_->Emit(DiscoveryEventType::kSnapshot, state_->printers);
+  }
+  Refresh();
+}
+
+void PrinterDiscovery::Stop() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->listener = nullptr;
+}
+
+void PrinterDiscovery::Refresh() {
+  RefreshLocal(*state_);
+
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->scanning) {
+      state_->rescanRequested = true;
+      return;
+    }
+    state_->scanning = true;
+  }
+  std::thread(&PrinterDiscovery::EnumerateConnections, state_).detach();
+}
+
+std::vector<DiscoveredPrinter> PrinterDiscovery::Snapshot() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->printers;
+}
+
+bool PrinterDiscovery::WaitForIdle(std::chrono::milliseconds timeout) const {
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  return state_->idle.wait_for(lock, timeout, [this]() { return !state_->scanning; });
+}
+
+void PrinterDiscovery::RefreshLocal(State& state) {
+  std::vector<std::string> local = state.enumerator->EnumerateLocal();
+
+  std::lock_guard<std::mutex> lock(state.mutex);
+  for (const std::string& name : local) {
+    auto it = FindPrinter(state.printers, name);
+    if (it == state.printers.end()) {
+      state.printers.push_back(DiscoveredPrinter{name, true});
+      state.Emit(DiscoveryEventType::kAdded, {state.printers.back()});
+    } else {
+      it->isLocal = true;
+    }
+  }
+
+  for (auto it = state.printers.begin(); it != state.printers.end();) {
+    if (it->isLocal && std::find(local.begin(), local.end(), it->name) == local.end()) {
+      DiscoveredPrinter removed = std::move(*it);
+      it = state.printers.erase(it);
+      state.Emit(DiscoveryEventType::kRemoved, {std::move(removed)});
+    } else {
+      ++it;
+    }
+  }
+}
+
+void PrinterDiscovery::EnumerateConnections(std::shared_ptr<State> state) {
+  bool rescan = true;
+  while (rescan) {
+    std::vector<std::string> seen;
+    state->enumerator->EnumerateConnections([&state, &seen](const std::string& name) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      seen.push_back(name);
+      if (FindPrinter(state->printers, name) == state->printers.end()) {
+        state->printers.push_back(DiscoveredPrinter{name, false});
+        state->Emit(DiscoveryEventType::kAdded, {state->printers.back()});
+      }
+    });
+
+    std::vector<DiscoveredPrinter> snapshot;
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      for (auto it = state->printers.begin(); it != state->printers.end();) {
+        if (!it->isLocal && std::find(seen.begin(), seen.end(), it->name) == seen.end()) {
+          DiscoveredPrinter removed = std::move(*it);
+          it = state->printers.erase(it);
+          state->Emit(DiscoveryEventType::kRemoved, {std::move(removed)});
+        } else {
+          ++it;
+        }
+      }
+      state->fromCache = false;
+      snapshot = state->printers;
+    }
+
+    if (!state->snapshotPath.empty()) {
+      SaveSnapshot(state->snapshotPath, snapshot);
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->Emit(DiscoveryEventType::kComplete, {});
+    rescan = state->rescanRequested;
+    state->rescanRequested = false;
+    if (!rescan) {
+      state->scanning = false;
+      state->idle.notify_all();
+    }
+  }
+}
+
+std::vector<DiscoveredPrinter> PrinterDiscovery::LoadSnapshot(const std::string& path) {
+  std::vector<DiscoveredPrinter> printers;
+  std::ifstream file(std::filesystem::u8path(path));
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.size() < 3 || line[1] != '\t') continue;
+    if (line[0] != kLocalTag && line[0] != kConnectionTag) continue;
+    std::string name = line.substr(2);
+    if (FindPrinter(printers, name) == printers.end()) {
+      printers.push_back(DiscoveredPrinter{std::move(name), line[0] == kLocalTag});
+    }
+  }
+  return printers;
+}
+
+bool PrinterDiscovery::SaveSnapshot(const std::string& path,
+                                    const std::vector<DiscoveredPrinter>& printers) {
+  // Write a temporary file first so a crash never leaves a truncated cache
+  std::filesystem::path target = std::filesystem::u8path(path);
+  std::filesystem::path temporary = target;
+  temporary += ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    for (const DiscoveredPrinter& printer : printers) {
+      file << (printer.isLocal ? kLocalTag : kConnectionTag) << '\t' << printer.name << '\n';
+    }
+    if (!file) return false;
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary, target, error);
+  return !error;
+}
+
+}  // namespace windows_printer
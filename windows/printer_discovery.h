@@ -0,0 +1,103 @@
+#ifndef FLUTTER_PLUGIN_PRINTER_DISCOVERY_H_
+#define FLUTTER_PLUGIN_PRINTER_DISCOVERY_H_
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace windows_printer {
+
+struct DiscoveredPrinter {
+  std::string name;
+  /// Installed on this machine rather than a connection to a print server
+  bool isLocal = true;
+};
+
+// Lists printers known to the spooler. EnumerateConnections may block for a
+// long time on unreachable print servers, so it is only called off the
+// platform thread.
+class PrinterEnumerator {
+public:
+  virtual ~PrinterEnumerator() = default;
+
+  /// Printers installed on this machine
+  virtual std::vector<std::string> EnumerateLocal() = 0;
+
+  /// Printer connections; onPrinter is called for each one as it resolves
+  virtual void EnumerateConnections(const std::function<void(const std::string& name)>& onPrinter) = 0;
+};
+
+enum class DiscoveryEventType {
+  /// Every printer known so far; always the first event a listener receives
+  kSnapshot = 0,
+  kAdded,
+  kRemoved,
+  /// A full enumeration finished and the snapshot cache was updated
+  kComplete,
+};
+
+struct DiscoveryEvent {
+  DiscoveryEventType type = DiscoveryEventType::kSnapshot;
+  /// All known printers for kSnapshot, the changed printer for kAdded/kRemoved
+  std::vector<DiscoveredPrinter> printers;
+  /// Set on a snapshot served from the cache before any enumeration finished
+  bool fromCache = false;
+};
+
+/// Receives discovery events. Called with the discovery lock held, from the
+/// thread that called Start/Refresh or from the background worker, so it
+/// must be quick and must not call back into PrinterDiscovery.
+using DiscoveryListener = std::function<void(const DiscoveryEvent& event)>;
+
+// Incremental printer discovery. Local printers are enumerated synchronously
+// because the local spooler answers quickly; connections are enumerated on a
+// background thread and streamed as they resolve. The result of the last
+// complete enumeration is cached on disk and served first on the next start,
+// after which listeners only see changes.
+class PrinterDiscovery {
+public:
+  /// snapshotPath may be empty to disable the on-disk cache
+  PrinterDiscovery(std::shared_ptr<PrinterEnumerator> enumerator, std::string snapshotPath);
+
+  /// Does not wait for a running enumeration; the background worker keeps
+  /// its own reference to the shared state and exits on its own.
+  ~PrinterDiscovery();
+
+  PrinterDiscovery(const PrinterDiscovery&) = delete;
+  PrinterDiscovery& operator=(const PrinterDiscovery&) = delete;
+
+  /// Send the current snapshot to listener, then refresh. Replaces any
+  /// previous listener.
+  void Start(DiscoveryListener listener);
+
+  /// Detach the listener; a running enumeration still updates the snapshot
+  void Stop();
+
+  /// Enumerate again and report only the differences. A refresh requested
+  /// while connections are still being enumerated runs once they finish.
+  void Refresh();
+
+  /// Printers known right now
+  std::vector<DiscoveredPrinter> Snapshot() const;
+
+  /// Wait until no enumeration is running (for tests and shutdown)
+  bool WaitForIdle(std::chrono::milliseconds timeout) const;
+
+  /// Read and write the on-disk snapshot format
+  static std::vector<DiscoveredPrinter> LoadSnapshot(const std::string& path);
+  static bool SaveSnapshot(const std::string& path, const std::vector<DiscoveredPrinter>& printers);
+
+private:
+  struct State;
+
+  static void RefreshLocal(State& state);
+  static void EnumerateConnections(std::shared_ptr<State> state);
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_PRINTER_DISCOVERY_H_
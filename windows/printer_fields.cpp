@@ -0,0 +1,115 @@
+#include "printer_fields.h"
+
+#include <cstddef>
+
+namespace windows_printer {
+
+namespace {
+
+struct FieldName {
+  const char* name;
+  uint32_t field;
+};
+
+constexpr FieldName kFieldNames[] = {
+    {"isDefault", kPrinterFieldIsDefault},
+    {"status", kPrinterFieldStatus},
+    {"info", kPrinterFieldInfo},
+    {"attributes", kPrinterFieldAttributes},
+    {"queue", kPrinterFieldQueue},
+    {"paperSizes", kPrinterFieldPaperSizes},
+    {"resolutions", kPrinterFieldResolutions},
+};
+
+// PRINTER_STATUS_PAUSED (0x1) through PRINTER_STATUS_POWER_SAVE (0x1000000)
+constexpr const char* kStatusNames[] = {
+    "Paused",
+    "Error",
+    "Pending Deletion",
+    "Paper Jam",
+    "Paper Out",
+    "Manual Feed",
+    "Paper Problem",
+    "Offline",
+    "I/O Active",
+    "Busy",
+    "Printing",
+    "Output Bin Full",
+    "Not Available",
+    "Waiting",
+    "Processing",
+    "Initializing",
+    "Warming Up",
+    "Toner Low",
+    "No Toner",
+    "Page Punt",
+    "User Intervention Required",
+    "Out of Memory",
+    "Door Open",
+    "Server Unknown",
+    "Power Save",
+};
+
+// PRINTER_ATTRIBUTE_QUEUED (0x1) through PRINTER_ATTRIBUTE_PUBLISHED (0x2000)
+constexpr const char* kAttributeNames[] = {
+    "Queued",
+    "Direct",
+    "Default",
+    "Shared",
+    "Network",
+    "Hidden",
+    "Local",
+    "Enable DevQ",
+    "Keep Printed Jobs",
+    "Do Complete First",
+    "Work Offline",
+    "Enable BiDi",
+    "Raw Only",
+    "Published",
+};
+
+// Names of the known bits set in flags, lowest bit first
+template <size_t N>
+std::vector<const char*> FlagNames(uint32_t flags, const char* const (&names)[N]) {
+  std::vector<const char*> result;
+  for (size_t bit = 0; bit < N; bit++) {
+    if ((flags & (1u << bit)) != 0) {
+      result.push_back(names[bit]);
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+bool ParsePrinterFields(const std::vector<std::string>& names, uint32_t* fields,
+                        std::string* unknown) {
+  uint32_t mask = 0;
+  for (const std::string& name : names) {
+    uint32_t field = 0;
+    for (const FieldName& entry : kFieldNames) {
+      if (name == entry.name) {
+        field = entry.field;
+        break;
+      }
+    }
+    if (field == 0) {
+      *unknown = name;
+      return false;
+    }
+    mask |= field;
+  }
+  *fields = mask;
+  return true;
+}
+
+std::vector<const char*> PrinterStatusMessages(uint32_t status) {
+  if (status == 0) return {"Ready"};
+  return FlagNames(status, kStatusNames);
+}
+
+std::vector<const char*> PrinterAttributeNames(uint32_t attributes) {
+  return FlagNames(attributes, kAttributeNames);
+}
+
+}  // namespace windows_printer
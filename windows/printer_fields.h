@@ -0,0 +1,52 @@
+#ifndef FLUTTER_PLUGIN_PRINTER_FIELDS_H_
+#define FLUTTER_PLUGIN_PRINTER_FIELDS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace windows_printer {
+
+/// Sections of getPrinterProperties, selected by name. Only the selected
+/// sections are queried and encoded.
+enum PrinterField : uint32_t {
+  /// "isDefault"; needs no printer handle
+  kPrinterFieldIsDefault = 1u << 0,
+  /// "status": status and statusMessages, from the cheap PRINTER_INFO_6
+  kPrinterFieldStatus = 1u << 1,
+  /// "info": name, server, share, port, driver, comment, location, separator
+  /// file, print processor and datatype
+  kPrinterFieldInfo = 1u << 2,
+  /// "attributes": attributes and attributesList
+  kPrinterFieldAttributes = 1u << 3,
+  /// "queue": jobs, averagePPM, priority, defaultPriority, startTime and
+  /// untilTime
+  kPrinterFieldQueue = 1u << 4,
+  /// "paperSizes", from DeviceCapabilities
+  kPrinterFieldPaperSizes = 1u << 5,
+  /// "resolutions", from DeviceCapabilities
+  kPrinterFieldResolutions = 1u << 6,
+};
+
+constexpr uint32_t kPrinterFieldsAll = (1u << 7) - 1;
+
+/// Sections that need PRINTER_INFO_2 rather than PRINTER_INFO_6
+constexpr uint32_t kPrinterFieldsInfo2 = kPrinterFieldInfo | kPrinterFieldAttributes |
+                                         kPrinterFieldQueue | kPrinterFieldPaperSizes |
+                                         kPrinterFieldResolutions;
+
+/// Turn section names into a mask. Returns false, with the offending name
+/// in *unknown, if a name is not a section.
+bool ParsePrinterFields(const std::vector<std::string>& names, uint32_t* fields,
+                        std::string* unknown);
+
+/// Readable names of the PRINTER_STATUS_* bits set in status, or "Ready"
+/// when none are. Bit i of status is the i-th PRINTER_STATUS_* flag.
+std::vector<const char*> PrinterStatusMessages(uint32_t status);
+
+/// Readable names of the PRINTER_ATTRIBUTE_* bits set in attributes
+std::vector<const char*> PrinterAttributeNames(uint32_t attributes);
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_PRINTER_FIELDS_H_
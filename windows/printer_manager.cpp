@@ -2,47 +2,185 @@
 
 #include <windows.h>
 #include <winspool.h>
+#include <cstdio>
 #include <string>
 #include <vector>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <fstream>
-#include <sstream>
 #include <string>
 
+#include "esc_pos_encoder.h"
+#include "image_scaler.h"
+#include "print_job.h"
+#include "print_metrics.h"
+#include "printer_fields.h"
+#include "reprint_cache.h"
+#include "rich_text.h"
+#include "string_convert.h"
+#include "task_pool.h"
+#include "win32_spooler_backend.h"
+
+using windows_printer::EscPosEncoder;
+using windows_printer::ImageBand;
+using windows_printer::ImageRect;
+using windows_printer::ImageScaler;
+using windows_printer::kPrinterFieldAttributes;
+using windows_printer::kPrinterFieldInfo;
+using windows_printer::kPrinterFieldIsDefault;
+using windows_printer::kPrinterFieldPaperSizes;
+using windows_printer::kPrinterFieldQueue;
+using windows_printer::kPrinterFieldResolutions;
+using windows_printer::kPrinterFieldStatus;
+using windows_printer::kPrinterFieldsInfo2;
+using windows_printer::MetricStage;
+using windows_printer::PositionedRichTextRun;
+using windows_printer::PreparedDocument;
+using windows_printer::PrinterAttributeNames;
+using windows_printer::PrinterStatusMessages;
+using windows_printer::PrintMetrics;
+using windows_printer::PrintReservation;
+using windows_printer::RawPrintOptions;
+using windows_printer::RawPrintResult;
+using windows_printer::ReprintCache;
+using windows_printer::RichTextFont;
+using windows_printer::RichTextMode;
+using windows_printer::ScopedQueueEntry;
+using windows_printer::ScopedStageTimer;
+using windows_printer::ScopedTraceSpan;
+using windows_printer::Win32SpoolerBackend;
+
+namespace {
+
+// Scaled rows handed to the driver at once, about 200 rows of an A4 page at
+// 600 dpi
+constexpr size_t kImageBandBytes = 4 << 20;
+
+// printer_fields.cpp names the bits up to these without winspool.h
+static_assert(PRINTER_STATUS_POWER_SAVE == (1u << 24), "printer status bits changed");
+static_assert(PRINTER_ATTRIBUTE_PUBLISHED == (1u << 13), "printer attribute bits changed");
+
+// Records a failed spooler or GDI call together with its Win32 error code
+void RecordSpoolerFailure(MetricStage stage) {
+  PrintMetrics::Instance().RecordFailure(stage, static_cast<uint32_t>(GetLastError()));
+}
+
+// Adds the raw status bits and their names, "Ready" when none are set
+void AddStatusProperties(DWORD status, flutter::EncodableMap* properties) {
+  (*properties)[flutter::EncodableValue("status")] = flutter::EncodableValue(static_cast<int>(status));
+  flutter::EncodableList statusMessages;
+  for (const char* message : PrinterStatusMessages(status)) {
+    statusMessages.push_back(flutter::EncodableValue(message));
+  }
+  (*properties)[flutter::EncodableValue("statusMessages")] = flutter::EncodableValue(statusMessages);
+}
+
+// Checks the queue's driver and default paper width for a receipt printer
+bool QueueIsReceiptPrinter(const std::wstring& widePrinterName) {
+  HANDLE hPrinter = NULL;
+  ScopedStageTimer openTimer(MetricStage::kOpenPrinter);
+  if (!OpenPrinter(const_cast<LPWSTR>(widePrinterName.c_str()), &hPrinter, NULL)) {
+    RecordSpoolerFailure(MetricStage::kOpenPrinter);
+    return false;
+  }
+  openTimer.Stop();
+
+  bool isReceipt = false;
+  ScopedStageTimer queryTimer(MetricStage::kQueryPrinter);
+  DWORD needed = 0;
+  GetPrinter(hPrinter, 2, NULL, 0, &needed);
+  if (needed > 0) {
+    std::vector<BYTE> buffer(needed);
+    if (GetPrinter(hPrinter, 2, buffer.data(), needed, &needed)) {
+      const PRINTER_INFO_2* info = reinterpret_cast<const PRINTER_INFO_2*>(buffer.data());
+      std::string driverName;
+      if (info->pDriverName) {
+        driverName = windows_printer::Utf16ToUtf8<wchar_t>(info->pDriverName);
+      }
+      int paperWidth = 0;
+      if (info->pDevMode && (info->pDevMode->dmFields & DM_PAPERWIDTH)) {
+        paperWidth = info->pDevMode->dmPaperWidth;
+      }
+      isReceipt = windows_printer::IsReceiptPrinter(driverName, paperWidth);
+    } else {
+      RecordSpoolerFailure(MetricStage::kQueryPrinter);
+    }
+  }
+  queryTimer.Stop();
+
+  ClosePrinter(hPrinter);
+  return isReceipt;
+}
+
+// A file handed to an external print handler, deleted with its owner
+class TemporaryFile {
+public:
+  explicit TemporaryFile(std::string path) : path_(std::move(path)) {}
+  ~TemporaryFile() { std::remove(path_.c_str()); }
+
+  TemporaryFile(const TemporaryFile&) = delete;
+  TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+  const std::string& Path() const { return path_; }
+
+private:
+  std::string path_;
+};
+
+// Keeps a PDF's temporary file until the process printing it exits. The
+// wait runs on the system thread pool rather than holding a thread.
+void ReleaseWhenProcessExits(HANDLE process, std::unique_ptr<TemporaryFile> file) {
+  struct PendingPrint {
+    std::mutex mutex;
+    HANDLE wait = NULL;
+    HANDLE process = NULL;
+    std::unique_ptr<TemporaryFile> file;
+  };
+  auto* pending = new PendingPrint();
+  pending->process = process;
+  pending->file = std::move(file);
+
+  // The callback may run before the wait handle is stored; the lock makes
+  // it wait for that
+  std::unique_lock<std::mutex> lock(pending->mutex);
+  const BOOL registered = RegisterWaitForSingleObject(
+      &pending->wait, process,
+      [](PVOID context, BOOLEAN) {
+        auto* pending = static_cast<PendingPrint*>(context);
+        { std::lock_guard<std::mutex> lock(pending->mutex); }
+        UnregisterWait(pending->wait);
+        CloseHandle(pending->process);
+        delete pending;
+      },
+      pending, INFINITE, WT_EXECUTEONLYONCE);
+  lock.unlock();
+  if (!registered) {
+    // Without a wait the print gets 5 seconds before the file goes
+    WaitForSingleObject(process, 5000);
+    CloseHandle(process);
+    delete pending;
+  }
+}
+
+}  // namespace
+
 // Helper function to convert wide string to UTF-8
 std::string PrinterManager::WideToUtf8(const wchar_t* wide_str) {
   if (wide_str == nullptr) return "";
-  
-  int size_needed = WideCharToMultiByte(CP_UTF8, 0, wide_str, -1, nullptr, 0, nullptr, nullptr);
-  std::string utf8_str(size_needed, 0);
-  WideCharToMultiByte(CP_UTF8, 0, wide_str, -1, &utf8_str[0], size_needed, nullptr, nullptr);
-  
-  // Remove null terminator
-  if (!utf8_str.empty() && utf8_str.back() == 0) {
-    utf8_str.pop_back();
-  }
-  return utf8_str;
+  return windows_printer::Utf16ToUtf8<wchar_t>(wide_str);
 }
 
 // Helper function to convert UTF-8 to wide string
 std::wstring PrinterManager::Utf8ToWide(const std::string& utf8_str) {
-  if (utf8_str.empty()) return L"";
-  
-  int size_needed = MultiByteToWideChar(CP_UTF8, 0, utf8_str.c_str(), -1, nullptr, 0);
-  std::wstring wide_str(size_needed, 0);
-  MultiByteToWideChar(CP_UTF8, 0, utf8_str.c_str(), -1, &wide_str[0], size_needed);
-  
-  // Remove null terminator
-  if (!wide_str.empty() && wide_str.back() == 0) {
-    wide_str.pop_back();
-  }
-  return wide_str;
+  return windows_printer::Utf8ToUtf16<wchar_t>(utf8_str);
 }
 
 // GetAvailablePrinters Implementation
 flutter::EncodableList PrinterManager::GetAvailablePrinters() {
   flutter::EncodableList printerList;
   
+  ScopedStageTimer queryTimer(MetricStage::kQueryPrinter);
   DWORD needed = 0, returned = 0;
   EnumPrinters(PRINTER_ENUM_LOCAL | PRINTER_ENUM_CONNECTIONS, NULL, 4, NULL, 0, &needed, &returned);
   
@@ -62,31 +200,59 @@ flutter::EncodableList PrinterManager::GetAvailablePrinters() {
 }
 
 // GetPrinterProperties implementation
-flutter::EncodableMap PrinterManager::GetPrinterProperties(const std::string& printerName) {
+flutter::EncodableMap PrinterManager::GetPrinterProperties(const std::string& printerName,
+                                                           uint32_t fields) {
   flutter::EncodableMap properties;
   HANDLE hPrinter = NULL;
   PRINTER_INFO_2* pPrinterInfo = NULL;
   DWORD needed = 0;
   
-  std::wstring widePrinterName = Utf8ToWide(printerName);
+  std::shared_ptr<const std::wstring> sharedPrinterName =
+      Win32SpoolerBackend::WidePrinterName(printerName);
+  const std::wstring& widePrinterName = *sharedPrinterName;
   
   // Check if this is the default printer
-  WCHAR defaultPrinterName[256] = {0};
-  DWORD defaultPrinterSize = sizeof(defaultPrinterName) / sizeof(WCHAR);
-  BOOL isDefault = FALSE;
-  
-  if (GetDefaultPrinter(defaultPrinterName, &defaultPrinterSize)) {
-    isDefault = (wcscmp(widePrinterName.c_str(), defaultPrinterName) == 0);
+  if (fields & kPrinterFieldIsDefault) {
+    WCHAR defaultPrinterName[256] = {0};
+    DWORD defaultPrinterSize = sizeof(defaultPrinterName) / sizeof(WCHAR);
+    BOOL isDefault = FALSE;
+    
+    if (GetDefaultPrinter(defaultPrinterName, &defaultPrinterSize)) {
+      isDefault = (wcscmp(widePrinterName.c_str(), defaultPrinterName) == 0);
+    }
+    
+    properties[flutter::EncodableValue("isDefault")] = flutter::EncodableValue(isDefault ? true : false);
   }
   
-  properties[flutter::EncodableValue("isDefault")] = flutter::EncodableValue(isDefault ? true : false);
+  // Everything else needs the printer open
+  if ((fields & ~kPrinterFieldIsDefault) == 0) {
+    return properties;
+  }
   
   // Open printer
+  ScopedStageTimer openTimer(MetricStage::kOpenPrinter);
   if (!OpenPrinter(const_cast<LPWSTR>(widePrinterName.c_str()), &hPrinter, NULL)) {
+    RecordSpoolerFailure(MetricStage::kOpenPrinter);
     // Error info if we can't open the printer
     properties[flutter::EncodableValue("error")] = flutter::EncodableValue("Failed to open printer");
     return properties;
   }
+  openTimer.Stop();
+  
+  ScopedStageTimer queryTimer(MetricStage::kQueryPrinter);
+  
+  // Status alone comes from PRINTER_INFO_6, a single DWORD the spooler
+  // answers without building the full PRINTER_INFO_2
+  if ((fields & kPrinterFieldsInfo2) == 0) {
+    PRINTER_INFO_6 statusInfo = {0};
+    if (GetPrinter(hPrinter, 6, reinterpret_cast<LPBYTE>(&statusInfo), sizeof(statusInfo), &needed)) {
+      AddStatusProperties(statusInfo.dwStatus, &properties);
+      ClosePrinter(hPrinter);
+      return properties;
+    }
+    // Older print servers only answer level 2
+    needed = 0;
+  }
   
   // Get the buffer size needed
   GetPrinter(hPrinter, 2, NULL, 0, &needed);
@@ -98,145 +264,72 @@ flutter::EncodableMap PrinterManager::GetPrinterProperties(const std::string& pr
       // Get the printer information
       if (GetPrinter(hPrinter, 2, buffer.data(), needed, &needed)) {
         // Basic properties
-        if (pPrinterInfo->pPrinterName)
-          properties[flutter::EncodableValue("name")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pPrinterName));
-        
-        if (pPrinterInfo->pServerName)
-          properties[flutter::EncodableValue("serverName")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pServerName));
-        
-        if (pPrinterInfo->pShareName)
-          properties[flutter::EncodableValue("shareName")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pShareName));
-        
-        if (pPrinterInfo->pPortName)
-          properties[flutter::EncodableValue("portName")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pPortName));
-        
-        if (pPrinterInfo->pDriverName)
-          properties[flutter::EncodableValue("driverName")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pDriverName));
-        
-        if (pPrinterInfo->pComment)
-          properties[flutter::EncodableValue("comment")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pComment));
-        
-        if (pPrinterInfo->pLocation)
-          properties[flutter::EncodableValue("location")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pLocation));
-        
-        if (pPrinterInfo->pSepFile)
-          properties[flutter::EncodableValue("separatorFile")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pSepFile));
-        
-        if (pPrinterInfo->pPrintProcessor)
-          properties[flutter::EncodableValue("printProcessor")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pPrintProcessor));
-        
-        if (pPrinterInfo->pDatatype)
-          properties[flutter::EncodableValue("datatype")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pDatatype));
+        if (fields & kPrinterFieldInfo) {
+          if (pPrinterInfo->pPrinterName)
+            properties[flutter::EncodableValue("name")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pPrinterName));
+          
+          if (pPrinterInfo->pServerName)
+            properties[flutter::EncodableValue("serverName")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pServerName));
+          
+          if (pPrinterInfo->pShareName)
+            properties[flutter::EncodableValue("shareName")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pShareName));
+          
+          if (pPrinterInfo->pPortName)
+            properties[flutter::EncodableValue("portName")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pPortName));
+          
+          if (pPrinterInfo->pDriverName)
+            properties[flutter::EncodableValue("driverName")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pDriverName));
+          
+          if (pPrinterInfo->pComment)
+            properties[flutter::EncodableValue("comment")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pComment));
+          
+          if (pPrinterInfo->pLocation)
+            properties[flutter::EncodableValue("location")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pLocation));
+          
+          if (pPrinterInfo->pSepFile)
+            properties[flutter::EncodableValue("separatorFile")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pSepFile));
+          
+          if (pPrinterInfo->pPrintProcessor)
+            properties[flutter::EncodableValue("printProcessor")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pPrintProcessor));
+          
+          if (pPrinterInfo->pDatatype)
+            properties[flutter::EncodableValue("datatype")] = flutter::EncodableValue(WideToUtf8(pPrinterInfo->pDatatype));
+        }
         
         // Status properties
-        properties[flutter::EncodableValue("status")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->Status));
-        
-        // Decode the status to human-readable formats
-        flutter::EncodableList statusMessages;
-        if (pPrinterInfo->Status == 0) {
-          statusMessages.push_back(flutter::EncodableValue("Ready"));
-        } else {
-          if (pPrinterInfo->Status & PRINTER_STATUS_PAUSED)
-            statusMessages.push_back(flutter::EncodableValue("Paused"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_ERROR)
-            statusMessages.push_back(flutter::EncodableValue("Error"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_PENDING_DELETION)
-            statusMessages.push_back(flutter::EncodableValue("Pending Deletion"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_PAPER_JAM)
-            statusMessages.push_back(flutter::EncodableValue("Paper Jam"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_PAPER_OUT)
-            statusMessages.push_back(flutter::EncodableValue("Paper Out"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_MANUAL_FEED)
-            statusMessages.push_back(flutter::EncodableValue("Manual Feed"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_PAPER_PROBLEM)
-            statusMessages.push_back(flutter::EncodableValue("Paper Problem"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_OFFLINE)
-            statusMessages.push_back(flutter::EncodableValue("Offline"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_IO_ACTIVE)
-            statusMessages.push_back(flutter::EncodableValue("I/O Active"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_BUSY)
-            statusMessages.push_back(flutter::EncodableValue("Busy"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_PRINTING)
-            statusMessages.push_back(flutter::EncodableValue("Printing"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_OUTPUT_BIN_FULL)
-            statusMessages.push_back(flutter::EncodableValue("Output Bin Full"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_NOT_AVAILABLE)
-            statusMessages.push_back(flutter::EncodableValue("Not Available"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_WAITING)
-            statusMessages.push_back(flutter::EncodableValue("Waiting"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_PROCESSING)
-            statusMessages.push_back(flutter::EncodableValue("Processing"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_INITIALIZING)
-            statusMessages.push_back(flutter::EncodableValue("Initializing"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_WARMING_UP)
-            statusMessages.push_back(flutter::EncodableValue("Warming Up"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_TONER_LOW)
-            statusMessages.push_back(flutter::EncodableValue("Toner Low"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_NO_TONER)
-            statusMessages.push_back(flutter::EncodableValue("No Toner"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_PAGE_PUNT)
-            statusMessages.push_back(flutter::EncodableValue("Page Punt"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_USER_INTERVENTION)
-            statusMessages.push_back(flutter::EncodableValue("User Intervention Required"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_OUT_OF_MEMORY)
-            statusMessages.push_back(flutter::EncodableValue("Out of Memory"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_DOOR_OPEN)
-            statusMessages.push_back(flutter::EncodableValue("Door Open"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_SERVER_UNKNOWN)
-            statusMessages.push_back(flutter::EncodableValue("Server Unknown"));
-          if (pPrinterInfo->Status & PRINTER_STATUS_POWER_SAVE)
-            statusMessages.push_back(flutter::EncodableValue("Power Save"));
+        if (fields & kPrinterFieldStatus) {
+          AddStatusProperties(pPrinterInfo->Status, &properties);
         }
-        properties[flutter::EncodableValue("statusMessages")] = flutter::EncodableValue(statusMessages);
         
-        // Numerical properties
-        properties[flutter::EncodableValue("attributes")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->Attributes));
-        properties[flutter::EncodableValue("priority")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->Priority));
-        properties[flutter::EncodableValue("defaultPriority")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->DefaultPriority));
-        properties[flutter::EncodableValue("startTime")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->StartTime));
-        properties[flutter::EncodableValue("untilTime")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->UntilTime));
-        properties[flutter::EncodableValue("jobs")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->cJobs));
-        properties[flutter::EncodableValue("averagePPM")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->AveragePPM));
+        // Queue properties
+        if (fields & kPrinterFieldQueue) {
+          properties[flutter::EncodableValue("priority")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->Priority));
+          properties[flutter::EncodableValue("defaultPriority")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->DefaultPriority));
+          properties[flutter::EncodableValue("startTime")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->StartTime));
+          properties[flutter::EncodableValue("untilTime")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->UntilTime));
+          properties[flutter::EncodableValue("jobs")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->cJobs));
+          properties[flutter::EncodableValue("averagePPM")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->AveragePPM));
+        }
         
         // Decode printer attributes to readable format
-        flutter::EncodableList attributesList;
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_QUEUED)
-          attributesList.push_back(flutter::EncodableValue("Queued"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_DIRECT)
-          attributesList.push_back(flutter::EncodableValue("Direct"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_DEFAULT)
-          attributesList.push_back(flutter::EncodableValue("Default"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_SHARED)
-          attributesList.push_back(flutter::EncodableValue("Shared"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_NETWORK)
-          attributesList.push_back(flutter::EncodableValue("Network"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_HIDDEN)
-          attributesList.push_back(flutter::EncodableValue("Hidden"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_LOCAL)
-          attributesList.push_back(flutter::EncodableValue("Local"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_ENABLE_DEVQ)
-          attributesList.push_back(flutter::EncodableValue("Enable DevQ"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_KEEPPRINTEDJOBS)
-          attributesList.push_back(flutter::EncodableValue("Keep Printed Jobs"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_DO_COMPLETE_FIRST)
-          attributesList.push_back(flutter::EncodableValue("Do Complete First"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_WORK_OFFLINE)
-          attributesList.push_back(flutter::EncodableValue("Work Offline"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_ENABLE_BIDI)
-          attributesList.push_back(flutter::EncodableValue("Enable BiDi"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_RAW_ONLY)
-          attributesList.push_back(flutter::EncodableValue("Raw Only"));
-        if (pPrinterInfo->Attributes & PRINTER_ATTRIBUTE_PUBLISHED)
-          attributesList.push_back(flutter::EncodableValue("Published"));
-        properties[flutter::EncodableValue("attributesList")] = flutter::EncodableValue(attributesList);
+        if (fields & kPrinterFieldAttributes) {
+          properties[flutter::EncodableValue("attributes")] = flutter::EncodableValue(static_cast<int>(pPrinterInfo->Attributes));
+          flutter::EncodableList attributesList;
+          for (const char* name : PrinterAttributeNames(pPrinterInfo->Attributes)) {
+            attributesList.push_back(flutter::EncodableValue(name));
+          }
+          properties[flutter::EncodableValue("attributesList")] = flutter::EncodableValue(attributesList);
+        }
         
-        // Get additional information about printer capabilities
+        // Get additional information about printer capabilities. Each query
+        // goes through the driver, so these are the slowest fields by far.
         DWORD caps_size = 0;
-        DeviceCapabilities(pPrinterInfo->pPrinterName, pPrinterInfo->pPortName, DC_PAPERNAMES, NULL, NULL);
-        caps_size = DeviceCapabilities(pPrinterInfo->pPrinterName, pPrinterInfo->pPortName, DC_PAPERSIZE, NULL, NULL);
         
         // Get paper sizes supported by printer
-        if (caps_size > 0) {
+        if (fields & kPrinterFieldPaperSizes) {
+          caps_size = DeviceCapabilities(pPrinterInfo->pPrinterName, pPrinterInfo->pPortName, DC_PAPERSIZE, NULL, NULL);
+        }
+        if (caps_size > 0 && caps_size != static_cast<DWORD>(-1)) {
           flutter::EncodableList paperSizes;
           std::vector<WCHAR> paperNames(64 * caps_size); // Each paper name can be up to 64 characters
           
@@ -255,8 +348,11 @@ flutter::EncodableMap PrinterManager::GetPrinterProperties(const std::string& pr
         }
         
         // Get supported resolutions
-        caps_size = DeviceCapabilities(pPrinterInfo->pPrinterName, pPrinterInfo->pPortName, DC_ENUMRESOLUTIONS, NULL, NULL);
-        if (caps_size > 0) {
+        caps_size = 0;
+        if (fields & kPrinterFieldResolutions) {
+          caps_size = DeviceCapabilities(pPrinterInfo->pPrinterName, pPrinterInfo->pPortName, DC_ENUMRESOLUTIONS, NULL, NULL);
+        }
+        if (caps_size > 0 && caps_size != static_cast<DWORD>(-1)) {
           flutter::EncodableList resolutions;
           std::vector<LONG> resolutionData(caps_size * 2); // Each resolution has X and Y values
           
@@ -316,16 +412,22 @@ bool PrinterManager::OpenPrinterProperties(const std::string& printerName) {
 // GetPaperSizeDetails implementation
 flutter::EncodableMap PrinterManager::GetPaperSizeDetails(const std::string& printerName) {
   flutter::EncodableMap paperDetails;
-  std::wstring widePrinterName = Utf8ToWide(printerName);
+  std::shared_ptr<const std::wstring> sharedPrinterName =
+      Win32SpoolerBackend::WidePrinterName(printerName);
+  const std::wstring& widePrinterName = *sharedPrinterName;
   
   // Open printer
   HANDLE hPrinter = NULL;
+  ScopedStageTimer openTimer(MetricStage::kOpenPrinter);
   if (!OpenPrinter(const_cast<LPWSTR>(widePrinterName.c_str()), &hPrinter, NULL)) {
+    RecordSpoolerFailure(MetricStage::kOpenPrinter);
     paperDetails[flutter::EncodableValue("error")] = flutter::EncodableValue("Failed to open printer");
     return paperDetails;
   }
+  openTimer.Stop();
   
   // Get device mode to get current paper size
+  ScopedStageTimer queryTimer(MetricStage::kQueryPrinter);
   LONG devModeSize = DocumentProperties(
     NULL, 
     hPrinter, 
@@ -464,63 +566,32 @@ flutter::EncodableMap PrinterManager::GetPaperSizeDetails(const std::string& pri
 }
 
 // PrintRawData implementation
-bool PrinterManager::PrintRawData(const std::string& printerName, 
-                                 const std::vector<uint8_t>& data, 
-                                 bool useRawDatatype) {
+RawPrintResult PrinterManager::PrintRawData(const std::string& printerName, 
+                                 std::shared_ptr<const std::vector<uint8_t>> data, 
+                                 bool useRawDatatype,
+                                 std::chrono::milliseconds timeout,
+                                 int copies,
+                                 std::vector<std::vector<uint8_t>> copyVariants,
+                                 std::shared_ptr<PrintReservation> reservation) {
+  // An empty printer name selects the default printer
+  RawPrintOptions options;
+  options.useRawDatatype = useRawDatatype;
+  options.timeout = timeout;
+  options.copies = copies;
+  options.copyVariants = std::move(copyVariants);
+  options.reservation = std::move(reservation);
+  return windows_printer::SubmitRawJob(Win32SpoolerBackend::SharedInstance(), printerName,
+                                       std::move(data), std::move(options));
+}
+
+// CancelJob implementation
+bool PrinterManager::CancelJob(const std::string& printerName, uint32_t jobId) {
+  Win32SpoolerBackend& backend = Win32SpoolerBackend::Instance();
   std::string actualPrinterName = printerName;
-  
-  // If no printer name provided, use the default printer
-  if (actualPrinterName.empty()) {
-    WCHAR defaultPrinterName[256] = {0};
-    DWORD defaultPrinterSize = sizeof(defaultPrinterName) / sizeof(WCHAR);
-    if (GetDefaultPrinter(defaultPrinterName, &defaultPrinterSize)) {
-      actualPrinterName = WideToUtf8(defaultPrinterName);
-    } else {
-      return false; // No default printer found
-    }
-  }
-  
-  std::wstring widePrinterName = Utf8ToWide(actualPrinterName);
-  
-  // Open printer
-  HANDLE hPrinter = NULL;
-  if (!OpenPrinter(const_cast<LPWSTR>(widePrinterName.c_str()), &hPrinter, NULL)) {
-    return false;
-  }
-  
-  // Get printer information to determine if it's a raw-capable printer
-  DWORD needed = 0;
-  GetPrinter(hPrinter, 2, NULL, 0, &needed);
-  
-  // Start a print job with user-controlled data typ
-  DOC_INFO_1 docInfo = {0};
-  docInfo.pDocName = L"Raw Print Job";
-  docInfo.pOutputFile = NULL;
-  docInfo.pDatatype = useRawDatatype ? L"RAW" : L"TEXT";
-  
-  DWORD jobId = StartDocPrinter(hPrinter, 1, (LPBYTE)&docInfo);
-  if (jobId == 0) {
-    ClosePrinter(hPrinter);
+  if (actualPrinterName.empty() && !backend.DefaultPrinterName(&actualPrinterName)) {
     return false;
   }
-  
-  // Start a page
-  if (!StartPagePrinter(hPrinter)) {
-    EndDocPrinter(hPrinter);
-    ClosePrinter(hPrinter);
-    return false;
-  }
-  
-  // Write the data to the printer
-  DWORD bytesWritten = 0;
-  bool success = WritePrinter(hPrinter, const_cast<BYTE*>(data.data()), static_cast<DWORD>(data.size()), &bytesWritten);
-  
-  // End the page and document
-  EndPagePrinter(hPrinter);
-  EndDocPrinter(hPrinter);
-  ClosePrinter(hPrinter);
-  
-  return (success && bytesWritten == data.size());
+  return backend.CancelJob(actualPrinterName, jobId);
 }
 
 // PrintPdf implementation
@@ -538,8 +609,13 @@ bool PrinterManager::PrintPdf(const std::string& printerName, const std::vector<
     }
   }
   
-  // For PDF printing, we need to save it to a temporary file
-  // and use ShellExecute to print it silently
+  ScopedQueueEntry queueEntry;
+  ScopedTraceSpan pdfSpan("spoolPdf");
+  pdfSpan.SetArg("bytes", static_cast<int64_t>(data.size()));
+  
+  // PDFs are printed by an external handler, so there is no spool-ready
+  // output to keep in the reprint cache. The temporary file is deleted once
+  // the handler has exited.
   char tempPath[MAX_PATH];
   char tempFileName[MAX_PATH];
   
@@ -547,16 +623,17 @@ bool PrinterManager::PrintPdf(const std::string& printerName, const std::vector<
   GetTempFileNameA(tempPath, "pdf", 0, tempFileName);
   
   // Create a temporary file with .pdf extension (for proper handling)
-  std::string tempPdfFile = std::string(tempFileName) + ".pdf";
+  auto pdfFile = std::make_unique<TemporaryFile>(std::string(tempFileName) + ".pdf");
   
   // Write PDF data to the temporary file
-  std::ofstream outFile(tempPdfFile, std::ios::binary);
+  std::ofstream outFile(pdfFile->Path(), std::ios::binary);
   if (!outFile) {
     return false;
   }
   
   outFile.write(reinterpret_cast<const char*>(data.data()), data.size());
   outFile.close();
+  const std::string& tempPdfFile = pdfFile->Path();
   
   std::wstring widePrinterName = Utf8ToWide(actualPrinterName);
   std::wstring wideTempFile = Utf8ToWide(tempPdfFile);
@@ -589,36 +666,26 @@ bool PrinterManager::PrintPdf(const std::string& printerName, const std::vector<
     // Wait for the process to finish (5 seconds max)
     WaitForSingleObject(pi.hProcess, 5000);
     
-    // Close handles
-    CloseHandle(pi.hProcess);
+    // The file stays until the process exits, even if that is later
     CloseHandle(pi.hThread);
-    
-    // Delete the temporary file (or try to)
-    try {
-      std::remove(tempPdfFile.c_str());
-    } catch (...) {
-      // Ignore errors deleting temp file
-    }
+    ReleaseWhenProcessExits(pi.hProcess, std::move(pdfFile));
     
     return true;
   } else {
     // Alternative approach if the first one failed
-    HINSTANCE hInstance = ShellExecuteW(
-      NULL,
-      L"print",
-      wideTempFile.c_str(),
-      NULL,
-      NULL,
-      SW_HIDE
-    );
+    SHELLEXECUTEINFOW info = {0};
+    info.cbSize = sizeof(info);
+    info.fMask = SEE_MASK_NOCLOSEPROCESS | SEE_MASK_NOASYNC;
+    info.lpVerb = L"print";
+    info.lpFile = wideTempFile.c_str();
+    info.nShow = SW_HIDE;
     
-    bool altSuccess = ((INT_PTR)hInstance > 32);
+    bool altSuccess = ShellExecuteExW(&info) != FALSE;
     
-    // Try to delete the temp file even if printing failed
-    try {
-      std::remove(tempPdfFile.c_str());
-    } catch (...) {
-      // Ignore errors deleting temp file
+    // A handler reached through DDE has no process to wait for; the file
+    // is then deleted right away, as it always was
+    if (altSuccess && info.hProcess != NULL) {
+      ReleaseWhenProcessExits(info.hProcess, std::move(pdfFile));
     }
     
     return altSuccess;
@@ -629,7 +696,8 @@ bool PrinterManager::PrintPdf(const std::string& printerName, const std::vector<
 bool PrinterManager::PrintRichTextDocument(const std::string& printerName, 
                                           const std::string& richTextContent,
                                           const std::string& defaultFontName,
-                                          int defaultFontSize) {
+                                          int defaultFontSize,
+                                          RichTextMode mode) {
   std::string actualPrinterName = printerName;
   
   if (actualPrinterName.empty()) {
@@ -642,26 +710,77 @@ bool PrinterManager::PrintRichTextDocument(const std::string& printerName,
     }
   }
   
-  std::wstring widePrinterName = Utf8ToWide(actualPrinterName);
+  std::shared_ptr<const std::wstring> sharedPrinterName =
+      Win32SpoolerBackend::WidePrinterName(actualPrinterName);
+  const std::wstring& widePrinterName = *sharedPrinterName;
+
+  // A document printed before skips detecting the printer type, encoding
+  // and text layout; ESC/POS output is the only kind with data. A GDI hit
+  // still opens the printer DC and creates its fonts, to draw the runs.
+  ReprintCache& cache = ReprintCache::Instance();
+  const std::string cacheSettings = "richText:" + std::to_string(static_cast<int>(mode)) + ":" +
+                                    defaultFontName + ":" + std::to_string(defaultFontSize);
+  const windows_printer::ReprintCacheKey cacheKey = windows_printer::MakeReprintCacheKey(
+      actualPrinterName, cacheSettings, richTextContent.data(), richTextContent.size());
+  std::shared_ptr<const PreparedDocument> prepared = cache.Find(cacheKey);
+  if (prepared) {
+    mode = prepared->data.empty() ? RichTextMode::kGdi : RichTextMode::kEscPos;
+  }
+
+  if (mode == RichTextMode::kAuto) {
+    mode = QueueIsReceiptPrinter(widePrinterName) ? RichTextMode::kEscPos : RichTextMode::kGdi;
+  }
+  if (mode == RichTextMode::kEscPos) {
+    if (!prepared) {
+      // Printer-resident fonts: no GDI fonts, layout or rasterized pages
+      EscPosEncoder encoder;
+      windows_printer::EncodeRichTextEscPos(richTextContent, &encoder);
+      encoder.Feed(3);
+      encoder.Cut();
+
+      auto document = std::make_shared<PreparedDocument>();
+      document->data = encoder.Bytes();
+      cache.Insert(cacheKey, document);
+      prepared = std::move(document);
+    }
+
+    RawPrintOptions options;
+    options.documentName = "Rich Text Document";
+    return windows_printer::SubmitRawJob(Win32SpoolerBackend::SharedInstance(),
+                                         actualPrinterName, prepared->data.data(),
+                                         prepared->data.size(), options)
+        .success;
+  }
+
+  ScopedQueueEntry queueEntry;
   
   // Use GDI for better font control
+  ScopedStageTimer openTimer(MetricStage::kOpenPrinter);
   HDC hDC = CreateDC(L"WINSPOOL", widePrinterName.c_str(), NULL, NULL);
-  if (!hDC) return false;
+  if (!hDC) {
+    RecordSpoolerFailure(MetricStage::kOpenPrinter);
+    return false;
+  }
+  openTimer.Stop();
   
   DOCINFO di = {0};
   di.cbSize = sizeof(DOCINFO);
   di.lpszDocName = L"Rich Text Document";
   
+  ScopedStageTimer startDocTimer(MetricStage::kStartDocPrinter);
   if (StartDoc(hDC, &di) <= 0) {
+    RecordSpoolerFailure(MetricStage::kStartDocPrinter);
     DeleteDC(hDC);
     return false;
   }
   
   if (StartPage(hDC) <= 0) {
+    RecordSpoolerFailure(MetricStage::kStartDocPrinter);
     EndDoc(hDC);
     DeleteDC(hDC);
     return false;
   }
+  startDocTimer.Stop();
   
   // Create different fonts
   std::wstring wideFontName = Utf8ToWide(defaultFontName);
@@ -703,14 +822,47 @@ bool PrinterManager::PrintRichTextDocument(const std::string& printerName,
   int baseLineHeight = MulDiv(defaultFontSize + 2, GetDeviceCaps(hDC, LOGPIXELSY), 72);
   
   // parse rich text content 
-  std::stringstream ss(richTextContent);
-  std::string line;
-  
-  while (std::getline(ss, line)) {
-    int currentLineHeight = baseLineHeight;
-    ParseAndPrintLine(hDC, line, 50, yPos, normalFont, boldFont, italicFont, 
-                     boldItalicFont, largeFont, &currentLineHeight);
-    yPos += currentLineHeight;
+  {
+    ScopedTraceSpan layoutSpan("layoutRichText");
+    HFONT fonts[] = {normalFont, boldFont, italicFont, boldItalicFont, largeFont};
+    static_assert(sizeof(fonts) / sizeof(fonts[0]) == static_cast<size_t>(RichTextFont::kCount),
+                  "one font per RichTextFont");
+
+    // Every run is measured and drawn through one reused buffer
+    std::wstring wideText;
+    auto widen = [&wideText](std::string_view text) {
+      wideText.resize(windows_printer::MaxUtf16Length(text.size()));
+      return static_cast<int>(windows_printer::Utf8ToUtf16(text, &wideText[0]));
+    };
+
+    // A cached layout is only valid at the resolution it was measured at
+    const int dpiX = GetDeviceCaps(hDC, LOGPIXELSX);
+    const int dpiY = GetDeviceCaps(hDC, LOGPIXELSY);
+    if (!prepared || prepared->dpiX != dpiX || prepared->dpiY != dpiY) {
+      auto document = std::make_shared<PreparedDocument>();
+      document->dpiX = dpiX;
+      document->dpiY = dpiY;
+      document->runs = windows_printer::LayoutRichText(
+          richTextContent, 50, yPos, baseLineHeight,
+          [&](RichTextFont font, std::string_view text) {
+            SelectObject(hDC, fonts[static_cast<int>(font)]);
+            int length = widen(text);
+            SIZE textSize;
+            GetTextExtentPoint32(hDC, wideText.c_str(), length, &textSize);
+            return static_cast<int>(textSize.cx);
+          });
+      cache.Insert(cacheKey, document);
+      prepared = std::move(document);
+    } else {
+      layoutSpan.SetArg("cached", 1);
+    }
+
+    for (const PositionedRichTextRun& run : prepared->runs) {
+      SelectObject(hDC, fonts[static_cast<int>(run.font)]);
+      int length = widen(run.text);
+      TextOut(hDC, run.x, run.y, wideText.c_str(), length);
+    }
+    layoutSpan.SetArg("runs", static_cast<int64_t>(prepared->runs.size()));
   }
   
   DeleteObject(normalFont);
@@ -719,131 +871,109 @@ bool PrinterManager::PrintRichTextDocument(const std::string& printerName,
   DeleteObject(boldItalicFont);
   DeleteObject(largeFont);
   
+  ScopedStageTimer endDocTimer(MetricStage::kEndDocPrinter);
   EndPage(hDC);
-  EndDoc(hDC);
+  if (EndDoc(hDC) <= 0) {
+    RecordSpoolerFailure(MetricStage::kEndDocPrinter);
+  }
   DeleteDC(hDC);
+  endDocTimer.Stop();
   
   return true;
 }
 
-// ParseAndPrintLine Implementation
-void PrinterManager::ParseAndPrintLine(HDC hDC, const std::string& line, int x, int y,
-                                       HFONT normalFont, HFONT boldFont, HFONT italicFont, 
-                                       HFONT boldItalicFont, HFONT largeFont, int* lineHeight) {
-  int currentX = x;
-  std::string currentText = "";
-  HFONT currentFont = normalFont;
-  bool isBold = false;
-  bool isItalic = false;
-  bool isLarge = false;
-  int maxHeight = *lineHeight;
-  
-  for (size_t i = 0; i < line.length(); ++i) {
-    // Check for bold markers (**)
-    if (i + 1 < line.length() && line.substr(i, 2) == "**") {
-      // Print current text before changing format
-      if (!currentText.empty()) {
-        SelectObject(hDC, currentFont);
-        std::wstring wideText = Utf8ToWide(currentText);
-        TextOut(hDC, currentX, y, wideText.c_str(), static_cast<int>(wideText.length()));
-        
-        SIZE textSize;
-        GetTextExtentPoint32(hDC, wideText.c_str(), static_cast<int>(wideText.length()), &textSize);
-        currentX += textSize.cx;
-        currentText = "";
-      }
-      
-      // Toggle bold
-      isBold = !isBold;
-      
-      // Update font based on current state
-      if (isLarge) {
-        currentFont = largeFont; // Large font is always bold
-      } else if (isBold && isItalic) {
-        currentFont = boldItalicFont;
-      } else if (isBold) {
-        currentFont = boldFont;
-      } else if (isItalic) {
-        currentFont = italicFont;
-      } else {
-        currentFont = normalFont;
-      }
-      
-      i++; // Skip second *
-      continue;
-    }
-    
-    // Check for italic markers (*)
-    if (line.substr(i, 1) == "*" && (i == 0 || line[i-1] != '*') && 
-        (i + 1 >= line.length() || line[i+1] != '*')) {
-      // Print current text before changing format
-      if (!currentText.empty()) {
-        SelectObject(hDC, currentFont);
-        std::wstring wideText = Utf8ToWide(currentText);
-        TextOut(hDC, currentX, y, wideText.c_str(), static_cast<int>(wideText.length()));
-        
-        SIZE textSize;
-        GetTextExtentPoint32(hDC, wideText.c_str(), static_cast<int>(wideText.length()), &textSize);
-        currentX += textSize.cx;
-        currentText = "";
-      }
-      
-      // Toggle italic
-      isItalic = !isItalic;
-      
-      // Update font based on current state
-      if (isLarge) {
-        currentFont = largeFont; // Large font is always bold
-      } else if (isBold && isItalic) {
-        currentFont = boldItalicFont;
-      } else if (isBold) {
-        currentFont = boldFont;
-      } else if (isItalic) {
-        currentFont = italicFont;
-      } else {
-        currentFont = normalFont;
-      }
-      
-      continue;
-    }
-    
-    // Check for large text markers (##)
-    if (i + 1 < line.length() && line.substr(i, 2) == "##") {
-      // Print current text before changing format
-      if (!currentText.empty()) {
-        SelectObject(hDC, currentFont);
-        std::wstring wideText = Utf8ToWide(currentText);
-        TextOut(hDC, currentX, y, wideText.c_str(), static_cast<int>(wideText.length()));
-        
-        SIZE textSize;
-        GetTextExtentPoint32(hDC, wideText.c_str(), static_cast<int>(wideText.length()), &textSize);
-        currentX += textSize.cx;
-        currentText = "";
-      }
-      
-      // Toggle large
-      isLarge = !isLarge;
-      currentFont = isLarge ? largeFont : (isBold ? boldFont : (isItalic ? italicFont : normalFont));
-      
-      // Update line height for large text
-      if (isLarge) {
-        maxHeight = static_cast<int>(maxHeight * 1.5);
-      }
-      
-      i++; // Skip second #
-      continue;
+// PrintImage Implementation
+bool PrinterManager::PrintImage(const std::string& printerName,
+                                const std::vector<uint8_t>& rgba,
+                                int width,
+                                int height) {
+  if (width <= 0 || height <= 0 || rgba.size() != static_cast<size_t>(width) * height * 4) {
+    return false;
+  }
+
+  std::string actualPrinterName = printerName;
+  if (actualPrinterName.empty()) {
+    WCHAR defaultPrinterName[256] = {0};
+    DWORD defaultPrinterSize = sizeof(defaultPrinterName) / sizeof(WCHAR);
+    if (GetDefaultPrinter(defaultPrinterName, &defaultPrinterSize)) {
+      actualPrinterName = WideToUtf8(defaultPrinterName);
+    } else {
+      return false;
     }
-    
-    // Regular character
-    currentText += line[i];
   }
-  
-  // Print remaining text
-  if (!currentText.empty()) {
-    SelectObject(hDC, currentFont);
-    std::wstring wideText = Utf8ToWide(currentText);
-    TextOut(hDC, currentX, y, wideText.c_str(), static_cast<int>(wideText.length()));
+
+  ScopedQueueEntry queueEntry;
+  ScopedTraceSpan imageSpan("printImage");
+  imageSpan.SetArg("width", width);
+  imageSpan.SetArg("height", height);
+
+  std::shared_ptr<const std::wstring> widePrinterName =
+      Win32SpoolerBackend::WidePrinterName(actualPrinterName);
+  ScopedStageTimer openTimer(MetricStage::kOpenPrinter);
+  HDC hDC = CreateDC(L"WINSPOOL", widePrinterName->c_str(), NULL, NULL);
+  if (!hDC) {
+    RecordSpoolerFailure(MetricStage::kOpenPrinter);
+    return false;
   }
-  
-  *lineHeight = maxHeight;
-}
\ No newline at end of file
+  openTimer.Stop();
+
+  DOCINFO di = {0};
+  di.cbSize = sizeof(DOCINFO);
+  di.lpszDocName = L"Image";
+
+  ScopedStageTimer startDocTimer(MetricStage::kStartDocPrinter);
+  if (StartDoc(hDC, &di) <= 0) {
+    RecordSpoolerFailure(MetricStage::kStartDocPrinter);
+    DeleteDC(hDC);
+    return false;
+  }
+  if (StartPage(hDC) <= 0) {
+    RecordSpoolerFailure(MetricStage::kStartDocPrinter);
+    AbortDoc(hDC);
+    DeleteDC(hDC);
+    return false;
+  }
+  startDocTimer.Stop();
+
+  // Scaled here rather than by the driver, one band at a time split across
+  // the shared pool; each band is a top-down 32-bit DIB drawn 1:1
+  const ImageRect rect =
+      windows_printer::FitImage(width, height, GetDeviceCaps(hDC, HORZRES), GetDeviceCaps(hDC, VERTRES));
+  ImageScaler scaler(rgba.data(), width, height, rect.width, rect.height);
+  BITMAPINFO info = {};
+  info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  info.bmiHeader.biWidth = rect.width;
+  info.bmiHeader.biPlanes = 1;
+  info.bmiHeader.biBitCount = 32;
+  info.bmiHeader.biCompression = BI_RGB;
+
+  ScopedStageTimer writeTimer(MetricStage::kWritePrinter);
+  const bool drawn = windows_printer::ForEachImageBand(
+      scaler, kImageBandBytes, windows_printer::SharedTaskPool(), [&](const ImageBand& band) {
+        info.bmiHeader.biHeight = -band.rows;
+        return StretchDIBits(hDC, rect.x, rect.y + band.top, band.width, band.rows, 0, 0,
+                             band.width, band.rows, band.bgrx, &info, DIB_RGB_COLORS,
+                             SRCCOPY) != static_cast<int>(GDI_ERROR);
+      });
+  writeTimer.Stop();
+  imageSpan.SetArg("printedWidth", rect.width);
+  imageSpan.SetArg("printedHeight", rect.height);
+
+  if (!drawn) {
+    RecordSpoolerFailure(MetricStage::kWritePrinter);
+    AbortDoc(hDC);
+    DeleteDC(hDC);
+    return false;
+  }
+
+  ScopedStageTimer endDocTimer(MetricStage::kEndDocPrinter);
+  EndPage(hDC);
+  bool ended = EndDoc(hDC) > 0;
+  if (!ended) {
+    RecordSpoolerFailure(MetricStage::kEndDocPrinter);
+  }
+  DeleteDC(hDC);
+  endDocTimer.Stop();
+
+  return ended;
+}
@@ -2,26 +2,46 @@
 #define FLUTTER_PLUGIN_PRINTER_MANAGER_H_
 
 #include <flutter/standard_method_codec.h>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 #include <windows.h>
 
+#include "print_job.h"
+#include "printer_fields.h"
+#include "rich_text.h"
+
 // Class that encapsulates all printer-related functionality
 class PrinterManager {
 public:
   /// Get list of available printers
   static flutter::EncodableList GetAvailablePrinters();
 
-  /// Get printer properties
-  static flutter::EncodableMap GetPrinterProperties(const std::string& printerName);
+  /// Get printer properties. fields is a mask of windows_printer::PrinterField
+  /// sections; sections left out are not queried, and status alone is read
+  /// with the cheap PRINTER_INFO_6.
+  static flutter::EncodableMap GetPrinterProperties(
+      const std::string& printerName,
+      uint32_t fields = windows_printer::kPrinterFieldsAll);
   
   /// Get paper size details
   static flutter::EncodableMap GetPaperSizeDetails(const std::string& printerName);
   
-  /// Print raw data(useful for receipt/thermal printers)
-  static bool PrintRawData(const std::string& printerName, 
-                          const std::vector<uint8_t>& data, 
-                          bool useRawDatatype = true);
+  /// Print raw data(useful for receipt/thermal printers). A zero timeout
+  /// waits for the spooler; otherwise the job is cancelled at the deadline.
+  /// All copies are printed by one job, see RawPrintOptions::copyVariants.
+  /// data is shared with the job's worker rather than copied.
+  static windows_printer::RawPrintResult PrintRawData(const std::string& printerName, 
+                          std::shared_ptr<const std::vector<uint8_t>> data, 
+                          bool useRawDatatype = true,
+                          std::chrono::milliseconds timeout = std::chrono::milliseconds(0),
+                          int copies = 1,
+                          std::vector<std::vector<uint8_t>> copyVariants = {},
+                          std::shared_ptr<windows_printer::PrintReservation> reservation = nullptr);
+
+  /// Cancel a spooler job
+  static bool CancelJob(const std::string& printerName, uint32_t jobId);
   
   /// Print PDF data
   static bool PrintPdf(const std::string& printerName, const std::vector<uint8_t>& data, int copies = 1);
@@ -33,11 +53,23 @@ public:
   /// Open printer properties dialog screen
   static bool OpenPrinterProperties(const std::string& printerName);
 
-  /// Print rich text (use symbols *, #, **,....)
+  /// Print rich text (use symbols *, #, **,....). Receipt printers get the
+  /// markup as ESC/POS text commands unless mode says otherwise; font name and
+  /// size only apply to the GDI path.
   static bool PrintRichTextDocument(const std::string& printerName, 
                                     const std::string& richTextContent,
                                     const std::string& defaultFontName = "Courier New",
-                                    int defaultFontSize = 12);
+                                    int defaultFontSize = 12,
+                                    windows_printer::RichTextMode mode =
+                                        windows_printer::RichTextMode::kAuto);
+
+  /// Print width x height RGBA pixels on one page through the driver,
+  /// scaled to fit the printable area and drawn in bands so the page is
+  /// never held as one bitmap. Transparent pixels print as paper.
+  static bool PrintImage(const std::string& printerName,
+                         const std::vector<uint8_t>& rgba,
+                         int width,
+                         int height);
 
 private:
   /// Helper function to convert wide string to UTF-8
@@ -45,11 +77,6 @@ private:
   
   /// Helper function to convert UTF-8 to wide string
   static std::wstring Utf8ToWide(const std::string& utf8_str);
-
-  /// Helper function to parse and print a line with formatting
-  static void ParseAndPrintLine(HDC hDC, const std::string& line, int x, int y,
-                               HFONT normalFont, HFONT boldFont, HFONT italicFont, 
-                               HFONT boldItalicFont, HFONT largeFont, int* lineHeight);
 };
 
 #endif // FLUTTER_PLUGIN_PRINTER_MANAGER_H_
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include "raw_print_stream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "print_metrics.h"
+#include "spsc_ring.h"
+
+namespace windows_printer {
+
+struct RawPrintStream::State {
+  explicit State(size_t capacity) : ring(capacity) {}
+
+  SpscRing ring;
+  std::shared_ptr<SpoolerBackend> backend;
+  std::string printerName;
+  RawPrintStreamOptions options;
+  PrintStreamListener listener;
+
+  // Set by the producer
+  std::atomic<bool> finishing{false};
+  std::atomic<bool> aborted{false};
+  // Set by the writer
+  std::atomic<bool> failed{false};
+  std::atomic<uint32_t> jobId{0};
+  std::atomic<uint64_t> bytesWritten{0};
+
+  // Set by a Commit that found the ring above the high watermark; whoever
+  // clears it decides whether kWritable is reported
+  std::atomic<bool> wantWritable{false};
+
+  // The writer sleeps here only when the ring is empty
+  std::mutex mutex;
+  std::condition_variable wakeup;
+  std::atomic<bool> writerSleeping{false};
+
+  void Emit(PrintStreamEventType type, uint32_t errorCode = 0) {
+    if (!listener) return;
+    PrintStreamEvent event;
+    event.type = type;
+    event.printerName = printerName;
+    event.jobId = jobId.load(std::memory_order_relaxed);
+    event.bytesWritten = bytesWritten.load(std::memory_order_relaxed);
+    event.errorCode = errorCode;
+    listener(event);
+  }
+
+  // Producer side; takes the mutex only when the writer is asleep
+  void WakeWriter() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writerSleeping.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(mutex);
+      wakeup.notify_one();
+    }
+  }
+
+  bool Stopped() const {
+    return failed.load(std::memory_order_relaxed) ||
+           aborted.load(std::memory_order_relaxed) ||
+           finishing.load(std::memory_order_relaxed);
+  }
+};
+
+RawPrintStream::RawPrintStream(std::shared_ptr<SpoolerBackend> backend,
+                               const std::string& printerName, RawPrintStreamOptions options,
+                               PrintStreamListener listener)
+    : state_(std::make_shared<State>(options.capacity)) {
+  const size_t capacity = state_->ring.Capacity();
+  if (options.highWatermark == 0 || options.highWatermark > capacity) {
+    options.highWatermark = capacity / 4 * 3;
+  }
+  if (options.lowWatermark == 0 || options.lowWatermark >= options.highWatermark) {
+    options.lowWatermark = std::min(capacity / 4, options.highWatermark / 2);
+  }
+  options.maxWriteSize = std::max<size_t>(options.maxWriteSize, 1);
+  state_->backend = std::move(backend);
+  state_->printerName = printerName;
+  state_->options = std::move(options);
+  state_->listener = std::move(listener);
+  std::thread(&RawPrintStream::Run, state_).detach();
+}
+
+RawPrintStream::~RawPrintStream() {
+  if (!state_->finishing.load(std::memory_order_relaxed)) {
+    Abort();
+  }
+}
+
+size_t RawPrintStream::WritableRegion(uint8_t** region) {
+  if (state_->Stopped()) return 0;
+  return state_->ring.WritableRegion(region);
+}
+
+bool RawPrintStream::Commit(size_t size) {
+  State& state = *state_;
+  state.ring.Commit(size);
+  state.WakeWriter();
+  if (state.ring.Size() < state.options.highWatermark) return false;
+
+  state.wantWritable.store(true, std::memory_order_seq_cst);
+  // The writer may have drained past the low watermark before seeing the
+  // flag; then nobody would report kWritable, so carry on instead
+  if (state.ring.Size() <= state.options.lowWatermark &&
+      state.wantWritable.exchange(false, std::memory_order_seq_cst)) {
+    return false;
+  }
+  return true;
+}
+
+size_t RawPrintStream::Write(const uint8_t* data, size_t size, bool* full) {
+  *full = false;
+  size_t written = 0;
+  while (written < size && !*full) {
+    uint8_t* region = nullptr;
+    size_t available = WritableRegion(&region);
+    if (available == 0) {
+      *full = true;
+      break;
+    }
+    size_t chunk = std::min(available, size - written);
+    std::copy(data + written, data + written + chunk, region);
+    *full = Commit(chunk);
+    written += chunk;
+  }
+  return written;
+}
+
+void RawPrintStream::Finish() {
+  state_->finishing.store(true, std::memory_order_release);
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->wakeup.notify_one();
+}
+
+void RawPrintStream::Abort() {
+  state_->aborted.store(true, std::memory_order_release);
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->wakeup.notify_one();
+}
+
+size_t RawPrintStream::Buffered() const {
+  return state_->ring.Size();
+}
+
+size_t RawPrintStream::Capacity() const {
+  return state_->ring.Capacity();
+}
+
+uint64_t RawPrintStream::BytesWritten() const {
+  return state_->bytesWritten.load(std::memory_order_relaxed);
+}
+
+uint32_t RawPrintStream::JobId() const {
+  return state_->jobId.load(std::memory_order_relaxed);
+}
+
+bool RawPrintStream::Failed() const {
+  return state_->failed.load(std::memory_order_relaxed);
+}
+
+void RawPrintStream::Run(std::shared_ptr<State> statePointer) {
+  State& state = *statePointer;
+  SpoolerBackend& backend = *state.backend;
+  ScopedQueueEntry queueEntry;
+
+  auto fail = [&state, &backend](MetricStage stage) {
+    uint32_t error = backend.LastError();
+    PrintMetrics::Instance().RecordFailure(stage, error);
+    state.failed.store(true, std::memory_order_relaxed);
+    state.Emit(PrintStreamEventType::kFailed, error);
+  };
+
+  if (state.printerName.empty() && !backend.DefaultPrinterName(&state.printerName)) {
+    state.failed.store(true, std::memory_order_relaxed);
+    state.Emit(PrintStreamEventType::kFailed, backend.LastError());
+    return;
+  }
+
+  PrinterHandle handle = nullptr;
+  ScopedStageTimer openTimer(MetricStage::kOpenPrinter);
+  if (!backend.Open(state.printerName, &handle)) {
+    fail(MetricStage::kOpenPrinter);
+    return;
+  }
+  openTimer.Stop();
+
+  RawDocInfo docInfo;
+  docInfo.documentName = state.options.documentName;
+  docInfo.datatype = state.options.useRawDatatype ? "RAW" : "TEXT";
+  ScopedStageTimer startDocTimer(MetricStage::kStartDocPrinter);
+  const uint32_t jobId = backend.StartDocument(handle, docInfo);
+  if (jobId == 0) {
+    fail(MetricStage::kStartDocPrinter);
+    backend.Close(handle);
+    return;
+  }
+  state.jobId.store(jobId, std::memory_order_relaxed);
+  if (!backend.StartPage(handle)) {
+    fail(MetricStage::kStartDocPrinter);
+    backend.CancelJob(state.printerName, jobId);
+    backend.EndDocument(handle);
+    backend.Close(handle);
+    return;
+  }
+  startDocTimer.SetTraceArg("jobId", jobId);
+  startDocTimer.Stop();
+  state.Emit(PrintStreamEventType::kStarted);
+
+  bool writeFailed = false;
+  while (!state.aborted.load(std::memory_order_acquire)) {
+    const uint8_t* region = nullptr;
+    size_t available = state.ring.ReadableRegion(&region);
+    if (available == 0) {
+      // Everything committed before Finish() is visible once it is seen
+      if (state.finishing.load(std::memory_order_acquire)) {
+        if (state.ring.ReadableRegion(&region) == 0) break;
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(state.mutex);
+      state.writerSleeping.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      state.wakeup.wait(lock, [&state]() {
+        return state.ring.Size() > 0 || state.finishing.load(std::memory_order_relaxed) ||
+               state.aborted.load(std::memory_order_relaxed);
+      });
+      state.writerSleeping.store(false, std::memory_order_relaxed);
+      continue;
+    }
+
+    const uint32_t chunk = static_cast<uint32_t>(std::min<size_t>(
+        std::min(available, state.options.maxWriteSize), std::numeric_limits<uint32_t>::max()));
+    uint32_t chunkWritten = 0;
+    ScopedStageTimer writeTimer(MetricStage::kWritePrinter);
+    if (!backend.Write(handle, region, chunk, &chunkWritten) || chunkWritten == 0) {
+      writeTimer.Stop();
+      writeFailed = true;
+      break;
+    }
+    writeTimer.SetTraceArg("bytes", chunkWritten);
+    writeTimer.Stop();
+    state.ring.Release(chunkWritten);
+    state.bytesWritten.fetch_add(chunkWritten, std::memory_order_relaxed);
+    PrintMetrics::Instance().RecordBytesWritten(chunkWritten);
+
+    if (state.wantWritable.load(std::memory_order_seq_cst) &&
+        state.ring.Size() <= state.options.lowWatermark &&
+        state.wantWritable.exchange(false, std::memory_order_seq_cst)) {
+      state.Emit(PrintStreamEventType::kWritable);
+    }
+  }
+
+  if (writeFailed || state.aborted.load(std::memory_order_acquire)) {
+    // Remember the error before the cleanup calls overwrite it
+    const uint32_t error = writeFailed ? backend.LastError() : 0;
+    if (writeFailed) {
+      PrintMetrics::Instance().RecordFailure(MetricStage::kWritePrinter, error);
+      state.failed.store(true, std::memory_order_relaxed);
+    }
+    backend.CancelJob(state.printerName, jobId);
+    backend.EndDocument(handle);
+    backend.Close(handle);
+    state.Emit(writeFailed ? PrintStreamEventType::kFailed : PrintStreamEventType::kCancelled,
+               error);
+    return;
+  }
+
+  ScopedStageTimer endDocTimer(MetricStage::kEndDocPrinter);
+  backend.EndPage(handle);
+  if (!backend.EndDocument(handle)) {
+    const uint32_t error = backend.LastError();
+    PrintMetrics::Instance().RecordFailure(MetricStage::kEndDocPrinter, error);
+    state.failed.store(true, std::memory_order_relaxed);
+    backend.Close(handle);
+    endDocTimer.Stop();
+    state.Emit(PrintStreamEventType::kFailed, error);
+    return;
+  }
+  backend.Close(handle);
+  endDocTimer.Stop();
+  state.Emit(PrintStreamEventType::kFinished);
+}
+
+}  // namespace windows_printer
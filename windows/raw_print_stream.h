@@ -0,0 +1,118 @@
+#ifndef FLUTTER_PLUGIN_RAW_PRINT_STREAM_H_
+#define FLUTTER_PLUGIN_RAW_PRINT_STREAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "spooler_backend.h"
+
+namespace windows_printer {
+
+enum class PrintStreamEventType {
+  /// The job started; jobId is set
+  kStarted = 0,
+  /// The buffer drained to the low watermark after Commit reported it full
+  kWritable,
+  /// Every byte was written and the job ended
+  kFinished,
+  /// A spooler call failed; errorCode is set and the job was cancelled
+  kFailed,
+  /// Abort() cancelled the job
+  kCancelled,
+};
+
+struct PrintStreamEvent {
+  PrintStreamEventType type = PrintStreamEventType::kStarted;
+  std::string printerName;
+  uint32_t jobId = 0;
+  uint64_t bytesWritten = 0;
+  uint32_t errorCode = 0;
+};
+
+/// Receives a stream's events on its writer thread, without any lock held
+using PrintStreamListener = std::function<void(const PrintStreamEvent& event)>;
+
+struct RawPrintStreamOptions {
+  /// Ring buffer size, rounded up to a power of two
+  size_t capacity = 1 << 20;
+  /// Commit reports the buffer full at this many buffered bytes; zero means
+  /// three quarters of the capacity
+  size_t highWatermark = 0;
+  /// kWritable is reported once the buffer drains to this many bytes; zero
+  /// means a quarter of the capacity
+  size_t lowWatermark = 0;
+  bool useRawDatatype = true;
+  std::string documentName = "Raw Print Stream";
+  /// Largest single backend Write, so the buffer is handed back in steps
+  size_t maxWriteSize = 64 << 10;
+};
+
+// One raw print job fed continuously through a lock-free ring buffer. The
+// producer fills the ring on its own thread and never waits for the
+// printer; a writer thread opens the printer, drains the ring into the job
+// as data arrives and ends the job once the producer calls Finish().
+//
+// Backpressure comes from watermarks instead of blocking: Commit returns
+// true once the ring holds highWatermark bytes, and the listener hears
+// kWritable when it has drained to lowWatermark. Every producer call must
+// come from the same thread.
+class RawPrintStream {
+public:
+  /// Starts the writer. An empty printerName selects the default printer.
+  RawPrintStream(std::shared_ptr<SpoolerBackend> backend, const std::string& printerName,
+                 RawPrintStreamOptions options = RawPrintStreamOptions(),
+                 PrintStreamListener listener = nullptr);
+
+  /// Aborts the job unless Finish() was called. The writer keeps its own
+  /// reference to the shared state and exits on its own.
+  ~RawPrintStream();
+
+  RawPrintStream(const RawPrintStream&) = delete;
+  RawPrintStream& operator=(const RawPrintStream&) = delete;
+
+  /// Contiguous free space to write into; 0 when the ring is full or the
+  /// stream has failed, been finished or been aborted
+  size_t WritableRegion(uint8_t** region);
+
+  /// Publish size bytes of the writable region. Returns true when the
+  /// producer should stop until kWritable.
+  bool Commit(size_t size);
+
+  /// Copy as much of data as fits. *full is set as Commit would return.
+  size_t Write(const uint8_t* data, size_t size, bool* full);
+
+  /// No more data: the writer drains the ring, ends the job and reports
+  /// kFinished
+  void Finish();
+
+  /// Stop writing, cancel the job and report kCancelled
+  void Abort();
+
+  /// Bytes waiting in the ring
+  size_t Buffered() const;
+
+  size_t Capacity() const;
+
+  /// Bytes handed to the spooler so far
+  uint64_t BytesWritten() const;
+
+  /// Spooler job id once started, otherwise 0
+  uint32_t JobId() const;
+
+  /// The writer gave up after a failed spooler call
+  bool Failed() const;
+
+private:
+  struct State;
+
+  static void Run(std::shared_ptr<State> state);
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_RAW_PRINT_STREAM_H_
@@ -0,0 +1,208 @@
+#include "receipt_image.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace windows_printer {
+
+namespace {
+
+// Filter weights are in 1/4096
+constexpr int kWeightBits = 12;
+constexpr int kWeightOne = 1 << kWeightBits;
+
+// Luminance in 1/256 at which a dithered dot turns black, and the largest
+// such luminance
+constexpr int32_t kDitherThreshold = 128 << 8;
+constexpr int32_t kWhite = 255 << 8;
+// EscPosEncoder::Image rounds luminance, then prints below 128
+constexpr int32_t kRoundedThreshold = (128 << 8) - 128;
+
+}  // namespace
+
+ReceiptRasterizer::ReceiptRasterizer(const ReceiptImageOptions& options) : options_(options) {}
+
+ReceiptRasterizer::Taps ReceiptRasterizer::BuildTaps(int source, int target) {
+  Taps taps;
+  taps.first.reserve(target);
+  taps.count.reserve(target);
+  taps.offset.reserve(target);
+  const double scale = static_cast<double>(source) / target;
+  std::vector<double> exact;
+  std::vector<int> weights;
+  for (int j = 0; j < target; j++) {
+    int first;
+    exact.clear();
+    if (target < source) {
+      // The average of the source pixels the output pixel covers
+      const double start = j * scale;
+      const double end = (j + 1) * scale;
+      first = static_cast<int>(start);
+      const int last = std::min(source, static_cast<int>(std::ceil(end)));
+      for (int i = first; i < last; i++) {
+        exact.push_back((std::min(end, i + 1.0) - std::max(start, static_cast<double>(i))) / scale);
+      }
+    } else {
+      // Between the two nearest source pixel centers
+      const double center =
+          std::min(std::max((j + 0.5) * scale - 0.5, 0.0), static_cast<double>(source - 1));
+      first = static_cast<int>(center);
+      const double fraction = center - first;
+      exact.push_back(1 - fraction);
+      if (first + 1 < source) exact.push_back(fraction);
+    }
+
+    // Rounded weights sum to exactly one, the remainder going to the largest
+    weights.clear();
+    int sum = 0;
+    size_t largest = 0;
+    for (size_t k = 0; k < exact.size(); k++) {
+      weights.push_back(static_cast<int>(std::lround(exact[k] * kWeightOne)));
+      sum += weights[k];
+      if (weights[k] > weights[largest]) largest = k;
+    }
+    weights[largest] += kWeightOne - sum;
+
+    size_t begin = 0;
+    size_t end = weights.size();
+    while (end - begin > 1 && weights[begin] == 0) begin++;
+    while (end - begin > 1 && weights[end - 1] == 0) end--;
+    taps.first.push_back(first + static_cast<int>(begin));
+    taps.count.push_back(static_cast<int>(end - begin));
+    taps.offset.push_back(taps.weights.size());
+    for (size_t k = begin; k < end; k++) {
+      taps.weights.push_back(static_cast<uint16_t>(weights[k]));
+    }
+  }
+  return taps;
+}
+
+bool ReceiptRasterizer::Begin(int width, int height) {
+  const int targetWidth = options_.width;
+  if (targetWidth < 1 || targetWidth > kMaxImageDimension) {
+    error_ = "Invalid image width";
+    return false;
+  }
+  const int64_t targetHeight = std::max<int64_t>(
+      1, (static_cast<int64_t>(height) * targetWidth + width / 2) / width);
+  if (targetHeight > kMaxReceiptImageHeight) {
+    error_ = "Image is too tall to print";
+    return false;
+  }
+
+  columns_ = BuildTaps(width, targetWidth);
+  rows_ = BuildTaps(height, static_cast<int>(targetHeight));
+
+  // As many sums as output rows share one source row
+  std::vector<int> sharing(static_cast<size_t>(height) + 1, 0);
+  for (size_t r = 0; r < rows_.first.size(); r++) {
+    sharing[rows_.first[r]]++;
+    sharing[rows_.first[r] + rows_.count[r]]--;
+  }
+  int open = 0;
+  int ring = 1;
+  for (int y = 0; y < height; y++) {
+    open += sharing[y];
+    ring = std::max(ring, open);
+  }
+  sums_.assign(ring, std::vector<uint32_t>(targetWidth, 0));
+  scaled_.assign(targetWidth, 0);
+  errors_[0].assign(static_cast<size_t>(targetWidth) + 2, 0);
+  errors_[1].assign(static_cast<size_t>(targetWidth) + 2, 0);
+  nextOpen_ = 0;
+  nextFinished_ = 0;
+  bitmap_ = MonoBitmap(targetWidth, static_cast<int>(targetHeight));
+  return true;
+}
+
+void ReceiptRasterizer::Row(int y, const uint8_t* gray) {
+  const int targetWidth = bitmap_.Width();
+  const int targetHeight = bitmap_.Height();
+
+  // Across: weights sum to 4096, leaving luminance in 1/256 after 4 bits
+  const uint16_t* weights = columns_.weights.data();
+  for (int x = 0; x < targetWidth; x++) {
+    const uint8_t* source = gray + columns_.first[x];
+    const uint16_t* weight = weights + columns_.offset[x];
+    uint32_t sum = 0;
+    for (int k = 0; k < columns_.count[x]; k++) {
+      sum += static_cast<uint32_t>(weight[k]) * source[k];
+    }
+    scaled_[x] = static_cast<uint16_t>((sum + 8) >> 4);
+  }
+
+  // Down: add into every output row this row is part of
+  while (nextOpen_ < targetHeight && rows_.first[nextOpen_] <= y) {
+    std::vector<uint32_t>& sums = sums_[nextOpen_ % sums_.size()];
+    std::fill(sums.begin(), sums.end(), 0);
+    nextOpen_++;
+  }
+  for (int row = nextFinished_; row < nextOpen_; row++) {
+    const int index = y - rows_.first[row];
+    if (index >= rows_.count[row]) continue;
+    const uint32_t weight = rows_.weights[rows_.offset[row] + index];
+    uint32_t* sums = sums_[row % sums_.size()].data();
+    for (int x = 0; x < targetWidth; x++) {
+      sums[x] += weight * scaled_[x];
+    }
+  }
+  while (nextFinished_ < nextOpen_ &&
+         rows_.first[nextFinished_] + rows_.count[nextFinished_] <= y + 1) {
+    FinishRow(nextFinished_++);
+  }
+}
+
+void ReceiptRasterizer::FinishRow(int row) {
+  const int width = bitmap_.Width();
+  const uint32_t* sums = sums_[row % sums_.size()].data();
+  uint8_t* dots = bitmap_.Row(row);
+  constexpr uint32_t kRound = 1 << (kWeightBits - 1);
+
+  if (!options_.dither) {
+    for (int x = 0; x < width; x++) {
+      if (static_cast<int32_t>((sums[x] + kRound) >> kWeightBits) < kRoundedThreshold) {
+        dots[x >> 3] |= static_cast<uint8_t>(0x80 >> (x & 7));
+      }
+    }
+    return;
+  }
+
+  // Floyd-Steinberg, alternating direction every row so the error does not
+  // drift to one side
+  int32_t* current = errors_[row & 1].data() + 1;
+  int32_t* next = errors_[(row + 1) & 1].data() + 1;
+  std::fill(next - 1, next + width + 1, 0);
+  const bool forward = (row & 1) == 0;
+  const int step = forward ? 1 : -1;
+  for (int i = 0; i < width; i++) {
+    const int x = forward ? i : width - 1 - i;
+    const int32_t value = static_cast<int32_t>((sums[x] + kRound) >> kWeightBits) + current[x];
+    int32_t error = value;
+    if (value < kDitherThreshold) {
+      dots[x >> 3] |= static_cast<uint8_t>(0x80 >> (x & 7));
+    } else {
+      error -= kWhite;
+    }
+    const int32_t ahead = error * 7 / 16;
+    const int32_t behindBelow = error * 3 / 16;
+    const int32_t below = error * 5 / 16;
+    current[x + step] += ahead;
+    next[x - step] += behindBelow;
+    next[x] += below;
+    next[x + step] += error - ahead - behindBelow - below;
+  }
+}
+
+bool RasterizeReceiptImage(const uint8_t* data, size_t size, const ReceiptImageOptions& options,
+                           MonoBitmap* bitmap, std::string* error) {
+  ReceiptRasterizer rasterizer(options);
+  std::string decodeError;
+  if (!DecodeGrayImage(data, size, rasterizer, &decodeError)) {
+    if (error) *error = rasterizer.Error().empty() ? decodeError : rasterizer.Error();
+    return false;
+  }
+  *bitmap = rasterizer.TakeBitmap();
+  return true;
+}
+
+}  // namespace windows_printer
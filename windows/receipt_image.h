@@ -0,0 +1,84 @@
+#ifndef FLUTTER_PLUGIN_RECEIPT_IMAGE_H_
+#define FLUTTER_PLUGIN_RECEIPT_IMAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "image_decoder.h"
+#include "mono_bitmap.h"
+
+namespace windows_printer {
+
+struct ReceiptImageOptions {
+  /// Dots across: 384 for 58 mm paper, 576 for 80 mm
+  int width = 576;
+  /// Floyd-Steinberg error diffusion, for photos and shaded logos;
+  /// otherwise dots are thresholded at 128 like EscPosEncoder::Image
+  bool dither = true;
+};
+
+/// Output images taller than this many dots are refused
+constexpr int kMaxReceiptImageHeight = 16384;
+
+// Turns decoded rows into printer dots as they arrive. Each row is scaled
+// across to the target width (area averaging when shrinking, bilinear when
+// enlarging), added into the few output rows it covers, and an output row
+// is dithered as soon as its last source row is in. Only those rows are
+// held, whatever the size of the source.
+class ReceiptRasterizer : public GrayRowSink {
+public:
+  explicit ReceiptRasterizer(const ReceiptImageOptions& options = ReceiptImageOptions());
+
+  ReceiptRasterizer(const ReceiptRasterizer&) = delete;
+  ReceiptRasterizer& operator=(const ReceiptRasterizer&) = delete;
+
+  /// Refuses, with Error set, a source that would print taller than
+  /// kMaxReceiptImageHeight
+  bool Begin(int width, int height) override;
+  void Row(int y, const uint8_t* gray) override;
+
+  /// Complete once every source row was delivered
+  const MonoBitmap& Bitmap() const { return bitmap_; }
+  MonoBitmap TakeBitmap() { return std::move(bitmap_); }
+
+  const std::string& Error() const { return error_; }
+
+private:
+  // Source positions and weights in 1/4096 for each output position
+  struct Taps {
+    std::vector<int> first;
+    std::vector<int> count;
+    std::vector<size_t> offset;
+    std::vector<uint16_t> weights;
+  };
+
+  static Taps BuildTaps(int source, int target);
+  void FinishRow(int row);
+
+  ReceiptImageOptions options_;
+  Taps columns_;
+  Taps rows_;
+  // Source row scaled across, luminance in 1/256
+  std::vector<uint16_t> scaled_;
+  // Open output rows, a ring indexed by output row
+  std::vector<std::vector<uint32_t>> sums_;
+  int nextOpen_ = 0;
+  int nextFinished_ = 0;
+  // Error diffused onto this row and the next, with a guard each side
+  std::vector<int32_t> errors_[2];
+  MonoBitmap bitmap_;
+  std::string error_;
+};
+
+/// Decode a PNG or baseline JPEG and rasterize it for a thermal printer:
+/// options.width dots across, aspect ratio kept, transparency on white.
+/// Returns false with a message in *error for data that cannot be decoded.
+bool RasterizeReceiptImage(const uint8_t* data, size_t size, const ReceiptImageOptions& options,
+                           MonoBitmap* bitmap, std::string* error);
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_RECEIPT_IMAGE_H_
@@ -0,0 +1,131 @@
+#include "reprint_cache.h"
+
+#include <iterator>
+
+#include "content_hash.h"
+
+namespace windows_printer {
+
+uint64_t PreparedDocument::Bytes() const {
+  uint64_t bytes = sizeof(PreparedDocument) + data.size();
+  for (const PositionedRichTextRun& run : runs) {
+    bytes += sizeof(run) + run.text.size();
+  }
+  return bytes;
+}
+
+ReprintCacheKey MakeReprintCacheKey(const std::string& printerName, std::string_view settings,
+                                    const void* content, size_t size) {
+  // A different seed makes the check independent of the hash
+  constexpr uint64_t kCheckSeed = 0x72657072696e7421ULL;
+  Hasher64 hasher;
+  Hasher64 checker(kCheckSeed);
+  auto update = [&hasher, &checker](const void* data, size_t length) {
+    hasher.Update(data, length);
+    checker.Update(data, length);
+  };
+  // Lengths keep the fields from running into each other
+  const uint64_t nameSize = printerName.size();
+  const uint64_t settingsSize = settings.size();
+  update(&nameSize, sizeof(nameSize));
+  update(printerName.data(), printerName.size());
+  update(&settingsSize, sizeof(settingsSize));
+  update(settings.data(), settings.size());
+  update(content, size);
+
+  ReprintCacheKey key;
+  key.hash = hasher.Digest();
+  key.check = checker.Digest();
+  key.contentSize = size;
+  return key;
+}
+
+ReprintCache::ReprintCache(ReprintCacheOptions options) : options_(options) {}
+
+ReprintCache& ReprintCache::Instance() {
+  static ReprintCache instance;
+  return instance;
+}
+
+void ReprintCache::SetOptions(ReprintCacheOptions options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  options_ = options;
+  EvictToFit();
+}
+
+ReprintCacheOptions ReprintCache::Options() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return options_;
+}
+
+std::shared_ptr<const PreparedDocument> ReprintCache::Find(const ReprintCacheKey& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = index_.find(key.hash);
+  if (found == index_.end() || found->second->key.check != key.check ||
+      found->second->key.contentSize != key.contentSize) {
+    misses_++;
+    return nullptr;
+  }
+  hits_++;
+  entries_.splice(entries_.begin(), entries_, found->second);
+  return found->second->document;
+}
+
+void ReprintCache::Insert(const ReprintCacheKey& key,
+                          std::shared_ptr<const PreparedDocument> document) {
+  const uint64_t bytes = document->Bytes();
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = index_.find(key.hash);
+  if (found != index_.end()) {
+    EraseEntry(found->second);
+  }
+  if (bytes > options_.maxBytes || options_.maxEntries == 0) return;
+
+  entries_.push_front(Entry{key, std::move(document), bytes});
+  index_[key.hash] = entries_.begin();
+  bytes_ += bytes;
+  EvictToFit();
+}
+
+void ReprintCache::Erase(const ReprintCacheKey& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = index_.find(key.hash);
+  if (found != index_.end() && found->second->key.check == key.check &&
+      found->second->key.contentSize == key.contentSize) {
+    EraseEntry(found->second);
+  }
+}
+
+ReprintCacheStats ReprintCache::Stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ReprintCacheStats stats;
+  stats.entries = entries_.size();
+  stats.bytes = bytes_;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.evictions = evictions_;
+  return stats;
+}
+
+void ReprintCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  index_.clear();
+  bytes_ = 0;
+}
+
+void ReprintCache::EraseEntry(std::list<Entry>::iterator entry) {
+  bytes_ -= entry->bytes;
+  index_.erase(entry->key.hash);
+  entries_.erase(entry);
+}
+
+void ReprintCache::EvictToFit() {
+  while (!entries_.empty() &&
+         (bytes_ > options_.maxBytes || entries_.size() > options_.maxEntries)) {
+    EraseEntry(std::prev(entries_.end()));
+    evictions_++;
+  }
+}
+
+}  // namespace windows_printer
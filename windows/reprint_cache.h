@@ -0,0 +1,119 @@
+#ifndef FLUTTER_PLUGIN_REPRINT_CACHE_H_
+#define FLUTTER_PLUGIN_REPRINT_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "rich_text.h"
+
+namespace windows_printer {
+
+/// A document fully prepared for one printer. Immutable once cached, so it
+/// can be printed from any thread while the cache evicts it.
+struct PreparedDocument {
+  /// Spool-ready bytes, such as ESC/POS, sent as one raw job
+  std::vector<uint8_t> data;
+  /// GDI layout, drawn without measuring text again
+  std::vector<PositionedRichTextRun> runs;
+  /// Device resolution the runs were laid out for
+  int dpiX = 0;
+  int dpiY = 0;
+
+  /// Memory held by the document
+  uint64_t Bytes() const;
+};
+
+struct ReprintCacheOptions {
+  /// Bytes of prepared output kept in memory; 0 turns the cache off
+  uint64_t maxBytes = 32 << 20;
+  size_t maxEntries = 64;
+};
+
+struct ReprintCacheStats {
+  size_t entries = 0;
+  uint64_t bytes = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+};
+
+/// Identifies what a document was prepared from. hash looks it up; a hit
+/// must also match check, an independent hash of the same fields, and the
+/// content size, so two documents whose hashes collide miss rather than
+/// print each other.
+struct ReprintCacheKey {
+  uint64_t hash = 0;
+  uint64_t check = 0;
+  uint64_t contentSize = 0;
+};
+
+/// Key of a document prepared from content for printerName with settings,
+/// such as the mode, font and size, that change the output
+ReprintCacheKey MakeReprintCacheKey(const std::string& printerName, std::string_view settings,
+                                    const void* content, size_t size);
+
+// Keeps prepared output of documents printed again and again, such as menus
+// and notices, keyed by hashes of their content, printer and settings. A
+// hit is printed as it was prepared the first time. The least recently used
+// documents are evicted to stay within the limits; a document evicted while
+// it is printing lives until the print holding it finishes.
+class ReprintCache {
+public:
+  explicit ReprintCache(ReprintCacheOptions options = ReprintCacheOptions());
+
+  ReprintCache(const ReprintCache&) = delete;
+  ReprintCache& operator=(const ReprintCache&) = delete;
+
+  /// The cache used by PrinterManager
+  static ReprintCache& Instance();
+
+  /// Evicts down to the new limits
+  void SetOptions(ReprintCacheOptions options);
+  ReprintCacheOptions Options() const;
+
+  /// The document cached under key, or nullptr on a miss
+  std::shared_ptr<const PreparedDocument> Find(const ReprintCacheKey& key);
+
+  /// Cache document under key, replacing any document with the same hash.
+  /// Documents larger than the byte limit are not kept.
+  void Insert(const ReprintCacheKey& key, std::shared_ptr<const PreparedDocument> document);
+
+  /// Drop a document, e.g. one that failed to print
+  void Erase(const ReprintCacheKey& key);
+
+  ReprintCacheStats Stats() const;
+
+  void Clear();
+
+private:
+  struct Entry {
+    ReprintCacheKey key;
+    std::shared_ptr<const PreparedDocument> document;
+    uint64_t bytes = 0;
+  };
+
+  // Must be called with mutex_ held
+  void EraseEntry(std::list<Entry>::iterator entry);
+  void EvictToFit();
+
+  mutable std::mutex mutex_;
+  ReprintCacheOptions options_;
+  // Most recently used first
+  std::list<Entry> entries_;
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+  uint64_t bytes_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  uint64_t evictions_ = 0;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_REPRINT_CACHE_H_
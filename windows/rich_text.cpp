@@ -0,0 +1,209 @@
+#include "rich_text.h"
+
+#include <array>
+#include <cctype>
+
+#include "esc_pos_encoder.h"
+
+namespace windows_printer {
+
+namespace {
+
+constexpr uint8_t kEsc = 0x1B;
+constexpr uint8_t kGs = 0x1D;
+
+// Printer settings that make up a rich text font
+struct EscPosFontStyle {
+  bool bold = false;
+  bool underline = false;
+  uint8_t size = 0x00;
+};
+
+EscPosFontStyle EscPosStyleFor(RichTextFont font) {
+  EscPosFontStyle style;
+  style.bold = font == RichTextFont::kBold || font == RichTextFont::kBoldItalic ||
+               font == RichTextFont::kLarge;
+  style.underline = font == RichTextFont::kItalic || font == RichTextFont::kBoldItalic;
+  // GS ! with double width and double height
+  style.size = font == RichTextFont::kLarge ? 0x11 : 0x00;
+  return style;
+}
+
+void SwitchEscPosStyle(const EscPosFontStyle& from, const EscPosFontStyle& to,
+                       EscPosEncoder* encoder) {
+  if (from.bold != to.bold) {
+    const uint8_t command[] = {kEsc, 0x45, static_cast<uint8_t>(to.bold ? 1 : 0)};
+    encoder->Raw(command, sizeof(command));
+  }
+  if (from.underline != to.underline) {
+    const uint8_t command[] = {kEsc, 0x2D, static_cast<uint8_t>(to.underline ? 1 : 0)};
+    encoder->Raw(command, sizeof(command));
+  }
+  if (from.size != to.size) {
+    const uint8_t command[] = {kGs, 0x21, to.size};
+    encoder->Raw(command, sizeof(command));
+  }
+}
+
+// Lower-case driver name fragments of receipt printer families
+constexpr std::array<std::string_view, 11> kReceiptDrivers = {
+    "receipt", "thermal", "epson tm-", "tm-t", "tm-m", "star tsp", "xp-", "rongta", "bixolon srp",
+    "58mm",    "80mm"};
+// Label printers are narrow too but do not speak ESC/POS
+constexpr std::array<std::string_view, 7> kLabelDrivers = {"zdesigner", "zebra", "label", "tsc ",
+                                                           "dymo",      "godex", "brother ql"};
+
+bool ContainsAny(const std::string& text, const std::string_view* begin,
+                 const std::string_view* end) {
+  for (const std::string_view* fragment = begin; fragment != end; ++fragment) {
+    if (text.find(*fragment) != std::string::npos) return true;
+  }
+  return false;
+}
+
+// "POS" as a word of its own, as in "POS-80" or "Generic POS Printer"
+bool HasPosWord(const std::string& text) {
+  for (size_t at = text.find("pos"); at != std::string::npos; at = text.find("pos", at + 1)) {
+    const bool startsWord = at == 0 || !std::isalpha(static_cast<unsigned char>(text[at - 1]));
+    const bool endsWord =
+        at + 3 >= text.size() || !std::isalpha(static_cast<unsigned char>(text[at + 3]));
+    if (startsWord && endsWord) return true;
+  }
+  return false;
+}
+
+RichTextFont SelectFont(bool isBold, bool isItalic, bool isLarge) {
+  if (isLarge) return RichTextFont::kLarge;
+  if (isBold && isItalic) return RichTextFont::kBoldItalic;
+  if (isBold) return RichTextFont::kBold;
+  if (isItalic) return RichTextFont::kItalic;
+  return RichTextFont::kNormal;
+}
+
+}  // namespace
+
+RichTextLine ParseRichTextLine(std::string_view line, int baseLineHeight) {
+  RichTextLine parsed;
+  parsed.lineHeight = baseLineHeight;
+
+  std::string currentText;
+  RichTextFont currentFont = RichTextFont::kNormal;
+  bool isBold = false;
+  bool isItalic = false;
+  bool isLarge = false;
+
+  auto flush = [&]() {
+    if (!currentText.empty()) {
+      parsed.runs.push_back(RichTextRun{std::move(currentText), currentFont});
+      currentText.clear();
+    }
+  };
+
+  for (size_t i = 0; i < line.length(); ++i) {
+    // Bold markers (**)
+    if (i + 1 < line.length() && line[i] == '*' && line[i + 1] == '*') {
+      flush();
+      isBold = !isBold;
+      currentFont = SelectFont(isBold, isItalic, isLarge);
+      i++;
+      continue;
+    }
+
+    // Italic markers (a single * not adjacent to another *)
+    if (line[i] == '*' && (i == 0 || line[i - 1] != '*') &&
+        (i + 1 >= line.length() || line[i + 1] != '*')) {
+      flush();
+      isItalic = !isItalic;
+      currentFont = SelectFont(isBold, isItalic, isLarge);
+      continue;
+    }
+
+    // Large text markers (##)
+    if (i + 1 < line.length() && line[i] == '#' && line[i + 1] == '#') {
+      flush();
+      isLarge = !isLarge;
+      // Leaving large text never restores bold italic, only one of the two
+      currentFont = isLarge ? RichTextFont::kLarge
+                            : (isBold ? RichTextFont::kBold
+                                      : (isItalic ? RichTextFont::kItalic : RichTextFont::kNormal));
+      if (isLarge) {
+        parsed.lineHeight = static_cast<int>(parsed.lineHeight * 1.5);
+      }
+      i++;
+      continue;
+    }
+
+    currentText += line[i];
+  }
+  flush();
+
+  return parsed;
+}
+
+std::vector<PositionedRichTextRun> LayoutRichText(std::string_view content,
+                                                  int originX, int originY,
+                                                  int baseLineHeight,
+                                                  const RichTextMeasure& measure) {
+  std::vector<PositionedRichTextRun> positioned;
+  int y = originY;
+
+  // Lines split like std::getline: a trailing newline does not start a line
+  size_t start = 0;
+  while (start < content.size()) {
+    size_t end = content.find('\n', start);
+    if (end == std::string_view::npos) end = content.size();
+
+    RichTextLine line = ParseRichTextLine(content.substr(start, end - start), baseLineHeight);
+    int x = originX;
+    for (size_t i = 0; i < line.runs.size(); i++) {
+      RichTextRun& run = line.runs[i];
+      // The last run's width is never needed
+      int width = i + 1 < line.runs.size() ? measure(run.font, run.text) : 0;
+      positioned.push_back(PositionedRichTextRun{x, y, run.font, std::move(run.text)});
+      x += width;
+    }
+    y += line.lineHeight;
+    start = end + 1;
+  }
+  return positioned;
+}
+
+void EncodeRichTextEscPos(std::string_view content, EscPosEncoder* encoder) {
+  static constexpr uint8_t kLineEnd[] = {0x0D, 0x0A};
+  EscPosFontStyle current;
+
+  size_t start = 0;
+  while (start < content.size()) {
+    size_t end = content.find('\n', start);
+    if (end == std::string_view::npos) end = content.size();
+    std::string_view line = content.substr(start, end - start);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+    // Line height is left to the printer, which grows lines for large text
+    for (const RichTextRun& run : ParseRichTextLine(line, 0).runs) {
+      const EscPosFontStyle style = EscPosStyleFor(run.font);
+      SwitchEscPosStyle(current, style, encoder);
+      current = style;
+      encoder->Raw(reinterpret_cast<const uint8_t*>(run.text.data()), run.text.size());
+    }
+    encoder->Raw(kLineEnd, sizeof(kLineEnd));
+    start = end + 1;
+  }
+  SwitchEscPosStyle(current, EscPosFontStyle(), encoder);
+}
+
+bool IsReceiptPrinter(std::string_view driverName, int paperWidth) {
+  std::string name(driverName);
+  for (char& c : name) {
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+  if (ContainsAny(name, kLabelDrivers.data(), kLabelDrivers.data() + kLabelDrivers.size())) {
+    return false;
+  }
+  // 80 mm rolls measure up to 82 mm across
+  if (paperWidth > 0 && paperWidth <= 820) return true;
+  return HasPosWord(name) ||
+         ContainsAny(name, kReceiptDrivers.data(), kReceiptDrivers.data() + kReceiptDrivers.size());
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,83 @@
+#ifndef FLUTTER_PLUGIN_RICH_TEXT_H_
+#define FLUTTER_PLUGIN_RICH_TEXT_H_
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace windows_printer {
+
+class EscPosEncoder;
+
+/// Font selected for a run of rich text markup
+enum class RichTextFont {
+  kNormal = 0,
+  kBold,
+  kItalic,
+  kBoldItalic,
+  /// Large text is always bold
+  kLarge,
+  kCount
+};
+
+/// A run of text printed with one font
+struct RichTextRun {
+  std::string text;
+  RichTextFont font = RichTextFont::kNormal;
+};
+
+/// One parsed line of markup
+struct RichTextLine {
+  std::vector<RichTextRun> runs;
+  /// Height of the line; grows by half for every ## that opens large text
+  int lineHeight = 0;
+};
+
+/// A run placed on the page by LayoutRichText
+struct PositionedRichTextRun {
+  int x = 0;
+  int y = 0;
+  RichTextFont font = RichTextFont::kNormal;
+  std::string text;
+};
+
+/// Returns the advance width of text printed in the given font
+using RichTextMeasure = std::function<int(RichTextFont font, std::string_view text)>;
+
+/// Parse one line of `**bold**`, `*italic*` and `##large##` markup. Style
+/// state does not carry over between lines.
+RichTextLine ParseRichTextLine(std::string_view line, int baseLineHeight);
+
+/// How rich text reaches the printer
+enum class RichTextMode {
+  /// ESC/POS for receipt printers (see IsReceiptPrinter), GDI otherwise
+  kAuto = 0,
+  /// Rasterized through the printer driver
+  kGdi,
+  /// Printer-resident fonts driven by ESC/POS text commands
+  kEscPos,
+};
+
+/// Split content into lines and place every run. Lines start at originX and
+/// advance downwards from originY by their (possibly enlarged) line height.
+std::vector<PositionedRichTextRun> LayoutRichText(std::string_view content,
+                                                  int originX, int originY,
+                                                  int baseLineHeight,
+                                                  const RichTextMeasure& measure);
+
+/// Append markup as ESC/POS text commands. Bold is emphasized, italic (which
+/// receipt printer fonts lack) is underlined and large text is emphasized at
+/// double width and height. Style commands are only sent when the style
+/// changes, and the style is back to normal at the end.
+void EncodeRichTextEscPos(std::string_view content, EscPosEncoder* encoder);
+
+/// Whether a printer queue looks like an ESC/POS receipt printer: paper at
+/// most 80 mm wide (paperWidth in tenths of a millimetre, 0 if unknown) or a
+/// driver of a known receipt printer family. Label printer drivers, which
+/// take their own command languages, never match.
+bool IsReceiptPrinter(std::string_view driverName, int paperWidth);
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_RICH_TEXT_H_
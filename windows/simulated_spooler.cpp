@@ -0,0 +1,264 @@
+#include "simulated_spooler.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace windows_printer {
+
+namespace {
+
+thread_local uint32_t lastError = 0;
+
+bool Fail(uint32_t error) {
+  lastError = error;
+  return false;
+}
+
+// Time the printer takes for bytes
+std::chrono::nanoseconds PrintTime(uint64_t bytes, uint64_t bytesPerSecond) {
+  return std::chrono::nanoseconds(static_cast<int64_t>(
+      static_cast<double>(bytes) * 1e9 / static_cast<double>(bytesPerSecond)));
+}
+
+}  // namespace
+
+SimulatedSpooler::SimulatedSpooler(uint32_t seed) : random_(seed) {}
+
+void SimulatedSpooler::AddPrinter(const std::string& printerName,
+                                  const SimulatedPrinterOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto printer = std::make_unique<Printer>();
+  printer->name = printerName;
+  printer->options = options;
+  printers_.push_back(std::move(printer));
+}
+
+uint64_t SimulatedSpooler::CompletedJobCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return completedJobs_;
+}
+
+uint64_t SimulatedSpooler::FailedJobCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return failedJobs_;
+}
+
+size_t SimulatedSpooler::QueuedJobCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const Clock::time_point now = Clock::now();
+  size_t count = 0;
+  for (const auto& printer : printers_) {
+    count += static_cast<size_t>(
+        std::count_if(printer->queue.begin(), printer->queue.end(),
+                      [now](const QueuedEntry& entry) {
+                        return !entry.ended || entry.printedAt > now;
+                      }));
+  }
+  return count;
+}
+
+size_t SimulatedSpooler::OpenHandleCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return handles_.size();
+}
+
+bool SimulatedSpooler::DefaultPrinterName(std::string* name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (printers_.empty()) return Fail(kErrorNoDefaultPrinter);
+  *name = printers_.front()->name;
+  return true;
+}
+
+bool SimulatedSpooler::Open(const std::string& printerName, PrinterHandle* handle) {
+  Printer* printer = FindPrinter(printerName);
+  if (!printer) return Fail(kErrorInvalidPrinterName);
+  std::this_thread::sleep_for(printer->options.latency);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uintptr_t key = nextHandle_++;
+  handles_[key].printer = printer;
+  *handle = reinterpret_cast<PrinterHandle>(key);
+  return true;
+}
+
+uint32_t SimulatedSpooler::StartDocument(PrinterHandle handle, const RawDocInfo&) {
+  Printer* printer = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    OpenHandle* open = FindHandle(handle);
+    if (!open || open->jobId != 0) {
+      Fail(kErrorInvalidHandle);
+      return 0;
+    }
+    printer = open->printer;
+  }
+  std::this_thread::sleep_for(printer->options.latency);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  OpenHandle* open = FindHandle(handle);
+  if (!open) {
+    Fail(kErrorInvalidHandle);
+    return 0;
+  }
+  if (printer->options.failureRate > 0.0 &&
+      std::uniform_real_distribution<double>(0.0, 1.0)(random_) < printer->options.failureRate) {
+    failedJobs_++;
+    Fail(kErrorNotReady);
+    return 0;
+  }
+  // Keeps the queue to the jobs still printing
+  DropPrinted(*printer, Clock::now());
+  open->jobId = nextJobId_++;
+  QueuedEntry entry;
+  entry.jobId = open->jobId;
+  printer->queue.push_back(entry);
+  return open->jobId;
+}
+
+bool SimulatedSpooler::StartPage(PrinterHandle handle) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  OpenHandle* open = FindHandle(handle);
+  return open && open->jobId != 0 ? true : Fail(kErrorInvalidHandle);
+}
+
+bool SimulatedSpooler::Write(PrinterHandle handle, const uint8_t*, uint32_t size,
+                             uint32_t* bytesWritten) {
+  Printer* printer = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    OpenHandle* open = FindHandle(handle);
+    if (!open || open->jobId == 0) return Fail(kErrorInvalidHandle);
+    printer = open->printer;
+  }
+
+  const SimulatedPrinterOptions& options = printer->options;
+  if (options.bytesPerSecond == 0) {
+    *bytesWritten = size;
+    return true;
+  }
+  const size_t bufferSize = options.bufferSize > 0 ? options.bufferSize : size;
+  const uint32_t accepted = static_cast<uint32_t>(std::min<size_t>(size, bufferSize));
+
+  std::lock_guard<std::mutex> port(printer->port);
+  Clock::time_point now = Clock::now();
+  printer->idleAt = std::max(printer->idleAt, now);
+  // Wait until the unprinted bytes leave room for this chunk
+  const Clock::time_point roomAt =
+      printer->idleAt - PrintTime(bufferSize - accepted, options.bytesPerSecond);
+  if (roomAt > now) {
+    std::this_thread::sleep_until(roomAt);
+  }
+  printer->idleAt += PrintTime(accepted, options.bytesPerSecond);
+  *bytesWritten = accepted;
+  return true;
+}
+
+bool SimulatedSpooler::EndPage(PrinterHandle handle) {
+  return StartPage(handle);
+}
+
+bool SimulatedSpooler::EndDocument(PrinterHandle handle) {
+  Printer* printer = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    OpenHandle* open = FindHandle(handle);
+    if (!open || open->jobId == 0) return Fail(kErrorInvalidHandle);
+    printer = open->printer;
+  }
+  Clock::time_point printedAt;
+  {
+    std::lock_guard<std::mutex> port(printer->port);
+    printedAt = std::max(printer->idleAt, Clock::now());
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  OpenHandle* open = FindHandle(handle);
+  if (!open) return Fail(kErrorInvalidHandle);
+  for (QueuedEntry& entry : printer->queue) {
+    if (entry.jobId == open->jobId) {
+      entry.ended = true;
+      entry.printedAt = printedAt;
+    }
+  }
+  open->jobId = 0;
+  completedJobs_++;
+  return true;
+}
+
+bool SimulatedSpooler::Close(PrinterHandle handle) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  OpenHandle* open = FindHandle(handle);
+  if (!open) return Fail(kErrorInvalidHandle);
+  if (open->jobId != 0) {
+    // Closed without EndDocument: the spooler deletes the job
+    auto& queue = open->printer->queue;
+    const uint32_t jobId = open->jobId;
+    queue.erase(std::remove_if(queue.begin(), queue.end(),
+                               [jobId](const QueuedEntry& entry) { return entry.jobId == jobId; }),
+                queue.end());
+  }
+  handles_.erase(reinterpret_cast<uintptr_t>(handle));
+  return true;
+}
+
+bool SimulatedSpooler::SetJobCopies(PrinterHandle, uint32_t, uint32_t) {
+  // Like a receipt printer taking RAW data: copies are sent as data
+  return false;
+}
+
+bool SimulatedSpooler::CancelJob(const std::string& printerName, uint32_t jobId) {
+  Printer* printer = FindPrinter(printerName);
+  if (!printer) return Fail(kErrorInvalidPrinterName);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& queue = printer->queue;
+  queue.erase(std::remove_if(queue.begin(), queue.end(),
+                             [jobId](const QueuedEntry& entry) { return entry.jobId == jobId; }),
+              queue.end());
+  return true;
+}
+
+bool SimulatedSpooler::EnumerateJobs(const std::string& printerName,
+                                     std::vector<QueuedJob>* jobs) {
+  Printer* printer = FindPrinter(printerName);
+  if (!printer) return Fail(kErrorInvalidPrinterName);
+  std::lock_guard<std::mutex> lock(mutex_);
+  const Clock::time_point now = Clock::now();
+  DropPrinted(*printer, now);
+  jobs->clear();
+  for (const QueuedEntry& entry : printer->queue) {
+    if (entry.ended && entry.printedAt <= now) continue;
+    QueuedJob job;
+    job.jobId = entry.jobId;
+    job.status = entry.ended ? kJobStatusPrinting : kJobStatusSpooling;
+    jobs->push_back(job);
+  }
+  return true;
+}
+
+uint32_t SimulatedSpooler::LastError() const {
+  return lastError;
+}
+
+SimulatedSpooler::Printer* SimulatedSpooler::FindPrinter(const std::string& printerName) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string name = printerName;
+  if (name.empty() && !printers_.empty()) name = printers_.front()->name;
+  for (const auto& printer : printers_) {
+    if (printer->name == name) return printer.get();
+  }
+  return nullptr;
+}
+
+SimulatedSpooler::OpenHandle* SimulatedSpooler::FindHandle(PrinterHandle handle) {
+  auto iter = handles_.find(reinterpret_cast<uintptr_t>(handle));
+  return iter == handles_.end() ? nullptr : &iter->second;
+}
+
+void SimulatedSpooler::DropPrinted(Printer& printer, Clock::time_point now) {
+  while (!printer.queue.empty() && printer.queue.front().ended &&
+         printer.queue.front().printedAt <= now) {
+    printer.queue.pop_front();
+  }
+}
+
+}  // namespace windows_printer
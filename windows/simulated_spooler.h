@@ -0,0 +1,122 @@
+#ifndef FLUTTER_PLUGIN_SIMULATED_SPOOLER_H_
+#define FLUTTER_PLUGIN_SIMULATED_SPOOLER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "spooler_backend.h"
+
+namespace windows_printer {
+
+struct SimulatedPrinterOptions {
+  /// Print speed; 0 prints instantly
+  uint64_t bytesPerSecond = 20000;
+  /// Unprinted bytes the printer holds. Write blocks while it is full, the
+  /// way a USB or network printer stops reading.
+  size_t bufferSize = 4096;
+  /// Round trip added to Open and StartDocument
+  std::chrono::microseconds latency{0};
+  /// Chance that StartDocument fails with kErrorNotReady, as for a printer
+  /// that is offline or out of paper
+  double failureRate = 0.0;
+};
+
+// SpoolerBackend whose printers take time to print. Every printer prints the
+// bytes it accepted in order at its own speed, on a virtual clock: nothing
+// runs in the background, a Write just sleeps until the printer's buffer has
+// room. A job is queued from StartDocument until its last byte has printed,
+// then EnumerateJobs stops listing it. Job data is not kept, so it can run
+// for hours. Used by the load generator and its tests.
+class SimulatedSpooler : public SpoolerBackend {
+public:
+  /// Win32 ERROR_NOT_READY
+  static constexpr uint32_t kErrorNotReady = 21;
+  static constexpr uint32_t kErrorInvalidHandle = 6;
+  static constexpr uint32_t kErrorInvalidPrinterName = 1801;
+  static constexpr uint32_t kErrorNoDefaultPrinter = 1814;
+
+  /// seed makes failures repeatable
+  explicit SimulatedSpooler(uint32_t seed = 1);
+
+  /// The first printer added is the default
+  void AddPrinter(const std::string& printerName,
+                  const SimulatedPrinterOptions& options = SimulatedPrinterOptions());
+
+  /// Jobs that reached EndDocument
+  uint64_t CompletedJobCount() const;
+
+  /// StartDocument calls failed through failureRate
+  uint64_t FailedJobCount() const;
+
+  /// Jobs listed by EnumerateJobs right now, over all printers
+  size_t QueuedJobCount() const;
+
+  size_t OpenHandleCount() const;
+
+  bool DefaultPrinterName(std::string* name) override;
+  bool Open(const std::string& printerName, PrinterHandle* handle) override;
+  uint32_t StartDocument(PrinterHandle handle, const RawDocInfo& docInfo) override;
+  bool StartPage(PrinterHandle handle) override;
+  bool Write(PrinterHandle handle, const uint8_t* data, uint32_t size,
+             uint32_t* bytesWritten) override;
+  bool EndPage(PrinterHandle handle) override;
+  bool EndDocument(PrinterHandle handle) override;
+  bool Close(PrinterHandle handle) override;
+  bool SetJobCopies(PrinterHandle handle, uint32_t jobId, uint32_t copies) override;
+  bool CancelJob(const std::string& printerName, uint32_t jobId) override;
+  bool EnumerateJobs(const std::string& printerName, std::vector<QueuedJob>* jobs) override;
+  uint32_t LastError() const override;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct QueuedEntry {
+    uint32_t jobId = 0;
+    /// Unset while data is still arriving
+    bool ended = false;
+    Clock::time_point printedAt;
+  };
+
+  struct Printer {
+    std::string name;
+    SimulatedPrinterOptions options;
+    /// Held by a Write for as long as it waits for buffer space, so writers
+    /// to one printer queue up like on a port
+    std::mutex port;
+    /// When every byte accepted so far will have printed; guarded by port
+    Clock::time_point idleAt;
+    /// Guarded by the spooler mutex_
+    std::deque<QueuedEntry> queue;
+  };
+
+  struct OpenHandle {
+    Printer* printer = nullptr;
+    uint32_t jobId = 0;
+  };
+
+  Printer* FindPrinter(const std::string& printerName);
+  // Both need mutex_ held
+  OpenHandle* FindHandle(PrinterHandle handle);
+  void DropPrinted(Printer& printer, Clock::time_point now);
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Printer>> printers_;
+  std::map<uintptr_t, OpenHandle> handles_;
+  uintptr_t nextHandle_ = 1;
+  uint32_t nextJobId_ = 1;
+  uint64_t completedJobs_ = 0;
+  uint64_t failedJobs_ = 0;
+  std::mt19937 random_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_SIMULATED_SPOOLER_H_
@@ -0,0 +1,91 @@
+#ifndef FLUTTER_PLUGIN_SPOOLER_BACKEND_H_
+#define FLUTTER_PLUGIN_SPOOLER_BACKEND_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace windows_printer {
+
+/// Opaque printer handle owned by a SpoolerBackend
+using PrinterHandle = void*;
+
+/// Document information passed to StartDocument
+struct RawDocInfo {
+  std::string documentName;
+  /// Spooler data type, "RAW" or "TEXT"
+  std::string datatype;
+};
+
+/// Job status bits reported by EnumerateJobs, the JOB_STATUS_* values of the
+/// Win32 spooler
+constexpr uint32_t kJobStatusPaused = 0x1;
+constexpr uint32_t kJobStatusError = 0x2;
+constexpr uint32_t kJobStatusDeleting = 0x4;
+constexpr uint32_t kJobStatusSpooling = 0x8;
+constexpr uint32_t kJobStatusPrinting = 0x10;
+constexpr uint32_t kJobStatusOffline = 0x20;
+constexpr uint32_t kJobStatusPaperOut = 0x40;
+constexpr uint32_t kJobStatusPrinted = 0x80;
+constexpr uint32_t kJobStatusDeleted = 0x100;
+constexpr uint32_t kJobStatusBlockedDevq = 0x200;
+constexpr uint32_t kJobStatusUserIntervention = 0x400;
+constexpr uint32_t kJobStatusRestart = 0x800;
+constexpr uint32_t kJobStatusComplete = 0x1000;
+
+/// A job waiting in a printer's queue, as listed by EnumerateJobs
+struct QueuedJob {
+  uint32_t jobId = 0;
+  /// kJobStatus* bits
+  uint32_t status = 0;
+  uint32_t pagesPrinted = 0;
+  uint32_t totalPages = 0;
+};
+
+// The subset of the Win32 print spooler used to submit raw jobs. Strings are
+// UTF-8. Methods mirror OpenPrinter, StartDocPrinter and friends: they return
+// false (or a zero job id) on failure and leave the reason in LastError().
+class SpoolerBackend {
+public:
+  virtual ~SpoolerBackend() = default;
+
+  /// Name of the default printer
+  virtual bool DefaultPrinterName(std::string* name) = 0;
+
+  virtual bool Open(const std::string& printerName, PrinterHandle* handle) = 0;
+
+  /// Returns the spooler job id, or 0 on failure
+  virtual uint32_t StartDocument(PrinterHandle handle, const RawDocInfo& docInfo) = 0;
+
+  virtual bool StartPage(PrinterHandle handle) = 0;
+
+  virtual bool Write(PrinterHandle handle, const uint8_t* data, uint32_t size,
+                     uint32_t* bytesWritten) = 0;
+
+  virtual bool EndPage(PrinterHandle handle) = 0;
+
+  virtual bool EndDocument(PrinterHandle handle) = 0;
+
+  virtual bool Close(PrinterHandle handle) = 0;
+
+  /// Have the spooler print a started job copies times, like SetJob with a
+  /// DEVMODE copy count. Returns false when the printer does not make copies
+  /// itself, in which case the caller has to send the data once per copy.
+  virtual bool SetJobCopies(PrinterHandle handle, uint32_t jobId, uint32_t copies) = 0;
+
+  /// Cancel and delete a job, like SetJob with JOB_CONTROL_DELETE. Opens its
+  /// own handle so it can be called while another thread is blocked in a call
+  /// for the same job.
+  virtual bool CancelJob(const std::string& printerName, uint32_t jobId) = 0;
+
+  /// Jobs in a printer's queue, like EnumJobs with JOB_INFO_1. The spooler
+  /// drops a job from the queue once it has printed or been deleted.
+  virtual bool EnumerateJobs(const std::string& printerName, std::vector<QueuedJob>* jobs) = 0;
+
+  /// Error code of the last failed call on this thread
+  virtual uint32_t LastError() const = 0;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_SPOOLER_BACKEND_H_
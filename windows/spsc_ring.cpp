@@ -0,0 +1,91 @@
+#include "spsc_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace windows_printer {
+
+namespace {
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 64;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+}  // namespace
+
+SpscRing::SpscRing(size_t capacity)
+    : buffer_(new uint8_t[RoundUpToPowerOfTwo(capacity)]),
+      mask_(RoundUpToPowerOfTwo(capacity) - 1) {}
+
+size_t SpscRing::Size() const {
+  // Tail first: head only grows, so the difference never goes negative
+  uint64_t tail = tail_.load(std::memory_order_acquire);
+  uint64_t head = head_.load(std::memory_order_acquire);
+  return static_cast<size_t>(head - tail);
+}
+
+size_t SpscRing::WritableRegion(uint8_t** region) {
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  size_t free = Capacity() - static_cast<size_t>(head - cachedTail_);
+  if (free == 0) {
+    cachedTail_ = tail_.load(std::memory_order_acquire);
+    free = Capacity() - static_cast<size_t>(head - cachedTail_);
+  }
+  const size_t offset = static_cast<size_t>(head) & mask_;
+  *region = buffer_.get() + offset;
+  return std::min(free, Capacity() - offset);
+}
+
+void SpscRing::Commit(size_t size) {
+  head_.store(head_.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+size_t SpscRing::Write(const uint8_t* data, size_t size) {
+  size_t written = 0;
+  while (written < size) {
+    uint8_t* region = nullptr;
+    size_t available = WritableRegion(&region);
+    if (available == 0) break;
+    size_t chunk = std::min(available, size - written);
+    std::memcpy(region, data + written, chunk);
+    Commit(chunk);
+    written += chunk;
+  }
+  return written;
+}
+
+size_t SpscRing::ReadableRegion(const uint8_t** region) {
+  const uint64_t tail = tail_.load(std::memory_order_relaxed);
+  size_t used = static_cast<size_t>(cachedHead_ - tail);
+  if (used == 0) {
+    cachedHead_ = head_.load(std::memory_order_acquire);
+    used = static_cast<size_t>(cachedHead_ - tail);
+  }
+  const size_t offset = static_cast<size_t>(tail) & mask_;
+  *region = buffer_.get() + offset;
+  return std::min(used, Capacity() - offset);
+}
+
+void SpscRing::Release(size_t size) {
+  tail_.store(tail_.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+size_t SpscRing::Read(uint8_t* data, size_t size) {
+  size_t read = 0;
+  while (read < size) {
+    const uint8_t* region = nullptr;
+    size_t available = ReadableRegion(&region);
+    if (available == 0) break;
+    size_t chunk = std::min(available, size - read);
+    std::memcpy(data + read, region, chunk);
+    Release(chunk);
+    read += chunk;
+  }
+  return read;
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,81 @@
+#ifndef FLUTTER_PLUGIN_SPSC_RING_H_
+#define FLUTTER_PLUGIN_SPSC_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace windows_printer {
+
+// Lock-free single-producer, single-consumer byte ring. One thread writes
+// and one thread reads; neither ever waits for the other. The producer can
+// fill the ring in place through WritableRegion/Commit, which is how memory
+// shared with Dart is written without a copy.
+//
+// Positions are free-running 64-bit byte counts, so full and empty are told
+// apart without a spare slot. Each side keeps a cached copy of the other
+// side's position and reloads it only when the cache says the ring is full
+// (or empty), which keeps the shared cache lines quiet under load.
+class SpscRing {
+public:
+  /// Capacity is rounded up to a power of two, at least 64 bytes
+  explicit SpscRing(size_t capacity);
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  size_t Capacity() const { return mask_ + 1; }
+
+  /// Bytes committed and not yet released. Exact on either side's own
+  /// thread when the other is idle; a snapshot otherwise.
+  size_t Size() const;
+
+  // Producer side.
+
+  /// Contiguous free space at the write position. May be less than the free
+  /// space in total when it wraps; commit and call again for the rest.
+  size_t WritableRegion(uint8_t** region);
+
+  /// Publish size bytes written into the writable region
+  void Commit(size_t size);
+
+  /// Copy as much of data as fits, wrapping as needed. Returns the bytes
+  /// written.
+  size_t Write(const uint8_t* data, size_t size);
+
+  // Consumer side.
+
+  /// Contiguous committed bytes at the read position
+  size_t ReadableRegion(const uint8_t** region);
+
+  /// Hand size bytes of the readable region back to the producer
+  void Release(size_t size);
+
+  /// Copy up to size committed bytes out. Returns the bytes read.
+  size_t Read(uint8_t* data, size_t size);
+
+private:
+  // Explicit padding rather than alignas, which MSVC warns about at /W4
+  static constexpr size_t kCacheLine = 64;
+
+  std::unique_ptr<uint8_t[]> buffer_;
+  size_t mask_;
+  [[maybe_unused]] char padding0_[kCacheLine];
+
+  // Written by the producer, read by the consumer
+  std::atomic<uint64_t> head_{0};
+  // Producer-only
+  uint64_t cachedTail_ = 0;
+  [[maybe_unused]] char padding1_[kCacheLine];
+
+  // Written by the consumer, read by the producer
+  std::atomic<uint64_t> tail_{0};
+  // Consumer-only
+  uint64_t cachedHead_ = 0;
+  [[maybe_unused]] char padding2_[kCacheLine];
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_SPSC_RING_H_
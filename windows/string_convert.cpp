@@ -0,0 +1,241 @@
+#include "string_convert.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WINDOWS_PRINTER_HAS_SSE2 1
+#endif
+
+namespace windows_printer {
+
+namespace {
+
+constexpr char32_t kReplacementCharacter = 0xFFFD;
+
+bool IsContinuation(uint8_t byte) {
+  return (byte & 0xC0) == 0x80;
+}
+
+// Widens the ASCII run at the start of utf8 into out and returns its length.
+// Whole blocks are converted while they are pure ASCII; the caller decodes
+// whatever follows one code point at a time.
+template <typename Char16>
+size_t WidenAscii(const char* utf8, size_t size, Char16* out) {
+  size_t pos = 0;
+#ifdef WINDOWS_PRINTER_HAS_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  while (pos + 16 <= size) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8 + pos));
+    if (_mm_movemask_epi8(bytes) != 0) break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + pos), _mm_unpacklo_epi8(bytes, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + pos + 8), _mm_unpackhi_epi8(bytes, zero));
+    pos += 16;
+  }
+#else
+  while (pos + 8 <= size) {
+    uint64_t word;
+    std::memcpy(&word, utf8 + pos, sizeof(word));
+    if ((word & 0x8080808080808080ULL) != 0) break;
+    for (size_t i = 0; i < 8; i++) {
+      out[pos + i] = static_cast<Char16>(utf8[pos + i]);
+    }
+    pos += 8;
+  }
+#endif
+  while (pos < size && static_cast<uint8_t>(utf8[pos]) < 0x80) {
+    out[pos] = static_cast<Char16>(utf8[pos]);
+    pos++;
+  }
+  return pos;
+}
+
+// Narrows the ASCII run at the start of utf16 into out and returns its length
+template <typename Char16>
+size_t NarrowAscii(const Char16* utf16, size_t size, char* out) {
+  size_t pos = 0;
+#ifdef WINDOWS_PRINTER_HAS_SSE2
+  const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  while (pos + 16 <= size) {
+    const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16 + pos));
+    const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16 + pos + 8));
+    const __m128i highBits = _mm_and_si128(_mm_or_si128(low, high), nonAscii);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(highBits, zero)) != 0xFFFF) break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + pos), _mm_packus_epi16(low, high));
+    pos += 16;
+  }
+#else
+  while (pos + 4 <= size) {
+    uint64_t word;
+    std::memcpy(&word, utf16 + pos, sizeof(word));
+    if ((word & 0xFF80FF80FF80FF80ULL) != 0) break;
+    for (size_t i = 0; i < 4; i++) {
+      out[pos + i] = static_cast<char>(utf16[pos + i]);
+    }
+    pos += 4;
+  }
+#endif
+  while (pos < size && static_cast<uint16_t>(utf16[pos]) < 0x80) {
+    out[pos] = static_cast<char>(utf16[pos]);
+    pos++;
+  }
+  return pos;
+}
+
+// Decodes one code point starting at utf8[*pos] and advances *pos past it.
+// A malformed sequence yields U+FFFD and consumes its maximal valid prefix.
+char32_t DecodeUtf8(std::string_view utf8, size_t* pos) {
+  const size_t size = utf8.size();
+  uint8_t lead = static_cast<uint8_t>(utf8[*pos]);
+  (*pos)++;
+
+  if (lead < 0x80) return lead;
+
+  int length;
+  char32_t codePoint;
+  char32_t minimum;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    length = 2;
+    codePoint = lead & 0x1F;
+    minimum = 0x80;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    length = 3;
+    codePoint = lead & 0x0F;
+    minimum = 0x800;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    length = 4;
+    codePoint = lead & 0x07;
+    minimum = 0x10000;
+  } else {
+    return kReplacementCharacter;
+  }
+
+  for (int i = 1; i < length; i++) {
+    if (*pos >= size || !IsContinuation(static_cast<uint8_t>(utf8[*pos]))) {
+      return kReplacementCharacter;
+    }
+    codePoint = (codePoint << 6) | (static_cast<uint8_t>(utf8[*pos]) & 0x3F);
+    (*pos)++;
+  }
+
+  if (codePoint < minimum || codePoint > 0x10FFFF ||
+      (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+    return kReplacementCharacter;
+  }
+  return codePoint;
+}
+
+// Writes codePoint as UTF-8 to out and returns the number of bytes written
+size_t EncodeUtf8(char32_t codePoint, char* out) {
+  if (codePoint < 0x80) {
+    out[0] = static_cast<char>(codePoint);
+    return 1;
+  }
+  if (codePoint < 0x800) {
+    out[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+    out[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+    return 2;
+  }
+  if (codePoint < 0x10000) {
+    out[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+    out[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+    out[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+    return 3;
+  }
+  out[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+  out[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+  out[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+  out[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+  return 4;
+}
+
+}  // namespace
+
+template <typename Char16>
+size_t Utf8ToUtf16(std::string_view utf8, Char16* out) {
+  static_assert(sizeof(Char16) == 2, "UTF-16 code units must be 16 bits wide");
+
+  size_t written = 0;
+  size_t pos = 0;
+  while (pos < utf8.size()) {
+    if (static_cast<uint8_t>(utf8[pos]) < 0x80) {
+      // One byte per code unit while the text is ASCII
+      const size_t ascii = WidenAscii(utf8.data() + pos, utf8.size() - pos, out + written);
+      pos += ascii;
+      written += ascii;
+      continue;
+    }
+
+    char32_t codePoint = DecodeUtf8(utf8, &pos);
+    if (codePoint < 0x10000) {
+      out[written++] = static_cast<Char16>(codePoint);
+    } else {
+      codePoint -= 0x10000;
+      out[written++] = static_cast<Char16>(0xD800 + (codePoint >> 10));
+      out[written++] = static_cast<Char16>(0xDC00 + (codePoint & 0x3FF));
+    }
+  }
+  return written;
+}
+
+template <typename Char16>
+size_t Utf16ToUtf8(std::basic_string_view<Char16> utf16, char* out) {
+  static_assert(sizeof(Char16) == 2, "UTF-16 code units must be 16 bits wide");
+
+  size_t written = 0;
+  size_t i = 0;
+  while (i < utf16.size()) {
+    if (static_cast<uint16_t>(utf16[i]) < 0x80) {
+      const size_t ascii = NarrowAscii(utf16.data() + i, utf16.size() - i, out + written);
+      i += ascii;
+      written += ascii;
+      continue;
+    }
+
+    char32_t unit = static_cast<uint16_t>(utf16[i]);
+    if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < utf16.size()) {
+      char32_t low = static_cast<uint16_t>(utf16[i + 1]);
+      if (low >= 0xDC00 && low <= 0xDFFF) {
+        written += EncodeUtf8(0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00), out + written);
+        i += 2;
+        continue;
+      }
+    }
+    if (unit >= 0xD800 && unit <= 0xDFFF) {
+      unit = kReplacementCharacter;
+    }
+    written += EncodeUtf8(unit, out + written);
+    i++;
+  }
+  return written;
+}
+
+template <typename Char16>
+std::basic_string<Char16> Utf8ToUtf16(std::string_view utf8) {
+  // One allocation of the worst case, trimmed to what was written
+  std::basic_string<Char16> utf16(MaxUtf16Length(utf8.size()), Char16());
+  utf16.resize(Utf8ToUtf16(utf8, &utf16[0]));
+  return utf16;
+}
+
+template <typename Char16>
+std::string Utf16ToUtf8(std::basic_string_view<Char16> utf16) {
+  std::string utf8(MaxUtf8Length(utf16.size()), '\0');
+  utf8.resize(Utf16ToUtf8(utf16, &utf8[0]));
+  return utf8;
+}
+
+template std::u16string Utf8ToUtf16<char16_t>(std::string_view);
+template std::string Utf16ToUtf8<char16_t>(std::u16string_view);
+template size_t Utf8ToUtf16<char16_t>(std::string_view, char16_t*);
+template size_t Utf16ToUtf8<char16_t>(std::u16string_view, char*);
+#if WCHAR_MAX == 0xFFFF
+template std::wstring Utf8ToUtf16<wchar_t>(std::string_view);
+template std::string Utf16ToUtf8<wchar_t>(std::wstring_view);
+template size_t Utf8ToUtf16<wchar_t>(std::string_view, wchar_t*);
+template size_t Utf16ToUtf8<wchar_t>(std::wstring_view, char*);
+#endif
+
+}  // namespace windows_printer
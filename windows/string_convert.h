@@ -0,0 +1,59 @@
+#ifndef FLUTTER_PLUGIN_STRING_CONVERT_H_
+#define FLUTTER_PLUGIN_STRING_CONVERT_H_
+
+#include <climits>
+#include <cstddef>
+#include <cwchar>
+#include <string>
+#include <string_view>
+
+namespace windows_printer {
+
+// Portable UTF-8 <-> UTF-16 conversion. Char16 is any 16-bit code unit type:
+// char16_t everywhere, and also wchar_t on Windows. Each malformed sequence
+// and each unpaired surrogate is replaced with U+FFFD. ASCII runs are
+// converted 16 characters at a time.
+
+/// Most UTF-16 code units that utf8Length bytes of UTF-8 convert to
+constexpr size_t MaxUtf16Length(size_t utf8Length) {
+  return utf8Length;
+}
+
+/// Most UTF-8 bytes that utf16Length code units of UTF-16 convert to
+constexpr size_t MaxUtf8Length(size_t utf16Length) {
+  return utf16Length * 3;
+}
+
+/// Convert UTF-8 to UTF-16
+template <typename Char16>
+std::basic_string<Char16> Utf8ToUtf16(std::string_view utf8);
+
+/// Convert UTF-16 to UTF-8
+template <typename Char16>
+std::string Utf16ToUtf8(std::basic_string_view<Char16> utf16);
+
+/// Convert UTF-8 into a caller's buffer of at least MaxUtf16Length(utf8.size())
+/// code units, without allocating. Returns the number of code units written.
+template <typename Char16>
+size_t Utf8ToUtf16(std::string_view utf8, Char16* out);
+
+/// Convert UTF-16 into a caller's buffer of at least
+/// MaxUtf8Length(utf16.size()) bytes, without allocating. Returns the number
+/// of bytes written.
+template <typename Char16>
+size_t Utf16ToUtf8(std::basic_string_view<Char16> utf16, char* out);
+
+extern template std::u16string Utf8ToUtf16<char16_t>(std::string_view);
+extern template std::string Utf16ToUtf8<char16_t>(std::u16string_view);
+extern template size_t Utf8ToUtf16<char16_t>(std::string_view, char16_t*);
+extern template size_t Utf16ToUtf8<char16_t>(std::u16string_view, char*);
+#if WCHAR_MAX == 0xFFFF
+extern template std::wstring Utf8ToUtf16<wchar_t>(std::string_view);
+extern template std::string Utf16ToUtf8<wchar_t>(std::wstring_view);
+extern template size_t Utf8ToUtf16<wchar_t>(std::string_view, wchar_t*);
+extern template size_t Utf16ToUtf8<wchar_t>(std::wstring_view, char*);
+#endif
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_STRING_CONVERT_H_
@@ -0,0 +1,58 @@
+#include "string_intern.h"
+
+#include <mutex>
+#include <utility>
+
+#include "string_convert.h"
+
+namespace windows_printer {
+
+template <typename Char16>
+Utf16InternTable<Char16>::Utf16InternTable(size_t capacity)
+    : capacity_(capacity > 0 ? capacity : 1) {}
+
+template <typename Char16>
+std::shared_ptr<const typename Utf16InternTable<Char16>::Utf16String>
+Utf16InternTable<Char16>::Intern(std::string_view utf8) {
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = entries_.find(utf8);
+    if (it != entries_.end()) return it->second.utf16;
+  }
+
+  // Converted outside the lock; a racing caller may convert the same string,
+  // and the first one stored wins
+  auto utf16 = std::make_shared<const Utf16String>(Utf8ToUtf16<Char16>(utf8));
+  auto owned = std::make_unique<const std::string>(utf8);
+
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  auto it = entries_.find(utf8);
+  if (it != entries_.end()) return it->second.utf16;
+  if (entries_.size() >= capacity_) {
+    entries_.clear();
+  }
+  const std::string_view key(*owned);
+  Entry& entry = entries_[key];
+  entry.utf8 = std::move(owned);
+  entry.utf16 = std::move(utf16);
+  return entry.utf16;
+}
+
+template <typename Char16>
+size_t Utf16InternTable<Char16>::Size() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return entries_.size();
+}
+
+template <typename Char16>
+void Utf16InternTable<Char16>::Clear() {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  entries_.clear();
+}
+
+template class Utf16InternTable<char16_t>;
+#if WCHAR_MAX == 0xFFFF
+template class Utf16InternTable<wchar_t>;
+#endif
+
+}  // namespace windows_printer
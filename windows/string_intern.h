@@ -0,0 +1,54 @@
+#ifndef FLUTTER_PLUGIN_STRING_INTERN_H_
+#define FLUTTER_PLUGIN_STRING_INTERN_H_
+
+#include <climits>
+#include <cstddef>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace windows_printer {
+
+/// Thread-safe cache of the UTF-16 form of strings that are converted over
+/// and over, such as printer names: each is converted once and later lookups
+/// share the result without converting or allocating.
+template <typename Char16>
+class Utf16InternTable {
+public:
+  using Utf16String = std::basic_string<Char16>;
+
+  /// Holds up to capacity strings; adding one more starts over empty
+  explicit Utf16InternTable(size_t capacity = 256);
+
+  Utf16InternTable(const Utf16InternTable&) = delete;
+  Utf16InternTable& operator=(const Utf16InternTable&) = delete;
+
+  /// The UTF-16 form of utf8. It stays valid for as long as it is held, also
+  /// after the table starts over or is cleared.
+  std::shared_ptr<const Utf16String> Intern(std::string_view utf8);
+
+  size_t Size() const;
+  void Clear();
+
+private:
+  struct Entry {
+    // Owns the characters the map key points at
+    std::unique_ptr<const std::string> utf8;
+    std::shared_ptr<const Utf16String> utf16;
+  };
+
+  const size_t capacity_;
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<std::string_view, Entry> entries_;
+};
+
+extern template class Utf16InternTable<char16_t>;
+#if WCHAR_MAX == 0xFFFF
+extern template class Utf16InternTable<wchar_t>;
+#endif
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_STRING_INTERN_H_
@@ -0,0 +1,198 @@
+#include "task_pool.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace windows_printer {
+
+struct TaskGroupState {
+  std::atomic<size_t> pending{0};
+  std::atomic<bool> cancelled{false};
+  std::mutex mutex;
+  std::condition_variable done;
+
+  void Finish() {
+    if (pending.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(mutex);
+      done.notify_all();
+    }
+  }
+};
+
+namespace {
+
+constexpr size_t kNoWorker = static_cast<size_t>(-1);
+
+// How long a waiter with nothing to help with sleeps before looking again:
+// its group's last task may be queued behind a task that waits itself
+constexpr std::chrono::milliseconds kWaitPoll{1};
+
+// The pool and worker index of the calling thread, if it is a worker
+thread_local const TaskPool* currentPool = nullptr;
+thread_local size_t currentWorker = kNoWorker;
+
+}  // namespace
+
+TaskPool::TaskPool(size_t threads) {
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  workers_.reserve(threads);
+  for (size_t i = 0; i < threads; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  // Started once every queue exists, as workers steal from all of them
+  for (size_t i = 0; i < threads; i++) {
+    workers_[i]->thread = std::thread(&TaskPool::RunWorker, this, i);
+  }
+}
+
+TaskPool::~TaskPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+void TaskPool::Submit(std::function<void()> task, TaskPriority priority) {
+  Push(Task{std::move(task), nullptr}, priority);
+}
+
+void TaskPool::Push(Task task, TaskPriority priority) {
+  const size_t index = currentPool == this ? currentWorker
+                                           : nextWorker_.fetch_add(1) % workers_.size();
+  Worker& worker = *workers_[index];
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.queues[static_cast<int>(priority)].push_back(std::move(task));
+  }
+  queued_.fetch_add(1);
+  {
+    // Pairs with the sleeping worker's check, so the wake cannot fall
+    // between its check and its wait
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+  }
+  wake_.notify_one();
+}
+
+bool TaskPool::Take(size_t self, Task* task) {
+  const size_t count = workers_.size();
+  const size_t start = self == kNoWorker ? nextWorker_.load() : self;
+  for (int priority = 0; priority < kTaskPriorities; priority++) {
+    if (self != kNoWorker) {
+      Worker& own = *workers_[self];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      std::deque<Task>& queue = own.queues[priority];
+      if (!queue.empty()) {
+        *task = std::move(queue.back());
+        queue.pop_back();
+        queued_.fetch_sub(1);
+        return true;
+      }
+    }
+    for (size_t k = 0; k < count; k++) {
+      const size_t victim = (start + k) % count;
+      if (victim == self) continue;
+      Worker& other = *workers_[victim];
+      std::lock_guard<std::mutex> lock(other.mutex);
+      std::deque<Task>& queue = other.queues[priority];
+      if (!queue.empty()) {
+        *task = std::move(queue.front());
+        queue.pop_front();
+        queued_.fetch_sub(1);
+        if (self != kNoWorker) stolen_.fetch_add(1);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void TaskPool::Execute(Task& task) {
+  if (task.group && task.group->cancelled.load()) {
+    cancelled_.fetch_add(1);
+  } else {
+    task.run();
+    executed_.fetch_add(1);
+  }
+  // Released before the group hears of it, so a waiter that returns never
+  // races the task's captures being destroyed
+  task.run = nullptr;
+  if (task.group) task.group->Finish();
+}
+
+bool TaskPool::RunPending() {
+  Task task;
+  if (!Take(currentPool == this ? currentWorker : kNoWorker, &task)) return false;
+  Execute(task);
+  return true;
+}
+
+void TaskPool::RunWorker(size_t index) {
+  currentPool = this;
+  currentWorker = index;
+  while (true) {
+    Task task;
+    if (Take(index, &task)) {
+      Execute(task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    wake_.wait(lock, [this] { return stopping_ || queued_.load() > 0; });
+    if (stopping_ && queued_.load() == 0) return;
+  }
+}
+
+TaskPoolStats TaskPool::Stats() const {
+  TaskPoolStats stats;
+  stats.threads = workers_.size();
+  stats.executed = executed_.load();
+  stats.stolen = stolen_.load();
+  stats.cancelled = cancelled_.load();
+  return stats;
+}
+
+TaskGroup::TaskGroup(TaskPool& pool) : pool_(pool), state_(std::make_shared<TaskGroupState>()) {}
+
+TaskGroup::~TaskGroup() { Wait(); }
+
+void TaskGroup::Run(std::function<void()> task, TaskPriority priority) {
+  state_->pending.fetch_add(1);
+  pool_.Push(TaskPool::Task{std::move(task), state_}, priority);
+}
+
+void TaskGroup::Cancel() { state_->cancelled.store(true); }
+
+bool TaskGroup::Cancelled() const { return state_->cancelled.load(); }
+
+bool TaskGroup::Wait() {
+  while (state_->pending.load() > 0) {
+    if (pool_.RunPending()) continue;
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    state_->done.wait_for(lock, kWaitPoll, [this] { return state_->pending.load() == 0; });
+  }
+  return !Cancelled();
+}
+
+void ParallelFor(TaskPool& pool, size_t count, size_t grain,
+                 const std::function<void(size_t begin, size_t end)>& body,
+                 TaskPriority priority) {
+  if (count == 0) return;
+  grain = std::max<size_t>(grain, 1);
+  TaskGroup group(pool);
+  for (size_t begin = grain; begin < count; begin += grain) {
+    const size_t end = std::min(count, begin + grain);
+    group.Run([&body, begin, end] { body(begin, end); }, priority);
+  }
+  body(0, std::min(count, grain));
+  group.Wait();
+}
+
+TaskPool& SharedTaskPool() {
+  static TaskPool* pool = new TaskPool();
+  return *pool;
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,140 @@
+#ifndef FLUTTER_PLUGIN_TASK_POOL_H_
+#define FLUTTER_PLUGIN_TASK_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace windows_printer {
+
+enum class TaskPriority {
+  /// Work someone is waiting on, such as a preview
+  kHigh = 0,
+  kNormal,
+  /// Work ahead of need, such as warming a cache
+  kLow,
+};
+
+constexpr int kTaskPriorities = 3;
+
+struct TaskPoolStats {
+  size_t threads = 0;
+  /// Tasks run, by workers and by threads helping while they wait
+  uint64_t executed = 0;
+  /// Tasks a worker took from another worker's queue
+  uint64_t stolen = 0;
+  /// Tasks dropped unrun because their group was cancelled
+  uint64_t cancelled = 0;
+};
+
+struct TaskGroupState;
+
+// Work-stealing thread pool for CPU-bound print preparation: decoding,
+// scaling and dithering images, encoding and layout. Each worker has a queue
+// per priority. It runs its own newest task first, while that task's data
+// is still in cache, and when it runs dry takes the oldest task from
+// another worker. A higher priority is always taken before a lower one,
+// from any queue. Spooler and socket calls block for as long as the printer
+// likes, so they stay on RunBatch's threads and never run here.
+class TaskPool {
+public:
+  /// threads 0 starts one worker per hardware thread
+  explicit TaskPool(size_t threads = 0);
+  /// Runs the tasks still queued, then joins the workers
+  ~TaskPool();
+
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  size_t Threads() const { return workers_.size(); }
+
+  /// Queue task for a worker: the calling worker's own queue when called
+  /// from one, otherwise each worker's in turn. Tasks must not throw.
+  void Submit(std::function<void()> task, TaskPriority priority = TaskPriority::kNormal);
+
+  /// Run one queued task on the calling thread, the calling worker's own
+  /// first. False when nothing is queued.
+  bool RunPending();
+
+  TaskPoolStats Stats() const;
+
+private:
+  friend class TaskGroup;
+
+  struct Task {
+    std::function<void()> run;
+    std::shared_ptr<TaskGroupState> group;
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> queues[kTaskPriorities];
+    std::thread thread;
+  };
+
+  void Push(Task task, TaskPriority priority);
+  // Own queue of worker self first (none for other threads), then steal
+  bool Take(size_t self, Task* task);
+  void Execute(Task& task);
+  void RunWorker(size_t index);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<size_t> queued_{0};
+  std::atomic<size_t> nextWorker_{0};
+  std::mutex sleepMutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+  std::atomic<uint64_t> executed_{0};
+  std::atomic<uint64_t> stolen_{0};
+  std::atomic<uint64_t> cancelled_{0};
+};
+
+// Tasks waited for and cancelled together. The group must outlive its
+// tasks, which its destructor ensures by waiting.
+class TaskGroup {
+public:
+  explicit TaskGroup(TaskPool& pool);
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  void Run(std::function<void()> task, TaskPriority priority = TaskPriority::kNormal);
+
+  /// Drop the tasks not started yet. Running tasks finish; long ones can
+  /// poll Cancelled to stop early.
+  void Cancel();
+  bool Cancelled() const;
+
+  /// Until every task has run or been dropped. The calling thread runs
+  /// queued tasks meanwhile, so a task can wait for a group of its own
+  /// without starving the pool. False if the group was cancelled.
+  bool Wait();
+
+private:
+  TaskPool& pool_;
+  std::shared_ptr<TaskGroupState> state_;
+};
+
+/// Call body(begin, end) for consecutive ranges of at most grain indices
+/// covering [0, count) on pool, and return once all have finished. The
+/// calling thread takes the first range.
+void ParallelFor(TaskPool& pool, size_t count, size_t grain,
+                 const std::function<void(size_t begin, size_t end)>& body,
+                 TaskPriority priority = TaskPriority::kNormal);
+
+/// The plugin's pool, one worker per hardware thread, started on first
+/// use. It is never destroyed: joining threads while the DLL unloads can
+/// deadlock on the loader lock.
+TaskPool& SharedTaskPool();
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_TASK_POOL_H_
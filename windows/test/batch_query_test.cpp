@@ -0,0 +1,264 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "batch_query.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+struct FakeProperties {
+  std::string name;
+  int status = 0;
+};
+
+// Properties backend with per-printer latency; printers marked as hung block
+// until Release()
+class LatencyBackend {
+public:
+  void SetLatency(const std::string& name, milliseconds latency) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latency_[name] = latency;
+  }
+
+  void Hang(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hung_.push_back(name);
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hung_.clear();
+    changed_.notify_all();
+  }
+
+  FakeProperties Query(const std::string& name) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    active_++;
+    peakActive_ = std::max(peakActive_, active_);
+    const milliseconds latency = latency_[name];
+    lock.unlock();
+    std::this_thread::sleep_for(latency);
+    lock.lock();
+    changed_.wait(lock, [this, &name]() {
+      return std::find(hung_.begin(), hung_.end(), name) == hung_.end();
+    });
+    active_--;
+    finished_++;
+    changed_.notify_all();
+    return FakeProperties{name, static_cast<int>(name.size())};
+  }
+
+  // Wait until calls abandoned by a batch have returned
+  bool WaitForFinished(int count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return changed_.wait_for(lock, milliseconds(5000), [this, count]() { return finished_ >= count; });
+  }
+
+  int PeakActive() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peakActive_;
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::map<std::string, milliseconds> latency_;
+  std::vector<std::string> hung_;
+  int active_ = 0;
+  int peakActive_ = 0;
+  int finished_ = 0;
+};
+
+std::function<FakeProperties(const std::string&)> QueryWith(std::shared_ptr<LatencyBackend> backend) {
+  return [backend](const std::string& name) { return backend->Query(name); };
+}
+
+std::vector<std::string> PrinterNames(int count) {
+  std::vector<std::string> names;
+  for (int i = 0; i < count; i++) {
+    names.push_back("Printer " + std::to_string(i));
+  }
+  return names;
+}
+
+}  // namespace
+
+TEST(BatchQuery, ReturnsResultsInRequestOrder) {
+  auto backend = std::make_shared<LatencyBackend>();
+  backend->SetLatency("Slow", milliseconds(40));
+  const std::vector<std::string> names = {"Slow", "Receipt", "Kitchen Label"};
+
+  auto results = QueryBatch<FakeProperties>(names, QueryWith(backend), BatchOptions{});
+  ASSERT_EQ(results.size(), 3u);
+  for (size_t i = 0; i < names.size(); i++) {
+    EXPECT_EQ(results[i].name, names[i]);
+    EXPECT_EQ(results[i].status, BatchItemStatus::kCompleted);
+    EXPECT_EQ(results[i].value.name, names[i]);
+    EXPECT_EQ(results[i].value.status, static_cast<int>(names[i].size()));
+  }
+  EXPECT_GE(results[0].elapsed, milliseconds(40));
+}
+
+TEST(BatchQuery, BoundsConcurrency) {
+  auto backend = std::make_shared<LatencyBackend>();
+  const std::vector<std::string> names = PrinterNames(12);
+  for (const auto& name : names) {
+    backend->SetLatency(name, milliseconds(20));
+  }
+
+  BatchOptions options;
+  options.maxConcurrency = 3;
+  auto start = std::chrono::steady_clock::now();
+  auto results = QueryBatch<FakeProperties>(names, QueryWith(backend), options);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  for (const auto& result : results) {
+    EXPECT_EQ(result.status, BatchItemStatus::kCompleted);
+  }
+  EXPECT_LE(backend->PeakActive(), 3);
+  EXPECT_GE(backend->PeakActive(), 2);
+  // At most three at a time means at least four rounds
+  EXPECT_GE(elapsed, milliseconds(80));
+}
+
+TEST(BatchQuery, TimesOutUnresponsivePrinterAndKeepsTheRest) {
+  auto backend = std::make_shared<LatencyBackend>();
+  backend->Hang("Offline");
+  const std::vector<std::string> names = {"Receipt", "Offline", "Label"};
+
+  BatchOptions options;
+  options.timeout = milliseconds(100);
+  auto start = std::chrono::steady_clock::now();
+  auto results = QueryBatch<FakeProperties>(names, QueryWith(backend), options);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_EQ(results[0].status, BatchItemStatus::kCompleted);
+  EXPECT_EQ(results[1].status, BatchItemStatus::kTimedOut);
+  EXPECT_EQ(results[1].elapsed, milliseconds(100));
+  EXPECT_TRUE(results[1].value.name.empty());
+  EXPECT_EQ(results[2].status, BatchItemStatus::kCompleted);
+  EXPECT_EQ(results[2].value.name, "Label");
+  EXPECT_GE(elapsed, milliseconds(100));
+  EXPECT_LT(elapsed, milliseconds(2000));
+
+  // The abandoned call finishes after the batch returned
+  backend->Release();
+  EXPECT_TRUE(backend->WaitForFinished(3));
+}
+
+TEST(BatchQuery, ReplacesWorkersStuckPastTheirDeadline) {
+  auto backend = std::make_shared<LatencyBackend>();
+  backend->Hang("Offline 1");
+  backend->Hang("Offline 2");
+  const std::vector<std::string> names = {"Offline 1", "Offline 2", "Receipt"};
+
+  // A single worker would never reach Receipt without replacements
+  BatchOptions options;
+  options.maxConcurrency = 1;
+  options.timeout = milliseconds(50);
+  auto results = QueryBatch<FakeProperties>(names, QueryWith(backend), options);
+
+  EXPECT_EQ(results[0].status, BatchItemStatus::kTimedOut);
+  EXPECT_EQ(results[1].status, BatchItemStatus::kTimedOut);
+  EXPECT_EQ(results[2].status, BatchItemStatus::kCompleted);
+  EXPECT_EQ(results[2].value.name, "Receipt");
+
+  backend->Release();
+  EXPECT_TRUE(backend->WaitForFinished(3));
+}
+
+TEST(BatchQuery, StartsNoWorkersPastTheAbandonedLimit) {
+  // Calls abandoned by earlier tests may still be counted
+  const size_t before = AbandonedWorkerCount();
+  SetAbandonedWorkerLimit(before + 1);
+  auto backend = std::make_shared<LatencyBackend>();
+  backend->Hang("Offline");
+
+  BatchOptions options;
+  options.timeout = milliseconds(20);
+  auto results = QueryBatch<FakeProperties>({"Offline"}, QueryWith(backend), options);
+  EXPECT_EQ(results[0].status, BatchItemStatus::kTimedOut);
+  EXPECT_EQ(AbandonedWorkerCount(), before + 1);
+
+  // Neither a batch, a deadline call nor a detached task gets a thread
+  results = QueryBatch<FakeProperties>({"Receipt", "Kitchen"}, QueryWith(backend), options);
+  EXPECT_EQ(results[0].status, BatchItemStatus::kTimedOut);
+  EXPECT_EQ(results[1].status, BatchItemStatus::kTimedOut);
+  EXPECT_EQ(results[1].elapsed.count(), 0);
+  EXPECT_FALSE(CallWithDeadline<int>([]() { return 1; }, milliseconds(1000)));
+  bool refused = false;
+  RunWithDeadline([]() {}, milliseconds(1000), [&refused](bool completed) { refused = !completed; });
+  EXPECT_TRUE(refused);
+  EXPECT_FALSE(RunAbandoned([]() {}));
+
+  backend->Release();
+  ASSERT_TRUE(backend->WaitForFinished(1));
+  for (int i = 0; i < 500 && AbandonedWorkerCount() > before; i++) {
+    std::this_thread::sleep_for(milliseconds(10));
+  }
+  EXPECT_LE(AbandonedWorkerCount(), before);
+  EXPECT_EQ(CallWithDeadline<int>([]() { return 1; }, milliseconds(1000)), 1);
+  SetAbandonedWorkerLimit(kDefaultAbandonedWorkerLimit);
+}
+
+TEST(BatchQuery, CallsBackWithResultOrTimeoutWithoutWaiting) {
+  auto backend = std::make_shared<LatencyBackend>();
+  backend->Hang("Offline");
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<std::optional<int>> results;
+  auto record = [&](std::optional<int> result) {
+    std::lock_guard<std::mutex> lock(mutex);
+    results.push_back(result);
+    changed.notify_all();
+  };
+
+  const size_t before = AbandonedWorkerCount();
+  CallWithDeadlineAsync<int>([backend]() { return backend->Query("Offline").status; },
+                             milliseconds(50), record);
+  CallWithDeadlineAsync<int>([backend]() { return backend->Query("Receipt").status; },
+                             milliseconds(5000), record);
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(changed.wait_for(lock, milliseconds(5000), [&]() { return results.size() == 2; }));
+    // The printer that answers is reported first, the hung one at its deadline
+    EXPECT_EQ(results[0], 7);
+    EXPECT_FALSE(results[1]);
+  }
+  EXPECT_GE(AbandonedWorkerCount(), before + 1);
+
+  // The abandoned call does not report again once it returns
+  backend->Release();
+  ASSERT_TRUE(backend->WaitForFinished(2));
+  for (int i = 0; i < 500 && AbandonedWorkerCount() > before; i++) {
+    std::this_thread::sleep_for(milliseconds(10));
+  }
+  EXPECT_LE(AbandonedWorkerCount(), before);
+  std::lock_guard<std::mutex> lock(mutex);
+  EXPECT_EQ(results.size(), 2u);
+}
+
+TEST(BatchQuery, HandlesEmptyBatch) {
+  bool called = false;
+  std::vector<BatchItemOutcome> outcomes = RunBatch(
+      0, [&called](size_t) { called = true; }, BatchOptions{});
+  EXPECT_TRUE(outcomes.empty());
+  EXPECT_FALSE(called);
+}
+
+}  // namespace test
+}  // namespace windows_printer
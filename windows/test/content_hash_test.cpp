@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "content_hash.h"
+#include "print_job.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+uint64_t HashOf(const std::string& text, uint64_t seed = 0) {
+  return Hash64(text.data(), text.size(), seed);
+}
+
+}  // namespace
+
+TEST(ContentHash, MatchesReferenceXxh64) {
+  EXPECT_EQ(HashOf(""), 0xEF46DB3751D8E999ULL);
+  EXPECT_EQ(HashOf("a"), 0xD24EC4F1A98C6E5BULL);
+  EXPECT_EQ(HashOf("abc"), 0x44BC2CF5AD770999ULL);
+  EXPECT_EQ(HashOf("abc", 1), 0xBEA9CA8199328908ULL);
+  // One stripe and a byte; 771 bytes cover every tail length path
+  EXPECT_EQ(HashOf("0123456789abcdef0123456789abcdef!", 7), 0xC1EFD54A62EF942FULL);
+  std::string bytes;
+  for (int i = 0; i < 3; i++) {
+    for (int b = 0; b < 256; b++) bytes.push_back(static_cast<char>(b));
+  }
+  bytes += "xyz";
+  EXPECT_EQ(HashOf(bytes), 0xE921A1B45BD779F8ULL);
+}
+
+TEST(ContentHash, StreamingMatchesOneShot) {
+  std::vector<uint8_t> data(1000);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>(i * 7 + 3);
+  }
+  const uint64_t expected = Hash64(data.data(), data.size(), 5);
+
+  for (size_t piece : {1u, 3u, 31u, 32u, 33u, 100u, 999u}) {
+    Hasher64 hasher(5);
+    for (size_t pos = 0; pos < data.size(); pos += piece) {
+      hasher.Update(data.data() + pos, std::min(piece, data.size() - pos));
+    }
+    EXPECT_EQ(hasher.Digest(), expected) << "piece " << piece;
+  }
+}
+
+TEST(ContentHash, RawJobKeysCoverOptions) {
+  const std::vector<uint8_t> receipt = {'H', 'i', 0x0A, 0x1D, 0x56, 0x01};
+  RawPrintOptions options;
+  const uint64_t key = RawJobContentKey(receipt.data(), receipt.size(), options);
+  EXPECT_EQ(RawJobContentKey(receipt.data(), receipt.size(), options), key);
+
+  RawPrintOptions twoCopies;
+  twoCopies.copies = 2;
+  EXPECT_NE(RawJobContentKey(receipt.data(), receipt.size(), twoCopies), key);
+
+  RawPrintOptions text;
+  text.useRawDatatype = false;
+  EXPECT_NE(RawJobContentKey(receipt.data(), receipt.size(), text), key);
+
+  // Moving bytes between the data and a variant changes the key
+  RawPrintOptions variant;
+  variant.copyVariants = {{0x01}};
+  RawPrintOptions shifted;
+  shifted.copyVariants = {{}};
+  const std::vector<uint8_t> longer = {'H', 'i', 0x0A, 0x1D, 0x56, 0x01, 0x01};
+  EXPECT_NE(RawJobContentKey(receipt.data(), receipt.size(), variant),
+            RawJobContentKey(longer.data(), longer.size(), shifted));
+
+  const std::string bytes(receipt.begin(), receipt.end());
+  EXPECT_EQ(RawJobIdempotencyKey("order-42"), RawJobIdempotencyKey("order-42"));
+  EXPECT_NE(RawJobIdempotencyKey("order-42"), RawJobIdempotencyKey("order-43"));
+  EXPECT_NE(RawJobIdempotencyKey(bytes), HashOf(bytes));
+}
+
+}  // namespace test
+}  // namespace windows_printer
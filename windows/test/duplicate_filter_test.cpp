@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+
+#include "duplicate_filter.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const DuplicateFilter::Clock::time_point kStart;
+
+}  // namespace
+
+TEST(DuplicateFilter, AcknowledgesDuplicatesWithOriginalJob) {
+  DuplicateFilter filter;
+  uint32_t jobId = 99;
+  EXPECT_TRUE(filter.Claim("Kitchen", 1, &jobId, kStart));
+
+  // Still being submitted
+  EXPECT_FALSE(filter.Claim("Kitchen", 1, &jobId, kStart + milliseconds(10)));
+  EXPECT_EQ(jobId, 0u);
+
+  filter.Complete("Kitchen", 1, 7);
+  EXPECT_FALSE(filter.Claim("Kitchen", 1, &jobId, kStart + milliseconds(20)));
+  EXPECT_EQ(jobId, 7u);
+
+  // Windows are per printer and per key
+  EXPECT_TRUE(filter.Claim("Bar", 1, &jobId, kStart));
+  EXPECT_TRUE(filter.Claim("Kitchen", 2, &jobId, kStart));
+  EXPECT_EQ(filter.Size(), 3u);
+}
+
+TEST(DuplicateFilter, ForgetsAfterWindow) {
+  DuplicateFilterOptions options;
+  options.window = milliseconds(1000);
+  DuplicateFilter filter(options);
+  uint32_t jobId = 0;
+  EXPECT_TRUE(filter.Claim("Kitchen", 1, &jobId, kStart));
+  // Duplicates do not extend the window
+  EXPECT_FALSE(filter.Claim("Kitchen", 1, &jobId, kStart + milliseconds(900)));
+  EXPECT_TRUE(filter.Claim("Kitchen", 1, &jobId, kStart + milliseconds(1000)));
+  EXPECT_FALSE(filter.Claim("Kitchen", 1, &jobId, kStart + milliseconds(1500)));
+
+  filter.SetWindow(milliseconds(0));
+  EXPECT_TRUE(filter.Claim("Kitchen", 1, &jobId, kStart + milliseconds(1500)));
+}
+
+TEST(DuplicateFilter, EvictsLeastRecentlySeen) {
+  DuplicateFilterOptions options;
+  options.capacityPerPrinter = 2;
+  DuplicateFilter filter(options);
+  uint32_t jobId = 0;
+  EXPECT_TRUE(filter.Claim("Kitchen", 1, &jobId, kStart));
+  EXPECT_TRUE(filter.Claim("Kitchen", 2, &jobId, kStart));
+  // Seeing 1 again makes 2 the least recent
+  EXPECT_FALSE(filter.Claim("Kitchen", 1, &jobId, kStart));
+  EXPECT_TRUE(filter.Claim("Kitchen", 3, &jobId, kStart));
+
+  EXPECT_FALSE(filter.Claim("Kitchen", 1, &jobId, kStart));
+  EXPECT_FALSE(filter.Claim("Kitchen", 3, &jobId, kStart));
+  EXPECT_TRUE(filter.Claim("Kitchen", 2, &jobId, kStart));
+  EXPECT_EQ(filter.Size(), 2u);
+}
+
+TEST(DuplicateFilter, ReleasedSubmissionsCanBeRetried) {
+  DuplicateFilter filter;
+  uint32_t jobId = 0;
+  EXPECT_TRUE(filter.Claim("Kitchen", 1, &jobId, kStart));
+  filter.Release("Kitchen", 1);
+  EXPECT_TRUE(filter.Claim("Kitchen", 1, &jobId, kStart));
+
+  filter.Clear();
+  EXPECT_EQ(filter.Size(), 0u);
+  EXPECT_TRUE(filter.Claim("Kitchen", 1, &jobId, kStart));
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+// Bytes following the ESC @ that every encoder starts with
+std::vector<uint8_t> Body(const EscPosEncoder& encoder) {
+  const std::vector<uint8_t>& bytes = encoder.Bytes();
+  return std::vector<uint8_t>(bytes.begin() + 2, bytes.end());
+}
+
+std::vector<uint8_t> Concat(std::initializer_list<std::vector<uint8_t>> parts) {
+  std::vector<uint8_t> result;
+  for (const auto& part : parts) {
+    result.insert(result.end(), part.begin(), part.end());
+  }
+  return result;
+}
+
+const std::vector<uint8_t> kResetFormatting = {0x1B, 0x45, 0, 0x1B, 0x2D, 0, 0x1D, 0x21, 0,
+                                               0x1D, 0x42, 0, 0x1B, 0x61, 0};
+
+}  // namespace
+
+// Expected bytes below were produced by the Dart WPESCPOSGenerator.
+
+TEST(EscPosEncoder, StartsWithInitialize) {
+  EscPosEncoder encoder;
+  EXPECT_EQ(encoder.Bytes(), (std::vector<uint8_t>{0x1B, 0x40}));
+  encoder.Feed(2);
+  encoder.Clear();
+  EXPECT_EQ(encoder.Bytes(), (std::vector<uint8_t>{0x1B, 0x40}));
+}
+
+TEST(EscPosEncoder, StyledText) {
+  EscPosEncoder encoder;
+  EscPosTextStyle style;
+  style.bold = true;
+  style.align = EscPosTextAlign::kCenter;
+  style.size = EscPosTextSize::kDoubleHeightWidth;
+  encoder.Text("Hi", style);
+
+  EXPECT_EQ(Body(encoder),
+            Concat({{0x1B, 0x61, 1, 0x1B, 0x45, 1, 0x1B, 0x2D, 0, 0x1D, 0x21, 0x30, 0x1D, 0x42, 0},
+                    {'H', 'i', 0x0D, 0x0A},
+                    kResetFormatting}));
+}
+
+TEST(EscPosEncoder, SeparatorSpansPaperWidth) {
+  EscPosEncoder encoder(EscPosPaperSize::kMm58);
+  encoder.Separator("=");
+
+  std::vector<uint8_t> line(32, '=');
+  line.push_back(0x0D);
+  line.push_back(0x0A);
+  EXPECT_EQ(Body(encoder),
+            Concat({{0x1B, 0x61, 0, 0x1B, 0x45, 0, 0x1B, 0x2D, 0, 0x1D, 0x21, 0, 0x1D, 0x42, 0},
+                    line,
+                    kResetFormatting}));
+}
+
+TEST(EscPosEncoder, HardwareCommands) {
+  EscPosEncoder encoder;
+  encoder.Cut();
+  encoder.OpenDrawer();
+  encoder.Beep(2, 12);
+
+  EXPECT_EQ(Body(encoder), (std::vector<uint8_t>{0x1D, 0x56, 1, 0x1D, 0x56, 0x41, 1,
+                                                 0x1B, 0x70, 0, 60, 120,
+                                                 0x1B, 0x42, 9, 0x07, 0x0A, 0x1B, 0x42, 9, 0x07}));
+}
+
+TEST(EscPosEncoder, Barcodes) {
+  EscPosEncoder encoder;
+  EXPECT_TRUE(encoder.Barcode(EscPosBarcodeType::kCode128, "AB"));
+  EXPECT_EQ(Body(encoder), (std::vector<uint8_t>{0x1B, 0x61, 1, 0x1D, 0x48, 2, 0x1D, 0x66, 0,
+                                                 0x1D, 0x77, 3, 0x1D, 0x68, 162, 0x1D, 0x6B, 73,
+                                                 2, 'A', 'B', 0x0D, 0x0A}));
+
+  encoder.Clear();
+  EXPECT_TRUE(encoder.Barcode(EscPosBarcodeType::kEan8, "1234567", 300, 1, false));
+  EXPECT_EQ(Body(encoder), (std::vector<uint8_t>{0x1B, 0x61, 1, 0x1D, 0x48, 0, 0x1D, 0x66, 0,
+                                                 0x1D, 0x77, 2, 0x1D, 0x68, 255, 0x1D, 0x6B, 3,
+                                                 '1', '2', '3', '4', '5', '6', '7', 0, 0x0D, 0x0A}));
+
+  encoder.Clear();
+  EXPECT_FALSE(encoder.Barcode(EscPosBarcodeType::kEan13, "12ab"));
+  EXPECT_TRUE(Body(encoder).empty());
+}
+
+TEST(EscPosEncoder, ValidatesBarcodeData) {
+  EXPECT_TRUE(EscPosEncoder::IsValidBarcodeData(EscPosBarcodeType::kUpcA, "01234567890"));
+  EXPECT_FALSE(EscPosEncoder::IsValidBarcodeData(EscPosBarcodeType::kUpcA, "0123456789"));
+  EXPECT_TRUE(EscPosEncoder::IsValidBarcodeData(EscPosBarcodeType::kCode39, "AB-12 $/+%."));
+  EXPECT_FALSE(EscPosEncoder::IsValidBarcodeData(EscPosBarcodeType::kCode39, "ab"));
+  EXPECT_TRUE(EscPosEncoder::IsValidBarcodeData(EscPosBarcodeType::kCodabar, "12-34"));
+  EXPECT_FALSE(EscPosEncoder::IsValidBarcodeData(EscPosBarcodeType::kCodabar, "A12"));
+  EXPECT_TRUE(EscPosEncoder::IsValidBarcodeData(EscPosBarcodeType::kItf, "1234"));
+  EXPECT_FALSE(EscPosEncoder::IsValidBarcodeData(EscPosBarcodeType::kItf, "123"));
+  EXPECT_FALSE(EscPosEncoder::IsValidBarcodeData(EscPosBarcodeType::kCode128, ""));
+  EXPECT_FALSE(EscPosEncoder::IsValidBarcodeData(EscPosBarcodeType::kCode93, std::string(256, 'A')));
+}
+
+TEST(EscPosEncoder, QrCode) {
+  EscPosEncoder encoder;
+  encoder.QrCode("abc");
+  EXPECT_EQ(Body(encoder), (std::vector<uint8_t>{0x1D, 0x28, 0x6B, 6, 0, 0x31, 0x50, 0x30, 'a', 'b', 'c',
+                                                 0x1D, 0x28, 0x6B, 3, 0, 0x31, 0x43, 6,
+                                                 0x1D, 0x28, 0x6B, 3, 0, 0x31, 0x45, 1,
+                                                 0x1D, 0x28, 0x6B, 3, 0, 0x31, 0x51, 0x30}));
+}
+
+TEST(EscPosEncoder, ImageBandsAreLsbFirst) {
+  const int width = 2;
+  const int height = 25;
+  std::vector<uint8_t> rgba(width * height * 4, 255);
+  auto setPixel = [&](int x, int y, uint8_t gray) {
+    uint8_t* pixel = &rgba[(y * width + x) * 4];
+    pixel[0] = pixel[1] = pixel[2] = gray;
+  };
+  setPixel(0, 0, 0);
+  setPixel(1, 9, 127);   // Just below the threshold: black
+  setPixel(1, 10, 128);  // At the threshold: white
+  setPixel(0, 24, 0);
+
+  EscPosEncoder encoder;
+  encoder.Image(rgba.data(), rgba.size(), width, height);
+  EXPECT_EQ(Body(encoder), (std::vector<uint8_t>{0x1B, 0x33, 24,
+                                                 0x1B, 0x2A, 33, 2, 0, 0x01, 0, 0, 0, 0x02, 0, 0x0A,
+                                                 0x1B, 0x2A, 33, 2, 0, 0x01, 0, 0, 0, 0, 0, 0x0A,
+                                                 0x1B, 0x32}));
+}
+
+TEST(EscPosEncoder, BitmapBandsAreMsbFirst) {
+  MonoBitmap bitmap(2, 25);
+  bitmap.Set(0, 0, true);
+  bitmap.Set(1, 9, true);
+  bitmap.Set(0, 24, true);
+
+  EscPosEncoder encoder;
+  encoder.Bitmap(bitmap);
+  EXPECT_EQ(Body(encoder), (std::vector<uint8_t>{0x1B, 0x33, 24,
+                                                 0x1B, 0x2A, 33, 2, 0, 0x80, 0, 0, 0, 0x40, 0, 0x0A,
+                                                 0x1B, 0x2A, 33, 2, 0, 0x80, 0, 0, 0, 0, 0, 0x0A,
+                                                 0x1B, 0x32}));
+
+  encoder.Clear();
+  encoder.Bitmap(MonoBitmap());
+  EXPECT_TRUE(Body(encoder).empty());
+}
+
+TEST(EscPosEncoder, ImageIgnoresMissingPixels) {
+  std::vector<uint8_t> rgba(4, 0);
+  EscPosEncoder encoder;
+  encoder.Image(rgba.data(), rgba.size(), 2, 1);
+  EXPECT_EQ(Body(encoder), (std::vector<uint8_t>{0x1B, 0x33, 24,
+                                                 0x1B, 0x2A, 33, 2, 0, 0x01, 0, 0, 0, 0, 0, 0x0A,
+                                                 0x1B, 0x32}));
+
+  encoder.Clear();
+  encoder.Image(rgba.data(), 0, 2, 1);
+  EXPECT_TRUE(Body(encoder).empty());
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+#include "esc_pos_renderer.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+EscPosPreview Render(const std::vector<uint8_t>& bytes,
+                     const EscPosPreviewOptions& options = EscPosPreviewOptions()) {
+  return RenderEscPos(bytes.data(), bytes.size(), options);
+}
+
+std::vector<uint8_t> Bytes(const std::string& text) {
+  return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+struct Bounds {
+  int left = -1;
+  int top = -1;
+  int right = -1;
+  int bottom = -1;
+};
+
+// Smallest rectangle holding every black dot; right and bottom are exclusive
+Bounds BlackBounds(const MonoBitmap& bitmap) {
+  Bounds bounds;
+  for (int y = 0; y < bitmap.Height(); y++) {
+    for (int x = 0; x < bitmap.Width(); x++) {
+      if (!bitmap.Get(x, y)) continue;
+      if (bounds.left < 0 || x < bounds.left) bounds.left = x;
+      if (bounds.top < 0) bounds.top = y;
+      if (x + 1 > bounds.right) bounds.right = x + 1;
+      bounds.bottom = y + 1;
+    }
+  }
+  return bounds;
+}
+
+}  // namespace
+
+TEST(EscPosRenderer, EmptyStreamIsOneBlankRow) {
+  EscPosPreview preview = Render({});
+  EXPECT_EQ(preview.bitmap.Width(), 576);
+  EXPECT_EQ(preview.bitmap.Height(), 1);
+  EXPECT_EQ(preview.bitmap.CountBlack(), 0u);
+  EXPECT_TRUE(preview.cuts.empty());
+}
+
+TEST(EscPosRenderer, LineFeedAdvancesByLineSpacing) {
+  EscPosPreview preview = Render(Bytes("A\n\n"));
+  EXPECT_EQ(preview.bitmap.Height(), 60);
+  Bounds bounds = BlackBounds(preview.bitmap);
+  EXPECT_GE(bounds.left, 0);
+  EXPECT_LE(bounds.right, 12);
+  EXPECT_LE(bounds.bottom, 24);
+
+  // ESC 3 n changes the spacing, ESC 2 restores it
+  preview = Render(Bytes("\x1b" "3" "\x50\n\x1b" "2\n"));
+  EXPECT_EQ(preview.bitmap.Height(), 0x50 + 30);
+}
+
+TEST(EscPosRenderer, AlignsLines) {
+  EscPosPreviewOptions options;
+  options.paperWidth = 384;
+  Bounds center = BlackBounds(Render(Bytes("\x1b" "a\x01" "I\n"), options).bitmap);
+  EXPECT_GE(center.left, 186);
+  EXPECT_LE(center.right, 198);
+
+  Bounds right = BlackBounds(Render(Bytes("\x1b" "a\x02" "I\n"), options).bitmap);
+  EXPECT_GE(right.left, 372);
+}
+
+TEST(EscPosRenderer, WrapsLongLines) {
+  // 48 font A characters fit on 80 mm paper
+  EXPECT_EQ(Render(Bytes(std::string(48, 'W') + "\n")).bitmap.Height(), 30);
+  EXPECT_EQ(Render(Bytes(std::string(49, 'W') + "\n")).bitmap.Height(), 60);
+}
+
+TEST(EscPosRenderer, ScalesCharacters) {
+  Bounds normal = BlackBounds(Render(Bytes("M\n")).bitmap);
+  // GS ! 0x11: double width and double height
+  Bounds large = BlackBounds(Render(Bytes("\x1d!\x11M\n")).bitmap);
+  EXPECT_EQ(large.right - large.left, (normal.right - normal.left) * 2);
+  EXPECT_EQ(large.bottom - large.top, (normal.bottom - normal.top) * 2);
+
+  // Font B is smaller
+  Bounds fontB = BlackBounds(Render(Bytes("\x1b!\x01M\n")).bitmap);
+  EXPECT_LT(fontB.bottom - fontB.top, normal.bottom - normal.top);
+}
+
+TEST(EscPosRenderer, UnderlineAndInvert) {
+  EscPosPreview underlined = Render(Bytes("\x1b-\x02 \n"));
+  EXPECT_EQ(underlined.bitmap.CountBlack(), 12u * 2);
+
+  EscPosPreview inverted = Render(Bytes("\x1d" "B\x01 \n"));
+  EXPECT_EQ(inverted.bitmap.CountBlack(), 12u * 24);
+}
+
+TEST(EscPosRenderer, PrintsRasterImages) {
+  // GS v 0: 2 bytes wide, 2 rows, most significant bit leftmost
+  std::vector<uint8_t> bytes = {0x1D, 'v', '0', 0, 2, 0, 2, 0, 0x80, 0x01, 0xFF, 0x00};
+  EscPosPreview preview = Render(bytes);
+  EXPECT_EQ(preview.bitmap.Height(), 2);
+  EXPECT_TRUE(preview.bitmap.Get(0, 0));
+  EXPECT_TRUE(preview.bitmap.Get(15, 0));
+  EXPECT_EQ(preview.bitmap.CountBlack(), 10u);
+}
+
+TEST(EscPosRenderer, PrintsBitImageColumns) {
+  // ESC * 33: three bytes per column, most significant bit at the top
+  std::vector<uint8_t> bytes = {0x1B, '*', 33, 2, 0, 0x80, 0x00, 0x01, 0x00, 0x00, 0x00, '\n'};
+  EscPosPreview preview = Render(bytes);
+  EXPECT_TRUE(preview.bitmap.Get(0, 0));
+  EXPECT_TRUE(preview.bitmap.Get(0, 23));
+  EXPECT_EQ(preview.bitmap.CountBlack(), 2u);
+}
+
+TEST(EscPosRenderer, PrintsEncoderBitmapsDotForDot) {
+  MonoBitmap bitmap(50, 30);
+  for (int y = 0; y < 30; y++) {
+    for (int x = 0; x < 50; x++) {
+      if ((x * 3 + y * 5) % 7 < 3) bitmap.Set(x, y);
+    }
+  }
+  EscPosEncoder encoder;
+  encoder.Bitmap(bitmap);
+  EscPosPreview preview = Render(encoder.Bytes());
+  for (int y = 0; y < 30; y++) {
+    for (int x = 0; x < 50; x++) {
+      EXPECT_EQ(preview.bitmap.Get(x, y), bitmap.Get(x, y)) << x << "," << y;
+    }
+  }
+  EXPECT_EQ(preview.bitmap.CountBlack(), bitmap.CountBlack());
+}
+
+TEST(EscPosRenderer, RendersEncoderSymbols) {
+  EscPosEncoder encoder;
+  encoder.QrCode("hello", 4, 1);
+  Bounds qr = BlackBounds(Render(encoder.Bytes()).bitmap);
+  // Version 1 symbol, 21 modules of 4 dots
+  EXPECT_EQ(qr.right - qr.left, 84);
+  EXPECT_EQ(qr.bottom - qr.top, 84);
+
+  encoder.Clear();
+  encoder.Barcode(EscPosBarcodeType::kCode128, "{BHi", 50, 2, false);
+  EscPosPreview preview = Render(encoder.Bytes());
+  Bounds barcode = BlackBounds(preview.bitmap);
+  EXPECT_EQ(barcode.right - barcode.left, 57 * 2);
+  EXPECT_EQ(barcode.bottom - barcode.top, 50);
+  // Centered by the encoder's ESC a 1
+  EXPECT_EQ(barcode.left, (576 - 57 * 2) / 2);
+  EXPECT_EQ(preview.unknownCommands, 0);
+}
+
+TEST(EscPosRenderer, CountsCutsDrawerAndBeeps) {
+  EscPosEncoder encoder;
+  encoder.Text("first");
+  encoder.Cut();
+  encoder.Text("second");
+  encoder.Cut(false);
+  encoder.OpenDrawer();
+  encoder.Beep(3);
+
+  EscPosPreviewOptions options;
+  options.markCuts = false;
+  EscPosPreview preview = Render(encoder.Bytes(), options);
+  // Each encoder cut sends GS V twice; they count once. The partial cut's
+  // GS V A 1 feeds one dot before the second line.
+  ASSERT_EQ(preview.cuts.size(), 2u);
+  EXPECT_EQ(preview.cuts[0], 30);
+  EXPECT_EQ(preview.cuts[1], 61);
+  EXPECT_EQ(preview.drawerPulses, 1);
+  EXPECT_EQ(preview.beeps, 3);
+  EXPECT_EQ(preview.unknownCommands, 0);
+}
+
+TEST(EscPosRenderer, MarksCuts) {
+  EscPosPreview preview = Render({0x1D, 'V', 0x00});
+  ASSERT_EQ(preview.cuts.size(), 1u);
+  EXPECT_TRUE(preview.bitmap.Get(0, 0));
+  EXPECT_FALSE(preview.bitmap.Get(4, 0));
+}
+
+TEST(EscPosRenderer, SkipsUnknownCommands) {
+  // ESC z, a PDF417 GS ( k function and a length-prefixed GS ( L
+  std::vector<uint8_t> bytes = {0x1B, 'z', 0x1D, '(', 'k', 3, 0, 48, 67, 3,
+                                0x1D, '(', 'L', 2, 0,  48, 69, 'A', '\n'};
+  EscPosPreview preview = Render(bytes);
+  EXPECT_EQ(preview.unknownCommands, 3);
+  EXPECT_GT(preview.bitmap.CountBlack(), 0u);
+}
+
+TEST(EscPosRenderer, StopsAtMaxHeight) {
+  EscPosPreviewOptions options;
+  options.maxHeight = 100;
+  EscPosPreview preview = Render(Bytes(std::string(10, '\n')), options);
+  EXPECT_TRUE(preview.truncated);
+  EXPECT_EQ(preview.bitmap.Height(), 100);
+}
+
+TEST(EscPosRenderer, ToleratesCutOffCommands) {
+  const std::vector<std::vector<uint8_t>> streams = {
+      {0x1B},
+      {0x1D, '(', 'k', 0xFF, 0xFF, 49},
+      {0x1D, 'v', '0', 0, 0xFF, 0xFF, 0xFF, 0xFF},
+      {0x1B, '*', 33, 0xFF, 0xFF, 0x01},
+      {0x1D, 'k', 4, 'A', 'B'},
+      {0xE2, 0x82},
+  };
+  for (const std::vector<uint8_t>& stream : streams) {
+    EscPosPreview preview = Render(stream);
+    EXPECT_GE(preview.bitmap.Height(), 1);
+  }
+}
+
+TEST(EscPosRenderer, NonAsciiPrintsReplacement) {
+  // U+00E9 is one glyph, the same as '?'
+  EscPosPreview accented = Render(Bytes("\xc3\xa9\n"));
+  EscPosPreview question = Render(Bytes("?\n"));
+  EXPECT_EQ(accented.bitmap.CountBlack(), question.bitmap.CountBlack());
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "esc_pos_symbols.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+std::string ModuleString(const LinearBarcode& barcode) {
+  std::string result;
+  for (bool bar : barcode.modules) {
+    result.push_back(bar ? '1' : '0');
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(EscPosSymbols, Ean13AddsCheckDigitAndParity) {
+  LinearBarcode barcode = EncodeLinearBarcode(EscPosBarcodeType::kEan13, "400638133393");
+  EXPECT_EQ(barcode.text, "4006381333931");
+  // Leading 4 gives the left half parity L G L L G G
+  EXPECT_EQ(ModuleString(barcode),
+            "101"
+            "0001101" "0100111" "0101111" "0111101" "0001001" "0110011"
+            "01010"
+            "1000010" "1000010" "1000010" "1110100" "1000010" "1100110"
+            "101");
+
+  // A supplied check digit is replaced by the computed one
+  EXPECT_EQ(EncodeLinearBarcode(EscPosBarcodeType::kEan13, "4006381333930").text,
+            "4006381333931");
+}
+
+TEST(EscPosSymbols, UpcAndEan8CheckDigits) {
+  LinearBarcode upc = EncodeLinearBarcode(EscPosBarcodeType::kUpcA, "03600029145");
+  EXPECT_EQ(upc.text, "036000291452");
+  EXPECT_EQ(upc.modules.size(), 95u);
+
+  LinearBarcode ean8 = EncodeLinearBarcode(EscPosBarcodeType::kEan8, "9638507");
+  EXPECT_EQ(ean8.text, "96385074");
+  EXPECT_EQ(ean8.modules.size(), 67u);
+}
+
+TEST(EscPosSymbols, Code128CodeSets) {
+  LinearBarcode barcode = EncodeLinearBarcode(EscPosBarcodeType::kCode128, "{BHi");
+  EXPECT_EQ(barcode.text, "Hi");
+  // Start B, H, i, checksum (104 + 40 + 2 * 73) % 103 = 84, stop
+  EXPECT_EQ(ModuleString(barcode),
+            "11010010000" "11000101000" "10000110100" "10011110100" "1100011101011");
+
+  // Data without a code set is read as code set B
+  EXPECT_EQ(ModuleString(EncodeLinearBarcode(EscPosBarcodeType::kCode128, "Hi")),
+            ModuleString(barcode));
+
+  LinearBarcode numeric = EncodeLinearBarcode(EscPosBarcodeType::kCode128, "{C123456");
+  EXPECT_EQ(numeric.text, "123456");
+  EXPECT_EQ(numeric.modules.size(), 11u * 5 + 13);
+
+  // Code set C only takes digit pairs
+  EXPECT_TRUE(EncodeLinearBarcode(EscPosBarcodeType::kCode128, "{C123").modules.empty());
+}
+
+TEST(EscPosSymbols, WideNarrowSymbologies) {
+  // Start, A and stop: three wide and six narrow elements each, narrow gaps
+  LinearBarcode code39 = EncodeLinearBarcode(EscPosBarcodeType::kCode39, "A");
+  EXPECT_EQ(code39.text, "A");
+  EXPECT_EQ(code39.modules.size(), 3u * 15 + 2);
+
+  LinearBarcode itf = EncodeLinearBarcode(EscPosBarcodeType::kItf, "12");
+  EXPECT_EQ(itf.modules.size(), 4u + 2 * 9 + 5);
+
+  LinearBarcode codabar = EncodeLinearBarcode(EscPosBarcodeType::kCodabar, "123");
+  EXPECT_EQ(codabar.text, "123");
+  EXPECT_FALSE(codabar.modules.empty());
+  EXPECT_TRUE(codabar.modules.front());
+  EXPECT_TRUE(codabar.modules.back());
+}
+
+TEST(EscPosSymbols, RejectsUnsupportedBarcodes) {
+  EXPECT_TRUE(EncodeLinearBarcode(EscPosBarcodeType::kUpcE, "123456").modules.empty());
+  EXPECT_TRUE(EncodeLinearBarcode(EscPosBarcodeType::kCode93, "ABC").modules.empty());
+  EXPECT_TRUE(EncodeLinearBarcode(EscPosBarcodeType::kEan13, "12AB").modules.empty());
+}
+
+TEST(EscPosSymbols, QrCodeMatchesReferenceEncoder) {
+  // "a" at level M with mask 0, as produced by a reference QR library
+  const std::vector<std::string> expected = {
+      "111111100000101111111", "100000101110101000001", "101110100011001011101",
+      "101110100100101011101", "101110101010101011101", "100000100110101000001",
+      "111111101010101111111", "000000000001100000000", "101010100101000010010",
+      "011001011110001000110", "000101101000100010001", "100000001100001000100",
+      "100001101000101010101", "000000001001010101011", "111111100001011101111",
+      "100000100101110111000", "101110101001011101101", "101110100000001000110",
+      "101110101000100010001", "100000100110001000110", "111111101100101010111",
+  };
+  QrCode code = EncodeQrCode("a", QrErrorCorrection::kMedium, 0);
+  ASSERT_EQ(code.size, 21);
+  EXPECT_EQ(code.version, 1);
+  for (int y = 0; y < code.size; y++) {
+    std::string row;
+    for (int x = 0; x < code.size; x++) {
+      row.push_back(code.Module(x, y) ? '1' : '0');
+    }
+    EXPECT_EQ(row, expected[static_cast<size_t>(y)]) << "row " << y;
+  }
+}
+
+TEST(EscPosSymbols, QrCodePicksSmallestVersion) {
+  // Version 1-M holds 14 bytes, version 40-L 2953
+  EXPECT_EQ(EncodeQrCode(std::string(14, 'x'), QrErrorCorrection::kMedium).version, 1);
+  EXPECT_EQ(EncodeQrCode(std::string(15, 'x'), QrErrorCorrection::kMedium).version, 2);
+
+  QrCode largest = EncodeQrCode(std::string(2953, 'x'), QrErrorCorrection::kLow);
+  EXPECT_EQ(largest.version, 40);
+  EXPECT_EQ(largest.size, 177);
+  EXPECT_EQ(EncodeQrCode(std::string(2954, 'x'), QrErrorCorrection::kLow).size, 0);
+}
+
+TEST(EscPosSymbols, QrCodeChoosesAMask) {
+  QrCode code = EncodeQrCode("https://example.com/receipt/000123", QrErrorCorrection::kMedium);
+  EXPECT_GE(code.mask, 0);
+  EXPECT_LE(code.mask, 7);
+  // The same mask chosen explicitly gives the same symbol
+  EXPECT_EQ(EncodeQrCode("https://example.com/receipt/000123", QrErrorCorrection::kMedium,
+                         code.mask)
+                .modules,
+            code.modules);
+}
+
+}  // namespace test
+}  // namespace windows_printer
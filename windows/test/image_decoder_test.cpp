@@ -0,0 +1,284 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "image_decoder.h"
+#include "mono_bitmap.h"
+#include "test_images.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+// Keeps every row of the decoded image
+class GrayImage : public GrayRowSink {
+public:
+  bool Begin(int width, int height) override {
+    width_ = width;
+    height_ = height;
+    pixels_.assign(static_cast<size_t>(width) * height, 0);
+    return true;
+  }
+
+  void Row(int y, const uint8_t* gray) override {
+    std::copy(gray, gray + width_, pixels_.begin() + static_cast<size_t>(y) * width_);
+    rows_++;
+  }
+
+  int Width() const { return width_; }
+  int Height() const { return height_; }
+  int Rows() const { return rows_; }
+  int At(int x, int y) const { return pixels_[static_cast<size_t>(y) * width_ + x]; }
+
+private:
+  int width_ = 0;
+  int height_ = 0;
+  int rows_ = 0;
+  std::vector<uint8_t> pixels_;
+};
+
+bool Decode(const std::vector<uint8_t>& data, GrayImage& image, std::string* error = nullptr) {
+  return DecodeGrayImage(data.data(), data.size(), image, error);
+}
+
+int ExpectedGray(int r, int g, int b, int alpha = 255) {
+  const int gray = (19595 * r + 38470 * g + 7471 * b + 32768) >> 16;
+  return 255 - ((255 - gray) * alpha + 127) / 255;
+}
+
+// 16x16, 8-bit palette with tRNS, Adam7 interlaced, IDAT split in two and
+// deflated with dynamic Huffman codes. Pixel (x, y) is palette entry
+// (x + 2y) % 16; entry i is (16i, 255 - 16i, 8i) at alpha 17i.
+const std::vector<uint8_t> kInterlacedPalettePng = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48,
+    0x44, 0x52, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x10, 0x08, 0x03, 0x00, 0x00,
+    0x01, 0x5F, 0x2A, 0x3F, 0xC5, 0x00, 0x00, 0x00, 0x30, 0x50, 0x4C, 0x54, 0x45, 0x00,
+    0xFF, 0x00, 0x10, 0xEF, 0x08, 0x20, 0xDF, 0x10, 0x30, 0xCF, 0x18, 0x40, 0xBF, 0x20,
+    0x50, 0xAF, 0x28, 0x60, 0x9F, 0x30, 0x70, 0x8F, 0x38, 0x80, 0x7F, 0x40, 0x90, 0x6F,
+    0x48, 0xA0, 0x5F, 0x50, 0xB0, 0x4F, 0x58, 0xC0, 0x3F, 0x60, 0xD0, 0x2F, 0x68, 0xE0,
+    0x1F, 0x70, 0xF0, 0x0F, 0x78, 0xF4, 0x88, 0xA7, 0x31, 0x00, 0x00, 0x00, 0x10, 0x74,
+    0x52, 0x4E, 0x53, 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA,
+    0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x76, 0x95, 0x01, 0x15, 0x00, 0x00, 0x00, 0x14, 0x49,
+    0x44, 0x41, 0x54, 0x78, 0xDA, 0xAD, 0x8C, 0x3B, 0x0E, 0xC0, 0x30, 0x08, 0x43, 0x1D,
+    0x92, 0x10, 0x42, 0x7E, 0xF7, 0xBF, 0x6D, 0x83, 0x58, 0x8F, 0xF9, 0x2D, 0xF0, 0x00,
+    0x00, 0x00, 0x46, 0x49, 0x44, 0x41, 0x54, 0x18, 0x3A, 0x74, 0xA8, 0x64, 0xD9, 0x3C,
+    0x8C, 0x00, 0x04, 0x57, 0x65, 0x9A, 0xE4, 0xBA, 0x1B, 0xB1, 0x6E, 0xE8, 0x26, 0x0E,
+    0x53, 0x61, 0xD1, 0xB9, 0x41, 0x30, 0x33, 0x78, 0xD9, 0xA4, 0x5C, 0x5B, 0x1F, 0xEB,
+    0xC0, 0x23, 0x65, 0x78, 0xD4, 0x06, 0x8F, 0x3E, 0x3E, 0xDD, 0x50, 0x2E, 0x95, 0x9B,
+    0x74, 0x1D, 0x73, 0xED, 0x83, 0x84, 0x08, 0x56, 0x22, 0x82, 0x95, 0x88, 0x60, 0xE5,
+    0x1F, 0x3F, 0x1E, 0x04, 0x42, 0x07, 0x81, 0xB3, 0xDC, 0xFF, 0x2B, 0x00, 0x00, 0x00,
+    0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82};
+
+// 16x16 baseline JPEG from another encoder, optimized Huffman tables and
+// 4:2:0 chroma: the left half black, the right half white
+const std::vector<uint8_t> kHalfBlackJpeg = {
+    0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00,
+    0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x10, 0x0B, 0x0C,
+    0x0E, 0x0C, 0x0A, 0x10, 0x0E, 0x0D, 0x0E, 0x12, 0x11, 0x10, 0x13, 0x18, 0x28, 0x1A,
+    0x18, 0x16, 0x16, 0x18, 0x31, 0x23, 0x25, 0x1D, 0x28, 0x3A, 0x33, 0x3D, 0x3C, 0x39,
+    0x33, 0x38, 0x37, 0x40, 0x48, 0x5C, 0x4E, 0x40, 0x44, 0x57, 0x45, 0x37, 0x38, 0x50,
+    0x6D, 0x51, 0x57, 0x5F, 0x62, 0x67, 0x68, 0x67, 0x3E, 0x4D, 0x71, 0x79, 0x70, 0x64,
+    0x78, 0x5C, 0x65, 0x67, 0x63, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x11, 0x12, 0x12, 0x18,
+    0x15, 0x18, 0x2F, 0x1A, 0x1A, 0x2F, 0x63, 0x42, 0x38, 0x42, 0x63, 0x63, 0x63, 0x63,
+    0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+    0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+    0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+    0x63, 0x63, 0x63, 0x63, 0xFF, 0xC0, 0x00, 0x11, 0x08, 0x00, 0x10, 0x00, 0x10, 0x03,
+    0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01, 0xFF, 0xC4, 0x00, 0x15, 0x00,
+    0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x08, 0x07, 0xFF, 0xC4, 0x00, 0x14, 0x10, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xC4,
+    0x00, 0x14, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xC4, 0x00, 0x14, 0x11, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3F, 0x00,
+    0x9F, 0x90, 0x03, 0xF9, 0x00, 0x0F, 0xFF, 0xD9};
+
+// Decoded JPEG luminance against the source's, which lossy coding only
+// approximates
+void ExpectCloseToSource(const GrayImage& image, const std::vector<uint8_t>& rgba, double meanLimit,
+                         int maxLimit) {
+  double total = 0;
+  int worst = 0;
+  for (int y = 0; y < image.Height(); y++) {
+    for (int x = 0; x < image.Width(); x++) {
+      const uint8_t* pixel = &rgba[(static_cast<size_t>(y) * image.Width() + x) * 4];
+      const int difference = std::abs(image.At(x, y) - ExpectedGray(pixel[0], pixel[1], pixel[2]));
+      total += difference;
+      worst = std::max(worst, difference);
+    }
+  }
+  EXPECT_LT(total / (image.Width() * image.Height()), meanLimit);
+  EXPECT_LE(worst, maxLimit);
+}
+
+}  // namespace
+
+TEST(ImageDecoder, DetectsFormatBySignature) {
+  const std::vector<uint8_t> png = EncodeTestPng(TestPhoto(2, 2).data(), 2, 2);
+  EXPECT_EQ(DetectImageFormat(png.data(), png.size()), ImageFormat::kPng);
+  EXPECT_EQ(DetectImageFormat(kHalfBlackJpeg.data(), kHalfBlackJpeg.size()), ImageFormat::kJpeg);
+  EXPECT_EQ(DetectImageFormat(png.data(), 4), ImageFormat::kUnknown);
+  const std::vector<uint8_t> gif = {'G', 'I', 'F', '8', '9', 'a', 0, 0, 0, 0};
+  EXPECT_EQ(DetectImageFormat(gif.data(), gif.size()), ImageFormat::kUnknown);
+
+  GrayImage image;
+  std::string error;
+  EXPECT_FALSE(Decode(gif, image, &error));
+  EXPECT_EQ(error, "Not a PNG or JPEG image");
+}
+
+TEST(ImageDecoder, DecodesRgbaPngOntoWhite) {
+  const int width = 37;
+  const int height = 11;
+  std::vector<uint8_t> rgba = TestPhoto(width, height);
+  for (size_t i = 3; i < rgba.size(); i += 4) {
+    rgba[i] = static_cast<uint8_t>(i * 7);
+  }
+  GrayImage image;
+  ASSERT_TRUE(Decode(EncodeTestPng(rgba.data(), width, height), image));
+  ASSERT_EQ(image.Width(), width);
+  ASSERT_EQ(image.Height(), height);
+  EXPECT_EQ(image.Rows(), height);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const uint8_t* pixel = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+      EXPECT_EQ(image.At(x, y), ExpectedGray(pixel[0], pixel[1], pixel[2], pixel[3]))
+          << x << "," << y;
+    }
+  }
+}
+
+TEST(ImageDecoder, DecodesOneBitPngWithBackReferences) {
+  MonoBitmap bitmap(100, 30);
+  bitmap.FillRect(10, 5, 70, 10);
+  bitmap.FillRect(0, 20, 100, 1);
+  const std::vector<uint8_t> png = bitmap.EncodePng();
+  GrayImage image;
+  ASSERT_TRUE(Decode(png, image));
+  ASSERT_EQ(image.Width(), 100);
+  ASSERT_EQ(image.Height(), 30);
+  for (int y = 0; y < 30; y++) {
+    for (int x = 0; x < 100; x++) {
+      EXPECT_EQ(image.At(x, y), bitmap.Get(x, y) ? 0 : 255) << x << "," << y;
+    }
+  }
+}
+
+TEST(ImageDecoder, DecodesInterlacedPalettePng) {
+  GrayImage image;
+  ASSERT_TRUE(Decode(kInterlacedPalettePng, image));
+  ASSERT_EQ(image.Width(), 16);
+  ASSERT_EQ(image.Height(), 16);
+  EXPECT_EQ(image.Rows(), 16);
+  for (int y = 0; y < 16; y++) {
+    for (int x = 0; x < 16; x++) {
+      const int i = (x + 2 * y) % 16;
+      EXPECT_EQ(image.At(x, y), ExpectedGray(i * 16, 255 - i * 16, i * 8, i * 17))
+          << x << "," << y;
+    }
+  }
+}
+
+TEST(ImageDecoder, DecodesBaselineJpeg) {
+  GrayImage half;
+  ASSERT_TRUE(Decode(kHalfBlackJpeg, half));
+  ASSERT_EQ(half.Width(), 16);
+  ASSERT_EQ(half.Height(), 16);
+  EXPECT_LT(half.At(0, 0), 16);
+  EXPECT_LT(half.At(7, 15), 16);
+  EXPECT_GT(half.At(8, 0), 240);
+  EXPECT_GT(half.At(15, 15), 240);
+
+  // Sizes that leave partial blocks and MCUs at the right and bottom
+  const int width = 53;
+  const int height = 35;
+  const std::vector<uint8_t> rgba = TestPhoto(width, height);
+  GrayImage color;
+  ASSERT_TRUE(Decode(EncodeTestJpeg(rgba.data(), width, height, 95), color));
+  ASSERT_EQ(color.Width(), width);
+  ASSERT_EQ(color.Height(), height);
+  EXPECT_EQ(color.Rows(), height);
+  ExpectCloseToSource(color, rgba, 2.0, 24);
+
+  GrayImage gray;
+  ASSERT_TRUE(Decode(EncodeTestJpeg(rgba.data(), width, height, 95, true), gray));
+  ExpectCloseToSource(gray, rgba, 2.0, 24);
+}
+
+TEST(ImageDecoder, FollowsRestartMarkers) {
+  const int width = 70;
+  const int height = 40;
+  const std::vector<uint8_t> rgba = TestPhoto(width, height);
+  GrayImage plain;
+  ASSERT_TRUE(Decode(EncodeTestJpeg(rgba.data(), width, height, 80), plain));
+  GrayImage restarted;
+  ASSERT_TRUE(Decode(EncodeTestJpeg(rgba.data(), width, height, 80, false, 3), restarted));
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      ASSERT_EQ(restarted.At(x, y), plain.At(x, y)) << x << "," << y;
+    }
+  }
+}
+
+TEST(ImageDecoder, RejectsProgressiveJpeg) {
+  const std::vector<uint8_t> progressive = {0xFF, 0xD8, 0xFF, 0xC2, 0x00, 0x0B, 0x08, 0x00,
+                                            0x10, 0x00, 0x10, 0x01, 0x01, 0x11, 0x00, 0xFF,
+                                            0xD9};
+  GrayImage image;
+  std::string error;
+  EXPECT_FALSE(Decode(progressive, image, &error));
+  EXPECT_EQ(error, "Only baseline JPEG images are supported");
+}
+
+TEST(ImageDecoder, RejectsTruncatedAndCorruptData) {
+  const std::vector<uint8_t> rgba = TestPhoto(40, 40);
+  const std::vector<std::vector<uint8_t>> images = {EncodeTestPng(rgba.data(), 40, 40),
+                                                    EncodeTestJpeg(rgba.data(), 40, 40, 75),
+                                                    kInterlacedPalettePng};
+  for (const std::vector<uint8_t>& complete : images) {
+    for (size_t length = 0; length < complete.size() - 2; length += 7) {
+      std::vector<uint8_t> cut(complete.begin(), complete.begin() + length);
+      GrayImage image;
+      std::string error;
+      EXPECT_FALSE(Decode(cut, image, &error)) << length;
+      EXPECT_FALSE(error.empty());
+    }
+    // Flipped bits may decode to other pixels, but never past the data
+    std::srand(7);
+    for (int round = 0; round < 50; round++) {
+      std::vector<uint8_t> corrupt = complete;
+      for (int flip = 0; flip < 4; flip++) {
+        const size_t index = 16 + std::rand() % (corrupt.size() - 16);
+        corrupt[index] ^= static_cast<uint8_t>(1 << (std::rand() % 8));
+      }
+      GrayImage image;
+      Decode(corrupt, image);
+    }
+  }
+}
+
+TEST(ImageDecoder, SinkCanRefuseTheImage) {
+  class Refusing : public GrayRowSink {
+  public:
+    bool Begin(int, int) override { return false; }
+    void Row(int, const uint8_t*) override { rows++; }
+    int rows = 0;
+  };
+  const std::vector<uint8_t> rgba = TestPhoto(8, 8);
+  for (const std::vector<uint8_t>& data :
+       {EncodeTestPng(rgba.data(), 8, 8), EncodeTestJpeg(rgba.data(), 8, 8, 75)}) {
+    Refusing sink;
+    std::string error;
+    EXPECT_FALSE(DecodeGrayImage(data.data(), data.size(), sink, &error));
+    EXPECT_EQ(error, "Image refused");
+    EXPECT_EQ(sink.rows, 0);
+  }
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "image_scaler.h"
+#include "task_pool.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+std::vector<uint8_t> RandomImage(int width, int height, bool opaque) {
+  std::mt19937 random(7);
+  std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+  for (size_t i = 0; i < rgba.size(); i++) {
+    rgba[i] = static_cast<uint8_t>(random());
+    if (opaque && i % 4 == 3) rgba[i] = 255;
+  }
+  return rgba;
+}
+
+std::vector<uint8_t> ScaleAll(const std::vector<uint8_t>& rgba, int width, int height,
+                              int targetWidth, int targetHeight) {
+  ImageScaler scaler(rgba.data(), width, height, targetWidth, targetHeight);
+  std::vector<uint8_t> out(static_cast<size_t>(targetWidth) * targetHeight * 4);
+  scaler.ScaleRows(0, targetHeight, out.data(), static_cast<size_t>(targetWidth) * 4);
+  return out;
+}
+
+// Bilinear sampling at pixel centers in floating point
+double Reference(const std::vector<uint8_t>& rgba, int width, int height, int targetWidth,
+                 int targetHeight, int x, int y, int channel) {
+  auto axis = [](int t, int size, int targetSize, int* first, int* second, double* weight) {
+    const double position = std::max(0.0, (t + 0.5) * size / targetSize - 0.5);
+    *first = std::min(static_cast<int>(position), size - 1);
+    *second = std::min(*first + 1, size - 1);
+    *weight = *first == size - 1 ? 0.0 : position - *first;
+  };
+  int left, right, top, bottom;
+  double wx, wy;
+  axis(x, width, targetWidth, &left, &right, &wx);
+  axis(y, height, targetHeight, &top, &bottom, &wy);
+  auto at = [&](int px, int py) { return rgba[(static_cast<size_t>(py) * width + px) * 4 + channel]; };
+  const double upper = at(left, top) * (1 - wx) + at(right, top) * wx;
+  const double lower = at(left, bottom) * (1 - wx) + at(right, bottom) * wx;
+  return upper * (1 - wy) + lower * wy;
+}
+
+}  // namespace
+
+TEST(ImageScaler, FitsImageInsideArea) {
+  // A4 at 600 dpi, printable area
+  ImageRect rect = FitImage(1000, 500, 4760, 6779);
+  EXPECT_EQ(rect.width, 4760);
+  EXPECT_EQ(rect.height, 2380);
+  EXPECT_EQ(rect.x, 0);
+  EXPECT_EQ(rect.y, 0);
+
+  rect = FitImage(300, 600, 800, 800);
+  EXPECT_EQ(rect.width, 400);
+  EXPECT_EQ(rect.height, 800);
+  EXPECT_EQ(rect.x, 200);
+
+  EXPECT_EQ(FitImage(0, 10, 800, 800).width, 0);
+  EXPECT_EQ(FitImage(10, 10, 800, 0).height, 0);
+  // Never thinner than a pixel
+  EXPECT_EQ(FitImage(10000, 1, 100, 100).height, 1);
+}
+
+TEST(ImageScaler, WritesBgrForDib) {
+  std::vector<uint8_t> rgba;
+  for (int i = 0; i < 4; i++) {
+    rgba.insert(rgba.end(), {10, 20, 30, 255});
+  }
+  std::vector<uint8_t> out = ScaleAll(rgba, 2, 2, 7, 5);
+  ASSERT_EQ(out.size(), 7u * 5 * 4);
+  for (size_t i = 0; i < out.size(); i += 4) {
+    EXPECT_EQ(out[i], 30);
+    EXPECT_EQ(out[i + 1], 20);
+    EXPECT_EQ(out[i + 2], 10);
+  }
+}
+
+TEST(ImageScaler, BlendsTransparencyOntoWhite) {
+  const std::vector<uint8_t> rgba = {0, 0, 0, 0, 0, 0, 0, 128, 0, 0, 0, 255};
+  std::vector<uint8_t> out = ScaleAll(rgba, 3, 1, 3, 1);
+  EXPECT_EQ(out[0], 255);
+  EXPECT_EQ(out[4], 127);
+  EXPECT_EQ(out[8], 0);
+}
+
+TEST(ImageScaler, KeepsImageAtSameSize) {
+  const std::vector<uint8_t> rgba = RandomImage(37, 11, true);
+  std::vector<uint8_t> out = ScaleAll(rgba, 37, 11, 37, 11);
+  for (size_t i = 0; i < rgba.size(); i += 4) {
+    EXPECT_EQ(out[i], rgba[i + 2]);
+    EXPECT_EQ(out[i + 1], rgba[i + 1]);
+    EXPECT_EQ(out[i + 2], rgba[i]);
+  }
+}
+
+TEST(ImageScaler, MatchesBilinearReference) {
+  const int width = 53;
+  const int height = 29;
+  const std::vector<uint8_t> rgba = RandomImage(width, height, true);
+  // Up, down and mixed, with odd widths for the scalar tail
+  const int sizes[][2] = {{211, 97}, {17, 9}, {101, 13}, {1, 1}};
+  for (const auto& size : sizes) {
+    std::vector<uint8_t> out = ScaleAll(rgba, width, height, size[0], size[1]);
+    int worst = 0;
+    for (int y = 0; y < size[1]; y++) {
+      for (int x = 0; x < size[0]; x++) {
+        for (int channel = 0; channel < 3; channel++) {
+          const double expected =
+              Reference(rgba, width, height, size[0], size[1], x, y, 2 - channel);
+          const int actual = out[(static_cast<size_t>(y) * size[0] + x) * 4 + channel];
+          worst = std::max(worst, static_cast<int>(std::lround(std::abs(actual - expected))));
+        }
+      }
+    }
+    // Eight-bit weights and rounding after each pass
+    EXPECT_LE(worst, 2) << size[0] << "x" << size[1];
+  }
+}
+
+TEST(ImageScaler, BandsMatchWholeImage) {
+  const int width = 40;
+  const int height = 30;
+  const std::vector<uint8_t> rgba = RandomImage(width, height, false);
+  const std::vector<uint8_t> whole = ScaleAll(rgba, width, height, 123, 77);
+
+  ImageScaler scaler(rgba.data(), width, height, 123, 77);
+  const size_t maxBandBytes = 123 * 4 * 10 + 100;
+  std::vector<uint8_t> banded;
+  int nextTop = 0;
+  int bands = 0;
+  EXPECT_TRUE(ForEachImageBand(scaler, maxBandBytes, [&](const ImageBand& band) {
+    EXPECT_EQ(band.top, nextTop);
+    EXPECT_EQ(band.width, 123);
+    EXPECT_LE(band.stride * band.rows, maxBandBytes);
+    banded.insert(banded.end(), band.bgrx, band.bgrx + band.stride * band.rows);
+    nextTop += band.rows;
+    bands++;
+    return true;
+  }));
+  EXPECT_EQ(nextTop, 77);
+  EXPECT_EQ(bands, 8);
+  EXPECT_EQ(banded, whole);
+}
+
+TEST(ImageScaler, ParallelBandsMatchSequentialBands) {
+  const int width = 300;
+  const int height = 200;
+  const std::vector<uint8_t> rgba = RandomImage(width, height, true);
+  const std::vector<uint8_t> whole = ScaleAll(rgba, width, height, 450, 317);
+
+  TaskPool pool(3);
+  ImageScaler scaler(rgba.data(), width, height, 450, 317);
+  std::vector<uint8_t> banded;
+  int bands = 0;
+  EXPECT_TRUE(ForEachImageBand(scaler, 450 * 4 * 100, pool, [&](const ImageBand& band) {
+    EXPECT_EQ(band.top, bands * 100);
+    banded.insert(banded.end(), band.bgrx, band.bgrx + band.stride * band.rows);
+    bands++;
+    return true;
+  }));
+  EXPECT_EQ(bands, 4);
+  EXPECT_EQ(banded, whole);
+  EXPECT_GT(pool.Stats().executed, 0u);
+}
+
+TEST(ImageScaler, BandsAreAtLeastOneRow) {
+  const std::vector<uint8_t> rgba = RandomImage(4, 4, true);
+  ImageScaler scaler(rgba.data(), 4, 4, 100, 3);
+  int bands = 0;
+  EXPECT_TRUE(ForEachImageBand(scaler, 16, [&](const ImageBand& band) {
+    EXPECT_EQ(band.rows, 1);
+    bands++;
+    return true;
+  }));
+  EXPECT_EQ(bands, 3);
+  EXPECT_EQ(ImageBandRows(100, 4000), 10);
+}
+
+TEST(ImageScaler, StopsWhenDrawingFails) {
+  const std::vector<uint8_t> rgba = RandomImage(4, 4, true);
+  ImageScaler scaler(rgba.data(), 4, 4, 10, 10);
+  int bands = 0;
+  EXPECT_FALSE(ForEachImageBand(scaler, 40, [&](const ImageBand&) { return ++bands < 3; }));
+  EXPECT_EQ(bands, 3);
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,334 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "in_memory_spooler.h"
+#include "job_tracker.h"
+#include "print_job.h"
+#include "raw_print_stream.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+const std::vector<uint8_t> kTicket = {'T', 'i', 'c', 'k', 'e', 't', 0x0A};
+
+JobTrackerOptions ManualPolling() {
+  JobTrackerOptions options;
+  options.pollInterval = std::chrono::milliseconds(0);
+  return options;
+}
+
+// Collects the events a tracker reports
+class EventLog {
+public:
+  JobListener Listener() {
+    return [this](const TrackedJob& job) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      events_.push_back(job);
+      changed_.notify_all();
+    };
+  }
+
+  std::vector<JobState> States(uint32_t jobId) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<JobState> states;
+    for (const TrackedJob& job : events_) {
+      if (job.jobId == jobId) states.push_back(job.state);
+    }
+    return states;
+  }
+
+  bool WaitForState(uint32_t jobId, JobState state) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return changed_.wait_for(lock, std::chrono::seconds(5), [this, jobId, state]() {
+      for (const TrackedJob& job : events_) {
+        if (job.jobId == jobId && job.state == state) return true;
+      }
+      return false;
+    });
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  std::vector<TrackedJob> events_;
+};
+
+// Submits a ticket and starts tracking its job
+uint32_t PrintTracked(const std::shared_ptr<InMemorySpooler>& spooler, JobTracker& tracker,
+                      const std::string& printer) {
+  RawPrintResult result = SubmitRawJob(spooler, printer, kTicket.data(), kTicket.size());
+  EXPECT_TRUE(result.success);
+  tracker.Track(result.printerName, result.jobId, "Ticket");
+  return result.jobId;
+}
+
+}  // namespace
+
+TEST(JobTracker, MapsSpoolerStatusBits) {
+  EXPECT_EQ(JobStateFromStatus(0), JobState::kSpooling);
+  EXPECT_EQ(JobStateFromStatus(kJobStatusSpooling), JobState::kSpooling);
+  EXPECT_EQ(JobStateFromStatus(kJobStatusPaused), JobState::kSpooling);
+  EXPECT_EQ(JobStateFromStatus(kJobStatusPrinting), JobState::kPrinting);
+  EXPECT_EQ(JobStateFromStatus(kJobStatusComplete), JobState::kPrinting);
+  EXPECT_EQ(JobStateFromStatus(kJobStatusPrinting | kJobStatusPaperOut), JobState::kError);
+  EXPECT_EQ(JobStateFromStatus(kJobStatusOffline), JobState::kError);
+  EXPECT_EQ(JobStateFromStatus(kJobStatusPrinted | kJobStatusComplete), JobState::kPrinted);
+  EXPECT_EQ(JobStateFromStatus(kJobStatusError | kJobStatusDeleting), JobState::kDeleted);
+  EXPECT_FALSE(IsFinalJobState(JobState::kError));
+  EXPECT_TRUE(IsFinalJobState(JobState::kPrinted));
+  EXPECT_TRUE(IsFinalJobState(JobState::kDeleted));
+}
+
+TEST(JobTracker, FollowsJobUntilPrinted) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  JobTracker tracker(spooler, ManualPolling());
+  EventLog log;
+  tracker.SetListener(log.Listener());
+
+  uint32_t jobId = PrintTracked(spooler, tracker, "Kitchen");
+  tracker.Poll();
+  spooler->SetJobStatus(jobId, kJobStatusPrinting);
+  tracker.Poll();
+  tracker.Poll();
+  spooler->FinishJob(jobId);
+  tracker.Poll();
+
+  EXPECT_EQ(log.States(jobId),
+            (std::vector<JobState>{JobState::kSpooling, JobState::kPrinting, JobState::kPrinted}));
+  EXPECT_EQ(tracker.ActiveJobCount(), 0u);
+
+  TrackedJob job;
+  ASSERT_TRUE(tracker.Find("", jobId, &job));
+  EXPECT_EQ(job.printerName, "Kitchen");
+  EXPECT_EQ(job.documentName, "Ticket");
+  EXPECT_EQ(job.state, JobState::kPrinted);
+}
+
+TEST(JobTracker, ReportsErrorsAndRecovery) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  JobTracker tracker(spooler, ManualPolling());
+  EventLog log;
+  tracker.SetListener(log.Listener());
+
+  uint32_t jobId = PrintTracked(spooler, tracker, "Kitchen");
+  spooler->SetJobStatus(jobId, kJobStatusPrinting | kJobStatusPaperOut);
+  tracker.Poll();
+
+  TrackedJob job;
+  ASSERT_TRUE(tracker.Find("Kitchen", jobId, &job));
+  EXPECT_EQ(job.state, JobState::kError);
+  EXPECT_EQ(job.status, kJobStatusPrinting | kJobStatusPaperOut);
+
+  spooler->SetJobStatus(jobId, kJobStatusPrinting);
+  tracker.Poll();
+  spooler->SetJobStatus(jobId, kJobStatusPrinted);
+  tracker.Poll();
+
+  EXPECT_EQ(log.States(jobId),
+            (std::vector<JobState>{JobState::kSpooling, JobState::kError, JobState::kPrinting,
+                                   JobState::kPrinted}));
+  EXPECT_EQ(tracker.ActiveJobCount(), 0u);
+}
+
+TEST(JobTracker, ReportsCancelledJobsAsDeleted) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  JobTracker tracker(spooler, ManualPolling());
+  EventLog log;
+  tracker.SetListener(log.Listener());
+
+  uint32_t jobId = PrintTracked(spooler, tracker, "Kitchen");
+  ASSERT_TRUE(spooler->CancelJob("Kitchen", jobId));
+  tracker.MarkCancelled("", jobId);
+  tracker.Poll();
+
+  EXPECT_EQ(log.States(jobId), (std::vector<JobState>{JobState::kSpooling, JobState::kDeleted}));
+}
+
+TEST(JobTracker, ReportsJobsLeavingWhileDeletingAsDeleted) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  JobTracker tracker(spooler, ManualPolling());
+  EventLog log;
+  tracker.SetListener(log.Listener());
+
+  uint32_t jobId = PrintTracked(spooler, tracker, "Kitchen");
+  spooler->SetJobStatus(jobId, kJobStatusSpooling | kJobStatusDeleting);
+  tracker.Poll();
+  // Deleted from the queue by someone else before it finished spooling
+  spooler->FinishJob(jobId);
+  tracker.Poll();
+
+  EXPECT_EQ(log.States(jobId), (std::vector<JobState>{JobState::kSpooling, JobState::kDeleted}));
+}
+
+TEST(JobTracker, ReportsJobsLeavingWhileSpoolingAsPrinted) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  JobTracker tracker(spooler, ManualPolling());
+  EventLog log;
+  tracker.SetListener(log.Listener());
+
+  uint32_t jobId = PrintTracked(spooler, tracker, "Kitchen");
+  spooler->SetJobStatus(jobId, kJobStatusSpooling);
+  tracker.Poll();
+  // Spooled and printed within one poll interval
+  spooler->FinishJob(jobId);
+  tracker.Poll();
+
+  EXPECT_EQ(log.States(jobId), (std::vector<JobState>{JobState::kSpooling, JobState::kPrinted}));
+}
+
+TEST(JobTracker, ReportsStreamsLeavingWhileSpoolingAsPrinted) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Labels");
+  JobTracker tracker(spooler, ManualPolling());
+  EventLog log;
+  tracker.SetListener(log.Listener());
+
+  // Streams are tracked from kStarted, while their data is still spooling
+  std::mutex mutex;
+  std::condition_variable changed;
+  uint32_t jobId = 0;
+  bool finished = false;
+  RawPrintStream stream(spooler, "Labels", RawPrintStreamOptions(),
+                        [&](const PrintStreamEvent& event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (event.type == PrintStreamEventType::kStarted) {
+      tracker.Track(event.printerName, event.jobId, "Labels");
+      jobId = event.jobId;
+    } else if (event.type == PrintStreamEventType::kFinished) {
+      finished = true;
+    }
+    changed.notify_all();
+  });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(changed.wait_for(lock, std::chrono::seconds(5), [&]() { return jobId != 0; }));
+  }
+  spooler->SetJobStatus(jobId, kJobStatusSpooling);
+  tracker.Poll();
+
+  bool full = false;
+  EXPECT_EQ(stream.Write(kTicket.data(), kTicket.size(), &full), kTicket.size());
+  stream.Finish();
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(changed.wait_for(lock, std::chrono::seconds(5), [&]() { return finished; }));
+  }
+  spooler->FinishJob(jobId);
+  tracker.Poll();
+
+  EXPECT_EQ(log.States(jobId), (std::vector<JobState>{JobState::kSpooling, JobState::kPrinted}));
+}
+
+TEST(JobTracker, ListsEachQueueOncePerPoll) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  spooler->AddPrinter("Bar");
+  JobTracker tracker(spooler, ManualPolling());
+  EventLog log;
+  tracker.SetListener(log.Listener());
+
+  uint32_t first = PrintTracked(spooler, tracker, "Kitchen");
+  uint32_t second = PrintTracked(spooler, tracker, "Kitchen");
+  uint32_t bar = PrintTracked(spooler, tracker, "Bar");
+  spooler->SetJobStatus(first, kJobStatusPrinting);
+  spooler->FinishJob(bar);
+
+  // Failed listings leave the jobs as they were until the next poll
+  spooler->FailNext(SpoolerCall::kEnumerateJobs, 1722, 2);
+  tracker.Poll();
+  EXPECT_EQ(log.States(first), std::vector<JobState>{JobState::kSpooling});
+  EXPECT_EQ(log.States(bar), std::vector<JobState>{JobState::kSpooling});
+  EXPECT_EQ(tracker.ActiveJobCount(), 3u);
+
+  tracker.Poll();
+  EXPECT_EQ(log.States(first), (std::vector<JobState>{JobState::kSpooling, JobState::kPrinting}));
+  EXPECT_EQ(log.States(second), std::vector<JobState>{JobState::kSpooling});
+  EXPECT_EQ(log.States(bar), (std::vector<JobState>{JobState::kSpooling, JobState::kPrinted}));
+  EXPECT_EQ(tracker.ActiveJobCount(), 2u);
+}
+
+TEST(JobTracker, FinishesJobsOfRemovedPrinters) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  JobTracker tracker(spooler, ManualPolling());
+  EventLog log;
+  tracker.SetListener(log.Listener());
+
+  tracker.Track("Gone", 7, "Ticket");
+  tracker.Track("Gone", 7, "Ticket");
+  tracker.Poll();
+
+  EXPECT_EQ(log.States(7), (std::vector<JobState>{JobState::kSpooling, JobState::kDeleted}));
+  EXPECT_EQ(tracker.ActiveJobCount(), 0u);
+}
+
+TEST(JobTracker, KeepsLimitedHistory) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  spooler->SetDiscardData(true);
+  JobTrackerOptions options = ManualPolling();
+  options.finishedJobHistory = 2;
+  JobTracker tracker(spooler, options);
+
+  std::vector<uint32_t> jobIds;
+  for (int i = 0; i < 3; i++) {
+    jobIds.push_back(PrintTracked(spooler, tracker, "Kitchen"));
+  }
+  tracker.Poll();
+
+  TrackedJob job;
+  EXPECT_FALSE(tracker.Find("Kitchen", jobIds[0], &job));
+  EXPECT_TRUE(tracker.Find("Kitchen", jobIds[1], &job));
+  EXPECT_TRUE(tracker.Find("Kitchen", jobIds[2], &job));
+  EXPECT_EQ(job.state, JobState::kPrinted);
+  EXPECT_FALSE(tracker.Find("Bar", jobIds[2], &job));
+}
+
+TEST(JobTracker, PollsInBackground) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  JobTrackerOptions options;
+  options.pollInterval = std::chrono::milliseconds(5);
+  JobTracker tracker(spooler, options);
+  EventLog log;
+  tracker.SetListener(log.Listener());
+
+  uint32_t jobId = PrintTracked(spooler, tracker, "Kitchen");
+  spooler->SetJobStatus(jobId, kJobStatusPrinting);
+  EXPECT_TRUE(log.WaitForState(jobId, JobState::kPrinting));
+  spooler->FinishJob(jobId);
+  EXPECT_TRUE(log.WaitForState(jobId, JobState::kPrinted));
+}
+
+TEST(JobTracker, DestructionDoesNotWaitForStuckPoll) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  spooler->HangNext(SpoolerCall::kEnumerateJobs);
+  {
+    JobTrackerOptions options;
+    options.pollInterval = std::chrono::milliseconds(1);
+    JobTracker tracker(spooler, options);
+    PrintTracked(spooler, tracker, "Kitchen");
+    for (int i = 0; i < 500 && spooler->HungCallCount() == 0; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(spooler->HungCallCount(), 1u);
+  }
+  spooler->ReleaseHangs();
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "label_layout.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+std::string Text(const std::vector<uint8_t>& bytes) {
+  return std::string(bytes.begin(), bytes.end());
+}
+
+LabelElement TextElement(int x, int y, const std::string& data, int field = 0) {
+  LabelElement element;
+  element.x = x;
+  element.y = y;
+  element.data = data;
+  element.field = field;
+  return element;
+}
+
+// A 50 x 30 mm shelf label: a logo, a product name, a price and a barcode
+LabelLayout ShelfLabel() {
+  LabelLayout layout;
+  layout.widthMm = 50;
+  layout.heightMm = 30;
+
+  LabelElement logo;
+  logo.type = LabelElementType::kGraphic;
+  logo.x = 10;
+  logo.y = 10;
+  logo.imageWidth = 160;
+  logo.imageHeight = 64;
+  logo.rgba.assign(static_cast<size_t>(logo.imageWidth) * logo.imageHeight * 4, 255);
+  // Error-diffused shading is irregular, like a scanned logo, and does not
+  // collapse into runs
+  uint32_t noise = 1;
+  for (int y = 0; y < logo.imageHeight; y++) {
+    for (int x = 0; x < logo.imageWidth; x++) {
+      noise = noise * 1103515245u + 12345u;
+      if ((noise >> 16) % 3 == 0) {
+        uint8_t* pixel = &logo.rgba[(static_cast<size_t>(y) * logo.imageWidth + x) * 4];
+        pixel[0] = pixel[1] = pixel[2] = 0;
+      }
+    }
+  }
+  layout.elements.push_back(logo);
+
+  layout.elements.push_back(TextElement(10, 90, "Fresh Whole Milk 1L", 1));
+  layout.elements.push_back(TextElement(10, 130, "1.29", 2));
+  LabelElement barcode;
+  barcode.type = LabelElementType::kBarcode;
+  barcode.barcodeType = LabelBarcodeType::kEan13;
+  barcode.x = 200;
+  barcode.y = 120;
+  barcode.height = 80;
+  barcode.data = "4006381333931";
+  barcode.field = 3;
+  layout.elements.push_back(barcode);
+  return layout;
+}
+
+const std::map<int, std::string> kShelfFields = {
+    {1, "Fresh Whole Milk 1L"}, {2, "1.29"}, {3, "4006381333931"}};
+
+}  // namespace
+
+TEST(LabelLayout, EncodesLabelInBothLanguages) {
+  LabelLayout layout;
+  layout.widthMm = 50;
+  layout.heightMm = 25;
+  layout.elements.push_back(TextElement(16, 16, "Hello"));
+  LabelElement qr;
+  qr.type = LabelElementType::kQrCode;
+  qr.x = 200;
+  qr.y = 16;
+  qr.width = 5;
+  qr.data = "42";
+  layout.elements.push_back(qr);
+
+  EXPECT_EQ(Text(EncodeLabel(LabelLanguage::kZpl, layout, 2)),
+            "^XA^PW400^LL200^FO16,16^A0N,30,30^FDHello^FS^FO200,16^BQN,2,5^FDMA,42^FS^PQ2^XZ");
+  EXPECT_EQ(Text(EncodeLabel(LabelLanguage::kTspl, layout)),
+            "SIZE 50 mm,25 mm\r\nGAP 2 mm,0 mm\r\nCLS\r\n"
+            "TEXT 16,16,\"3\",0,1,1,\"Hello\"\r\n"
+            "QRCODE 200,16,M,5,A,0,\"42\"\r\n"
+            "PRINT 1\r\n");
+}
+
+TEST(LabelLayout, FieldsPrintTheirDataOnFullLabels) {
+  LabelLayout layout;
+  layout.elements.push_back(TextElement(0, 0, "Sample", 1));
+  EXPECT_EQ(Text(EncodeLabel(LabelLanguage::kZpl, layout)),
+            "^XA^FO0,0^A0N,30,30^FDSample^FS^XZ");
+  EXPECT_EQ(Text(EncodeLabelFormat(LabelLanguage::kZpl, layout, "F")),
+            "^XA^DFR:F.ZPL^FS^FO0,0^A0N,30,30^FN1^FS^XZ");
+}
+
+TEST(LabelLayout, RecallFillsFieldsByElementType) {
+  LabelLayout layout;
+  layout.elements.push_back(TextElement(0, 0, "", 1));
+  LabelElement qr;
+  qr.type = LabelElementType::kQrCode;
+  qr.field = 2;
+  layout.elements.push_back(qr);
+
+  const std::map<int, std::string> fields = {{1, "Name"}, {2, "https://x"}, {7, "unused"}};
+  EXPECT_EQ(Text(EncodeLabelRecall(LabelLanguage::kZpl, layout, "TAG", fields, 3)),
+            "^XA^XFR:TAG.ZPL^FS^FN1^FDName^FS^FN2^FDMA,https://x^FS^PQ3^XZ");
+  EXPECT_EQ(Text(EncodeLabelRecall(LabelLanguage::kTspl, layout, "TAG", fields, 2)),
+            "F1$=\"Name\"\r\nF2$=\"https://x\"\r\nRUN \"TAG.BAS\"\r\nRUN \"TAG.BAS\"\r\n");
+}
+
+TEST(LabelLayout, RecallSendsATenthOfTheBytes) {
+  const LabelLayout layout = ShelfLabel();
+  ASSERT_EQ(ValidateLabelLayout(layout), "");
+  for (LabelLanguage language : {LabelLanguage::kZpl, LabelLanguage::kTspl}) {
+    const size_t full = EncodeLabel(language, layout).size();
+    const size_t recall = EncodeLabelRecall(language, layout, "SHELF", kShelfFields).size();
+    EXPECT_GE(full, recall * 10) << static_cast<int>(language) << ": " << full << " vs " << recall;
+  }
+}
+
+TEST(LabelLayout, ValidatesLayouts) {
+  LabelLayout layout;
+  layout.elements.push_back(TextElement(0, 0, "ok"));
+  EXPECT_EQ(ValidateLabelLayout(layout), "");
+
+  LabelElement barcode;
+  barcode.type = LabelElementType::kBarcode;
+  barcode.barcodeType = LabelBarcodeType::kEan8;
+  barcode.data = "12";
+  layout.elements.push_back(barcode);
+  EXPECT_EQ(ValidateLabelLayout(layout), "Element 1: data is invalid for the barcode type");
+  layout.elements.back().field = 4;
+  EXPECT_EQ(ValidateLabelLayout(layout), "");
+  layout.elements.back().field = 100;
+  EXPECT_NE(ValidateLabelLayout(layout), "");
+
+  LabelLayout graphic;
+  LabelElement image;
+  image.type = LabelElementType::kGraphic;
+  image.imageWidth = 4;
+  image.imageHeight = 4;
+  image.rgba.resize(4 * 4 * 4 - 1);
+  graphic.elements.push_back(image);
+  EXPECT_NE(ValidateLabelLayout(graphic), "");
+
+  LabelLayout size;
+  size.widthMm = 100000;
+  EXPECT_EQ(ValidateLabelLayout(size), "Label size is out of range");
+}
+
+TEST(LabelLayout, FormatNamesAreShortFileNames) {
+  EXPECT_TRUE(IsValidLabelFormatName("SHELF_1"));
+  EXPECT_TRUE(IsValidLabelFormatName("abc"));
+  EXPECT_FALSE(IsValidLabelFormatName(""));
+  EXPECT_FALSE(IsValidLabelFormatName("TOOLONGNAME"));
+  EXPECT_FALSE(IsValidLabelFormatName("A.ZPL"));
+  EXPECT_FALSE(IsValidLabelFormatName("A\"B"));
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "load_generator.h"
+#include "simulated_spooler.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+LoadOptions ShortRun() {
+  LoadOptions options;
+  options.printers = {"Kitchen", "Bar"};
+  LoadJobKind receipt;
+  receipt.name = "receipt";
+  receipt.weight = 3;
+  LoadJobKind ticket;
+  ticket.name = "kitchen";
+  ticket.lines = 8;
+  ticket.priority = 1;
+  LoadJobKind logo;
+  logo.name = "logo";
+  logo.imageWidth = 384;
+  logo.imageHeight = 96;
+  logo.paperSize = EscPosPaperSize::kMm58;
+  options.mix = {receipt, ticket, logo};
+  options.threads = 4;
+  options.duration = std::chrono::milliseconds(300);
+  options.sampleInterval = std::chrono::milliseconds(100);
+  options.pollInterval = std::chrono::milliseconds(5);
+  options.drainTimeout = std::chrono::milliseconds(5000);
+  return options;
+}
+
+}  // namespace
+
+TEST(LoadGenerator, ReportsLatencyAndThroughput) {
+  auto spooler = std::make_shared<SimulatedSpooler>();
+  SimulatedPrinterOptions printer;
+  printer.bytesPerSecond = 2000000;
+  printer.bufferSize = 8192;
+  spooler->AddPrinter("Kitchen", printer);
+  spooler->AddPrinter("Bar", printer);
+
+  LoadOptions options = ShortRun();
+  uint64_t fakeMemory = 1000;
+  options.memoryProbe = [&fakeMemory]() { return fakeMemory += 10; };
+  std::vector<LoadSample> seen;
+  options.onSample = [&seen](const LoadSample& sample) { seen.push_back(sample); };
+
+  LoadReport report = RunLoad(spooler, options);
+  EXPECT_GT(report.submitted, 0u);
+  EXPECT_EQ(report.printed, report.submitted);
+  EXPECT_EQ(report.failed, 0u);
+  EXPECT_EQ(report.outstanding, 0u);
+  EXPECT_EQ(report.printed, spooler->CompletedJobCount());
+  EXPECT_GT(report.bytesSubmitted, 0u);
+  EXPECT_GT(report.jobsPerSecond, 0.0);
+
+  EXPECT_EQ(report.completeLatency.count, report.printed);
+  EXPECT_GT(report.completeLatency.p50, 0u);
+  EXPECT_LE(report.completeLatency.p50, report.completeLatency.p99);
+  EXPECT_LE(report.completeLatency.p99, report.completeLatency.p999);
+  // Completion includes printing, so it is never shorter than submission
+  EXPECT_GE(report.completeLatency.max, report.submitLatency.min);
+  EXPECT_EQ(report.submitLatency.count, report.submitted);
+
+  ASSERT_EQ(report.priorities.size(), 2u);
+  EXPECT_EQ(report.priorities[0].priority, 1);
+  EXPECT_EQ(report.priorities[1].priority, 0);
+  EXPECT_GT(report.priorities[0].printed, 0u);
+  EXPECT_EQ(report.priorities[0].printed + report.priorities[1].printed, report.printed);
+
+  ASSERT_GE(report.samples.size(), 2u);
+  EXPECT_EQ(seen.size(), report.samples.size());
+  EXPECT_GT(report.samples.back().residentBytes, report.samples.front().residentBytes);
+  EXPECT_EQ(report.memoryGrowthBytes,
+            static_cast<int64_t>(report.samples.back().residentBytes -
+                                 report.samples.front().residentBytes));
+}
+
+TEST(LoadGenerator, CountsFailedSubmissions) {
+  auto spooler = std::make_shared<SimulatedSpooler>(3);
+  SimulatedPrinterOptions printer;
+  printer.bytesPerSecond = 0;
+  printer.failureRate = 0.5;
+  spooler->AddPrinter("Kitchen", printer);
+  spooler->AddPrinter("Bar", printer);
+
+  LoadOptions options = ShortRun();
+  options.duration = std::chrono::milliseconds(100);
+  LoadReport report = RunLoad(spooler, options);
+  EXPECT_GT(report.failed, 0u);
+  EXPECT_GT(report.printed, 0u);
+  EXPECT_EQ(report.failed, spooler->FailedJobCount());
+  EXPECT_EQ(report.printed + report.failed, report.submitted);
+}
+
+TEST(LoadGenerator, SubmitsAtFixedRate) {
+  auto spooler = std::make_shared<SimulatedSpooler>();
+  SimulatedPrinterOptions printer;
+  printer.bytesPerSecond = 0;
+  spooler->AddPrinter("Kitchen", printer);
+  spooler->AddPrinter("Bar", printer);
+
+  LoadOptions options = ShortRun();
+  options.jobsPerSecond = 100;
+  options.duration = std::chrono::milliseconds(500);
+  LoadReport report = RunLoad(spooler, options);
+  EXPECT_EQ(report.submitted, 50u);
+  EXPECT_EQ(report.printed, 50u);
+}
+
+TEST(LoadGenerator, SlowPrinterShowsInTailLatency) {
+  auto spooler = std::make_shared<SimulatedSpooler>();
+  SimulatedPrinterOptions fast;
+  fast.bytesPerSecond = 0;
+  SimulatedPrinterOptions slow;
+  // Each receipt takes about 10 ms to print
+  slow.bytesPerSecond = 100000;
+  slow.bufferSize = 1 << 20;
+  spooler->AddPrinter("Kitchen", fast);
+  spooler->AddPrinter("Bar", slow);
+
+  LoadOptions options = ShortRun();
+  options.mix.resize(1);
+  options.jobsPerSecond = 200;
+  options.duration = std::chrono::milliseconds(250);
+  LoadReport report = RunLoad(spooler, options);
+  EXPECT_EQ(report.outstanding, 0u);
+  EXPECT_GE(report.completeLatency.p99, 10000000u);
+  EXPECT_GE(report.completeLatency.p99, 4 * report.completeLatency.min);
+}
+
+}  // namespace test
+}  // namespace windows_printer
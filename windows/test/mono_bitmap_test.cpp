@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "mono_bitmap.h"
+
+namespace windows_printer {
+namespace test {
+
+TEST(MonoBitmap, FillRectCoversExactlyTheRectangle) {
+  MonoBitmap bitmap(40, 6);
+  bitmap.FillRect(3, 1, 22, 4);
+  for (int y = 0; y < 6; y++) {
+    for (int x = 0; x < 40; x++) {
+      EXPECT_EQ(bitmap.Get(x, y), x >= 3 && x < 25 && y >= 1 && y < 5) << x << "," << y;
+    }
+  }
+  EXPECT_EQ(bitmap.CountBlack(), 22u * 4);
+
+  bitmap.FillRect(5, 2, 2, 1, false);
+  EXPECT_FALSE(bitmap.Get(5, 2));
+  EXPECT_FALSE(bitmap.Get(6, 2));
+  EXPECT_TRUE(bitmap.Get(7, 2));
+}
+
+TEST(MonoBitmap, ThresholdsRgbaByLuminance) {
+  // Black, dark red, mid gray, white; a second row cut short
+  const std::vector<uint8_t> rgba = {0,   0,   0,   255, 200, 0,   0,   255,
+                                     128, 128, 128, 255, 255, 255, 255, 255,
+                                     0,   0,   0,   255};
+  MonoBitmap bitmap = MonoBitmap::FromRgba(rgba.data(), rgba.size(), 4, 2);
+  ASSERT_EQ(bitmap.Width(), 4);
+  ASSERT_EQ(bitmap.Height(), 2);
+  EXPECT_TRUE(bitmap.Get(0, 0));
+  EXPECT_TRUE(bitmap.Get(1, 0));
+  EXPECT_FALSE(bitmap.Get(2, 0));
+  EXPECT_FALSE(bitmap.Get(3, 0));
+  EXPECT_TRUE(bitmap.Get(0, 1));
+  EXPECT_EQ(bitmap.CountBlack(), 3u);
+}
+
+TEST(MonoBitmap, ClipsToBounds) {
+  MonoBitmap bitmap(10, 10);
+  bitmap.FillRect(-5, -5, 100, 7);
+  EXPECT_EQ(bitmap.CountBlack(), 20u);
+  bitmap.Set(10, 0);
+  bitmap.Set(-1, 3);
+  EXPECT_EQ(bitmap.CountBlack(), 20u);
+  EXPECT_FALSE(bitmap.Get(10, 0));
+}
+
+TEST(MonoBitmap, BlitMatchesPixelCopy) {
+  // 13 dots wide so the last source byte is partly used
+  const int width = 13;
+  const int height = 3;
+  const std::vector<uint8_t> source = {0xB5, 0xFF, 0x81, 0xF8, 0x0F, 0x07};
+  const size_t stride = 2;
+
+  for (int offset = -4; offset < 24; offset++) {
+    MonoBitmap bitmap(30, 5);
+    bitmap.Blit(source.data(), stride, width, height, offset, 1);
+    for (int y = 0; y < 5; y++) {
+      for (int x = 0; x < 30; x++) {
+        const int column = x - offset;
+        const int row = y - 1;
+        bool expected = false;
+        if (column >= 0 && column < width && row >= 0 && row < height) {
+          expected = (source[row * stride + column / 8] & (0x80 >> (column % 8))) != 0;
+        }
+        EXPECT_EQ(bitmap.Get(x, y), expected) << "offset " << offset << " at " << x << "," << y;
+      }
+    }
+  }
+}
+
+TEST(MonoBitmap, BlitClearModeRemovesDots) {
+  MonoBitmap bitmap(16, 1);
+  bitmap.FillRect(0, 0, 16, 1);
+  const uint8_t source[] = {0xF0};
+  bitmap.Blit(source, 1, 8, 1, 6, 0, BlitMode::kClear);
+  EXPECT_EQ(bitmap.CountBlack(), 12u);
+  EXPECT_FALSE(bitmap.Get(6, 0));
+  EXPECT_FALSE(bitmap.Get(9, 0));
+  EXPECT_TRUE(bitmap.Get(10, 0));
+}
+
+TEST(MonoBitmap, ResizeKeepsRowsAndAddsWhite) {
+  MonoBitmap bitmap(8, 1);
+  bitmap.Set(2, 0);
+  bitmap.Resize(3);
+  EXPECT_EQ(bitmap.Height(), 3);
+  EXPECT_TRUE(bitmap.Get(2, 0));
+  EXPECT_EQ(bitmap.CountBlack(), 1u);
+}
+
+TEST(MonoBitmap, EncodesOneBitPng) {
+  MonoBitmap bitmap(576, 2000);
+  bitmap.FillRect(10, 10, 100, 20);
+  const std::vector<uint8_t> png = bitmap.EncodePng();
+
+  const std::vector<uint8_t> signature = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  ASSERT_GT(png.size(), 33u);
+  EXPECT_EQ(std::vector<uint8_t>(png.begin(), png.begin() + 8), signature);
+  // IHDR: 576 x 2000, bit depth 1, grayscale
+  EXPECT_EQ(std::vector<uint8_t>(png.begin() + 12, png.begin() + 16),
+            (std::vector<uint8_t>{'I', 'H', 'D', 'R'}));
+  EXPECT_EQ(std::vector<uint8_t>(png.begin() + 16, png.begin() + 26),
+            (std::vector<uint8_t>{0, 0, 0x02, 0x40, 0, 0, 0x07, 0xD0, 1, 0}));
+  EXPECT_EQ(std::vector<uint8_t>(png.end() - 8, png.end() - 4),
+            (std::vector<uint8_t>{'I', 'E', 'N', 'D'}));
+
+  // Mostly white paper compresses to a small fraction of the 146 KB of rows
+  EXPECT_LT(png.size(), 4000u);
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,283 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "network_scanner.h"
+
+// The loopback listeners below use POSIX sockets; the scanner itself is
+// covered on Windows by the same engine behind winsock.
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+// Status byte of an idle printer with the cover closed
+constexpr uint8_t kIdleStatus = 0x12;
+
+uint32_t Ipv4(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+  return (a << 24) | (b << 16) | (c << 8) | d;
+}
+
+// TCP listener on a loopback address. Connections are answered with reply
+// once they send something, or held open silently if reply is empty.
+class LoopbackListener {
+public:
+  LoopbackListener(uint32_t address, uint16_t port, std::vector<uint8_t> reply)
+      : reply_(std::move(reply)) {
+    socket_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    local.sin_addr.s_addr = htonl(address);
+    if (bind(socket_, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0 ||
+        listen(socket_, 16) != 0) {
+      close(socket_);
+      socket_ = -1;
+      return;
+    }
+    socklen_t length = sizeof(local);
+    getsockname(socket_, reinterpret_cast<sockaddr*>(&local), &length);
+    port_ = ntohs(local.sin_port);
+    thread_ = std::thread(&LoopbackListener::Serve, this);
+  }
+
+  ~LoopbackListener() {
+    stop_ = true;
+    if (thread_.joinable()) thread_.join();
+    if (socket_ != -1) close(socket_);
+  }
+
+  bool IsListening() const { return socket_ != -1; }
+  uint16_t Port() const { return port_; }
+
+private:
+  void Serve() {
+    std::vector<int> clients;
+    while (!stop_) {
+      pollfd listening{socket_, POLLIN, 0};
+      if (poll(&listening, 1, 10) > 0) {
+        int client = accept(socket_, nullptr, nullptr);
+        if (client != -1) clients.push_back(client);
+      }
+      for (int& client : clients) {
+        if (client == -1 || reply_.empty()) continue;
+        pollfd readable{client, POLLIN, 0};
+        if (poll(&readable, 1, 0) <= 0) continue;
+        uint8_t request[16];
+        if (recv(client, request, sizeof(request), 0) > 0) {
+          send(client, reply_.data(), reply_.size(), MSG_NOSIGNAL);
+        }
+        close(client);
+        client = -1;
+      }
+    }
+    for (int client : clients) {
+      if (client != -1) close(client);
+    }
+  }
+
+  std::vector<uint8_t> reply_;
+  int socket_ = -1;
+  uint16_t port_ = 0;
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+
+// A loopback port nothing listens on, so probes to it are refused
+uint16_t UnusedPort() {
+  LoopbackListener probe(Ipv4(127, 0, 0, 1), 0, {});
+  return probe.Port();
+}
+
+class EventRecorder {
+public:
+  NetworkScanListener Listener() {
+    return [this](const NetworkScanEvent& event) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      events_.push_back(event);
+    };
+  }
+
+  std::vector<NetworkScanEvent> Events() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return events_;
+  }
+
+  std::vector<ScannedHost> Found() {
+    std::vector<ScannedHost> hosts;
+    for (const NetworkScanEvent& event : Events()) {
+      if (event.type == NetworkScanEventType::kFound) hosts.push_back(event.host);
+    }
+    std::sort(hosts.begin(), hosts.end(), [](const ScannedHost& a, const ScannedHost& b) {
+      return a.address < b.address;
+    });
+    return hosts;
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<NetworkScanEvent> events_;
+};
+
+}  // namespace
+
+TEST(NetworkScanner, ParsesCidrRanges) {
+  Ipv4Range range;
+  ASSERT_TRUE(ParseCidr("192.168.1.77/24", &range));
+  EXPECT_EQ(FormatIpv4(range.first), "192.168.1.1");
+  EXPECT_EQ(range.count, 254u);
+
+  ASSERT_TRUE(ParseCidr("10.0.0.7", &range));
+  EXPECT_EQ(FormatIpv4(range.first), "10.0.0.7");
+  EXPECT_EQ(range.count, 1u);
+
+  ASSERT_TRUE(ParseCidr("10.0.0.6/31", &range));
+  EXPECT_EQ(FormatIpv4(range.first), "10.0.0.6");
+  EXPECT_EQ(range.count, 2u);
+
+  ASSERT_TRUE(ParseCidr("172.16.4.0/22", &range));
+  EXPECT_EQ(FormatIpv4(range.first), "172.16.4.1");
+  EXPECT_EQ(range.count, 1022u);
+
+  EXPECT_FALSE(ParseCidr("10.0.0.0/15", &range));
+  EXPECT_FALSE(ParseCidr("10.0.0.0/33", &range));
+  EXPECT_FALSE(ParseCidr("10.0.0.0/", &range));
+  EXPECT_FALSE(ParseCidr("10.0.0/24", &range));
+  EXPECT_FALSE(ParseCidr("256.0.0.1", &range));
+  EXPECT_FALSE(ParseCidr("10.0.0.1 ", &range));
+  EXPECT_FALSE(ParseCidr("", &range));
+}
+
+TEST(NetworkScanner, FindsListenersOnSeveralPortsAndAddresses) {
+  // Printer with a raw port and an LPD-like second port
+  LoopbackListener printerRaw(Ipv4(127, 0, 0, 2), 0, {kIdleStatus});
+  ASSERT_TRUE(printerRaw.IsListening());
+  const uint16_t rawPort = printerRaw.Port();
+  LoopbackListener printerLpd(Ipv4(127, 0, 0, 2), 0, {});
+  ASSERT_TRUE(printerLpd.IsListening());
+  const uint16_t lpdPort = printerLpd.Port();
+  // Web server on the raw port that answers with something else
+  LoopbackListener webServer(Ipv4(127, 0, 0, 3), rawPort, {'H', 'T', 'T', 'P'});
+  ASSERT_TRUE(webServer.IsListening());
+  // Busy printer that never answers the status request
+  LoopbackListener busyPrinter(Ipv4(127, 0, 0, 4), rawPort, {});
+  ASSERT_TRUE(busyPrinter.IsListening());
+  // Print server with only the second port
+  LoopbackListener printServer(Ipv4(127, 0, 0, 5), lpdPort, {});
+  ASSERT_TRUE(printServer.IsListening());
+
+  Ipv4Range range;
+  ASSERT_TRUE(ParseCidr("127.0.0.0/29", &range));
+  NetworkScanOptions options;
+  options.ports = {rawPort, lpdPort};
+  options.statusPort = rawPort;
+  options.statusTimeout = milliseconds(200);
+
+  EventRecorder recorder;
+  NetworkScanner scanner;
+  ASSERT_TRUE(scanner.Start(range, options, recorder.Listener()));
+  ASSERT_TRUE(scanner.WaitForIdle(milliseconds(5000)));
+
+  std::vector<ScannedHost> found = recorder.Found();
+  ASSERT_EQ(found.size(), 4u);
+  EXPECT_EQ(found[0].address, "127.0.0.2");
+  EXPECT_EQ(found[0].openPorts, (std::vector<uint16_t>{rawPort, lpdPort}));
+  EXPECT_TRUE(found[0].escPos);
+  EXPECT_EQ(found[0].statusByte, kIdleStatus);
+  EXPECT_EQ(found[1].address, "127.0.0.3");
+  EXPECT_EQ(found[1].openPorts, (std::vector<uint16_t>{rawPort}));
+  EXPECT_FALSE(found[1].escPos);
+  EXPECT_EQ(found[2].address, "127.0.0.4");
+  EXPECT_EQ(found[2].openPorts, (std::vector<uint16_t>{rawPort}));
+  EXPECT_FALSE(found[2].escPos);
+  EXPECT_EQ(found[3].address, "127.0.0.5");
+  EXPECT_EQ(found[3].openPorts, (std::vector<uint16_t>{lpdPort}));
+  EXPECT_FALSE(found[3].escPos);
+
+  std::vector<NetworkScanEvent> events = recorder.Events();
+  ASSERT_FALSE(events.empty());
+  const NetworkScanEvent& complete = events.back();
+  EXPECT_EQ(complete.type, NetworkScanEventType::kComplete);
+  EXPECT_EQ(complete.scanned, 6u);
+  EXPECT_EQ(complete.total, 6u);
+  EXPECT_FALSE(complete.cancelled);
+}
+
+TEST(NetworkScanner, ScansA22WithinSeconds) {
+  LoopbackListener printer(Ipv4(127, 1, 2, 77), 0, {kIdleStatus});
+  ASSERT_TRUE(printer.IsListening());
+
+  Ipv4Range range;
+  ASSERT_TRUE(ParseCidr("127.1.0.0/22", &range));
+  NetworkScanOptions options;
+  options.ports = {printer.Port(), UnusedPort(), UnusedPort()};
+  options.statusPort = printer.Port();
+
+  EventRecorder recorder;
+  NetworkScanner scanner;
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(scanner.Start(range, options, recorder.Listener()));
+  ASSERT_TRUE(scanner.WaitForIdle(milliseconds(10000)));
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  std::vector<ScannedHost> found = recorder.Found();
+  ASSERT_EQ(found.size(), 1u);
+  EXPECT_EQ(found[0].address, "127.1.2.77");
+  EXPECT_TRUE(found[0].escPos);
+  EXPECT_EQ(recorder.Events().back().scanned, 1022u);
+  EXPECT_LT(elapsed, milliseconds(5000));
+}
+
+TEST(NetworkScanner, CancelStopsTheScan) {
+  // Holds the status request for far longer than the test waits
+  LoopbackListener busyPrinter(Ipv4(127, 0, 0, 6), 0, {});
+  ASSERT_TRUE(busyPrinter.IsListening());
+
+  Ipv4Range range;
+  ASSERT_TRUE(ParseCidr("127.0.0.6", &range));
+  NetworkScanOptions options;
+  options.ports = {busyPrinter.Port()};
+  options.statusPort = busyPrinter.Port();
+  options.statusTimeout = milliseconds(60000);
+
+  EventRecorder recorder;
+  NetworkScanner scanner;
+  ASSERT_TRUE(scanner.Start(range, options, recorder.Listener()));
+  EXPECT_FALSE(scanner.Start(range, options, recorder.Listener()));
+  std::this_thread::sleep_for(milliseconds(50));
+  scanner.Cancel();
+  ASSERT_TRUE(scanner.WaitForIdle(milliseconds(2000)));
+
+  std::vector<NetworkScanEvent> events = recorder.Events();
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].type, NetworkScanEventType::kComplete);
+  EXPECT_TRUE(events[0].cancelled);
+  EXPECT_EQ(events[0].scanned, 0u);
+
+  // A finished scanner can scan again
+  options.statusTimeout = milliseconds(50);
+  EXPECT_TRUE(scanner.Start(range, options, recorder.Listener()));
+  EXPECT_TRUE(scanner.WaitForIdle(milliseconds(2000)));
+}
+
+}  // namespace test
+}  // namespace windows_printer
+
+#endif  // _WIN32
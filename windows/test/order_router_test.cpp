@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "in_memory_spooler.h"
+#include "order_router.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+Order SampleOrder() {
+  Order order;
+  order.title = "Order 42";
+  order.details = {"Table 7", "Server: Ana"};
+  order.items = {
+      {"Burger", "grill", 2, {"no onions"}, "$20.00"},
+      {"IPA", "drinks", 1, {}, "$6.50"},
+      {"Fries", "fryer", 1, {}, "$4.00"},
+      {"Lemonade", "drinks", 2, {"no ice"}, "$7.00"},
+  };
+  order.total = "$37.50";
+  return order;
+}
+
+std::vector<OrderStation> SampleStations() {
+  OrderStation kitchen;
+  kitchen.name = "KITCHEN";
+  kitchen.printerName = "Kitchen";
+  kitchen.categories = {"grill", "fryer"};
+  OrderStation bar;
+  bar.name = "BAR";
+  bar.printerName = "Bar";
+  bar.categories = {"drinks"};
+  bar.paperSize = EscPosPaperSize::kMm58;
+  OrderStation customer;
+  customer.name = "RECEIPT";
+  customer.printerName = "Front";
+  customer.showPrices = true;
+  return {kitchen, bar, customer};
+}
+
+bool Contains(const std::vector<uint8_t>& data, const std::string& text) {
+  return std::search(data.begin(), data.end(), text.begin(), text.end()) != data.end();
+}
+
+const SpooledJob* FindJob(const std::vector<SpooledJob>& jobs, const std::string& printerName) {
+  for (const SpooledJob& job : jobs) {
+    if (job.printerName == printerName) return &job;
+  }
+  return nullptr;
+}
+
+bool WaitFor(const std::function<bool()>& condition) {
+  for (int i = 0; i < 500; i++) {
+    if (condition()) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST(OrderRouter, SplitsItemsByCategory) {
+  Order order = SampleOrder();
+  order.items.push_back({"Cake", "pastry", 1, {}, ""});
+  std::vector<OrderStation> stations = SampleStations();
+  stations[2].categories = {"drinks"};
+
+  std::vector<size_t> unrouted;
+  auto split = SplitOrder(order, stations, &unrouted);
+  ASSERT_EQ(split.size(), 3u);
+  EXPECT_EQ(split[0], (std::vector<size_t>{0, 2}));
+  EXPECT_EQ(split[1], (std::vector<size_t>{1, 3}));
+  // An item can go to several stations
+  EXPECT_EQ(split[2], (std::vector<size_t>{1, 3}));
+  EXPECT_EQ(unrouted, (std::vector<size_t>{4}));
+}
+
+TEST(OrderRouter, EncodesStationTickets) {
+  const Order order = SampleOrder();
+  const std::vector<OrderStation> stations = SampleStations();
+
+  std::vector<uint8_t> kitchen = EncodeStationTicket(order, stations[0], {0, 2});
+  EXPECT_TRUE(Contains(kitchen, "KITCHEN"));
+  EXPECT_TRUE(Contains(kitchen, "Order 42"));
+  EXPECT_TRUE(Contains(kitchen, "Table 7"));
+  EXPECT_TRUE(Contains(kitchen, "2 x Burger"));
+  EXPECT_TRUE(Contains(kitchen, "   no onions"));
+  EXPECT_TRUE(Contains(kitchen, "1 x Fries"));
+  EXPECT_FALSE(Contains(kitchen, "IPA"));
+  EXPECT_FALSE(Contains(kitchen, "$20.00"));
+  // Ends with feeds and a partial cut
+  const std::vector<uint8_t> cut = {0x0A, 0x0A, 0x0A, 0x1D, 0x56, 0x01, 0x1D, 0x56, 0x41, 0x01};
+  ASSERT_GE(kitchen.size(), cut.size());
+  EXPECT_TRUE(std::equal(cut.begin(), cut.end(), kitchen.end() - cut.size()));
+
+  // Prices are right aligned to the 48 character line
+  std::vector<uint8_t> receipt = EncodeStationTicket(order, stations[2], {0, 1, 2, 3});
+  EXPECT_TRUE(Contains(receipt, "2 x Burger" + std::string(32, ' ') + "$20.00"));
+  EXPECT_TRUE(Contains(receipt, "TOTAL" + std::string(37, ' ') + "$37.50"));
+}
+
+TEST(OrderRouter, RoutesOrderToEveryStation) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  spooler->AddPrinter("Bar");
+  spooler->AddPrinter("Front");
+  std::vector<OrderStation> stations = SampleStations();
+  stations[2].copies = 2;
+
+  OrderRouteResult result = RouteOrder(spooler, SampleOrder(), stations);
+  EXPECT_TRUE(result.AllSucceeded());
+  EXPECT_TRUE(result.unroutedItems.empty());
+  ASSERT_EQ(result.tickets.size(), 3u);
+  EXPECT_EQ(result.tickets[0].station, 0u);
+  EXPECT_EQ(result.tickets[0].items, (std::vector<size_t>{0, 2}));
+  EXPECT_EQ(result.tickets[1].items, (std::vector<size_t>{1, 3}));
+  EXPECT_EQ(result.tickets[2].items.size(), 4u);
+  for (const StationTicket& ticket : result.tickets) {
+    EXPECT_NE(ticket.result.jobId, 0u);
+    EXPECT_LE(ticket.elapsed, result.elapsed);
+  }
+
+  std::vector<SpooledJob> jobs = spooler->Jobs();
+  ASSERT_EQ(jobs.size(), 3u);
+  const SpooledJob* bar = FindJob(jobs, "Bar");
+  ASSERT_NE(bar, nullptr);
+  EXPECT_EQ(bar->documentName, "BAR");
+  EXPECT_TRUE(Contains(bar->data, "2 x Lemonade"));
+  EXPECT_FALSE(Contains(bar->data, "Burger"));
+  // The customer's copies share one job
+  const SpooledJob* front = FindJob(jobs, "Front");
+  ASSERT_NE(front, nullptr);
+  EXPECT_EQ(front->data.size(),
+            2 * EncodeStationTicket(SampleOrder(), stations[2], {0, 1, 2, 3}).size());
+}
+
+TEST(OrderRouter, SkipsStationsWithoutItems) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  spooler->AddPrinter("Bar");
+  Order order = SampleOrder();
+  order.items.resize(1);
+  std::vector<OrderStation> stations = SampleStations();
+  stations.pop_back();
+
+  OrderRouteResult result = RouteOrder(spooler, order, stations);
+  ASSERT_EQ(result.tickets.size(), 1u);
+  EXPECT_EQ(result.tickets[0].station, 0u);
+  ASSERT_EQ(spooler->Jobs().size(), 1u);
+  EXPECT_EQ(spooler->Jobs()[0].printerName, "Kitchen");
+}
+
+TEST(OrderRouter, SubmitsTicketsConcurrently) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  spooler->AddPrinter("Bar");
+  spooler->AddPrinter("Front");
+  // Every printer stalls in its write; all three must be in flight at once
+  spooler->HangNext(SpoolerCall::kWrite, 3);
+
+  auto routing = std::async(std::launch::async, [&spooler]() {
+    return RouteOrder(spooler, SampleOrder(), SampleStations());
+  });
+  EXPECT_TRUE(WaitFor([&spooler]() { return spooler->HungCallCount() == 3; }));
+  spooler->ReleaseHangs();
+
+  OrderRouteResult result = routing.get();
+  EXPECT_TRUE(result.AllSucceeded());
+  EXPECT_EQ(spooler->CompletedJobCount(), 3u);
+}
+
+TEST(OrderRouter, OneFailingPrinterDoesNotHoldUpTheOthers) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Kitchen");
+  spooler->AddPrinter("Front");
+  spooler->HangNext(SpoolerCall::kWrite);
+  OrderRouteOptions options;
+  options.timeout = std::chrono::milliseconds(100);
+
+  // Bar is not installed and one of the others hangs past the deadline
+  OrderRouteResult result = RouteOrder(spooler, SampleOrder(), SampleStations(), options);
+  ASSERT_EQ(result.tickets.size(), 3u);
+  EXPECT_FALSE(result.AllSucceeded());
+  EXPECT_FALSE(result.tickets[1].result.success);
+  EXPECT_EQ(result.tickets[1].result.errorCode, InMemorySpooler::kErrorInvalidPrinterName);
+  const int timedOut = static_cast<int>(std::count_if(
+      result.tickets.begin(), result.tickets.end(),
+      [](const StationTicket& ticket) { return ticket.result.timedOut; }));
+  const int printed = static_cast<int>(std::count_if(
+      result.tickets.begin(), result.tickets.end(),
+      [](const StationTicket& ticket) { return ticket.result.success; }));
+  EXPECT_EQ(timedOut, 1);
+  EXPECT_EQ(printed, 1);
+  EXPECT_LT(result.elapsed, std::chrono::milliseconds(1000));
+
+  EXPECT_TRUE(WaitFor([&spooler]() { return spooler->OpenHandleCount() == 0; }));
+}
+
+}  // namespace test
+}  // namespace windows_printer
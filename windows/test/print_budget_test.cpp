@@ -0,0 +1,274 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "in_memory_spooler.h"
+#include "print_budget.h"
+#include "print_job.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+bool WaitFor(const std::function<bool()>& condition) {
+  for (int i = 0; i < 500; i++) {
+    if (condition()) return true;
+    std::this_thread::sleep_for(milliseconds(10));
+  }
+  return false;
+}
+
+size_t FilesIn(const std::filesystem::path& directory) {
+  size_t count = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+    (void)entry;
+    count++;
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST(PrintBudget, RejectsOverPrinterAndGlobalLimits) {
+  PrintMetrics metrics;
+  PrintBudgetOptions options;
+  options.maxJobsPerPrinter = 2;
+  options.maxBytes = 1000;
+  PrintBudget budget(options, metrics);
+
+  std::shared_ptr<PrintReservation> first;
+  std::shared_ptr<PrintReservation> second;
+  std::shared_ptr<PrintReservation> third;
+  EXPECT_EQ(budget.Admit("Kitchen", 300, OverflowPolicy::kReject, milliseconds(0), &first),
+            AdmitStatus::kAdmitted);
+  EXPECT_TRUE(budget.TryAdmit("Kitchen", 300, &second));
+  // Two jobs is the printer's limit
+  EXPECT_FALSE(budget.TryAdmit("Kitchen", 10, &third));
+  EXPECT_EQ(budget.Admit("Kitchen", 10, OverflowPolicy::kReject, milliseconds(0), &third),
+            AdmitStatus::kRejected);
+  EXPECT_EQ(third, nullptr);
+  // The bar has room of its own, but 600 + 500 bytes is over the global limit
+  EXPECT_EQ(budget.Admit("Bar", 500, OverflowPolicy::kReject, milliseconds(0), &third),
+            AdmitStatus::kRejected);
+  EXPECT_EQ(budget.Admit("Bar", 400, OverflowPolicy::kReject, milliseconds(0), &third),
+            AdmitStatus::kAdmitted);
+
+  EXPECT_EQ(budget.Usage().jobs, 3u);
+  EXPECT_EQ(budget.Usage().bytes, 1000u);
+  EXPECT_EQ(budget.Usage("Kitchen").jobs, 2u);
+  EXPECT_EQ(budget.Usage("Kitchen").bytes, 600u);
+  MetricsSnapshot snapshot = metrics.Snapshot();
+  EXPECT_EQ(snapshot.pendingJobs, 3u);
+  EXPECT_EQ(snapshot.pendingBytes, 1000u);
+  EXPECT_EQ(snapshot.rejectedJobs, 2u);
+
+  first.reset();
+  second.reset();
+  third.reset();
+  EXPECT_EQ(budget.Usage().jobs, 0u);
+  EXPECT_EQ(budget.Usage().bytes, 0u);
+  snapshot = metrics.Snapshot();
+  EXPECT_EQ(snapshot.pendingBytes, 0u);
+  EXPECT_EQ(snapshot.peakPendingBytes, 1000u);
+}
+
+TEST(PrintBudget, AdmitsOversizedJobAlone) {
+  PrintMetrics metrics;
+  PrintBudgetOptions options;
+  options.maxBytesPerPrinter = 100;
+  PrintBudget budget(options, metrics);
+
+  std::shared_ptr<PrintReservation> large;
+  EXPECT_TRUE(budget.TryAdmit("Kitchen", 5000, &large));
+  std::shared_ptr<PrintReservation> small;
+  EXPECT_FALSE(budget.TryAdmit("Kitchen", 1, &small));
+  large.reset();
+  EXPECT_TRUE(budget.TryAdmit("Kitchen", 1, &small));
+}
+
+TEST(PrintBudget, BlocksUntilRoomIsFreed) {
+  PrintMetrics metrics;
+  PrintBudgetOptions options;
+  options.maxJobs = 1;
+  PrintBudget budget(options, metrics);
+
+  std::shared_ptr<PrintReservation> held;
+  ASSERT_TRUE(budget.TryAdmit("Kitchen", 10, &held));
+
+  std::shared_ptr<PrintReservation> waited;
+  auto admitted = std::async(std::launch::async, [&budget, &waited]() {
+    return budget.Admit("Bar", 10, OverflowPolicy::kBlock, milliseconds(0), &waited);
+  });
+  EXPECT_TRUE(WaitFor([&budget]() { return budget.Usage().waiting == 1; }));
+  // Nothing overtakes a waiting job, even where it would fit
+  std::shared_ptr<PrintReservation> other;
+  EXPECT_FALSE(budget.TryAdmit("Bar", 10, &other));
+
+  held.reset();
+  EXPECT_EQ(admitted.get(), AdmitStatus::kAdmitted);
+  EXPECT_NE(waited, nullptr);
+  EXPECT_EQ(budget.Usage("Bar").jobs, 1u);
+  EXPECT_EQ(budget.Usage().waiting, 0u);
+  EXPECT_EQ(metrics.Snapshot().blockedJobs, 1u);
+}
+
+TEST(PrintBudget, TimesOutWaiting) {
+  PrintMetrics metrics;
+  PrintBudgetOptions options;
+  options.maxJobsPerPrinter = 1;
+  PrintBudget budget(options, metrics);
+
+  std::shared_ptr<PrintReservation> held;
+  ASSERT_TRUE(budget.TryAdmit("Kitchen", 10, &held));
+  std::shared_ptr<PrintReservation> waited;
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(budget.Admit("Kitchen", 10, OverflowPolicy::kBlock, milliseconds(50), &waited),
+            AdmitStatus::kTimedOut);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, milliseconds(50));
+  EXPECT_EQ(waited, nullptr);
+  EXPECT_EQ(budget.Usage().waiting, 0u);
+  EXPECT_EQ(metrics.Snapshot().rejectedJobs, 1u);
+}
+
+TEST(PrintBudget, SpillsWaitingDataToDisk) {
+  const std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "windows_printer_budget_test";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+
+  PrintMetrics metrics;
+  PrintBudgetOptions options;
+  options.maxBytes = 4096;
+  options.spillDirectory = directory.string();
+  PrintBudget budget(options, metrics);
+
+  std::shared_ptr<PrintReservation> held;
+  ASSERT_TRUE(budget.TryAdmit("Kitchen", 4096, &held));
+
+  std::vector<uint8_t> image(3000);
+  for (size_t i = 0; i < image.size(); i++) {
+    image[i] = static_cast<uint8_t>(i * 7);
+  }
+  const std::vector<uint8_t> original = image;
+  std::shared_ptr<PrintReservation> spilled;
+  auto admitted = std::async(std::launch::async, [&budget, &image, &spilled]() {
+    return budget.Admit("Kitchen", image.size(), OverflowPolicy::kSpill, milliseconds(0),
+                        &spilled, &image);
+  });
+  ASSERT_TRUE(WaitFor([&budget]() { return budget.Usage().spilledJobs == 1; }));
+  EXPECT_EQ(budget.Usage().spilledBytes, 3000u);
+  EXPECT_EQ(FilesIn(directory), 1u);
+  MetricsSnapshot snapshot = metrics.Snapshot();
+  EXPECT_EQ(snapshot.spilledJobs, 1u);
+  EXPECT_EQ(snapshot.spilledBytes, 3000u);
+  // Only the admitted job is held in memory
+  EXPECT_EQ(snapshot.pendingBytes, 4096u);
+
+  held.reset();
+  EXPECT_EQ(admitted.get(), AdmitStatus::kAdmitted);
+  EXPECT_EQ(image, original);
+  EXPECT_EQ(FilesIn(directory), 0u);
+  EXPECT_EQ(budget.Usage().spilledJobs, 0u);
+  EXPECT_EQ(metrics.Snapshot().spilledBytes, 0u);
+  EXPECT_EQ(metrics.Snapshot().pendingBytes, 3000u);
+  spilled.reset();
+  std::filesystem::remove_all(directory);
+}
+
+TEST(PrintBudget, ReportsSpillFailure) {
+  PrintMetrics metrics;
+  PrintBudgetOptions options;
+  options.maxJobs = 1;
+  options.spillDirectory =
+      (std::filesystem::temp_directory_path() / "windows_printer_missing" / "spill").string();
+  PrintBudget budget(options, metrics);
+
+  std::shared_ptr<PrintReservation> held;
+  ASSERT_TRUE(budget.TryAdmit("Kitchen", 10, &held));
+  std::vector<uint8_t> data(100, 1);
+  std::shared_ptr<PrintReservation> spilled;
+  EXPECT_EQ(budget.Admit("Kitchen", data.size(), OverflowPolicy::kSpill, milliseconds(0),
+                         &spilled, &data),
+            AdmitStatus::kSpillFailed);
+  EXPECT_TRUE(data.empty());
+  EXPECT_EQ(budget.Usage().waiting, 0u);
+}
+
+TEST(PrintBudget, SignalsBackpressure) {
+  PrintMetrics metrics;
+  PrintBudgetOptions options;
+  options.maxJobsPerPrinter = 2;
+  options.maxBytes = 100;
+  PrintBudget budget(options, metrics);
+  std::vector<BackpressureEvent> events;
+  budget.SetListener([&events](const BackpressureEvent& event) { events.push_back(event); });
+
+  std::shared_ptr<PrintReservation> first;
+  std::shared_ptr<PrintReservation> second;
+  std::shared_ptr<PrintReservation> third;
+  ASSERT_TRUE(budget.TryAdmit("Kitchen", 10, &first));
+  ASSERT_TRUE(budget.TryAdmit("Kitchen", 10, &second));
+  // TryAdmit leaves signalling to Admit
+  EXPECT_FALSE(budget.TryAdmit("Kitchen", 10, &third));
+  EXPECT_TRUE(events.empty());
+  EXPECT_EQ(budget.Admit("Kitchen", 10, OverflowPolicy::kReject, milliseconds(0), &third),
+            AdmitStatus::kRejected);
+  // Signalled once while the pressure lasts
+  EXPECT_EQ(budget.Admit("Kitchen", 10, OverflowPolicy::kReject, milliseconds(0), &third),
+            AdmitStatus::kRejected);
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_FALSE(events[0].global);
+  EXPECT_EQ(events[0].printerName, "Kitchen");
+  EXPECT_TRUE(events[0].full);
+  EXPECT_EQ(events[0].jobs, 2u);
+
+  EXPECT_EQ(budget.Admit("Bar", 200, OverflowPolicy::kReject, milliseconds(0), &third),
+            AdmitStatus::kRejected);
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_TRUE(events[1].global);
+  EXPECT_TRUE(events[1].full);
+
+  // Lifted at half the limits
+  first.reset();
+  ASSERT_EQ(events.size(), 4u);
+  EXPECT_EQ(events[2].printerName, "Kitchen");
+  EXPECT_FALSE(events[2].full);
+  EXPECT_EQ(events[2].jobs, 1u);
+  EXPECT_TRUE(events[3].global);
+  EXPECT_FALSE(events[3].full);
+  second.reset();
+  EXPECT_EQ(events.size(), 4u);
+}
+
+TEST(PrintBudget, AbandonedJobStaysCharged) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+  spooler->HangNext(SpoolerCall::kWrite);
+  PrintBudget budget;
+
+  const std::vector<uint8_t> data(2048, 0x0A);
+  RawPrintOptions options;
+  options.timeout = milliseconds(50);
+  ASSERT_TRUE(budget.TryAdmit("Receipt", data.size(), &options.reservation));
+  RawPrintResult result = SubmitRawJob(spooler, "Receipt", data.data(), data.size(), options);
+  EXPECT_TRUE(result.timedOut);
+  options.reservation.reset();
+  // The hung worker still holds its copy of the data
+  EXPECT_EQ(budget.Usage("Receipt").bytes, 2048u);
+
+  spooler->ReleaseHangs();
+  EXPECT_TRUE(WaitFor([&budget]() { return budget.Usage().jobs == 0; }));
+}
+
+}  // namespace test
+}  // namespace windows_printer
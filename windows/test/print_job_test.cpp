@@ -0,0 +1,309 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "in_memory_spooler.h"
+#include "print_job.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+const std::vector<uint8_t> kReceipt = {0x1B, 0x40, 'H', 'i', 0x0A, 0x1D, 0x56, 0x01};
+
+// Polls until condition holds; abandoned workers finish in the background
+bool WaitFor(const std::function<bool()>& condition) {
+  for (int i = 0; i < 500; i++) {
+    if (condition()) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+RawPrintOptions WithTimeout(int milliseconds) {
+  RawPrintOptions options;
+  options.timeout = std::chrono::milliseconds(milliseconds);
+  return options;
+}
+
+}  // namespace
+
+TEST(PrintJob, SubmitsRawDocument) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+
+  RawPrintResult result = SubmitRawJob(spooler, "Receipt", kReceipt.data(), kReceipt.size());
+  EXPECT_TRUE(result.success);
+  EXPECT_EQ(result.jobId, 1u);
+  EXPECT_EQ(result.bytesWritten, kReceipt.size());
+  EXPECT_EQ(result.errorCode, 0u);
+
+  std::vector<SpooledJob> jobs = spooler->Jobs();
+  ASSERT_EQ(jobs.size(), 1u);
+  EXPECT_EQ(jobs[0].printerName, "Receipt");
+  EXPECT_EQ(jobs[0].documentName, "Raw Print Job");
+  EXPECT_EQ(jobs[0].datatype, "RAW");
+  EXPECT_EQ(jobs[0].data, kReceipt);
+  EXPECT_TRUE(jobs[0].completed);
+  EXPECT_EQ(spooler->OpenHandleCount(), 0u);
+}
+
+TEST(PrintJob, UsesDefaultPrinterAndTextDatatype) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Office");
+  spooler->SetDefaultPrinter("Office");
+
+  RawPrintOptions options;
+  options.useRawDatatype = false;
+  RawPrintResult result = SubmitRawJob(spooler, "", kReceipt.data(), kReceipt.size(), options);
+  EXPECT_TRUE(result.success);
+  EXPECT_EQ(result.printerName, "Office");
+
+  std::vector<SpooledJob> jobs = spooler->Jobs();
+  ASSERT_EQ(jobs.size(), 1u);
+  EXPECT_EQ(jobs[0].printerName, "Office");
+  EXPECT_EQ(jobs[0].datatype, "TEXT");
+}
+
+TEST(PrintJob, ReportsMissingPrinters) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  RawPrintResult result = SubmitRawJob(spooler, "", kReceipt.data(), kReceipt.size());
+  EXPECT_FALSE(result.success);
+  EXPECT_EQ(result.errorCode, InMemorySpooler::kErrorNoDefaultPrinter);
+
+  result = SubmitRawJob(spooler, "Unknown", kReceipt.data(), kReceipt.size());
+  EXPECT_FALSE(result.success);
+  EXPECT_EQ(result.jobId, 0u);
+  EXPECT_EQ(result.errorCode, InMemorySpooler::kErrorInvalidPrinterName);
+}
+
+TEST(PrintJob, ContinuesAfterPartialWrites) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+  spooler->SetMaxWriteSize(3);
+
+  RawPrintResult result = SubmitRawJob(spooler, "Receipt", kReceipt.data(), kReceipt.size());
+  EXPECT_TRUE(result.success);
+  EXPECT_EQ(spooler->Jobs()[0].data, kReceipt);
+}
+
+TEST(PrintJob, ClosesPrinterAfterFailures) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+
+  spooler->FailNext(SpoolerCall::kStartDocument, 5);
+  RawPrintResult result = SubmitRawJob(spooler, "Receipt", kReceipt.data(), kReceipt.size());
+  EXPECT_FALSE(result.success);
+  EXPECT_EQ(result.errorCode, 5u);
+  EXPECT_EQ(spooler->OpenHandleCount(), 0u);
+
+  spooler->FailNext(SpoolerCall::kStartPage, 6);
+  result = SubmitRawJob(spooler, "Receipt", kReceipt.data(), kReceipt.size());
+  EXPECT_FALSE(result.success);
+  EXPECT_EQ(result.errorCode, 6u);
+  EXPECT_EQ(spooler->OpenHandleCount(), 0u);
+
+  spooler->FailNext(SpoolerCall::kWrite, 1167);
+  result = SubmitRawJob(spooler, "Receipt", kReceipt.data(), kReceipt.size());
+  EXPECT_FALSE(result.success);
+  EXPECT_NE(result.jobId, 0u);
+  EXPECT_EQ(result.bytesWritten, 0u);
+  EXPECT_EQ(result.errorCode, 1167u);
+  EXPECT_EQ(spooler->OpenHandleCount(), 0u);
+
+  // The document is still ended so the spooler can discard it
+  std::vector<SpooledJob> jobs = spooler->Jobs();
+  ASSERT_EQ(jobs.size(), 2u);
+  EXPECT_TRUE(jobs[1].completed);
+}
+
+TEST(PrintJob, CompletesWithinDeadline) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+
+  RawPrintResult result =
+      SubmitRawJob(spooler, "Receipt", kReceipt.data(), kReceipt.size(), WithTimeout(5000));
+  EXPECT_TRUE(result.success);
+  EXPECT_FALSE(result.timedOut);
+  EXPECT_EQ(spooler->Jobs()[0].data, kReceipt);
+  EXPECT_TRUE(WaitFor([&spooler]() { return spooler->OpenHandleCount() == 0; }));
+}
+
+TEST(PrintJob, CancelsJobWhenWriteHangsPastDeadline) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+  spooler->HangNext(SpoolerCall::kWrite);
+
+  auto start = std::chrono::steady_clock::now();
+  RawPrintResult result =
+      SubmitRawJob(spooler, "Receipt", kReceipt.data(), kReceipt.size(), WithTimeout(50));
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_FALSE(result.success);
+  EXPECT_TRUE(result.timedOut);
+  EXPECT_EQ(result.errorCode, kErrorTimeout);
+  EXPECT_EQ(result.jobId, 1u);
+  EXPECT_GE(elapsed, std::chrono::milliseconds(50));
+  EXPECT_LT(elapsed, std::chrono::milliseconds(2000));
+
+  // Cancelling fails the blocked write, and the worker closes its handle
+  EXPECT_TRUE(WaitFor([&spooler]() {
+    return spooler->HungCallCount() == 0 && spooler->OpenHandleCount() == 0;
+  }));
+  std::vector<SpooledJob> jobs = spooler->Jobs();
+  ASSERT_EQ(jobs.size(), 1u);
+  EXPECT_TRUE(jobs[0].cancelled);
+  EXPECT_FALSE(jobs[0].completed);
+}
+
+TEST(PrintJob, AbandonsHungOpenWithoutStartingJob) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+  spooler->HangNext(SpoolerCall::kOpen);
+
+  RawPrintResult result =
+      SubmitRawJob(spooler, "Receipt", kReceipt.data(), kReceipt.size(), WithTimeout(50));
+  EXPECT_TRUE(result.timedOut);
+  EXPECT_EQ(result.jobId, 0u);
+
+  // The queue comes back after the caller gave up: nothing is printed
+  spooler->ReleaseHangs();
+  EXPECT_TRUE(WaitFor([&spooler]() {
+    return spooler->HungCallCount() == 0 && spooler->OpenHandleCount() == 0;
+  }));
+  EXPECT_TRUE(spooler->Jobs().empty());
+}
+
+TEST(PrintJob, CancelsJobThatStartsAfterDeadline) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+  spooler->HangNext(SpoolerCall::kStartDocument);
+
+  RawPrintResult result =
+      SubmitRawJob(spooler, "Receipt", kReceipt.data(), kReceipt.size(), WithTimeout(50));
+  EXPECT_TRUE(result.timedOut);
+  EXPECT_EQ(result.jobId, 0u);
+
+  spooler->ReleaseHangs();
+  EXPECT_TRUE(WaitFor([&spooler]() { return spooler->OpenHandleCount() == 0; }));
+  std::vector<SpooledJob> jobs = spooler->Jobs();
+  ASSERT_EQ(jobs.size(), 1u);
+  EXPECT_TRUE(jobs[0].cancelled);
+  EXPECT_TRUE(jobs[0].data.empty());
+}
+
+TEST(PrintJob, SharesOwnedDataWithAbandonedWorker) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+  spooler->HangNext(SpoolerCall::kOpen);
+
+  auto data = std::make_shared<const std::vector<uint8_t>>(kReceipt);
+  std::weak_ptr<const std::vector<uint8_t>> watched = data;
+  RawPrintResult result = SubmitRawJob(spooler, "Receipt", std::move(data), WithTimeout(50));
+  EXPECT_TRUE(result.timedOut);
+  // The abandoned worker holds the caller's buffer, not a copy of it
+  EXPECT_FALSE(watched.expired());
+
+  spooler->ReleaseHangs();
+  EXPECT_TRUE(WaitFor([&watched]() { return watched.expired(); }));
+}
+
+TEST(PrintJob, CancelJobRequiresMatchingPrinter) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+  spooler->AddPrinter("Label");
+  ASSERT_TRUE(SubmitRawJob(spooler, "Receipt", kReceipt.data(), kReceipt.size()).success);
+
+  EXPECT_FALSE(spooler->CancelJob("Label", 1));
+  EXPECT_EQ(spooler->LastError(), InMemorySpooler::kErrorInvalidParameter);
+  EXPECT_FALSE(spooler->CancelJob("Receipt", 2));
+  EXPECT_TRUE(spooler->CancelJob("Receipt", 1));
+  EXPECT_TRUE(spooler->Jobs()[0].cancelled);
+}
+
+TEST(PrintJob, RepeatsRawDataForEachCopy) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+  // Even a driver that makes copies gets RAW data straight from the spooler
+  spooler->SetMakesCopies(true);
+
+  RawPrintOptions options;
+  options.copies = 2;
+  RawPrintResult result =
+      SubmitRawJob(spooler, "Receipt", kReceipt.data(), kReceipt.size(), options);
+  EXPECT_TRUE(result.success);
+  EXPECT_FALSE(result.spoolerCopies);
+  EXPECT_EQ(result.bytesWritten, kReceipt.size() * 2);
+
+  std::vector<SpooledJob> jobs = spooler->Jobs();
+  ASSERT_EQ(jobs.size(), 1u);
+  std::vector<uint8_t> expected = kReceipt;
+  expected.insert(expected.end(), kReceipt.begin(), kReceipt.end());
+  EXPECT_EQ(jobs[0].data, expected);
+  EXPECT_EQ(jobs[0].copies, 1u);
+}
+
+TEST(PrintJob, LeavesTextCopiesToTheSpooler) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Office");
+  RawPrintOptions options;
+  options.useRawDatatype = false;
+  options.copies = 3;
+
+  // The driver makes the copies: the data is sent once
+  spooler->SetMakesCopies(true);
+  RawPrintResult result =
+      SubmitRawJob(spooler, "Office", kReceipt.data(), kReceipt.size(), options);
+  EXPECT_TRUE(result.success);
+  EXPECT_TRUE(result.spoolerCopies);
+  EXPECT_EQ(spooler->Jobs()[0].copies, 3u);
+  EXPECT_EQ(spooler->Jobs()[0].data, kReceipt);
+
+  // It does not: the data is repeated
+  spooler->SetMakesCopies(false);
+  result = SubmitRawJob(spooler, "Office", kReceipt.data(), kReceipt.size(), options);
+  EXPECT_TRUE(result.success);
+  EXPECT_FALSE(result.spoolerCopies);
+  EXPECT_EQ(spooler->Jobs()[1].data.size(), kReceipt.size() * 3);
+}
+
+TEST(PrintJob, InsertsCopyVariantsBeforeTheCut) {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Receipt");
+  spooler->SetMaxWriteSize(3);
+
+  RawPrintOptions options;
+  options.copies = 2;
+  options.copyVariants = {{}, {'M', 'E', 'R', 'C', 'H', 'A', 'N', 'T', 0x0A}};
+  RawPrintResult result =
+      SubmitRawJob(spooler, "Receipt", kReceipt.data(), kReceipt.size(), options);
+  EXPECT_TRUE(result.success);
+
+  const std::vector<uint8_t> merchant = {0x1B, 0x40, 'H', 'i', 0x0A, 'M', 'E', 'R', 'C',
+                                         'H',  'A',  'N', 'T', 0x0A, 0x1D, 0x56, 0x01};
+  std::vector<uint8_t> expected = kReceipt;
+  expected.insert(expected.end(), merchant.begin(), merchant.end());
+  EXPECT_EQ(spooler->Jobs()[0].data, expected);
+  EXPECT_EQ(result.bytesWritten, expected.size());
+}
+
+TEST(PrintJob, FindsCopyVariantOffset) {
+  auto offset = [](const std::vector<uint8_t>& data) {
+    return CopyVariantOffset(data.data(), data.size());
+  };
+  // Feeds and both cuts of EscPosEncoder::Cut are skipped, the last line's
+  // line feed is kept
+  EXPECT_EQ(offset({'a', 0x0A, 0x0A, 0x0A, 0x1D, 0x56, 0x00, 0x1D, 0x56, 0x41, 0x00}), 2u);
+  EXPECT_EQ(offset({'a', 0x1B, 0x64, 0x03, 0x1B, 0x69}), 1u);
+  // Without a cut the variant goes at the end
+  EXPECT_EQ(offset({'a', 0x0A, 0x0A}), 3u);
+  EXPECT_EQ(offset({}), 0u);
+}
+
+}  // namespace test
+}  // namespace windows_printer
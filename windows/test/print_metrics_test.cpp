@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "print_metrics.h"
+
+namespace windows_printer {
+namespace test {
+
+TEST(LatencyHistogram, BucketsCoverValuesWithBoundedError) {
+  for (uint64_t value : {0ULL, 1ULL, 15ULL, 16ULL, 17ULL, 1000ULL, 123456ULL,
+                         987654321ULL, (1ULL << 41) + 12345ULL}) {
+    int index = LatencyHistogram::BucketIndex(value);
+    ASSERT_GE(index, 0);
+    ASSERT_LT(index, LatencyHistogram::kBucketCount);
+    uint64_t upper = LatencyHistogram::BucketUpperBound(index);
+    EXPECT_GE(upper, value);
+    EXPECT_LE(static_cast<double>(upper - value), static_cast<double>(value) / 16.0 + 1.0);
+  }
+  EXPECT_EQ(LatencyHistogram::BucketIndex(UINT64_MAX), LatencyHistogram::kBucketCount - 1);
+}
+
+TEST(LatencyHistogram, SummarizesPercentiles) {
+  auto histogram = std::make_unique<LatencyHistogram>();
+  for (uint64_t i = 1; i <= 1000; i++) {
+    histogram->Record(i * 1000);
+  }
+
+  HistogramSummary summary = histogram->Summarize("test");
+  EXPECT_EQ(summary.count, 1000u);
+  EXPECT_EQ(summary.min, 1000u);
+  EXPECT_EQ(summary.max, 1000000u);
+  EXPECT_NEAR(summary.mean, 500500.0, 1.0);
+  EXPECT_NEAR(static_cast<double>(summary.p50), 500000.0, 500000.0 * 0.07);
+  EXPECT_NEAR(static_cast<double>(summary.p99), 990000.0, 990000.0 * 0.07);
+  EXPECT_LE(summary.p999, summary.max);
+
+  histogram->Reset();
+  EXPECT_EQ(histogram->Summarize("test").count, 0u);
+}
+
+TEST(PrintMetrics, AggregatesConcurrentRecordingWithoutLoss) {
+  auto metrics = std::make_unique<PrintMetrics>();
+  const int kThreads = 8;
+  const int kIterations = 20000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&metrics, t]() {
+      const char* method = (t % 2 == 0) ? "printRawData" : "getPrinterProperties";
+      for (int i = 0; i < kIterations; i++) {
+        metrics->QueueEnter();
+        metrics->RecordStage(MetricStage::kWritePrinter, static_cast<uint64_t>(i));
+        metrics->RecordMethod(method, 1000 + static_cast<uint64_t>(i), i % 10 == 0);
+        metrics->RecordBytesWritten(3);
+        if (i % 100 == 0) {
+          metrics->RecordFailure(MetricStage::kOpenPrinter, static_cast<uint32_t>(t % 3));
+        }
+        metrics->QueueExit();
+      }
+    });
+  }
+  // Snapshots taken while writers are running must not disturb them
+  for (int i = 0; i < 20; i++) {
+    metrics->Snapshot();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  MetricsSnapshot snapshot = metrics->Snapshot();
+  const uint64_t total = static_cast<uint64_t>(kThreads) * kIterations;
+
+  EXPECT_EQ(snapshot.bytesWritten, total * 3);
+  EXPECT_EQ(snapshot.queueDepth, 0u);
+  EXPECT_GE(snapshot.peakQueueDepth, 1u);
+  EXPECT_LE(snapshot.peakQueueDepth, static_cast<uint64_t>(kThreads));
+
+  const HistogramSummary& write = snapshot.stages[static_cast<int>(MetricStage::kWritePrinter)];
+  EXPECT_EQ(write.name, "writePrinter");
+  EXPECT_EQ(write.count, total);
+  EXPECT_EQ(write.min, 0u);
+  EXPECT_EQ(write.max, static_cast<uint64_t>(kIterations - 1));
+
+  ASSERT_EQ(snapshot.methods.size(), 2u);
+  for (const MethodSummary& method : snapshot.methods) {
+    EXPECT_EQ(method.latency.count, total / 2);
+    EXPECT_EQ(method.failures, total / 2 / 10);
+    EXPECT_GT(method.callsPerSecond, 0.0);
+  }
+  EXPECT_EQ(snapshot.methods[0].latency.name, "getPrinterProperties");
+
+  uint64_t failures = 0;
+  for (const ErrorCount& error : snapshot.errors) {
+    EXPECT_EQ(error.stage, "openPrinter");
+    EXPECT_LT(error.code, 3u);
+    failures += error.count;
+  }
+  EXPECT_EQ(snapshot.errors.size(), 3u);
+  EXPECT_EQ(failures, total / 100);
+}
+
+TEST(PrintMetrics, ResetClearsCountersButKeepsInFlightDepth) {
+  auto metrics = std::make_unique<PrintMetrics>();
+  metrics->QueueEnter();
+  metrics->RecordMethod("printPdf", 500, true);
+  metrics->RecordFailure(MetricStage::kStartDocPrinter, 5);
+  metrics->RecordBytesWritten(42);
+
+  metrics->Reset();
+  MetricsSnapshot snapshot = metrics->Snapshot();
+  EXPECT_TRUE(snapshot.methods.empty());
+  EXPECT_TRUE(snapshot.errors.empty());
+  EXPECT_EQ(snapshot.bytesWritten, 0u);
+  EXPECT_EQ(snapshot.queueDepth, 1u);
+  EXPECT_EQ(snapshot.peakQueueDepth, 1u);
+
+  metrics->QueueExit();
+  metrics->RecordMethod("printPdf", 700, false);
+  snapshot = metrics->Snapshot();
+  ASSERT_EQ(snapshot.methods.size(), 1u);
+  EXPECT_EQ(snapshot.methods[0].latency.count, 1u);
+  EXPECT_EQ(snapshot.methods[0].failures, 0u);
+}
+
+TEST(PrintMetrics, ScopedStageTimerRecordsOnce) {
+  auto metrics = std::make_unique<PrintMetrics>();
+  {
+    ScopedStageTimer timer(MetricStage::kEncodeResult, *metrics);
+    timer.Stop();
+  }
+  MetricsSnapshot snapshot = metrics->Snapshot();
+  EXPECT_EQ(snapshot.stages[static_cast<int>(MetricStage::kEncodeResult)].count, 1u);
+}
+
+}  // namespace test
+}  // namespace windows_printer
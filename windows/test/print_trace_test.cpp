@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "print_metrics.h"
+#include "print_trace.h"
+
+namespace windows_printer {
+namespace test {
+
+TEST(PrintTracer, SerializesChromeTraceEvents) {
+  std::vector<TraceEvent> events(2);
+  events[0].name = "printRawData";
+  events[0].category = "channel";
+  events[0].startNanos = 1500;
+  events[0].durationNanos = 2000250;
+  events[0].threadId = 1;
+  events[1].name = "write\"Printer\"";
+  events[1].category = "print";
+  events[1].startNanos = 10000;
+  events[1].durationNanos = 42;
+  events[1].threadId = 2;
+  events[1].argName = "bytes";
+  events[1].argValue = 1024;
+
+  EXPECT_EQ(PrintTracer::ToChromeTraceJson(events),
+            "{\"traceEvents\":["
+            "{\"name\":\"printRawData\",\"cat\":\"channel\",\"ph\":\"X\","
+            "\"ts\":1.500,\"dur\":2000.250,\"pid\":1,\"tid\":1},"
+            "{\"name\":\"write\\\"Printer\\\"\",\"cat\":\"print\",\"ph\":\"X\","
+            "\"ts\":10.000,\"dur\":0.042,\"pid\":1,\"tid\":2,\"args\":{\"bytes\":1024}}"
+            "],\"displayTimeUnit\":\"ms\"}");
+  EXPECT_EQ(PrintTracer::ToChromeTraceJson({}),
+            "{\"traceEvents\":[],\"displayTimeUnit\":\"ms\"}");
+}
+
+TEST(PrintTracer, RecordsNothingWhileDisabled) {
+  PrintTracer tracer(16);
+  { ScopedTraceSpan span("ignored", "print", tracer); }
+  EXPECT_TRUE(tracer.Events().empty());
+
+  tracer.SetEnabled(true);
+  {
+    ScopedTraceSpan span("openPrinter", "print", tracer);
+    span.SetArg("jobId", 7);
+  }
+  std::vector<TraceEvent> events = tracer.Events();
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].name, "openPrinter");
+  EXPECT_EQ(events[0].argName, "jobId");
+  EXPECT_EQ(events[0].argValue, 7);
+  EXPECT_GE(events[0].durationNanos, 0);
+
+  tracer.Clear();
+  EXPECT_TRUE(tracer.Events().empty());
+}
+
+TEST(PrintTracer, RingBufferKeepsNewestSpans) {
+  PrintTracer tracer(4);
+  tracer.SetEnabled(true);
+  for (int i = 0; i < 10; i++) {
+    tracer.Record("span", "print", i * 100, i * 100 + 10, "index", i);
+  }
+  std::vector<TraceEvent> events = tracer.Events();
+  ASSERT_EQ(events.size(), 4u);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(events[i].argValue, 6 + i);
+    EXPECT_EQ(events[i].durationNanos, 10);
+  }
+}
+
+TEST(PrintTracer, TruncatesLongNames) {
+  PrintTracer tracer(2);
+  tracer.Record("a_very_long_span_name_that_does_not_fit", "print", 0, 1);
+  std::vector<TraceEvent> events = tracer.Events();
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].name.size(), PrintTracer::kMaxNameLength);
+}
+
+TEST(PrintTracer, ConcurrentWritersProduceWellFormedSpans) {
+  PrintTracer tracer(256);
+  tracer.SetEnabled(true);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&tracer]() {
+      for (int i = 0; i < 5000; i++) {
+        ScopedTraceSpan span("writePrinter", "print", tracer);
+        span.SetArg("bytes", 64);
+      }
+    });
+  }
+  for (int i = 0; i < 50; i++) {
+    for (const TraceEvent& event : tracer.Events()) {
+      ASSERT_EQ(event.name, "writePrinter");
+      ASSERT_EQ(event.argValue, 64);
+    }
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(tracer.Events().size(), 256u);
+}
+
+TEST(PrintTracer, StageTimersEmitSpans) {
+  PrintTracer tracer(8);
+  tracer.SetEnabled(true);
+  auto metrics = std::make_unique<PrintMetrics>();
+  {
+    ScopedStageTimer timer(MetricStage::kWritePrinter, *metrics, tracer);
+    timer.SetTraceArg("bytes", 3);
+  }
+  std::vector<TraceEvent> events = tracer.Events();
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].name, "writePrinter");
+  EXPECT_EQ(events[0].category, "print");
+  EXPECT_EQ(events[0].argValue, 3);
+}
+
+}  // namespace test
+}  // namespace windows_printer
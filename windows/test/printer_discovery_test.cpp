@@ -0,0 +1,263 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "printer_discovery.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+// Enumerator whose connection list can be held back until released
+class FakeEnumerator : public PrinterEnumerator {
+public:
+  void SetLocal(std::vector<std::string> local) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    local_ = std::move(local);
+  }
+
+  void SetConnections(std::vector<std::string> connections) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_ = std::move(connections);
+  }
+
+  // Block EnumerateConnections after the first connection until Release()
+  void HoldConnections() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    held_ = true;
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    held_ = false;
+    released_.notify_all();
+  }
+
+  std::vector<std::string> EnumerateLocal() override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return local_;
+  }
+
+  void EnumerateConnections(const std::function<void(const std::string&)>& onPrinter) override {
+    std::vector<std::string> connections;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      connections = connections_;
+    }
+    for (size_t i = 0; i < connections.size(); i++) {
+      onPrinter(connections[i]);
+      if (i == 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        released_.wait(lock, [this]() { return !held_; });
+      }
+    }
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable released_;
+  std::vector<std::string> local_;
+  std::vector<std::string> connections_;
+  bool held_ = false;
+};
+
+// Collects events delivered to a listener
+class EventLog {
+public:
+  DiscoveryListener Listener() {
+    return [this](const DiscoveryEvent& event) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      events_.push_back(event);
+    };
+  }
+
+  std::vector<DiscoveryEvent> Take() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<DiscoveryEvent> events;
+    events.swap(events_);
+    return events;
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<DiscoveryEvent> events_;
+};
+
+std::string TempPath(const char* name) {
+  std::string path = testing::TempDir() + name;
+  std::remove(path.c_str());
+  return path;
+}
+
+}  // namespace
+
+TEST(PrinterDiscovery, ReportsLocalPrintersBeforeConnectionsResolve) {
+  auto enumerator = std::make_shared<FakeEnumerator>();
+  enumerator->SetLocal({"Receipt", "Label"});
+  enumerator->SetConnections({"\\\\server\\Office", "\\\\server\\Kitchen"});
+  enumerator->HoldConnections();
+
+  EventLog log;
+  PrinterDiscovery discovery(enumerator, "");
+  discovery.Start(log.Listener());
+
+  // Local printers are reported before Start returns, then the first
+  // connection streams in while the rest are still resolving
+  for (int i = 0; i < 500 && discovery.Snapshot().size() < 3; i++) {
+    std::this_thread::sleep_for(milliseconds(10));
+  }
+  std::vector<DiscoveryEvent> events = log.Take();
+  ASSERT_EQ(events.size(), 4u);
+  EXPECT_EQ(events[0].type, DiscoveryEventType::kSnapshot);
+  EXPECT_TRUE(events[0].printers.empty());
+  EXPECT_FALSE(events[0].fromCache);
+  EXPECT_EQ(events[1].type, DiscoveryEventType::kAdded);
+  EXPECT_EQ(events[1].printers[0].name, "Receipt");
+  EXPECT_TRUE(events[1].printers[0].isLocal);
+  EXPECT_EQ(events[2].printers[0].name, "Label");
+  EXPECT_EQ(events[3].type, DiscoveryEventType::kAdded);
+  EXPECT_EQ(events[3].printers[0].name, "\\\\server\\Office");
+  EXPECT_FALSE(events[3].printers[0].isLocal);
+  EXPECT_FALSE(discovery.WaitForIdle(milliseconds(0)));
+
+  enumerator->Release();
+  ASSERT_TRUE(discovery.WaitForIdle(milliseconds(5000)));
+  events = log.Take();
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_EQ(events[0].type, DiscoveryEventType::kAdded);
+  EXPECT_EQ(events[0].printers[0].name, "\\\\server\\Kitchen");
+  EXPECT_EQ(events[1].type, DiscoveryEventType::kComplete);
+  EXPECT_EQ(discovery.Snapshot().size(), 4u);
+}
+
+TEST(PrinterDiscovery, ServesCachedSnapshotThenOnlyChanges) {
+  const std::string path = TempPath("windows_printer_discovery_cache.txt");
+  auto enumerator = std::make_shared<FakeEnumerator>();
+  enumerator->SetLocal({"Receipt"});
+  enumerator->SetConnections({"\\\\server\\Office"});
+
+  {
+    PrinterDiscovery discovery(enumerator, path);
+    discovery.Start(nullptr);
+    ASSERT_TRUE(discovery.WaitForIdle(milliseconds(5000)));
+  }
+
+  // Next start: the label printer was installed, the office queue removed
+  enumerator->SetLocal({"Receipt", "Label"});
+  enumerator->SetConnections({});
+
+  EventLog log;
+  PrinterDiscovery discovery(enumerator, path);
+  discovery.Start(log.Listener());
+  ASSERT_TRUE(discovery.WaitForIdle(milliseconds(5000)));
+
+  std::vector<DiscoveryEvent> events = log.Take();
+  ASSERT_EQ(events.size(), 4u);
+  EXPECT_EQ(events[0].type, DiscoveryEventType::kSnapshot);
+  EXPECT_TRUE(events[0].fromCache);
+  ASSERT_EQ(events[0].printers.size(), 2u);
+  EXPECT_EQ(events[0].printers[0].name, "Receipt");
+  EXPECT_TRUE(events[0].printers[0].isLocal);
+  EXPECT_EQ(events[0].printers[1].name, "\\\\server\\Office");
+  EXPECT_FALSE(events[0].printers[1].isLocal);
+
+  EXPECT_EQ(events[1].type, DiscoveryEventType::kAdded);
+  EXPECT_EQ(events[1].printers[0].name, "Label");
+  EXPECT_EQ(events[2].type, DiscoveryEventType::kRemoved);
+  EXPECT_EQ(events[2].printers[0].name, "\\\\server\\Office");
+  EXPECT_EQ(events[3].type, DiscoveryEventType::kComplete);
+
+  std::vector<DiscoveredPrinter> cached = PrinterDiscovery::LoadSnapshot(path);
+  ASSERT_EQ(cached.size(), 2u);
+  EXPECT_EQ(cached[1].name, "Label");
+  std::remove(path.c_str());
+}
+
+TEST(PrinterDiscovery, RefreshWithoutChangesOnlyCompletes) {
+  auto enumerator = std::make_shared<FakeEnumerator>();
+  enumerator->SetLocal({"Receipt"});
+  enumerator->SetConnections({"\\\\server\\Office"});
+
+  EventLog log;
+  PrinterDiscovery discovery(enumerator, "");
+  discovery.Start(log.Listener());
+  ASSERT_TRUE(discovery.WaitForIdle(milliseconds(5000)));
+  log.Take();
+
+  discovery.Refresh();
+  ASSERT_TRUE(discovery.WaitForIdle(milliseconds(5000)));
+  std::vector<DiscoveryEvent> events = log.Take();
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].type, DiscoveryEventType::kComplete);
+
+  // A second listener gets the full snapshot first
+  discovery.Start(log.Listener());
+  ASSERT_TRUE(discovery.WaitForIdle(milliseconds(5000)));
+  events = log.Take();
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_EQ(events[0].type, DiscoveryEventType::kSnapshot);
+  EXPECT_EQ(events[0].printers.size(), 2u);
+  EXPECT_FALSE(events[0].fromCache);
+}
+
+TEST(PrinterDiscovery, CoalescesRefreshesDuringEnumeration) {
+  auto enumerator = std::make_shared<FakeEnumerator>();
+  enumerator->SetConnections({"\\\\server\\Office"});
+  enumerator->HoldConnections();
+
+  EventLog log;
+  PrinterDiscovery discovery(enumerator, "");
+  discovery.Start(log.Listener());
+  discovery.Refresh();
+  discovery.Refresh();
+  enumerator->Release();
+  ASSERT_TRUE(discovery.WaitForIdle(milliseconds(5000)));
+
+  int completes = 0;
+  for (const auto& event : log.Take()) {
+    if (event.type == DiscoveryEventType::kComplete) completes++;
+  }
+  EXPECT_EQ(completes, 2);
+}
+
+TEST(PrinterDiscovery, StopDetachesListener) {
+  auto enumerator = std::make_shared<FakeEnumerator>();
+  enumerator->SetConnections({"\\\\server\\Office", "\\\\server\\Kitchen"});
+  enumerator->HoldConnections();
+
+  EventLog log;
+  PrinterDiscovery discovery(enumerator, "");
+  discovery.Start(log.Listener());
+  discovery.Stop();
+  log.Take();
+  enumerator->Release();
+  ASSERT_TRUE(discovery.WaitForIdle(milliseconds(5000)));
+
+  EXPECT_TRUE(log.Take().empty());
+  EXPECT_EQ(discovery.Snapshot().size(), 2u);
+}
+
+TEST(PrinterDiscovery, IgnoresMalformedSnapshotLines) {
+  const std::string path = TempPath("windows_printer_discovery_malformed.txt");
+  std::ofstream(path) << "L\tReceipt\nX\tUnknown\n\nC\t\\\\server\\Office\nL\tReceipt\n";
+  std::vector<DiscoveredPrinter> printers = PrinterDiscovery::LoadSnapshot(path);
+  ASSERT_EQ(printers.size(), 2u);
+  EXPECT_EQ(printers[0].name, "Receipt");
+  EXPECT_FALSE(printers[1].isLocal);
+  std::remove(path.c_str());
+
+  EXPECT_TRUE(PrinterDiscovery::LoadSnapshot(path).empty());
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "printer_fields.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+std::vector<std::string> Names(const std::vector<const char*>& names) {
+  return std::vector<std::string>(names.begin(), names.end());
+}
+
+}  // namespace
+
+TEST(PrinterFieldsTest, ParsesSectionNames) {
+  uint32_t fields = 0;
+  std::string unknown;
+  ASSERT_TRUE(ParsePrinterFields({"status", "paperSizes"}, &fields, &unknown));
+  EXPECT_EQ(fields, kPrinterFieldStatus | kPrinterFieldPaperSizes);
+}
+
+TEST(PrinterFieldsTest, EveryNameTogetherSelectsAll) {
+  uint32_t fields = 0;
+  std::string unknown;
+  ASSERT_TRUE(ParsePrinterFields({"isDefault", "status", "info", "attributes", "queue",
+                                  "paperSizes", "resolutions"},
+                                 &fields, &unknown));
+  EXPECT_EQ(fields, kPrinterFieldsAll);
+}
+
+TEST(PrinterFieldsTest, EmptyListSelectsNothing) {
+  uint32_t fields = kPrinterFieldsAll;
+  std::string unknown;
+  ASSERT_TRUE(ParsePrinterFields({}, &fields, &unknown));
+  EXPECT_EQ(fields, 0u);
+}
+
+TEST(PrinterFieldsTest, RejectsUnknownName) {
+  uint32_t fields = kPrinterFieldStatus;
+  std::string unknown;
+  EXPECT_FALSE(ParsePrinterFields({"status", "Status"}, &fields, &unknown));
+  EXPECT_EQ(unknown, "Status");
+  EXPECT_EQ(fields, kPrinterFieldStatus);
+}
+
+TEST(PrinterFieldsTest, StatusOnlyNeedsNoInfo2) {
+  EXPECT_EQ(kPrinterFieldStatus & kPrinterFieldsInfo2, 0u);
+  EXPECT_EQ(kPrinterFieldIsDefault & kPrinterFieldsInfo2, 0u);
+  EXPECT_EQ(kPrinterFieldsInfo2 | kPrinterFieldStatus | kPrinterFieldIsDefault,
+            kPrinterFieldsAll);
+}
+
+TEST(PrinterFieldsTest, NoStatusBitsIsReady) {
+  EXPECT_EQ(Names(PrinterStatusMessages(0)), std::vector<std::string>({"Ready"}));
+}
+
+TEST(PrinterFieldsTest, NamesStatusBitsLowestFirst) {
+  // PRINTER_STATUS_PAUSED | PRINTER_STATUS_OFFLINE | PRINTER_STATUS_POWER_SAVE
+  EXPECT_EQ(Names(PrinterStatusMessages(0x1 | 0x80 | 0x1000000)),
+            std::vector<std::string>({"Paused", "Offline", "Power Save"}));
+}
+
+TEST(PrinterFieldsTest, IgnoresUnknownStatusBits) {
+  EXPECT_TRUE(PrinterStatusMessages(0x80000000u).empty());
+}
+
+TEST(PrinterFieldsTest, NamesAttributeBits) {
+  // PRINTER_ATTRIBUTE_QUEUED | PRINTER_ATTRIBUTE_LOCAL | PRINTER_ATTRIBUTE_PUBLISHED
+  EXPECT_EQ(Names(PrinterAttributeNames(0x1 | 0x40 | 0x2000)),
+            std::vector<std::string>({"Queued", "Local", "Published"}));
+  EXPECT_TRUE(PrinterAttributeNames(0).empty());
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "in_memory_spooler.h"
+#include "raw_print_stream.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+// Collects a stream's events
+class StreamEvents {
+public:
+  PrintStreamListener Listener() {
+    return [this](const PrintStreamEvent& event) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      events_.push_back(event);
+      changed_.notify_all();
+    };
+  }
+
+  // Waits for the count-th event of a type and returns it
+  bool WaitFor(PrintStreamEventType type, PrintStreamEvent* found = nullptr, int count = 1) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return changed_.wait_for(lock, std::chrono::seconds(5), [&]() {
+      int seen = 0;
+      for (const PrintStreamEvent& event : events_) {
+        if (event.type == type && ++seen == count) {
+          if (found) *found = event;
+          return true;
+        }
+      }
+      return false;
+    });
+  }
+
+  int Count(PrintStreamEventType type) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int count = 0;
+    for (const PrintStreamEvent& event : events_) {
+      if (event.type == type) count++;
+    }
+    return count;
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  std::vector<PrintStreamEvent> events_;
+};
+
+std::shared_ptr<InMemorySpooler> LabelPrinter() {
+  auto spooler = std::make_shared<InMemorySpooler>();
+  spooler->AddPrinter("Labels");
+  spooler->SetDefaultPrinter("Labels");
+  return spooler;
+}
+
+RawPrintStreamOptions SmallRing() {
+  RawPrintStreamOptions options;
+  options.capacity = 1024;
+  options.highWatermark = 768;
+  options.lowWatermark = 256;
+  options.maxWriteSize = 100;
+  return options;
+}
+
+std::vector<uint8_t> Label(int index) {
+  std::string label = "^XA^FDLabel " + std::to_string(index) + "^FS^XZ\n";
+  return std::vector<uint8_t>(label.begin(), label.end());
+}
+
+}  // namespace
+
+TEST(RawPrintStream, StreamsLabelsInOrderIntoOneJob) {
+  auto spooler = LabelPrinter();
+  StreamEvents events;
+  std::vector<uint8_t> expected;
+  {
+    RawPrintStream stream(spooler, "Labels", SmallRing(), events.Listener());
+    for (int i = 0; i < 2000; i++) {
+      std::vector<uint8_t> label = Label(i);
+      expected.insert(expected.end(), label.begin(), label.end());
+      size_t written = 0;
+      int pauses = events.Count(PrintStreamEventType::kWritable);
+      while (written < label.size()) {
+        bool full = false;
+        written += stream.Write(label.data() + written, label.size() - written, &full);
+        if (full) {
+          ASSERT_TRUE(events.WaitFor(PrintStreamEventType::kWritable, nullptr, ++pauses));
+        }
+      }
+    }
+    stream.Finish();
+  }
+
+  PrintStreamEvent finished;
+  ASSERT_TRUE(events.WaitFor(PrintStreamEventType::kFinished, &finished));
+  EXPECT_EQ(finished.bytesWritten, expected.size());
+  EXPECT_EQ(finished.printerName, "Labels");
+
+  std::vector<SpooledJob> jobs = spooler->Jobs();
+  ASSERT_EQ(jobs.size(), 1u);
+  EXPECT_EQ(jobs[0].jobId, finished.jobId);
+  EXPECT_TRUE(jobs[0].completed);
+  EXPECT_EQ(jobs[0].datatype, "RAW");
+  EXPECT_EQ(jobs[0].data, expected);
+  EXPECT_EQ(spooler->OpenHandleCount(), 0u);
+}
+
+TEST(RawPrintStream, ReportsFullAboveHighWatermarkAndWritableBelowLow) {
+  auto spooler = LabelPrinter();
+  StreamEvents events;
+  RawPrintStream stream(spooler, "", SmallRing(), events.Listener());
+  ASSERT_TRUE(events.WaitFor(PrintStreamEventType::kStarted));
+
+  spooler->HangNext(SpoolerCall::kWrite);
+  std::vector<uint8_t> data(700, 'A');
+  bool full = true;
+  EXPECT_EQ(stream.Write(data.data(), data.size(), &full), data.size());
+  EXPECT_FALSE(full);
+  // The writer takes the first 100 bytes and hangs writing them
+  std::vector<uint8_t> more(200, 'B');
+  EXPECT_EQ(stream.Write(more.data(), more.size(), &full), more.size());
+  EXPECT_TRUE(full);
+  EXPECT_EQ(events.Count(PrintStreamEventType::kWritable), 0);
+
+  spooler->ReleaseHangs();
+  ASSERT_TRUE(events.WaitFor(PrintStreamEventType::kWritable));
+  EXPECT_LE(stream.Buffered(), 256u);
+  stream.Finish();
+  ASSERT_TRUE(events.WaitFor(PrintStreamEventType::kFinished));
+  EXPECT_EQ(spooler->Jobs().at(0).data.size(), 900u);
+  EXPECT_EQ(events.Count(PrintStreamEventType::kWritable), 1);
+}
+
+TEST(RawPrintStream, FailsForUnknownPrinter) {
+  auto spooler = LabelPrinter();
+  StreamEvents events;
+  RawPrintStream stream(spooler, "Missing", SmallRing(), events.Listener());
+
+  PrintStreamEvent failed;
+  ASSERT_TRUE(events.WaitFor(PrintStreamEventType::kFailed, &failed));
+  EXPECT_EQ(failed.errorCode, InMemorySpooler::kErrorInvalidPrinterName);
+  EXPECT_TRUE(stream.Failed());
+  uint8_t* region = nullptr;
+  EXPECT_EQ(stream.WritableRegion(&region), 0u);
+}
+
+TEST(RawPrintStream, CancelsJobWhenWriteFails) {
+  auto spooler = LabelPrinter();
+  StreamEvents events;
+  RawPrintStream stream(spooler, "Labels", SmallRing(), events.Listener());
+  ASSERT_TRUE(events.WaitFor(PrintStreamEventType::kStarted));
+
+  spooler->FailNext(SpoolerCall::kWrite, InMemorySpooler::kErrorNotSupported);
+  std::vector<uint8_t> label = Label(1);
+  bool full = false;
+  stream.Write(label.data(), label.size(), &full);
+
+  PrintStreamEvent failed;
+  ASSERT_TRUE(events.WaitFor(PrintStreamEventType::kFailed, &failed));
+  EXPECT_EQ(failed.errorCode, InMemorySpooler::kErrorNotSupported);
+  EXPECT_TRUE(spooler->Jobs().at(0).cancelled);
+  EXPECT_EQ(spooler->OpenHandleCount(), 0u);
+}
+
+TEST(RawPrintStream, AbortCancelsJob) {
+  auto spooler = LabelPrinter();
+  StreamEvents events;
+  {
+    RawPrintStream stream(spooler, "Labels", SmallRing(), events.Listener());
+    ASSERT_TRUE(events.WaitFor(PrintStreamEventType::kStarted));
+    std::vector<uint8_t> label = Label(1);
+    bool full = false;
+    stream.Write(label.data(), label.size(), &full);
+    // Destroyed without Finish()
+  }
+
+  ASSERT_TRUE(events.WaitFor(PrintStreamEventType::kCancelled));
+  std::vector<SpooledJob> jobs = spooler->Jobs();
+  ASSERT_EQ(jobs.size(), 1u);
+  EXPECT_TRUE(jobs[0].cancelled);
+  EXPECT_EQ(events.Count(PrintStreamEventType::kFinished), 0);
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "receipt_image.h"
+#include "test_images.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+std::vector<uint8_t> GrayRgba(int width, int height, uint8_t gray) {
+  std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4, gray);
+  for (size_t i = 3; i < rgba.size(); i += 4) rgba[i] = 255;
+  return rgba;
+}
+
+// Feeds rows straight to a rasterizer, bypassing the decoder
+MonoBitmap Rasterize(const std::vector<std::vector<uint8_t>>& rows,
+                     const ReceiptImageOptions& options) {
+  ReceiptRasterizer rasterizer(options);
+  EXPECT_TRUE(rasterizer.Begin(static_cast<int>(rows[0].size()), static_cast<int>(rows.size())));
+  for (size_t y = 0; y < rows.size(); y++) {
+    rasterizer.Row(static_cast<int>(y), rows[y].data());
+  }
+  return rasterizer.TakeBitmap();
+}
+
+}  // namespace
+
+TEST(ReceiptImage, ScalesToPaperWidthKeepingAspectRatio) {
+  const std::vector<uint8_t> rgba = TestPhoto(1000, 501);
+  const std::vector<uint8_t> png = EncodeTestPng(rgba.data(), 1000, 501);
+  ReceiptImageOptions options;
+  options.width = 384;
+  MonoBitmap bitmap;
+  std::string error;
+  ASSERT_TRUE(RasterizeReceiptImage(png.data(), png.size(), options, &bitmap, &error)) << error;
+  EXPECT_EQ(bitmap.Width(), 384);
+  EXPECT_EQ(bitmap.Height(), 192);
+
+  // Enlarging works the same way
+  const std::vector<uint8_t> small = EncodeTestPng(rgba.data(), 10, 5);
+  ASSERT_TRUE(RasterizeReceiptImage(small.data(), small.size(), options, &bitmap, &error));
+  EXPECT_EQ(bitmap.Width(), 384);
+  EXPECT_EQ(bitmap.Height(), 192);
+}
+
+TEST(ReceiptImage, ThresholdMatchesEscPosImageAtFullSize) {
+  const int width = 64;
+  const int height = 20;
+  std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4, 255);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint8_t* pixel = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+      pixel[0] = pixel[1] = pixel[2] = static_cast<uint8_t>(96 + (x * 7 + y * 3) % 64);
+    }
+  }
+  const std::vector<uint8_t> png = EncodeTestPng(rgba.data(), width, height);
+  ReceiptImageOptions options;
+  options.width = width;
+  options.dither = false;
+  MonoBitmap bitmap;
+  ASSERT_TRUE(RasterizeReceiptImage(png.data(), png.size(), options, &bitmap, nullptr));
+  MonoBitmap expected = MonoBitmap::FromRgba(rgba.data(), rgba.size(), width, height);
+  ASSERT_EQ(bitmap.Height(), height);
+  EXPECT_GT(expected.CountBlack(), 0u);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      EXPECT_EQ(bitmap.Get(x, y), expected.Get(x, y)) << x << "," << y;
+    }
+  }
+}
+
+TEST(ReceiptImage, AveragesWhenShrinkingAndInterpolatesWhenEnlarging) {
+  ReceiptImageOptions options;
+  options.dither = false;
+
+  // Pairs of columns average to black, white, black, white
+  options.width = 4;
+  MonoBitmap shrunk = Rasterize({{0, 0, 255, 255, 0, 0, 255, 255},
+                                 {0, 0, 255, 255, 0, 0, 255, 255},
+                                 {40, 0, 255, 210, 0, 60, 255, 255},
+                                 {0, 0, 255, 255, 0, 0, 255, 255}},
+                                options);
+  ASSERT_EQ(shrunk.Height(), 2);
+  for (int y = 0; y < 2; y++) {
+    EXPECT_TRUE(shrunk.Get(0, y));
+    EXPECT_FALSE(shrunk.Get(1, y));
+    EXPECT_TRUE(shrunk.Get(2, y));
+    EXPECT_FALSE(shrunk.Get(3, y));
+  }
+
+  // Black to white across four dots: 0, 64, 191, 255
+  MonoBitmap enlarged = Rasterize({{0, 255}}, options);
+  ASSERT_EQ(enlarged.Height(), 2);
+  for (int y = 0; y < 2; y++) {
+    EXPECT_TRUE(enlarged.Get(0, y));
+    EXPECT_TRUE(enlarged.Get(1, y));
+    EXPECT_FALSE(enlarged.Get(2, y));
+    EXPECT_FALSE(enlarged.Get(3, y));
+  }
+}
+
+TEST(ReceiptImage, DitheringKeepsTheTone) {
+  const std::vector<uint8_t> rgba = GrayRgba(200, 200, 191);
+  const std::vector<uint8_t> png = EncodeTestPng(rgba.data(), 200, 200);
+  ReceiptImageOptions options;
+  options.width = 200;
+  MonoBitmap dithered;
+  ASSERT_TRUE(RasterizeReceiptImage(png.data(), png.size(), options, &dithered, nullptr));
+  // A quarter of the dots for a quarter of the darkness
+  const double black = static_cast<double>(dithered.CountBlack()) / (200 * 200);
+  EXPECT_NEAR(black, 64.0 / 255, 0.01);
+
+  options.dither = false;
+  MonoBitmap thresholded;
+  ASSERT_TRUE(RasterizeReceiptImage(png.data(), png.size(), options, &thresholded, nullptr));
+  EXPECT_EQ(thresholded.CountBlack(), 0u);
+}
+
+TEST(ReceiptImage, DecodesJpeg) {
+  const std::vector<uint8_t> rgba = TestPhoto(640, 480);
+  const std::vector<uint8_t> jpeg = EncodeTestJpeg(rgba.data(), 640, 480, 85);
+  MonoBitmap bitmap;
+  std::string error;
+  ASSERT_TRUE(
+      RasterizeReceiptImage(jpeg.data(), jpeg.size(), ReceiptImageOptions(), &bitmap, &error))
+      << error;
+  EXPECT_EQ(bitmap.Width(), 576);
+  EXPECT_EQ(bitmap.Height(), 432);
+  // The dark box in the middle prints solid
+  EXPECT_TRUE(bitmap.Get(288, 216));
+}
+
+TEST(ReceiptImage, ReportsErrors) {
+  MonoBitmap bitmap;
+  std::string error;
+  const std::vector<uint8_t> text = {'h', 'e', 'l', 'l', 'o'};
+  EXPECT_FALSE(
+      RasterizeReceiptImage(text.data(), text.size(), ReceiptImageOptions(), &bitmap, &error));
+  EXPECT_EQ(error, "Not a PNG or JPEG image");
+
+  // A strip that would print 57600 dots tall
+  const std::vector<uint8_t> rgba = GrayRgba(1, 100, 0);
+  const std::vector<uint8_t> strip = EncodeTestPng(rgba.data(), 1, 100);
+  EXPECT_FALSE(
+      RasterizeReceiptImage(strip.data(), strip.size(), ReceiptImageOptions(), &bitmap, &error));
+  EXPECT_EQ(error, "Image is too tall to print");
+
+  ReceiptImageOptions options;
+  options.width = 0;
+  EXPECT_FALSE(RasterizeReceiptImage(strip.data(), strip.size(), options, &bitmap, &error));
+  EXPECT_EQ(error, "Invalid image width");
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "reprint_cache.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+std::shared_ptr<PreparedDocument> RawDocument(size_t size) {
+  auto document = std::make_shared<PreparedDocument>();
+  document->data.assign(size, 0x1B);
+  return document;
+}
+
+// Key of a document whose content is index
+ReprintCacheKey Key(int index) {
+  const std::string content = "Notice " + std::to_string(index);
+  return MakeReprintCacheKey("Office", "gdi", content.data(), content.size());
+}
+
+}  // namespace
+
+TEST(ReprintCache, KeysByPrinterSettingsAndContent) {
+  const std::string menu = "**Specials**\nSoup of the day";
+  auto key = [](const std::string& printer, std::string_view settings, const std::string& content) {
+    return MakeReprintCacheKey(printer, settings, content.data(), content.size()).hash;
+  };
+  const uint64_t hash = key("Kitchen", "escPos", menu);
+  EXPECT_EQ(hash, key("Kitchen", "escPos", menu));
+  EXPECT_NE(hash, key("Bar", "escPos", menu));
+  EXPECT_NE(hash, key("Kitchen", "gdi", menu));
+  EXPECT_NE(hash, key("Kitchen", "escPos", menu.substr(1)));
+  // Fields do not run into each other
+  EXPECT_NE(key("ab", "c", ""), key("a", "bc", ""));
+
+  const ReprintCacheKey full = MakeReprintCacheKey("Kitchen", "escPos", menu.data(), menu.size());
+  EXPECT_NE(full.check, full.hash);
+  EXPECT_EQ(full.contentSize, menu.size());
+}
+
+TEST(ReprintCache, MissesOnHashCollisions) {
+  ReprintCache cache;
+  const ReprintCacheKey key = Key(1);
+  cache.Insert(key, RawDocument(10));
+
+  // Same hash, different source
+  ReprintCacheKey collision = key;
+  collision.check++;
+  EXPECT_EQ(cache.Find(collision), nullptr);
+  collision = key;
+  collision.contentSize++;
+  EXPECT_EQ(cache.Find(collision), nullptr);
+  cache.Erase(collision);
+  EXPECT_NE(cache.Find(key), nullptr);
+  EXPECT_EQ(cache.Stats().misses, 2u);
+
+  // Inserting the colliding document replaces the first
+  cache.Insert(collision, RawDocument(20));
+  EXPECT_EQ(cache.Find(key), nullptr);
+  EXPECT_EQ(cache.Find(collision)->data.size(), 20u);
+  EXPECT_EQ(cache.Stats().entries, 1u);
+}
+
+TEST(ReprintCache, FindsInsertedDocuments) {
+  ReprintCache cache;
+  EXPECT_EQ(cache.Find(Key(1)), nullptr);
+  auto document = RawDocument(100);
+  cache.Insert(Key(1), document);
+  EXPECT_EQ(cache.Find(Key(1)), document);
+
+  ReprintCacheStats stats = cache.Stats();
+  EXPECT_EQ(stats.entries, 1u);
+  EXPECT_EQ(stats.bytes, document->Bytes());
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 1u);
+
+  cache.Erase(Key(1));
+  EXPECT_EQ(cache.Find(Key(1)), nullptr);
+  EXPECT_EQ(cache.Stats().bytes, 0u);
+}
+
+TEST(ReprintCache, EvictsLeastRecentlyUsed) {
+  ReprintCacheOptions options;
+  options.maxEntries = 2;
+  ReprintCache cache(options);
+  cache.Insert(Key(1), RawDocument(10));
+  cache.Insert(Key(2), RawDocument(10));
+  // Using the first makes the second the least recently used
+  EXPECT_NE(cache.Find(Key(1)), nullptr);
+  cache.Insert(Key(3), RawDocument(10));
+  EXPECT_NE(cache.Find(Key(1)), nullptr);
+  EXPECT_EQ(cache.Find(Key(2)), nullptr);
+  EXPECT_NE(cache.Find(Key(3)), nullptr);
+  EXPECT_EQ(cache.Stats().evictions, 1u);
+}
+
+TEST(ReprintCache, BoundsBytes) {
+  const uint64_t documentBytes = RawDocument(1000)->Bytes();
+  ReprintCacheOptions options;
+  options.maxBytes = documentBytes * 2;
+  ReprintCache cache(options);
+  cache.Insert(Key(1), RawDocument(1000));
+  cache.Insert(Key(2), RawDocument(1000));
+  cache.Insert(Key(3), RawDocument(1000));
+  EXPECT_EQ(cache.Stats().entries, 2u);
+  EXPECT_LE(cache.Stats().bytes, options.maxBytes);
+  EXPECT_EQ(cache.Find(Key(1)), nullptr);
+
+  // Too large to keep at all
+  cache.Insert(Key(4), RawDocument(5000));
+  EXPECT_EQ(cache.Find(Key(4)), nullptr);
+  EXPECT_EQ(cache.Stats().entries, 2u);
+
+  // Shrinking the limits evicts at once; zero turns the cache off
+  options.maxBytes = 0;
+  cache.SetOptions(options);
+  EXPECT_EQ(cache.Stats().entries, 0u);
+  cache.Insert(Key(5), RawDocument(1));
+  EXPECT_EQ(cache.Find(Key(5)), nullptr);
+}
+
+TEST(ReprintCache, EvictedDocumentLivesWhilePrinting) {
+  ReprintCacheOptions options;
+  options.maxEntries = 1;
+  ReprintCache cache(options);
+  cache.Insert(Key(1), RawDocument(100));
+  std::shared_ptr<const PreparedDocument> printing = cache.Find(Key(1));
+  std::weak_ptr<const PreparedDocument> watched = printing;
+  cache.Insert(Key(2), RawDocument(10));
+  EXPECT_EQ(cache.Find(Key(1)), nullptr);
+  ASSERT_FALSE(watched.expired());
+  EXPECT_EQ(printing->data.size(), 100u);
+
+  // The document goes with the last reference
+  printing.reset();
+  EXPECT_TRUE(watched.expired());
+}
+
+}  // namespace test
+}  // namespace windows_printer
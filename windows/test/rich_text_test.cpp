@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+#include "rich_text.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+// Every character is 10 units wide
+int FixedWidth(RichTextFont, std::string_view text) {
+  return static_cast<int>(text.size()) * 10;
+}
+
+// Markup as ESC/POS, without the encoder's leading ESC @
+std::vector<uint8_t> EscPosBytes(std::string_view content) {
+  EscPosEncoder encoder;
+  EncodeRichTextEscPos(content, &encoder);
+  return std::vector<uint8_t>(encoder.Bytes().begin() + 2, encoder.Bytes().end());
+}
+
+std::vector<uint8_t> Bytes(const std::string& text) {
+  return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+}  // namespace
+
+TEST(RichText, ParsesStyledRuns) {
+  RichTextLine line = ParseRichTextLine("Total: **12.50** *incl. tax*", 20);
+  ASSERT_EQ(line.runs.size(), 4u);
+  EXPECT_EQ(line.runs[0].text, "Total: ");
+  EXPECT_EQ(line.runs[0].font, RichTextFont::kNormal);
+  EXPECT_EQ(line.runs[1].text, "12.50");
+  EXPECT_EQ(line.runs[1].font, RichTextFont::kBold);
+  EXPECT_EQ(line.runs[2].text, " ");
+  EXPECT_EQ(line.runs[2].font, RichTextFont::kNormal);
+  EXPECT_EQ(line.runs[3].text, "incl. tax");
+  EXPECT_EQ(line.runs[3].font, RichTextFont::kItalic);
+  EXPECT_EQ(line.lineHeight, 20);
+}
+
+TEST(RichText, CombinesBoldAndItalic) {
+  RichTextLine line = ParseRichTextLine("**bold *both* bold**", 20);
+  ASSERT_EQ(line.runs.size(), 3u);
+  EXPECT_EQ(line.runs[1].text, "both");
+  EXPECT_EQ(line.runs[1].font, RichTextFont::kBoldItalic);
+}
+
+TEST(RichText, LargeTextGrowsLineHeight) {
+  RichTextLine line = ParseRichTextLine("##A## and ##B##", 10);
+  ASSERT_EQ(line.runs.size(), 3u);
+  EXPECT_EQ(line.runs[0].font, RichTextFont::kLarge);
+  EXPECT_EQ(line.runs[1].font, RichTextFont::kNormal);
+  EXPECT_EQ(line.runs[2].font, RichTextFont::kLarge);
+  // 10 * 1.5 = 15, then 15 * 1.5 truncated to 22
+  EXPECT_EQ(line.lineHeight, 22);
+}
+
+TEST(RichText, KeepsPrinterQuirks) {
+  // A * next to ** is printed literally
+  RichTextLine line = ParseRichTextLine("***x", 10);
+  ASSERT_EQ(line.runs.size(), 1u);
+  EXPECT_EQ(line.runs[0].text, "*x");
+  EXPECT_EQ(line.runs[0].font, RichTextFont::kBold);
+
+  // Leaving large text restores bold, not bold italic
+  line = ParseRichTextLine("** *##a##b*", 10);
+  ASSERT_EQ(line.runs.size(), 3u);
+  EXPECT_EQ(line.runs[1].font, RichTextFont::kLarge);
+  EXPECT_EQ(line.runs[2].text, "b");
+  EXPECT_EQ(line.runs[2].font, RichTextFont::kBold);
+
+  // Unterminated markup does not carry over to the next line
+  std::vector<PositionedRichTextRun> runs = LayoutRichText("**open\nplain", 0, 0, 10, FixedWidth);
+  ASSERT_EQ(runs.size(), 2u);
+  EXPECT_EQ(runs[1].font, RichTextFont::kNormal);
+}
+
+TEST(RichText, LaysOutLines) {
+  std::vector<PositionedRichTextRun> runs =
+      LayoutRichText("a**bc**d\n\n##big##\ntail\n", 50, 100, 20, FixedWidth);
+  ASSERT_EQ(runs.size(), 5u);
+  EXPECT_EQ(runs[0].x, 50);
+  EXPECT_EQ(runs[0].y, 100);
+  EXPECT_EQ(runs[1].x, 60);
+  EXPECT_EQ(runs[1].font, RichTextFont::kBold);
+  EXPECT_EQ(runs[2].x, 80);
+  EXPECT_EQ(runs[2].text, "d");
+  // The empty line still advances by one line height
+  EXPECT_EQ(runs[3].y, 140);
+  EXPECT_EQ(runs[3].font, RichTextFont::kLarge);
+  EXPECT_EQ(runs[4].y, 170);
+  EXPECT_EQ(runs[4].text, "tail");
+}
+
+TEST(RichText, EncodesEscPosStyles) {
+  EXPECT_EQ(EscPosBytes("Total: **12.50** *incl. tax*"),
+            Bytes("Total: \x1b" "E\x01" "12.50\x1b" "E" + std::string(1, '\0') +
+                  " \x1b-\x01" "incl. tax\r\n\x1b-" + std::string(1, '\0')));
+
+  // Large text is emphasized double width and height
+  EXPECT_EQ(EscPosBytes("##Order 7##"),
+            Bytes("\x1b" "E\x01\x1d!\x11" "Order 7\r\n\x1b" "E" + std::string(1, '\0') +
+                  "\x1d!" + std::string(1, '\0')));
+}
+
+TEST(RichText, EscPosSendsOnlyStyleChanges) {
+  // Bold to bold italic adds underline only; the style carries across lines
+  // until a run with another style starts
+  EXPECT_EQ(EscPosBytes("**a*b*\n**c**"),
+            Bytes("\x1b" "E\x01" "a\x1b-\x01" "b\r\n\x1b-" + std::string(1, '\0') +
+                  "c\r\n\x1b" "E" + std::string(1, '\0')));
+
+  // Plain text, CRLF line ends and blank lines send no style commands
+  EXPECT_EQ(EscPosBytes("one\r\n\ntwo\n"), Bytes("one\r\n\r\ntwo\r\n"));
+  EXPECT_TRUE(EscPosBytes("").empty());
+}
+
+TEST(RichText, DetectsReceiptPrinters) {
+  EXPECT_TRUE(IsReceiptPrinter("EPSON TM-T88V Receipt", 0));
+  EXPECT_TRUE(IsReceiptPrinter("Star TSP100 Cutter (TSP143)", 0));
+  EXPECT_TRUE(IsReceiptPrinter("XP-80C", 0));
+  EXPECT_TRUE(IsReceiptPrinter("POS-58", 0));
+  EXPECT_TRUE(IsReceiptPrinter("Generic / Text Only", 800));
+
+  EXPECT_FALSE(IsReceiptPrinter("Microsoft Print to PDF", 2100));
+  EXPECT_FALSE(IsReceiptPrinter("Microsoft XPS Document Writer", 0));
+  // "pos" inside a word is not a receipt printer
+  EXPECT_FALSE(IsReceiptPrinter("HP PostScript Universal", 0));
+  // Narrow label printers use their own languages
+  EXPECT_FALSE(IsReceiptPrinter("ZDesigner GK420d", 1040));
+  EXPECT_FALSE(IsReceiptPrinter("Brother QL-800", 620));
+}
+
+}  // namespace test
+}  // namespace windows_printer
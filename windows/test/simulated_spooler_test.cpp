@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "print_job.h"
+#include "simulated_spooler.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<QueuedJob> Queue(SimulatedSpooler& spooler, const std::string& printerName) {
+  std::vector<QueuedJob> jobs;
+  EXPECT_TRUE(spooler.EnumerateJobs(printerName, &jobs));
+  return jobs;
+}
+
+}  // namespace
+
+TEST(SimulatedSpooler, PrintsAtConfiguredSpeed) {
+  auto spooler = std::make_shared<SimulatedSpooler>();
+  SimulatedPrinterOptions options;
+  options.bytesPerSecond = 100000;
+  options.bufferSize = 1000;
+  spooler->AddPrinter("Receipt", options);
+  std::vector<uint8_t> data(6000, 'A');
+
+  // The first 1000 bytes fill the buffer; the rest wait for it to drain
+  const Clock::time_point start = Clock::now();
+  RawPrintResult result = SubmitRawJob(spooler, "Receipt", data.data(), data.size());
+  const Clock::duration submitTime = Clock::now() - start;
+  ASSERT_TRUE(result.success);
+  EXPECT_EQ(result.bytesWritten, data.size());
+  EXPECT_GE(submitTime, std::chrono::milliseconds(50));
+  EXPECT_LT(submitTime, std::chrono::milliseconds(1000));
+
+  // Queued until the buffered bytes have printed, 10 ms later
+  std::vector<QueuedJob> queue = Queue(*spooler, "Receipt");
+  if (Clock::now() - start < std::chrono::milliseconds(60)) {
+    ASSERT_EQ(queue.size(), 1u);
+    EXPECT_EQ(queue[0].jobId, result.jobId);
+    EXPECT_EQ(queue[0].status, kJobStatusPrinting);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_TRUE(Queue(*spooler, "Receipt").empty());
+  EXPECT_EQ(spooler->CompletedJobCount(), 1u);
+  EXPECT_EQ(spooler->OpenHandleCount(), 0u);
+}
+
+TEST(SimulatedSpooler, InstantPrinterKeepsNothingQueued) {
+  auto spooler = std::make_shared<SimulatedSpooler>();
+  SimulatedPrinterOptions options;
+  options.bytesPerSecond = 0;
+  spooler->AddPrinter("Fast", options);
+  std::vector<uint8_t> data(1 << 20, 'A');
+
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(SubmitRawJob(spooler, "", data.data(), data.size()).success);
+  }
+  EXPECT_TRUE(Queue(*spooler, "Fast").empty());
+  EXPECT_EQ(spooler->QueuedJobCount(), 0u);
+  EXPECT_EQ(spooler->CompletedJobCount(), 100u);
+}
+
+TEST(SimulatedSpooler, FailsJobsAtConfiguredRate) {
+  auto spooler = std::make_shared<SimulatedSpooler>(7);
+  SimulatedPrinterOptions options;
+  options.bytesPerSecond = 0;
+  options.failureRate = 0.25;
+  spooler->AddPrinter("Flaky", options);
+  const std::vector<uint8_t> data(64, 'A');
+
+  int failed = 0;
+  for (int i = 0; i < 1000; i++) {
+    RawPrintResult result = SubmitRawJob(spooler, "Flaky", data.data(), data.size());
+    if (!result.success) {
+      EXPECT_EQ(result.errorCode, SimulatedSpooler::kErrorNotReady);
+      failed++;
+    }
+  }
+  EXPECT_GT(failed, 200);
+  EXPECT_LT(failed, 300);
+  EXPECT_EQ(spooler->FailedJobCount(), static_cast<uint64_t>(failed));
+  EXPECT_EQ(spooler->OpenHandleCount(), 0u);
+}
+
+TEST(SimulatedSpooler, AddsLatencyToOpenAndStart) {
+  auto spooler = std::make_shared<SimulatedSpooler>();
+  SimulatedPrinterOptions options;
+  options.bytesPerSecond = 0;
+  options.latency = std::chrono::milliseconds(20);
+  spooler->AddPrinter("Remote", options);
+  const std::vector<uint8_t> data(64, 'A');
+
+  const Clock::time_point start = Clock::now();
+  EXPECT_TRUE(SubmitRawJob(spooler, "Remote", data.data(), data.size()).success);
+  EXPECT_GE(Clock::now() - start, std::chrono::milliseconds(40));
+
+  EXPECT_FALSE(SubmitRawJob(spooler, "Missing", data.data(), data.size()).success);
+  EXPECT_EQ(spooler->LastError(), SimulatedSpooler::kErrorInvalidPrinterName);
+}
+
+}  // namespace test
+}  // namespace windows_printer
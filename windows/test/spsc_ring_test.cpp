@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "spsc_ring.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+// Byte at a stream position; 251 is prime, so the pattern never lines up
+// with the power-of-two ring
+uint8_t PatternByte(uint64_t position) {
+  return static_cast<uint8_t>(position % 251);
+}
+
+}  // namespace
+
+TEST(SpscRing, RoundsCapacityUpToPowerOfTwo) {
+  EXPECT_EQ(SpscRing(1).Capacity(), 64u);
+  EXPECT_EQ(SpscRing(1000).Capacity(), 1024u);
+  EXPECT_EQ(SpscRing(4096).Capacity(), 4096u);
+}
+
+TEST(SpscRing, WritesUntilFullAndReadsBack) {
+  SpscRing ring(64);
+  std::vector<uint8_t> data(100);
+  for (size_t i = 0; i < data.size(); i++) data[i] = PatternByte(i);
+
+  EXPECT_EQ(ring.Write(data.data(), data.size()), 64u);
+  EXPECT_EQ(ring.Size(), 64u);
+  uint8_t* region = nullptr;
+  EXPECT_EQ(ring.WritableRegion(&region), 0u);
+
+  std::vector<uint8_t> out(100);
+  EXPECT_EQ(ring.Read(out.data(), out.size()), 64u);
+  EXPECT_EQ(ring.Size(), 0u);
+  for (size_t i = 0; i < 64; i++) EXPECT_EQ(out[i], PatternByte(i));
+}
+
+TEST(SpscRing, RegionsStopAtTheWrap) {
+  SpscRing ring(64);
+  std::vector<uint8_t> data(48, 0xAA);
+  ASSERT_EQ(ring.Write(data.data(), data.size()), 48u);
+  std::vector<uint8_t> out(40);
+  ASSERT_EQ(ring.Read(out.data(), out.size()), 40u);
+
+  // 56 bytes are free, but only 16 before the end of the buffer
+  uint8_t* region = nullptr;
+  EXPECT_EQ(ring.WritableRegion(&region), 16u);
+  ring.Commit(16);
+  EXPECT_EQ(ring.WritableRegion(&region), 40u);
+
+  // The reader may see the 24 bytes in more than one region, but none runs
+  // past the end of the buffer
+  size_t read = 0;
+  const uint8_t* readable = nullptr;
+  while (size_t size = ring.ReadableRegion(&readable)) {
+    EXPECT_LE(static_cast<size_t>(readable - region) + size, ring.Capacity());
+    ring.Release(size);
+    read += size;
+  }
+  EXPECT_EQ(read, 24u);
+  EXPECT_EQ(ring.Size(), 0u);
+}
+
+TEST(SpscRing, KeepsOrderAcrossThreads) {
+  constexpr uint64_t kTotal = 8 << 20;
+  SpscRing ring(4096);
+
+  std::thread producer([&ring]() {
+    std::mt19937 random(1);
+    std::vector<uint8_t> chunk(3000);
+    uint64_t position = 0;
+    while (position < kTotal) {
+      size_t size = std::min<uint64_t>(1 + random() % chunk.size(), kTotal - position);
+      for (size_t i = 0; i < size; i++) chunk[i] = PatternByte(position + i);
+      size_t written = 0;
+      while (written < size) {
+        size_t count = ring.Write(chunk.data() + written, size - written);
+        // Full; let the reader run when both share a core
+        if (count == 0) std::this_thread::yield();
+        written += count;
+      }
+      position += size;
+    }
+  });
+
+  std::mt19937 random(2);
+  std::vector<uint8_t> chunk(5000);
+  uint64_t position = 0;
+  uint64_t mismatches = 0;
+  while (position < kTotal) {
+    size_t read = ring.Read(chunk.data(), 1 + random() % chunk.size());
+    if (read == 0) std::this_thread::yield();
+    for (size_t i = 0; i < read; i++) {
+      if (chunk[i] != PatternByte(position + i)) mismatches++;
+    }
+    position += read;
+  }
+  producer.join();
+
+  EXPECT_EQ(mismatches, 0u);
+  EXPECT_EQ(ring.Size(), 0u);
+}
+
+TEST(SpscRing, KeepsOrderThroughRegions) {
+  constexpr uint64_t kTotal = 8 << 20;
+  SpscRing ring(1024);
+
+  std::thread producer([&ring]() {
+    uint64_t position = 0;
+    while (position < kTotal) {
+      uint8_t* region = nullptr;
+      size_t size = std::min<uint64_t>(ring.WritableRegion(&region), kTotal - position);
+      if (size == 0) std::this_thread::yield();
+      for (size_t i = 0; i < size; i++) region[i] = PatternByte(position + i);
+      ring.Commit(size);
+      position += size;
+    }
+  });
+
+  uint64_t position = 0;
+  uint64_t mismatches = 0;
+  while (position < kTotal) {
+    const uint8_t* region = nullptr;
+    size_t size = ring.ReadableRegion(&region);
+    if (size == 0) std::this_thread::yield();
+    for (size_t i = 0; i < size; i++) {
+      if (region[i] != PatternByte(position + i)) mismatches++;
+    }
+    ring.Release(size);
+    position += size;
+  }
+  producer.join();
+
+  EXPECT_EQ(mismatches, 0u);
+}
+
+}  // namespace test
+}  // namespace windows_printer
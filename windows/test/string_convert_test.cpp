@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "string_convert.h"
+
+namespace windows_printer {
+namespace test {
+
+TEST(StringConvert, RoundTripsValidText) {
+  const std::string utf8 = "Caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x96\xA8 ok";
+  std::u16string utf16 = Utf8ToUtf16<char16_t>(utf8);
+  EXPECT_EQ(utf16, u"Caf\u00E9 \u20AC \U0001F5A8 ok");
+  EXPECT_EQ(Utf16ToUtf8<char16_t>(utf16), utf8);
+
+  EXPECT_TRUE(Utf8ToUtf16<char16_t>("").empty());
+  EXPECT_TRUE(Utf16ToUtf8<char16_t>(u"").empty());
+}
+
+TEST(StringConvert, ReplacesMalformedUtf8) {
+  // Truncated sequence, overlong encoding, encoded surrogate, out of range
+  EXPECT_EQ(Utf8ToUtf16<char16_t>("a\xE2\x82"), u"a\uFFFD");
+  EXPECT_EQ(Utf8ToUtf16<char16_t>("\xC0\xAF"), u"\uFFFD\uFFFD");
+  EXPECT_EQ(Utf8ToUtf16<char16_t>("\xED\xA0\x80x"), u"\uFFFDx");
+  EXPECT_EQ(Utf8ToUtf16<char16_t>("\xF4\x90\x80\x80"), u"\uFFFD");
+  EXPECT_EQ(Utf8ToUtf16<char16_t>("\xE2\x82x"), u"\uFFFDx");
+}
+
+TEST(StringConvert, ReplacesLoneSurrogates) {
+  std::u16string utf16 = u"a";
+  utf16 += static_cast<char16_t>(0xD83D);
+  utf16 += u"b";
+  utf16 += static_cast<char16_t>(0xDE00);
+  EXPECT_EQ(Utf16ToUtf8<char16_t>(utf16), "a\xEF\xBF\xBD" "b\xEF\xBF\xBD");
+}
+
+TEST(StringConvert, KeepsEmbeddedNul) {
+  std::string utf8("a\0b", 3);
+  EXPECT_EQ(Utf8ToUtf16<char16_t>(utf8).size(), 3u);
+}
+
+TEST(StringConvert, NonAsciiAtEveryBlockPosition) {
+  // Moves a multi-byte character through and past the 16 character ASCII blocks
+  for (size_t prefix = 0; prefix < 40; prefix++) {
+    const std::string utf8 = std::string(prefix, 'a') + "\xE2\x82\xAC" + std::string(20, 'b');
+    const std::u16string utf16 = std::u16string(prefix, u'a') + u"\u20AC" + std::u16string(20, u'b');
+    EXPECT_EQ(Utf8ToUtf16<char16_t>(utf8), utf16) << prefix;
+    EXPECT_EQ(Utf16ToUtf8<char16_t>(utf16), utf8) << prefix;
+  }
+
+  // 0x80 and 0xFF are one bit past ASCII in UTF-16
+  std::u16string latin(32, u'x');
+  latin[17] = 0x80;
+  latin[30] = 0xFF;
+  EXPECT_EQ(Utf8ToUtf16<char16_t>(Utf16ToUtf8<char16_t>(latin)), latin);
+}
+
+TEST(StringConvert, WritesIntoCallerBuffers) {
+  const std::string utf8 = "Kitchen \xF0\x9F\x96\xA8 printer";
+  std::u16string utf16(MaxUtf16Length(utf8.size()), u'#');
+  const size_t units = Utf8ToUtf16(utf8, &utf16[0]);
+  EXPECT_EQ(utf16.substr(0, units), u"Kitchen \U0001F5A8 printer");
+  // Nothing past the returned length is touched
+  EXPECT_EQ(utf16.substr(units), std::u16string(utf16.size() - units, u'#'));
+
+  // A lone surrogate is the longest UTF-8 per code unit
+  const std::u16string worst(4, static_cast<char16_t>(0xD800));
+  std::string back(MaxUtf8Length(worst.size()), '#');
+  EXPECT_EQ(Utf16ToUtf8<char16_t>(worst, &back[0]), back.size());
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "string_intern.h"
+
+namespace windows_printer {
+namespace test {
+
+TEST(StringIntern, ConvertsOnceAndShares) {
+  Utf16InternTable<char16_t> table;
+  std::shared_ptr<const std::u16string> first = table.Intern("Caf\xC3\xA9 receipt");
+  EXPECT_EQ(*first, u"Caf\u00E9 receipt");
+
+  // The same string, from a different buffer, is the same object
+  const std::string copy = "Caf\xC3\xA9 receipt";
+  EXPECT_EQ(table.Intern(copy).get(), first.get());
+  EXPECT_NE(table.Intern("other").get(), first.get());
+  EXPECT_EQ(table.Size(), 2u);
+}
+
+TEST(StringIntern, StartsOverWhenFull) {
+  Utf16InternTable<char16_t> table(2);
+  std::shared_ptr<const std::u16string> kept = table.Intern("a");
+  table.Intern("b");
+  table.Intern("c");
+  EXPECT_EQ(table.Size(), 1u);
+  // Strings handed out before stay valid
+  EXPECT_EQ(*kept, u"a");
+
+  table.Clear();
+  EXPECT_EQ(table.Size(), 0u);
+  EXPECT_EQ(*kept, u"a");
+}
+
+TEST(StringIntern, ConcurrentLookupsAgree) {
+  Utf16InternTable<char16_t> table;
+  const std::vector<std::string> names = {"EPSON TM-T88VI", "Kitchen", "Bar", "Office PDF"};
+  std::vector<std::vector<const std::u16string*>> seen(8);
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < seen.size(); t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < 1000; i++) {
+        seen[t].push_back(table.Intern(names[static_cast<size_t>(i) % names.size()]).get());
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(table.Size(), names.size());
+  for (size_t t = 0; t < seen.size(); t++) {
+    for (size_t i = 0; i < seen[t].size(); i++) {
+      EXPECT_EQ(seen[t][i], table.Intern(names[i % names.size()]).get());
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "task_pool.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+// Holds a worker until opened, so tests can queue behind it
+class Gate {
+public:
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    entered_ = true;
+    changed_.notify_all();
+    changed_.wait(lock, [this] { return open_; });
+  }
+
+  void WaitUntilEntered() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] { return entered_; });
+  }
+
+  void Open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_ = true;
+    changed_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  bool entered_ = false;
+  bool open_ = false;
+};
+
+}  // namespace
+
+TEST(TaskPool, SizesToTheMachine) {
+  TaskPool pool;
+  EXPECT_EQ(pool.Threads(), std::max(1u, std::thread::hardware_concurrency()));
+  EXPECT_EQ(TaskPool(3).Threads(), 3u);
+  EXPECT_GE(SharedTaskPool().Threads(), 1u);
+  EXPECT_EQ(&SharedTaskPool(), &SharedTaskPool());
+}
+
+TEST(TaskPool, RunsEveryTask) {
+  TaskPool pool(4);
+  std::atomic<int> sum{0};
+  {
+    TaskGroup group(pool);
+    for (int i = 1; i <= 1000; i++) {
+      group.Run([&sum, i] { sum += i; });
+    }
+    EXPECT_TRUE(group.Wait());
+  }
+  EXPECT_EQ(sum.load(), 500500);
+  EXPECT_EQ(pool.Stats().executed, 1000u);
+
+  // Plain submissions run too, by the time the pool is destroyed
+  std::atomic<int> submitted{0};
+  {
+    TaskPool shortLived(2);
+    for (int i = 0; i < 50; i++) {
+      shortLived.Submit([&submitted] { submitted++; });
+    }
+  }
+  EXPECT_EQ(submitted.load(), 50);
+}
+
+TEST(TaskPool, HigherPrioritiesRunFirst) {
+  TaskPool pool(1);
+  Gate gate;
+  TaskGroup group(pool);
+  group.Run([&gate] { gate.Wait(); });
+  gate.WaitUntilEntered();
+
+  std::mutex mutex;
+  std::vector<int> order;
+  auto record = [&](int value) {
+    return [&, value] {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(value);
+    };
+  };
+  group.Run(record(3), TaskPriority::kLow);
+  group.Run(record(2), TaskPriority::kNormal);
+  group.Run(record(1), TaskPriority::kHigh);
+  group.Run(record(3), TaskPriority::kLow);
+  group.Run(record(1), TaskPriority::kHigh);
+  gate.Open();
+  // Waiting here rather than in Wait, which would run tasks on this thread
+  // alongside the worker
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (order.size() == 5) break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  group.Wait();
+  EXPECT_EQ(order, (std::vector<int>{1, 1, 2, 3, 3}));
+}
+
+TEST(TaskPool, CancelDropsQueuedTasks) {
+  TaskPool pool(1);
+  Gate gate;
+  std::atomic<int> ran{0};
+  std::atomic<bool> sawCancel{false};
+  TaskGroup group(pool);
+  group.Run([&] {
+    gate.Wait();
+    sawCancel = group.Cancelled();
+  });
+  gate.WaitUntilEntered();
+  for (int i = 0; i < 20; i++) {
+    group.Run([&ran] { ran++; });
+  }
+
+  // Another group on the same pool is unaffected
+  TaskGroup other(pool);
+  other.Run([&ran] { ran += 100; });
+
+  group.Cancel();
+  gate.Open();
+  EXPECT_FALSE(group.Wait());
+  EXPECT_TRUE(other.Wait());
+  EXPECT_EQ(ran.load(), 100);
+  EXPECT_TRUE(sawCancel.load());
+  EXPECT_EQ(pool.Stats().cancelled, 20u);
+}
+
+TEST(TaskPool, IdleWorkersStealQueuedTasks) {
+  TaskPool pool(2);
+  std::mutex mutex;
+  std::condition_variable changed;
+  int finished = 0;
+  bool outerDone = false;
+  // Submitted rather than run in a group, so this thread does not help
+  pool.Submit([&] {
+    // Queued on this worker, which then blocks without helping: only the
+    // other worker can run them
+    TaskGroup inner(pool);
+    for (int i = 0; i < 2; i++) {
+      inner.Run([&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished++;
+        changed.notify_all();
+      });
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] { return finished == 2; });
+    outerDone = true;
+    changed.notify_all();
+  });
+  std::unique_lock<std::mutex> lock(mutex);
+  changed.wait(lock, [&] { return outerDone; });
+  EXPECT_GE(pool.Stats().stolen, 2u);
+}
+
+TEST(TaskPool, NestedWaitsDoNotStarveThePool) {
+  // Every worker waits on tasks of its own; the waits run them
+  TaskPool pool(2);
+  std::atomic<int> leaves{0};
+  ParallelFor(pool, 8, 1, [&](size_t, size_t) {
+    ParallelFor(pool, 16, 1, [&](size_t, size_t) { leaves++; });
+  });
+  EXPECT_EQ(leaves.load(), 8 * 16);
+}
+
+TEST(TaskPool, ParallelForCoversTheRangeOnce) {
+  TaskPool pool(3);
+  std::vector<std::atomic<int>> hits(1001);
+  ParallelFor(pool, hits.size(), 64, [&](size_t begin, size_t end) {
+    EXPECT_LE(end - begin, 64u);
+    for (size_t i = begin; i < end; i++) hits[i]++;
+  });
+  for (size_t i = 0; i < hits.size(); i++) {
+    EXPECT_EQ(hits[i].load(), 1) << i;
+  }
+
+  bool called = false;
+  ParallelFor(pool, 0, 8, [&](size_t, size_t) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+}  // namespace test
+}  // namespace windows_printer
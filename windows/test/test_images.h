@@ -0,0 +1,417 @@
+#ifndef FLUTTER_PLUGIN_TEST_TEST_IMAGES_H_
+#define FLUTTER_PLUGIN_TEST_TEST_IMAGES_H_
+
+// Minimal PNG and JPEG encoders for the image decoder's tests and
+// benchmarks, so images of any size can be made without checking in binary
+// files. Neither aims at small output.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace windows_printer {
+namespace test {
+
+namespace images {
+
+inline void AppendBigEndian(std::vector<uint8_t>& out, uint32_t value, int bytes) {
+  for (int i = bytes - 1; i >= 0; i--) {
+    out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+  }
+}
+
+inline void AppendPngChunk(std::vector<uint8_t>& out, const char* type,
+                           const std::vector<uint8_t>& data) {
+  AppendBigEndian(out, static_cast<uint32_t>(data.size()), 4);
+  const size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = start; i < out.size(); i++) {
+    crc ^= out[i];
+    for (int k = 0; k < 8; k++) {
+      crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+    }
+  }
+  AppendBigEndian(out, crc ^ 0xFFFFFFFFu, 4);
+}
+
+// Bits least significant first, as deflate packs them
+class DeflateWriter {
+public:
+  explicit DeflateWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+  void Write(uint32_t bits, int count) {
+    accumulator_ |= static_cast<uint64_t>(bits) << used_;
+    used_ += count;
+    while (used_ >= 8) {
+      out_.push_back(static_cast<uint8_t>(accumulator_));
+      accumulator_ >>= 8;
+      used_ -= 8;
+    }
+  }
+
+  // Fixed Huffman code of a literal or end of block, most significant bit
+  // first
+  void Symbol(int symbol) {
+    uint32_t code;
+    int length;
+    if (symbol < 144) {
+      code = 0x30 + symbol;
+      length = 8;
+    } else if (symbol < 256) {
+      code = 0x190 + symbol - 144;
+      length = 9;
+    } else {
+      code = symbol - 256;
+      length = 7;
+    }
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; i++) {
+      reversed |= ((code >> i) & 1) << (length - 1 - i);
+    }
+    Write(reversed, length);
+  }
+
+  void Flush() {
+    if (used_ > 0) Write(0, 8 - used_);
+  }
+
+private:
+  std::vector<uint8_t>& out_;
+  uint64_t accumulator_ = 0;
+  int used_ = 0;
+};
+
+// JPEG bits, most significant first, with 0xFF bytes stuffed
+class JpegWriter {
+public:
+  explicit JpegWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+  void Write(uint32_t bits, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+      byte_ = static_cast<uint8_t>(byte_ << 1 | ((bits >> i) & 1));
+      if (++used_ == 8) {
+        out_.push_back(byte_);
+        if (byte_ == 0xFF) out_.push_back(0);
+        byte_ = 0;
+        used_ = 0;
+      }
+    }
+  }
+
+  // Pad with one bits to a byte boundary
+  void Flush() {
+    if (used_ > 0) Write(0xFF, 8 - used_);
+  }
+
+private:
+  std::vector<uint8_t>& out_;
+  uint8_t byte_ = 0;
+  int used_ = 0;
+};
+
+// Annex K luminance and chrominance tables, natural order
+constexpr std::array<uint8_t, 64> kLumaQuant = {
+    16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,
+    14, 13, 16, 24, 40,  57,  69,  56,  14, 17, 22, 29, 51,  87,  80,  62,
+    18, 22, 37, 56, 68,  109, 103, 77,  24, 35, 55, 64, 81,  104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99};
+constexpr std::array<uint8_t, 64> kChromaQuant = {
+    17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99, 24, 26, 56, 99, 99, 99,
+    99, 99, 47, 66, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99};
+
+constexpr std::array<uint8_t, 64> kZigzag = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33, 40, 48,
+    41, 34, 27, 20, 13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23,
+    30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+// Annex K luminance Huffman tables, used for every component
+constexpr std::array<uint8_t, 16> kDcCounts = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+constexpr std::array<uint8_t, 12> kDcSymbols = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+constexpr std::array<uint8_t, 16> kAcCounts = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D};
+constexpr std::array<uint8_t, 162> kAcSymbols = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61,
+    0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52,
+    0xD1, 0xF0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25,
+    0x26, 0x27, 0x28, 0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45,
+    0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64,
+    0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83,
+    0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+    0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6,
+    0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3,
+    0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8,
+    0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA};
+
+struct HuffmanCode {
+  std::array<uint16_t, 256> codes{};
+  std::array<uint8_t, 256> lengths{};
+};
+
+inline HuffmanCode BuildHuffmanCode(const uint8_t* counts, const uint8_t* symbols) {
+  HuffmanCode code;
+  int next = 0;
+  int index = 0;
+  for (int length = 1; length <= 16; length++) {
+    for (int i = 0; i < counts[length - 1]; i++) {
+      code.codes[symbols[index]] = static_cast<uint16_t>(next++);
+      code.lengths[symbols[index]] = static_cast<uint8_t>(length);
+      index++;
+    }
+    next <<= 1;
+  }
+  return code;
+}
+
+inline int Category(int value) {
+  int magnitude = std::abs(value);
+  int bits = 0;
+  while (magnitude > 0) {
+    bits++;
+    magnitude >>= 1;
+  }
+  return bits;
+}
+
+// Forward DCT of one block of samples less 128, quantized, in natural order
+inline void ForwardDct(const float* samples, const uint8_t* quant, int* out) {
+  static const std::array<float, 64> cosines = []() {
+    std::array<float, 64> table{};
+    for (int x = 0; x < 8; x++) {
+      for (int u = 0; u < 8; u++) {
+        table[x * 8 + u] = static_cast<float>(std::cos((2 * x + 1) * u * 3.14159265358979 / 16));
+      }
+    }
+    return table;
+  }();
+  float rows[64];
+  for (int y = 0; y < 8; y++) {
+    for (int u = 0; u < 8; u++) {
+      float sum = 0;
+      for (int x = 0; x < 8; x++) {
+        sum += samples[y * 8 + x] * cosines[x * 8 + u];
+      }
+      rows[y * 8 + u] = sum * (u == 0 ? 0.70710678f : 1.0f);
+    }
+  }
+  for (int v = 0; v < 8; v++) {
+    for (int u = 0; u < 8; u++) {
+      float sum = 0;
+      for (int y = 0; y < 8; y++) {
+        sum += rows[y * 8 + u] * cosines[y * 8 + v];
+      }
+      const float coefficient = sum * (v == 0 ? 0.70710678f : 1.0f) / 4;
+      out[v * 8 + u] = static_cast<int>(std::lround(coefficient / quant[v * 8 + u]));
+    }
+  }
+}
+
+}  // namespace images
+
+/// An RGBA image with smooth gradients, hard edges and fine detail, like a
+/// logo on a photo
+inline std::vector<uint8_t> TestPhoto(int width, int height) {
+  std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint8_t* pixel = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+      const double u = static_cast<double>(x) / width;
+      const double v = static_cast<double>(y) / height;
+      const bool inBox = u > 0.3 && u < 0.7 && v > 0.3 && v < 0.7;
+      const int ripple = static_cast<int>(24 * std::sin(x * 0.21) * std::cos(y * 0.17));
+      pixel[0] = static_cast<uint8_t>(std::clamp(static_cast<int>(255 * u) + ripple, 0, 255));
+      pixel[1] = static_cast<uint8_t>(std::clamp(static_cast<int>(255 * v) - ripple, 0, 255));
+      pixel[2] = inBox ? 20 : static_cast<uint8_t>(((x ^ y) & 0x3F) + 96);
+      pixel[3] = 255;
+    }
+  }
+  return rgba;
+}
+
+/// RGBA at 8 bits per channel with Sub-filtered rows, deflated as fixed
+/// Huffman literals without matches
+inline std::vector<uint8_t> EncodeTestPng(const uint8_t* rgba, int width, int height) {
+  std::vector<uint8_t> out = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+  std::vector<uint8_t> header;
+  images::AppendBigEndian(header, width, 4);
+  images::AppendBigEndian(header, height, 4);
+  header.insert(header.end(), {8, 6, 0, 0, 0});
+  images::AppendPngChunk(out, "IHDR", header);
+
+  std::vector<uint8_t> compressed = {0x78, 0x01};
+  images::DeflateWriter writer(compressed);
+  writer.Write(1, 1);
+  writer.Write(1, 2);
+  uint32_t a = 1;
+  uint32_t b = 0;
+  auto literal = [&](uint8_t byte) {
+    writer.Symbol(byte);
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  };
+  const size_t stride = static_cast<size_t>(width) * 4;
+  for (int y = 0; y < height; y++) {
+    const uint8_t* row = rgba + y * stride;
+    literal(1);
+    for (size_t i = 0; i < stride; i++) {
+      literal(static_cast<uint8_t>(row[i] - (i >= 4 ? row[i - 4] : 0)));
+    }
+  }
+  writer.Symbol(256);
+  writer.Flush();
+  images::AppendBigEndian(compressed, b << 16 | a, 4);
+  images::AppendPngChunk(out, "IDAT", compressed);
+  images::AppendPngChunk(out, "IEND", {});
+  return out;
+}
+
+/// Baseline JPEG of RGBA's color (alpha is ignored): YCbCr with chroma
+/// halved both ways, or luminance alone when gray. quality scales the Annex
+/// K quantization tables as the IJG library does; restartInterval adds a
+/// restart marker every that many MCUs.
+inline std::vector<uint8_t> EncodeTestJpeg(const uint8_t* rgba, int width, int height,
+                                           int quality, bool gray = false,
+                                           int restartInterval = 0) {
+  const int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+  std::array<uint8_t, 64> quant[2];
+  for (int i = 0; i < 64; i++) {
+    quant[0][i] =
+        static_cast<uint8_t>(std::clamp((images::kLumaQuant[i] * scale + 50) / 100, 1, 255));
+    quant[1][i] =
+        static_cast<uint8_t>(std::clamp((images::kChromaQuant[i] * scale + 50) / 100, 1, 255));
+  }
+  const int components = gray ? 1 : 3;
+
+  std::vector<uint8_t> out = {0xFF, 0xD8};
+  for (int t = 0; t < (gray ? 1 : 2); t++) {
+    out.insert(out.end(), {0xFF, 0xDB, 0, 67, static_cast<uint8_t>(t)});
+    for (int k = 0; k < 64; k++) {
+      out.push_back(quant[t][images::kZigzag[k]]);
+    }
+  }
+  out.insert(out.end(), {0xFF, 0xC0});
+  images::AppendBigEndian(out, 8 + components * 3, 2);
+  out.push_back(8);
+  images::AppendBigEndian(out, height, 2);
+  images::AppendBigEndian(out, width, 2);
+  out.push_back(static_cast<uint8_t>(components));
+  if (gray) {
+    out.insert(out.end(), {1, 0x11, 0});
+  } else {
+    out.insert(out.end(), {1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1});
+  }
+  out.insert(out.end(), {0xFF, 0xC4});
+  images::AppendBigEndian(out, 2 + 17 + 12 + 17 + 162, 2);
+  out.push_back(0x00);
+  out.insert(out.end(), images::kDcCounts.begin(), images::kDcCounts.end());
+  out.insert(out.end(), images::kDcSymbols.begin(), images::kDcSymbols.end());
+  out.push_back(0x10);
+  out.insert(out.end(), images::kAcCounts.begin(), images::kAcCounts.end());
+  out.insert(out.end(), images::kAcSymbols.begin(), images::kAcSymbols.end());
+  if (restartInterval > 0) {
+    out.insert(out.end(), {0xFF, 0xDD, 0, 4});
+    images::AppendBigEndian(out, restartInterval, 2);
+  }
+  out.insert(out.end(), {0xFF, 0xDA});
+  images::AppendBigEndian(out, 6 + components * 2, 2);
+  out.push_back(static_cast<uint8_t>(components));
+  for (int c = 0; c < components; c++) {
+    out.insert(out.end(), {static_cast<uint8_t>(c + 1), 0x00});
+  }
+  out.insert(out.end(), {0, 63, 0});
+
+  const images::HuffmanCode dc =
+      images::BuildHuffmanCode(images::kDcCounts.data(), images::kDcSymbols.data());
+  const images::HuffmanCode ac =
+      images::BuildHuffmanCode(images::kAcCounts.data(), images::kAcSymbols.data());
+  images::JpegWriter writer(out);
+  int predictions[3] = {0, 0, 0};
+  auto encodeBlock = [&](const float* samples, int component) {
+    int coefficients[64];
+    images::ForwardDct(samples, quant[component == 0 ? 0 : 1].data(), coefficients);
+    const int difference = coefficients[0] - predictions[component];
+    predictions[component] = coefficients[0];
+    auto writeValue = [&](int value, int category) {
+      if (category > 0) writer.Write(value < 0 ? value + (1 << category) - 1 : value, category);
+    };
+    int category = images::Category(difference);
+    writer.Write(dc.codes[category], dc.lengths[category]);
+    writeValue(difference, category);
+    int run = 0;
+    for (int k = 1; k < 64; k++) {
+      const int value = coefficients[images::kZigzag[k]];
+      if (value == 0) {
+        run++;
+        continue;
+      }
+      while (run > 15) {
+        writer.Write(ac.codes[0xF0], ac.lengths[0xF0]);
+        run -= 16;
+      }
+      category = images::Category(value);
+      const int symbol = run << 4 | category;
+      writer.Write(ac.codes[symbol], ac.lengths[symbol]);
+      writeValue(value, category);
+      run = 0;
+    }
+    if (run > 0) writer.Write(ac.codes[0], ac.lengths[0]);
+  };
+
+  // Samples of a channel at (x, y), edges repeated past the image
+  auto sample = [&](int x, int y, int channel) {
+    x = std::min(x, width - 1);
+    y = std::min(y, height - 1);
+    const uint8_t* pixel = rgba + (static_cast<size_t>(y) * width + x) * 4;
+    const float r = pixel[0];
+    const float g = pixel[1];
+    const float b = pixel[2];
+    if (channel == 0) return 0.299f * r + 0.587f * g + 0.114f * b;
+    if (channel == 1) return -0.168736f * r - 0.331264f * g + 0.5f * b + 128;
+    return 0.5f * r - 0.418688f * g - 0.081312f * b + 128;
+  };
+
+  const int mcuSize = gray ? 8 : 16;
+  const int mcusAcross = (width + mcuSize - 1) / mcuSize;
+  const int mcusDown = (height + mcuSize - 1) / mcuSize;
+  float block[64];
+  int mcu = 0;
+  for (int mcuY = 0; mcuY < mcusDown; mcuY++) {
+    for (int mcuX = 0; mcuX < mcusAcross; mcuX++, mcu++) {
+      if (restartInterval > 0 && mcu > 0 && mcu % restartInterval == 0) {
+        writer.Flush();
+        out.insert(out.end(), {0xFF, static_cast<uint8_t>(0xD0 + (mcu / restartInterval - 1) % 8)});
+        predictions[0] = predictions[1] = predictions[2] = 0;
+      }
+      const int left = mcuX * mcuSize;
+      const int top = mcuY * mcuSize;
+      for (int blockY = 0; blockY < mcuSize; blockY += 8) {
+        for (int blockX = 0; blockX < mcuSize; blockX += 8) {
+          for (int i = 0; i < 64; i++) {
+            block[i] = sample(left + blockX + i % 8, top + blockY + i / 8, 0) - 128;
+          }
+          encodeBlock(block, 0);
+        }
+      }
+      for (int channel = 1; channel < components; channel++) {
+        for (int i = 0; i < 64; i++) {
+          const int x = left + (i % 8) * 2;
+          const int y = top + (i / 8) * 2;
+          block[i] = (sample(x, y, channel) + sample(x + 1, y, channel) +
+                      sample(x, y + 1, channel) + sample(x + 1, y + 1, channel)) / 4 - 128;
+        }
+        encodeBlock(block, channel);
+      }
+    }
+  }
+  writer.Flush();
+  out.insert(out.end(), {0xFF, 0xD9});
+  return out;
+}
+
+}  // namespace test
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_TEST_TEST_IMAGES_H_
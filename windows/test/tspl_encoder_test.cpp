@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "mono_bitmap.h"
+#include "tspl_encoder.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+std::string Text(const TsplEncoder& encoder) {
+  return std::string(encoder.Bytes().begin(), encoder.Bytes().end());
+}
+
+}  // namespace
+
+TEST(TsplEncoder, LabelWithTextBarcodeAndQrCode) {
+  TsplEncoder encoder;
+  encoder.Setup(50, 30, 2);
+  encoder.Text(20, 10, "Milk 1L", 30);
+  EXPECT_TRUE(encoder.Barcode(20, 60, LabelBarcodeType::kCode128, "AB-12", 80));
+  encoder.QrCode(280, 60, "https://example.com/p/42", 4);
+  encoder.Print(2);
+
+  EXPECT_EQ(Text(encoder),
+            "SIZE 50 mm,30 mm\r\n"
+            "GAP 2 mm,0 mm\r\n"
+            "CLS\r\n"
+            "TEXT 20,10,\"3\",0,1,1,\"Milk 1L\"\r\n"
+            "BARCODE 20,60,\"128\",80,1,0,2,2,\"AB-12\"\r\n"
+            "QRCODE 280,60,M,4,A,0,\"https://example.com/p/42\"\r\n"
+            "PRINT 2\r\n");
+}
+
+TEST(TsplEncoder, PicksFontAndMultipliersForTextSize) {
+  TsplEncoder encoder;
+  encoder.Text(0, 0, "A", 96, 64);
+  encoder.Text(0, 0, "B", 10);
+  encoder.Text(0, 0, "C", 20, 36);
+  EXPECT_EQ(Text(encoder),
+            "TEXT 0,0,\"5\",0,2,2,\"A\"\r\n"
+            "TEXT 0,0,\"1\",0,1,1,\"B\"\r\n"
+            "TEXT 0,0,\"2\",0,3,1,\"C\"\r\n");
+}
+
+TEST(TsplEncoder, EscapesQuotesAndLineBreaks) {
+  TsplEncoder encoder;
+  encoder.Text(0, 0, "12\" pipe\r\nx", 24);
+  EXPECT_EQ(Text(encoder), "TEXT 0,0,\"3\",0,1,1,\"12\\[\"] pipe  x\"\r\n");
+}
+
+TEST(TsplEncoder, BarcodeTypes) {
+  TsplEncoder encoder;
+  EXPECT_TRUE(encoder.Barcode(0, 0, LabelBarcodeType::kCode39, "AB-12", 50, 2, false));
+  EXPECT_TRUE(encoder.Barcode(0, 0, LabelBarcodeType::kEan13, "4006381333931", 50));
+  EXPECT_TRUE(encoder.Barcode(0, 0, LabelBarcodeType::kEan8, "1234567", 50));
+  EXPECT_TRUE(encoder.Barcode(0, 0, LabelBarcodeType::kUpcA, "03600029145", 50));
+  EXPECT_FALSE(encoder.Barcode(0, 0, LabelBarcodeType::kUpcA, "ABC", 50));
+  EXPECT_EQ(Text(encoder),
+            "BARCODE 0,0,\"39\",50,0,0,2,6,\"AB-12\"\r\n"
+            "BARCODE 0,0,\"EAN13\",50,1,0,2,2,\"4006381333931\"\r\n"
+            "BARCODE 0,0,\"EAN8\",50,1,0,2,2,\"1234567\"\r\n"
+            "BARCODE 0,0,\"UPCA\",50,1,0,2,2,\"03600029145\"\r\n");
+}
+
+TEST(TsplEncoder, BitmapSendsClearBitsForBlackDots) {
+  MonoBitmap bitmap(10, 2);
+  bitmap.FillRect(0, 0, 10, 1);
+  TsplEncoder encoder;
+  encoder.Graphic(5, 6, bitmap);
+
+  std::string expected = "BITMAP 5,6,2,2,0,";
+  expected += std::string{'\x00', '\x3F', '\xFF', '\xFF'};
+  expected += "\r\n";
+  EXPECT_EQ(Text(encoder), expected);
+}
+
+TEST(TsplEncoder, StoresAndRunsFormats) {
+  TsplEncoder format;
+  format.StartFormat("SHELF");
+  format.Setup(50, 30, 2);
+  format.Text(20, 10, "", 30, 0, 1);
+  format.Barcode(20, 60, LabelBarcodeType::kCode128, "", 80, 2, true, 2);
+  format.Print(1);
+  format.EndFormat();
+  EXPECT_EQ(Text(format),
+            "DOWNLOAD \"SHELF.BAS\"\r\n"
+            "SIZE 50 mm,30 mm\r\n"
+            "GAP 2 mm,0 mm\r\n"
+            "CLS\r\n"
+            "TEXT 20,10,\"3\",0,1,1,F1$\r\n"
+            "BARCODE 20,60,\"128\",80,1,0,2,2,F2$\r\n"
+            "PRINT 1\r\n"
+            "EOP\r\n");
+
+  TsplEncoder recall;
+  recall.FieldData(1, "Milk 1L");
+  recall.FieldData(2, "SKU-42");
+  recall.RunFormat("SHELF");
+  EXPECT_EQ(Text(recall),
+            "F1$=\"Milk 1L\"\r\n"
+            "F2$=\"SKU-42\"\r\n"
+            "RUN \"SHELF.BAS\"\r\n");
+}
+
+}  // namespace test
+}  // namespace windows_printer
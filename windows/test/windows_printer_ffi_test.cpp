@@ -0,0 +1,438 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ffi_runtime.h"
+#include "in_memory_spooler.h"
+#include "include/windows_printer/windows_printer_ffi.h"
+#include "job_tracker.h"
+#include "print_metrics.h"
+#include "test_images.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+const std::vector<uint8_t> kTicket = {'T', 'i', 'c', 'k', 'e', 't', 0x0A};
+
+// Installs an in-memory spooler and a manually polled tracker behind the
+// exported functions for the duration of a test
+class WindowsPrinterFfi : public ::testing::Test {
+protected:
+  void SetUp() override {
+    spooler_ = std::make_shared<InMemorySpooler>();
+    spooler_->AddPrinter("Kitchen");
+    spooler_->AddPrinter("Bar");
+    spooler_->SetDefaultPrinter("Kitchen");
+    JobTrackerOptions options;
+    options.pollInterval = std::chrono::milliseconds(0);
+    tracker_ = std::make_shared<JobTracker>(spooler_, options);
+    InstallFfiRuntime(spooler_, tracker_, [this](uint32_t streamId, const PrintStreamEvent& event) {
+      std::lock_guard<std::mutex> lock(streamMutex_);
+      streamEvents_.push_back({streamId, event});
+      streamChanged_.notify_all();
+    });
+  }
+
+  void TearDown() override { InstallFfiRuntime(nullptr, nullptr); }
+
+  int32_t Submit(const char* printerName, WindowsPrinterJob* job, uint32_t timeoutMs = 0) {
+    return WindowsPrinterSubmitRawJob(printerName, kTicket.data(), kTicket.size(), 1, 1,
+                                      timeoutMs, job);
+  }
+
+  // Waits for a stream event of a type and returns it
+  bool WaitForStream(uint32_t streamId, int32_t type, PrintStreamEvent* found = nullptr) {
+    std::unique_lock<std::mutex> lock(streamMutex_);
+    return streamChanged_.wait_for(lock, std::chrono::seconds(5), [&]() {
+      for (const auto& entry : streamEvents_) {
+        if (entry.first == streamId && static_cast<int32_t>(entry.second.type) == type) {
+          if (found) *found = entry.second;
+          return true;
+        }
+      }
+      return false;
+    });
+  }
+
+  // A job abandoned at its deadline is cancelled from a detached thread,
+  // which must be done before the spooler goes away with the fixture
+  bool WaitForCancel(uint32_t jobId) {
+    for (int i = 0; i < 500; i++) {
+      for (const SpooledJob& spooled : spooler_->Jobs()) {
+        if (spooled.jobId == jobId && spooled.cancelled) return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  }
+
+  std::shared_ptr<InMemorySpooler> spooler_;
+  std::shared_ptr<JobTracker> tracker_;
+
+  std::mutex streamMutex_;
+  std::condition_variable streamChanged_;
+  std::vector<std::pair<uint32_t, PrintStreamEvent>> streamEvents_;
+};
+
+}  // namespace
+
+TEST_F(WindowsPrinterFfi, ReportsVersion) {
+  EXPECT_EQ(WindowsPrinterFfiVersion(), WINDOWS_PRINTER_FFI_VERSION);
+}
+
+TEST_F(WindowsPrinterFfi, SubmitsFromCallerMemory) {
+  WindowsPrinterJob job;
+  ASSERT_EQ(Submit("Bar", &job), WINDOWS_PRINTER_FFI_OK);
+  EXPECT_NE(job.jobId, 0u);
+  EXPECT_EQ(job.state, WINDOWS_PRINTER_JOB_SPOOLING);
+  EXPECT_EQ(job.errorCode, 0u);
+  EXPECT_EQ(job.bytesWritten, kTicket.size());
+
+  std::vector<SpooledJob> jobs = spooler_->Jobs();
+  ASSERT_EQ(jobs.size(), 1u);
+  EXPECT_EQ(jobs[0].printerName, "Bar");
+  EXPECT_EQ(jobs[0].datatype, "RAW");
+  EXPECT_EQ(jobs[0].data, kTicket);
+}
+
+TEST_F(WindowsPrinterFfi, NullOrEmptyPrinterSelectsDefault) {
+  WindowsPrinterJob job;
+  ASSERT_EQ(Submit(nullptr, &job), WINDOWS_PRINTER_FFI_OK);
+  ASSERT_EQ(Submit("", &job), WINDOWS_PRINTER_FFI_OK);
+  for (const SpooledJob& spooled : spooler_->Jobs()) {
+    EXPECT_EQ(spooled.printerName, "Kitchen");
+  }
+}
+
+TEST_F(WindowsPrinterFfi, SubmitsWithDeadline) {
+  WindowsPrinterJob job;
+  ASSERT_EQ(Submit("Bar", &job, 5000), WINDOWS_PRINTER_FFI_OK);
+  EXPECT_EQ(spooler_->Jobs().at(0).data, kTicket);
+}
+
+TEST_F(WindowsPrinterFfi, RejectsInvalidArguments) {
+  WindowsPrinterJob job;
+  EXPECT_EQ(WindowsPrinterSubmitRawJob("Bar", nullptr, 4, 1, 1, 0, &job),
+            WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_EQ(WindowsPrinterSubmitRawJob("Bar", kTicket.data(), kTicket.size(), 1, 0, 0, &job),
+            WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_EQ(WindowsPrinterSubmitRawJob("Bar", kTicket.data(), kTicket.size(), 1, 1000, 0, &job),
+            WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_EQ(WindowsPrinterSubmitRawJob("Bar", kTicket.data(), kTicket.size(), 1, 1, 0, nullptr),
+            WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_EQ(WindowsPrinterGetJob("Bar", 0, &job), WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_TRUE(spooler_->Jobs().empty());
+}
+
+TEST_F(WindowsPrinterFfi, ReportsSpoolerFailure) {
+  spooler_->FailNext(SpoolerCall::kStartDocument, InMemorySpooler::kErrorInvalidParameter);
+  WindowsPrinterJob job;
+  EXPECT_EQ(Submit("Bar", &job), WINDOWS_PRINTER_FFI_FAILED);
+  EXPECT_EQ(job.jobId, 0u);
+  EXPECT_EQ(job.errorCode, InMemorySpooler::kErrorInvalidParameter);
+}
+
+TEST_F(WindowsPrinterFfi, ReportsTimeout) {
+  spooler_->HangNext(SpoolerCall::kWrite);
+  WindowsPrinterJob job;
+  EXPECT_EQ(Submit("Bar", &job, 20), WINDOWS_PRINTER_FFI_TIMED_OUT);
+  EXPECT_TRUE(WaitForCancel(job.jobId));
+  spooler_->ReleaseHangs();
+  // The abandoned worker closes its handle last
+  for (int i = 0; i < 500 && spooler_->OpenHandleCount() > 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(spooler_->OpenHandleCount(), 0u);
+}
+
+TEST_F(WindowsPrinterFfi, PollsTrackedJobState) {
+  WindowsPrinterJob job;
+  ASSERT_EQ(Submit("Bar", &job), WINDOWS_PRINTER_FFI_OK);
+  const uint32_t jobId = job.jobId;
+
+  spooler_->SetJobStatus(jobId, kJobStatusPrinting);
+  tracker_->Poll();
+  std::memset(&job, 0xFF, sizeof(job));
+  ASSERT_EQ(WindowsPrinterGetJob("Bar", jobId, &job), WINDOWS_PRINTER_FFI_OK);
+  EXPECT_EQ(job.jobId, jobId);
+  EXPECT_EQ(job.state, WINDOWS_PRINTER_JOB_PRINTING);
+  EXPECT_EQ(job.status, kJobStatusPrinting);
+  EXPECT_EQ(job.errorCode, 0u);
+
+  spooler_->FinishJob(jobId);
+  tracker_->Poll();
+  ASSERT_EQ(WindowsPrinterGetJob(nullptr, jobId, &job), WINDOWS_PRINTER_FFI_OK);
+  EXPECT_EQ(job.state, WINDOWS_PRINTER_JOB_PRINTED);
+
+  EXPECT_EQ(WindowsPrinterGetJob("Kitchen", jobId, &job), WINDOWS_PRINTER_FFI_NOT_FOUND);
+  EXPECT_EQ(WindowsPrinterGetJob("Bar", jobId + 1, &job), WINDOWS_PRINTER_FFI_NOT_FOUND);
+}
+
+TEST_F(WindowsPrinterFfi, FailsUntilInstalled) {
+  InstallFfiRuntime(nullptr, nullptr);
+  WindowsPrinterJob job;
+  EXPECT_EQ(Submit("Bar", &job), WINDOWS_PRINTER_FFI_NOT_READY);
+  EXPECT_EQ(WindowsPrinterGetJob("Bar", 1, &job), WINDOWS_PRINTER_FFI_NOT_READY);
+}
+
+TEST_F(WindowsPrinterFfi, CopiesMetrics) {
+  PrintMetrics::Instance().Reset();
+  WindowsPrinterJob job;
+  ASSERT_EQ(Submit("Bar", &job), WINDOWS_PRINTER_FFI_OK);
+
+  WindowsPrinterMetrics metrics;
+  std::memset(&metrics, 0, sizeof(metrics));
+  metrics.structSize = sizeof(metrics);
+  ASSERT_EQ(WindowsPrinterGetMetrics(&metrics), WINDOWS_PRINTER_FFI_OK);
+  EXPECT_EQ(metrics.bytesWritten, kTicket.size());
+  EXPECT_EQ(metrics.stages[WINDOWS_PRINTER_STAGE_WRITE_PRINTER].count, 1u);
+  EXPECT_EQ(metrics.stages[WINDOWS_PRINTER_STAGE_START_DOC_PRINTER].count, 1u);
+  EXPECT_EQ(metrics.failures, 0u);
+
+  bool recorded = false;
+  for (const MethodSummary& method : PrintMetrics::Instance().Snapshot().methods) {
+    if (method.latency.name == "ffiSubmitRawJob") recorded = method.latency.count == 1;
+  }
+  EXPECT_TRUE(recorded);
+
+  // A version 1 caller's struct ends before the budget fields
+  metrics.pendingBytes = 12345;
+  metrics.structSize = offsetof(WindowsPrinterMetrics, pendingJobs);
+  EXPECT_EQ(WindowsPrinterGetMetrics(&metrics), WINDOWS_PRINTER_FFI_OK);
+  EXPECT_EQ(metrics.pendingBytes, 12345u);
+  metrics.structSize = offsetof(WindowsPrinterMetrics, pendingJobs) - 1;
+  EXPECT_EQ(WindowsPrinterGetMetrics(&metrics), WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+}
+
+TEST_F(WindowsPrinterFfi, ChargesPrintBudget) {
+  PrintMetrics::Instance().Reset();
+  PrintBudgetOptions options;
+  options.maxJobsPerPrinter = 1;
+  // Would wait for room without end on the channel; the FFI refuses at once
+  options.overflow = OverflowPolicy::kBlock;
+  auto budget = std::make_shared<PrintBudget>(options);
+  InstallFfiRuntime(spooler_, tracker_, nullptr, budget);
+
+  // A job abandoned at its deadline keeps the printer's only slot. It hangs
+  // before its job starts, so there is nothing to cancel that would free it.
+  spooler_->HangNext(SpoolerCall::kOpen);
+  WindowsPrinterJob job;
+  EXPECT_EQ(Submit("Bar", &job, 50), WINDOWS_PRINTER_FFI_TIMED_OUT);
+  EXPECT_EQ(budget->Usage("Bar").jobs, 1u);
+  EXPECT_EQ(Submit("Bar", &job), WINDOWS_PRINTER_FFI_QUEUE_FULL);
+  EXPECT_EQ(Submit("Kitchen", &job), WINDOWS_PRINTER_FFI_OK);
+
+  WindowsPrinterMetrics metrics;
+  std::memset(&metrics, 0, sizeof(metrics));
+  metrics.structSize = sizeof(metrics);
+  ASSERT_EQ(WindowsPrinterGetMetrics(&metrics), WINDOWS_PRINTER_FFI_OK);
+  EXPECT_EQ(metrics.pendingJobs, 1u);
+  EXPECT_EQ(metrics.pendingBytes, kTicket.size());
+  EXPECT_EQ(metrics.rejectedJobs, 1u);
+
+  spooler_->ReleaseHangs();
+  for (int i = 0; i < 500 && budget->Usage().jobs > 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(Submit("Bar", &job), WINDOWS_PRINTER_FFI_OK);
+}
+
+TEST_F(WindowsPrinterFfi, AllocatesNativeBuffers) {
+  EXPECT_EQ(WindowsPrinterAllocate(0), nullptr);
+  uint8_t* buffer = WindowsPrinterAllocate(kTicket.size());
+  ASSERT_NE(buffer, nullptr);
+  std::memcpy(buffer, kTicket.data(), kTicket.size());
+  WindowsPrinterJob job;
+  EXPECT_EQ(WindowsPrinterSubmitRawJob("Bar", buffer, kTicket.size(), 1, 2, 0, &job),
+            WINDOWS_PRINTER_FFI_OK);
+  WindowsPrinterFree(buffer);
+  WindowsPrinterFree(nullptr);
+  EXPECT_EQ(spooler_->Jobs().at(0).data.size(), kTicket.size() * 2);
+}
+
+TEST_F(WindowsPrinterFfi, StreamsThroughReservedMemory) {
+  WindowsPrinterStream* stream = nullptr;
+  uint32_t streamId = 0;
+  ASSERT_EQ(WindowsPrinterStreamOpen("Bar", 256, 0, 0, 1, &stream, &streamId),
+            WINDOWS_PRINTER_FFI_OK);
+  EXPECT_NE(streamId, 0u);
+
+  // More tickets than the ring holds at once, written in place
+  std::vector<uint8_t> expected;
+  for (int i = 0; i < 100; i++) {
+    size_t written = 0;
+    while (written < kTicket.size()) {
+      uint64_t length = 0;
+      uint8_t* region = WindowsPrinterStreamReserve(stream, &length);
+      if (length == 0) {
+        std::this_thread::yield();
+        continue;
+      }
+      size_t size = std::min<size_t>(static_cast<size_t>(length), kTicket.size() - written);
+      std::memcpy(region, kTicket.data() + written, size);
+      ASSERT_NE(WindowsPrinterStreamCommit(stream, size), WINDOWS_PRINTER_FFI_FAILED);
+      written += size;
+    }
+    expected.insert(expected.end(), kTicket.begin(), kTicket.end());
+  }
+
+  WindowsPrinterStreamInfo info;
+  ASSERT_EQ(WindowsPrinterStreamGetInfo(stream, &info), WINDOWS_PRINTER_FFI_OK);
+  EXPECT_EQ(info.streamId, streamId);
+  EXPECT_EQ(info.capacity, 256u);
+  EXPECT_EQ(info.failed, 0);
+  EXPECT_EQ(WindowsPrinterStreamClose(stream, 0), WINDOWS_PRINTER_FFI_OK);
+
+  PrintStreamEvent finished;
+  ASSERT_TRUE(WaitForStream(streamId, WINDOWS_PRINTER_STREAM_FINISHED, &finished));
+  EXPECT_EQ(finished.bytesWritten, expected.size());
+  std::vector<SpooledJob> jobs = spooler_->Jobs();
+  ASSERT_EQ(jobs.size(), 1u);
+  EXPECT_EQ(jobs[0].printerName, "Bar");
+  EXPECT_EQ(jobs[0].data, expected);
+
+  // Followed like any other job
+  WindowsPrinterJob job;
+  EXPECT_EQ(WindowsPrinterGetJob("Bar", finished.jobId, &job), WINDOWS_PRINTER_FFI_OK);
+}
+
+TEST_F(WindowsPrinterFfi, StreamPausesAtHighWatermark) {
+  WindowsPrinterStream* stream = nullptr;
+  uint32_t streamId = 0;
+  ASSERT_EQ(WindowsPrinterStreamOpen(nullptr, 1024, 128, 512, 1, &stream, &streamId),
+            WINDOWS_PRINTER_FFI_OK);
+  ASSERT_TRUE(WaitForStream(streamId, WINDOWS_PRINTER_STREAM_STARTED));
+
+  // The writer takes the first commit and hangs writing it
+  spooler_->HangNext(SpoolerCall::kWrite);
+  uint64_t length = 0;
+  uint8_t* region = WindowsPrinterStreamReserve(stream, &length);
+  ASSERT_EQ(length, 1024u);
+  std::memset(region, 'x', 100);
+  EXPECT_EQ(WindowsPrinterStreamCommit(stream, 100), WINDOWS_PRINTER_FFI_OK);
+  region = WindowsPrinterStreamReserve(stream, &length);
+  ASSERT_GE(length, 600u);
+  std::memset(region, 'y', 600);
+  EXPECT_EQ(WindowsPrinterStreamCommit(stream, 600), WINDOWS_PRINTER_FFI_PAUSED);
+
+  spooler_->ReleaseHangs();
+  EXPECT_TRUE(WaitForStream(streamId, WINDOWS_PRINTER_STREAM_WRITABLE));
+
+  EXPECT_EQ(WindowsPrinterStreamClose(stream, 1), WINDOWS_PRINTER_FFI_OK);
+  EXPECT_TRUE(WaitForStream(streamId, WINDOWS_PRINTER_STREAM_CANCELLED));
+}
+
+TEST_F(WindowsPrinterFfi, RejectsInvalidStreamArguments) {
+  WindowsPrinterStream* stream = nullptr;
+  uint32_t streamId = 0;
+  EXPECT_EQ(WindowsPrinterStreamOpen("Bar", 0, 0, 0, 1, nullptr, &streamId),
+            WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_EQ(WindowsPrinterStreamOpen("Bar", 1024, 512, 256, 1, &stream, &streamId),
+            WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_EQ(WindowsPrinterStreamOpen("Bar", 1024, 0, 2048, 1, &stream, &streamId),
+            WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_EQ(WindowsPrinterStreamCommit(nullptr, 0), WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_EQ(WindowsPrinterStreamClose(nullptr, 0), WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+
+  ASSERT_EQ(WindowsPrinterStreamOpen("Bar", 1024, 0, 0, 1, &stream, &streamId),
+            WINDOWS_PRINTER_FFI_OK);
+  // Nothing reserved yet
+  EXPECT_EQ(WindowsPrinterStreamCommit(stream, 1), WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_EQ(WindowsPrinterStreamClose(stream, 1), WINDOWS_PRINTER_FFI_OK);
+  EXPECT_TRUE(WaitForStream(streamId, WINDOWS_PRINTER_STREAM_CANCELLED));
+}
+
+TEST_F(WindowsPrinterFfi, StreamFailsForUnknownPrinter) {
+  WindowsPrinterStream* stream = nullptr;
+  uint32_t streamId = 0;
+  ASSERT_EQ(WindowsPrinterStreamOpen("Missing", 0, 0, 0, 1, &stream, &streamId),
+            WINDOWS_PRINTER_FFI_OK);
+  ASSERT_TRUE(WaitForStream(streamId, WINDOWS_PRINTER_STREAM_FAILED));
+
+  uint64_t length = 1;
+  EXPECT_EQ(WindowsPrinterStreamReserve(stream, &length), nullptr);
+  EXPECT_EQ(length, 0u);
+  EXPECT_EQ(WindowsPrinterStreamCommit(stream, 0), WINDOWS_PRINTER_FFI_FAILED);
+  EXPECT_EQ(WindowsPrinterStreamClose(stream, 0), WINDOWS_PRINTER_FFI_OK);
+}
+
+TEST_F(WindowsPrinterFfi, EncodesReceiptImages) {
+  const std::vector<uint8_t> rgba = TestPhoto(120, 60);
+  const std::vector<uint8_t> png = EncodeTestPng(rgba.data(), 120, 60);
+  uint8_t* output = nullptr;
+  uint64_t outputSize = 0;
+  char error[64] = "unchanged";
+  ASSERT_EQ(WindowsPrinterEncodeReceiptImage(png.data(), png.size(), 384, 1, &output, &outputSize,
+                                             error, sizeof(error)),
+            WINDOWS_PRINTER_FFI_OK);
+  ASSERT_NE(output, nullptr);
+  // ESC 3 24, then 8 bands of 384 columns, then ESC 2
+  EXPECT_EQ(outputSize, 3u + 8 * (5 + 384 * 3 + 1) + 2);
+  EXPECT_EQ(output[0], 0x1B);
+  EXPECT_EQ(output[1], 0x33);
+  EXPECT_EQ(output[outputSize - 1], 0x32);
+  EXPECT_STREQ(error, "unchanged");
+  WindowsPrinterFree(output);
+
+  const std::vector<uint8_t> text = {'n', 'o', 'p', 'e'};
+  EXPECT_EQ(WindowsPrinterEncodeReceiptImage(text.data(), text.size(), 384, 1, &output,
+                                             &outputSize, error, 8),
+            WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_STREQ(error, "Not a P");
+  EXPECT_EQ(output, nullptr);
+  EXPECT_EQ(WindowsPrinterEncodeReceiptImage(png.data(), png.size(), 0, 1, &output, &outputSize,
+                                             nullptr, 0),
+            WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+}
+
+TEST_F(WindowsPrinterFfi, EncodesReceiptImagesInParallel) {
+  const std::vector<uint8_t> rgba = TestPhoto(120, 60);
+  const std::vector<uint8_t> png = EncodeTestPng(rgba.data(), 120, 60);
+  const std::vector<uint8_t> jpeg = EncodeTestJpeg(rgba.data(), 120, 60, 85);
+  const std::vector<uint8_t> text = {'n', 'o', 'p', 'e'};
+  const uint8_t* images[] = {png.data(), jpeg.data(), text.data(), png.data()};
+  const uint64_t sizes[] = {png.size(), jpeg.size(), text.size(), png.size()};
+  uint8_t* outputs[4] = {};
+  uint64_t outputSizes[4] = {};
+  int32_t results[4] = {};
+  char error[64] = "";
+  EXPECT_EQ(WindowsPrinterEncodeReceiptImages(4, images, sizes, 384, 1, outputs, outputSizes,
+                                              results, error, sizeof(error)),
+            WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_STREQ(error, "Not a PNG or JPEG image");
+  EXPECT_EQ(results[2], WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  EXPECT_EQ(outputs[2], nullptr);
+
+  // The others are encoded as one at a time
+  for (int i : {0, 1, 3}) {
+    EXPECT_EQ(results[i], WINDOWS_PRINTER_FFI_OK);
+    uint8_t* single = nullptr;
+    uint64_t singleSize = 0;
+    ASSERT_EQ(WindowsPrinterEncodeReceiptImage(images[i], sizes[i], 384, 1, &single, &singleSize,
+                                               nullptr, 0),
+              WINDOWS_PRINTER_FFI_OK);
+    ASSERT_EQ(outputSizes[i], singleSize);
+    EXPECT_EQ(std::memcmp(outputs[i], single, singleSize), 0);
+    WindowsPrinterFree(single);
+    WindowsPrinterFree(outputs[i]);
+  }
+
+  EXPECT_EQ(WindowsPrinterEncodeReceiptImages(0, images, sizes, 384, 1, outputs, outputSizes,
+                                              results, nullptr, 0),
+            WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+}
+
+}  // namespace test
+}  // namespace windows_printer
@@ -22,21 +22,65 @@ using flutter::MethodResultFunctions;
 
 }  // namespace
 
-TEST(WindowsPrinterPlugin, GetPlatformVersion) {
+TEST(WindowsPrinterPlugin, UnknownMethodIsNotImplemented) {
   WindowsPrinterPlugin plugin;
-  // Save the reply value from the success callback.
-  std::string result_string;
+  bool not_implemented = false;
   plugin.HandleMethodCall(
       MethodCall("getPlatformVersion", std::make_unique<EncodableValue>()),
       std::make_unique<MethodResultFunctions<>>(
-          [&result_string](const EncodableValue* result) {
-            result_string = std::get<std::string>(*result);
+          nullptr, nullptr, [&not_implemented]() { not_implemented = true; }));
+
+  EXPECT_TRUE(not_implemented);
+}
+
+TEST(WindowsPrinterPlugin, PrintRawDataRejectsMissingData) {
+  WindowsPrinterPlugin plugin;
+  std::string error_code;
+  EncodableMap arguments = {
+      {EncodableValue("printerName"), EncodableValue("Receipt Printer")},
+  };
+  plugin.HandleMethodCall(
+      MethodCall("printRawData", std::make_unique<EncodableValue>(arguments)),
+      std::make_unique<MethodResultFunctions<>>(
+          nullptr,
+          [&error_code](const std::string& code, const std::string&,
+                        const EncodableValue*) { error_code = code; },
+          nullptr));
+
+  EXPECT_EQ(error_code, "INVALID_DATA");
+}
+
+TEST(WindowsPrinterPlugin, GetMetricsReportsStages) {
+  WindowsPrinterPlugin plugin;
+  bool has_stages = false;
+  plugin.HandleMethodCall(
+      MethodCall("getMetrics", std::make_unique<EncodableValue>()),
+      std::make_unique<MethodResultFunctions<>>(
+          [&has_stages](const EncodableValue* result) {
+            const auto& metrics = std::get<EncodableMap>(*result);
+            has_stages = metrics.find(EncodableValue("stages")) != metrics.end();
           },
           nullptr, nullptr));
 
-  // Since the exact string varies by host, just ensure that it's a string
-  // with the expected format.
-  EXPECT_TRUE(result_string.rfind("Windows ", 0) == 0);
+  EXPECT_TRUE(has_stages);
+}
+
+TEST(WindowsPrinterPlugin, GetPrinterPropertiesBatchRejectsNonStringNames) {
+  WindowsPrinterPlugin plugin;
+  std::string error_code;
+  EncodableMap arguments = {
+      {EncodableValue("printerNames"),
+       EncodableValue(flutter::EncodableList{EncodableValue("Receipt Printer"), EncodableValue(42)})},
+  };
+  plugin.HandleMethodCall(
+      MethodCall("getPrinterPropertiesBatch", std::make_unique<EncodableValue>(arguments)),
+      std::make_unique<MethodResultFunctions<>>(
+          nullptr,
+          [&error_code](const std::string& code, const std::string&,
+                        const EncodableValue*) { error_code = code; },
+          nullptr));
+
+  EXPECT_EQ(error_code, "INVALID_PRINTER_NAME");
 }
 
 }  // namespace test
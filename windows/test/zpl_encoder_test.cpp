@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "mono_bitmap.h"
+#include "zpl_encoder.h"
+
+namespace windows_printer {
+namespace test {
+
+namespace {
+
+std::string Text(const ZplEncoder& encoder) {
+  return std::string(encoder.Bytes().begin(), encoder.Bytes().end());
+}
+
+}  // namespace
+
+TEST(ZplEncoder, LabelWithTextBarcodeAndQrCode) {
+  ZplEncoder encoder;
+  encoder.StartLabel(400, 240);
+  encoder.Text(20, 10, "Milk 1L", 30);
+  EXPECT_TRUE(encoder.Barcode(20, 60, LabelBarcodeType::kEan13, "4006381333931", 80));
+  encoder.QrCode(280, 60, "https://example.com/p/42", 4);
+  encoder.EndLabel(3);
+
+  EXPECT_EQ(Text(encoder),
+            "^XA^PW400^LL240"
+            "^FO20,10^A0N,30,30^FDMilk 1L^FS"
+            "^FO20,60^BY2^BEN,80,Y,N^FD4006381333931^FS"
+            "^FO280,60^BQN,2,4^FDMA,https://example.com/p/42^FS"
+            "^PQ3^XZ");
+}
+
+TEST(ZplEncoder, BarcodeCommands) {
+  ZplEncoder encoder;
+  EXPECT_TRUE(encoder.Barcode(0, 0, LabelBarcodeType::kCode128, "AB-12", 50, 3, false));
+  EXPECT_TRUE(encoder.Barcode(0, 0, LabelBarcodeType::kCode39, "AB-12", 50));
+  EXPECT_TRUE(encoder.Barcode(0, 0, LabelBarcodeType::kEan8, "1234567", 50));
+  EXPECT_TRUE(encoder.Barcode(0, 0, LabelBarcodeType::kUpcA, "03600029145", 50));
+
+  EXPECT_EQ(Text(encoder),
+            "^FO0,0^BY3^BCN,50,N,N,N,A^FDAB-12^FS"
+            "^FO0,0^BY2,3^B3N,N,50,Y,N^FDAB-12^FS"
+            "^FO0,0^BY2^B8N,50,Y,N^FD1234567^FS"
+            "^FO0,0^BY2^BUN,50,Y,N,Y^FD03600029145^FS");
+}
+
+TEST(ZplEncoder, RejectsInvalidBarcodeData) {
+  ZplEncoder encoder;
+  EXPECT_FALSE(encoder.Barcode(0, 0, LabelBarcodeType::kEan13, "12345", 50));
+  EXPECT_FALSE(encoder.Barcode(0, 0, LabelBarcodeType::kCode39, "lower", 50));
+  EXPECT_TRUE(encoder.Bytes().empty());
+  // A field is filled at recall, so its data is not checked
+  EXPECT_TRUE(encoder.Barcode(0, 0, LabelBarcodeType::kEan13, "", 50, 2, true, 2));
+}
+
+TEST(ZplEncoder, EscapesCommandCharactersInFieldData) {
+  ZplEncoder encoder;
+  encoder.Text(0, 0, "A^B~C_D", 20, 10);
+  EXPECT_EQ(Text(encoder), "^FO0,0^A0N,20,10^FH^FDA_5EB_7EC_5FD^FS");
+}
+
+TEST(ZplEncoder, StoresAndRecallsFormats) {
+  ZplEncoder format;
+  format.StartFormat("SHELF", 400, 240);
+  format.Text(20, 10, "", 30, 0, 1);
+  format.Barcode(20, 60, LabelBarcodeType::kCode128, "", 80, 2, true, 2);
+  format.QrCode(280, 60, "", 4, 3);
+  format.EndLabel();
+  EXPECT_EQ(Text(format),
+            "^XA^DFR:SHELF.ZPL^FS^PW400^LL240"
+            "^FO20,10^A0N,30,30^FN1^FS"
+            "^FO20,60^BY2^BCN,80,Y,N,N,A^FN2^FS"
+            "^FO280,60^BQN,2,4^FN3^FS"
+            "^XZ");
+
+  ZplEncoder recall;
+  recall.RecallFormat("SHELF");
+  recall.FieldData(1, "Milk 1L");
+  recall.FieldData(2, "SKU-42");
+  recall.FieldData(3, "https://example.com/p/42", true);
+  recall.EndLabel(2);
+  EXPECT_EQ(Text(recall),
+            "^XA^XFR:SHELF.ZPL^FS"
+            "^FN1^FDMilk 1L^FS^FN2^FDSKU-42^FS^FN3^FDMA,https://example.com/p/42^FS"
+            "^PQ2^XZ");
+}
+
+TEST(ZplEncoder, CompressesGraphicRows) {
+  // 32 dots wide: 8 hex digits per row
+  MonoBitmap bitmap(32, 5);
+  bitmap.FillRect(0, 0, 8, 1);    // FF000000 -> FF,
+  bitmap.FillRect(0, 1, 8, 1);    // same row -> :
+  bitmap.FillRect(8, 2, 24, 1);   // 00FFFFFF -> 00!
+  bitmap.FillRect(0, 3, 4, 1);
+  bitmap.Set(31, 3);              // F0000001 -> F, six 0s, 1
+  // Row 4 stays white -> ,
+  EXPECT_EQ(CompressZplGraphic(bitmap), "FF,:00!FL01,");
+}
+
+TEST(ZplEncoder, CompressesLongRunsWithRepeatCounts) {
+  // 800 dots: 200 hex digits per row; a single dot in the middle
+  MonoBitmap bitmap(800, 1);
+  bitmap.Set(400, 0);
+  // k is 100 zeros; the 99 after the 8 end the row
+  EXPECT_EQ(CompressZplGraphic(bitmap), "k08,");
+
+  MonoBitmap solid(3400, 1);
+  solid.FillRect(0, 0, 3400, 1);
+  // 850 F digits end the row, so they collapse into !
+  EXPECT_EQ(CompressZplGraphic(solid), "!");
+
+  MonoBitmap pattern(1760, 1);
+  for (int x = 0; x < 1760; x += 4) pattern.FillRect(x, 0, 2, 1);
+  pattern.Set(1759, 0);
+  // 439 C digits then a D: 419 (zY) and 20 (g) repeats
+  EXPECT_EQ(CompressZplGraphic(pattern), "zYCgCD");
+}
+
+TEST(ZplEncoder, GraphicField) {
+  MonoBitmap bitmap(16, 2);
+  bitmap.FillRect(0, 0, 16, 2);
+  ZplEncoder encoder;
+  encoder.Graphic(10, 20, bitmap);
+  EXPECT_EQ(Text(encoder), "^FO10,20^GFA,4,4,2,!:^FS");
+}
+
+}  // namespace test
+}  // namespace windows_printer
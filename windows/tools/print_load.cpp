@@ -0,0 +1,215 @@
+// Soak test of the native print path against simulated printers, e.g.
+//
+//   windows_printer_load --duration=3600 --threads=16 --rate=200
+//       --printers=6 --speed=30000 --buffer=4096 --latency-ms=2
+//       --failure-rate=0.001 --mix=receipt:70,kitchen:20:1,logo:10
+//
+// Prints a progress line every --sample seconds and a summary at the end.
+// Mix entries are name:weight[:priority] from the kinds below.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "load_generator.h"
+#include "simulated_spooler.h"
+
+namespace {
+
+using windows_printer::EscPosPaperSize;
+using windows_printer::HistogramSummary;
+using windows_printer::LoadJobKind;
+using windows_printer::LoadOptions;
+using windows_printer::LoadReport;
+using windows_printer::LoadSample;
+using windows_printer::SimulatedPrinterOptions;
+using windows_printer::SimulatedSpooler;
+
+uint64_t ResidentBytes() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters = {};
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+  return counters.WorkingSetSize;
+#else
+  unsigned long size = 0;
+  unsigned long resident = 0;
+  FILE* statm = std::fopen("/proc/self/statm", "r");
+  if (!statm) return 0;
+  const int read = std::fscanf(statm, "%lu %lu", &size, &resident);
+  std::fclose(statm);
+  return read == 2 ? resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) : 0;
+#endif
+}
+
+bool KindByName(const std::string& name, LoadJobKind* kind) {
+  kind->name = name;
+  if (name == "receipt") {
+    kind->lines = 20;
+  } else if (name == "long") {
+    kind->lines = 150;
+  } else if (name == "kitchen") {
+    kind->lines = 8;
+    kind->paperSize = EscPosPaperSize::kMm58;
+  } else if (name == "logo") {
+    kind->lines = 20;
+    kind->imageWidth = 384;
+    kind->imageHeight = 120;
+  } else if (name == "raster") {
+    kind->lines = 0;
+    kind->imageWidth = 576;
+    kind->imageHeight = 800;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool ParseMix(const std::string& text, std::vector<LoadJobKind>* mix) {
+  std::stringstream entries(text);
+  std::string entry;
+  while (std::getline(entries, entry, ',')) {
+    std::stringstream fields(entry);
+    std::string name;
+    std::string weight;
+    std::string priority;
+    std::getline(fields, name, ':');
+    std::getline(fields, weight, ':');
+    std::getline(fields, priority, ':');
+    LoadJobKind kind;
+    if (!KindByName(name, &kind)) return false;
+    kind.weight = weight.empty() ? 1.0 : std::atof(weight.c_str());
+    kind.priority = priority.empty() ? 0 : std::atoi(priority.c_str());
+    mix->push_back(kind);
+  }
+  return !mix->empty();
+}
+
+// Value of --name=value, or nullptr
+const char* Flag(const char* arg, const char* name) {
+  const size_t length = std::strlen(name);
+  if (std::strncmp(arg, "--", 2) != 0 || std::strncmp(arg + 2, name, length) != 0 ||
+      arg[2 + length] != '=') {
+    return nullptr;
+  }
+  return arg + 3 + length;
+}
+
+double Millis(uint64_t nanos) {
+  return static_cast<double>(nanos) / 1e6;
+}
+
+void PrintLatency(const HistogramSummary& summary) {
+  std::printf("  %-12s n=%-9llu p50=%8.2f ms  p99=%8.2f ms  p999=%8.2f ms  max=%8.2f ms\n",
+              summary.name.c_str(), static_cast<unsigned long long>(summary.count),
+              Millis(summary.p50), Millis(summary.p99), Millis(summary.p999),
+              Millis(summary.max));
+}
+
+int Usage() {
+  std::fprintf(stderr,
+               "usage: windows_printer_load [--duration=SECONDS] [--threads=N] [--rate=JOBS/S]\n"
+               "    [--printers=N] [--speed=BYTES/S] [--buffer=BYTES] [--latency-ms=MS]\n"
+               "    [--failure-rate=P] [--timeout-ms=MS] [--sample=SECONDS] [--seed=N]\n"
+               "    [--mix=KIND:WEIGHT[:PRIORITY],...]\n"
+               "kinds: receipt, long, kitchen, logo, raster\n");
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  LoadOptions options;
+  options.duration = std::chrono::seconds(60);
+  options.memoryProbe = ResidentBytes;
+  SimulatedPrinterOptions printer;
+  int printers = 4;
+  std::string mix = "receipt:70,kitchen:20:1,logo:10";
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = nullptr;
+    if ((value = Flag(arg, "duration"))) {
+      options.duration = std::chrono::milliseconds(static_cast<int64_t>(std::atof(value) * 1000));
+    } else if ((value = Flag(arg, "threads"))) {
+      options.threads = static_cast<size_t>(std::atoi(value));
+    } else if ((value = Flag(arg, "rate"))) {
+      options.jobsPerSecond = std::atof(value);
+    } else if ((value = Flag(arg, "printers"))) {
+      printers = std::atoi(value);
+    } else if ((value = Flag(arg, "speed"))) {
+      printer.bytesPerSecond = std::strtoull(value, nullptr, 10);
+    } else if ((value = Flag(arg, "buffer"))) {
+      printer.bufferSize = static_cast<size_t>(std::strtoull(value, nullptr, 10));
+    } else if ((value = Flag(arg, "latency-ms"))) {
+      printer.latency = std::chrono::microseconds(static_cast<int64_t>(std::atof(value) * 1000));
+    } else if ((value = Flag(arg, "failure-rate"))) {
+      printer.failureRate = std::atof(value);
+    } else if ((value = Flag(arg, "timeout-ms"))) {
+      options.timeout = std::chrono::milliseconds(std::atoi(value));
+    } else if ((value = Flag(arg, "sample"))) {
+      options.sampleInterval =
+          std::chrono::milliseconds(static_cast<int64_t>(std::atof(value) * 1000));
+    } else if ((value = Flag(arg, "seed"))) {
+      options.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+    } else if ((value = Flag(arg, "mix"))) {
+      mix = value;
+    } else {
+      return Usage();
+    }
+  }
+  if (!ParseMix(mix, &options.mix) || printers < 1 || options.threads < 1 ||
+      options.sampleInterval.count() < 1) {
+    return Usage();
+  }
+
+  auto spooler = std::make_shared<SimulatedSpooler>(options.seed);
+  for (int i = 0; i < printers; i++) {
+    const std::string name = "Printer " + std::to_string(i + 1);
+    spooler->AddPrinter(name, printer);
+    options.printers.push_back(name);
+  }
+
+  std::printf("%10s %10s %10s %8s %10s %8s %11s %10s\n", "elapsed_s", "submitted", "printed",
+              "failed", "jobs/s", "queued", "p99_ms", "rss_mb");
+  options.onSample = [](const LoadSample& sample) {
+    std::printf("%10.1f %10llu %10llu %8llu %10.1f %8llu %11.2f %10.1f\n", sample.elapsedSeconds,
+                static_cast<unsigned long long>(sample.submitted),
+                static_cast<unsigned long long>(sample.printed),
+                static_cast<unsigned long long>(sample.failed), sample.jobsPerSecond,
+                static_cast<unsigned long long>(sample.outstanding), Millis(sample.p99),
+                static_cast<double>(sample.residentBytes) / (1 << 20));
+    std::fflush(stdout);
+  };
+
+  const LoadReport report = windows_printer::RunLoad(spooler, options);
+
+  std::printf("\n%.1f s: %llu submitted, %llu printed, %llu failed, %llu still queued\n",
+              report.elapsedSeconds, static_cast<unsigned long long>(report.submitted),
+              static_cast<unsigned long long>(report.printed),
+              static_cast<unsigned long long>(report.failed),
+              static_cast<unsigned long long>(report.outstanding));
+  std::printf("throughput: %.1f jobs/s, %.1f KB/s submitted\n", report.jobsPerSecond,
+              report.elapsedSeconds > 0.0
+                  ? static_cast<double>(report.bytesSubmitted) / 1024 / report.elapsedSeconds
+                  : 0.0);
+  std::printf("latency:\n");
+  PrintLatency(report.submitLatency);
+  PrintLatency(report.completeLatency);
+  for (const auto& priority : report.priorities) {
+    PrintLatency(priority.latency);
+  }
+  std::printf("memory growth: %+.1f MB\n",
+              static_cast<double>(report.memoryGrowthBytes) / (1 << 20));
+  return report.outstanding == 0 ? 0 : 1;
+}
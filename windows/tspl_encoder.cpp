@@ -0,0 +1,215 @@
+#include "tspl_encoder.h"
+
+#include <algorithm>
+
+namespace windows_printer {
+
+namespace {
+
+struct TsplFont {
+  const char* name;
+  int width;
+  int height;
+};
+
+// Built-in bitmap fonts 1 to 5 at 203 dpi
+constexpr TsplFont kFonts[] = {
+    {"1", 8, 12}, {"2", 12, 20}, {"3", 16, 24}, {"4", 24, 32}, {"5", 32, 48},
+};
+
+// TSPL scales fonts by 1 to 10
+int Multiplier(int size, int fontSize) {
+  return std::clamp(size / fontSize, 1, 10);
+}
+
+const char* BarcodeName(LabelBarcodeType type) {
+  switch (type) {
+    case LabelBarcodeType::kCode128:
+      return "128";
+    case LabelBarcodeType::kCode39:
+      return "39";
+    case LabelBarcodeType::kEan13:
+      return "EAN13";
+    case LabelBarcodeType::kEan8:
+      return "EAN8";
+    case LabelBarcodeType::kUpcA:
+      return "UPCA";
+  }
+  return "128";
+}
+
+}  // namespace
+
+void TsplEncoder::Clear() {
+  buffer_.clear();
+}
+
+void TsplEncoder::Setup(int widthMm, int heightMm, int gapMm) {
+  if (widthMm > 0 && heightMm > 0) {
+    Append("SIZE ");
+    AppendNumber(widthMm);
+    Append(" mm,");
+    AppendNumber(heightMm);
+    Append(" mm");
+    EndLine();
+    Append("GAP ");
+    AppendNumber(std::max(0, gapMm));
+    Append(" mm,0 mm");
+    EndLine();
+  }
+  Append("CLS");
+  EndLine();
+}
+
+void TsplEncoder::StartFormat(std::string_view name) {
+  Append("DOWNLOAD \"");
+  Append(name);
+  Append(".BAS\"");
+  EndLine();
+}
+
+void TsplEncoder::EndFormat() {
+  Append("EOP");
+  EndLine();
+}
+
+void TsplEncoder::Text(int x, int y, std::string_view text, int height, int width, int field) {
+  const TsplFont* font = &kFonts[0];
+  for (const TsplFont& candidate : kFonts) {
+    if (candidate.height <= height) font = &candidate;
+  }
+  const int yMultiplier = Multiplier(height, font->height);
+  const int xMultiplier = width > 0 ? Multiplier(width, font->width) : yMultiplier;
+
+  Append("TEXT ");
+  AppendNumber(x);
+  Append(",");
+  AppendNumber(y);
+  Append(",\"");
+  Append(font->name);
+  Append("\",0,");
+  AppendNumber(xMultiplier);
+  Append(",");
+  AppendNumber(yMultiplier);
+  Append(",");
+  AppendString(text, field);
+  EndLine();
+}
+
+bool TsplEncoder::Barcode(int x, int y, LabelBarcodeType type, std::string_view data, int height,
+                          int narrowWidth, bool showText, int field) {
+  if (field <= 0 && !IsValidLabelBarcodeData(type, data)) return false;
+
+  const int narrow = std::max(1, narrowWidth);
+  // Code 39 has a 3:1 wide to narrow ratio; the others ignore the wide bar
+  const int wide = type == LabelBarcodeType::kCode39 ? narrow * 3 : narrow;
+  Append("BARCODE ");
+  AppendNumber(x);
+  Append(",");
+  AppendNumber(y);
+  Append(",\"");
+  Append(BarcodeName(type));
+  Append("\",");
+  AppendNumber(height);
+  Append(showText ? ",1,0," : ",0,0,");
+  AppendNumber(narrow);
+  Append(",");
+  AppendNumber(wide);
+  Append(",");
+  AppendString(data, field);
+  EndLine();
+  return true;
+}
+
+void TsplEncoder::QrCode(int x, int y, std::string_view data, int cellWidth, int field) {
+  Append("QRCODE ");
+  AppendNumber(x);
+  Append(",");
+  AppendNumber(y);
+  Append(",M,");
+  AppendNumber(std::clamp(cellWidth, 1, 10));
+  Append(",A,0,");
+  AppendString(data, field);
+  EndLine();
+}
+
+void TsplEncoder::Graphic(int x, int y, const MonoBitmap& bitmap) {
+  if (bitmap.Width() == 0 || bitmap.Height() == 0) return;
+  Append("BITMAP ");
+  AppendNumber(x);
+  Append(",");
+  AppendNumber(y);
+  Append(",");
+  Append(std::to_string(bitmap.Stride()));
+  Append(",");
+  AppendNumber(bitmap.Height());
+  Append(",0,");
+  for (int row = 0; row < bitmap.Height(); row++) {
+    const uint8_t* bits = bitmap.Row(row);
+    for (size_t i = 0; i < bitmap.Stride(); i++) {
+      buffer_.push_back(static_cast<uint8_t>(~bits[i]));
+    }
+  }
+  EndLine();
+}
+
+void TsplEncoder::Print(int copies) {
+  Append("PRINT ");
+  AppendNumber(std::max(1, copies));
+  EndLine();
+}
+
+void TsplEncoder::FieldData(int field, std::string_view data) {
+  Append("F");
+  AppendNumber(field);
+  Append("$=");
+  AppendString(data);
+  EndLine();
+}
+
+void TsplEncoder::RunFormat(std::string_view name) {
+  Append("RUN \"");
+  Append(name);
+  Append(".BAS\"");
+  EndLine();
+}
+
+void TsplEncoder::Raw(const uint8_t* data, size_t length) {
+  buffer_.insert(buffer_.end(), data, data + length);
+}
+
+void TsplEncoder::Append(std::string_view text) {
+  buffer_.insert(buffer_.end(), text.begin(), text.end());
+}
+
+void TsplEncoder::AppendNumber(int value) {
+  Append(std::to_string(value));
+}
+
+void TsplEncoder::AppendString(std::string_view text, int field) {
+  if (field > 0) {
+    Append("F");
+    AppendNumber(field);
+    Append("$");
+    return;
+  }
+  buffer_.push_back('"');
+  for (char c : text) {
+    if (c == '"') {
+      // TSPL's escape for a quote inside a string
+      Append("\\[\"]");
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      // A line break would end the command
+      buffer_.push_back(' ');
+    } else {
+      buffer_.push_back(static_cast<uint8_t>(c));
+    }
+  }
+  buffer_.push_back('"');
+}
+
+void TsplEncoder::EndLine() {
+  Append("\r\n");
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,73 @@
+#ifndef FLUTTER_PLUGIN_TSPL_ENCODER_H_
+#define FLUTTER_PLUGIN_TSPL_ENCODER_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "label_layout.h"
+#include "mono_bitmap.h"
+
+namespace windows_printer {
+
+// TSPL command generator for TSC label printers. Every command is a line
+// ending in CR LF. Field n of a stored format is the string variable Fn$.
+class TsplEncoder {
+public:
+  TsplEncoder() = default;
+
+  const std::vector<uint8_t>& Bytes() const { return buffer_; }
+
+  void Clear();
+
+  /// SIZE and GAP when the size is given, then CLS to start a new image
+  void Setup(int widthMm, int heightMm, int gapMm);
+
+  /// DOWNLOAD: commands up to EndFormat are stored on the printer as the
+  /// program name.BAS instead of run
+  void StartFormat(std::string_view name);
+
+  /// EOP
+  void EndFormat();
+
+  /// Built-in bitmap font text, the largest font no taller than height
+  /// scaled up by whole multiples. With a field number, its variable.
+  void Text(int x, int y, std::string_view text, int height, int width = 0, int field = 0);
+
+  /// Returns false and adds nothing if data is invalid for type. With a
+  /// field number, its variable and data is not checked.
+  bool Barcode(int x, int y, LabelBarcodeType type, std::string_view data, int height,
+               int narrowWidth = 2, bool showText = true, int field = 0);
+
+  /// QR code, error correction M
+  void QrCode(int x, int y, std::string_view data, int cellWidth = 4, int field = 0);
+
+  /// BITMAP in overwrite mode. TSPL prints clear bits, so the rows are sent
+  /// inverted.
+  void Graphic(int x, int y, const MonoBitmap& bitmap);
+
+  /// PRINT copies of the image
+  void Print(int copies = 1);
+
+  /// Set the variable of a field before RunFormat
+  void FieldData(int field, std::string_view data);
+
+  /// RUN a stored format
+  void RunFormat(std::string_view name);
+
+  void Raw(const uint8_t* data, size_t length);
+
+private:
+  void Append(std::string_view text);
+  void AppendNumber(int value);
+  /// "text" with quotes escaped and control characters blanked, or Fn$
+  void AppendString(std::string_view text, int field = 0);
+  void EndLine();
+
+  std::vector<uint8_t> buffer_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_TSPL_ENCODER_H_
@@ -0,0 +1,55 @@
+#include "win32_printer_enumerator.h"
+
+#include <windows.h>
+#include <winspool.h>
+
+#include <vector>
+
+#include "print_metrics.h"
+#include "string_convert.h"
+
+namespace windows_printer {
+
+namespace {
+
+std::vector<std::string> EnumPrinterNames(DWORD flags) {
+  std::vector<std::string> names;
+  ScopedStageTimer queryTimer(MetricStage::kQueryPrinter);
+  DWORD needed = 0, returned = 0;
+  EnumPrinters(flags, NULL, 4, NULL, 0, &needed, &returned);
+
+  if (needed > 0) {
+    std::vector<BYTE> buffer(needed);
+    PRINTER_INFO_4* printerInfo = reinterpret_cast<PRINTER_INFO_4*>(buffer.data());
+
+    if (EnumPrinters(flags, NULL, 4, buffer.data(), needed, &needed, &returned)) {
+      names.reserve(returned);
+      for (DWORD i = 0; i < returned; i++) {
+        if (printerInfo[i].pPrinterName != nullptr) {
+          names.push_back(Utf16ToUtf8<wchar_t>(printerInfo[i].pPrinterName));
+        }
+      }
+    } else {
+      PrintMetrics::Instance().RecordFailure(MetricStage::kQueryPrinter,
+                                             static_cast<uint32_t>(GetLastError()));
+    }
+  }
+  return names;
+}
+
+}  // namespace
+
+std::vector<std::string> Win32PrinterEnumerator::EnumerateLocal() {
+  return EnumPrinterNames(PRINTER_ENUM_LOCAL);
+}
+
+void Win32PrinterEnumerator::EnumerateConnections(
+    const std::function<void(const std::string& name)>& onPrinter) {
+  // The spooler resolves every connection inside one EnumPrinters call, so
+  // connections are reported together once that call returns.
+  for (const std::string& name : EnumPrinterNames(PRINTER_ENUM_CONNECTIONS)) {
+    onPrinter(name);
+  }
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,17 @@
+#ifndef FLUTTER_PLUGIN_WIN32_PRINTER_ENUMERATOR_H_
+#define FLUTTER_PLUGIN_WIN32_PRINTER_ENUMERATOR_H_
+
+#include "printer_discovery.h"
+
+namespace windows_printer {
+
+// PrinterEnumerator backed by EnumPrinters level 4
+class Win32PrinterEnumerator : public PrinterEnumerator {
+public:
+  std::vector<std::string> EnumerateLocal() override;
+  void EnumerateConnections(const std::function<void(const std::string& name)>& onPrinter) override;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_WIN32_PRINTER_ENUMERATOR_H_
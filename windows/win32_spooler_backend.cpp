@@ -0,0 +1,196 @@
+#include "win32_spooler_backend.h"
+
+#include <windows.h>
+#include <winspool.h>
+
+#include <string>
+#include <vector>
+
+#include "string_convert.h"
+#include "string_intern.h"
+
+namespace windows_printer {
+
+namespace {
+
+static_assert(kJobStatusPaused == JOB_STATUS_PAUSED && kJobStatusError == JOB_STATUS_ERROR &&
+                  kJobStatusDeleting == JOB_STATUS_DELETING &&
+                  kJobStatusSpooling == JOB_STATUS_SPOOLING &&
+                  kJobStatusPrinting == JOB_STATUS_PRINTING &&
+                  kJobStatusOffline == JOB_STATUS_OFFLINE &&
+                  kJobStatusPaperOut == JOB_STATUS_PAPEROUT &&
+                  kJobStatusPrinted == JOB_STATUS_PRINTED &&
+                  kJobStatusDeleted == JOB_STATUS_DELETED &&
+                  kJobStatusBlockedDevq == JOB_STATUS_BLOCKED_DEVQ &&
+                  kJobStatusUserIntervention == JOB_STATUS_USER_INTERVENTION &&
+                  kJobStatusRestart == JOB_STATUS_RESTART &&
+                  kJobStatusComplete == JOB_STATUS_COMPLETE,
+              "kJobStatus* must match the spooler's JOB_STATUS_* bits");
+
+// Document names and datatypes come from a handful of callers
+Utf16InternTable<wchar_t>& DocStrings() {
+  static Utf16InternTable<wchar_t> strings(64);
+  return strings;
+}
+
+}  // namespace
+
+Win32SpoolerBackend& Win32SpoolerBackend::Instance() {
+  static Win32SpoolerBackend backend;
+  return backend;
+}
+
+std::shared_ptr<SpoolerBackend> Win32SpoolerBackend::SharedInstance() {
+  // The instance is never destroyed before the process exits
+  static const std::shared_ptr<SpoolerBackend> shared(&Instance(), [](SpoolerBackend*) {});
+  return shared;
+}
+
+std::shared_ptr<const std::wstring> Win32SpoolerBackend::WidePrinterName(
+    const std::string& printerName) {
+  static Utf16InternTable<wchar_t> names;
+  return names.Intern(printerName);
+}
+
+bool Win32SpoolerBackend::DefaultPrinterName(std::string* name) {
+  WCHAR defaultPrinterName[256] = {0};
+  DWORD defaultPrinterSize = sizeof(defaultPrinterName) / sizeof(WCHAR);
+  if (!::GetDefaultPrinterW(defaultPrinterName, &defaultPrinterSize)) {
+    return false;
+  }
+  *name = Utf16ToUtf8<wchar_t>(defaultPrinterName);
+  return true;
+}
+
+bool Win32SpoolerBackend::Open(const std::string& printerName, PrinterHandle* handle) {
+  std::shared_ptr<const std::wstring> widePrinterName = WidePrinterName(printerName);
+  HANDLE hPrinter = NULL;
+  if (!::OpenPrinterW(const_cast<LPWSTR>(widePrinterName->c_str()), &hPrinter, NULL)) {
+    return false;
+  }
+  *handle = hPrinter;
+  return true;
+}
+
+uint32_t Win32SpoolerBackend::StartDocument(PrinterHandle handle, const RawDocInfo& docInfo) {
+  std::shared_ptr<const std::wstring> docName = DocStrings().Intern(docInfo.documentName);
+  std::shared_ptr<const std::wstring> datatype = DocStrings().Intern(docInfo.datatype);
+
+  DOC_INFO_1W info = {0};
+  info.pDocName = const_cast<LPWSTR>(docName->c_str());
+  info.pOutputFile = NULL;
+  info.pDatatype = const_cast<LPWSTR>(datatype->c_str());
+  return ::StartDocPrinterW(static_cast<HANDLE>(handle), 1, reinterpret_cast<LPBYTE>(&info));
+}
+
+bool Win32SpoolerBackend::StartPage(PrinterHandle handle) {
+  return ::StartPagePrinter(static_cast<HANDLE>(handle)) != FALSE;
+}
+
+bool Win32SpoolerBackend::Write(PrinterHandle handle, const uint8_t* data, uint32_t size,
+                                uint32_t* bytesWritten) {
+  DWORD written = 0;
+  BOOL ok = ::WritePrinter(static_cast<HANDLE>(handle), const_cast<uint8_t*>(data), size, &written);
+  *bytesWritten = written;
+  return ok != FALSE;
+}
+
+bool Win32SpoolerBackend::EndPage(PrinterHandle handle) {
+  return ::EndPagePrinter(static_cast<HANDLE>(handle)) != FALSE;
+}
+
+bool Win32SpoolerBackend::EndDocument(PrinterHandle handle) {
+  return ::EndDocPrinter(static_cast<HANDLE>(handle)) != FALSE;
+}
+
+bool Win32SpoolerBackend::Close(PrinterHandle handle) {
+  return ::ClosePrinter(static_cast<HANDLE>(handle)) != FALSE;
+}
+
+bool Win32SpoolerBackend::SetJobCopies(PrinterHandle handle, uint32_t jobId, uint32_t copies) {
+  HANDLE hPrinter = static_cast<HANDLE>(handle);
+  DWORD needed = 0;
+  ::GetJobW(hPrinter, jobId, 2, NULL, 0, &needed);
+  if (needed == 0) return false;
+  std::vector<BYTE> buffer(needed);
+  if (!::GetJobW(hPrinter, jobId, 2, buffer.data(), needed, &needed)) return false;
+
+  JOB_INFO_2W* job = reinterpret_cast<JOB_INFO_2W*>(buffer.data());
+  if (job->pDevMode == NULL || job->pPrinterName == NULL) {
+    ::SetLastError(ERROR_NOT_SUPPORTED);
+    return false;
+  }
+  // The driver reports how many copies it can make; 1 means it makes none
+  int maxCopies = ::DeviceCapabilitiesW(job->pPrinterName, NULL, DC_COPIES, NULL, NULL);
+  if (maxCopies < 0 || static_cast<uint32_t>(maxCopies) < copies) {
+    ::SetLastError(ERROR_NOT_SUPPORTED);
+    return false;
+  }
+
+  job->pDevMode->dmCopies = static_cast<short>(copies);
+  job->pDevMode->dmFields |= DM_COPIES;
+  job->Position = JOB_POSITION_UNSPECIFIED;
+  return ::SetJobW(hPrinter, jobId, 2, buffer.data(), 0) != FALSE;
+}
+
+bool Win32SpoolerBackend::CancelJob(const std::string& printerName, uint32_t jobId) {
+  PrinterHandle handle = nullptr;
+  if (!Open(printerName, &handle)) {
+    return false;
+  }
+  // JOB_CONTROL_CANCEL is documented as obsolete; deleting the job makes a
+  // pending WritePrinter fail with ERROR_PRINT_CANCELLED
+  BOOL ok = ::SetJobW(static_cast<HANDLE>(handle), jobId, 0, NULL, JOB_CONTROL_DELETE);
+  DWORD error = ::GetLastError();
+  ::ClosePrinter(static_cast<HANDLE>(handle));
+  ::SetLastError(error);
+  return ok != FALSE;
+}
+
+bool Win32SpoolerBackend::EnumerateJobs(const std::string& printerName,
+                                        std::vector<QueuedJob>* jobs) {
+  PrinterHandle handle = nullptr;
+  if (!Open(printerName, &handle)) {
+    return false;
+  }
+  HANDLE hPrinter = static_cast<HANDLE>(handle);
+
+  // The queue can grow between sizing the buffer and filling it
+  std::vector<BYTE> buffer;
+  DWORD needed = 0;
+  DWORD returned = 0;
+  BOOL ok = FALSE;
+  for (int attempt = 0; attempt < 3 && !ok; attempt++) {
+    ok = ::EnumJobsW(hPrinter, 0, 0xFFFFFFFF, 1, buffer.empty() ? NULL : buffer.data(),
+                     static_cast<DWORD>(buffer.size()), &needed, &returned);
+    if (!ok && ::GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
+      buffer.resize(needed);
+    } else {
+      break;
+    }
+  }
+  DWORD error = ::GetLastError();
+  ::ClosePrinter(hPrinter);
+  if (!ok) {
+    ::SetLastError(error);
+    return false;
+  }
+
+  jobs->clear();
+  const JOB_INFO_1W* info = reinterpret_cast<const JOB_INFO_1W*>(buffer.data());
+  for (DWORD i = 0; i < returned; i++) {
+    QueuedJob job;
+    job.jobId = info[i].JobId;
+    job.status = info[i].Status;
+    job.pagesPrinted = info[i].PagesPrinted;
+    job.totalPages = info[i].TotalPages;
+    jobs->push_back(job);
+  }
+  return true;
+}
+
+uint32_t Win32SpoolerBackend::LastError() const {
+  return static_cast<uint32_t>(::GetLastError());
+}
+
+}  // namespace windows_printer
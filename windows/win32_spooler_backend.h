@@ -0,0 +1,41 @@
+#ifndef FLUTTER_PLUGIN_WIN32_SPOOLER_BACKEND_H_
+#define FLUTTER_PLUGIN_WIN32_SPOOLER_BACKEND_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "spooler_backend.h"
+
+namespace windows_printer {
+
+// SpoolerBackend backed by the Windows print spooler (winspool)
+class Win32SpoolerBackend : public SpoolerBackend {
+public:
+  /// Shared instance; the backend holds no state
+  static Win32SpoolerBackend& Instance();
+  /// The shared instance for callers that keep a reference to their backend
+  static std::shared_ptr<SpoolerBackend> SharedInstance();
+
+  /// UTF-16 form of a printer name for the Win32 API. Each name is converted
+  /// once and then shared by every call that names the printer.
+  static std::shared_ptr<const std::wstring> WidePrinterName(const std::string& printerName);
+
+  bool DefaultPrinterName(std::string* name) override;
+  bool Open(const std::string& printerName, PrinterHandle* handle) override;
+  uint32_t StartDocument(PrinterHandle handle, const RawDocInfo& docInfo) override;
+  bool StartPage(PrinterHandle handle) override;
+  bool Write(PrinterHandle handle, const uint8_t* data, uint32_t size,
+             uint32_t* bytesWritten) override;
+  bool EndPage(PrinterHandle handle) override;
+  bool EndDocument(PrinterHandle handle) override;
+  bool Close(PrinterHandle handle) override;
+  bool SetJobCopies(PrinterHandle handle, uint32_t jobId, uint32_t copies) override;
+  bool CancelJob(const std::string& printerName, uint32_t jobId) override;
+  bool EnumerateJobs(const std::string& printerName, std::vector<QueuedJob>* jobs) override;
+  uint32_t LastError() const override;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_WIN32_SPOOLER_BACKEND_H_
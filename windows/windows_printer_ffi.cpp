@@ -0,0 +1,453 @@
+#include "include/windows_printer/windows_printer_ffi.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "esc_pos_encoder.h"
+#include "ffi_runtime.h"
+#include "print_job.h"
+#include "print_metrics.h"
+#include "raw_print_stream.h"
+#include "receipt_image.h"
+#include "task_pool.h"
+
+namespace windows_printer {
+
+namespace {
+
+static_assert(static_cast<int>(JobState::kSpooling) == WINDOWS_PRINTER_JOB_SPOOLING &&
+                  static_cast<int>(JobState::kPrinting) == WINDOWS_PRINTER_JOB_PRINTING &&
+                  static_cast<int>(JobState::kPrinted) == WINDOWS_PRINTER_JOB_PRINTED &&
+                  static_cast<int>(JobState::kError) == WINDOWS_PRINTER_JOB_ERROR &&
+                  static_cast<int>(JobState::kDeleted) == WINDOWS_PRINTER_JOB_DELETED,
+              "WINDOWS_PRINTER_JOB_* must match JobState");
+static_assert(static_cast<int>(MetricStage::kWritePrinter) == WINDOWS_PRINTER_STAGE_WRITE_PRINTER &&
+                  static_cast<int>(MetricStage::kCount) == WINDOWS_PRINTER_STAGE_COUNT,
+              "WINDOWS_PRINTER_STAGE_* must match MetricStage");
+static_assert(static_cast<int>(PrintStreamEventType::kStarted) == WINDOWS_PRINTER_STREAM_STARTED &&
+                  static_cast<int>(PrintStreamEventType::kWritable) ==
+                      WINDOWS_PRINTER_STREAM_WRITABLE &&
+                  static_cast<int>(PrintStreamEventType::kFinished) ==
+                      WINDOWS_PRINTER_STREAM_FINISHED &&
+                  static_cast<int>(PrintStreamEventType::kFailed) == WINDOWS_PRINTER_STREAM_FAILED &&
+                  static_cast<int>(PrintStreamEventType::kCancelled) ==
+                      WINDOWS_PRINTER_STREAM_CANCELLED,
+              "WINDOWS_PRINTER_STREAM_* must match PrintStreamEventType");
+
+// Same bound as printRawData's copies argument
+constexpr int32_t kMaxCopies = 999;
+
+// Callers built against version 1 or 2 pass a struct that ends here
+constexpr size_t kMetricsVersion1Size = offsetof(WindowsPrinterMetrics, pendingJobs);
+
+struct Runtime {
+  std::shared_ptr<SpoolerBackend> backend;
+  std::shared_ptr<JobTracker> tracker;
+  FfiStreamListener streamListener;
+  std::shared_ptr<PrintBudget> budget;
+};
+
+std::mutex& RuntimeMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+Runtime& InstalledRuntime() {
+  static Runtime runtime;
+  return runtime;
+}
+
+// Copy of the installed runtime, so a call outlives an uninstall
+Runtime CurrentRuntime() {
+  std::lock_guard<std::mutex> lock(RuntimeMutex());
+  return InstalledRuntime();
+}
+
+std::string PrinterNameArgument(const char* printerName) {
+  return printerName ? std::string(printerName) : std::string();
+}
+
+uint32_t NextStreamId() {
+  static std::atomic<uint32_t> next{1};
+  return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Runs on a stream's writer thread. A started job is followed like any
+// other; the event then goes to the listener installed at that moment,
+// under the lock so an uninstall waits for it.
+void DeliverStreamEvent(uint32_t streamId, const std::string& documentName,
+                        const PrintStreamEvent& event) {
+  Runtime runtime = CurrentRuntime();
+  if (event.type == PrintStreamEventType::kStarted && runtime.tracker) {
+    runtime.tracker->Track(event.printerName, event.jobId, documentName);
+  }
+  std::lock_guard<std::mutex> lock(RuntimeMutex());
+  if (InstalledRuntime().streamListener) {
+    InstalledRuntime().streamListener(streamId, event);
+  }
+}
+
+void CopyTrackedJob(const TrackedJob& tracked, WindowsPrinterJob* job) {
+  job->jobId = tracked.jobId;
+  job->state = static_cast<int32_t>(tracked.state);
+  job->status = tracked.status;
+  job->pagesPrinted = tracked.pagesPrinted;
+  job->totalPages = tracked.totalPages;
+}
+
+// Records an FFI call alongside the channel methods in getMetrics
+class ScopedFfiCall {
+public:
+  explicit ScopedFfiCall(const char* name)
+      : name_(name), start_(std::chrono::steady_clock::now()) {}
+  ~ScopedFfiCall() {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_);
+    PrintMetrics::Instance().RecordMethod(name_, static_cast<uint64_t>(elapsed.count()),
+                                          result_ != WINDOWS_PRINTER_FFI_OK);
+  }
+
+  ScopedFfiCall(const ScopedFfiCall&) = delete;
+  ScopedFfiCall& operator=(const ScopedFfiCall&) = delete;
+
+  int32_t Return(int32_t result) {
+    result_ = result;
+    return result;
+  }
+
+private:
+  const char* name_;
+  std::chrono::steady_clock::time_point start_;
+  int32_t result_ = WINDOWS_PRINTER_FFI_OK;
+};
+
+// Message into a caller's buffer of errorSize bytes, cut short to fit and
+// NUL-terminated
+void CopyErrorMessage(const std::string& message, char* error, uint32_t errorSize) {
+  if (!error || errorSize == 0) return;
+  const size_t length = std::min<size_t>(message.size(), errorSize - 1);
+  std::memcpy(error, message.data(), length);
+  error[length] = '\0';
+}
+
+bool IsValidImageWidth(int32_t width) {
+  return width >= 1 && width <= kMaxImageDimension;
+}
+
+// ESC/POS bit image bands of one image, in memory from
+// WindowsPrinterAllocate. Only the image: the receipt it goes into has
+// already initialized the printer.
+int32_t EncodeReceiptImage(const uint8_t* image, uint64_t size, const ReceiptImageOptions& options,
+                           uint8_t** output, uint64_t* outputSize, std::string* message) {
+  *output = nullptr;
+  *outputSize = 0;
+  if (!image || size == 0 || size > SIZE_MAX) {
+    *message = "Invalid argument";
+    return WINDOWS_PRINTER_FFI_INVALID_ARGUMENT;
+  }
+  MonoBitmap bitmap;
+  if (!RasterizeReceiptImage(image, static_cast<size_t>(size), options, &bitmap, message)) {
+    return WINDOWS_PRINTER_FFI_INVALID_ARGUMENT;
+  }
+  EscPosEncoder encoder;
+  const size_t initialize = encoder.Bytes().size();
+  encoder.Bitmap(bitmap);
+  const std::vector<uint8_t>& bytes = encoder.Bytes();
+  const size_t length = bytes.size() - initialize;
+  uint8_t* copy = WindowsPrinterAllocate(length);
+  if (!copy) {
+    *message = "Out of memory";
+    return WINDOWS_PRINTER_FFI_FAILED;
+  }
+  std::memcpy(copy, bytes.data() + initialize, length);
+  *output = copy;
+  *outputSize = length;
+  return WINDOWS_PRINTER_FFI_OK;
+}
+
+}  // namespace
+
+void InstallFfiRuntime(std::shared_ptr<SpoolerBackend> backend,
+                       std::shared_ptr<JobTracker> tracker,
+                       FfiStreamListener streamListener,
+                       std::shared_ptr<PrintBudget> budget) {
+  std::lock_guard<std::mutex> lock(RuntimeMutex());
+  InstalledRuntime().backend = std::move(backend);
+  InstalledRuntime().tracker = std::move(tracker);
+  InstalledRuntime().streamListener = std::move(streamListener);
+  InstalledRuntime().budget = std::move(budget);
+}
+
+}  // namespace windows_printer
+
+// Behind the opaque handle of the C ABI. Reserve and commit are called by
+// the one producer thread the stream allows.
+struct WindowsPrinterStream {
+  uint32_t id = 0;
+  std::unique_ptr<windows_printer::RawPrintStream> stream;
+  // Size of the last reserved region; a commit may not exceed it
+  size_t reserved = 0;
+};
+
+using windows_printer::AdmitStatus;
+using windows_printer::CopyErrorMessage;
+using windows_printer::CopyTrackedJob;
+using windows_printer::CurrentRuntime;
+using windows_printer::DeliverStreamEvent;
+using windows_printer::EncodeReceiptImage;
+using windows_printer::IsValidImageWidth;
+using windows_printer::kMaxCopies;
+using windows_printer::kMetricsVersion1Size;
+using windows_printer::MetricsSnapshot;
+using windows_printer::NextStreamId;
+using windows_printer::OverflowPolicy;
+using windows_printer::ParallelFor;
+using windows_printer::PrintStreamEvent;
+using windows_printer::PrinterNameArgument;
+using windows_printer::PrintMetrics;
+using windows_printer::RawPrintOptions;
+using windows_printer::RawPrintResult;
+using windows_printer::RawPrintStream;
+using windows_printer::RawPrintStreamOptions;
+using windows_printer::ReceiptImageOptions;
+using windows_printer::Runtime;
+using windows_printer::ScopedFfiCall;
+using windows_printer::SharedTaskPool;
+using windows_printer::SubmitRawJob;
+using windows_printer::TrackedJob;
+
+int32_t WindowsPrinterFfiVersion(void) {
+  return WINDOWS_PRINTER_FFI_VERSION;
+}
+
+uint8_t* WindowsPrinterAllocate(uint64_t size) {
+  if (size == 0 || size > SIZE_MAX) return nullptr;
+  return static_cast<uint8_t*>(std::malloc(static_cast<size_t>(size)));
+}
+
+void WindowsPrinterFree(void* buffer) {
+  std::free(buffer);
+}
+
+int32_t WindowsPrinterSubmitRawJob(const char* printerName, const uint8_t* data, uint64_t size,
+                                   int32_t useRawDatatype, int32_t copies, uint32_t timeoutMs,
+                                   WindowsPrinterJob* job) {
+  ScopedFfiCall call("ffiSubmitRawJob");
+  if (!job || (!data && size > 0) || size > SIZE_MAX || copies < 1 || copies > kMaxCopies) {
+    return call.Return(WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  }
+  *job = WindowsPrinterJob();
+  Runtime runtime = CurrentRuntime();
+  if (!runtime.backend) {
+    return call.Return(WINDOWS_PRINTER_FFI_NOT_READY);
+  }
+
+  RawPrintOptions options;
+  options.useRawDatatype = useRawDatatype != 0;
+  options.copies = copies;
+  options.timeout = std::chrono::milliseconds(timeoutMs);
+  const std::string name = PrinterNameArgument(printerName);
+  if (runtime.budget) {
+    // This call blocks the calling isolate, so a full budget fails at once
+    // whatever the overflow policy; waiting or spilling is for printRawJob
+    if (runtime.budget->Admit(name, size, OverflowPolicy::kReject, std::chrono::milliseconds(0),
+                              &options.reservation) != AdmitStatus::kAdmitted) {
+      return call.Return(WINDOWS_PRINTER_FFI_QUEUE_FULL);
+    }
+  }
+  RawPrintResult result =
+      SubmitRawJob(runtime.backend, name, data, static_cast<size_t>(size), options);
+  job->jobId = result.jobId;
+  job->errorCode = result.errorCode;
+  job->bytesWritten = result.bytesWritten;
+  if (result.success && result.jobId != 0 && runtime.tracker) {
+    runtime.tracker->Track(result.printerName, result.jobId, options.documentName);
+    TrackedJob tracked;
+    if (runtime.tracker->Find(result.printerName, result.jobId, &tracked)) {
+      CopyTrackedJob(tracked, job);
+    }
+  }
+  if (result.timedOut) return call.Return(WINDOWS_PRINTER_FFI_TIMED_OUT);
+  return call.Return(result.success ? WINDOWS_PRINTER_FFI_OK : WINDOWS_PRINTER_FFI_FAILED);
+}
+
+int32_t WindowsPrinterGetJob(const char* printerName, uint32_t jobId, WindowsPrinterJob* job) {
+  if (!job || jobId == 0) return WINDOWS_PRINTER_FFI_INVALID_ARGUMENT;
+  Runtime runtime = CurrentRuntime();
+  if (!runtime.tracker) return WINDOWS_PRINTER_FFI_NOT_READY;
+
+  TrackedJob tracked;
+  if (!runtime.tracker->Find(PrinterNameArgument(printerName), jobId, &tracked)) {
+    return WINDOWS_PRINTER_FFI_NOT_FOUND;
+  }
+  *job = WindowsPrinterJob();
+  CopyTrackedJob(tracked, job);
+  return WINDOWS_PRINTER_FFI_OK;
+}
+
+int32_t WindowsPrinterGetMetrics(WindowsPrinterMetrics* metrics) {
+  // Version 1 callers pass the full version 1 struct
+  if (!metrics || metrics->structSize < kMetricsVersion1Size) {
+    return WINDOWS_PRINTER_FFI_INVALID_ARGUMENT;
+  }
+  MetricsSnapshot snapshot = PrintMetrics::Instance().Snapshot();
+  metrics->bytesWritten = snapshot.bytesWritten;
+  metrics->queueDepth = snapshot.queueDepth;
+  metrics->peakQueueDepth = snapshot.peakQueueDepth;
+  metrics->failures = snapshot.droppedErrors;
+  for (const auto& error : snapshot.errors) {
+    metrics->failures += error.count;
+  }
+  for (size_t i = 0; i < WINDOWS_PRINTER_STAGE_COUNT && i < snapshot.stages.size(); i++) {
+    WindowsPrinterStageMetrics& stage = metrics->stages[i];
+    stage.count = snapshot.stages[i].count;
+    stage.p50Ns = snapshot.stages[i].p50;
+    stage.p99Ns = snapshot.stages[i].p99;
+    stage.maxNs = snapshot.stages[i].max;
+  }
+  if (metrics->structSize >= sizeof(WindowsPrinterMetrics)) {
+    metrics->pendingJobs = snapshot.pendingJobs;
+    metrics->pendingBytes = snapshot.pendingBytes;
+    metrics->peakPendingBytes = snapshot.peakPendingBytes;
+    metrics->spilledBytes = snapshot.spilledBytes;
+    metrics->rejectedJobs = snapshot.rejectedJobs;
+    metrics->blockedJobs = snapshot.blockedJobs;
+    metrics->spilledJobs = snapshot.spilledJobs;
+  }
+  return WINDOWS_PRINTER_FFI_OK;
+}
+
+int32_t WindowsPrinterStreamOpen(const char* printerName, uint64_t capacity,
+                                 uint64_t lowWatermark, uint64_t highWatermark,
+                                 int32_t useRawDatatype, WindowsPrinterStream** stream,
+                                 uint32_t* streamId) {
+  ScopedFfiCall call("ffiStreamOpen");
+  RawPrintStreamOptions options;
+  if (capacity > 0) options.capacity = static_cast<size_t>(capacity);
+  if (!stream || !streamId || capacity > SIZE_MAX / 2 || lowWatermark > options.capacity ||
+      highWatermark > options.capacity || (highWatermark > 0 && lowWatermark >= highWatermark)) {
+    return call.Return(WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  }
+  options.lowWatermark = static_cast<size_t>(lowWatermark);
+  options.highWatermark = static_cast<size_t>(highWatermark);
+  options.useRawDatatype = useRawDatatype != 0;
+  *stream = nullptr;
+  *streamId = 0;
+  Runtime runtime = CurrentRuntime();
+  if (!runtime.backend) {
+    return call.Return(WINDOWS_PRINTER_FFI_NOT_READY);
+  }
+
+  auto handle = std::unique_ptr<WindowsPrinterStream>(new (std::nothrow) WindowsPrinterStream());
+  if (!handle) return call.Return(WINDOWS_PRINTER_FFI_FAILED);
+  handle->id = NextStreamId();
+  handle->stream = std::make_unique<RawPrintStream>(
+      runtime.backend, PrinterNameArgument(printerName), options,
+      [id = handle->id, documentName = options.documentName](const PrintStreamEvent& event) {
+        DeliverStreamEvent(id, documentName, event);
+      });
+  *streamId = handle->id;
+  *stream = handle.release();
+  return call.Return(WINDOWS_PRINTER_FFI_OK);
+}
+
+uint8_t* WindowsPrinterStreamReserve(WindowsPrinterStream* stream, uint64_t* length) {
+  if (!length) return nullptr;
+  *length = 0;
+  if (!stream) return nullptr;
+  uint8_t* region = nullptr;
+  stream->reserved = stream->stream->WritableRegion(&region);
+  *length = stream->reserved;
+  return stream->reserved > 0 ? region : nullptr;
+}
+
+int32_t WindowsPrinterStreamCommit(WindowsPrinterStream* stream, uint64_t length) {
+  if (!stream || length > stream->reserved) return WINDOWS_PRINTER_FFI_INVALID_ARGUMENT;
+  if (stream->stream->Failed()) return WINDOWS_PRINTER_FFI_FAILED;
+  stream->reserved = 0;
+  bool full = stream->stream->Commit(static_cast<size_t>(length));
+  return full ? WINDOWS_PRINTER_FFI_PAUSED : WINDOWS_PRINTER_FFI_OK;
+}
+
+int32_t WindowsPrinterStreamGetInfo(WindowsPrinterStream* stream, WindowsPrinterStreamInfo* info) {
+  if (!stream || !info) return WINDOWS_PRINTER_FFI_INVALID_ARGUMENT;
+  *info = WindowsPrinterStreamInfo();
+  info->streamId = stream->id;
+  info->jobId = stream->stream->JobId();
+  info->capacity = stream->stream->Capacity();
+  info->buffered = stream->stream->Buffered();
+  info->bytesWritten = stream->stream->BytesWritten();
+  info->failed = stream->stream->Failed() ? 1 : 0;
+  return WINDOWS_PRINTER_FFI_OK;
+}
+
+int32_t WindowsPrinterStreamClose(WindowsPrinterStream* stream, int32_t abort) {
+  ScopedFfiCall call("ffiStreamClose");
+  if (!stream) return call.Return(WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  if (abort != 0) {
+    stream->stream->Abort();
+  } else {
+    stream->stream->Finish();
+  }
+  // The writer keeps the shared state and finishes on its own
+  delete stream;
+  return call.Return(WINDOWS_PRINTER_FFI_OK);
+}
+
+int32_t WindowsPrinterEncodeReceiptImage(const uint8_t* image, uint64_t size, int32_t width,
+                                         int32_t dither, uint8_t** output, uint64_t* outputSize,
+                                         char* error, uint32_t errorSize) {
+  ScopedFfiCall call("ffiEncodeReceiptImage");
+  if (!output || !outputSize || !IsValidImageWidth(width)) {
+    CopyErrorMessage("Invalid argument", error, errorSize);
+    return call.Return(WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  }
+  ReceiptImageOptions options;
+  options.width = width;
+  options.dither = dither != 0;
+  std::string message;
+  const int32_t result = EncodeReceiptImage(image, size, options, output, outputSize, &message);
+  if (result != WINDOWS_PRINTER_FFI_OK) CopyErrorMessage(message, error, errorSize);
+  return call.Return(result);
+}
+
+int32_t WindowsPrinterEncodeReceiptImages(uint32_t count, const uint8_t* const* images,
+                                          const uint64_t* sizes, int32_t width, int32_t dither,
+                                          uint8_t** outputs, uint64_t* outputSizes,
+                                          int32_t* results, char* error, uint32_t errorSize) {
+  ScopedFfiCall call("ffiEncodeReceiptImages");
+  if (count == 0 || !images || !sizes || !outputs || !outputSizes || !results ||
+      !IsValidImageWidth(width)) {
+    CopyErrorMessage("Invalid argument", error, errorSize);
+    return call.Return(WINDOWS_PRINTER_FFI_INVALID_ARGUMENT);
+  }
+  ReceiptImageOptions options;
+  options.width = width;
+  options.dither = dither != 0;
+  std::vector<std::string> messages(count);
+  // One image per task: images are independent, and each streams through
+  // its own few rows
+  ParallelFor(SharedTaskPool(), count, 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      results[i] = EncodeReceiptImage(images[i], sizes[i], options, &outputs[i], &outputSizes[i],
+                                      &messages[i]);
+    }
+  });
+  for (uint32_t i = 0; i < count; i++) {
+    if (results[i] != WINDOWS_PRINTER_FFI_OK) {
+      CopyErrorMessage(messages[i], error, errorSize);
+      return call.Return(results[i]);
+    }
+  }
+  return call.Return(WINDOWS_PRINTER_FFI_OK);
+}
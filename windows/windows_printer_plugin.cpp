@@ -3,19 +3,791 @@
 // This must be included before many other Windows headers.
 #include <windows.h>
 
-// For getPlatformVersion; remove unless needed for your plugin implementation.
-#include <VersionHelpers.h>
-
+#include <flutter/event_channel.h>
+#include <flutter/event_stream_handler_functions.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
 #include <memory>
+#include <optional>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "batch_query.h"
+#include "esc_pos_renderer.h"
+#include "ffi_runtime.h"
+#include "label_layout.h"
+#include "order_router.h"
+#include "print_budget.h"
+#include "print_metrics.h"
+#include "print_trace.h"
+#include "printer_fields.h"
 #include "printer_manager.h"
+#include "raw_print_stream.h"
+#include "reprint_cache.h"
+#include "string_convert.h"
+#include "win32_printer_enumerator.h"
+#include "win32_spooler_backend.h"
 
 namespace windows_printer {
 
+namespace {
+
+// Upper bound on getPrinterPropertiesBatch workers; each holds a spooler RPC
+constexpr int kMaxBatchConcurrency = 32;
+
+// Upper bound on concurrent connection attempts of a network scan
+constexpr int kMaxScanInFlight = 4096;
+
+// Upper bound on printRawData copies, the most a DEVMODE copy count holds
+constexpr int kMaxRawCopies = 999;
+
+// Deadline for spooler-backed calls unless changed with setOperationTimeout
+constexpr std::chrono::milliseconds kDefaultOperationTimeout(30000);
+
+// Forwards to the channel's result and records the call's latency, outcome
+// and trace span once the result has been encoded and delivered.
+class InstrumentedMethodResult : public flutter::MethodResult<flutter::EncodableValue> {
+ public:
+  InstrumentedMethodResult(
+      std::string method_name,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> inner)
+      : method_name_(std::move(method_name)),
+        inner_(std::move(inner)),
+        start_(std::chrono::steady_clock::now()) {
+    PrintTracer& tracer = PrintTracer::Instance();
+    if (tracer.IsEnabled()) {
+      tracer_ = &tracer;
+      trace_start_ = tracer.Now();
+    }
+  }
+
+ protected:
+  void SuccessInternal(const flutter::EncodableValue* result) override {
+    if (result) {
+      inner_->Success(*result);
+    } else {
+      inner_->Success();
+    }
+    Record(false);
+  }
+
+  void ErrorInternal(const std::string& error_code,
+                     const std::string& error_message,
+                     const flutter::EncodableValue* error_details) override {
+    if (error_details) {
+      inner_->Error(error_code, error_message, *error_details);
+    } else {
+      inner_->Error(error_code, error_message);
+    }
+    Record(true);
+  }
+
+  void NotImplementedInternal() override {
+    inner_->NotImplemented();
+    Record(true);
+  }
+
+ private:
+  void Record(bool failed) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_);
+    PrintMetrics::Instance().RecordMethod(
+        method_name_, static_cast<uint64_t>(elapsed.count()), failed);
+    if (tracer_) {
+      tracer_->Record(method_name_, "channel", trace_start_, tracer_->Now(),
+                      failed ? "failed" : "", 1);
+    }
+  }
+
+  std::string method_name_;
+  std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> inner_;
+  std::chrono::steady_clock::time_point start_;
+  PrintTracer* tracer_ = nullptr;
+  int64_t trace_start_ = 0;
+};
+
+flutter::EncodableMap EncodeHistogram(const HistogramSummary& summary) {
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("count")] = flutter::EncodableValue(static_cast<int64_t>(summary.count));
+  map[flutter::EncodableValue("totalNs")] = flutter::EncodableValue(static_cast<int64_t>(summary.sum));
+  map[flutter::EncodableValue("minNs")] = flutter::EncodableValue(static_cast<int64_t>(summary.min));
+  map[flutter::EncodableValue("maxNs")] = flutter::EncodableValue(static_cast<int64_t>(summary.max));
+  map[flutter::EncodableValue("meanNs")] = flutter::EncodableValue(summary.mean);
+  map[flutter::EncodableValue("p50Ns")] = flutter::EncodableValue(static_cast<int64_t>(summary.p50));
+  map[flutter::EncodableValue("p90Ns")] = flutter::EncodableValue(static_cast<int64_t>(summary.p90));
+  map[flutter::EncodableValue("p99Ns")] = flutter::EncodableValue(static_cast<int64_t>(summary.p99));
+  map[flutter::EncodableValue("p999Ns")] = flutter::EncodableValue(static_cast<int64_t>(summary.p999));
+  return map;
+}
+
+flutter::EncodableMap EncodeMetrics(const MetricsSnapshot& snapshot) {
+  flutter::EncodableMap stages;
+  for (const auto& stage : snapshot.stages) {
+    stages[flutter::EncodableValue(stage.name)] = flutter::EncodableValue(EncodeHistogram(stage));
+  }
+
+  flutter::EncodableMap methods;
+  for (const auto& method : snapshot.methods) {
+    flutter::EncodableMap entry = EncodeHistogram(method.latency);
+    entry[flutter::EncodableValue("failures")] = flutter::EncodableValue(static_cast<int64_t>(method.failures));
+    entry[flutter::EncodableValue("callsPerSecond")] = flutter::EncodableValue(method.callsPerSecond);
+    methods[flutter::EncodableValue(method.latency.name)] = flutter::EncodableValue(entry);
+  }
+
+  flutter::EncodableList errors;
+  for (const auto& error : snapshot.errors) {
+    flutter::EncodableMap entry;
+    entry[flutter::EncodableValue("stage")] = flutter::EncodableValue(error.stage);
+    entry[flutter::EncodableValue("code")] = flutter::EncodableValue(static_cast<int64_t>(error.code));
+    entry[flutter::EncodableValue("count")] = flutter::EncodableValue(static_cast<int64_t>(error.count));
+    errors.push_back(flutter::EncodableValue(entry));
+  }
+
+  flutter::EncodableMap metrics;
+  metrics[flutter::EncodableValue("elapsedSeconds")] = flutter::EncodableValue(snapshot.elapsedSeconds);
+  metrics[flutter::EncodableValue("bytesWritten")] = flutter::EncodableValue(static_cast<int64_t>(snapshot.bytesWritten));
+  metrics[flutter::EncodableValue("queueDepth")] = flutter::EncodableValue(static_cast<int64_t>(snapshot.queueDepth));
+  metrics[flutter::EncodableValue("peakQueueDepth")] = flutter::EncodableValue(static_cast<int64_t>(snapshot.peakQueueDepth));
+  metrics[flutter::EncodableValue("droppedErrors")] = flutter::EncodableValue(static_cast<int64_t>(snapshot.droppedErrors));
+  metrics[flutter::EncodableValue("pendingJobs")] = flutter::EncodableValue(static_cast<int64_t>(snapshot.pendingJobs));
+  metrics[flutter::EncodableValue("pendingBytes")] = flutter::EncodableValue(static_cast<int64_t>(snapshot.pendingBytes));
+  metrics[flutter::EncodableValue("peakPendingBytes")] = flutter::EncodableValue(static_cast<int64_t>(snapshot.peakPendingBytes));
+  metrics[flutter::EncodableValue("spilledBytes")] = flutter::EncodableValue(static_cast<int64_t>(snapshot.spilledBytes));
+  metrics[flutter::EncodableValue("rejectedJobs")] = flutter::EncodableValue(static_cast<int64_t>(snapshot.rejectedJobs));
+  metrics[flutter::EncodableValue("blockedJobs")] = flutter::EncodableValue(static_cast<int64_t>(snapshot.blockedJobs));
+  metrics[flutter::EncodableValue("spilledJobs")] = flutter::EncodableValue(static_cast<int64_t>(snapshot.spilledJobs));
+  metrics[flutter::EncodableValue("stages")] = flutter::EncodableValue(stages);
+  metrics[flutter::EncodableValue("methods")] = flutter::EncodableValue(methods);
+  metrics[flutter::EncodableValue("errors")] = flutter::EncodableValue(errors);
+  return metrics;
+}
+
+flutter::EncodableMap EncodeReprintCacheStats(const ReprintCacheStats& stats) {
+  flutter::EncodableMap encoded;
+  encoded[flutter::EncodableValue("entries")] = flutter::EncodableValue(static_cast<int64_t>(stats.entries));
+  encoded[flutter::EncodableValue("bytes")] = flutter::EncodableValue(static_cast<int64_t>(stats.bytes));
+  encoded[flutter::EncodableValue("hits")] = flutter::EncodableValue(static_cast<int64_t>(stats.hits));
+  encoded[flutter::EncodableValue("misses")] = flutter::EncodableValue(static_cast<int64_t>(stats.misses));
+  encoded[flutter::EncodableValue("evictions")] = flutter::EncodableValue(static_cast<int64_t>(stats.evictions));
+  return encoded;
+}
+
+const char* DiscoveryEventTypeName(DiscoveryEventType type) {
+  switch (type) {
+    case DiscoveryEventType::kSnapshot:
+      return "snapshot";
+    case DiscoveryEventType::kAdded:
+      return "added";
+    case DiscoveryEventType::kRemoved:
+      return "removed";
+    case DiscoveryEventType::kComplete:
+      return "complete";
+  }
+  return "unknown";
+}
+
+flutter::EncodableValue EncodeDiscoveryEvent(const DiscoveryEvent& event) {
+  flutter::EncodableList printers;
+  for (const auto& printer : event.printers) {
+    flutter::EncodableMap entry;
+    entry[flutter::EncodableValue("name")] = flutter::EncodableValue(printer.name);
+    entry[flutter::EncodableValue("isLocal")] = flutter::EncodableValue(printer.isLocal);
+    printers.push_back(flutter::EncodableValue(entry));
+  }
+
+  flutter::EncodableMap encoded;
+  encoded[flutter::EncodableValue("type")] = flutter::EncodableValue(DiscoveryEventTypeName(event.type));
+  encoded[flutter::EncodableValue("printers")] = flutter::EncodableValue(printers);
+  encoded[flutter::EncodableValue("fromCache")] = flutter::EncodableValue(event.fromCache);
+  return flutter::EncodableValue(encoded);
+}
+
+const char* JobStateName(JobState state) {
+  switch (state) {
+    case JobState::kSpooling:
+      return "spooling";
+    case JobState::kPrinting:
+      return "printing";
+    case JobState::kPrinted:
+      return "printed";
+    case JobState::kError:
+      return "error";
+    case JobState::kDeleted:
+      return "deleted";
+  }
+  return "unknown";
+}
+
+flutter::EncodableValue EncodeTrackedJob(const TrackedJob& job) {
+  flutter::EncodableMap encoded;
+  encoded[flutter::EncodableValue("jobId")] = flutter::EncodableValue(static_cast<int64_t>(job.jobId));
+  encoded[flutter::EncodableValue("printerName")] = flutter::EncodableValue(job.printerName);
+  encoded[flutter::EncodableValue("documentName")] = flutter::EncodableValue(job.documentName);
+  encoded[flutter::EncodableValue("state")] = flutter::EncodableValue(JobStateName(job.state));
+  encoded[flutter::EncodableValue("status")] = flutter::EncodableValue(static_cast<int64_t>(job.status));
+  encoded[flutter::EncodableValue("pagesPrinted")] = flutter::EncodableValue(static_cast<int64_t>(job.pagesPrinted));
+  encoded[flutter::EncodableValue("totalPages")] = flutter::EncodableValue(static_cast<int64_t>(job.totalPages));
+  return flutter::EncodableValue(encoded);
+}
+
+const char* PrintStreamEventTypeName(PrintStreamEventType type) {
+  switch (type) {
+    case PrintStreamEventType::kStarted:
+      return "started";
+    case PrintStreamEventType::kWritable:
+      return "writable";
+    case PrintStreamEventType::kFinished:
+      return "finished";
+    case PrintStreamEventType::kFailed:
+      return "failed";
+    case PrintStreamEventType::kCancelled:
+      return "cancelled";
+  }
+  return "unknown";
+}
+
+flutter::EncodableValue EncodeStreamEvent(uint32_t streamId, const PrintStreamEvent& event) {
+  flutter::EncodableMap encoded;
+  encoded[flutter::EncodableValue("streamId")] = flutter::EncodableValue(static_cast<int64_t>(streamId));
+  encoded[flutter::EncodableValue("type")] = flutter::EncodableValue(PrintStreamEventTypeName(event.type));
+  encoded[flutter::EncodableValue("printerName")] = flutter::EncodableValue(event.printerName);
+  encoded[flutter::EncodableValue("jobId")] = flutter::EncodableValue(static_cast<int64_t>(event.jobId));
+  encoded[flutter::EncodableValue("bytesWritten")] = flutter::EncodableValue(static_cast<int64_t>(event.bytesWritten));
+  encoded[flutter::EncodableValue("errorCode")] = flutter::EncodableValue(static_cast<int64_t>(event.errorCode));
+  return flutter::EncodableValue(encoded);
+}
+
+void ReportTimeout(flutter::MethodResult<flutter::EncodableValue>* result,
+                   std::chrono::milliseconds timeout,
+                   const flutter::EncodableMap& details = flutter::EncodableMap()) {
+  result->Error("TIMEOUT",
+                "The printer did not respond within " + std::to_string(timeout.count()) + " ms",
+                flutter::EncodableValue(details));
+}
+
+// Runs call off the platform thread and replies on it, through reply or with
+// a TIMEOUT error once timeout has passed. A call that misses the deadline is
+// abandoned as in CallWithDeadline.
+template <typename Value>
+void ReplyWithDeadline(
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result,
+    const PlatformThreadDispatcher::PostFunction& post, std::chrono::milliseconds timeout,
+    std::function<Value()> call,
+    std::function<void(flutter::MethodResult<flutter::EncodableValue>* result, Value value)>
+        reply) {
+  // Shared because posted tasks must be copyable
+  std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> shared_result(std::move(result));
+  CallWithDeadlineAsync<Value>(
+      std::move(call), timeout,
+      [shared_result, post, timeout, reply = std::move(reply)](std::optional<Value> value) {
+        post([shared_result, timeout, value = std::move(value), reply]() mutable {
+          if (!value) {
+            ReportTimeout(shared_result.get(), timeout);
+            return;
+          }
+          reply(shared_result.get(), std::move(*value));
+        });
+      });
+}
+
+// Reply for calls that succeed or fail without details
+std::function<void(flutter::MethodResult<flutter::EncodableValue>*, bool)> ReplyTrueOr(
+    const std::string& errorCode, const std::string& errorMessage) {
+  return [errorCode, errorMessage](flutter::MethodResult<flutter::EncodableValue>* reply,
+                                   bool success) {
+    if (success) {
+      reply->Success(flutter::EncodableValue(true));
+    } else {
+      reply->Error(errorCode, errorMessage);
+    }
+  };
+}
+
+flutter::EncodableValue EncodeBackpressureEvent(const BackpressureEvent& event) {
+  flutter::EncodableMap encoded;
+  // null for the limits shared by every printer
+  encoded[flutter::EncodableValue("printerName")] =
+      event.global ? flutter::EncodableValue() : flutter::EncodableValue(event.printerName);
+  encoded[flutter::EncodableValue("full")] = flutter::EncodableValue(event.full);
+  encoded[flutter::EncodableValue("pendingJobs")] = flutter::EncodableValue(static_cast<int64_t>(event.jobs));
+  encoded[flutter::EncodableValue("pendingBytes")] = flutter::EncodableValue(static_cast<int64_t>(event.bytes));
+  return flutter::EncodableValue(encoded);
+}
+
+// Fails a raw print the budget could not make room for
+void ReportBudgetRefusal(flutter::MethodResult<flutter::EncodableValue>* result,
+                         AdmitStatus status, const std::string& printerName,
+                         const PrintBudgetUsage& usage, std::chrono::milliseconds wait) {
+  if (status == AdmitStatus::kSpillFailed) {
+    result->Error("SPILL_FAILED", "Print data could not be spilled to disk");
+    return;
+  }
+  flutter::EncodableMap details;
+  details[flutter::EncodableValue("printerName")] = flutter::EncodableValue(printerName);
+  details[flutter::EncodableValue("timedOut")] = flutter::EncodableValue(status == AdmitStatus::kTimedOut);
+  details[flutter::EncodableValue("pendingJobs")] = flutter::EncodableValue(static_cast<int64_t>(usage.jobs));
+  details[flutter::EncodableValue("pendingBytes")] = flutter::EncodableValue(static_cast<int64_t>(usage.bytes));
+  result->Error("QUEUE_FULL",
+                status == AdmitStatus::kTimedOut
+                    ? "No room for the print data within " + std::to_string(wait.count()) + " ms"
+                    : std::string("Too much print data is queued"),
+                flutter::EncodableValue(details));
+}
+
+const char* NetworkScanEventTypeName(NetworkScanEventType type) {
+  switch (type) {
+    case NetworkScanEventType::kFound:
+      return "found";
+    case NetworkScanEventType::kComplete:
+      return "complete";
+  }
+  return "unknown";
+}
+
+flutter::EncodableValue EncodeNetworkScanEvent(const NetworkScanEvent& event) {
+  flutter::EncodableMap encoded;
+  encoded[flutter::EncodableValue("type")] = flutter::EncodableValue(NetworkScanEventTypeName(event.type));
+  encoded[flutter::EncodableValue("scanned")] = flutter::EncodableValue(static_cast<int64_t>(event.scanned));
+  encoded[flutter::EncodableValue("total")] = flutter::EncodableValue(static_cast<int64_t>(event.total));
+  if (event.type == NetworkScanEventType::kFound) {
+    flutter::EncodableList ports;
+    for (uint16_t port : event.host.openPorts) {
+      ports.push_back(flutter::EncodableValue(static_cast<int>(port)));
+    }
+    encoded[flutter::EncodableValue("address")] = flutter::EncodableValue(event.host.address);
+    encoded[flutter::EncodableValue("openPorts")] = flutter::EncodableValue(ports);
+    encoded[flutter::EncodableValue("escPos")] = flutter::EncodableValue(event.host.escPos);
+    encoded[flutter::EncodableValue("statusByte")] = flutter::EncodableValue(static_cast<int>(event.host.statusByte));
+  } else {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(event.elapsed);
+    encoded[flutter::EncodableValue("cancelled")] = flutter::EncodableValue(event.cancelled);
+    encoded[flutter::EncodableValue("elapsedMs")] = flutter::EncodableValue(static_cast<int64_t>(elapsed.count()));
+  }
+  return flutter::EncodableValue(encoded);
+}
+
+// Reads the optional int argument key in milliseconds; values below 1 ms are
+// ignored
+void ReadMilliseconds(const flutter::EncodableMap& arguments, const char* key,
+                      std::chrono::milliseconds* value) {
+  auto iter = arguments.find(flutter::EncodableValue(key));
+  if (iter != arguments.end() && std::holds_alternative<int>(iter->second) &&
+      std::get<int>(iter->second) > 0) {
+    *value = std::chrono::milliseconds(std::get<int>(iter->second));
+  }
+}
+
+// Decode {cidr, ports?, maxInFlight?, connectTimeoutMs?, statusTimeoutMs?}
+// into a range and options; returns an error message on invalid arguments
+std::string DecodeNetworkScan(const flutter::EncodableValue* value, Ipv4Range* range,
+                              NetworkScanOptions* options) {
+  const auto* arguments = value ? std::get_if<flutter::EncodableMap>(value) : nullptr;
+  if (!arguments) {
+    return "Expected map arguments";
+  }
+
+  auto cidrIter = arguments->find(flutter::EncodableValue("cidr"));
+  if (cidrIter == arguments->end() || !std::holds_alternative<std::string>(cidrIter->second) ||
+      !ParseCidr(std::get<std::string>(cidrIter->second), range)) {
+    return "cidr must be an IPv4 range such as 192.168.1.0/24, no wider than /16";
+  }
+
+  auto portsIter = arguments->find(flutter::EncodableValue("ports"));
+  if (portsIter != arguments->end() && std::holds_alternative<flutter::EncodableList>(portsIter->second)) {
+    options->ports.clear();
+    for (const auto& port : std::get<flutter::EncodableList>(portsIter->second)) {
+      if (!std::holds_alternative<int>(port) || std::get<int>(port) < 1 || std::get<int>(port) > 65535) {
+        return "ports must be a list of ints between 1 and 65535";
+      }
+      options->ports.push_back(static_cast<uint16_t>(std::get<int>(port)));
+    }
+    if (options->ports.empty()) {
+      return "ports must not be empty";
+    }
+  }
+
+  auto inFlightIter = arguments->find(flutter::EncodableValue("maxInFlight"));
+  if (inFlightIter != arguments->end() && std::holds_alternative<int>(inFlightIter->second)) {
+    options->maxInFlight = static_cast<size_t>(
+        std::clamp(std::get<int>(inFlightIter->second), 1, kMaxScanInFlight));
+  }
+  ReadMilliseconds(*arguments, "connectTimeoutMs", &options->connectTimeout);
+  ReadMilliseconds(*arguments, "statusTimeoutMs", &options->statusTimeout);
+  return "";
+}
+
+// Optional "timeoutMs" argument; values below 1 ms are raised to 1 ms
+std::chrono::milliseconds ReadTimeout(const flutter::EncodableMap& arguments,
+                                      std::chrono::milliseconds fallback) {
+  auto timeoutIter = arguments.find(flutter::EncodableValue("timeoutMs"));
+  if (timeoutIter == arguments.end() || !std::holds_alternative<int>(timeoutIter->second)) {
+    return fallback;
+  }
+  int timeoutMs = std::get<int>(timeoutIter->second);
+  return std::chrono::milliseconds(timeoutMs < 1 ? 1 : timeoutMs);
+}
+
+// Optional "fields" argument, a list of section names; every section when
+// absent. Returns an error message for anything else.
+std::string ReadPrinterFields(const flutter::EncodableMap& arguments, uint32_t* fields) {
+  *fields = kPrinterFieldsAll;
+  auto fieldsIter = arguments.find(flutter::EncodableValue("fields"));
+  if (fieldsIter == arguments.end() || fieldsIter->second.IsNull()) {
+    return "";
+  }
+  const auto* list = std::get_if<flutter::EncodableList>(&fieldsIter->second);
+  if (!list) {
+    return "fields must be a list of strings";
+  }
+  std::vector<std::string> names;
+  for (const auto& name : *list) {
+    if (!std::holds_alternative<std::string>(name)) {
+      return "fields must be a list of strings";
+    }
+    names.push_back(std::get<std::string>(name));
+  }
+  std::string unknown;
+  if (!ParsePrinterFields(names, fields, &unknown)) {
+    return "Unknown printer field: " + unknown;
+  }
+  return "";
+}
+
+// Optional int entry of a map; value is left alone when absent
+void ReadIntEntry(const flutter::EncodableMap& map, const char* key, int* value) {
+  auto iter = map.find(flutter::EncodableValue(key));
+  if (iter != map.end() && std::holds_alternative<int>(iter->second)) {
+    *value = std::get<int>(iter->second);
+  }
+}
+
+std::string ReadStringEntry(const flutter::EncodableMap& map, const char* key) {
+  auto iter = map.find(flutter::EncodableValue(key));
+  if (iter == map.end() || !std::holds_alternative<std::string>(iter->second)) {
+    return "";
+  }
+  return std::get<std::string>(iter->second);
+}
+
+bool ParseLabelElementType(const std::string& name, LabelElementType* type) {
+  if (name == "text") {
+    *type = LabelElementType::kText;
+  } else if (name == "barcode") {
+    *type = LabelElementType::kBarcode;
+  } else if (name == "qrCode") {
+    *type = LabelElementType::kQrCode;
+  } else if (name == "graphic") {
+    *type = LabelElementType::kGraphic;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool ParseLabelBarcodeType(const std::string& name, LabelBarcodeType* type) {
+  if (name == "code128") {
+    *type = LabelBarcodeType::kCode128;
+  } else if (name == "code39") {
+    *type = LabelBarcodeType::kCode39;
+  } else if (name == "ean13") {
+    *type = LabelBarcodeType::kEan13;
+  } else if (name == "ean8") {
+    *type = LabelBarcodeType::kEan8;
+  } else if (name == "upcA") {
+    *type = LabelBarcodeType::kUpcA;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Decode {widthMm?, heightMm?, gapMm?, dotsPerMm?, elements} into a layout;
+// returns an error message on arguments of the wrong shape. Ranges are
+// checked by ValidateLabelLayout.
+std::string DecodeLabelLayout(const flutter::EncodableValue& value, LabelLayout* layout) {
+  const auto* map = std::get_if<flutter::EncodableMap>(&value);
+  if (!map) {
+    return "layout must be a map";
+  }
+  ReadIntEntry(*map, "widthMm", &layout->widthMm);
+  ReadIntEntry(*map, "heightMm", &layout->heightMm);
+  ReadIntEntry(*map, "gapMm", &layout->gapMm);
+  ReadIntEntry(*map, "dotsPerMm", &layout->dotsPerMm);
+
+  auto elementsIter = map->find(flutter::EncodableValue("elements"));
+  if (elementsIter == map->end() ||
+      !std::holds_alternative<flutter::EncodableList>(elementsIter->second)) {
+    return "elements must be a list of maps";
+  }
+  for (const auto& entry : std::get<flutter::EncodableList>(elementsIter->second)) {
+    const auto* elementMap = std::get_if<flutter::EncodableMap>(&entry);
+    if (!elementMap) {
+      return "elements must be a list of maps";
+    }
+    LabelElement element;
+    const std::string index = std::to_string(layout->elements.size());
+    if (!ParseLabelElementType(ReadStringEntry(*elementMap, "type"), &element.type)) {
+      return "Element " + index + ": unknown type";
+    }
+    ReadIntEntry(*elementMap, "x", &element.x);
+    ReadIntEntry(*elementMap, "y", &element.y);
+    ReadIntEntry(*elementMap, "field", &element.field);
+    ReadIntEntry(*elementMap, "height", &element.height);
+    ReadIntEntry(*elementMap, "width", &element.width);
+    element.data = ReadStringEntry(*elementMap, "data");
+    if (element.type == LabelElementType::kBarcode &&
+        !ParseLabelBarcodeType(ReadStringEntry(*elementMap, "barcodeType"),
+                               &element.barcodeType)) {
+      return "Element " + index + ": unknown barcode type";
+    }
+    auto showTextIter = elementMap->find(flutter::EncodableValue("showText"));
+    if (showTextIter != elementMap->end() && std::holds_alternative<bool>(showTextIter->second)) {
+      element.showText = std::get<bool>(showTextIter->second);
+    }
+    if (element.type == LabelElementType::kGraphic) {
+      auto rgbaIter = elementMap->find(flutter::EncodableValue("rgba"));
+      if (rgbaIter != elementMap->end() &&
+          std::holds_alternative<std::vector<uint8_t>>(rgbaIter->second)) {
+        element.rgba = std::get<std::vector<uint8_t>>(rgbaIter->second);
+      }
+      ReadIntEntry(*elementMap, "imageWidth", &element.imageWidth);
+      ReadIntEntry(*elementMap, "imageHeight", &element.imageHeight);
+    }
+    layout->elements.push_back(std::move(element));
+  }
+  return "";
+}
+
+// Optional list of strings; false if the entry is anything else
+bool ReadStringList(const flutter::EncodableMap& map, const char* key,
+                    std::vector<std::string>* values) {
+  auto iter = map.find(flutter::EncodableValue(key));
+  if (iter == map.end() || iter->second.IsNull()) {
+    return true;
+  }
+  const auto* list = std::get_if<flutter::EncodableList>(&iter->second);
+  if (!list) {
+    return false;
+  }
+  for (const auto& value : *list) {
+    if (!std::holds_alternative<std::string>(value)) {
+      return false;
+    }
+    values->push_back(std::get<std::string>(value));
+  }
+  return true;
+}
+
+// Optional non-negative integer that may not fit in 32 bits, such as a byte
+// count. Returns false for anything else.
+bool ReadCountEntry(const flutter::EncodableMap& map, const char* key, uint64_t* value) {
+  auto iter = map.find(flutter::EncodableValue(key));
+  if (iter == map.end() || iter->second.IsNull()) {
+    return true;
+  }
+  int64_t count = 0;
+  if (std::holds_alternative<int>(iter->second)) {
+    count = std::get<int>(iter->second);
+  } else if (std::holds_alternative<int64_t>(iter->second)) {
+    count = std::get<int64_t>(iter->second);
+  } else {
+    return false;
+  }
+  if (count < 0) {
+    return false;
+  }
+  *value = static_cast<uint64_t>(count);
+  return true;
+}
+
+// Optional "overflow" ("reject", "block" or "spill") and "overflowTimeoutMs"
+// over the given defaults; returns an error message on invalid arguments
+std::string ReadOverflow(const flutter::EncodableMap& arguments, OverflowPolicy* policy,
+                         std::chrono::milliseconds* wait) {
+  auto overflowIter = arguments.find(flutter::EncodableValue("overflow"));
+  if (overflowIter != arguments.end() && !overflowIter->second.IsNull()) {
+    const auto* name = std::get_if<std::string>(&overflowIter->second);
+    if (name && *name == "reject") {
+      *policy = OverflowPolicy::kReject;
+    } else if (name && *name == "block") {
+      *policy = OverflowPolicy::kBlock;
+    } else if (name && *name == "spill") {
+      *policy = OverflowPolicy::kSpill;
+    } else {
+      return "overflow must be reject, block or spill";
+    }
+  }
+  uint64_t waitMs = static_cast<uint64_t>(wait->count());
+  if (!ReadCountEntry(arguments, "overflowTimeoutMs", &waitMs)) {
+    return "overflowTimeoutMs must be a non-negative int";
+  }
+  *wait = std::chrono::milliseconds(waitMs);
+  return "";
+}
+
+// Decode {order: {title, details, items, note, total}, stations: [...]};
+// returns an error message on invalid arguments
+std::string DecodeOrderRoute(const flutter::EncodableMap& arguments, Order* order,
+                             std::vector<OrderStation>* stations) {
+  auto orderIter = arguments.find(flutter::EncodableValue("order"));
+  const auto* orderMap = orderIter == arguments.end()
+                             ? nullptr
+                             : std::get_if<flutter::EncodableMap>(&orderIter->second);
+  if (!orderMap) {
+    return "order must be a map";
+  }
+  order->title = ReadStringEntry(*orderMap, "title");
+  order->note = ReadStringEntry(*orderMap, "note");
+  order->total = ReadStringEntry(*orderMap, "total");
+  if (!ReadStringList(*orderMap, "details", &order->details)) {
+    return "details must be a list of strings";
+  }
+  auto itemsIter = orderMap->find(flutter::EncodableValue("items"));
+  if (itemsIter == orderMap->end() ||
+      !std::holds_alternative<flutter::EncodableList>(itemsIter->second)) {
+    return "items must be a list of maps";
+  }
+  for (const auto& entry : std::get<flutter::EncodableList>(itemsIter->second)) {
+    const auto* itemMap = std::get_if<flutter::EncodableMap>(&entry);
+    if (!itemMap) {
+      return "items must be a list of maps";
+    }
+    OrderItem item;
+    item.name = ReadStringEntry(*itemMap, "name");
+    item.category = ReadStringEntry(*itemMap, "category");
+    item.price = ReadStringEntry(*itemMap, "price");
+    ReadIntEntry(*itemMap, "quantity", &item.quantity);
+    if (!ReadStringList(*itemMap, "notes", &item.notes)) {
+      return "Item notes must be a list of strings";
+    }
+    order->items.push_back(std::move(item));
+  }
+
+  auto stationsIter = arguments.find(flutter::EncodableValue("stations"));
+  if (stationsIter == arguments.end() ||
+      !std::holds_alternative<flutter::EncodableList>(stationsIter->second)) {
+    return "stations must be a list of maps";
+  }
+  for (const auto& entry : std::get<flutter::EncodableList>(stationsIter->second)) {
+    const auto* stationMap = std::get_if<flutter::EncodableMap>(&entry);
+    if (!stationMap) {
+      return "stations must be a list of maps";
+    }
+    OrderStation station;
+    station.name = ReadStringEntry(*stationMap, "name");
+    station.printerName = ReadStringEntry(*stationMap, "printerName");
+    if (!ReadStringList(*stationMap, "categories", &station.categories)) {
+      return "Station categories must be a list of strings";
+    }
+    int paperWidth = static_cast<int>(EscPosPaperSize::kMm80);
+    ReadIntEntry(*stationMap, "paperWidth", &paperWidth);
+    if (paperWidth != static_cast<int>(EscPosPaperSize::kMm58) &&
+        paperWidth != static_cast<int>(EscPosPaperSize::kMm80)) {
+      return "Station paper width must be 384 or 576 dots";
+    }
+    station.paperSize = static_cast<EscPosPaperSize>(paperWidth);
+    auto pricesIter = stationMap->find(flutter::EncodableValue("showPrices"));
+    if (pricesIter != stationMap->end() && std::holds_alternative<bool>(pricesIter->second)) {
+      station.showPrices = std::get<bool>(pricesIter->second);
+    }
+    ReadIntEntry(*stationMap, "copies", &station.copies);
+    if (station.copies < 1 || station.copies > kMaxRawCopies) {
+      return "Station copies must be between 1 and " + std::to_string(kMaxRawCopies);
+    }
+    stations->push_back(std::move(station));
+  }
+  if (stations->empty()) {
+    return "stations must not be empty";
+  }
+  return "";
+}
+
+// {elapsedMs, unroutedItems, tickets: [{station, printerName, items,
+// success, timedOut, jobId, errorCode, elapsedMs}]}
+flutter::EncodableMap EncodeOrderRouteResult(const OrderRouteResult& routeResult) {
+  auto toMilliseconds = [](std::chrono::nanoseconds elapsed) {
+    return static_cast<double>(elapsed.count()) / 1e6;
+  };
+  auto encodeIndices = [](const std::vector<size_t>& indices) {
+    flutter::EncodableList list;
+    for (size_t index : indices) {
+      list.push_back(flutter::EncodableValue(static_cast<int>(index)));
+    }
+    return list;
+  };
+
+  flutter::EncodableList tickets;
+  for (const StationTicket& ticket : routeResult.tickets) {
+    flutter::EncodableMap encoded;
+    encoded[flutter::EncodableValue("station")] =
+        flutter::EncodableValue(static_cast<int>(ticket.station));
+    encoded[flutter::EncodableValue("printerName")] =
+        flutter::EncodableValue(ticket.result.printerName);
+    encoded[flutter::EncodableValue("items")] = flutter::EncodableValue(encodeIndices(ticket.items));
+    encoded[flutter::EncodableValue("success")] = flutter::EncodableValue(ticket.result.success);
+    encoded[flutter::EncodableValue("timedOut")] = flutter::EncodableValue(ticket.result.timedOut);
+    encoded[flutter::EncodableValue("jobId")] =
+        flutter::EncodableValue(static_cast<int64_t>(ticket.result.jobId));
+    encoded[flutter::EncodableValue("errorCode")] =
+        flutter::EncodableValue(static_cast<int64_t>(ticket.result.errorCode));
+    encoded[flutter::EncodableValue("elapsedMs")] =
+        flutter::EncodableValue(toMilliseconds(ticket.elapsed));
+    tickets.push_back(flutter::EncodableValue(std::move(encoded)));
+  }
+
+  flutter::EncodableMap encoded;
+  encoded[flutter::EncodableValue("tickets")] = flutter::EncodableValue(std::move(tickets));
+  encoded[flutter::EncodableValue("unroutedItems")] =
+      flutter::EncodableValue(encodeIndices(routeResult.unroutedItems));
+  encoded[flutter::EncodableValue("elapsedMs")] =
+      flutter::EncodableValue(toMilliseconds(routeResult.elapsed));
+  return encoded;
+}
+
+// Printer name to properties; printers that missed their deadline map to
+// {timedOut: true, error, elapsedMs} instead.
+flutter::EncodableValue EncodePropertiesBatch(
+    std::vector<BatchQueryResult<flutter::EncodableMap>>& results) {
+  flutter::EncodableMap encoded;
+  for (auto& entry : results) {
+    flutter::EncodableMap properties;
+    if (entry.status == BatchItemStatus::kTimedOut) {
+      auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(entry.elapsed);
+      properties[flutter::EncodableValue("timedOut")] = flutter::EncodableValue(true);
+      properties[flutter::EncodableValue("error")] = flutter::EncodableValue("Timed out");
+      properties[flutter::EncodableValue("elapsedMs")] = flutter::EncodableValue(static_cast<int64_t>(elapsed.count()));
+      PrintMetrics::Instance().RecordFailure(MetricStage::kQueryPrinter, WAIT_TIMEOUT);
+    } else {
+      properties = std::move(entry.value);
+    }
+    encoded[flutter::EncodableValue(entry.name)] = flutter::EncodableValue(std::move(properties));
+  }
+  return flutter::EncodableValue(std::move(encoded));
+}
+
+// %LOCALAPPDATA%\windows_printer\printers.txt, or empty to disable the cache
+std::string DiscoverySnapshotPath() {
+  wchar_t localAppData[MAX_PATH] = {0};
+  DWORD length = GetEnvironmentVariableW(L"LOCALAPPDATA", localAppData, MAX_PATH);
+  if (length == 0 || length >= MAX_PATH) {
+    return "";
+  }
+  std::wstring directory = std::wstring(localAppData) + L"\\windows_printer";
+  if (!CreateDirectoryW(directory.c_str(), NULL) && GetLastError() != ERROR_ALREADY_EXISTS) {
+    return "";
+  }
+  return Utf16ToUtf8<wchar_t>(directory + L"\\printers.txt");
+}
+
+}  // namespace
+
 // static
 void WindowsPrinterPlugin::RegisterWithRegistrar(
     flutter::PluginRegistrarWindows *registrar) {
@@ -24,27 +796,473 @@ void WindowsPrinterPlugin::RegisterWithRegistrar(
           registrar->messenger(), "windows_printer",
           &flutter::StandardMethodCodec::GetInstance());
 
-  auto plugin = std::make_unique<WindowsPrinterPlugin>();
+  auto plugin = std::make_unique<WindowsPrinterPlugin>(registrar);
 
   channel->SetMethodCallHandler(
       [plugin_pointer = plugin.get()](const auto &call, auto result) {
         plugin_pointer->HandleMethodCall(call, std::move(result));
       });
 
+  auto discovery_channel =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          registrar->messenger(), "windows_printer/discovery",
+          &flutter::StandardMethodCodec::GetInstance());
+
+  discovery_channel->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [plugin_pointer = plugin.get()](
+              const flutter::EncodableValue *,
+              std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> &&events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            plugin_pointer->OnDiscoveryListen(std::move(events));
+            return nullptr;
+          },
+          [plugin_pointer = plugin.get()](const flutter::EncodableValue *)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            plugin_pointer->OnDiscoveryCancel();
+            return nullptr;
+          }));
+
+  auto network_scan_channel =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          registrar->messenger(), "windows_printer/network_scan",
+          &flutter::StandardMethodCodec::GetInstance());
+
+  network_scan_channel->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [plugin_pointer = plugin.get()](
+              const flutter::EncodableValue *arguments,
+              std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> &&events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            return plugin_pointer->OnNetworkScanListen(arguments, std::move(events));
+          },
+          [plugin_pointer = plugin.get()](const flutter::EncodableValue *)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            plugin_pointer->OnNetworkScanCancel();
+            return nullptr;
+          }));
+
+  auto jobs_channel =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          registrar->messenger(), "windows_printer/jobs",
+          &flutter::StandardMethodCodec::GetInstance());
+
+  jobs_channel->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [plugin_pointer = plugin.get()](
+              const flutter::EncodableValue *,
+              std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> &&events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            plugin_pointer->OnJobsListen(std::move(events));
+            return nullptr;
+          },
+          [plugin_pointer = plugin.get()](const flutter::EncodableValue *)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            plugin_pointer->OnJobsCancel();
+            return nullptr;
+          }));
+
+  auto streams_channel =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          registrar->messenger(), "windows_printer/streams",
+          &flutter::StandardMethodCodec::GetInstance());
+
+  streams_channel->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [plugin_pointer = plugin.get()](
+              const flutter::EncodableValue *,
+              std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> &&events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            plugin_pointer->OnStreamsListen(std::move(events));
+            return nullptr;
+          },
+          [plugin_pointer = plugin.get()](const flutter::EncodableValue *)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            plugin_pointer->OnStreamsCancel();
+            return nullptr;
+          }));
+
+  auto queue_pressure_channel =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          registrar->messenger(), "windows_printer/queue_pressure",
+          &flutter::StandardMethodCodec::GetInstance());
+
+  queue_pressure_channel->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [plugin_pointer = plugin.get()](
+              const flutter::EncodableValue *,
+              std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> &&events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            plugin_pointer->OnQueuePressureListen(std::move(events));
+            return nullptr;
+          },
+          [plugin_pointer = plugin.get()](const flutter::EncodableValue *)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            plugin_pointer->OnQueuePressureCancel();
+            return nullptr;
+          }));
+
   registrar->AddPlugin(std::move(plugin));
 }
 
-WindowsPrinterPlugin::WindowsPrinterPlugin() {}
+WindowsPrinterPlugin::WindowsPrinterPlugin() : WindowsPrinterPlugin(nullptr) {}
+
+WindowsPrinterPlugin::WindowsPrinterPlugin(flutter::PluginRegistrarWindows *registrar)
+    : dispatcher_(std::make_unique<PlatformThreadDispatcher>(registrar)),
+      operation_timeout_(kDefaultOperationTimeout) {
+  std::shared_ptr<SpoolerBackend> backend = Win32SpoolerBackend::SharedInstance();
+  job_tracker_ = std::make_shared<JobTracker>(backend);
+  print_budget_ = std::make_shared<PrintBudget>();
+
+  // Raised wherever a job is admitted or releases its data
+  print_budget_->SetListener([this](const BackpressureEvent& event) {
+    dispatcher_->Post([this, encoded = EncodeBackpressureEvent(event)]() {
+      if (queue_pressure_sink_) {
+        queue_pressure_sink_->Success(encoded);
+      }
+    });
+  });
+
+  // State changes are raised on the platform thread (Track) and on the
+  // tracker's poller; both are delivered via the dispatcher.
+  job_tracker_->SetListener([this](const TrackedJob& job) {
+    dispatcher_->Post([this, encoded = EncodeTrackedJob(job)]() {
+      if (jobs_sink_) {
+        jobs_sink_->Success(encoded);
+      }
+    });
+  });
+
+  // Events of streams Dart feeds through FFI, raised on their writer threads
+  InstallFfiRuntime(backend, job_tracker_,
+                    [this](uint32_t streamId, const PrintStreamEvent& event) {
+    dispatcher_->Post([this, encoded = EncodeStreamEvent(streamId, event)]() {
+      if (streams_sink_) {
+        streams_sink_->Success(encoded);
+      }
+    });
+  }, print_budget_);
+}
+
+WindowsPrinterPlugin::~WindowsPrinterPlugin() {
+  // An FFI call in progress can keep the tracker alive; its listener must
+  // not reach this plugin afterwards. Uninstalling also waits for a stream
+  // event being delivered.
+  InstallFfiRuntime(nullptr, nullptr);
+  job_tracker_->SetListener(nullptr);
+  // Jobs waiting for room or abandoned at their deadline share the budget
+  print_budget_->SetListener(nullptr);
+}
+
+void WindowsPrinterPlugin::OnDiscoveryListen(
+    std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events) {
+  discovery_sink_ = std::move(events);
+  int session = ++discovery_session_;
+
+  if (!discovery_) {
+    discovery_ = std::make_unique<PrinterDiscovery>(
+        std::make_shared<Win32PrinterEnumerator>(), DiscoverySnapshotPath());
+  }
+
+  // Events are raised on the platform thread (snapshot, local printers) and
+  // on the discovery worker (connections); both are delivered via the
+  // dispatcher so the sink is only used on the platform thread.
+  discovery_->Start([this, session](const DiscoveryEvent& event) {
+    dispatcher_->Post([this, session, encoded = EncodeDiscoveryEvent(event)]() {
+      if (discovery_sink_ && session == discovery_session_) {
+        discovery_sink_->Success(encoded);
+      }
+    });
+  });
+}
+
+void WindowsPrinterPlugin::OnDiscoveryCancel() {
+  if (discovery_) {
+    discovery_->Stop();
+  }
+  discovery_sink_.reset();
+}
 
-WindowsPrinterPlugin::~WindowsPrinterPlugin() {}
+std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>>
+WindowsPrinterPlugin::OnNetworkScanListen(
+    const flutter::EncodableValue *arguments,
+    std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events) {
+  Ipv4Range range;
+  NetworkScanOptions options;
+  std::string error = DecodeNetworkScan(arguments, &range, &options);
+  if (!error.empty()) {
+    return std::make_unique<flutter::StreamHandlerError<flutter::EncodableValue>>(
+        "INVALID_ARGUMENTS", error, nullptr);
+  }
+
+  // A new listen replaces the previous scan; destroying it cancels it
+  network_scanner_ = std::make_unique<NetworkScanner>();
+  network_scan_sink_ = std::move(events);
+  int session = ++network_scan_session_;
+
+  // Events are raised on the scanner thread and delivered via the dispatcher.
+  // The stream ends after the complete event.
+  bool started = network_scanner_->Start(range, std::move(options),
+                                         [this, session](const NetworkScanEvent& event) {
+    dispatcher_->Post([this, session, encoded = EncodeNetworkScanEvent(event),
+                       complete = event.type == NetworkScanEventType::kComplete]() {
+      if (!network_scan_sink_ || session != network_scan_session_) return;
+      network_scan_sink_->Success(encoded);
+      if (complete) {
+        network_scan_sink_->EndOfStream();
+        network_scan_sink_.reset();
+      }
+    });
+  });
+  if (!started) {
+    network_scan_sink_.reset();
+    return std::make_unique<flutter::StreamHandlerError<flutter::EncodableValue>>(
+        "SCAN_FAILED", "Sockets are unavailable", nullptr);
+  }
+  return nullptr;
+}
+
+void WindowsPrinterPlugin::OnNetworkScanCancel() {
+  if (network_scanner_) {
+    network_scanner_->Cancel();
+  }
+  network_scan_sink_.reset();
+}
+
+void WindowsPrinterPlugin::OnJobsListen(
+    std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events) {
+  jobs_sink_ = std::move(events);
+}
+
+void WindowsPrinterPlugin::OnJobsCancel() {
+  jobs_sink_.reset();
+}
+
+void WindowsPrinterPlugin::OnStreamsListen(
+    std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events) {
+  streams_sink_ = std::move(events);
+}
+
+void WindowsPrinterPlugin::OnStreamsCancel() {
+  streams_sink_.reset();
+}
+
+void WindowsPrinterPlugin::OnQueuePressureListen(
+    std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events) {
+  queue_pressure_sink_ = std::move(events);
+}
+
+void WindowsPrinterPlugin::OnQueuePressureCancel() {
+  queue_pressure_sink_.reset();
+}
 
 void WindowsPrinterPlugin::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue> &method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  // Time every call from here until its result has been delivered
+  result = std::make_unique<InstrumentedMethodResult>(method_call.method_name(), std::move(result));
+
   // Handle all printer operations using the PrinterManager
   if (method_call.method_name().compare("getAvailablePrinters") == 0) {
-    result->Success(flutter::EncodableValue(PrinterManager::GetAvailablePrinters()));
-  } else if (method_call.method_name().compare("getPrinterProperties") == 0) {
+    ReplyWithDeadline<flutter::EncodableList>(
+        std::move(result), dispatcher_->GetPoster(), operation_timeout_,
+        &PrinterManager::GetAvailablePrinters,
+        [](flutter::MethodResult<flutter::EncodableValue>* reply, flutter::EncodableList printers) {
+          ScopedStageTimer encodeTimer(MetricStage::kEncodeResult);
+          reply->Success(flutter::EncodableValue(std::move(printers)));
+        });
+  } else if (method_call.method_name().compare("refreshPrinters") == 0) {
+    // Changes are reported on the discovery stream
+    if (discovery_) {
+      discovery_->Refresh();
+    }
+    result->Success(flutter::EncodableValue(discovery_ != nullptr));
+  } else if (method_call.method_name().compare("cancelJob") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENTS", "Expected map arguments");
+      return;
+    }
+
+    auto jobIter = arguments->find(flutter::EncodableValue("jobId"));
+    if (jobIter == arguments->end() || !std::holds_alternative<int>(jobIter->second) ||
+        std::get<int>(jobIter->second) <= 0) {
+      result->Error("INVALID_JOB_ID", "jobId must be provided as a positive int");
+      return;
+    }
+    uint32_t jobId = static_cast<uint32_t>(std::get<int>(jobIter->second));
+
+    // Optional; the default printer is used when missing
+    std::string printerName;
+    auto nameIter = arguments->find(flutter::EncodableValue("printerName"));
+    if (nameIter != arguments->end() && std::holds_alternative<std::string>(nameIter->second)) {
+      printerName = std::get<std::string>(nameIter->second);
+    }
+
+    ReplyWithDeadline<bool>(
+        std::move(result), dispatcher_->GetPoster(), operation_timeout_,
+        [printerName, jobId]() { return PrinterManager::CancelJob(printerName, jobId); },
+        [tracker = job_tracker_, printerName, jobId](
+            flutter::MethodResult<flutter::EncodableValue>* reply, bool success) {
+          if (success) {
+            tracker->MarkCancelled(printerName, jobId);
+            reply->Success(flutter::EncodableValue(true));
+          } else {
+            reply->Error("CANCEL_JOB_FAILED", "Failed to cancel print job");
+          }
+        });
+  } else if (method_call.method_name().compare("getJob") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENTS", "Expected map arguments");
+      return;
+    }
+
+    auto jobIter = arguments->find(flutter::EncodableValue("jobId"));
+    if (jobIter == arguments->end() || !std::holds_alternative<int>(jobIter->second) ||
+        std::get<int>(jobIter->second) <= 0) {
+      result->Error("INVALID_JOB_ID", "jobId must be provided as a positive int");
+      return;
+    }
+    uint32_t jobId = static_cast<uint32_t>(std::get<int>(jobIter->second));
+
+    // Optional; matches the job on any printer when missing
+    std::string printerName;
+    auto nameIter = arguments->find(flutter::EncodableValue("printerName"));
+    if (nameIter != arguments->end() && std::holds_alternative<std::string>(nameIter->second)) {
+      printerName = std::get<std::string>(nameIter->second);
+    }
+
+    // Answered from the tracker's table without calling the spooler
+    TrackedJob job;
+    if (job_tracker_->Find(printerName, jobId, &job)) {
+      result->Success(EncodeTrackedJob(job));
+    } else {
+      result->Success();
+    }
+  } else if (method_call.method_name().compare("setOperationTimeout") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENTS", "Expected map arguments");
+      return;
+    }
+
+    auto timeoutIter = arguments->find(flutter::EncodableValue("timeoutMs"));
+    if (timeoutIter == arguments->end() || !std::holds_alternative<int>(timeoutIter->second) ||
+        std::get<int>(timeoutIter->second) <= 0) {
+      result->Error("INVALID_ARGUMENTS", "timeoutMs must be provided as a positive int");
+      return;
+    }
+
+    operation_timeout_ = std::chrono::milliseconds(std::get<int>(timeoutIter->second));
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("setDeduplicationWindow") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENTS", "Expected map arguments");
+      return;
+    }
+
+    // Zero turns deduplication off
+    auto windowIter = arguments->find(flutter::EncodableValue("windowMs"));
+    if (windowIter == arguments->end() || !std::holds_alternative<int>(windowIter->second) ||
+        std::get<int>(windowIter->second) < 0) {
+      result->Error("INVALID_ARGUMENTS", "windowMs must be provided as a non-negative int");
+      return;
+    }
+
+    duplicate_filter_.SetWindow(std::chrono::milliseconds(std::get<int>(windowIter->second)));
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("setQueueLimits") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENTS", "Expected map arguments");
+      return;
+    }
+
+    // Limits left out, or zero, are lifted
+    uint64_t maxJobs = 0;
+    uint64_t maxJobsPerPrinter = 0;
+    PrintBudgetOptions options;
+    if (!ReadCountEntry(*arguments, "maxJobs", &maxJobs) ||
+        !ReadCountEntry(*arguments, "maxBytes", &options.maxBytes) ||
+        !ReadCountEntry(*arguments, "maxJobsPerPrinter", &maxJobsPerPrinter) ||
+        !ReadCountEntry(*arguments, "maxBytesPerPrinter", &options.maxBytesPerPrinter)) {
+      result->Error("INVALID_ARGUMENTS", "Limits must be non-negative ints");
+      return;
+    }
+    options.maxJobs = static_cast<size_t>(maxJobs);
+    options.maxJobsPerPrinter = static_cast<size_t>(maxJobsPerPrinter);
+    std::string error = ReadOverflow(*arguments, &options.overflow, &options.wait);
+    if (!error.empty()) {
+      result->Error("INVALID_ARGUMENTS", error);
+      return;
+    }
+    options.spillDirectory = ReadStringEntry(*arguments, "spillDirectory");
+
+    print_budget_->SetOptions(std::move(options));
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("setReprintCacheLimits") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENTS", "Expected map arguments");
+      return;
+    }
+
+    ReprintCacheOptions options = ReprintCache::Instance().Options();
+    uint64_t maxEntries = options.maxEntries;
+    if (!ReadCountEntry(*arguments, "maxBytes", &options.maxBytes) ||
+        !ReadCountEntry(*arguments, "maxEntries", &maxEntries)) {
+      result->Error("INVALID_ARGUMENTS", "Limits must be non-negative ints");
+      return;
+    }
+    options.maxEntries = static_cast<size_t>(maxEntries);
+    ReprintCache::Instance().SetOptions(options);
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("clearReprintCache") == 0) {
+    ReprintCache::Instance().Clear();
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("getMetrics") == 0) {
+    flutter::EncodableMap metrics = EncodeMetrics(PrintMetrics::Instance().Snapshot());
+    metrics[flutter::EncodableValue("reprintCache")] =
+        flutter::EncodableValue(EncodeReprintCacheStats(ReprintCache::Instance().Stats()));
+    result->Success(flutter::EncodableValue(metrics));
+  } else if (method_call.method_name().compare("resetMetrics") == 0) {
+    PrintMetrics::Instance().Reset();
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("setTracingEnabled") == 0) {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENTS", "Expected map arguments");
+      return;
+    }
+
+    auto enabledIter = arguments->find(flutter::EncodableValue("enabled"));
+    if (enabledIter == arguments->end() || !std::holds_alternative<bool>(enabledIter->second)) {
+      result->Error("INVALID_ARGUMENTS", "enabled must be provided as a bool");
+      return;
+    }
+
+    PrintTracer::Instance().SetEnabled(std::get<bool>(enabledIter->second));
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("dumpTrace") == 0) {
+    bool clear = true;
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (arguments) {
+      auto clearIter = arguments->find(flutter::EncodableValue("clear"));
+      if (clearIter != arguments->end() && std::holds_alternative<bool>(clearIter->second)) {
+        clear = std::get<bool>(clearIter->second);
+      }
+    }
+
+    std::string json = PrintTracer::Instance().ToChromeTraceJson();
+    if (clear) {
+      PrintTracer::Instance().Clear();
+    }
+    result->Success(flutter::EncodableValue(json));
+  } else if (method_call.method_name().compare("getPrinterProperties") == 0 ||
+             method_call.method_name().compare("getPrinterStatus") == 0) {
+    ScopedStageTimer decodeTimer(MetricStage::kDecodeArguments);
     const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
     if (!arguments) {
       result->Error("INVALID_ARGUMENTS", "Expected map arguments");
@@ -58,8 +1276,123 @@ void WindowsPrinterPlugin::HandleMethodCall(
     }
     
     std::string printerName = std::get<std::string>(nameIter->second);
-    result->Success(flutter::EncodableValue(PrinterManager::GetPrinterProperties(printerName)));
+    // getPrinterStatus is getPrinterProperties with just the status section
+    uint32_t fields = kPrinterFieldStatus;
+    if (method_call.method_name().compare("getPrinterProperties") == 0) {
+      std::string fieldsError = ReadPrinterFields(*arguments, &fields);
+      if (!fieldsError.empty()) {
+        result->Error("INVALID_FIELDS", fieldsError);
+        return;
+      }
+    }
+    decodeTimer.Stop();
+    ReplyWithDeadline<flutter::EncodableMap>(
+        std::move(result), dispatcher_->GetPoster(), operation_timeout_,
+        [printerName, fields]() { return PrinterManager::GetPrinterProperties(printerName, fields); },
+        [](flutter::MethodResult<flutter::EncodableValue>* reply, flutter::EncodableMap properties) {
+          ScopedStageTimer encodeTimer(MetricStage::kEncodeResult);
+          reply->Success(flutter::EncodableValue(std::move(properties)));
+        });
+  } else if (method_call.method_name().compare("getPrinterPropertiesBatch") == 0) {
+    ScopedStageTimer decodeTimer(MetricStage::kDecodeArguments);
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENTS", "Expected map arguments");
+      return;
+    }
+
+    auto namesIter = arguments->find(flutter::EncodableValue("printerNames"));
+    if (namesIter == arguments->end() || !std::holds_alternative<flutter::EncodableList>(namesIter->second)) {
+      result->Error("INVALID_PRINTER_NAME", "Printer names must be provided as a list of strings");
+      return;
+    }
+    std::vector<std::string> printerNames;
+    for (const auto& name : std::get<flutter::EncodableList>(namesIter->second)) {
+      if (!std::holds_alternative<std::string>(name)) {
+        result->Error("INVALID_PRINTER_NAME", "Printer names must be provided as a list of strings");
+        return;
+      }
+      printerNames.push_back(std::get<std::string>(name));
+    }
+
+    uint32_t fields = kPrinterFieldsAll;
+    std::string fieldsError = ReadPrinterFields(*arguments, &fields);
+    if (!fieldsError.empty()) {
+      result->Error("INVALID_FIELDS", fieldsError);
+      return;
+    }
+
+    BatchOptions options;
+    options.timeout = ReadTimeout(*arguments, options.timeout);
+    auto concurrencyIter = arguments->find(flutter::EncodableValue("maxConcurrency"));
+    if (concurrencyIter != arguments->end() && std::holds_alternative<int>(concurrencyIter->second)) {
+      options.maxConcurrency = static_cast<size_t>(
+          std::clamp(std::get<int>(concurrencyIter->second), 1, kMaxBatchConcurrency));
+    }
+    decodeTimer.Stop();
+
+    // Wait for the batch off the platform thread and reply from it; the
+    // result is shared because posted tasks must be copyable.
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> shared_result(std::move(result));
+    std::thread([printerNames = std::move(printerNames), fields, options, shared_result,
+                 post = dispatcher_->GetPoster()]() {
+      auto properties = QueryBatch<flutter::EncodableMap>(
+          printerNames,
+          [fields](const std::string& printerName) {
+            return PrinterManager::GetPrinterProperties(printerName, fields);
+          },
+          options);
+      post([shared_result, encoded = EncodePropertiesBatch(properties)]() {
+        ScopedStageTimer encodeTimer(MetricStage::kEncodeResult);
+        shared_result->Success(encoded);
+      });
+    }).detach();
+  } else if (method_call.method_name().compare("routeOrder") == 0) {
+    ScopedStageTimer decodeTimer(MetricStage::kDecodeArguments);
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENTS", "Expected map arguments");
+      return;
+    }
+
+    Order order;
+    std::vector<OrderStation> stations;
+    std::string error = DecodeOrderRoute(*arguments, &order, &stations);
+    if (!error.empty()) {
+      result->Error("INVALID_ORDER", error);
+      return;
+    }
+    OrderRouteOptions options;
+    options.timeout = ReadTimeout(*arguments, operation_timeout_);
+    auto concurrencyIter = arguments->find(flutter::EncodableValue("maxConcurrency"));
+    if (concurrencyIter != arguments->end() && std::holds_alternative<int>(concurrencyIter->second)) {
+      options.maxConcurrency = static_cast<size_t>(
+          std::clamp(std::get<int>(concurrencyIter->second), 1, kMaxBatchConcurrency));
+    }
+    decodeTimer.Stop();
+
+    // Tickets print in parallel on RouteOrder's workers; wait for the last
+    // one off the platform thread and reply from it
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> shared_result(std::move(result));
+    std::thread([order = std::move(order), stations = std::move(stations), options, shared_result,
+                 tracker = job_tracker_, post = dispatcher_->GetPoster()]() {
+      OrderRouteResult routeResult =
+          RouteOrder(Win32SpoolerBackend::SharedInstance(), order, stations, options);
+      // State changes of every ticket are streamed on windows_printer/jobs
+      for (const StationTicket& ticket : routeResult.tickets) {
+        if (ticket.result.success) {
+          const std::string& name = stations[ticket.station].name;
+          tracker->Track(ticket.result.printerName, ticket.result.jobId,
+                         name.empty() ? "Order Ticket" : name);
+        }
+      }
+      post([shared_result, encoded = EncodeOrderRouteResult(routeResult)]() {
+        ScopedStageTimer encodeTimer(MetricStage::kEncodeResult);
+        shared_result->Success(flutter::EncodableValue(encoded));
+      });
+    }).detach();
   } else if (method_call.method_name().compare("getPaperSizeDetails") == 0) {
+    ScopedStageTimer decodeTimer(MetricStage::kDecodeArguments);
     const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
     if (!arguments) {
       result->Error("INVALID_ARGUMENTS", "Expected map arguments");
@@ -73,8 +1406,16 @@ void WindowsPrinterPlugin::HandleMethodCall(
     }
     
     std::string printerName = std::get<std::string>(nameIter->second);
-    result->Success(flutter::EncodableValue(PrinterManager::GetPaperSizeDetails(printerName)));
+    decodeTimer.Stop();
+    ReplyWithDeadline<flutter::EncodableMap>(
+        std::move(result), dispatcher_->GetPoster(), operation_timeout_,
+        [printerName]() { return PrinterManager::GetPaperSizeDetails(printerName); },
+        [](flutter::MethodResult<flutter::EncodableValue>* reply, flutter::EncodableMap paperDetails) {
+          ScopedStageTimer encodeTimer(MetricStage::kEncodeResult);
+          reply->Success(flutter::EncodableValue(std::move(paperDetails)));
+        });
   } else if (method_call.method_name().compare("printPdf") == 0) {
+    ScopedStageTimer decodeTimer(MetricStage::kDecodeArguments);
     const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
     if (!arguments) {
       result->Error("INVALID_ARGUMENTS", "Expected map arguments");
@@ -104,13 +1445,48 @@ void WindowsPrinterPlugin::HandleMethodCall(
       if (copies < 1) copies = 1;
     }
     
-    bool success = PrinterManager::PrintPdf(printerName, pdfData, copies);
-    if (success) {
-      result->Success(flutter::EncodableValue(true));
-    } else {
-      result->Error("PRINT_FAILED", "Failed to print PDF");
+    decodeTimer.Stop();
+    ReplyWithDeadline<bool>(
+        std::move(result), dispatcher_->GetPoster(), operation_timeout_,
+        [printerName, pdfData, copies]() { return PrinterManager::PrintPdf(printerName, pdfData, copies); },
+        ReplyTrueOr("PRINT_FAILED", "Failed to print PDF"));
+  } else if (method_call.method_name().compare("printImage") == 0) {
+    ScopedStageTimer decodeTimer(MetricStage::kDecodeArguments);
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENTS", "Expected map arguments");
+      return;
+    }
+
+    std::string printerName = ReadStringEntry(*arguments, "printerName");
+    int width = 0;
+    int height = 0;
+    ReadIntEntry(*arguments, "width", &width);
+    ReadIntEntry(*arguments, "height", &height);
+    auto rgbaIter = arguments->find(flutter::EncodableValue("rgba"));
+    if (rgbaIter == arguments->end() || !std::holds_alternative<std::vector<uint8_t>>(rgbaIter->second)) {
+      result->Error("INVALID_DATA", "Pixels must be provided as a Uint8List");
+      return;
+    }
+    const auto& rgba = std::get<std::vector<uint8_t>>(rgbaIter->second);
+    if (width <= 0 || height <= 0 || rgba.size() != static_cast<size_t>(width) * height * 4) {
+      result->Error("INVALID_DATA", "rgba must hold width * height RGBA pixels");
+      return;
     }
-  } else if (method_call.method_name().compare("printRawData") == 0) {
+    // The arguments are const and end with this call, so the pixels are
+    // copied out once; the deadline's worker shares that copy
+    auto pixels = std::make_shared<const std::vector<uint8_t>>(rgba);
+
+    decodeTimer.Stop();
+    ReplyWithDeadline<bool>(
+        std::move(result), dispatcher_->GetPoster(), operation_timeout_,
+        [printerName, pixels, width, height]() {
+          return PrinterManager::PrintImage(printerName, *pixels, width, height);
+        },
+        ReplyTrueOr("PRINT_FAILED", "Failed to print image"));
+  } else if (method_call.method_name().compare("printRawData") == 0 ||
+             method_call.method_name().compare("printRawJob") == 0) {
+    ScopedStageTimer decodeTimer(MetricStage::kDecodeArguments);
     const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
     if (!arguments) {
       result->Error("INVALID_ARGUMENTS", "Expected map arguments");
@@ -137,13 +1513,176 @@ void WindowsPrinterPlugin::HandleMethodCall(
       useRawDatatype = std::get<bool>(rawIter->second);
     }
     
-    bool success = PrinterManager::PrintRawData(printerName, data, useRawDatatype);
+    std::chrono::milliseconds timeout = ReadTimeout(*arguments, operation_timeout_);
 
-    if (success) {
-      result->Success(flutter::EncodableValue(true));
-    } else {
-      result->Error("PRINT_RAW_DATA_FAILED", "Failed to print raw data");
+    // Copies share one job; the payload crosses the channel once
+    int copies = 1;
+    auto copiesIter = arguments->find(flutter::EncodableValue("copies"));
+    if (copiesIter != arguments->end() && std::holds_alternative<int>(copiesIter->second)) {
+      copies = std::get<int>(copiesIter->second);
+      if (copies < 1 || copies > kMaxRawCopies) {
+        result->Error("INVALID_COPIES", "Copies must be between 1 and " + std::to_string(kMaxRawCopies));
+        return;
+      }
+    }
+
+    std::vector<std::vector<uint8_t>> copyVariants;
+    auto variantsIter = arguments->find(flutter::EncodableValue("copyVariants"));
+    if (variantsIter != arguments->end() && std::holds_alternative<flutter::EncodableList>(variantsIter->second)) {
+      const auto& variants = std::get<flutter::EncodableList>(variantsIter->second);
+      if (variants.size() > static_cast<size_t>(copies)) {
+        result->Error("INVALID_COPY_VARIANTS", "There can be at most one copy variant per copy");
+        return;
+      }
+      for (const auto& variant : variants) {
+        if (!std::holds_alternative<std::vector<uint8_t>>(variant)) {
+          result->Error("INVALID_COPY_VARIANTS", "Copy variants must be Uint8List");
+          return;
+        }
+        copyVariants.push_back(std::get<std::vector<uint8_t>>(variant));
+      }
     }
+    
+    // An idempotency key, or the content when asked to deduplicate, names
+    // the submission; the content key is a hash fast enough for raster jobs
+    bool deduplicate = false;
+    uint64_t submissionKey = 0;
+    auto idempotencyIter = arguments->find(flutter::EncodableValue("idempotencyKey"));
+    auto deduplicateIter = arguments->find(flutter::EncodableValue("deduplicate"));
+    if (idempotencyIter != arguments->end() && std::holds_alternative<std::string>(idempotencyIter->second)) {
+      deduplicate = true;
+      submissionKey = RawJobIdempotencyKey(std::get<std::string>(idempotencyIter->second));
+    } else if (deduplicateIter != arguments->end() && std::holds_alternative<bool>(deduplicateIter->second) &&
+               std::get<bool>(deduplicateIter->second)) {
+      deduplicate = true;
+      RawPrintOptions keyOptions;
+      keyOptions.useRawDatatype = useRawDatatype;
+      keyOptions.copies = copies;
+      keyOptions.copyVariants = copyVariants;
+      submissionKey = RawJobContentKey(data.data(), data.size(), keyOptions);
+    }
+
+    // What to do when the print budget is full; setQueueLimits sets the
+    // defaults
+    const PrintBudgetOptions limits = print_budget_->Options();
+    OverflowPolicy overflow = limits.overflow;
+    std::chrono::milliseconds overflowWait = limits.wait;
+    std::string overflowError = ReadOverflow(*arguments, &overflow, &overflowWait);
+    if (!overflowError.empty()) {
+      result->Error("INVALID_ARGUMENTS", overflowError);
+      return;
+    }
+
+    decodeTimer.Stop();
+    const bool returnsJobId = method_call.method_name().compare("printRawJob") == 0;
+    if (deduplicate) {
+      uint32_t originalJobId = 0;
+      if (!duplicate_filter_.Claim(printerName, submissionKey, &originalJobId)) {
+        if (returnsJobId) {
+          result->Success(flutter::EncodableValue(static_cast<int64_t>(originalJobId)));
+        } else {
+          result->Success(flutter::EncodableValue(true));
+        }
+        return;
+      }
+    }
+
+    // Both reply on the platform thread; a failed or refused submission is
+    // forgotten so that a retry prints
+    auto refuse = [this, printerName, deduplicate, submissionKey, overflowWait](
+                      flutter::MethodResult<flutter::EncodableValue>* reply, AdmitStatus status,
+                      const PrintBudgetUsage& usage) {
+      if (deduplicate) {
+        duplicate_filter_.Release(printerName, submissionKey);
+      }
+      ReportBudgetRefusal(reply, status, printerName, usage, overflowWait);
+    };
+    auto finish = [this, printerName, deduplicate, submissionKey, returnsJobId, timeout](
+                      flutter::MethodResult<flutter::EncodableValue>* reply,
+                      const RawPrintResult& printResult) {
+      if (deduplicate) {
+        if (printResult.success) {
+          duplicate_filter_.Complete(printerName, submissionKey, printResult.jobId);
+        } else {
+          duplicate_filter_.Release(printerName, submissionKey);
+        }
+      }
+
+      if (printResult.success) {
+        // State changes are streamed on windows_printer/jobs
+        job_tracker_->Track(printResult.printerName, printResult.jobId, RawPrintOptions().documentName);
+        if (returnsJobId) {
+          reply->Success(flutter::EncodableValue(static_cast<int64_t>(printResult.jobId)));
+        } else {
+          reply->Success(flutter::EncodableValue(true));
+        }
+      } else if (printResult.timedOut) {
+        // The job, if it started, is being cancelled
+        flutter::EncodableMap details;
+        details[flutter::EncodableValue("jobId")] = flutter::EncodableValue(static_cast<int64_t>(printResult.jobId));
+        ReportTimeout(reply, timeout, details);
+      } else {
+        reply->Error("PRINT_RAW_DATA_FAILED", "Failed to print raw data");
+      }
+    };
+
+    // The data counts against the print budget until it has been spooled,
+    // or until an abandoned job's spooler call returns. When the budget is
+    // full the job is refused here, or waits for room off the platform
+    // thread, in a spill file if asked to.
+    uint64_t chargedBytes = data.size();
+    for (const auto& variant : copyVariants) {
+      chargedBytes += variant.size();
+    }
+    std::shared_ptr<PrintReservation> reservation;
+    if (!print_budget_->TryAdmit(printerName, chargedBytes, &reservation) &&
+        overflow == OverflowPolicy::kReject) {
+      AdmitStatus status = print_budget_->Admit(printerName, chargedBytes, overflow,
+                                                overflowWait, &reservation);
+      if (status != AdmitStatus::kAdmitted) {
+        refuse(result.get(), status, print_budget_->Usage(printerName));
+        return;
+      }
+    }
+
+    if (!reservation) {
+      std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> shared_result(std::move(result));
+      std::thread([budget = print_budget_, printerName, data = std::move(data), useRawDatatype,
+                   timeout, copies, copyVariants = std::move(copyVariants), chargedBytes, overflow,
+                   overflowWait, refuse, finish, shared_result,
+                   post = dispatcher_->GetPoster()]() mutable {
+        std::shared_ptr<PrintReservation> reservation;
+        AdmitStatus status = budget->Admit(printerName, chargedBytes, overflow, overflowWait,
+                                           &reservation, &data);
+        if (status != AdmitStatus::kAdmitted) {
+          post([refuse, shared_result, status, usage = budget->Usage(printerName)]() {
+            refuse(shared_result.get(), status, usage);
+          });
+          return;
+        }
+        RawPrintResult printResult = PrinterManager::PrintRawData(
+            printerName, std::make_shared<const std::vector<uint8_t>>(std::move(data)),
+            useRawDatatype, timeout, copies, std::move(copyVariants), std::move(reservation));
+        post([finish, shared_result, printResult]() {
+          finish(shared_result.get(), printResult);
+        });
+      }).detach();
+      return;
+    }
+
+    // Spooled off the platform thread too, which would otherwise wait for a
+    // hung spooler until the deadline
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> shared_result(std::move(result));
+    std::thread([printerName, data = std::move(data), useRawDatatype, timeout, copies,
+                 copyVariants = std::move(copyVariants), reservation = std::move(reservation),
+                 finish, shared_result, post = dispatcher_->GetPoster()]() mutable {
+      RawPrintResult printResult = PrinterManager::PrintRawData(
+          printerName, std::make_shared<const std::vector<uint8_t>>(std::move(data)),
+          useRawDatatype, timeout, copies, std::move(copyVariants), std::move(reservation));
+      post([finish, shared_result, printResult]() {
+        finish(shared_result.get(), printResult);
+      });
+    }).detach();
   } else if (method_call.method_name().compare("setDefaultPrinter") == 0) {
     const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
     if (!arguments) {
@@ -158,13 +1697,10 @@ void WindowsPrinterPlugin::HandleMethodCall(
     }
     
     std::string printerName = std::get<std::string>(nameIter->second);
-    bool success = PrinterManager::AssignDefaultPrinter(printerName);
-    
-    if (success) {
-      result->Success(flutter::EncodableValue(true));
-    } else {
-      result->Error("SET_DEFAULT_FAILED", "Failed to set default printer");
-    }
+    ReplyWithDeadline<bool>(
+        std::move(result), dispatcher_->GetPoster(), operation_timeout_,
+        [printerName]() { return PrinterManager::AssignDefaultPrinter(printerName); },
+        ReplyTrueOr("SET_DEFAULT_FAILED", "Failed to set default printer"));
   } else if (method_call.method_name().compare("openPrinterProperties") == 0) {
     const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
     if (!arguments) {
@@ -187,6 +1723,7 @@ void WindowsPrinterPlugin::HandleMethodCall(
       result->Error("OPEN_PRINTER_PROPERTIES_FAILED", "Failed to open printer properties");
     }
   } else if (method_call.method_name().compare("printRichTextDocument") == 0) {
+    ScopedStageTimer decodeTimer(MetricStage::kDecodeArguments);
     const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
     if (!arguments) {
       result->Error("INVALID_ARGUMENTS", "Expected map arguments");
@@ -220,14 +1757,150 @@ void WindowsPrinterPlugin::HandleMethodCall(
     if (fontSizeIter != arguments->end() && std::holds_alternative<int>(fontSizeIter->second)) {
       fontSize = std::get<int>(fontSizeIter->second);
     }
+
+    // "auto" picks ESC/POS for receipt printers and GDI for everything else
+    RichTextMode mode = RichTextMode::kAuto;
+    auto modeIter = arguments->find(flutter::EncodableValue("mode"));
+    if (modeIter != arguments->end() && std::holds_alternative<std::string>(modeIter->second)) {
+      const std::string& modeName = std::get<std::string>(modeIter->second);
+      if (modeName == "gdi") {
+        mode = RichTextMode::kGdi;
+      } else if (modeName == "escPos") {
+        mode = RichTextMode::kEscPos;
+      } else if (modeName != "auto") {
+        result->Error("INVALID_MODE", "Mode must be auto, gdi or escPos");
+        return;
+      }
+    }
     
-    bool success = PrinterManager::PrintRichTextDocument(printerName, content, fontName, fontSize);
+    decodeTimer.Stop();
+    ReplyWithDeadline<bool>(
+        std::move(result), dispatcher_->GetPoster(), operation_timeout_,
+        [printerName, content, fontName, fontSize, mode]() {
+          return PrinterManager::PrintRichTextDocument(printerName, content, fontName, fontSize,
+                                                       mode);
+        },
+        ReplyTrueOr("PRINT_RICH_TEXT_FAILED", "Failed to print rich text document"));
+  } else if (method_call.method_name().compare("renderPreview") == 0) {
+    ScopedStageTimer decodeTimer(MetricStage::kDecodeArguments);
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENTS", "Expected map arguments");
+      return;
+    }
 
-    if (success) {
-      result->Success(flutter::EncodableValue(true));
+    auto dataIter = arguments->find(flutter::EncodableValue("data"));
+    if (dataIter == arguments->end() || !std::holds_alternative<std::vector<uint8_t>>(dataIter->second)) {
+      result->Error("INVALID_DATA", "Data must be provided as Uint8List");
+      return;
+    }
+    const std::vector<uint8_t>& data = std::get<std::vector<uint8_t>>(dataIter->second);
+
+    EscPosPreviewOptions options;
+    auto widthIter = arguments->find(flutter::EncodableValue("paperWidth"));
+    if (widthIter != arguments->end() && std::holds_alternative<int>(widthIter->second)) {
+      options.paperWidth = std::get<int>(widthIter->second);
+    }
+    if (options.paperWidth < 8 || options.paperWidth > 4096) {
+      result->Error("INVALID_PAPER_WIDTH", "Paper width must be between 8 and 4096 dots");
+      return;
+    }
+
+    decodeTimer.Stop();
+    EscPosPreview preview = RenderEscPos(data.data(), data.size(), options);
+
+    ScopedStageTimer encodeTimer(MetricStage::kEncodeResult);
+    flutter::EncodableList cuts;
+    for (int cut : preview.cuts) {
+      cuts.push_back(flutter::EncodableValue(cut));
+    }
+    flutter::EncodableMap response;
+    response[flutter::EncodableValue("png")] = flutter::EncodableValue(preview.bitmap.EncodePng());
+    response[flutter::EncodableValue("width")] = flutter::EncodableValue(preview.bitmap.Width());
+    response[flutter::EncodableValue("height")] = flutter::EncodableValue(preview.bitmap.Height());
+    response[flutter::EncodableValue("cuts")] = flutter::EncodableValue(std::move(cuts));
+    response[flutter::EncodableValue("drawerPulses")] = flutter::EncodableValue(preview.drawerPulses);
+    response[flutter::EncodableValue("beeps")] = flutter::EncodableValue(preview.beeps);
+    response[flutter::EncodableValue("unknownCommands")] = flutter::EncodableValue(preview.unknownCommands);
+    response[flutter::EncodableValue("truncated")] = flutter::EncodableValue(preview.truncated);
+    result->Success(flutter::EncodableValue(std::move(response)));
+  } else if (method_call.method_name().compare("encodeLabel") == 0) {
+    ScopedStageTimer decodeTimer(MetricStage::kDecodeArguments);
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENTS", "Expected map arguments");
+      return;
+    }
+
+    const std::string languageName = ReadStringEntry(*arguments, "language");
+    if (languageName != "zpl" && languageName != "tspl") {
+      result->Error("INVALID_LANGUAGE", "Language must be zpl or tspl");
+      return;
+    }
+    const LabelLanguage language =
+        languageName == "tspl" ? LabelLanguage::kTspl : LabelLanguage::kZpl;
+
+    std::string mode = ReadStringEntry(*arguments, "mode");
+    if (mode.empty()) {
+      mode = "label";
+    }
+    if (mode != "label" && mode != "format" && mode != "recall") {
+      result->Error("INVALID_ARGUMENTS", "Mode must be label, format or recall");
+      return;
+    }
+    const std::string name = ReadStringEntry(*arguments, "name");
+    if (mode != "label" && !IsValidLabelFormatName(name)) {
+      result->Error("INVALID_FORMAT_NAME",
+                    "Format name must be 1 to 8 letters, digits or underscores");
+      return;
+    }
+
+    auto layoutIter = arguments->find(flutter::EncodableValue("layout"));
+    if (layoutIter == arguments->end()) {
+      result->Error("INVALID_LABEL", "layout is required");
+      return;
+    }
+    LabelLayout layout;
+    std::string error = DecodeLabelLayout(layoutIter->second, &layout);
+    // A recall only needs the fields' types, so Dart may leave graphics out
+    if (error.empty() && mode != "recall") {
+      error = ValidateLabelLayout(layout);
+    }
+    if (!error.empty()) {
+      result->Error("INVALID_LABEL", error);
+      return;
+    }
+
+    int copies = 1;
+    ReadIntEntry(*arguments, "copies", &copies);
+    if (copies < 1 || copies > 99999) {
+      result->Error("INVALID_ARGUMENTS", "Copies must be between 1 and 99999");
+      return;
+    }
+
+    std::map<int, std::string> fields;
+    auto fieldsIter = arguments->find(flutter::EncodableValue("fields"));
+    if (fieldsIter != arguments->end() &&
+        std::holds_alternative<flutter::EncodableMap>(fieldsIter->second)) {
+      for (const auto& [key, value] : std::get<flutter::EncodableMap>(fieldsIter->second)) {
+        if (!std::holds_alternative<int>(key) || !std::holds_alternative<std::string>(value)) {
+          result->Error("INVALID_ARGUMENTS", "fields must map field numbers to strings");
+          return;
+        }
+        fields[std::get<int>(key)] = std::get<std::string>(value);
+      }
+    }
+    decodeTimer.Stop();
+
+    std::vector<uint8_t> bytes;
+    if (mode == "format") {
+      bytes = EncodeLabelFormat(language, layout, name);
+    } else if (mode == "recall") {
+      bytes = EncodeLabelRecall(language, layout, name, fields, copies);
     } else {
-      result->Error("PRINT_RICH_TEXT_FAILED", "Failed to print rich text document");
+      bytes = EncodeLabel(language, layout, copies);
     }
+    result->Success(flutter::EncodableValue(std::move(bytes)));
   } else {
     result->NotImplemented();
   }
@@ -1,11 +1,21 @@
 #ifndef FLUTTER_PLUGIN_WINDOWS_PRINTER_PLUGIN_H_
 #define FLUTTER_PLUGIN_WINDOWS_PRINTER_PLUGIN_H_
 
+#include <flutter/event_sink.h>
+#include <flutter/event_stream_handler.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 
+#include <chrono>
 #include <memory>
 
+#include "duplicate_filter.h"
+#include "job_tracker.h"
+#include "network_scanner.h"
+#include "platform_thread_dispatcher.h"
+#include "print_budget.h"
+#include "printer_discovery.h"
+
 namespace windows_printer {
 
 class WindowsPrinterPlugin : public flutter::Plugin {
@@ -14,6 +24,8 @@ class WindowsPrinterPlugin : public flutter::Plugin {
 
   WindowsPrinterPlugin();
 
+  explicit WindowsPrinterPlugin(flutter::PluginRegistrarWindows *registrar);
+
   virtual ~WindowsPrinterPlugin();
 
   // Disallow copy and assign.
@@ -24,6 +36,69 @@ class WindowsPrinterPlugin : public flutter::Plugin {
   void HandleMethodCall(
       const flutter::MethodCall<flutter::EncodableValue> &method_call,
       std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Called when Dart starts or stops listening to printer discovery events.
+  void OnDiscoveryListen(
+      std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events);
+  void OnDiscoveryCancel();
+
+  // Called when Dart starts or stops listening to a network scan. Each
+  // listen starts a new scan of the requested range.
+  std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> OnNetworkScanListen(
+      const flutter::EncodableValue *arguments,
+      std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events);
+  void OnNetworkScanCancel();
+
+  // Called when Dart starts or stops listening to print job state changes.
+  void OnJobsListen(
+      std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events);
+  void OnJobsCancel();
+
+  // Called when Dart starts or stops listening to the events of print
+  // streams opened through dart:ffi.
+  void OnStreamsListen(
+      std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events);
+  void OnStreamsCancel();
+
+  // Called when Dart starts or stops listening to backpressure changes of
+  // the print data budget.
+  void OnQueuePressureListen(
+      std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events);
+  void OnQueuePressureCancel();
+
+ private:
+  // Declared first so it outlives everything that posts to it.
+  std::unique_ptr<PlatformThreadDispatcher> dispatcher_;
+
+  std::unique_ptr<PrinterDiscovery> discovery_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> discovery_sink_;
+  // Incremented on every listen so events queued for an earlier listener
+  // are dropped.
+  int discovery_session_ = 0;
+
+  std::unique_ptr<NetworkScanner> network_scanner_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> network_scan_sink_;
+  int network_scan_session_ = 0;
+
+  // Follows every job printRawData submits, listened to or not, so getJob
+  // can answer for jobs that finished before Dart asked. Shared with the
+  // dart:ffi entry points, whose jobs it follows too.
+  std::shared_ptr<JobTracker> job_tracker_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> jobs_sink_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> streams_sink_;
+
+  // Caps the raw print data held natively, set by setQueueLimits. Shared
+  // with the dart:ffi entry points and with jobs waiting for room.
+  std::shared_ptr<PrintBudget> print_budget_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> queue_pressure_sink_;
+
+  // Raw jobs submitted with an idempotency key or deduplicate: true, so a
+  // repeat inside the window is acknowledged without printing.
+  DuplicateFilter duplicate_filter_;
+
+  // Deadline for spooler-backed calls; a call that misses it fails with a
+  // TIMEOUT error and is abandoned in the background.
+  std::chrono::milliseconds operation_timeout_;
 };
 
 }  // namespace windows_printer
@@ -0,0 +1,265 @@
+#include "zpl_encoder.h"
+
+#include <algorithm>
+
+namespace windows_printer {
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789ABCDEF";
+
+// Longest run one repeat-count prefix covers: z (400) plus Y (19)
+constexpr int kMaxRepeat = 419;
+
+// Repeat-count letters for 1 to 419 repetitions of the next character
+void AppendRepeatCount(std::string& out, int count) {
+  if (count >= 20) {
+    out.push_back(static_cast<char>('g' + count / 20 - 1));
+    count %= 20;
+  }
+  if (count > 0) {
+    out.push_back(static_cast<char>('G' + count - 1));
+  }
+}
+
+void AppendRuns(std::string& out, std::string_view hex) {
+  size_t i = 0;
+  while (i < hex.size()) {
+    const char digit = hex[i];
+    size_t run = 1;
+    while (i + run < hex.size() && hex[i + run] == digit) run++;
+    i += run;
+    // A count only pays off from three repetitions on
+    while (run > 0) {
+      const int chunk = static_cast<int>(std::min<size_t>(run, kMaxRepeat));
+      if (chunk >= 3) {
+        AppendRepeatCount(out, chunk);
+        out.push_back(digit);
+      } else {
+        out.append(static_cast<size_t>(chunk), digit);
+      }
+      run -= static_cast<size_t>(chunk);
+    }
+  }
+}
+
+// ZPL reads ^ and ~ as commands anywhere in field data, and ^FH makes _ the
+// escape character
+bool NeedsFieldHex(std::string_view data) {
+  return data.find_first_of("^~_") != std::string_view::npos;
+}
+
+const char* BarcodeCommand(LabelBarcodeType type) {
+  switch (type) {
+    case LabelBarcodeType::kCode128:
+      return "^BCN,";
+    case LabelBarcodeType::kCode39:
+      return "^B3N,N,";
+    case LabelBarcodeType::kEan13:
+      return "^BEN,";
+    case LabelBarcodeType::kEan8:
+      return "^B8N,";
+    case LabelBarcodeType::kUpcA:
+      return "^BUN,";
+  }
+  return "^BCN,";
+}
+
+}  // namespace
+
+std::string CompressZplGraphic(const MonoBitmap& bitmap) {
+  std::string out;
+  std::string hex;
+  std::string previous;
+  for (int y = 0; y < bitmap.Height(); y++) {
+    const uint8_t* row = bitmap.Row(y);
+    hex.clear();
+    for (size_t i = 0; i < bitmap.Stride(); i++) {
+      hex.push_back(kHexDigits[row[i] >> 4]);
+      hex.push_back(kHexDigits[row[i] & 0x0F]);
+    }
+    if (y > 0 && hex == previous) {
+      out.push_back(':');
+      continue;
+    }
+
+    // A trailing run of white or black is one character
+    const size_t end = hex.find_last_not_of(hex.back());
+    const size_t tail = end == std::string::npos ? 0 : end + 1;
+    const char fill = hex.back() == '0' ? ',' : hex.back() == 'F' ? '!' : '\0';
+    if (fill != '\0') {
+      AppendRuns(out, std::string_view(hex).substr(0, tail));
+      out.push_back(fill);
+    } else {
+      AppendRuns(out, hex);
+    }
+    previous.swap(hex);
+  }
+  return out;
+}
+
+void ZplEncoder::Clear() {
+  buffer_.clear();
+}
+
+void ZplEncoder::StartLabel(int widthDots, int lengthDots) {
+  Append("^XA");
+  if (widthDots > 0) {
+    Append("^PW");
+    AppendNumber(widthDots);
+  }
+  if (lengthDots > 0) {
+    Append("^LL");
+    AppendNumber(lengthDots);
+  }
+}
+
+void ZplEncoder::StartFormat(std::string_view name, int widthDots, int lengthDots) {
+  Append("^XA^DFR:");
+  Append(name);
+  Append(".ZPL^FS");
+  if (widthDots > 0) {
+    Append("^PW");
+    AppendNumber(widthDots);
+  }
+  if (lengthDots > 0) {
+    Append("^LL");
+    AppendNumber(lengthDots);
+  }
+}
+
+void ZplEncoder::RecallFormat(std::string_view name) {
+  Append("^XA^XFR:");
+  Append(name);
+  Append(".ZPL^FS");
+}
+
+void ZplEncoder::EndLabel(int copies) {
+  if (copies > 1) {
+    Append("^PQ");
+    AppendNumber(copies);
+  }
+  Append("^XZ");
+}
+
+void ZplEncoder::Text(int x, int y, std::string_view text, int height, int width, int field) {
+  FieldOrigin(x, y);
+  Append("^A0N,");
+  AppendNumber(height);
+  Append(",");
+  AppendNumber(width > 0 ? width : height);
+  if (field > 0) {
+    FieldPlaceholder(field);
+  } else {
+    AppendFieldData("", text);
+  }
+}
+
+bool ZplEncoder::Barcode(int x, int y, LabelBarcodeType type, std::string_view data, int height,
+                         int moduleWidth, bool showText, int field) {
+  if (field <= 0 && !IsValidLabelBarcodeData(type, data)) return false;
+
+  FieldOrigin(x, y);
+  Append("^BY");
+  AppendNumber(std::max(1, moduleWidth));
+  // Wide to narrow bar ratio for Code 39; the others have fixed ratios
+  if (type == LabelBarcodeType::kCode39) Append(",3");
+  Append(BarcodeCommand(type));
+  AppendNumber(height);
+  Append(showText ? ",Y,N" : ",N,N");
+  if (type == LabelBarcodeType::kCode128) {
+    // Automatic subset selection, so data needs no invocation codes
+    Append(",N,A");
+  } else if (type == LabelBarcodeType::kUpcA) {
+    Append(",Y");
+  }
+  if (field > 0) {
+    FieldPlaceholder(field);
+  } else {
+    AppendFieldData("", data);
+  }
+  return true;
+}
+
+void ZplEncoder::QrCode(int x, int y, std::string_view data, int magnification, int field) {
+  FieldOrigin(x, y);
+  Append("^BQN,2,");
+  AppendNumber(std::clamp(magnification, 1, 10));
+  if (field > 0) {
+    FieldPlaceholder(field);
+  } else {
+    // Error correction M, automatic data mode
+    AppendFieldData("MA,", data);
+  }
+}
+
+void ZplEncoder::Graphic(int x, int y, const MonoBitmap& bitmap) {
+  if (bitmap.Width() == 0 || bitmap.Height() == 0) return;
+  const size_t total = bitmap.Stride() * static_cast<size_t>(bitmap.Height());
+  FieldOrigin(x, y);
+  Append("^GFA,");
+  Append(std::to_string(total));
+  Append(",");
+  Append(std::to_string(total));
+  Append(",");
+  Append(std::to_string(bitmap.Stride()));
+  Append(",");
+  Append(CompressZplGraphic(bitmap));
+  Append("^FS");
+}
+
+void ZplEncoder::FieldData(int field, std::string_view data, bool qrCode) {
+  Append("^FN");
+  AppendNumber(field);
+  AppendFieldData(qrCode ? "MA," : "", data);
+}
+
+void ZplEncoder::Raw(const uint8_t* data, size_t length) {
+  buffer_.insert(buffer_.end(), data, data + length);
+}
+
+void ZplEncoder::Append(std::string_view text) {
+  buffer_.insert(buffer_.end(), text.begin(), text.end());
+}
+
+void ZplEncoder::AppendNumber(int value) {
+  Append(std::to_string(value));
+}
+
+void ZplEncoder::FieldOrigin(int x, int y) {
+  Append("^FO");
+  AppendNumber(x);
+  Append(",");
+  AppendNumber(y);
+}
+
+void ZplEncoder::AppendFieldData(std::string_view prefix, std::string_view data) {
+  if (!NeedsFieldHex(data)) {
+    Append("^FD");
+    Append(prefix);
+    Append(data);
+    Append("^FS");
+    return;
+  }
+  Append("^FH^FD");
+  Append(prefix);
+  for (char c : data) {
+    if (c == '^' || c == '~' || c == '_') {
+      const uint8_t byte = static_cast<uint8_t>(c);
+      buffer_.push_back('_');
+      buffer_.push_back(static_cast<uint8_t>(kHexDigits[byte >> 4]));
+      buffer_.push_back(static_cast<uint8_t>(kHexDigits[byte & 0x0F]));
+    } else {
+      buffer_.push_back(static_cast<uint8_t>(c));
+    }
+  }
+  Append("^FS");
+}
+
+void ZplEncoder::FieldPlaceholder(int field) {
+  Append("^FN");
+  AppendNumber(field);
+  Append("^FS");
+}
+
+}  // namespace windows_printer
@@ -0,0 +1,78 @@
+#ifndef FLUTTER_PLUGIN_ZPL_ENCODER_H_
+#define FLUTTER_PLUGIN_ZPL_ENCODER_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "label_layout.h"
+#include "mono_bitmap.h"
+
+namespace windows_printer {
+
+/// ^GFA graphic data in ZPL's ASCII compression: hex digits with
+/// repeat-count letters (G-Y for 1-19, g-z for 20-400), ',' for a row that
+/// ends in white, '!' for one that ends in black and ':' for a row equal
+/// to the one above
+std::string CompressZplGraphic(const MonoBitmap& bitmap);
+
+// ZPL II command generator for Zebra label printers. Commands are written
+// without separators. A label starts with StartLabel, StartFormat or
+// RecallFormat and ends with EndLabel.
+class ZplEncoder {
+public:
+  ZplEncoder() = default;
+
+  const std::vector<uint8_t>& Bytes() const { return buffer_; }
+
+  void Clear();
+
+  /// ^XA, with ^PW and ^LL when the size is given
+  void StartLabel(int widthDots = 0, int lengthDots = 0);
+
+  /// ^XA^DF: everything up to EndLabel is stored on the printer as
+  /// R:name.ZPL instead of printed
+  void StartFormat(std::string_view name, int widthDots = 0, int lengthDots = 0);
+
+  /// ^XA^XF: print the stored format; fill its fields with FieldData
+  void RecallFormat(std::string_view name);
+
+  /// ^PQ when copies is more than 1, then ^XZ
+  void EndLabel(int copies = 1);
+
+  /// Scalable font 0 text. With a field number, a placeholder for it.
+  void Text(int x, int y, std::string_view text, int height, int width = 0, int field = 0);
+
+  /// Returns false and adds nothing if data is invalid for type. With a
+  /// field number, a placeholder for it and data is not checked.
+  bool Barcode(int x, int y, LabelBarcodeType type, std::string_view data, int height,
+               int moduleWidth = 2, bool showText = true, int field = 0);
+
+  /// Model 2 QR code, error correction M
+  void QrCode(int x, int y, std::string_view data, int magnification = 4, int field = 0);
+
+  /// ^GFA field compressed with CompressZplGraphic
+  void Graphic(int x, int y, const MonoBitmap& bitmap);
+
+  /// ^FN data for a field of a recalled format. qrCode adds the mode
+  /// prefix that QR code field data needs.
+  void FieldData(int field, std::string_view data, bool qrCode = false);
+
+  void Raw(const uint8_t* data, size_t length);
+
+private:
+  void Append(std::string_view text);
+  void AppendNumber(int value);
+  void FieldOrigin(int x, int y);
+  /// ^FD prefix data^FS, through ^FH when data contains command characters
+  void AppendFieldData(std::string_view prefix, std::string_view data);
+  /// ^FNn^FS
+  void FieldPlaceholder(int field);
+
+  std::vector<uint8_t> buffer_;
+};
+
+}  // namespace windows_printer
+
+#endif  // FLUTTER_PLUGIN_ZPL_ENCODER_H_